@@ -37,12 +37,16 @@ extern "C" {
 
 struct SQLFunctionCtx;
 
+struct SLocalMergeStream;
+
 typedef struct SLocalDataSource {
-  tExtMemBuffer *pMemBuffer;
-  int32_t        flushoutIdx;
-  int32_t        pageId;
-  int32_t        rowIdx;
-  tFilePage      filePage;
+  tExtMemBuffer *           pMemBuffer;
+  struct SLocalMergeStream *pStream;  // pages merged from a part of the sources by the pool, NULL to load from buffer
+  tFilePage *               pPage;    // the page rows are read from, filePage or the current page of pStream
+  int32_t                   flushoutIdx;
+  int32_t                   pageId;
+  int32_t                   rowIdx;
+  tFilePage                 filePage;
 } SLocalDataSource;
 
 enum {
@@ -76,6 +80,8 @@ typedef struct SLocalReducer {
   SResultInfo *          pResInfo;
   bool                   discard;
   int32_t                offset;             // limit offset value
+  int32_t                numOfStream;
+  struct SLocalMergeStream **pStream;        // streams merging parts of the sources
 } SLocalReducer;
 
 typedef struct SSubqueryState {
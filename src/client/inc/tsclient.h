@@ -33,6 +33,10 @@ extern "C" {
 
 #define TSC_GET_RESPTR_BASE(res, _queryinfo, col) (res->data + ((_queryinfo)->fieldsInfo.pSqlExpr[col]->offset) * res->numOfRows)
 
+// "alter local localMergeThreads n" changes the threads for the connection only
+#define LOCAL_MERGE_THREADS_OPTION     "localMergeThreads"
+#define LOCAL_MERGE_THREADS_OPTION_LEN 17
+
 // forward declaration
 struct SSqlInfo;
 
@@ -282,6 +286,7 @@ typedef struct {
   uint64_t      qhandle;
   int64_t       uid;
   int64_t       useconds;
+  int64_t       memUsage;  // memory reserved in dnode, the largest one among vnodes for super table query
   int64_t       offset;  // offset value from vnode during projection query of stable
   int           row;
   int16_t       numOfCols;
@@ -312,6 +317,7 @@ typedef struct _tsc_obj {
   struct _sql_obj *pHb;
   struct _sql_obj *sqlList;
   struct _sstream *streamList;
+  int32_t          localMergeThreads;  // threads to merge results of vnodes for queries of this connection
   pthread_mutex_t  mutex;
 } STscObj;
 
@@ -2131,8 +2131,35 @@ static void copyTopBotRes(SQLFunctionCtx *pCtx, int32_t type) {
   tfree(pData);
 }
 
+/*
+ * Parameters values:
+ * 1. param[0]: maximum allowable results
+ * 2. param[1]: order by type (time or value)
+ * 3. param[2]: asc/desc order
+ *
+ * top/bottom use the intermediate result buffer to keep the intermediate result
+ */
+static STopBotInfo *getTopBotOutputInfo(SQLFunctionCtx *pCtx) {
+  SResultInfo *pResInfo = GET_RES_INFO(pCtx);
+
+  // only the first_stage_merge is directly written data into final output buffer
+  if (pResInfo->superTableQ && pCtx->currentStage != SECONDARY_STAGE_MERGE) {
+    return (STopBotInfo*) pCtx->aOutputBuf;
+  } else {  // during normal table query and super table at the secondary_stage, result is written to intermediate buffer
+    return pResInfo->interResultBuf;
+  }
+}
+
+/*
+ * minval/maxval are the pre-aggregated values in SField, in which integers are kept as int64_t and float as double
+ */
 bool top_bot_datablock_filter(SQLFunctionCtx *pCtx, int32_t functionId, char *minval, char *maxval) {
-  STopBotInfo *pTopBotInfo = (STopBotInfo *)GET_RES_INFO(pCtx)->interResultBuf;
+  SResultInfo *pResInfo = GET_RES_INFO(pCtx);
+  if (!pResInfo->initialized) {
+    return true;
+  }
+
+  STopBotInfo *pTopBotInfo = getTopBotOutputInfo(pCtx);
 
   int32_t numOfExistsRes = pTopBotInfo->num;
 
@@ -2141,64 +2168,38 @@ bool top_bot_datablock_filter(SQLFunctionCtx *pCtx, int32_t functionId, char *mi
     return true;
   }
 
-  tValuePair *pRes = (tValuePair*) pTopBotInfo->res;
+  // the smallest kept value of top, or the largest kept value of bottom
+  tValuePair *pRes = pTopBotInfo->res[0];
 
   if (functionId == TSDB_FUNC_TOP) {
     switch (pCtx->inputType) {
       case TSDB_DATA_TYPE_TINYINT:
-        return GET_INT8_VAL(maxval) > pRes[0].v.i64Key;
       case TSDB_DATA_TYPE_SMALLINT:
-        return GET_INT16_VAL(maxval) > pRes[0].v.i64Key;
       case TSDB_DATA_TYPE_INT:
-        return GET_INT32_VAL(maxval) > pRes[0].v.i64Key;
       case TSDB_DATA_TYPE_BIGINT:
-        return GET_INT64_VAL(maxval) > pRes[0].v.i64Key;
+        return GET_INT64_VAL(maxval) > pRes->v.i64Key;
       case TSDB_DATA_TYPE_FLOAT:
-        return GET_FLOAT_VAL(maxval) > pRes[0].v.dKey;
       case TSDB_DATA_TYPE_DOUBLE:
-        return GET_DOUBLE_VAL(maxval) > pRes[0].v.dKey;
+        return GET_DOUBLE_VAL(maxval) > pRes->v.dKey;
       default:
         return true;
     }
   } else {
     switch (pCtx->inputType) {
       case TSDB_DATA_TYPE_TINYINT:
-        return GET_INT8_VAL(minval) < pRes[0].v.i64Key;
       case TSDB_DATA_TYPE_SMALLINT:
-        return GET_INT16_VAL(minval) < pRes[0].v.i64Key;
       case TSDB_DATA_TYPE_INT:
-        return GET_INT32_VAL(minval) < pRes[0].v.i64Key;
       case TSDB_DATA_TYPE_BIGINT:
-        return GET_INT64_VAL(minval) < pRes[0].v.i64Key;
+        return GET_INT64_VAL(minval) < pRes->v.i64Key;
       case TSDB_DATA_TYPE_FLOAT:
-        return GET_FLOAT_VAL(minval) < pRes[0].v.dKey;
       case TSDB_DATA_TYPE_DOUBLE:
-        return GET_DOUBLE_VAL(minval) < pRes[0].v.dKey;
+        return GET_DOUBLE_VAL(minval) < pRes->v.dKey;
       default:
         return true;
     }
   }
 }
 
-/*
- * Parameters values:
- * 1. param[0]: maximum allowable results
- * 2. param[1]: order by type (time or value)
- * 3. param[2]: asc/desc order
- *
- * top/bottom use the intermediate result buffer to keep the intermediate result
- */
-static STopBotInfo *getTopBotOutputInfo(SQLFunctionCtx *pCtx) {
-  SResultInfo *pResInfo = GET_RES_INFO(pCtx);
-
-  // only the first_stage_merge is directly written data into final output buffer
-  if (pResInfo->superTableQ && pCtx->currentStage != SECONDARY_STAGE_MERGE) {
-    return (STopBotInfo*) pCtx->aOutputBuf;
-  } else {  // during normal table query and super table at the secondary_stage, result is written to intermediate buffer
-    return pResInfo->interResultBuf;
-  }
-}
-
 /*
  * keep the intermediate results during scan data blocks in the format of:
  * +-----------------------------------+-------------one value pair-----------+------------next value pair-----------+
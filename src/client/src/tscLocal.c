@@ -484,7 +484,13 @@ int tscProcessLocalCmd(SSqlObj *pSql) {
   SSqlCmd *pCmd = &pSql->cmd;
 
   if (pCmd->command == TSDB_SQL_CFG_LOCAL) {
-    pSql->res.code = (uint8_t)tsCfgDynamicOptions(pCmd->payload);
+    if (strncasecmp(pCmd->payload, LOCAL_MERGE_THREADS_OPTION " ", LOCAL_MERGE_THREADS_OPTION_LEN + 1) == 0) {
+      pSql->pTscObj->localMergeThreads = atoi(pCmd->payload + LOCAL_MERGE_THREADS_OPTION_LEN + 1);
+      tscTrace("%p threads to merge results of vnodes are set to %d", pSql, pSql->pTscObj->localMergeThreads);
+      pSql->res.code = TSDB_CODE_SUCCESS;
+    } else {
+      pSql->res.code = (uint8_t)tsCfgDynamicOptions(pCmd->payload);
+    }
   } else if (pCmd->command == TSDB_SQL_DESCRIBE_TABLE) {
     pSql->res.code = (uint8_t)tscProcessDescribeTable(pSql);
   } else if (pCmd->command == TSDB_SQL_RETRIEVE_TAGS) {
@@ -612,6 +612,149 @@ static void tsSetBlockInfo(SShellSubmitBlock *pBlocks, const SMeterMeta *pMeterM
   pBlocks->numOfRows += numOfRows;
 }
 
+#define ROW_KEY_INDEX_BITS   16  // rows of a submit block is less than INT16_MAX
+#define ROW_KEY_RADIX_BITS   11
+#define ROW_KEY_RADIX_PASSES ((64 - ROW_KEY_INDEX_BITS + 7) / 8)
+
+static bool rowDataInOrder(const char *pBlockData, int32_t numOfRows, int32_t rowSize) {
+  for (int32_t i = 1; i < numOfRows; ++i) {
+    if (*(TSKEY *)(pBlockData + rowSize * i) < *(TSKEY *)(pBlockData + rowSize * (i - 1))) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/*
+ * Rows arriving a little late cost a few moves each. Gives up once the moves exceed the limit, the keys sorted so far
+ * stay in the order of their row index for the same timestamp.
+ */
+static bool insertionSortRowKeys(uint64_t *pKeys, int32_t numOfRows, int64_t maxMoves) {
+  for (int32_t i = 1; i < numOfRows; ++i) {
+    uint64_t k = pKeys[i];
+    int32_t  j = i - 1;
+    while (j >= 0 && pKeys[j] > k) {
+      pKeys[j + 1] = pKeys[j];
+      --j;
+    }
+
+    pKeys[j + 1] = k;
+    maxMoves -= (i - 1 - j);
+    if (maxMoves < 0) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/*
+ * LSD radix sort on the bits of the timestamp offsets only, the row index below them is in ascending order for the
+ * same offset before sorting and stays so as the sort is stable. Returns the buffer holding the sorted keys.
+ */
+static uint64_t *radixSortRowKeys(uint64_t *pKeys, uint64_t *pBuf, int32_t numOfRows, int32_t keyBits) {
+  // narrower digits for fewer rows, the counters of a pass are not many more than the rows
+  int32_t  radixBits = (numOfRows < (1 << ROW_KEY_RADIX_BITS) * 2) ? 8 : ROW_KEY_RADIX_BITS;
+  int32_t  passes = (keyBits + radixBits - 1) / radixBits;
+  int32_t  digitBits = (keyBits + passes - 1) / passes;
+  uint64_t mask = (1u << digitBits) - 1;
+
+  uint32_t count[ROW_KEY_RADIX_PASSES * 2][1 << ROW_KEY_RADIX_BITS];
+  for (int32_t p = 0; p < passes; ++p) {
+    memset(count[p], 0, sizeof(uint32_t) * (mask + 1));
+  }
+
+  for (int32_t i = 0; i < numOfRows; ++i) {
+    uint64_t k = pKeys[i] >> ROW_KEY_INDEX_BITS;
+    for (int32_t p = 0; p < passes; ++p) {
+      count[p][(k >> (p * digitBits)) & mask]++;
+    }
+  }
+
+  for (int32_t p = 0; p < passes; ++p) {
+    int32_t shift = ROW_KEY_INDEX_BITS + p * digitBits;
+
+    uint32_t offset = 0;
+    for (uint32_t d = 0; d <= mask; ++d) {
+      uint32_t c = count[p][d];
+      count[p][d] = offset;
+      offset += c;
+    }
+
+    for (int32_t i = 0; i < numOfRows; ++i) {
+      pBuf[count[p][(pKeys[i] >> shift) & mask]++] = pKeys[i];
+    }
+
+    uint64_t *tmp = pKeys;
+    pKeys = pBuf;
+    pBuf = tmp;
+  }
+
+  return pKeys;
+}
+
+/*
+ * The rows are sorted by keys of the offset to the smallest timestamp followed by the row index, and then moved
+ * once each. Rows of the same timestamp keep their order of arrival.
+ */
+static int32_t sortRowDataByKey(char *pBlockData, int32_t numOfRows, int32_t rowSize) {
+  TSKEY skey = INT64_MAX;
+  TSKEY ekey = INT64_MIN;
+  for (int32_t i = 0; i < numOfRows; ++i) {
+    TSKEY k = *(TSKEY *)(pBlockData + rowSize * i);
+    if (k < skey) skey = k;
+    if (k > ekey) ekey = k;
+  }
+
+  uint64_t range = (uint64_t)ekey - (uint64_t)skey;
+  int32_t  keyBits = 1;
+  while (keyBits < 64 && (range >> keyBits) != 0) {
+    keyBits++;
+  }
+
+  if (numOfRows > (1 << ROW_KEY_INDEX_BITS) || keyBits > 64 - ROW_KEY_INDEX_BITS) {
+    return TSDB_CODE_INVALID_VALUE;
+  }
+
+  uint64_t *pKeys = malloc(sizeof(uint64_t) * numOfRows * 2);
+  char *    pRows = malloc((size_t)rowSize * numOfRows);
+  if (pKeys == NULL || pRows == NULL) {
+    tfree(pKeys);
+    tfree(pRows);
+    return TSDB_CODE_CLI_OUT_OF_MEMORY;
+  }
+
+  bool descending = true;
+  for (int32_t i = 0; i < numOfRows; ++i) {
+    uint64_t offset = (uint64_t)(*(TSKEY *)(pBlockData + rowSize * i)) - (uint64_t)skey;
+    pKeys[i] = (offset << ROW_KEY_INDEX_BITS) | (uint64_t)i;
+    descending = descending && (i == 0 || (pKeys[i] >> ROW_KEY_INDEX_BITS) < (pKeys[i - 1] >> ROW_KEY_INDEX_BITS));
+  }
+
+  uint64_t *pSorted = pKeys;
+  if (descending) {
+    for (int32_t i = 0, j = numOfRows - 1; i < j; ++i, --j) {
+      uint64_t k = pKeys[i];
+      pKeys[i] = pKeys[j];
+      pKeys[j] = k;
+    }
+  } else if (!insertionSortRowKeys(pKeys, numOfRows, (int64_t)numOfRows * 4 + 1024)) {
+    pSorted = radixSortRowKeys(pKeys, pKeys + numOfRows, numOfRows, keyBits);
+  }
+
+  uint64_t indexMask = (1u << ROW_KEY_INDEX_BITS) - 1;
+  for (int32_t i = 0; i < numOfRows; ++i) {
+    memcpy(pRows + rowSize * i, pBlockData + rowSize * (pSorted[i] & indexMask), rowSize);
+  }
+
+  memcpy(pBlockData, pRows, (size_t)rowSize * numOfRows);
+
+  free(pKeys);
+  free(pRows);
+  return TSDB_CODE_SUCCESS;
+}
+
 // data block is disordered, sort it in ascending order
 void sortRemoveDuplicates(STableDataBlocks *dataBuf) {
   SShellSubmitBlock *pBlocks = (SShellSubmitBlock *)dataBuf->pData;
@@ -626,7 +769,12 @@ void sortRemoveDuplicates(STableDataBlocks *dataBuf) {
 
   if (!dataBuf->ordered) {
     char *pBlockData = pBlocks->payLoad;
-    qsort(pBlockData, pBlocks->numOfRows, dataBuf->rowSize, rowDataCompar);
+
+    // the block may be disordered only by duplicated timestamps
+    if (!rowDataInOrder(pBlockData, pBlocks->numOfRows, dataBuf->rowSize) &&
+        sortRowDataByKey(pBlockData, pBlocks->numOfRows, dataBuf->rowSize) != TSDB_CODE_SUCCESS) {
+      qsort(pBlockData, pBlocks->numOfRows, dataBuf->rowSize, rowDataCompar);
+    }
 
     int32_t i = 0;
     int32_t j = 1;
@@ -1516,6 +1664,466 @@ void tscProcessMultiVnodesInsert(SSqlObj *pSql) {
   pCmd->pDataBlocks = tscDestroyBlockArrayList(pCmd->pDataBlocks);
 }
 
+/*
+ * Parallel loading of data files. A file is mapped and cut into chunks on line boundaries, chunks of all files are
+ * parsed by a pool of threads, and the worker that finishes the next chunk of a file sends the parsed blocks of the
+ * file in order, so rows of a table arrive at its vnode in the file order while files of different tables are sent
+ * to their vnodes concurrently. At most IMPORT_WINDOW_PER_THREAD * threads chunks of a file are parsed ahead of the
+ * one being sent, which bounds the memory of parsed rows. Workers take chunks from the files in turn, and skip a file
+ * whose window is full, so a file waiting for a slow submit does not hold back the others.
+ */
+#define IMPORT_CHUNK_SIZE        (4 * 1024 * 1024)
+#define IMPORT_WINDOW_PER_THREAD 2
+
+struct SImportFile;
+
+typedef struct SImportChunk {
+  struct SImportFile *pFile;
+  int32_t             index;
+  const char *        start;
+  const char *        end;
+  bool                parsed;
+  int32_t             code;
+  char *              error;  // message of the line that failed to be parsed
+  int32_t             numOfBlocks;
+  STableDataBlocks ** pBlocks;  // rows parsed from the chunk, each one is sent in one submit
+} SImportChunk;
+
+typedef struct SImportFile {
+  SSqlObj *     pSql;  // sends the blocks of the file, one submit at a time
+  char          path[PATH_MAX];
+  char *        data;
+  size_t        len;
+  int32_t       numOfChunks;
+  SImportChunk *chunks;
+  int32_t       nextToParse;
+  int32_t       nextToSubmit;
+  bool          submitting;
+  int32_t       code;
+  int32_t       numOfRows;
+  char          error[TSDB_DEFAULT_PAYLOAD_SIZE];
+} SImportFile;
+
+typedef struct SImportJob {
+  pthread_mutex_t mutex;
+  pthread_cond_t  cond;
+  SSqlObj *       pSql;
+  int32_t         numOfFiles;
+  SImportFile *   files;
+  int32_t         nextFile;  // the file to take a chunk from first, so that files are parsed and sent concurrently
+  int32_t         window;
+} SImportJob;
+
+static void tscImportFreeChunk(SImportChunk *pChunk) {
+  for (int32_t i = 0; i < pChunk->numOfBlocks; ++i) {
+    tscDestroyDataBlock(pChunk->pBlocks[i]);
+  }
+
+  tfree(pChunk->pBlocks);
+  tfree(pChunk->error);
+  pChunk->numOfBlocks = 0;
+}
+
+// a block holds as many rows as the one used to load a file in the calling thread, which vnodes accept in a submit
+static int32_t tscImportAddBlock(SImportChunk *pChunk, SMeterMetaInfo *pMeterMetaInfo, STableDataBlocks **pBlock,
+                                 int32_t *maxRows) {
+  SMeterMeta *pMeterMeta = pMeterMetaInfo->pMeterMeta;
+
+  STableDataBlocks **tmp = realloc(pChunk->pBlocks, POINTER_BYTES * (pChunk->numOfBlocks + 1));
+  if (tmp == NULL) {
+    return TSDB_CODE_CLI_OUT_OF_MEMORY;
+  }
+  pChunk->pBlocks = tmp;
+
+  int32_t code = tscCreateDataBlock(TSDB_PAYLOAD_SIZE, pMeterMeta->rowSize, sizeof(SShellSubmitBlock),
+                                    pMeterMetaInfo->name, pMeterMeta, pBlock);
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  pChunk->pBlocks[pChunk->numOfBlocks++] = *pBlock;
+  return tscAllocateMemIfNeed(*pBlock, pMeterMeta->rowSize, maxRows);
+}
+
+static int32_t tscImportParseChunk(SImportChunk *pChunk, char **line, size_t *lineSize, char *tmpTokenBuf,
+                                   char *error) {
+  SImportFile *   pFile = pChunk->pFile;
+  SMeterMetaInfo *pMeterMetaInfo = tscGetMeterMetaInfo(&pFile->pSql->cmd, 0, 0);
+  SMeterMeta *    pMeterMeta = pMeterMetaInfo->pMeterMeta;
+  SSchema *       pSchema = tsGetSchema(pMeterMeta);
+  int32_t         code = TSDB_CODE_SUCCESS;
+
+  SParsedDataColInfo spd = {.numOfCols = pMeterMeta->numOfColumns};
+  tscSetAssignedColumnInfo(&spd, pSchema, pMeterMeta->numOfColumns);
+
+  STableDataBlocks *pBlock = NULL;
+  int32_t           numOfRows = 0;
+  int32_t           maxRows = 0;
+
+  for (const char *p = pChunk->start; p < pChunk->end;) {
+    const char *eol = memchr(p, '\n', pChunk->end - p);
+    if (eol == NULL) eol = pChunk->end;
+
+    size_t len = eol - p;
+    const char *next = eol + 1;
+    if (len > 0 && p[len - 1] == '\r') len--;
+
+    if (len == 0) {
+      p = next;
+      continue;
+    }
+
+    if (len + 1 > *lineSize) {
+      char *tmp = realloc(*line, len + 1);
+      if (tmp == NULL) return TSDB_CODE_CLI_OUT_OF_MEMORY;
+      *line = tmp;
+      *lineSize = len + 1;
+    }
+
+    memcpy(*line, p, len);
+    (*line)[len] = 0;
+    strtolower(*line, *line);
+
+    if (pBlock == NULL || numOfRows >= maxRows) {
+      if ((code = tscImportAddBlock(pChunk, pMeterMetaInfo, &pBlock, &maxRows)) != TSDB_CODE_SUCCESS) {
+        return code;
+      }
+      numOfRows = 0;
+    }
+
+    char *  lineptr = *line;
+    int32_t ret = tsParseOneRowData(&lineptr, pBlock, pSchema, &spd, error, pMeterMeta->precision, &code, tmpTokenBuf);
+    if (ret <= 0 || pBlock->numOfParams > 0) {
+      // blocks filled before the line are still sent, as loading a file in the calling thread does
+      tscDestroyDataBlock(pChunk->pBlocks[--pChunk->numOfBlocks]);
+      return (code != TSDB_CODE_SUCCESS) ? code : TSDB_CODE_INVALID_SQL;
+    }
+
+    pBlock->size += ret;
+    numOfRows++;
+    p = next;
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+// send the parsed blocks of a chunk in order, the vnode response carries the number of rows written
+static int32_t tscImportSubmitChunk(SImportChunk *pChunk) {
+  SSqlObj *pSql = pChunk->pFile->pSql;
+  SSqlCmd *pCmd = &pSql->cmd;
+  int32_t  code = TSDB_CODE_SUCCESS;
+
+  for (int32_t i = 0; i < pChunk->numOfBlocks && code == TSDB_CODE_SUCCESS; ++i) {
+    STableDataBlocks *pBlock = pChunk->pBlocks[i];
+    pChunk->pBlocks[i] = NULL;
+
+    int32_t numOfRows = (pBlock->size - pBlock->headerSize) / pBlock->rowSize;
+
+    // the block is released along with the list
+    pCmd->pDataBlocks = tscCreateBlockArrayList();
+    tscAppendDataBlock(pCmd->pDataBlocks, pBlock);
+
+    pSql->res.numOfRows = 0;
+    code = doPackSendDataBlock(pSql, numOfRows, pBlock);
+    pCmd->pDataBlocks = tscDestroyBlockArrayList(pCmd->pDataBlocks);
+
+    if (code == TSDB_CODE_SUCCESS) {
+      pChunk->pFile->numOfRows += pSql->res.numOfRows;
+    }
+  }
+
+  return code;
+}
+
+// take the next chunk of a file in turn whose window is not full, NULL if no chunk is left to parse
+static SImportChunk *tscImportTakeChunk(SImportJob *pJob, bool *pending) {
+  *pending = false;
+
+  for (int32_t i = 0; i < pJob->numOfFiles; ++i) {
+    int32_t      index = (pJob->nextFile + i) % pJob->numOfFiles;
+    SImportFile *pFile = &pJob->files[index];
+
+    // rows after an error are not written, as loading a file in the calling thread does
+    if (pFile->code != TSDB_CODE_SUCCESS || pFile->nextToParse >= pFile->numOfChunks) {
+      continue;
+    }
+
+    *pending = true;
+    if (pFile->nextToParse < pFile->nextToSubmit + pJob->window) {
+      pJob->nextFile = (index + 1) % pJob->numOfFiles;
+      return &pFile->chunks[pFile->nextToParse++];
+    }
+  }
+
+  return NULL;
+}
+
+static void *tscImportWorker(void *param) {
+  SImportJob *pJob = (SImportJob *)param;
+  char *      line = NULL;
+  size_t      lineSize = 0;
+  char *      tmpTokenBuf = calloc(1, 4096);  // used for deleting Escape character: \\, \', \"
+  char *      error = calloc(1, TSDB_DEFAULT_PAYLOAD_SIZE);
+
+  pthread_mutex_lock(&pJob->mutex);
+
+  while (true) {
+    bool          pending = false;
+    SImportChunk *pChunk = tscImportTakeChunk(pJob, &pending);
+    if (pChunk == NULL) {
+      if (!pending) break;
+
+      // windows of all files are full, a submit moves them on
+      pthread_cond_wait(&pJob->cond, &pJob->mutex);
+      continue;
+    }
+
+    SImportFile *pFile = pChunk->pFile;
+    pthread_mutex_unlock(&pJob->mutex);
+
+    int32_t code = TSDB_CODE_CLI_OUT_OF_MEMORY;
+    if (tmpTokenBuf != NULL && error != NULL) {
+      error[0] = 0;
+      code = tscImportParseChunk(pChunk, &line, &lineSize, tmpTokenBuf, error);
+    }
+
+    if (code != TSDB_CODE_SUCCESS && error != NULL) {
+      pChunk->error = strdup(error);
+    }
+
+    pthread_mutex_lock(&pJob->mutex);
+    pChunk->parsed = true;
+    pChunk->code = code;
+
+    if (pFile->submitting) {
+      continue;
+    }
+
+    // the chunks of the file parsed in order are sent by this worker, others may have been waiting for them
+    pFile->submitting = true;
+    while (pFile->nextToSubmit < pFile->numOfChunks && pFile->chunks[pFile->nextToSubmit].parsed) {
+      SImportChunk *pNext = &pFile->chunks[pFile->nextToSubmit];
+      bool          skip = (pFile->code != TSDB_CODE_SUCCESS);
+      pthread_mutex_unlock(&pJob->mutex);
+
+      if (!skip) {
+        code = tscImportSubmitChunk(pNext);
+        if (code == TSDB_CODE_SUCCESS) code = pNext->code;
+      }
+
+      pthread_mutex_lock(&pJob->mutex);
+      if (!skip && code != TSDB_CODE_SUCCESS) {
+        pFile->code = code;
+        if (code == pNext->code && pNext->error != NULL) {
+          tscError("%p failed to parse file %s, chunk:%d, code:%d, %s", pJob->pSql, pFile->path, pNext->index, code,
+                   pNext->error);
+          strncpy(pFile->error, pNext->error, tListLen(pFile->error) - 1);
+        }
+      }
+      tscImportFreeChunk(pNext);
+
+      pFile->nextToSubmit++;
+      pthread_cond_broadcast(&pJob->cond);
+    }
+    pFile->submitting = false;
+  }
+
+  pthread_cond_broadcast(&pJob->cond);
+  pthread_mutex_unlock(&pJob->mutex);
+
+  tfree(line);
+  tfree(tmpTokenBuf);
+  tfree(error);
+  return NULL;
+}
+
+static int32_t tscImportOpenFile(SSqlObj *pSql, SImportFile *pFile, STableDataBlocks *pDataBlock) {
+  SSqlCmd *pCmd = &pSql->cmd;
+
+  strncpy(pFile->path, pDataBlock->filename, PATH_MAX - 1);
+
+  SSqlObj *pNew = calloc(1, sizeof(SSqlObj));
+  if (pNew == NULL) {
+    return TSDB_CODE_CLI_OUT_OF_MEMORY;
+  }
+
+  pNew->signature = pNew;
+  pNew->pTscObj = pSql->pTscObj;
+  tsem_init(&pNew->rspSem, 0, 0);
+  tsem_init(&pNew->emptyRspSem, 0, 1);
+  pFile->pSql = pNew;
+
+  SQueryInfo *pNewQueryInfo = NULL;
+  pNew->cmd.command = TSDB_SQL_INSERT;
+  if (tscGetQueryInfoDetailSafely(&pNew->cmd, 0, &pNewQueryInfo) != TSDB_CODE_SUCCESS ||
+      tscAllocPayload(&pNew->cmd, TSDB_PAYLOAD_SIZE) != TSDB_CODE_SUCCESS) {
+    return TSDB_CODE_CLI_OUT_OF_MEMORY;
+  }
+
+  // insert or import
+  pNewQueryInfo->type = tscGetQueryInfoDetail(pCmd, 0)->type;
+
+  SMeterMetaInfo *pMeterMetaInfo = tscAddEmptyMeterMetaInfo(pNewQueryInfo);
+  strncpy(pMeterMetaInfo->name, pDataBlock->meterId, TSDB_METER_ID_LEN);
+
+  int32_t code = tscGetMeterMeta(pNew, pMeterMetaInfo);
+  if (code != TSDB_CODE_SUCCESS) {
+    tscError("%p get meter meta failed, abort", pSql);
+    return code;
+  }
+
+  int fd = open(pFile->path, O_RDONLY);
+  if (fd < 0) {
+    tscError("%p failed to open file %s to load data from file, reason:%s", pSql, pFile->path, strerror(errno));
+    return TSDB_CODE_OTHERS;
+  }
+
+  struct stat fstat_buf;
+  if (fstat(fd, &fstat_buf) != 0) {
+    tscError("%p failed to stat file %s, reason:%s", pSql, pFile->path, strerror(errno));
+    close(fd);
+    return TSDB_CODE_OTHERS;
+  }
+
+  pFile->len = (size_t)fstat_buf.st_size;
+  if (pFile->len > 0) {
+    pFile->data = mmap(NULL, pFile->len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (pFile->data == MAP_FAILED) {
+      tscError("%p failed to map file %s, reason:%s", pSql, pFile->path, strerror(errno));
+      pFile->data = NULL;
+      close(fd);
+      return TSDB_CODE_OTHERS;
+    }
+
+    madvise(pFile->data, pFile->len, MADV_SEQUENTIAL);
+  }
+  close(fd);
+
+  // cut the file into chunks on line boundaries
+  int32_t maxChunks = (int32_t)(pFile->len / IMPORT_CHUNK_SIZE) + 1;
+  pFile->chunks = calloc((size_t)maxChunks, sizeof(SImportChunk));
+  if (pFile->chunks == NULL) {
+    return TSDB_CODE_CLI_OUT_OF_MEMORY;
+  }
+
+  const char *p = pFile->data;
+  const char *end = pFile->data + pFile->len;
+  while (p < end) {
+    const char *e = (end - p > IMPORT_CHUNK_SIZE) ? p + IMPORT_CHUNK_SIZE : end;
+    if (e < end) {
+      const char *eol = memchr(e, '\n', end - e);
+      e = (eol == NULL) ? end : eol + 1;
+    }
+
+    SImportChunk *pChunk = &pFile->chunks[pFile->numOfChunks];
+    pChunk->pFile = pFile;
+    pChunk->index = pFile->numOfChunks++;
+    pChunk->start = p;
+    pChunk->end = e;
+    p = e;
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+static void tscImportCloseFile(SImportFile *pFile) {
+  for (int32_t i = 0; i < pFile->numOfChunks; ++i) {
+    tscImportFreeChunk(&pFile->chunks[i]);
+  }
+
+  tfree(pFile->chunks);
+  if (pFile->data != NULL) {
+    munmap(pFile->data, pFile->len);
+  }
+
+  if (pFile->pSql != NULL) {
+    tscFreeSqlObj(pFile->pSql);
+  }
+}
+
+static void tscProcessMultiVnodesInsertFromFileParallel(SSqlObj *pSql, SDataBlockList *pDataBlockList,
+                                                        int32_t numOfThreads) {
+  SSqlCmd *  pCmd = &pSql->cmd;
+  SImportJob job = {.pSql = pSql, .window = IMPORT_WINDOW_PER_THREAD * numOfThreads};
+  int32_t    code = TSDB_CODE_SUCCESS;
+  int32_t    affected_rows = 0;
+  int64_t    st = taosGetTimestampUs();
+
+  pthread_mutex_init(&job.mutex, NULL);
+  pthread_cond_init(&job.cond, NULL);
+
+  job.files = calloc((size_t)pDataBlockList->nSize, sizeof(SImportFile));
+  if (job.files == NULL) {
+    code = TSDB_CODE_CLI_OUT_OF_MEMORY;
+    goto _clean;
+  }
+
+  int32_t total = 0;
+  for (int32_t i = 0; i < pDataBlockList->nSize; ++i) {
+    if (pDataBlockList->pData[i] == NULL) {
+      continue;
+    }
+
+    SImportFile *pFile = &job.files[job.numOfFiles++];
+    pFile->code = tscImportOpenFile(pSql, pFile, pDataBlockList->pData[i]);
+    total += pFile->numOfChunks;
+  }
+
+  numOfThreads = MIN(numOfThreads, MAX(total, 1));
+  pthread_t *threads = calloc((size_t)numOfThreads, sizeof(pthread_t));
+  int32_t    numOfStarted = 0;
+  for (int32_t i = 0; threads != NULL && i < numOfThreads; ++i) {
+    if (pthread_create(&threads[i], NULL, tscImportWorker, &job) != 0) {
+      tscError("%p failed to create import thread, reason:%s", pSql, strerror(errno));
+      break;
+    }
+    numOfStarted++;
+  }
+
+  // chunks are parsed in the calling thread if no thread is created
+  if (numOfStarted == 0) {
+    tscImportWorker(&job);
+  }
+
+  for (int32_t i = 0; i < numOfStarted; ++i) {
+    pthread_join(threads[i], NULL);
+  }
+  tfree(threads);
+
+  // rows of a file that fails are not counted, as loading a file in the calling thread does
+  for (int32_t i = 0; i < job.numOfFiles; ++i) {
+    SImportFile *pFile = &job.files[i];
+
+    if (pFile->code != TSDB_CODE_SUCCESS) {
+      tscTrace("%p no records(%d) in file %s, code:%d", pSql, pFile->numOfRows, pFile->path, pFile->code);
+      if (code == TSDB_CODE_SUCCESS) {
+        code = pFile->code;
+        if (pFile->error[0] != 0 && tscAllocPayload(pCmd, TSDB_DEFAULT_PAYLOAD_SIZE) == TSDB_CODE_SUCCESS) {
+          strcpy(pCmd->payload, pFile->error);
+        }
+      }
+    } else {
+      affected_rows += pFile->numOfRows;
+      tscTrace("%p Insert data %d records from file %s", pSql, pFile->numOfRows, pFile->path);
+    }
+  }
+
+  tscTrace("%p %d records from %d files are inserted by %d threads, elapsed time:%" PRId64 " us", pSql,
+           affected_rows, job.numOfFiles, numOfStarted, taosGetTimestampUs() - st);
+
+_clean:
+  for (int32_t i = 0; i < job.numOfFiles; ++i) {
+    tscImportCloseFile(&job.files[i]);
+  }
+
+  tfree(job.files);
+  pthread_cond_destroy(&job.cond);
+  pthread_mutex_destroy(&job.mutex);
+
+  pSql->res.numOfRows = affected_rows;
+  pSql->res.code = code;
+}
+
 // multi-vnodes insertion in sync query model
 void tscProcessMultiVnodesInsertFromFile(SSqlObj *pSql) {
   SSqlCmd *pCmd = &pSql->cmd;
@@ -1533,6 +2141,14 @@ void tscProcessMultiVnodesInsertFromFile(SSqlObj *pSql) {
   SDataBlockList *pDataBlockList = pCmd->pDataBlocks;
   pCmd->pDataBlocks = NULL;
 
+  // parsing threads more than cores only compete with the sending ones
+  int32_t numOfThreads = MIN(tsImportThreads, tsNumOfCores);
+  if (numOfThreads > 1) {
+    tscProcessMultiVnodesInsertFromFileParallel(pSql, pDataBlockList, numOfThreads);
+    tscDestroyBlockArrayList(pDataBlockList);
+    return;
+  }
+
   char path[PATH_MAX] = {0};
 
   for (int32_t i = 0; i < pDataBlockList->nSize; ++i) {
@@ -0,0 +1,1360 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "os.h"
+
+#include "hash.h"
+#include "taos.h"
+#include "taosmsg.h"
+#include "tcache.h"
+#include "tmd5.h"
+#include "tschemautil.h"
+#include "tscUtil.h"
+#include "tsclient.h"
+#include "tstrbuild.h"
+#include "ttime.h"
+#include "ttypes.h"
+#include "tutil.h"
+
+/*
+ * Points in the line protocol are written without SQL:
+ *
+ *   measurement[,tag=value...] field=value[,field=value...] [timestamp in nanoseconds]
+ *
+ * A measurement is a super table, and the child table of a point is named after the md5 of its measurement and
+ * sorted tags. Points with the same text of measurement and tags are a series, which is parsed and named once.
+ * Super tables are created or altered by SQL when new fields or tags show up, the child tables of a measurement are
+ * created by mgmt in one request, and values are written into the submit blocks of child tables directly.
+ *
+ * Field values: 1i or 1u is an integer, 1 or 1.5 is a float, "abc" is a string, t/true/f/false are bools.
+ * Tags are strings.
+ */
+
+#define LINE_TS_COLUMN_NAME "ts"
+#define LINE_CHILD_TABLE_PREFIX "t_"
+#define LINE_MIN_BINARY_BYTES 16
+#define LINE_MAX_TABLES_PER_CREATE 1000
+
+int taos_query_imp(STscObj *pObj, SSqlObj *pSql);
+
+typedef struct SLineKv {
+  char *   key;
+  char *   value;
+  int32_t  len;   // length of value
+  uint8_t  type;  // type inferred from the value
+  union {
+    int64_t i64;
+    double  dbl;
+  };
+} SLineKv;
+
+typedef struct SLinePoint {
+  int32_t  index;   // line number
+  int32_t  series;  // index of the series of the point
+  char *   measurement;
+  SLineKv *tags;  // tags are parsed for the first point of a series, and shared by the others
+  int32_t  numOfTags;
+  SLineKv *fields;
+  int32_t  numOfFields;
+  bool     hasTs;
+  int64_t  ts;
+} SLinePoint;
+
+// points of a measurement with the same tags, they are written into one child table
+typedef struct SLineSeries {
+  int32_t           measurement;  // index of the measurement, points are grouped by it
+  SLinePoint *      pPoint;       // the first point of the series
+  STableDataBlocks *pBlock;       // data block of the child table in the submit being built
+  char              childName[TSDB_METER_NAME_LEN];
+} SLineSeries;
+
+typedef struct SLineSTable {
+  char     name[TSDB_METER_ID_LEN];  // full name of the super table
+  int8_t   precision;
+  int16_t  numOfColumns;
+  int16_t  numOfTags;
+  int32_t  rowSize;
+  SSchema *pSchema;   // columns followed by tags
+  int16_t *offset;    // offset of each column in a row
+  char *   pNullRow;  // a row of null values, copied before the fields of a point are set
+} SLineSTable;
+
+typedef struct SLineContext {
+  STscObj *    pObj;
+  SSqlObj *    pSql;
+  char *       buf;  // copy of lines, parsed in place
+  SLinePoint * points;
+  SLinePoint **sorted;
+  SLineKv *    kvs;
+  int32_t      numOfPoints;
+  SLineSeries *series;
+  int32_t      numOfSeries;
+  int32_t      numOfMeasurements;
+  void *       pSeriesHashList;       // index of series keyed by the text of measurement and tags in lines
+  void *       pMeasurementHashList;  // index of measurements keyed by name
+  void *       pTableHashList;        // data blocks of child tables keyed by uid
+  void *       pChildHashList;        // data blocks of child tables keyed by name
+  SLineSTable  sTable;                // super table of the measurement in process
+} SLineContext;
+
+static void tscLineToLower(char *s, int32_t len) {
+  for (int32_t i = 0; i < len; ++i) {
+    s[i] = (char)tolower(s[i]);
+  }
+}
+
+// names are put into SQL to create or alter super tables, only letters, digits and underscores are allowed
+static bool tscLineValidName(const char *name, int32_t len, int32_t maxLen) {
+  if (len <= 0 || len >= maxLen || !isalpha(name[0])) {
+    return false;
+  }
+
+  for (int32_t i = 1; i < len; ++i) {
+    if (!isalnum(name[i]) && name[i] != '_') {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/*
+ * scan to the first unescaped comma or space, or equal sign of a key, backslash escapes are removed in place.
+ * The token is null-terminated, and the delimiter found is returned, 0 for the end of line.
+ */
+static char tscLineScan(char **pos, bool isKey, char **token, int32_t *len) {
+  char *src = *pos;
+  char *dst = src;
+  *token = src;
+
+  for (char c = *src; c != 0 && c != ',' && c != ' ' && (c != '=' || !isKey); c = *src) {
+    if (c == '\\' && src[1] != 0) {
+      src++;
+    }
+    *dst++ = *src++;
+  }
+
+  char delimiter = *src;
+  *pos = (delimiter == 0) ? src : src + 1;
+  *len = (int32_t)(dst - *token);
+  *dst = 0;
+
+  return delimiter;
+}
+
+static int32_t tscLineParseFieldValue(SLineKv *pKv) {
+  char *  v = pKv->value;
+  int32_t len = pKv->len;
+  char *  end = NULL;
+
+  if (len == 0) {
+    return TSDB_CODE_INVALID_VALUE;
+  }
+
+  if (v[0] == 't' || v[0] == 'T') {
+    pKv->type = TSDB_DATA_TYPE_BOOL;
+    pKv->i64 = 1;
+    return (len == 1 || strcasecmp(v, "true") == 0) ? TSDB_CODE_SUCCESS : TSDB_CODE_INVALID_VALUE;
+  }
+
+  if (v[0] == 'f' || v[0] == 'F') {
+    pKv->type = TSDB_DATA_TYPE_BOOL;
+    pKv->i64 = 0;
+    return (len == 1 || strcasecmp(v, "false") == 0) ? TSDB_CODE_SUCCESS : TSDB_CODE_INVALID_VALUE;
+  }
+
+  errno = 0;
+  if (v[len - 1] == 'i' || v[len - 1] == 'u') {
+    v[len - 1] = 0;
+
+    pKv->type = TSDB_DATA_TYPE_BIGINT;
+    pKv->i64 = strtoll(v, &end, 10);
+    if (errno != 0 || end == v || *end != 0) {
+      return TSDB_CODE_INVALID_VALUE;
+    }
+
+    return TSDB_CODE_SUCCESS;
+  }
+
+  pKv->type = TSDB_DATA_TYPE_DOUBLE;
+  pKv->dbl = strtod(v, &end);
+  if (errno != 0 || end == v || *end != 0 || !isfinite(pKv->dbl)) {
+    return TSDB_CODE_INVALID_VALUE;
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+// quoted string of a field, \" and \\ are escaped
+static int32_t tscLineScanString(char **pos, SLineKv *pKv) {
+  char *src = *pos + 1;
+  char *dst = src;
+  pKv->value = src;
+
+  while (*src != '"') {
+    if (*src == 0) {
+      return TSDB_CODE_INVALID_VALUE;
+    }
+
+    if (*src == '\\' && (src[1] == '"' || src[1] == '\\')) {
+      src++;
+    }
+    *dst++ = *src++;
+  }
+
+  pKv->len = (int32_t)(dst - pKv->value);
+  pKv->type = TSDB_DATA_TYPE_BINARY;
+  *dst = 0;
+
+  // a comma, space or end of line follows the closing quote
+  src++;
+  if (*src != 0 && *src != ',' && *src != ' ') {
+    return TSDB_CODE_INVALID_VALUE;
+  }
+
+  *pos = src;
+  return TSDB_CODE_SUCCESS;
+}
+
+// tags of a point are few, they are sorted by insertion
+static void tscLineSortKvs(SLineKv *pKvs, int32_t num) {
+  for (int32_t i = 1; i < num; ++i) {
+    SLineKv kv = pKvs[i];
+    int32_t j = i - 1;
+    for (; j >= 0 && strcmp(pKvs[j].key, kv.key) > 0; --j) {
+      pKvs[j + 1] = pKvs[j];
+    }
+    pKvs[j + 1] = kv;
+  }
+}
+
+// the child table is named after the md5 of the measurement and sorted tags
+static void tscLineSetChildName(SLineSeries *pSeries) {
+  static const char hex[] = "0123456789abcdef";
+  SLinePoint *      pPoint = pSeries->pPoint;
+
+  MD5_CTX context;
+  MD5Init(&context);
+  MD5Update(&context, (uint8_t *)pPoint->measurement, (unsigned int)strlen(pPoint->measurement));
+
+  for (int32_t i = 0; i < pPoint->numOfTags; ++i) {
+    SLineKv *pTag = &pPoint->tags[i];
+    MD5Update(&context, (uint8_t *)",", 1);
+    MD5Update(&context, (uint8_t *)pTag->key, (unsigned int)strlen(pTag->key));
+    MD5Update(&context, (uint8_t *)"=", 1);
+    MD5Update(&context, (uint8_t *)pTag->value, (unsigned int)pTag->len);
+  }
+
+  MD5Final(&context);
+
+  char *p = pSeries->childName;
+  memcpy(p, LINE_CHILD_TABLE_PREFIX, strlen(LINE_CHILD_TABLE_PREFIX));
+  p += strlen(LINE_CHILD_TABLE_PREFIX);
+
+  for (int32_t i = 0; i < 16; ++i) {
+    *p++ = hex[context.digest[i] >> 4];
+    *p++ = hex[context.digest[i] & 0xF];
+  }
+  *p = 0;
+}
+
+static int32_t tscLineParseTs(char *pos, SLinePoint *pPoint) {
+  while (*pos == ' ') pos++;
+  if (*pos == 0) {
+    pPoint->hasTs = false;
+    return TSDB_CODE_SUCCESS;
+  }
+
+  char *end = NULL;
+  errno = 0;
+  pPoint->ts = strtoll(pos, &end, 10);
+  if (errno != 0 || end == pos) {
+    return TSDB_CODE_INVALID_VALUE;
+  }
+
+  while (*end == ' ') end++;
+  if (*end != 0) {
+    return TSDB_CODE_INVALID_VALUE;
+  }
+
+  pPoint->hasTs = true;
+  return TSDB_CODE_SUCCESS;
+}
+
+// length of the measurement and tags in the line, i.e., the text before the first unescaped space
+static int32_t tscLineKeyLen(const char *line) {
+  const char *p = line;
+  while (*p != 0 && *p != ' ') {
+    if (*p == '\\' && p[1] != 0) p++;
+    p++;
+  }
+
+  return (int32_t)(p - line);
+}
+
+// the measurement and tags of the first point of a series
+static int32_t tscLineParseTags(char *line, SLinePoint *pPoint, SLineKv *kvs) {
+  char *  pos = line;
+  char *  token = NULL;
+  int32_t len = 0;
+
+  char delimiter = tscLineScan(&pos, false, &pPoint->measurement, &len);
+  tscLineToLower(pPoint->measurement, len);
+  if (!tscLineValidName(pPoint->measurement, len, TSDB_METER_NAME_LEN)) {
+    return TSDB_CODE_INVALID_TABLE_ID;
+  }
+
+  pPoint->tags = kvs;
+  while (delimiter == ',') {
+    SLineKv *pTag = &pPoint->tags[pPoint->numOfTags++];
+    if (tscLineScan(&pos, true, &pTag->key, &len) != '=') {
+      return TSDB_CODE_INVALID_SQL;
+    }
+
+    tscLineToLower(pTag->key, len);
+    if (!tscLineValidName(pTag->key, len, TSDB_COL_NAME_LEN)) {
+      return TSDB_CODE_INVALID_SQL;
+    }
+
+    delimiter = tscLineScan(&pos, false, &token, &pTag->len);
+    pTag->value = token;
+    pTag->type = TSDB_DATA_TYPE_BINARY;
+  }
+
+  if (delimiter != ' ') {
+    return TSDB_CODE_INVALID_SQL;
+  }
+
+  // tags of a table are in order of keys
+  tscLineSortKvs(pPoint->tags, pPoint->numOfTags);
+  for (int32_t i = 1; i < pPoint->numOfTags; ++i) {
+    if (strcmp(pPoint->tags[i].key, pPoint->tags[i - 1].key) == 0) {
+      return TSDB_CODE_INVALID_SQL;
+    }
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+// fields and timestamp of a point, after the space following its tags
+static int32_t tscLineParseFields(char *pos, SLinePoint *pPoint, SLineKv *kvs) {
+  char    delimiter = 0;
+  int32_t len = 0;
+
+  while (*pos == ' ') pos++;
+
+  pPoint->fields = kvs;
+  do {
+    SLineKv *pField = &pPoint->fields[pPoint->numOfFields++];
+    if (tscLineScan(&pos, true, &pField->key, &len) != '=') {
+      return TSDB_CODE_INVALID_SQL;
+    }
+
+    tscLineToLower(pField->key, len);
+    if (!tscLineValidName(pField->key, len, TSDB_COL_NAME_LEN) || strcmp(pField->key, LINE_TS_COLUMN_NAME) == 0) {
+      return TSDB_CODE_INVALID_SQL;
+    }
+
+    int32_t code = TSDB_CODE_SUCCESS;
+    if (*pos == '"') {
+      code = tscLineScanString(&pos, pField);
+      delimiter = *pos;
+      if (delimiter != 0) pos++;
+    } else {
+      delimiter = tscLineScan(&pos, false, &pField->value, &pField->len);
+      code = tscLineParseFieldValue(pField);
+    }
+
+    if (code != TSDB_CODE_SUCCESS) {
+      return code;
+    }
+  } while (delimiter == ',');
+
+  if (delimiter == ' ') {
+    return tscLineParseTs(pos, pPoint);
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+// a new series of the point, named after its tags, and a new measurement if it is the first series of one
+static int32_t tscLineAddSeries(SLineContext *pCtx, SLinePoint *pPoint, const char *key, int32_t keyLen) {
+  int32_t      index = pCtx->numOfSeries;
+  SLineSeries *pSeries = &pCtx->series[index];
+
+  pSeries->pPoint = pPoint;
+  tscLineSetChildName(pSeries);
+
+  int32_t  len = (int32_t)strlen(pPoint->measurement);
+  int32_t *pMeasurement = (int32_t *)taosGetDataFromHashTable(pCtx->pMeasurementHashList, pPoint->measurement, len);
+  if (pMeasurement != NULL) {
+    pSeries->measurement = *pMeasurement;
+  } else {
+    pSeries->measurement = pCtx->numOfMeasurements;
+    if (taosAddToHashTable(pCtx->pMeasurementHashList, pPoint->measurement, len, &pSeries->measurement,
+                           sizeof(int32_t)) != 0) {
+      return TSDB_CODE_CLI_OUT_OF_MEMORY;
+    }
+    pCtx->numOfMeasurements++;
+  }
+
+  if (taosAddToHashTable(pCtx->pSeriesHashList, key, keyLen, &index, sizeof(int32_t)) != 0) {
+    return TSDB_CODE_CLI_OUT_OF_MEMORY;
+  }
+
+  pCtx->numOfSeries++;
+  pPoint->series = index;
+  return TSDB_CODE_SUCCESS;
+}
+
+// points are grouped by measurement and kept in the order of lines, by a counting sort on the index of measurement
+static int32_t tscLineSortPoints(SLineContext *pCtx) {
+  int32_t *pos = calloc((size_t)pCtx->numOfMeasurements + 1, sizeof(int32_t));
+  if (pos == NULL) {
+    return TSDB_CODE_CLI_OUT_OF_MEMORY;
+  }
+
+  for (int32_t i = 0; i < pCtx->numOfPoints; ++i) {
+    pos[pCtx->series[pCtx->points[i].series].measurement + 1]++;
+  }
+
+  for (int32_t i = 1; i <= pCtx->numOfMeasurements; ++i) {
+    pos[i] += pos[i - 1];
+  }
+
+  for (int32_t i = 0; i < pCtx->numOfPoints; ++i) {
+    SLinePoint *pPoint = &pCtx->points[i];
+    pCtx->sorted[pos[pCtx->series[pPoint->series].measurement]++] = pPoint;
+  }
+
+  free(pos);
+  return TSDB_CODE_SUCCESS;
+}
+
+static int32_t tscLineParseAll(SLineContext *pCtx, char *lines[], int numLines) {
+  size_t  total = 0;
+  int32_t numOfKvs = 0;
+  for (int i = 0; i < numLines; ++i) {
+    if (lines[i] == NULL) {
+      return TSDB_CODE_INVALID_VALUE;
+    }
+
+    size_t len = strlen(lines[i]);
+    total += len + 1;
+
+    // each tag or field has an equal sign at least
+    for (size_t j = 0; j < len; ++j) {
+      if (lines[i][j] == '=') numOfKvs++;
+    }
+  }
+
+  pCtx->buf = malloc(total);
+  pCtx->points = calloc((size_t)numLines, sizeof(SLinePoint));
+  pCtx->sorted = malloc(sizeof(SLinePoint *) * numLines);
+  pCtx->kvs = calloc((size_t)numOfKvs + 1, sizeof(SLineKv));
+  pCtx->series = calloc((size_t)numLines, sizeof(SLineSeries));
+  pCtx->pSeriesHashList = taosInitHashTable(128, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), false);
+  pCtx->pMeasurementHashList = taosInitHashTable(16, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), false);
+  if (pCtx->buf == NULL || pCtx->points == NULL || pCtx->sorted == NULL || pCtx->kvs == NULL ||
+      pCtx->series == NULL || pCtx->pSeriesHashList == NULL || pCtx->pMeasurementHashList == NULL) {
+    return TSDB_CODE_CLI_OUT_OF_MEMORY;
+  }
+
+  char *   buf = pCtx->buf;
+  SLineKv *kvs = pCtx->kvs;
+  for (int i = 0; i < numLines; ++i) {
+    size_t len = strlen(lines[i]);
+    memcpy(buf, lines[i], len + 1);
+
+    // empty lines and comments are skipped
+    char *p = buf;
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+    if (*p == 0 || *p == '#') {
+      buf += len + 1;
+      continue;
+    }
+
+    while (len > 0 && (buf[len - 1] == '\n' || buf[len - 1] == '\r')) {
+      buf[--len] = 0;
+    }
+
+    SLinePoint *pPoint = &pCtx->points[pCtx->numOfPoints];
+    pPoint->index = i;
+
+    // the key is taken from the line given, since the copy is modified in place by parsing
+    const char *key = lines[i] + (p - buf);
+    int32_t     keyLen = tscLineKeyLen(p);
+    int32_t *   pSeries = (int32_t *)taosGetDataFromHashTable(pCtx->pSeriesHashList, key, keyLen);
+
+    int32_t code = TSDB_CODE_SUCCESS;
+    if (p[keyLen] != ' ') {
+      code = TSDB_CODE_INVALID_SQL;
+    } else if (pSeries != NULL) {
+      SLinePoint *pFirst = pCtx->series[*pSeries].pPoint;
+      pPoint->series = *pSeries;
+      pPoint->measurement = pFirst->measurement;
+      pPoint->tags = pFirst->tags;
+      pPoint->numOfTags = pFirst->numOfTags;
+    } else {
+      code = tscLineParseTags(p, pPoint, kvs);
+      kvs += pPoint->numOfTags;
+
+      if (code == TSDB_CODE_SUCCESS && pPoint->numOfTags == 0) {
+        tscError("%p line %d has no tag, a super table needs one tag at least:%s", pCtx->pSql, i, lines[i]);
+        return TSDB_CODE_INVALID_SQL;
+      }
+    }
+
+    if (code == TSDB_CODE_SUCCESS) {
+      code = tscLineParseFields(p + keyLen + 1, pPoint, kvs);
+      kvs += pPoint->numOfFields;
+    }
+
+    if (code != TSDB_CODE_SUCCESS) {
+      tscError("%p failed to parse line %d:%s, code:%d", pCtx->pSql, i, lines[i], code);
+      return code;
+    }
+
+    // a series is added once its first point is valid
+    if (pSeries == NULL && (code = tscLineAddSeries(pCtx, pPoint, key, keyLen)) != TSDB_CODE_SUCCESS) {
+      return code;
+    }
+
+    pCtx->numOfPoints++;
+    buf += len + 1;
+  }
+
+  return tscLineSortPoints(pCtx);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// super tables
+
+static int32_t tscLineExecSql(SLineContext *pCtx, const char *sql) {
+  SSqlObj *pSql = calloc(1, sizeof(SSqlObj));
+  if (pSql == NULL) {
+    return TSDB_CODE_CLI_OUT_OF_MEMORY;
+  }
+
+  tsem_init(&pSql->rspSem, 0, 0);
+  tsem_init(&pSql->emptyRspSem, 0, 1);
+  pSql->signature = pSql;
+  pSql->pTscObj = pCtx->pObj;
+  pSql->sqlstr = strdup(sql);
+
+  tscTrace("%p line protocol sql:%s", pCtx->pSql, sql);
+  int32_t code = taos_query_imp(pCtx->pObj, pSql);
+  tscFreeSqlObj(pSql);
+
+  return code;
+}
+
+static const char *tscLineTypeName(uint8_t type) {
+  switch (type) {
+    case TSDB_DATA_TYPE_BOOL:
+      return "bool";
+    case TSDB_DATA_TYPE_BIGINT:
+      return "bigint";
+    case TSDB_DATA_TYPE_DOUBLE:
+      return "double";
+    default:
+      return "binary";
+  }
+}
+
+// bytes of a binary column or tag created for the value, leaves room for longer values
+static int16_t tscLineBinaryBytes(int32_t len) {
+  int32_t bytes = LINE_MIN_BINARY_BYTES;
+  while (bytes < len) bytes <<= 1;
+  return (int16_t)((bytes > TSDB_MAX_BINARY_LEN) ? TSDB_MAX_BINARY_LEN : bytes);
+}
+
+static void tscLineAppendType(SStringBuilder *sb, SLineKv *pKv) {
+  taosStringBuilderAppendString(sb, pKv->key);
+  taosStringBuilderAppendChar(sb, ' ');
+  taosStringBuilderAppendString(sb, tscLineTypeName(pKv->type));
+  if (pKv->type == TSDB_DATA_TYPE_BINARY) {
+    taosStringBuilderAppendChar(sb, '(');
+    taosStringBuilderAppendInteger(sb, tscLineBinaryBytes(pKv->len));
+    taosStringBuilderAppendChar(sb, ')');
+  }
+}
+
+static char *tscLineBuildCreateSql(const char *measurement, SLineKv *pFields, int32_t numOfFields, SLineKv *pTags,
+                                   int32_t numOfTags) {
+  SStringBuilder sb = {0};
+  if (taosStringBuilderSetJmp(&sb) != 0) {
+    taosStringBuilderDestroy(&sb);
+    return NULL;
+  }
+
+  taosStringBuilderAppendString(&sb, "create table if not exists ");
+  taosStringBuilderAppendString(&sb, measurement);
+  taosStringBuilderAppendString(&sb, " (" LINE_TS_COLUMN_NAME " timestamp");
+  for (int32_t i = 0; i < numOfFields; ++i) {
+    taosStringBuilderAppendString(&sb, ", ");
+    tscLineAppendType(&sb, &pFields[i]);
+  }
+
+  taosStringBuilderAppendString(&sb, ") tags (");
+  for (int32_t i = 0; i < numOfTags; ++i) {
+    if (i > 0) taosStringBuilderAppendString(&sb, ", ");
+    tscLineAppendType(&sb, &pTags[i]);
+  }
+  taosStringBuilderAppendChar(&sb, ')');
+
+  return taosStringBuilderGetResult(&sb, NULL);
+}
+
+static char *tscLineBuildAlterSql(const char *measurement, bool isTag, SLineKv *pKv) {
+  SStringBuilder sb = {0};
+  if (taosStringBuilderSetJmp(&sb) != 0) {
+    taosStringBuilderDestroy(&sb);
+    return NULL;
+  }
+
+  taosStringBuilderAppendString(&sb, "alter table ");
+  taosStringBuilderAppendString(&sb, measurement);
+  taosStringBuilderAppendString(&sb, isTag ? " add tag " : " add column ");
+  tscLineAppendType(&sb, pKv);
+
+  return taosStringBuilderGetResult(&sb, NULL);
+}
+
+/*
+ * the fields of all points and the tags of all series of the measurement, the longest value of a key is kept for
+ * binary, points are in [start, end) of the sorted list
+ */
+static int32_t tscLineCollectKeys(SLineContext *pCtx, int32_t start, int32_t end, SLineKv **pFields,
+                                  int32_t *numOfFields, SLineKv **pTags, int32_t *numOfTags) {
+  int32_t maxFields = 0, maxTags = 0;
+  for (int32_t i = start; i < end; ++i) {
+    maxFields += pCtx->sorted[i]->numOfFields;
+    maxTags += pCtx->sorted[i]->numOfTags;
+  }
+
+  *pFields = malloc(sizeof(SLineKv) * maxFields);
+  *pTags = malloc(sizeof(SLineKv) * maxTags);
+  *numOfFields = 0;
+  *numOfTags = 0;
+  if (*pFields == NULL || *pTags == NULL) {
+    return TSDB_CODE_CLI_OUT_OF_MEMORY;
+  }
+
+  for (int32_t i = start; i < end; ++i) {
+    SLinePoint *pPoint = pCtx->sorted[i];
+    bool        isFirst = (pCtx->series[pPoint->series].pPoint == pPoint);
+
+    for (int32_t k = 0; k < 2; ++k) {
+      SLineKv *pList = (k == 0) ? pPoint->fields : pPoint->tags;
+      int32_t  num = (k == 0) ? pPoint->numOfFields : (isFirst ? pPoint->numOfTags : 0);
+      SLineKv *pKeys = (k == 0) ? *pFields : *pTags;
+      int32_t *numOfKeys = (k == 0) ? numOfFields : numOfTags;
+
+      for (int32_t j = 0; j < num; ++j) {
+        int32_t n = 0;
+        while (n < *numOfKeys && strcmp(pKeys[n].key, pList[j].key) != 0) n++;
+
+        if (n == *numOfKeys) {
+          pKeys[(*numOfKeys)++] = pList[j];
+        } else if (pKeys[n].type != pList[j].type) {
+          tscError("%p values of %s.%s are of different types", pCtx->pSql, pPoint->measurement, pList[j].key);
+          return TSDB_CODE_INVALID_VALUE;
+        } else if (pKeys[n].len < pList[j].len) {
+          pKeys[n].len = pList[j].len;
+        }
+      }
+    }
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+static int32_t tscLineFindSchema(SSchema *pSchema, int32_t num, const char *name) {
+  for (int32_t i = 0; i < num; ++i) {
+    if (strcmp(pSchema[i].name, name) == 0) return i;
+  }
+
+  return -1;
+}
+
+static bool tscLineTypeMatch(uint8_t valueType, uint8_t colType) {
+  switch (valueType) {
+    case TSDB_DATA_TYPE_BOOL:
+      return colType == TSDB_DATA_TYPE_BOOL;
+    case TSDB_DATA_TYPE_BIGINT:
+      return (colType >= TSDB_DATA_TYPE_TINYINT && colType <= TSDB_DATA_TYPE_DOUBLE) ||
+             colType == TSDB_DATA_TYPE_TIMESTAMP;
+    case TSDB_DATA_TYPE_DOUBLE:
+      return colType == TSDB_DATA_TYPE_FLOAT || colType == TSDB_DATA_TYPE_DOUBLE;
+    default:
+      return colType == TSDB_DATA_TYPE_BINARY || colType == TSDB_DATA_TYPE_NCHAR;
+  }
+}
+
+static void tscLineFreeSTable(SLineSTable *pSTable) {
+  tfree(pSTable->pSchema);
+  tfree(pSTable->offset);
+  tfree(pSTable->pNullRow);
+}
+
+// keep the schema of the super table, and the null row for its child tables
+static int32_t tscLineSetSTable(SLineContext *pCtx, SMeterMetaInfo *pSTableMeterMetaInfo) {
+  SLineSTable *pSTable = &pCtx->sTable;
+  SMeterMeta * pMeterMeta = pSTableMeterMetaInfo->pMeterMeta;
+
+  tscLineFreeSTable(pSTable);
+  strcpy(pSTable->name, pSTableMeterMetaInfo->name);
+  pSTable->precision = pMeterMeta->precision;
+  pSTable->numOfColumns = pMeterMeta->numOfColumns;
+  pSTable->numOfTags = pMeterMeta->numOfTags;
+  pSTable->rowSize = pMeterMeta->rowSize;
+
+  int32_t total = pSTable->numOfColumns + pSTable->numOfTags;
+  pSTable->pSchema = malloc(sizeof(SSchema) * total);
+  pSTable->offset = malloc(sizeof(int16_t) * pSTable->numOfColumns);
+  pSTable->pNullRow = malloc((size_t)pSTable->rowSize);
+  if (pSTable->pSchema == NULL || pSTable->offset == NULL || pSTable->pNullRow == NULL) {
+    return TSDB_CODE_CLI_OUT_OF_MEMORY;
+  }
+
+  memcpy(pSTable->pSchema, tsGetSchema(pMeterMeta), sizeof(SSchema) * total);
+
+  int16_t offset = 0;
+  for (int32_t i = 0; i < pSTable->numOfColumns; ++i) {
+    pSTable->offset[i] = offset;
+    setNull(pSTable->pNullRow + offset, pSTable->pSchema[i].type, pSTable->pSchema[i].bytes);
+    offset += pSTable->pSchema[i].bytes;
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+static int32_t tscLineGetSTableMeta(SLineContext *pCtx, SMeterMetaInfo *pSTableMeterMetaInfo, bool renew) {
+  if (renew) {
+    taosRemoveDataFromCache(tscCacheHandle, (void **)&pSTableMeterMetaInfo->pMeterMeta, true);
+  }
+
+  return tscGetMeterMeta(pCtx->pSql, pSTableMeterMetaInfo);
+}
+
+/*
+ * create the super table of the measurement if not exists, or add the new fields and tags to it.
+ * A column is added by other clients at the same time may fail the alter, so the schema is checked again at last.
+ */
+static int32_t tscLinePrepareSTable(SLineContext *pCtx, int32_t start, int32_t end) {
+  SSqlObj *       pSql = pCtx->pSql;
+  SQueryInfo *    pQueryInfo = tscGetQueryInfoDetail(&pSql->cmd, 0);
+  SMeterMetaInfo *pSTableMeterMetaInfo = tscGetMeterMetaInfoFromQueryInfo(pQueryInfo, 1);
+  char *          measurement = pCtx->sorted[start]->measurement;
+
+  SLineKv *pFields = NULL, *pTags = NULL;
+  int32_t  numOfFields = 0, numOfTags = 0;
+
+  int32_t code = tscLineCollectKeys(pCtx, start, end, &pFields, &numOfFields, &pTags, &numOfTags);
+  if (code != TSDB_CODE_SUCCESS) {
+    goto _clean;
+  }
+
+  SSQLToken token = {.z = measurement, .n = (uint32_t)strlen(measurement), .type = TK_ID};
+  if ((code = setMeterID(pSTableMeterMetaInfo, &token, pSql)) != TSDB_CODE_SUCCESS) {
+    goto _clean;
+  }
+
+  code = tscLineGetSTableMeta(pCtx, pSTableMeterMetaInfo, false);
+
+  if (code == TSDB_CODE_INVALID_TABLE) {
+    char *sql = tscLineBuildCreateSql(measurement, pFields, numOfFields, pTags, numOfTags);
+    code = (sql == NULL) ? TSDB_CODE_CLI_OUT_OF_MEMORY : tscLineExecSql(pCtx, sql);
+    tfree(sql);
+    if (code != TSDB_CODE_SUCCESS) {
+      tscError("%p failed to create super table %s, code:%d", pSql, measurement, code);
+      goto _clean;
+    }
+
+    code = tscLineGetSTableMeta(pCtx, pSTableMeterMetaInfo, true);
+  }
+
+  if (code != TSDB_CODE_SUCCESS) {
+    goto _clean;
+  }
+
+  for (int32_t round = 0; round < 2; ++round) {
+    if (!UTIL_METER_IS_SUPERTABLE(pSTableMeterMetaInfo)) {
+      tscError("%p %s is not a super table", pSql, measurement);
+      code = TSDB_CODE_INVALID_TABLE;
+      goto _clean;
+    }
+
+    SMeterMeta *pMeterMeta = pSTableMeterMetaInfo->pMeterMeta;
+    SSchema *   pSchema = tsGetSchema(pMeterMeta);
+    SSchema *   pTagSchema = tsGetTagSchema(pMeterMeta);
+    bool        altered = false;
+
+    for (int32_t k = 0; k < 2; ++k) {
+      SLineKv *pKeys = (k == 0) ? pFields : pTags;
+      int32_t  numOfKeys = (k == 0) ? numOfFields : numOfTags;
+      SSchema *pList = (k == 0) ? pSchema : pTagSchema;
+      int32_t  num = (k == 0) ? pMeterMeta->numOfColumns : pMeterMeta->numOfTags;
+
+      for (int32_t i = 0; i < numOfKeys; ++i) {
+        int32_t index = tscLineFindSchema(pList, num, pKeys[i].key);
+        if (index >= 0) {
+          // tags are strings in lines, they are converted to the type of the tag
+          if (k == 0 && !tscLineTypeMatch(pKeys[i].type, pList[index].type)) {
+            tscError("%p type of %s.%s does not match the value", pSql, measurement, pKeys[i].key);
+            code = TSDB_CODE_INVALID_VALUE;
+            goto _clean;
+          }
+          continue;
+        }
+
+        if (round > 0) {
+          tscError("%p failed to add %s to super table %s", pSql, pKeys[i].key, measurement);
+          code = TSDB_CODE_INVALID_SQL;
+          goto _clean;
+        }
+
+        char *sql = tscLineBuildAlterSql(measurement, k > 0, &pKeys[i]);
+        code = (sql == NULL) ? TSDB_CODE_CLI_OUT_OF_MEMORY : tscLineExecSql(pCtx, sql);
+        tfree(sql);
+        if (code != TSDB_CODE_SUCCESS) {
+          tscTrace("%p failed to add %s to super table %s, code:%d", pSql, pKeys[i].key, measurement, code);
+        }
+
+        altered = true;
+      }
+    }
+
+    if (!altered) {
+      break;
+    }
+
+    if ((code = tscLineGetSTableMeta(pCtx, pSTableMeterMetaInfo, true)) != TSDB_CODE_SUCCESS) {
+      goto _clean;
+    }
+  }
+
+  code = tscLineSetSTable(pCtx, pSTableMeterMetaInfo);
+
+_clean:
+  tfree(pFields);
+  tfree(pTags);
+  return code;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// child tables and rows
+
+static int32_t tscLineSetTag(char *dst, SSchema *pSchema, SLineKv *pTag) {
+  if (pSchema->type == TSDB_DATA_TYPE_BINARY) {
+    if (pTag->len > pSchema->bytes) return TSDB_CODE_INVALID_VALUE;
+    memcpy(dst, pTag->value, (size_t)pTag->len);
+    return TSDB_CODE_SUCCESS;
+  }
+
+  if (pSchema->type == TSDB_DATA_TYPE_NCHAR) {
+    return taosMbsToUcs4(pTag->value, pTag->len, dst, pSchema->bytes) ? TSDB_CODE_SUCCESS : TSDB_CODE_INVALID_VALUE;
+  }
+
+  tVariant var = {.nType = TSDB_DATA_TYPE_BINARY, .pz = pTag->value, .nLen = pTag->len};
+  return (tVariantDump(&var, dst, pSchema->type) == 0) ? TSDB_CODE_SUCCESS : TSDB_CODE_INVALID_VALUE;
+}
+
+// tag values of the child table to create, tags not in the point are null
+static int32_t tscLineSetTagData(SLineContext *pCtx, SLinePoint *pPoint, char *data) {
+  SLineSTable *pSTable = &pCtx->sTable;
+  SSchema *    pTagSchema = pSTable->pSchema + pSTable->numOfColumns;
+
+  for (int32_t i = 0; i < pSTable->numOfTags; ++i) {
+    SLineKv *pKv = NULL;
+    for (int32_t j = 0; j < pPoint->numOfTags && pKv == NULL; ++j) {
+      if (strcmp(pPoint->tags[j].key, pTagSchema[i].name) == 0) pKv = &pPoint->tags[j];
+    }
+
+    if (pKv == NULL) {
+      setNull(data, pTagSchema[i].type, pTagSchema[i].bytes);
+    } else if (tscLineSetTag(data, &pTagSchema[i], pKv) != TSDB_CODE_SUCCESS) {
+      tscError("%p invalid value of tag %s:%s", pCtx->pSql, pKv->key, pKv->value);
+      return TSDB_CODE_INVALID_VALUE;
+    }
+
+    data += pTagSchema[i].bytes;
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+/*
+ * data block of the child table of the series, the table is created by mgmt from the super table if it is neither
+ * created along with the others of the measurement
+ */
+static int32_t tscLineGetChildBlock(SLineContext *pCtx, SLineSeries *pSeries) {
+  SSqlObj *          pSql = pCtx->pSql;
+  SSqlCmd *          pCmd = &pSql->cmd;
+  STableDataBlocks **pBlock = &pSeries->pBlock;
+  int32_t            nameLen = (int32_t)strlen(pSeries->childName);
+
+  // lines of a child table may have the tags in different orders
+  STableDataBlocks **p = (STableDataBlocks **)taosGetDataFromHashTable(pCtx->pChildHashList, pSeries->childName, nameLen);
+  if (p != NULL) {
+    *pBlock = *p;
+    return TSDB_CODE_SUCCESS;
+  }
+
+  SMeterMetaInfo *pMeterMetaInfo = tscGetMeterMetaInfo(pCmd, 0, 0);
+  SSQLToken       token = {.z = pSeries->childName, .n = (uint32_t)nameLen, .type = TK_ID};
+
+  int32_t code = setMeterID(pMeterMetaInfo, &token, pSql);
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  code = tscGetMeterMeta(pSql, pMeterMetaInfo);
+  if (code == TSDB_CODE_INVALID_TABLE) {
+    STagData *pTag = (STagData *)pCmd->payload;
+    memset(pTag, 0, sizeof(STagData));
+    strncpy(pTag->name, pCtx->sTable.name, TSDB_METER_ID_LEN);
+
+    if ((code = tscLineSetTagData(pCtx, pSeries->pPoint, pTag->data)) != TSDB_CODE_SUCCESS) {
+      return code;
+    }
+
+    code = tscGetMeterMetaEx(pSql, pMeterMetaInfo, true);
+    pCmd->createOnDemand = false;
+  }
+
+  // the cached meta of the child table is out of date if columns are just added to the super table
+  if (code == TSDB_CODE_SUCCESS && pMeterMetaInfo->pMeterMeta->numOfColumns != pCtx->sTable.numOfColumns) {
+    taosRemoveDataFromCache(tscCacheHandle, (void **)&pMeterMetaInfo->pMeterMeta, true);
+    code = tscGetMeterMeta(pSql, pMeterMetaInfo);
+  }
+
+  if (code != TSDB_CODE_SUCCESS) {
+    tscError("%p failed to get meter meta of %s, code:%d", pSql, pSeries->childName, code);
+    return code;
+  }
+
+  SMeterMeta *pMeterMeta = pMeterMetaInfo->pMeterMeta;
+  if (!UTIL_METER_IS_CREATE_FROM_METRIC(pMeterMetaInfo) || pMeterMeta->numOfColumns != pCtx->sTable.numOfColumns ||
+      pMeterMeta->rowSize != pCtx->sTable.rowSize) {
+    tscError("%p schema of table %s is different from super table %s", pSql, pSeries->childName, pCtx->sTable.name);
+    return TSDB_CODE_INVALID_TABLE;
+  }
+
+  code = tscGetDataBlockFromList(pCtx->pTableHashList, pCmd->pDataBlocks, pMeterMeta->uid, TSDB_DEFAULT_PAYLOAD_SIZE,
+                                 sizeof(SShellSubmitBlock), pMeterMeta->rowSize, pMeterMetaInfo->name, pMeterMeta,
+                                 pBlock);
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  SShellSubmitBlock *pSubmit = (SShellSubmitBlock *)(*pBlock)->pData;
+  pSubmit->sid = pMeterMeta->sid;
+  pSubmit->uid = pMeterMeta->uid;
+  pSubmit->sversion = pMeterMeta->sversion;
+  pSubmit->numOfRows = 0;
+
+  (*pBlock)->vgid = pMeterMeta->vgid;
+  (*pBlock)->numOfMeters = 1;
+
+  taosAddToHashTable(pCtx->pChildHashList, pSeries->childName, nameLen, (char *)pBlock, POINTER_BYTES);
+  return TSDB_CODE_SUCCESS;
+}
+
+static void tscLineSendCreateMsg(SLineContext *pCtx, SSqlObj *pNew) {
+  SSqlCmd *pCmd = &pNew->cmd;
+  int32_t  count = pCmd->count;
+
+  // the multi meter meta msg is built by the parser for SQL, not by tscProcessSql
+  int32_t code = tscBuildMsg[TSDB_SQL_MULTI_META](pNew, NULL);
+  if (code == TSDB_CODE_SUCCESS) {
+    code = tscProcessSql(pNew);
+  }
+
+  tscTrace("%p %d of %d child tables of %s are created or loaded by one request, code:%d", pCtx->pSql,
+           pNew->res.numOfTotal, count, pCtx->sTable.name, code);
+
+  // the payload is moved behind the msg head when built, it is filled from the start again
+  pCmd->count = 0;
+  pCmd->payloadLen = 0;
+}
+
+/*
+ * child tables of the measurement not in the cache are created from the super table and their metas are loaded, by
+ * one request to mgmt for many tables, instead of one meter meta request each. It is an optimization only, tables
+ * left out are created one by one when their data blocks are built, and the errors are reported then.
+ */
+static void tscLineCreateChildTables(SLineContext *pCtx, int32_t measurement) {
+  SLineSTable *pSTable = &pCtx->sTable;
+
+  int32_t tagLen = 0;
+  for (int32_t i = 0; i < pSTable->numOfTags; ++i) {
+    tagLen += pSTable->pSchema[pSTable->numOfColumns + i].bytes;
+  }
+
+  SSqlObj *pNew = calloc(1, sizeof(SSqlObj));
+  if (pNew == NULL) {
+    return;
+  }
+
+  tsem_init(&pNew->rspSem, 0, 0);
+  tsem_init(&pNew->emptyRspSem, 0, 1);
+  pNew->signature = pNew;
+  pNew->pTscObj = pCtx->pObj;
+
+  SSqlCmd *pCmd = &pNew->cmd;
+  pCmd->command = TSDB_SQL_MULTI_META;
+  pCmd->createOnDemand = true;
+
+  int32_t     entrySize = (int32_t)sizeof(SMultiCreateMeterInfo) + tagLen;
+  SQueryInfo *pQueryInfo = NULL;
+  if (tscGetQueryInfoDetailSafely(pCmd, 0, &pQueryInfo) != TSDB_CODE_SUCCESS ||
+      tscAllocPayload(pCmd, entrySize * LINE_MAX_TABLES_PER_CREATE + TSDB_DEFAULT_PAYLOAD_SIZE) != TSDB_CODE_SUCCESS ||
+      tscAddEmptyMeterMetaInfo(pQueryInfo) == NULL) {
+    tscFreeSqlObj(pNew);
+    return;
+  }
+
+  SMeterMetaInfo *pMeterMetaInfo = tscGetMeterMetaInfoFromQueryInfo(pQueryInfo, 0);
+
+  for (int32_t i = 0; i < pCtx->numOfSeries; ++i) {
+    SLineSeries *pSeries = &pCtx->series[i];
+    if (pSeries->measurement != measurement) {
+      continue;
+    }
+
+    SSQLToken token = {.z = pSeries->childName, .n = (uint32_t)strlen(pSeries->childName), .type = TK_ID};
+    if (setMeterID(pMeterMetaInfo, &token, pNew) != TSDB_CODE_SUCCESS) {
+      continue;
+    }
+
+    SMeterMeta *pMeterMeta = taosGetDataFromCache(tscCacheHandle, pMeterMetaInfo->name);
+    if (pMeterMeta != NULL) {
+      taosRemoveDataFromCache(tscCacheHandle, (void **)&pMeterMeta, false);
+      continue;
+    }
+
+    SMultiCreateMeterInfo *pInfo = (SMultiCreateMeterInfo *)(pCmd->payload + pCmd->payloadLen);
+    memset(pInfo, 0, (size_t)entrySize);
+    strcpy(pInfo->meterId, pMeterMetaInfo->name);
+    strcpy(pInfo->stableId, pSTable->name);
+    pInfo->tagLen = htons((int16_t)tagLen);
+
+    if (tscLineSetTagData(pCtx, pSeries->pPoint, pInfo->tags) != TSDB_CODE_SUCCESS) {
+      continue;
+    }
+
+    pCmd->payloadLen += entrySize;
+    if (++pCmd->count == LINE_MAX_TABLES_PER_CREATE) {
+      tscLineSendCreateMsg(pCtx, pNew);
+    }
+  }
+
+  if (pCmd->count > 0) {
+    tscLineSendCreateMsg(pCtx, pNew);
+  }
+
+  tscFreeSqlObj(pNew);
+}
+
+static int32_t tscLineSetColumn(char *dst, SSchema *pSchema, SLineKv *pKv) {
+  int64_t v = pKv->i64;
+
+  switch (pSchema->type) {
+    case TSDB_DATA_TYPE_BOOL:
+      *(int8_t *)dst = (int8_t)v;
+      break;
+    case TSDB_DATA_TYPE_TINYINT:
+      if (v <= INT8_MIN || v > INT8_MAX) return TSDB_CODE_INVALID_VALUE;
+      *(int8_t *)dst = (int8_t)v;
+      break;
+    case TSDB_DATA_TYPE_SMALLINT:
+      if (v <= INT16_MIN || v > INT16_MAX) return TSDB_CODE_INVALID_VALUE;
+      *(int16_t *)dst = (int16_t)v;
+      break;
+    case TSDB_DATA_TYPE_INT:
+      if (v <= INT32_MIN || v > INT32_MAX) return TSDB_CODE_INVALID_VALUE;
+      *(int32_t *)dst = (int32_t)v;
+      break;
+    case TSDB_DATA_TYPE_BIGINT:
+    case TSDB_DATA_TYPE_TIMESTAMP:
+      if (v == INT64_MIN) return TSDB_CODE_INVALID_VALUE;
+      *(int64_t *)dst = v;
+      break;
+    case TSDB_DATA_TYPE_FLOAT: {
+      float f = (pKv->type == TSDB_DATA_TYPE_DOUBLE) ? (float)pKv->dbl : (float)v;
+      *((float *)dst) = f;
+      break;
+    }
+    case TSDB_DATA_TYPE_DOUBLE: {
+      double d = (pKv->type == TSDB_DATA_TYPE_DOUBLE) ? pKv->dbl : (double)v;
+      *((double *)dst) = d;
+      break;
+    }
+    case TSDB_DATA_TYPE_BINARY:
+      if (pKv->len > pSchema->bytes) return TSDB_CODE_INVALID_VALUE;
+      memcpy(dst, pKv->value, (size_t)pKv->len);
+      memset(dst + pKv->len, 0, (size_t)(pSchema->bytes - pKv->len));
+      break;
+    case TSDB_DATA_TYPE_NCHAR:
+      if (!taosMbsToUcs4(pKv->value, pKv->len, dst, pSchema->bytes)) return TSDB_CODE_INVALID_VALUE;
+      break;
+    default:
+      return TSDB_CODE_INVALID_VALUE;
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+static int32_t tscLineAppendRow(SLineContext *pCtx, STableDataBlocks *pBlock, SLinePoint *pPoint) {
+  SLineSTable *pSTable = &pCtx->sTable;
+
+  uint32_t size = pBlock->size + pSTable->rowSize;
+  if (size > pBlock->nAllocSize) {
+    uint32_t allocSize = (uint32_t)(size * 1.5);
+    char *   tmp = realloc(pBlock->pData, allocSize);
+    if (tmp == NULL) {
+      return TSDB_CODE_CLI_OUT_OF_MEMORY;
+    }
+
+    pBlock->pData = tmp;
+    pBlock->nAllocSize = allocSize;
+  }
+
+  char *row = pBlock->pData + pBlock->size;
+  memcpy(row, pSTable->pNullRow, (size_t)pSTable->rowSize);
+
+  // timestamps of lines are in nanoseconds
+  TSKEY k = 0;
+  if (!pPoint->hasTs) {
+    k = taosGetTimestamp(pSTable->precision);
+  } else if (pSTable->precision == TSDB_TIME_PRECISION_MICRO) {
+    k = pPoint->ts / 1000L;
+  } else {
+    k = pPoint->ts / 1000000L;
+  }
+
+  *(TSKEY *)row = k;
+
+  // fields of points of a measurement are usually in the same order, so search from the column after the last one
+  int32_t col = 0;
+  for (int32_t i = 0; i < pPoint->numOfFields; ++i) {
+    SLineKv *pField = &pPoint->fields[i];
+
+    int32_t n = 0;
+    for (; n < pSTable->numOfColumns - 1; ++n) {
+      col = (col + 1 < pSTable->numOfColumns) ? col + 1 : 1;
+      if (strcmp(pSTable->pSchema[col].name, pField->key) == 0) break;
+    }
+
+    if (n == pSTable->numOfColumns - 1 || tscLineSetColumn(row + pSTable->offset[col], &pSTable->pSchema[col],
+                                                           pField) != TSDB_CODE_SUCCESS) {
+      tscError("%p invalid value of %s.%s in line %d", pCtx->pSql, pPoint->measurement, pField->key, pPoint->index);
+      return TSDB_CODE_INVALID_VALUE;
+    }
+  }
+
+  if (pBlock->ordered) {
+    if (k <= pBlock->prevTS) pBlock->ordered = false;
+    pBlock->prevTS = k;
+  }
+
+  pBlock->size = size;
+  ((SShellSubmitBlock *)pBlock->pData)->numOfRows += 1;
+
+  return TSDB_CODE_SUCCESS;
+}
+
+static int32_t tscLineResetBlocks(SLineContext *pCtx) {
+  SSqlCmd *pCmd = &pCtx->pSql->cmd;
+
+  for (int32_t i = 0; i < pCtx->numOfSeries; ++i) {
+    pCtx->series[i].pBlock = NULL;
+  }
+
+  pCmd->pDataBlocks = tscDestroyBlockArrayList(pCmd->pDataBlocks);
+  taosCleanUpHashTable(pCtx->pTableHashList);
+  taosCleanUpHashTable(pCtx->pChildHashList);
+
+  pCmd->pDataBlocks = tscCreateBlockArrayList();
+  pCtx->pTableHashList = taosInitHashTable(128, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BIGINT), false);
+  pCtx->pChildHashList = taosInitHashTable(128, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), false);
+
+  if (pCmd->pDataBlocks == NULL || pCtx->pTableHashList == NULL || pCtx->pChildHashList == NULL) {
+    return TSDB_CODE_CLI_OUT_OF_MEMORY;
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+// merge the blocks of child tables by vnode and send them
+static int32_t tscLineSubmit(SLineContext *pCtx) {
+  SSqlObj *pSql = pCtx->pSql;
+  SSqlCmd *pCmd = &pSql->cmd;
+  SSqlRes *pRes = &pSql->res;
+
+  if (pCmd->pDataBlocks->nSize == 0) {
+    return TSDB_CODE_SUCCESS;
+  }
+
+  int32_t code = tscMergeTableDataBlocks(pSql, pCmd->pDataBlocks);
+  if (code == TSDB_CODE_SUCCESS) {
+    code = tscCopyDataBlockToPayload(pSql, pCmd->pDataBlocks->pData[0]);
+  }
+
+  if (code == TSDB_CODE_SUCCESS) {
+    SMeterMetaInfo *pMeterMetaInfo = tscGetMeterMetaInfo(pCmd, 0, 0);
+    pMeterMetaInfo->vnodeIndex = 1;
+
+    pRes->numOfRows = 0;
+    pRes->qhandle = 0;
+    pSql->thandle = NULL;
+
+    tscDoQuery(pSql);
+    code = pRes->code;
+  }
+
+  int32_t ret = tscLineResetBlocks(pCtx);
+  return (code != TSDB_CODE_SUCCESS) ? code : ret;
+}
+
+static int32_t tscLineInsertPoints(SLineContext *pCtx) {
+  int32_t code = tscLineResetBlocks(pCtx);
+
+  for (int32_t start = 0, end = 0; code == TSDB_CODE_SUCCESS && start < pCtx->numOfPoints; start = end) {
+    int32_t measurement = pCtx->series[pCtx->sorted[start]->series].measurement;
+
+    end = start + 1;
+    while (end < pCtx->numOfPoints && pCtx->series[pCtx->sorted[end]->series].measurement == measurement) {
+      end++;
+    }
+
+    if ((code = tscLinePrepareSTable(pCtx, start, end)) != TSDB_CODE_SUCCESS) {
+      break;
+    }
+
+    tscLineCreateChildTables(pCtx, measurement);
+
+    for (int32_t i = start; i < end; ++i) {
+      SLinePoint * pPoint = pCtx->sorted[i];
+      SLineSeries *pSeries = &pCtx->series[pPoint->series];
+
+      if (pSeries->pBlock == NULL && (code = tscLineGetChildBlock(pCtx, pSeries)) != TSDB_CODE_SUCCESS) {
+        break;
+      }
+
+      STableDataBlocks *pBlock = pSeries->pBlock;
+      if ((code = tscLineAppendRow(pCtx, pBlock, pPoint)) != TSDB_CODE_SUCCESS) {
+        break;
+      }
+
+      // numOfRows of a submit block is a short
+      if (((SShellSubmitBlock *)pBlock->pData)->numOfRows >= INT16_MAX) {
+        if ((code = tscLineSubmit(pCtx)) != TSDB_CODE_SUCCESS) {
+          break;
+        }
+      }
+    }
+  }
+
+  if (code == TSDB_CODE_SUCCESS) {
+    code = tscLineSubmit(pCtx);
+  }
+
+  return code;
+}
+
+static SSqlObj *tscLineCreateSqlObj(STscObj *pObj) {
+  SSqlObj *pSql = calloc(1, sizeof(SSqlObj));
+  if (pSql == NULL) {
+    return NULL;
+  }
+
+  tsem_init(&pSql->rspSem, 0, 0);
+  tsem_init(&pSql->emptyRspSem, 0, 1);
+  pSql->signature = pSql;
+  pSql->pTscObj = pObj;
+
+  // there is no sql, but the meter meta renewed on a vnode error is retrieved by a copy of the sql string
+  pSql->sqlstr = strdup("insert lines");
+
+  SSqlCmd *pCmd = &pSql->cmd;
+  pCmd->command = TSDB_SQL_INSERT;
+
+  SQueryInfo *pQueryInfo = NULL;
+  if (pSql->sqlstr == NULL || tscGetQueryInfoDetailSafely(pCmd, 0, &pQueryInfo) != TSDB_CODE_SUCCESS ||
+      tscAllocPayload(pCmd, TSDB_DEFAULT_PAYLOAD_SIZE) != TSDB_CODE_SUCCESS) {
+    tscFreeSqlObj(pSql);
+    return NULL;
+  }
+
+  TSDB_QUERY_SET_TYPE(pQueryInfo->type, TSDB_QUERY_TYPE_INSERT);
+
+  // the child table is at index 0, and its super table at index 1
+  tscAddEmptyMeterMetaInfo(pQueryInfo);
+  tscAddEmptyMeterMetaInfo(pQueryInfo);
+
+  return pSql;
+}
+
+int taos_insert_lines(TAOS *taos, char *lines[], int numLines) {
+  STscObj *pObj = (STscObj *)taos;
+  if (pObj == NULL || pObj->signature != pObj) {
+    globalCode = TSDB_CODE_DISCONNECTED;
+    return TSDB_CODE_DISCONNECTED;
+  }
+
+  if (!pObj->writeAuth) {
+    return TSDB_CODE_NO_RIGHTS;
+  }
+
+  if (lines == NULL || numLines <= 0) {
+    return TSDB_CODE_INVALID_VALUE;
+  }
+
+  SLineContext ctx = {.pObj = pObj};
+  int32_t      code = TSDB_CODE_SUCCESS;
+
+  ctx.pSql = tscLineCreateSqlObj(pObj);
+  if (ctx.pSql == NULL) {
+    return TSDB_CODE_CLI_OUT_OF_MEMORY;
+  }
+
+  int64_t st = taosGetTimestampUs();
+
+  code = tscLineParseAll(&ctx, lines, numLines);
+  if (code == TSDB_CODE_SUCCESS) {
+    code = tscLineInsertPoints(&ctx);
+  }
+
+  tscTrace("%p %d lines of %d points are processed, code:%d, elapsed time:%" PRId64 " us", ctx.pSql, numLines,
+           ctx.numOfPoints, code, taosGetTimestampUs() - st);
+
+  taosCleanUpHashTable(ctx.pSeriesHashList);
+  taosCleanUpHashTable(ctx.pMeasurementHashList);
+  taosCleanUpHashTable(ctx.pTableHashList);
+  taosCleanUpHashTable(ctx.pChildHashList);
+  tscLineFreeSTable(&ctx.sTable);
+  tscFreeSqlObj(ctx.pSql);
+
+  tfree(ctx.buf);
+  tfree(ctx.points);
+  tfree(ctx.sorted);
+  tfree(ctx.kvs);
+  tfree(ctx.series);
+
+  return code;
+}
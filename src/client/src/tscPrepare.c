@@ -14,9 +14,13 @@
  */
 
 #include "taos.h"
+#include "hash.h"
 #include "tsclient.h"
 #include "tscSQLParser.h"
 #include "tscUtil.h"
+#include "tschemautil.h"
+#include "tsqldef.h"
+#include "tstoken.h"
 #include "ttimer.h"
 #include "taosmsg.h"
 #include "tstrbuild.h"
@@ -24,6 +28,7 @@
 
 int tsParseInsertSql(SSqlObj *pSql);
 int taos_query_imp(STscObj* pObj, SSqlObj* pSql);
+int validateTableName(char *tblName, int len);
 
 ////////////////////////////////////////////////////////////////////////////////
 // functions for normal statement preparation
@@ -47,11 +52,32 @@ typedef struct SNormalStmt {
 //
 //} SInsertStmt;
 
+/*
+ * An insert statement of one values tuple can be bound to many tables of the same schema, the table is switched by
+ * taos_stmt_set_tbname. Rows of each table are appended to its own data block, and all of them are merged by vnode
+ * and sent when the statement is executed.
+ */
+typedef struct SMultiTbStmt {
+  bool              enabled;
+  bool              tbnameParam;   // "insert into ? ...", the sql is parsed when the first table name is set
+  uint32_t          tbnameOffset;  // offset of the table name parameter in the sql string
+  int16_t           numOfColumns;
+  int32_t           rowSize;
+  SSchema*          pSchema;       // schema of the parsed table, the bound tables shall be identical to it
+  char*             pRow;          // the parsed row, constants in it are copied into each bound row
+  uint32_t          numOfParams;
+  SParamInfo*       params;
+  void*             pTableHashList;  // data blocks of the bound tables, keyed by uid
+  STableDataBlocks* pCurBlock;
+  char              tbname[TSDB_METER_ID_LEN];
+} SMultiTbStmt;
+
 typedef struct STscStmt {
   bool isInsert;
   STscObj* taos;
   SSqlObj* pSql;
   SNormalStmt normal;
+  SMultiTbStmt multi;
 } STscStmt;
 
 
@@ -263,7 +289,7 @@ static char* normalStmtBuildSql(STscStmt* stmt) {
 
 static int doBindParam(char* data, SParamInfo* param, TAOS_BIND* bind) {
   if (bind->is_null != NULL && *(bind->is_null)) {
-    setNull(data, param->type, param->bytes);
+    setNull(data + param->offset, param->type, param->bytes);
     return TSDB_CODE_SUCCESS;
   }
 
@@ -378,6 +404,11 @@ static int insertStmtBindParam(STscStmt* stmt, TAOS_BIND* bind) {
 
 static int insertStmtAddBatch(STscStmt* stmt) {
   SSqlCmd* pCmd = &stmt->pSql->cmd;
+  if (stmt->multi.enabled) {
+    // rows are appended to the table blocks once they are bound
+    return TSDB_CODE_SUCCESS;
+  }
+
   if ((pCmd->batchSize % 2) == 1) {
     ++pCmd->batchSize;
   }
@@ -389,9 +420,461 @@ static int insertStmtPrepare(STscStmt* stmt) {
   pSql->cmd.numOfParams = 0;
   pSql->cmd.batchSize = 0;
 
+  // the table name is a parameter, the sql can not be parsed before the first table is set
+  int32_t   index = 0;
+  SSQLToken sToken = tStrGetToken(pSql->sqlstr, &index, false, 0, NULL);
+  sToken = tStrGetToken(pSql->sqlstr, &index, false, 0, NULL);
+  if (sToken.type == TK_INTO) {
+    sToken = tStrGetToken(pSql->sqlstr, &index, false, 0, NULL);
+    if (sToken.type == TK_QUESTION) {
+      SSQLToken next = tStrGetToken(pSql->sqlstr, &index, false, 0, NULL);
+      if (next.type != TK_VALUES && next.type != TK_LP) {
+        tscError("%p only VALUES clause is allowed after the table name parameter", pSql);
+        return TSDB_CODE_OPS_NOT_SUPPORT;
+      }
+
+      stmt->multi.tbnameParam = true;
+      stmt->multi.tbnameOffset = (uint32_t)(sToken.z - pSql->sqlstr);
+      return TSDB_CODE_SUCCESS;
+    }
+  }
+
   return tsParseInsertSql(pSql);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// functions for binding rows of multiple tables to one insertion statement
+
+// drop all bound rows, the current table is bound again when the next row arrives
+static void multiTbStmtClearBlocks(STscStmt* pStmt) {
+  SMultiTbStmt* pMulti = &pStmt->multi;
+  SSqlCmd*      pCmd = &pStmt->pSql->cmd;
+
+  pCmd->pDataBlocks = tscDestroyBlockArrayList(pCmd->pDataBlocks);
+  taosCleanUpHashTable(pMulti->pTableHashList);
+  pMulti->pTableHashList = NULL;
+  pMulti->pCurBlock = NULL;
+}
+
+static void multiTbStmtDestroy(STscStmt* pStmt) {
+  SMultiTbStmt* pMulti = &pStmt->multi;
+
+  // the data blocks are released with the sql object
+  taosCleanUpHashTable(pMulti->pTableHashList);
+  tfree(pMulti->pSchema);
+  tfree(pMulti->pRow);
+  tfree(pMulti->params);
+}
+
+/*
+ * keep the parsed values tuple as the template of bound rows, the data block of the parsed table is dropped, since
+ * rows are bound to the table set by taos_stmt_set_tbname from now on.
+ */
+static int multiTbStmtInit(STscStmt* pStmt) {
+  SMultiTbStmt* pMulti = &pStmt->multi;
+  SSqlCmd*      pCmd = &pStmt->pSql->cmd;
+
+  // rows bound by taos_stmt_add_batch can not be moved to other tables
+  if (pCmd->batchSize > 0 || pCmd->pDataBlocks == NULL || pCmd->pDataBlocks->nSize != 1) {
+    tscError("%p statement of multiple tables or bound rows can not be bound to other tables", pStmt->pSql);
+    return TSDB_CODE_OPS_NOT_SUPPORT;
+  }
+
+  STableDataBlocks* pBlock = pCmd->pDataBlocks->pData[0];
+  SMeterMeta*       pMeterMeta = pBlock->pMeterMeta;
+  if (pBlock->size != sizeof(SShellSubmitBlock) + pBlock->rowSize) {
+    tscError("%p only one values tuple is allowed to bind multiple tables", pStmt->pSql);
+    return TSDB_CODE_OPS_NOT_SUPPORT;
+  }
+
+  pMulti->numOfColumns = pMeterMeta->numOfColumns;
+  pMulti->rowSize = pBlock->rowSize;
+  pMulti->numOfParams = pBlock->numOfParams;
+
+  pMulti->pSchema = malloc(sizeof(SSchema) * pMulti->numOfColumns);
+  pMulti->pRow = malloc((size_t)pMulti->rowSize);
+  pMulti->params = malloc(sizeof(SParamInfo) * (pMulti->numOfParams + 1));
+  if (pMulti->pSchema == NULL || pMulti->pRow == NULL || pMulti->params == NULL) {
+    multiTbStmtDestroy(pStmt);
+    return TSDB_CODE_CLI_OUT_OF_MEMORY;
+  }
+
+  memcpy(pMulti->pSchema, tsGetSchema(pMeterMeta), sizeof(SSchema) * pMulti->numOfColumns);
+  memcpy(pMulti->pRow, pBlock->pData + sizeof(SShellSubmitBlock), (size_t)pMulti->rowSize);
+  memcpy(pMulti->params, pBlock->params, sizeof(SParamInfo) * pMulti->numOfParams);
+  strncpy(pMulti->tbname, pBlock->meterId, TSDB_METER_ID_LEN);
+
+  multiTbStmtClearBlocks(pStmt);
+  pMulti->enabled = true;
+  return TSDB_CODE_SUCCESS;
+}
+
+// substitute the table name parameter with the first table, and parse the sql for the template row
+static int multiTbStmtParse(STscStmt* pStmt, const char* name) {
+  SMultiTbStmt* pMulti = &pStmt->multi;
+  SSqlObj*      pSql = pStmt->pSql;
+
+  size_t nameLen = strlen(name);
+  size_t len = strlen(pSql->sqlstr);
+  char*  sql = malloc(len + nameLen);
+  if (sql == NULL) {
+    return TSDB_CODE_CLI_OUT_OF_MEMORY;
+  }
+
+  memcpy(sql, pSql->sqlstr, pMulti->tbnameOffset);
+  memcpy(sql + pMulti->tbnameOffset, name, nameLen);
+  strcpy(sql + pMulti->tbnameOffset + nameLen, pSql->sqlstr + pMulti->tbnameOffset + 1);
+
+  char* sqlstr = pSql->sqlstr;
+  pSql->sqlstr = sql;
+
+  int code = tsParseInsertSql(pSql);
+  if (code == TSDB_CODE_SUCCESS) {
+    code = multiTbStmtInit(pStmt);
+  }
+
+  // keep the table name parameter in sql, another table may be set later
+  if (code != TSDB_CODE_SUCCESS) {
+    pSql->sqlstr = sqlstr;
+    free(sql);
+    return code;
+  }
+
+  free(sqlstr);
+  pMulti->tbnameParam = false;
+  return TSDB_CODE_SUCCESS;
+}
+
+static bool multiTbStmtSchemaMatch(SMultiTbStmt* pMulti, SMeterMeta* pMeterMeta) {
+  if (pMeterMeta->numOfColumns != pMulti->numOfColumns || pMeterMeta->rowSize != pMulti->rowSize) {
+    return false;
+  }
+
+  SSchema* pSchema = tsGetSchema(pMeterMeta);
+  for (int32_t i = 0; i < pMulti->numOfColumns; ++i) {
+    if (pSchema[i].type != pMulti->pSchema[i].type || pSchema[i].bytes != pMulti->pSchema[i].bytes) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// bind the following rows to the table of full name, the data block of the table is created if not exists
+static int multiTbStmtBindTable(STscStmt* pStmt, const char* name) {
+  SMultiTbStmt* pMulti = &pStmt->multi;
+  SSqlObj*      pSql = pStmt->pSql;
+  SSqlCmd*      pCmd = &pSql->cmd;
+
+  char meterId[TSDB_METER_ID_LEN] = {0};
+  strncpy(meterId, name, TSDB_METER_ID_LEN - 1);
+  pMulti->pCurBlock = NULL;
+  pMulti->tbname[0] = 0;
+
+  SMeterMetaInfo* pMeterMetaInfo = tscGetMeterMetaInfo(pCmd, pCmd->clauseIndex, 0);
+  if (strncmp(pMeterMetaInfo->name, meterId, TSDB_METER_ID_LEN) != 0) {
+    tscClearMeterMetaInfo(pMeterMetaInfo, false);
+    strcpy(pMeterMetaInfo->name, meterId);
+  }
+
+  int code = tscGetMeterMeta(pSql, pMeterMetaInfo);
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  SMeterMeta* pMeterMeta = pMeterMetaInfo->pMeterMeta;
+  if (UTIL_METER_IS_SUPERTABLE(pMeterMetaInfo)) {
+    tscError("%p insert data into super table %s is not supported", pSql, meterId);
+    return TSDB_CODE_INVALID_TABLE;
+  }
+
+  if (!multiTbStmtSchemaMatch(pMulti, pMeterMeta)) {
+    tscError("%p schema of table %s is different from the prepared statement", pSql, meterId);
+    return TSDB_CODE_INVALID_TABLE;
+  }
+
+  if (pCmd->pDataBlocks == NULL) {
+    pCmd->pDataBlocks = tscCreateBlockArrayList();
+  }
+
+  if (pMulti->pTableHashList == NULL) {
+    pMulti->pTableHashList = taosInitHashTable(128, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BIGINT), false);
+  }
+
+  if (pCmd->pDataBlocks == NULL || pMulti->pTableHashList == NULL) {
+    return TSDB_CODE_CLI_OUT_OF_MEMORY;
+  }
+
+  STableDataBlocks* pBlock = NULL;
+  code = tscGetDataBlockFromList(pMulti->pTableHashList, pCmd->pDataBlocks, pMeterMeta->uid, TSDB_DEFAULT_PAYLOAD_SIZE,
+                                 sizeof(SShellSubmitBlock), pMulti->rowSize, meterId, pMeterMeta, &pBlock);
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  // the block is newly created
+  if (pBlock->numOfMeters == 0) {
+    SShellSubmitBlock* pSubmit = (SShellSubmitBlock*)pBlock->pData;
+    pSubmit->sid = pMeterMeta->sid;
+    pSubmit->uid = pMeterMeta->uid;
+    pSubmit->sversion = pMeterMeta->sversion;
+    pSubmit->numOfRows = 0;
+
+    pBlock->vgid = pMeterMeta->vgid;
+    pBlock->numOfMeters = 1;
+  }
+
+  pMulti->pCurBlock = pBlock;
+  strcpy(pMulti->tbname, meterId);
+  return TSDB_CODE_SUCCESS;
+}
+
+static int insertStmtSetTbname(STscStmt* pStmt, const char* name) {
+  SMultiTbStmt* pMulti = &pStmt->multi;
+  SSqlObj*      pSql = pStmt->pSql;
+
+  size_t len = (name == NULL) ? 0 : strlen(name);
+  if (len == 0 || len >= TSDB_METER_ID_LEN) {
+    tscError("%p invalid table name", pSql);
+    return TSDB_CODE_INVALID_TABLE_ID;
+  }
+
+  char tbname[TSDB_METER_ID_LEN] = {0};
+  strtolower(tbname, name);
+  if (validateTableName(tbname, (int)len) != TSDB_CODE_SUCCESS) {
+    tscError("%p invalid table name:%s", pSql, tbname);
+    return TSDB_CODE_INVALID_TABLE_ID;
+  }
+
+  int code = TSDB_CODE_SUCCESS;
+  if (pMulti->tbnameParam) {
+    code = multiTbStmtParse(pStmt, tbname);
+  } else if (!pMulti->enabled) {
+    code = multiTbStmtInit(pStmt);
+  }
+
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  SMeterMetaInfo* pMeterMetaInfo = tscGetMeterMetaInfo(&pSql->cmd, pSql->cmd.clauseIndex, 0);
+  SSQLToken       token = {.z = tbname, .n = (uint32_t)len, .type = TK_ID};
+  if ((code = setMeterID(pMeterMetaInfo, &token, pSql)) != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  return multiTbStmtBindTable(pStmt, pMeterMetaInfo->name);
+}
+
+// append numOfRows rows copied from the template row to the block of current table, they are not committed yet
+static int multiTbStmtAllocRows(STscStmt* pStmt, int32_t numOfRows, char** data) {
+  SMultiTbStmt* pMulti = &pStmt->multi;
+  int           code = TSDB_CODE_SUCCESS;
+
+  // the table blocks are released once executed, bind the current table again
+  if (pMulti->pCurBlock == NULL) {
+    if (pMulti->tbname[0] == 0) {
+      tscError("%p table name is not set", pStmt->pSql);
+      return TSDB_CODE_INVALID_TABLE_ID;
+    }
+
+    if ((code = multiTbStmtBindTable(pStmt, pMulti->tbname)) != TSDB_CODE_SUCCESS) {
+      return code;
+    }
+  }
+
+  STableDataBlocks*  pBlock = pMulti->pCurBlock;
+  SShellSubmitBlock* pSubmit = (SShellSubmitBlock*)pBlock->pData;
+
+  // numOfRows of a submit block is a short
+  if (pSubmit->numOfRows + numOfRows > INT16_MAX) {
+    tscError("%p too many rows for table %s in one batch, rows:%d", pStmt->pSql, pBlock->meterId,
+             pSubmit->numOfRows + numOfRows);
+    return TSDB_CODE_INVALID_VALUE;
+  }
+
+  uint32_t size = pBlock->size + (uint32_t)numOfRows * pMulti->rowSize;
+  if (size > pBlock->nAllocSize) {
+    const double factor = 1.5;
+    char*        tmp = realloc(pBlock->pData, (uint32_t)(size * factor));
+    if (tmp == NULL) {
+      return TSDB_CODE_CLI_OUT_OF_MEMORY;
+    }
+
+    pBlock->pData = tmp;
+    pBlock->nAllocSize = (uint32_t)(size * factor);
+  }
+
+  *data = pBlock->pData + pBlock->size;
+  for (int32_t i = 0; i < numOfRows; ++i) {
+    memcpy(*data + pMulti->rowSize * i, pMulti->pRow, (size_t)pMulti->rowSize);
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+static void multiTbStmtCommitRows(STscStmt* pStmt, int32_t numOfRows) {
+  SMultiTbStmt*     pMulti = &pStmt->multi;
+  STableDataBlocks* pBlock = pMulti->pCurBlock;
+
+  char* data = pBlock->pData + pBlock->size;
+  for (int32_t i = 0; i < numOfRows && pBlock->ordered; ++i) {
+    TSKEY k = *(TSKEY*)(data + pMulti->rowSize * i);
+    if (k <= pBlock->prevTS) {
+      pBlock->ordered = false;
+    }
+
+    pBlock->prevTS = k;
+  }
+
+  pBlock->size += (uint32_t)numOfRows * pMulti->rowSize;
+
+  SShellSubmitBlock* pSubmit = (SShellSubmitBlock*)pBlock->pData;
+  pSubmit->numOfRows += numOfRows;
+}
+
+static int multiTbStmtBindParam(STscStmt* pStmt, TAOS_BIND* bind) {
+  SMultiTbStmt* pMulti = &pStmt->multi;
+
+  char* data = NULL;
+  int   code = multiTbStmtAllocRows(pStmt, 1, &data);
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  for (uint32_t j = 0; j < pMulti->numOfParams; ++j) {
+    SParamInfo* param = pMulti->params + j;
+    if ((code = doBindParam(data, param, bind + param->idx)) != TSDB_CODE_SUCCESS) {
+      tscTrace("param %d: type mismatch or invalid", param->idx);
+      return code;
+    }
+  }
+
+  multiTbStmtCommitRows(pStmt, 1);
+  return TSDB_CODE_SUCCESS;
+}
+
+// bind the values of one parameter to numOfRows rows, which are rowSize bytes apart
+static int doBindBatchParam(char* data, int32_t rowSize, SParamInfo* param, TAOS_MULTI_BIND* bind, int32_t numOfRows) {
+  if (bind->buffer_type != param->type) {
+    return TSDB_CODE_INVALID_VALUE;
+  }
+
+  bool      isVarType = (param->type == TSDB_DATA_TYPE_BINARY || param->type == TSDB_DATA_TYPE_NCHAR);
+  uintptr_t step = bind->buffer_length;
+  if (isVarType && (step == 0 || bind->length == NULL)) {
+    return TSDB_CODE_INVALID_VALUE;
+  } else if (!isVarType && step == 0) {
+    step = (uintptr_t)param->bytes;
+  }
+
+  for (int32_t i = 0; i < numOfRows; ++i) {
+    char* dst = data + rowSize * i + param->offset;
+    if (bind->is_null != NULL && bind->is_null[i]) {
+      setNull(dst, param->type, param->bytes);
+      continue;
+    }
+
+    char* src = (char*)bind->buffer + step * i;
+    switch (param->type) {
+      case TSDB_DATA_TYPE_BINARY:
+        if (bind->length[i] < 0 || bind->length[i] > param->bytes) {
+          return TSDB_CODE_INVALID_VALUE;
+        }
+
+        memcpy(dst, src, (size_t)bind->length[i]);
+        memset(dst + bind->length[i], 0, (size_t)(param->bytes - bind->length[i]));
+        break;
+
+      case TSDB_DATA_TYPE_NCHAR:
+        if (bind->length[i] < 0 || !taosMbsToUcs4(src, bind->length[i], dst, param->bytes)) {
+          return TSDB_CODE_INVALID_VALUE;
+        }
+        break;
+
+      default:
+        memcpy(dst, src, (size_t)param->bytes);
+        break;
+    }
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+static int insertStmtBindParamBatch(STscStmt* pStmt, TAOS_MULTI_BIND* bind) {
+  SMultiTbStmt* pMulti = &pStmt->multi;
+  int           code = TSDB_CODE_SUCCESS;
+
+  if (!pMulti->enabled) {
+    if (pMulti->tbnameParam) {
+      tscError("%p table name is not set", pStmt->pSql);
+      return TSDB_CODE_INVALID_TABLE_ID;
+    }
+
+    if ((code = multiTbStmtInit(pStmt)) != TSDB_CODE_SUCCESS) {
+      return code;
+    }
+  }
+
+  if (pMulti->numOfParams == 0) {
+    return TSDB_CODE_INVALID_VALUE;
+  }
+
+  // all parameters shall have the same number of rows
+  int32_t numOfRows = bind[pMulti->params[0].idx].num;
+  for (uint32_t j = 0; j < pMulti->numOfParams; ++j) {
+    if (numOfRows <= 0 || bind[pMulti->params[j].idx].num != numOfRows) {
+      tscError("%p number of rows of param %d is invalid", pStmt->pSql, pMulti->params[j].idx);
+      return TSDB_CODE_INVALID_VALUE;
+    }
+  }
+
+  char* data = NULL;
+  if ((code = multiTbStmtAllocRows(pStmt, numOfRows, &data)) != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  // nothing is committed if any value is invalid
+  for (uint32_t j = 0; j < pMulti->numOfParams; ++j) {
+    SParamInfo* param = pMulti->params + j;
+    code = doBindBatchParam(data, pMulti->rowSize, param, bind + param->idx, numOfRows);
+    if (code != TSDB_CODE_SUCCESS) {
+      tscTrace("param %d: type mismatch or invalid", param->idx);
+      return code;
+    }
+  }
+
+  multiTbStmtCommitRows(pStmt, numOfRows);
+  return TSDB_CODE_SUCCESS;
+}
+
+// remove the tables that no row is bound to, returns the number of tables left
+static int32_t multiTbStmtRemoveEmptyBlocks(STscStmt* pStmt) {
+  SDataBlockList* pList = pStmt->pSql->cmd.pDataBlocks;
+  if (pList == NULL) {
+    return 0;
+  }
+
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < pList->nSize; ++i) {
+    STableDataBlocks* pBlock = pList->pData[i];
+    if (((SShellSubmitBlock*)pBlock->pData)->numOfRows == 0) {
+      taosDeleteFromHashTable(pStmt->multi.pTableHashList, (const char*)&((SShellSubmitBlock*)pBlock->pData)->uid,
+                              sizeof(int64_t));
+      if (pStmt->multi.pCurBlock == pBlock) {
+        pStmt->multi.pCurBlock = NULL;
+      }
+
+      tscDestroyDataBlock(pBlock);
+    } else {
+      pList->pData[n++] = pBlock;
+    }
+  }
+
+  pList->nSize = n;
+  return (int32_t)n;
+}
+
 static int insertStmtReset(STscStmt* pStmt) {
   SSqlCmd* pCmd = &pStmt->pSql->cmd;
   if (pCmd->batchSize > 2) {
@@ -407,6 +890,10 @@ static int insertStmtReset(STscStmt* pStmt) {
     }
   }
   pCmd->batchSize = 0;
+
+  if (pStmt->multi.enabled) {
+    multiTbStmtClearBlocks(pStmt);
+  }
   
   SMeterMetaInfo* pMeterMetaInfo = tscGetMeterMetaInfo(pCmd, pCmd->clauseIndex, 0);
   pMeterMetaInfo->vnodeIndex = 0;
@@ -415,7 +902,11 @@ static int insertStmtReset(STscStmt* pStmt) {
 
 static int insertStmtExecute(STscStmt* stmt) {
   SSqlCmd* pCmd = &stmt->pSql->cmd;
-  if (pCmd->batchSize == 0) {
+  if (stmt->multi.enabled) {
+    if (multiTbStmtRemoveEmptyBlocks(stmt) == 0) {
+      return TSDB_CODE_INVALID_VALUE;
+    }
+  } else if (pCmd->batchSize == 0) {
     return TSDB_CODE_INVALID_VALUE;
   }
   if ((pCmd->batchSize % 2) == 1) {
@@ -428,13 +919,14 @@ static int insertStmtExecute(STscStmt* stmt) {
   if (pCmd->pDataBlocks->nSize > 0) {
     // merge according to vgid
     int code = tscMergeTableDataBlocks(stmt->pSql, pCmd->pDataBlocks);
-    if (code != TSDB_CODE_SUCCESS) {
-      return code;
+    if (code == TSDB_CODE_SUCCESS) {
+      code = tscCopyDataBlockToPayload(stmt->pSql, pCmd->pDataBlocks->pData[0]);
     }
 
-    STableDataBlocks *pDataBlock = pCmd->pDataBlocks->pData[0];
-    code = tscCopyDataBlockToPayload(stmt->pSql, pDataBlock);
     if (code != TSDB_CODE_SUCCESS) {
+      if (stmt->multi.enabled) {
+        multiTbStmtClearBlocks(stmt);
+      }
       return code;
     }
 
@@ -455,6 +947,12 @@ static int insertStmtExecute(STscStmt* stmt) {
 
   tscDoQuery(pSql);
 
+  // the table blocks are merged and sent, rows of the next batch are bound to new blocks
+  if (stmt->multi.enabled) {
+    multiTbStmtClearBlocks(stmt);
+    return pRes->code;
+  }
+
   // tscTrace("%p SQL result:%d, %s pObj:%p", pSql, pRes->code, taos_errstr(taos), pObj);
   if (pRes->code != TSDB_CODE_SUCCESS) {
     tscFreeSqlObjPartial(pSql);
@@ -534,6 +1032,8 @@ int taos_stmt_close(TAOS_STMT* stmt) {
     }
     free(normal->parts);
     free(normal->sql);
+  } else {
+    multiTbStmtDestroy(pStmt);
   }
 
   tscFreeSqlObj(pStmt->pSql);
@@ -541,14 +1041,36 @@ int taos_stmt_close(TAOS_STMT* stmt) {
   return TSDB_CODE_SUCCESS;
 }
 
+int taos_stmt_set_tbname(TAOS_STMT* stmt, const char* name) {
+  STscStmt* pStmt = (STscStmt*)stmt;
+  if (pStmt->isInsert) {
+    return insertStmtSetTbname(pStmt, name);
+  }
+  return TSDB_CODE_OPS_NOT_SUPPORT;
+}
+
 int taos_stmt_bind_param(TAOS_STMT* stmt, TAOS_BIND* bind) {
   STscStmt* pStmt = (STscStmt*)stmt;
   if (pStmt->isInsert) {
+    if (pStmt->multi.enabled) {
+      return multiTbStmtBindParam(pStmt, bind);
+    } else if (pStmt->multi.tbnameParam) {
+      tscError("%p table name is not set", pStmt->pSql);
+      return TSDB_CODE_INVALID_TABLE_ID;
+    }
     return insertStmtBindParam(pStmt, bind);
   }
   return normalStmtBindParam(pStmt, bind);
 }
 
+int taos_stmt_bind_param_batch(TAOS_STMT* stmt, TAOS_MULTI_BIND* bind) {
+  STscStmt* pStmt = (STscStmt*)stmt;
+  if (pStmt->isInsert) {
+    return insertStmtBindParamBatch(pStmt, bind);
+  }
+  return TSDB_CODE_OPS_NOT_SUPPORT;
+}
+
 int taos_stmt_add_batch(TAOS_STMT* stmt) {
   STscStmt* pStmt = (STscStmt*)stmt;
   if (pStmt->isInsert) {
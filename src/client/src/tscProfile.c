@@ -235,6 +235,7 @@ char *tscBuildQueryStreamDesc(char *pMsg, STscObj *pObj) {
     pQdesc->stime = pSql->stime;
     pQdesc->queryId = pSql->queryId;
     pQdesc->useconds = pSql->res.useconds;
+    pQdesc->memUsage = pSql->res.memUsage;
 
     pQList->numOfQueries++;
     pQdesc++;
@@ -468,7 +468,7 @@ int32_t tscToSQLCmd(SSqlObj* pSql, struct SSqlInfo* pInfo) {
         strncpy(&pCmd->payload[pDCL->a[0].n + 1], pDCL->a[1].z, pDCL->a[1].n);
       }
 
-      break;
+      return TSDB_CODE_SUCCESS;  // no message is built for local options
     }
 
     case TSDB_SQL_CREATE_TABLE: {
@@ -4523,6 +4523,13 @@ int32_t validateLocalConfig(tDCLSQL* pOptions) {
 
   SSQLToken* pOptionToken = &pOptions->a[0];
 
+  // the threads to merge results of vnodes are set for the connection, not the debug flags
+  if (pOptions->nTokens == 2 && pOptionToken->n == LOCAL_MERGE_THREADS_OPTION_LEN &&
+      strncasecmp(pOptionToken->z, LOCAL_MERGE_THREADS_OPTION, pOptionToken->n) == 0) {
+    int32_t val = strtol(pOptions->a[1].z, NULL, 10);
+    return (val >= 1 && val <= 64) ? TSDB_CODE_SUCCESS : TSDB_CODE_INVALID_SQL;
+  }
+
   if (pOptions->nTokens == 1) {
     // reset log does not need value
     for (int32_t i = 0; i < 1; ++i) {
@@ -5261,8 +5268,8 @@ int32_t doLocalQueryProcess(SQueryInfo* pQueryInfo, SQuerySQL* pQuerySql) {
 int32_t tscCheckCreateDbParams(SSqlCmd* pCmd, SCreateDbMsg* pCreate) {
   char msg[512] = {0};
 
-  if (pCreate->commitLog != -1 && (pCreate->commitLog < 0 || pCreate->commitLog > 1)) {
-    snprintf(msg, tListLen(msg), "invalid db option commitLog: %d, only 0 or 1 allowed", pCreate->commitLog);
+  if (pCreate->commitLog != -1 && (pCreate->commitLog < 0 || pCreate->commitLog > TSDB_COMMIT_LOG_SYNC)) {
+    snprintf(msg, tListLen(msg), "invalid db option commitLog: %d, only 0, 1 or 2 allowed", pCreate->commitLog);
     return invalidSqlErrMsg(tscGetErrorMsgPayload(pCmd), msg);
   }
 
@@ -17,6 +17,7 @@
 #include "os.h"
 #include "tlosertree.h"
 #include "tscUtil.h"
+#include "tsched.h"
 #include "tschemautil.h"
 #include "tsclient.h"
 #include "tutil.h"
@@ -46,14 +47,386 @@ int32_t treeComparator(const void *pLeft, const void *pRight, void *param) {
   }
 
   if (pParam->groupOrderType == TSQL_SO_DESC) {  // desc
-    return compare_d(pDesc, pParam->numOfElems, pLocalData[pLeftIdx]->rowIdx, pLocalData[pLeftIdx]->filePage.data,
-                     pParam->numOfElems, pLocalData[pRightIdx]->rowIdx, pLocalData[pRightIdx]->filePage.data);
+    return compare_d(pDesc, pParam->numOfElems, pLocalData[pLeftIdx]->rowIdx, pLocalData[pLeftIdx]->pPage->data,
+                     pParam->numOfElems, pLocalData[pRightIdx]->rowIdx, pLocalData[pRightIdx]->pPage->data);
   } else {
-    return compare_a(pDesc, pParam->numOfElems, pLocalData[pLeftIdx]->rowIdx, pLocalData[pLeftIdx]->filePage.data,
-                     pParam->numOfElems, pLocalData[pRightIdx]->rowIdx, pLocalData[pRightIdx]->filePage.data);
+    return compare_a(pDesc, pParam->numOfElems, pLocalData[pLeftIdx]->rowIdx, pLocalData[pLeftIdx]->pPage->data,
+                     pParam->numOfElems, pLocalData[pRightIdx]->rowIdx, pLocalData[pRightIdx]->pPage->data);
   }
 }
 
+/*
+ * Parallel merge: the sources are partitioned by vnode, and each part is merged by a stream with a loser tree of its
+ * own into a ring of pages, in the layout of the pages of the sources. The loser tree of the reducer then merges the
+ * outputs of the streams, so the rows arrive in the same order as merging all sources in the application thread.
+ * Sources of a vnode share the file of its buffer and are always merged by the same stream.
+ *
+ * Streams of all queries are run by one pool of workers, a task fills the free pages of the ring and returns. The
+ * consumer reads the merged pages in place, and schedules the stream again once it releases a page. A consumer whose
+ * stream has no page yet and is not running fills a page itself, so queries are not held up by a busy pool.
+ */
+#define LOCAL_MERGE_STREAM_PAGES 4
+#define LOCAL_MERGE_POOL_QUEUE_SIZE 1024
+
+typedef struct SLocalMergeStream {
+  pthread_mutex_t    mutex;
+  pthread_cond_t     cond;
+  SLocalDataSource **pDataSrc;
+  int32_t            numOfSrc;
+  int32_t            numOfCompleted;
+  SLoserTreeInfo *   pTree;
+  tOrderDescriptor * pDesc;  // a copy, since the order columns of the reducer are changed in isSameGroup
+  SColumnModel *     pModel;
+  int32_t            pageSize;
+  tFilePage *        pages[LOCAL_MERGE_STREAM_PAGES];
+  int32_t            head;        // the page read by the consumer
+  int32_t            numOfPages;  // merged pages not released by the consumer yet
+  bool               scheduled;   // a task of the stream is in the queue of the pool
+  bool               running;     // pages are being filled, by a worker or the consumer
+  bool               completed;
+  bool               stop;
+} SLocalMergeStream;
+
+static void *         tscMergeQhandle = NULL;
+static pthread_once_t tscMergePoolInit = PTHREAD_ONCE_INIT;
+
+static bool loadNextPageOfSource(SLocalDataSource *pDataSrc);
+
+// a worker per core, streams of queries asking for more threads share them
+static void tscInitMergePool(void) {
+  tscMergeQhandle = taosInitScheduler(LOCAL_MERGE_POOL_QUEUE_SIZE, MAX(tsNumOfCores, 1), "merge");
+  if (tscMergeQhandle == NULL) {
+    tscError("failed to start the pool to merge results of vnodes, merged in the application threads");
+  }
+}
+
+// merge the rows of the sources into a page until it is full or all sources are exhausted
+static void localMergeStreamFill(SLocalMergeStream *pStream, tFilePage *pPage) {
+  SLoserTreeInfo *pTree = pStream->pTree;
+  int32_t         capacity = pStream->pModel->capacity;
+
+  pPage->numOfElems = 0;
+  while (pStream->numOfCompleted < pStream->numOfSrc && pPage->numOfElems < capacity) {
+    SLocalDataSource *pDataSrc = pStream->pDataSrc[pTree->pNode[0].index];
+    tColModelAppend(pStream->pModel, pPage, pDataSrc->pPage->data, pDataSrc->rowIdx, 1, capacity);
+
+    pDataSrc->rowIdx += 1;
+    if (pDataSrc->pPage->numOfElems <= pDataSrc->rowIdx && !loadNextPageOfSource(pDataSrc)) {
+      pDataSrc->rowIdx = -1;
+      pStream->numOfCompleted += 1;
+    }
+
+    tLoserTreeAdjust(pTree, pTree->pNode[0].index + pStream->numOfSrc);
+  }
+}
+
+/*
+ * fill at most maxPages free pages of the ring, called with the mutex locked by the one that set running
+ */
+static void localMergeStreamRun(SLocalMergeStream *pStream, int32_t maxPages) {
+  for (int32_t i = 0; i < maxPages; ++i) {
+    if (pStream->stop || pStream->completed || pStream->numOfPages == LOCAL_MERGE_STREAM_PAGES) {
+      break;
+    }
+
+    // the pages from head on are not touched until the consumer releases them
+    tFilePage *pPage = pStream->pages[(pStream->head + pStream->numOfPages) % LOCAL_MERGE_STREAM_PAGES];
+    pthread_mutex_unlock(&pStream->mutex);
+
+    localMergeStreamFill(pStream, pPage);
+
+    pthread_mutex_lock(&pStream->mutex);
+    if (pPage->numOfElems > 0) {
+      pStream->numOfPages += 1;
+    }
+
+    pStream->completed = (pStream->numOfCompleted == pStream->numOfSrc);
+    pthread_cond_broadcast(&pStream->cond);
+  }
+
+  pStream->running = false;
+  pthread_cond_broadcast(&pStream->cond);
+}
+
+static void localMergeStreamTask(SSchedMsg *pMsg) {
+  SLocalMergeStream *pStream = (SLocalMergeStream *)pMsg->ahandle;
+
+  pthread_mutex_lock(&pStream->mutex);
+  pStream->scheduled = false;
+
+  // the consumer may have taken over the stream while the task was queued
+  if (pStream->running) {
+    pthread_cond_broadcast(&pStream->cond);
+  } else {
+    pStream->running = true;
+    localMergeStreamRun(pStream, LOCAL_MERGE_STREAM_PAGES);
+  }
+
+  pthread_mutex_unlock(&pStream->mutex);
+}
+
+/*
+ * mark the stream scheduled if it has free pages and is idle, called with the mutex locked
+ * @return true if a task shall be put into the pool once the mutex is unlocked
+ */
+static bool localMergeStreamNeedSchedule(SLocalMergeStream *pStream) {
+  if (tscMergeQhandle == NULL || pStream->scheduled || pStream->running || pStream->completed || pStream->stop ||
+      pStream->numOfPages == LOCAL_MERGE_STREAM_PAGES) {
+    return false;
+  }
+
+  pStream->scheduled = true;
+  return true;
+}
+
+static void localMergeStreamSchedule(SLocalMergeStream *pStream) {
+  SSchedMsg schedMsg = {0};
+  schedMsg.fp = localMergeStreamTask;
+  schedMsg.ahandle = pStream;
+
+  taosScheduleTask(tscMergeQhandle, &schedMsg);
+}
+
+/*
+ * release the page read by the consumer, and make the next merged page the one to read
+ * @return false if all pages have been read
+ */
+static bool localMergeStreamNext(SLocalMergeStream *pStream, tFilePage **pPage) {
+  pthread_mutex_lock(&pStream->mutex);
+  if (*pPage != NULL) {
+    pStream->head = (pStream->head + 1) % LOCAL_MERGE_STREAM_PAGES;
+    pStream->numOfPages -= 1;
+    *pPage = NULL;
+  }
+
+  while (pStream->numOfPages == 0 && !pStream->completed) {
+    if (pStream->running) {
+      pthread_cond_wait(&pStream->cond, &pStream->mutex);
+    } else {
+      pStream->running = true;
+      localMergeStreamRun(pStream, 1);
+    }
+  }
+
+  bool loaded = (pStream->numOfPages > 0);
+  if (loaded) {
+    *pPage = pStream->pages[pStream->head];
+  }
+
+  bool schedule = localMergeStreamNeedSchedule(pStream);
+  pthread_mutex_unlock(&pStream->mutex);
+
+  if (schedule) {
+    localMergeStreamSchedule(pStream);
+  }
+
+  return loaded;
+}
+
+/*
+ * load the next page of a source, from its buffer or the stream merging it
+ * @return false if the source is exhausted
+ */
+static bool loadNextPageOfSource(SLocalDataSource *pDataSrc) {
+  pDataSrc->rowIdx = 0;
+
+  if (pDataSrc->pStream != NULL) {
+    return localMergeStreamNext(pDataSrc->pStream, &pDataSrc->pPage);
+  }
+
+  pDataSrc->pageId += 1;
+  if (pDataSrc->pageId >= pDataSrc->pMemBuffer->fileMeta.flushoutData.pFlushoutInfo[pDataSrc->flushoutIdx].numOfPages) {
+    return false;
+  }
+
+  tExtMemBufferLoadData(pDataSrc->pMemBuffer, &(pDataSrc->filePage), pDataSrc->flushoutIdx, pDataSrc->pageId);
+  return true;
+}
+
+static void destroyLocalMergeStream(SLocalMergeStream *pStream, bool freeDataSrc) {
+  if (freeDataSrc) {
+    for (int32_t i = 0; i < pStream->numOfSrc; ++i) {
+      tfree(pStream->pDataSrc[i]);
+    }
+  }
+
+  if (pStream->pTree != NULL) {
+    tfree(pStream->pTree->param);
+    tfree(pStream->pTree);
+  }
+
+  for (int32_t i = 0; i < LOCAL_MERGE_STREAM_PAGES; ++i) {
+    tfree(pStream->pages[i]);
+  }
+
+  tfree(pStream->pDataSrc);
+  tfree(pStream->pDesc);
+  pthread_cond_destroy(&pStream->cond);
+  pthread_mutex_destroy(&pStream->mutex);
+  free(pStream);
+}
+
+// a queued task of a stream still refers to it, the stream is freed after the task has returned
+static void tscDestroyLocalMergeStreams(SLocalReducer *pReducer) {
+  for (int32_t i = 0; i < pReducer->numOfStream; ++i) {
+    SLocalMergeStream *pStream = pReducer->pStream[i];
+
+    pthread_mutex_lock(&pStream->mutex);
+    pStream->stop = true;
+    while (pStream->scheduled || pStream->running) {
+      pthread_cond_wait(&pStream->cond, &pStream->mutex);
+    }
+    pthread_mutex_unlock(&pStream->mutex);
+
+    destroyLocalMergeStream(pStream, true);
+  }
+
+  tfree(pReducer->pStream);
+  pReducer->numOfStream = 0;
+}
+
+static SLocalMergeStream *createLocalMergeStream(SLocalDataSource **pDataSrc, int32_t numOfSrc, tOrderDescriptor *pDesc,
+                                                 int32_t groupOrderType) {
+  SLocalMergeStream *pStream = calloc(1, sizeof(SLocalMergeStream));
+  if (pStream == NULL) {
+    return NULL;
+  }
+
+  pthread_mutex_init(&pStream->mutex, NULL);
+  pthread_cond_init(&pStream->cond, NULL);
+
+  tExtMemBuffer *pMemBuffer = pDataSrc[0]->pMemBuffer;
+  pStream->numOfSrc = numOfSrc;
+  pStream->pModel = pMemBuffer->pColumnModel;
+  pStream->pageSize = pMemBuffer->pageSize;
+
+  size_t descSize = sizeof(tOrderDescriptor) + sizeof(int32_t) * pDesc->orderIdx.numOfCols;
+  pStream->pDesc = malloc(descSize);
+  pStream->pDataSrc = malloc(POINTER_BYTES * numOfSrc);
+
+  SCompareParam *param = malloc(sizeof(SCompareParam));
+  if (pStream->pDesc == NULL || pStream->pDataSrc == NULL || param == NULL) {
+    tfree(param);
+    destroyLocalMergeStream(pStream, false);
+    return NULL;
+  }
+
+  memcpy(pStream->pDesc, pDesc, descSize);
+  pStream->pDesc->pColumnModel = pMemBuffer->pColumnModel;
+  memcpy(pStream->pDataSrc, pDataSrc, POINTER_BYTES * numOfSrc);
+
+  for (int32_t i = 0; i < LOCAL_MERGE_STREAM_PAGES; ++i) {
+    if ((pStream->pages[i] = calloc(1, (size_t)pStream->pageSize)) == NULL) {
+      tfree(param);
+      destroyLocalMergeStream(pStream, false);
+      return NULL;
+    }
+  }
+
+  param->pLocalData = pStream->pDataSrc;
+  param->pDesc = pStream->pDesc;
+  param->numOfElems = pMemBuffer->numOfElemsPerPage;
+  param->groupOrderType = groupOrderType;
+
+  if (tLoserTreeCreate(&pStream->pTree, numOfSrc, param, treeComparator) != TSDB_CODE_SUCCESS) {
+    tfree(param);
+    destroyLocalMergeStream(pStream, false);
+    return NULL;
+  }
+
+  return pStream;
+}
+
+/*
+ * The sources of the reducer are replaced by the outputs of the streams. The sources of a part whose stream can not
+ * be created are merged by the reducer itself.
+ */
+static void tscCreateLocalMergeStreams(SLocalReducer *pReducer, int32_t numOfThreads, int32_t groupOrderType,
+                                       void *pSqlObjAddr) {
+  int32_t            numOfBuffer = pReducer->numOfBuffer;
+  SLocalDataSource **pDataSrc = pReducer->pLocalDataSrc;
+
+  // the sources of a vnode are adjacent
+  int32_t numOfVnodes = 1;
+  for (int32_t i = 1; i < numOfBuffer; ++i) {
+    numOfVnodes += (pDataSrc[i]->pMemBuffer != pDataSrc[i - 1]->pMemBuffer) ? 1 : 0;
+  }
+
+  int32_t numOfStream = MIN(numOfThreads, MAX(numOfVnodes / 2, 1));
+  if (numOfThreads <= 1 || numOfBuffer < 2) {
+    return;
+  }
+
+  pthread_once(&tscMergePoolInit, tscInitMergePool);
+
+  SLocalDataSource **pList = malloc(POINTER_BYTES * numOfBuffer);
+  pReducer->pStream = calloc((size_t)numOfStream, POINTER_BYTES);
+  if (pList == NULL || pReducer->pStream == NULL) {
+    tfree(pList);
+    tfree(pReducer->pStream);
+    return;
+  }
+
+  int32_t numOfList = 0;
+  int32_t start = 0;
+  int32_t vnodeIdx = 0;
+  bool    failed = false;
+
+  for (int32_t s = 0; s < numOfStream; ++s) {
+    // each stream merges the sources of a range of vnodes
+    int32_t lastVnode = (int32_t)(((int64_t)numOfVnodes * (s + 1)) / numOfStream);
+    int32_t end = start;
+    while (end < numOfBuffer) {
+      if (end > start && pDataSrc[end]->pMemBuffer != pDataSrc[end - 1]->pMemBuffer) {
+        if (++vnodeIdx >= lastVnode) break;
+      }
+      end++;
+    }
+
+    SLocalMergeStream *pStream = NULL;
+    SLocalDataSource * pStreamSrc = NULL;
+    if (!failed) {
+      pStream = createLocalMergeStream(&pDataSrc[start], end - start, pReducer->pDesc, groupOrderType);
+      pStreamSrc = (pStream != NULL) ? malloc(sizeof(SLocalDataSource)) : NULL;
+    }
+
+    if (pStreamSrc == NULL) {
+      tscError("%p failed to create the merge of sources %d-%d, merged in the application thread", pSqlObjAddr, start,
+               end - 1);
+      if (pStream != NULL) destroyLocalMergeStream(pStream, false);
+      tfree(pStreamSrc);
+
+      failed = true;
+      for (int32_t i = start; i < end; ++i) {
+        pList[numOfList++] = pDataSrc[i];
+      }
+    } else {
+      pReducer->pStream[pReducer->numOfStream++] = pStream;
+
+      pStreamSrc->pMemBuffer = pStream->pDataSrc[0]->pMemBuffer;
+      pStreamSrc->pStream = pStream;
+      pStreamSrc->flushoutIdx = 0;
+      pStreamSrc->pageId = 0;
+      pStreamSrc->pPage = NULL;  // pages of the stream are read in place
+      pStreamSrc->filePage.numOfElems = 0;
+      pList[numOfList++] = pStreamSrc;
+
+      // the stream merges one row at least
+      bool loaded = loadNextPageOfSource(pStreamSrc);
+      assert(loaded);
+    }
+
+    start = end;
+  }
+
+  memcpy(pDataSrc, pList, POINTER_BYTES * numOfList);
+  pReducer->numOfBuffer = numOfList;
+  free(pList);
+
+  tscTrace("%p %d sources of %d vnodes are merged by %d streams, %d leaves remain", pSqlObjAddr, numOfBuffer,
+           numOfVnodes, pReducer->numOfStream, numOfList);
+}
+
 static void tscInitSqlContext(SSqlCmd *pCmd, SSqlRes *pRes, SLocalReducer *pReducer, tOrderDescriptor *pDesc) {
   /*
    * the fields and offset attributes in pCmd and pModel may be different due to
@@ -206,6 +579,8 @@ void tscCreateLocalReducer(tExtMemBuffer **pMemBuffer, int32_t numOfBuffer, tOrd
       pReducer->pLocalDataSrc[idx] = pDS;
 
       pDS->pMemBuffer = pMemBuffer[i];
+      pDS->pStream = NULL;
+      pDS->pPage = &pDS->filePage;
       pDS->flushoutIdx = j;
       pDS->filePage.numOfElems = 0;
       pDS->pageId = 0;
@@ -239,16 +614,21 @@ void tscCreateLocalReducer(tExtMemBuffer **pMemBuffer, int32_t numOfBuffer, tOrd
 
   pReducer->numOfBuffer = idx; // the actual entries that has result for merge
 
+  SQueryInfo *pQueryInfo = tscGetQueryInfoDetail(pCmd, pCmd->clauseIndex);
+  STscObj *   pObj = ((SSqlObj *)pSqlObjAddr)->pTscObj;
+  if (pObj != NULL && pObj->localMergeThreads > 1) {
+    tscCreateLocalMergeStreams(pReducer, pObj->localMergeThreads, pQueryInfo->groupbyExpr.orderType, pSqlObjAddr);
+  }
+
   SCompareParam *param = malloc(sizeof(SCompareParam));
   param->pLocalData = pReducer->pLocalDataSrc;
   param->pDesc = pReducer->pDesc;
   param->numOfElems = pReducer->pLocalDataSrc[0]->pMemBuffer->numOfElemsPerPage;
-  SQueryInfo *pQueryInfo = tscGetQueryInfoDetail(pCmd, pCmd->clauseIndex);
-
   param->groupOrderType = pQueryInfo->groupbyExpr.orderType;
 
   pRes->code = tLoserTreeCreate(&pReducer->pLoserTree, pReducer->numOfBuffer, param, treeComparator);
   if (pReducer->pLoserTree == NULL || pRes->code != 0) {
+    tscDestroyLocalMergeStreams(pReducer);
     return;
   }
 
@@ -296,6 +676,7 @@ void tscCreateLocalReducer(tExtMemBuffer **pMemBuffer, int32_t numOfBuffer, tOrd
     tfree(pReducer->pFinalRes);
     tfree(pReducer->pBufForInterpo);
     tfree(pReducer->prevRowOfInput);
+    tscDestroyLocalMergeStreams(pReducer);
 
     pRes->code = TSDB_CODE_CLI_OUT_OF_MEMORY;
     return;
@@ -497,6 +878,9 @@ void tscDestroyLocalReducer(SSqlObj *pSql) {
     tfree(pLocalReducer->pFinalRes);
     tfree(pLocalReducer->discardData);
 
+    // the workers read the buffers of vnodes
+    tscDestroyLocalMergeStreams(pLocalReducer);
+
     tscLocalReducerEnvDestroy(pLocalReducer->pExtMemBuffer, pLocalReducer->pDesc, pLocalReducer->resColModel,
                               pLocalReducer->numOfVnode);
     for (int32_t i = 0; i < pLocalReducer->numOfBuffer; ++i) {
@@ -735,18 +1119,11 @@ void tscLocalReducerEnvDestroy(tExtMemBuffer **pMemBuffer, tOrderDescriptor *pDe
  */
 int32_t loadNewDataFromDiskFor(SLocalReducer *pLocalReducer, SLocalDataSource *pOneInterDataSrc,
                                bool *needAdjustLoserTree) {
-  pOneInterDataSrc->rowIdx = 0;
-  pOneInterDataSrc->pageId += 1;
-
-  if (pOneInterDataSrc->pageId <
-      pOneInterDataSrc->pMemBuffer->fileMeta.flushoutData.pFlushoutInfo[pOneInterDataSrc->flushoutIdx].numOfPages) {
-    tExtMemBufferLoadData(pOneInterDataSrc->pMemBuffer, &(pOneInterDataSrc->filePage), pOneInterDataSrc->flushoutIdx,
-                          pOneInterDataSrc->pageId);
-
+  if (loadNextPageOfSource(pOneInterDataSrc)) {
 #if defined(_DEBUG_VIEW)
     printf("new page load to buffer\n");
-    tColModelDisplay(pOneInterDataSrc->pMemBuffer->pColumnModel, pOneInterDataSrc->filePage.data,
-                     pOneInterDataSrc->filePage.numOfElems, pOneInterDataSrc->pMemBuffer->pColumnModel->capacity);
+    tColModelDisplay(pOneInterDataSrc->pMemBuffer->pColumnModel, pOneInterDataSrc->pPage->data,
+                     pOneInterDataSrc->pPage->numOfElems, pOneInterDataSrc->pMemBuffer->pColumnModel->capacity);
 #endif
     *needAdjustLoserTree = true;
   } else {
@@ -767,7 +1144,7 @@ void adjustLoserTreeFromNewData(SLocalReducer *pLocalReducer, SLocalDataSource *
    * since it's last record in buffer has been chosen to be processed, as the winner of loser-tree
    */
   bool needToAdjust = true;
-  if (pOneInterDataSrc->filePage.numOfElems <= pOneInterDataSrc->rowIdx) {
+  if (pOneInterDataSrc->pPage->numOfElems <= pOneInterDataSrc->rowIdx) {
     loadNewDataFromDiskFor(pLocalReducer, pOneInterDataSrc, &needToAdjust);
   }
 
@@ -1467,7 +1844,7 @@ int32_t tscDoLocalreduce(SSqlObj *pSql) {
     // chosen from loser tree
     SLocalDataSource *pOneDataSrc = pLocalReducer->pLocalDataSrc[pTree->pNode[0].index];
 
-    tColModelAppend(pModel, tmpBuffer, pOneDataSrc->filePage.data, pOneDataSrc->rowIdx, 1,
+    tColModelAppend(pModel, tmpBuffer, pOneDataSrc->pPage->data, pOneDataSrc->rowIdx, 1,
                     pOneDataSrc->pMemBuffer->pColumnModel->capacity);
 
 #if defined(_DEBUG_VIEW)
@@ -266,6 +266,12 @@ void tscGetConnToVnode(SSqlObj *pSql, uint8_t *pCode) {
     pSql->index = pSql->index%TSDB_VNODES_SUPPORT;
     
     char ipstr[40] = {0};
+    // a slot with ip 0 after the first one is not a replica, its vnode 0 may hold another table, e.g., when a
+    // restarted server does not respond on the old connection, so the first peer is retried
+    if (pSql->index > 0 && pVPeersDesc[pSql->index].ip == 0) {
+      pSql->index = 0;
+    }
+
     if (pVPeersDesc[pSql->index].ip == 0) {
       /*
        * in the edge edition, ip is 0, and at this time we use masterIp instead
@@ -381,6 +387,85 @@ void tscProcessMgmtRedirect(SSqlObj *pSql, uint8_t *cont) {
   tscPrintMgmtIp();
 }
 
+static int (*tscDecompFunc[])(const char *const input, int compressedSize, const int elements, char *const output,
+                              int outputSize, char algorithm, char *const buffer, int bufferSize) = {NULL,
+                                                                                                     NULL,
+                                                                                                     tsDecompressTinyint,
+                                                                                                     tsDecompressSmallint,
+                                                                                                     tsDecompressInt,
+                                                                                                     tsDecompressBigint,
+                                                                                                     tsDecompressFloat,
+                                                                                                     tsDecompressDouble,
+                                                                                                     tsDecompressString,
+                                                                                                     tsDecompressTimestamp,
+                                                                                                     tsDecompressString};
+
+/*
+ * columns compressed by vnode are decompressed right into pRes->pRsp in place of copying the message, so the result
+ * is laid out as if it was not compressed. The data following the columns, the progress of subscriptions, is copied
+ * as it is.
+ */
+static int32_t tscDecompressRetrieveRsp(SSqlRes *pRes, const char *cont, int32_t contLen) {
+  const SRetrieveMeterRsp *pSrc = (const SRetrieveMeterRsp *)cont;
+  const char *             end = cont + contLen;
+  int32_t                  numOfRows = htonl(pSrc->numOfRows);
+  int16_t                  numOfCols = htons(pSrc->numOfCols);
+
+  // the first pass gets the size of decompressed columns
+  const char *p = pSrc->data;
+  int32_t     rawLen = 0;
+  for (int32_t i = 0; i < numOfCols; ++i) {
+    const SRetrieveColumnRsp *pCol = (const SRetrieveColumnRsp *)p;
+    if (p + sizeof(SRetrieveColumnRsp) > end) return TSDB_CODE_WRONG_MSG_SIZE;
+
+    rawLen += htonl(pCol->rawLen);
+    p += sizeof(SRetrieveColumnRsp) + htonl(pCol->len);
+  }
+
+  if (p > end) return TSDB_CODE_WRONG_MSG_SIZE;
+
+  int32_t restLen = end - p;
+  int32_t rspLen = sizeof(SRetrieveMeterRsp) + rawLen + restLen + 1;  // including the code
+
+  char *tmp = (char *)realloc(pRes->pRsp, rspLen);
+  if (tmp == NULL) return TSDB_CODE_CLI_OUT_OF_MEMORY;
+
+  pRes->pRsp = tmp;
+  pRes->rspLen = rspLen;
+
+  SRetrieveMeterRsp *pDst = (SRetrieveMeterRsp *)pRes->pRsp;
+  memcpy(pDst, pSrc, sizeof(SRetrieveMeterRsp));
+  pDst->compressed = 0;
+
+  char *dst = pDst->data;
+  p = pSrc->data;
+  for (int32_t i = 0; i < numOfCols; ++i) {
+    const SRetrieveColumnRsp *pCol = (const SRetrieveColumnRsp *)p;
+    int32_t                   len = htonl(pCol->len);
+    int32_t                   colRawLen = htonl(pCol->rawLen);
+
+    if (!pCol->compressed) {
+      if (len != colRawLen) return TSDB_CODE_WRONG_MSG_SIZE;
+      memcpy(dst, pCol->data, colRawLen);
+    } else if (pCol->type > TSDB_DATA_TYPE_BOOL && pCol->type <= TSDB_DATA_TYPE_NCHAR) {
+      int32_t decompLen =
+          (*tscDecompFunc[(int32_t)pCol->type])(pCol->data, len, numOfRows, dst, colRawLen, ONE_STAGE_COMP, NULL, 0);
+      if (decompLen != colRawLen) {
+        tscError("column:%d type:%d, %d bytes decompressed, expected:%d", i, pCol->type, decompLen, colRawLen);
+        return TSDB_CODE_WRONG_MSG_SIZE;
+      }
+    } else {
+      return TSDB_CODE_WRONG_MSG_SIZE;
+    }
+
+    dst += colRawLen;
+    p += sizeof(SRetrieveColumnRsp) + len;
+  }
+
+  memcpy(dst, p, restLen);
+  return TSDB_CODE_SUCCESS;
+}
+
 void *tscProcessMsgFromServer(char *msg, void *ahandle, void *thandle) {
   if (ahandle == NULL) return NULL;
 
@@ -537,8 +622,17 @@ void *tscProcessMsgFromServer(char *msg, void *ahandle, void *thandle) {
     pRes->rspType = pMsg->msgType;
     pRes->rspLen = pMsg->msgLen - sizeof(SIntMsg);
 
-    char *tmp = (char *)realloc(pRes->pRsp, pRes->rspLen);
-    if (tmp == NULL) {
+    SRetrieveMeterRsp *pRetrieve = (SRetrieveMeterRsp *)(pMsg->content + 1);
+    char *             tmp = NULL;
+
+    if (pMsg->msgType == TSDB_MSG_TYPE_RETRIEVE_RSP && pRes->code == TSDB_CODE_SUCCESS &&
+        pRes->rspLen > sizeof(SRetrieveMeterRsp) && pRetrieve->compressed) {
+      int32_t ret = tscDecompressRetrieveRsp(pRes, (char *)pRetrieve, pRes->rspLen - 1);
+      if (ret != TSDB_CODE_SUCCESS) {
+        tscError("%p failed to decompress retrieve rsp, code:%d", pSql, ret);
+        pRes->code = ret;
+      }
+    } else if ((tmp = (char *)realloc(pRes->pRsp, pRes->rspLen)) == NULL) {
       pRes->code = TSDB_CODE_CLI_OUT_OF_MEMORY;
     } else {
       pRes->pRsp = tmp;
@@ -1200,6 +1294,10 @@ void tscRetrieveFromVnodeCallBack(void *param, TAOS_RES *tres, int numOfRows) {
   SSqlRes *   pRes = &pSql->res;
   SQueryInfo *pQueryInfo = tscGetQueryInfoDetail(&pSql->cmd, 0);
 
+  if (pRes->memUsage > pPObj->res.memUsage) {
+    pPObj->res.memUsage = pRes->memUsage;
+  }
+
   SMeterMetaInfo *pMeterMetaInfo = tscGetMeterMetaInfoFromQueryInfo(pQueryInfo, 0);
 
   SVnodeSidList *vnodeInfo = tscGetVnodeSidList(pMeterMetaInfo->pMetricMeta, idx);
@@ -1735,6 +1833,7 @@ int tscBuildQueryMsg(SSqlObj *pSql, SSqlInfo *pInfo) {
 
   pQueryMsg->queryType = htons(pQueryInfo->type);
   pQueryMsg->numOfOutputCols = htons(pQueryInfo->exprsInfo.numOfExprs);
+  pQueryMsg->retrieveWindow = htons(tsRetrieveWindow);
 
   if (pQueryInfo->fieldsInfo.numOfOutputCols < 0) {
     tscError("%p illegal value of number of output columns in query msg: %d", pSql,
@@ -2726,7 +2825,8 @@ int tscBuildMultiMeterMetaMsg(SSqlObj *pSql, SSqlInfo *pInfo) {
   tfree(tmpData);
 
   pCmd->payloadLen += sizeof(SMgmtHead) + sizeof(SMultiMeterInfoMsg);
-  pCmd->msgType = TSDB_MSG_TYPE_MULTI_METERINFO;
+  // tables that do not exist are created from their super tables, as the payload gives them, by the create msg
+  pCmd->msgType = pCmd->createOnDemand ? TSDB_MSG_TYPE_MULTI_CREATE_METERINFO : TSDB_MSG_TYPE_MULTI_METERINFO;
 
   assert(pCmd->payloadLen + minMsgSize() <= pCmd->allocSize);
 
@@ -3460,6 +3560,7 @@ int tscProcessRetrieveRspFromVnode(SSqlObj *pSql) {
   pRes->precision = htons(pRetrieve->precision);
   pRes->offset = htobe64(pRetrieve->offset);
   pRes->useconds = htobe64(pRetrieve->useconds);
+  pRes->memUsage = htobe64(pRetrieve->memUsage);
   pRes->data = pRetrieve->data;
   
   SQueryInfo* pQueryInfo = tscGetQueryInfoDetail(pCmd, pCmd->clauseIndex);
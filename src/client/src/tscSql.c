@@ -92,6 +92,7 @@ TAOS *taos_connect_imp(const char *ip, const char *user, const char *pass, const
   strncpy(pObj->user, user, TSDB_USER_LEN);
   taosEncryptPass((uint8_t *)pass, strlen(pass), pObj->pass);
   pObj->mgmtPort = port ? port : tsMgmtShellPort;
+  pObj->localMergeThreads = tsLocalMergeThreads;
 
   if (db) {
     int32_t len = strlen(db);
@@ -419,6 +419,7 @@ void tscFreeResData(SSqlObj* pSql) {
   
   pRes->offset = 0;
   pRes->useconds = 0;
+  pRes->memUsage = 0;
   
   tscDestroyLocalReducer(pSql);
   
@@ -78,9 +78,21 @@ typedef struct TAOS_BIND {
   int *          error;        // unused
 } TAOS_BIND;
 
+// values of one parameter for num rows, bound column by column
+typedef struct TAOS_MULTI_BIND {
+  int            buffer_type;
+  void *         buffer;         // num values, each one takes buffer_length bytes
+  uintptr_t      buffer_length;  // size of one value, the max length of binary/nchar values
+  int32_t *      length;         // actual length of each binary/nchar value, unused for other types
+  char *         is_null;        // null flag of each value, NULL if none of them is null
+  int            num;
+} TAOS_MULTI_BIND;
+
 TAOS_STMT *taos_stmt_init(TAOS *taos);
 int        taos_stmt_prepare(TAOS_STMT *stmt, const char *sql, unsigned long length);
+int        taos_stmt_set_tbname(TAOS_STMT *stmt, const char *name);
 int        taos_stmt_bind_param(TAOS_STMT *stmt, TAOS_BIND *bind);
+int        taos_stmt_bind_param_batch(TAOS_STMT *stmt, TAOS_MULTI_BIND *bind);
 int        taos_stmt_add_batch(TAOS_STMT *stmt);
 int        taos_stmt_execute(TAOS_STMT *stmt);
 TAOS_RES * taos_stmt_use_result(TAOS_STMT *stmt);
@@ -127,6 +139,12 @@ DLL_EXPORT void taos_close_stream(TAOS_STREAM *tstr);
 
 DLL_EXPORT int taos_load_table_info(TAOS *taos, const char* tableNameList);
 
+/*
+ * write points in line protocol, "measurement,tag=value... field=value... [timestamp in nanoseconds]" per line.
+ * The super table of a measurement and the child tables of tag sets are created or altered if needed.
+ */
+DLL_EXPORT int taos_insert_lines(TAOS *taos, char *lines[], int numLines);
+
 #ifdef __cplusplus
 }
 #endif
@@ -139,8 +139,9 @@ extern "C" {
 #define TSDB_CODE_TABLE_ID_MISMATCH          118
 #define TSDB_CODE_QUERY_CACHE_ERASED         119
 #define TSDB_CODE_AUTH_BANNED_PERIOD         120
+#define TSDB_CODE_QUERY_MEM_EXCEEDED         121
 
-#define TSDB_CODE_MAX_ERROR_CODE             121
+#define TSDB_CODE_MAX_ERROR_CODE             122
 
 #ifdef __cplusplus
 }
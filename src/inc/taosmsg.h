@@ -120,6 +120,8 @@ extern "C" {
 
 #define TSDB_MSG_TYPE_MULTI_METERINFO  85
 #define TSDB_MSG_TYPE_MULTI_METERINFO_RSP 86
+#define TSDB_MSG_TYPE_MULTI_CREATE_METERINFO  87
+#define TSDB_MSG_TYPE_MULTI_CREATE_METERINFO_RSP 88
 
 #define TSDB_MSG_TYPE_HEARTBEAT        91
 #define TSDB_MSG_TYPE_HEARTBEAT_RSP    92
@@ -544,6 +546,7 @@ typedef struct {
 
   int16_t queryType;        // denote another query process
   int16_t numOfOutputCols;  // final output columns numbers
+  int16_t retrieveWindow;   // file blocks of results the client accepts in one retrieve
 
   int16_t  interpoType;  // interpolate type
   uint64_t defaultVal;   // default value array list
@@ -582,11 +585,22 @@ typedef struct {
 typedef struct {
   int32_t numOfRows;
   int16_t precision;
+  int8_t  compressed;  // if set, each column in data starts with a SRetrieveColumnRsp
+  int16_t numOfCols;
   int64_t offset;  // updated offset value for multi-vnode projection query
   int64_t useconds;
+  int64_t memUsage;  // bytes reserved by the query from the query memory budget of the dnode
   char    data[];
 } SRetrieveMeterRsp;
 
+typedef struct {
+  int8_t  type;
+  int8_t  compressed;  // compressed by the codec of type, or copied as it is
+  int32_t len;         // bytes of data in message
+  int32_t rawLen;      // bytes of the column after decompressed
+  char    data[];
+} SRetrieveColumnRsp;
+
 typedef struct {
   uint32_t vnode;
   uint32_t vgId;
@@ -713,6 +727,18 @@ typedef struct {
   char    meterId[];
 } SMultiMeterInfoMsg;
 
+/*
+ * a table of the multi create meter info msg, created from the super table with the tags if it does not exist:
+ * | SMultiMeterInfoMsg | SMultiCreateMeterInfo0 | tags0 | SMultiCreateMeterInfo1 | tags1 | ...
+ * metas of the tables are returned as those of the multi meter info msg
+ */
+typedef struct {
+  char    meterId[TSDB_METER_ID_LEN];
+  char    stableId[TSDB_METER_ID_LEN];
+  int16_t tagLen;
+  char    tags[];
+} SMultiCreateMeterInfo;
+
 typedef struct {
   int16_t elemLen;
 
@@ -832,6 +858,7 @@ typedef struct {
   uint32_t queryId;
   int64_t  useconds;
   int64_t  stime;
+  int64_t  memUsage;
 } SQDesc;
 
 typedef struct {
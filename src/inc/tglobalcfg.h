@@ -74,6 +74,14 @@ extern int tsMetricMetaKeepTimer;
 
 extern float tsNumOfThreadsPerCore;
 extern float tsRatioOfQueryThreads;
+extern int   tsAsyncRead;
+extern int   tsReadAheadBlocks;
+extern int   tsNumOfReadThreads;
+extern int   tsBlockCacheSize;
+extern int   tsQueryParallelism;
+extern int   tsQueryMemBudget;
+extern int   tsQueryMemQuota;
+extern int   tsQueryMemWaitTime;
 extern char  tsPublicIp[];
 extern char  tsPrivateIp[];
 extern short tsNumOfVnodesPerCore;
@@ -85,15 +93,25 @@ extern short tsAffectedRowsMod;
 extern int tsSessionsPerVnode;
 extern int tsAverageCacheBlocks;
 extern int tsCacheBlockSize;
+extern int tsCacheShards;
 
 extern int   tsRowsInFileBlock;
 extern float tsFileBlockMinPercent;
+extern int   tsCompactInterval;
+extern int   tsCompactBlocksPerSec;
 
 extern short tsNumOfBlocksPerMeter;
 extern short tsCommitTime;  // seconds
+extern int   tsNumOfCommitThreads;
+extern int   tsNumOfCommitWorkers;
+extern int   tsMaxCommitsPerDir;
+extern int   tsImportBufferRows;
 extern short tsCommitLog;
+extern int   tsCommitLogSyncDelay;
+extern int   tsCommitLogSyncBytes;
 extern short tsAsyncLog;
 extern short tsCompression;
+extern int   tsFloatCompression;
 extern short tsDaysPerFile;
 extern int   tsDaysToKeep;
 extern int   tsReplications;
@@ -126,6 +144,9 @@ extern int tsEnableHttpModule;
 extern int tsEnableMonitorModule;
 extern int tsRestRowLimit;
 extern int tsCompressMsgSize;
+extern int tsRetrieveWindow;
+extern int tsImportThreads;
+extern int tsLocalMergeThreads;
 extern int tsMaxSQLStringLen;
 extern int tsMaxNumOfOrderedResults;
 
@@ -256,7 +277,7 @@ extern int            tsGlobalConfigNum;
 extern char *         tsCfgStatusStr[];
 SGlobalConfig *tsGetConfigOption(const char *option);
 
-#define TSDB_CFG_MAX_NUM    111
+#define TSDB_CFG_MAX_NUM    132
 #define TSDB_CFG_PRINT_LEN  23
 #define TSDB_CFG_OPTION_LEN 24
 #define TSDB_CFG_VALUE_LEN  41
@@ -21,6 +21,7 @@ typedef struct SQueryDiskbasedResultBuf {
   int32_t  fd;                  // data file fd
   int32_t  allocateId;          // allocated page id
   int32_t  incStep;             // minimum allocated pages
+  int64_t  spilledBufSize;      // buffer size when pages were spilled last time
   char*    pBuf;                // mmap buffer pointer
   char*    path;                // file path
   
@@ -77,6 +78,14 @@ tFilePage* getResultBufferPageById(SQueryDiskbasedResultBuf* pResultBuf, int32_t
  */
 int32_t getResBufSize(SQueryDiskbasedResultBuf* pResultBuf);
 
+/**
+ * write the pages back to the disk file and release their memory, the pages are loaded again when accessed.
+ * It is done only after the buffer grows by a quarter since the last time.
+ * @param pResultBuf
+ * @return the number of bytes released since the last time, 0 if nothing is written back
+ */
+int64_t spillResultBufPages(SQueryDiskbasedResultBuf* pResultBuf);
+
 /**
  * get the number of groups in the result buffer
  * @param pResultBuf
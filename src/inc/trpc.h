@@ -98,6 +98,9 @@ void taosStopRpcConn(void *thandle);
 
 int taosSendMsgToPeerH(void *thandle, char *pCont, int contLen, void *ahandle);
 
+// the same as taosSendMsgToPeer, but the message is never compressed by rpc, e.g., it is compressed by the sender
+int taosSendUncompressedMsgToPeer(void *thandle, char *pCont, int contLen);
+
 char *taosBuildReqHeader(void *param, char type, char *msg);
 
 char *taosBuildReqMsgWithSize(void *, char type, int size);
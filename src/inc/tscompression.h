@@ -31,6 +31,15 @@ extern "C" {
 #define NO_COMPRESSION 0
 #define ONE_STAGE_COMP 1
 #define TWO_STAGE_COMP 2
+// Codec engines of timestamps and integers, all of them produce the same bytes
+#define TSDB_CODEC_REFERENCE 0  // the original byte-wise implementations, used on big endian hosts
+#define TSDB_CODEC_SCALAR    1
+#define TSDB_CODEC_SSE42     2
+#define TSDB_CODEC_AVX2      3
+// Codecs of float and double columns, selected by the floatComp option
+#define TSDB_FLOAT_COMP_BYTES    0  // XOR with the previous value, leading or trailing bytes are kept for each value
+#define TSDB_FLOAT_COMP_GROUP    1  // XOR with the previous value, one bit window is kept for each group of 8 values
+#define TSDB_FLOAT_COMP_ADAPTIVE 2  // both are tried and the smaller one is kept
 
 int tsCompressTinyint(const char* const input, int inputSize, const int nelements, char* const output, int outputSize, char algorithm,
                       char* const buffer, int bufferSize);
@@ -70,6 +79,13 @@ int tsDecompressDouble(const char* const input, int compressedSize, const int ne
 int tsDecompressTimestamp(const char* const input, int compressedSize, const int nelements, char* const output,
                           int outputSize, char algorithm, char* const buffer, int bufferSize);
 
+/*
+ * Select the codec engine, -1 picks the best one supported by the CPU. A codec not supported falls back to the
+ * best one, and the codec in use is returned.
+ */
+int tsSetCompressCodec(int codec);
+int tsGetCompressCodec();
+
 #ifdef __cplusplus
 }
 #endif
@@ -166,6 +166,8 @@ extern "C" {
 #define TSDB_MIN_COMPRESSION_LEVEL      0
 #define TSDB_MAX_COMPRESSION_LEVEL      2
 
+#define TSDB_COMMIT_LOG_SYNC            2  // commit log is synced to disk in groups before insert returns
+
 #define TSDB_MIN_COMMIT_TIME_INTERVAL   30
 #define TSDB_MAX_COMMIT_TIME_INTERVAL   40960
 
@@ -224,6 +224,11 @@ void* shellImportThreadFp(void *arg)
 static void shellRunImportThreads(struct arguments* args)
 {
   pthread_attr_t thattr;
+
+  // data files of "insert into ... file" are loaded by a pool of threads per statement, the pools of all connections
+  // together shall not use more threads than the cores
+  tsImportThreads = MAX(1, tsImportThreads / args->threadNum);
+
   ShellThreadObj *threadObj = (ShellThreadObj *)calloc(args->threadNum, sizeof(ShellThreadObj));
   for (int t = 0; t < args->threadNum; ++t) {
     ShellThreadObj *pThread = threadObj + t;
@@ -31,4 +31,58 @@ typedef struct {
 
 extern void (*monitorCountReqFp)(SCountInfo *info);
 
+typedef struct {
+  int64_t hits;
+  int64_t misses;
+  int64_t evictions;
+  int64_t cachedBytes;
+} SBlockCacheInfo;
+
+extern void (*monitorBlockCacheFp)(SBlockCacheInfo *info);
+
+typedef struct {
+  int32_t queued;
+  int32_t running;
+  int64_t commits;
+  int64_t waitUs;
+  int64_t latency[5];  // commits finished in 100ms, 1s, 10s, 60s, and longer
+} SCommitSchedInfo;
+
+extern void (*monitorCommitSchedFp)(SCommitSchedInfo *info);
+
+typedef struct {
+  int64_t commits;
+  int64_t blocks;
+  int64_t bytes;
+  int64_t useconds;
+} SCommitInfo;
+
+extern void (*monitorCommitFp)(SCommitInfo *info);
+
+typedef struct {
+  int64_t rounds;
+  int64_t meters;
+  int64_t srcBlocks;
+  int64_t dstBlocks;
+  int64_t srcBytes;
+  int64_t dstBytes;
+  int64_t reclaimedBytes;
+  int64_t useconds;
+} SCompactInfo;
+
+extern void (*monitorCompactFp)(SCompactInfo *info);
+
+typedef struct {
+  int64_t budget;
+  int64_t used;
+  int64_t peak;
+  int32_t queued;
+  int64_t admitted;
+  int64_t rejected;
+  int64_t spills;
+  int64_t spilledBytes;
+} SQueryMemInfo;
+
+extern void (*monitorQueryMemFp)(SQueryMemInfo *info);
+
 #endif
\ No newline at end of file
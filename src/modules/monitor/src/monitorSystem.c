@@ -39,6 +39,16 @@ typedef enum {
   MONITOR_CMD_CREATE_TB_DN,
   MONITOR_CMD_CREATE_TB_ACCT_ROOT,
   MONITOR_CMD_CREATE_TB_SLOWQUERY,
+  MONITOR_CMD_CREATE_MT_BC,
+  MONITOR_CMD_CREATE_TB_BC,
+  MONITOR_CMD_CREATE_MT_CS,
+  MONITOR_CMD_CREATE_TB_CS,
+  MONITOR_CMD_CREATE_MT_CM,
+  MONITOR_CMD_CREATE_TB_CM,
+  MONITOR_CMD_CREATE_MT_CP,
+  MONITOR_CMD_CREATE_TB_CP,
+  MONITOR_CMD_CREATE_MT_QM,
+  MONITOR_CMD_CREATE_TB_QM,
   MONITOR_CMD_MAX
 } MonitorCommand;
 
@@ -78,6 +88,11 @@ void monitorSaveAcctLog(char *acctId, int64_t currentPointsPerSecond, int64_t ma
                         int64_t totalUsers, int64_t maxUsers, int64_t totalStreams, int64_t maxStreams,
                         int64_t totalConns, int64_t maxConns, int8_t accessState);
 void (*monitorCountReqFp)(SCountInfo *info) = NULL;
+void (*monitorBlockCacheFp)(SBlockCacheInfo *info) = NULL;
+void (*monitorCommitSchedFp)(SCommitSchedInfo *info) = NULL;
+void (*monitorCommitFp)(SCommitInfo *info) = NULL;
+void (*monitorCompactFp)(SCompactInfo *info) = NULL;
+void (*monitorQueryMemFp)(SQueryMemInfo *info) = NULL;
 void monitorExecuteSQL(char *sql);
 
 void monitorCheckDiskUsage(void *para, void *unused) {
@@ -189,6 +204,54 @@ void dnodeBuildMonitorSql(char *sql, int cmd) {
              "create table if not exists %s.slowquery(ts timestamp, username "
              "binary(%d), created_time timestamp, time bigint, sql binary(%d))",
              tsMonitorDbName, TSDB_METER_ID_LEN, TSDB_SHOW_SQL_LEN);
+  } else if (cmd == MONITOR_CMD_CREATE_MT_BC) {
+    snprintf(sql, SQL_LENGTH,
+             "create table if not exists %s.bc(ts timestamp"
+             ", hits bigint, misses bigint, evictions bigint, cache_used float"
+             ") tags (ipaddr binary(%d))",
+             tsMonitorDbName, IP_LEN_STR + 1);
+  } else if (cmd == MONITOR_CMD_CREATE_TB_BC) {
+    snprintf(sql, SQL_LENGTH, "create table if not exists %s.bc_%s using %s.bc tags('%s')", tsMonitorDbName,
+             monitor->privateIpStr, tsMonitorDbName, tsPrivateIp);
+  } else if (cmd == MONITOR_CMD_CREATE_MT_CS) {
+    snprintf(sql, SQL_LENGTH,
+             "create table if not exists %s.cs(ts timestamp"
+             ", queued int, running int, commits bigint, avg_wait_ms float"
+             ", lat_100ms bigint, lat_1s bigint, lat_10s bigint, lat_60s bigint, lat_long bigint"
+             ") tags (ipaddr binary(%d))",
+             tsMonitorDbName, IP_LEN_STR + 1);
+  } else if (cmd == MONITOR_CMD_CREATE_TB_CS) {
+    snprintf(sql, SQL_LENGTH, "create table if not exists %s.cs_%s using %s.cs tags('%s')", tsMonitorDbName,
+             monitor->privateIpStr, tsMonitorDbName, tsPrivateIp);
+  } else if (cmd == MONITOR_CMD_CREATE_MT_CM) {
+    snprintf(sql, SQL_LENGTH,
+             "create table if not exists %s.cm(ts timestamp"
+             ", commits bigint, blocks bigint, write_mb float, avg_commit_ms float"
+             ") tags (ipaddr binary(%d))",
+             tsMonitorDbName, IP_LEN_STR + 1);
+  } else if (cmd == MONITOR_CMD_CREATE_TB_CM) {
+    snprintf(sql, SQL_LENGTH, "create table if not exists %s.cm_%s using %s.cm tags('%s')", tsMonitorDbName,
+             monitor->privateIpStr, tsMonitorDbName, tsPrivateIp);
+  } else if (cmd == MONITOR_CMD_CREATE_MT_CP) {
+    snprintf(sql, SQL_LENGTH,
+             "create table if not exists %s.cp(ts timestamp"
+             ", rounds bigint, meters bigint, src_blocks bigint, dst_blocks bigint, src_mb float, dst_mb float"
+             ", reclaimed_mb float, avg_round_ms float"
+             ") tags (ipaddr binary(%d))",
+             tsMonitorDbName, IP_LEN_STR + 1);
+  } else if (cmd == MONITOR_CMD_CREATE_TB_CP) {
+    snprintf(sql, SQL_LENGTH, "create table if not exists %s.cp_%s using %s.cp tags('%s')", tsMonitorDbName,
+             monitor->privateIpStr, tsMonitorDbName, tsPrivateIp);
+  } else if (cmd == MONITOR_CMD_CREATE_MT_QM) {
+    snprintf(sql, SQL_LENGTH,
+             "create table if not exists %s.qm(ts timestamp"
+             ", budget_mb float, used_mb float, peak_mb float, queued int, admitted bigint, rejected bigint"
+             ", spills bigint, spilled_mb float"
+             ") tags (ipaddr binary(%d))",
+             tsMonitorDbName, IP_LEN_STR + 1);
+  } else if (cmd == MONITOR_CMD_CREATE_TB_QM) {
+    snprintf(sql, SQL_LENGTH, "create table if not exists %s.qm_%s using %s.qm tags('%s')", tsMonitorDbName,
+             monitor->privateIpStr, tsMonitorDbName, tsPrivateIp);
   } else if (cmd == MONITOR_CMD_CREATE_TB_LOG) {
     snprintf(sql, SQL_LENGTH,
              "create table if not exists %s.log(ts timestamp, level tinyint, "
@@ -274,6 +337,46 @@ void dnodeMontiorInsertSysCallback(void *param, TAOS_RES *result, int code) {
   }
 }
 
+void dnodeMontiorInsertBlockCacheCallback(void *param, TAOS_RES *result, int code) {
+  if (code <= 0) {
+    monitorError("monitor:%p, save block cache info failed, code:%d", monitor->conn, code);
+  } else {
+    monitorTrace("monitor:%p, save block cache info success, code:%d", monitor->conn, code);
+  }
+}
+
+void dnodeMontiorInsertCommitSchedCallback(void *param, TAOS_RES *result, int code) {
+  if (code <= 0) {
+    monitorError("monitor:%p, save commit scheduler info failed, code:%d", monitor->conn, code);
+  } else {
+    monitorTrace("monitor:%p, save commit scheduler info success, code:%d", monitor->conn, code);
+  }
+}
+
+void dnodeMontiorInsertCommitCallback(void *param, TAOS_RES *result, int code) {
+  if (code <= 0) {
+    monitorError("monitor:%p, save commit info failed, code:%d", monitor->conn, code);
+  } else {
+    monitorTrace("monitor:%p, save commit info success, code:%d", monitor->conn, code);
+  }
+}
+
+void dnodeMontiorInsertCompactCallback(void *param, TAOS_RES *result, int code) {
+  if (code <= 0) {
+    monitorError("monitor:%p, save compact info failed, code:%d", monitor->conn, code);
+  } else {
+    monitorTrace("monitor:%p, save compact info success, code:%d", monitor->conn, code);
+  }
+}
+
+void dnodeMontiorInsertQueryMemCallback(void *param, TAOS_RES *result, int code) {
+  if (code <= 0) {
+    monitorError("monitor:%p, save query memory info failed, code:%d", monitor->conn, code);
+  } else {
+    monitorTrace("monitor:%p, save query memory info success, code:%d", monitor->conn, code);
+  }
+}
+
 void dnodeMontiorInsertLogCallback(void *param, TAOS_RES *result, int code) {
   if (code < 0) {
     monitorError("monitor:%p, save log failed, code:%d", monitor->conn, code);
@@ -350,6 +453,104 @@ int monitorBuildIoSql(char *sql) {
   return sprintf(sql, ", %f, %f", readKB, writeKB);
 }
 
+// hits, misses and evictions are counted since last report, cache used is in MB
+void monitorSaveBlockCacheInfo(int64_t ts) {
+  if (monitorBlockCacheFp == NULL) {
+    return;
+  }
+
+  SBlockCacheInfo info = {0};
+  (*monitorBlockCacheFp)(&info);
+
+  char sql[SQL_LENGTH] = {0};
+  snprintf(sql, SQL_LENGTH,
+           "insert into %s.bc_%s values(%" PRId64 ", %" PRId64 ", %" PRId64 ", %" PRId64 ", %f)", tsMonitorDbName,
+           monitor->privateIpStr, ts, info.hits, info.misses, info.evictions, info.cachedBytes / 1048576.0);
+
+  monitorTrace("monitor:%p, save block cache info, sql:%s", monitor->conn, sql);
+  taos_query_a(monitor->conn, sql, dnodeMontiorInsertBlockCacheCallback, "log");
+}
+
+// commits and the latency histogram are counted since last report
+void monitorSaveCommitSchedInfo(int64_t ts) {
+  if (monitorCommitSchedFp == NULL) {
+    return;
+  }
+
+  SCommitSchedInfo info = {0};
+  (*monitorCommitSchedFp)(&info);
+
+  char sql[SQL_LENGTH] = {0};
+  snprintf(sql, SQL_LENGTH,
+           "insert into %s.cs_%s values(%" PRId64 ", %d, %d, %" PRId64 ", %f, %" PRId64 ", %" PRId64 ", %" PRId64
+           ", %" PRId64 ", %" PRId64 ")",
+           tsMonitorDbName, monitor->privateIpStr, ts, info.queued, info.running, info.commits,
+           (info.commits > 0) ? info.waitUs / 1000.0 / info.commits : 0.0, info.latency[0], info.latency[1],
+           info.latency[2], info.latency[3], info.latency[4]);
+
+  monitorTrace("monitor:%p, save commit scheduler info, sql:%s", monitor->conn, sql);
+  taos_query_a(monitor->conn, sql, dnodeMontiorInsertCommitSchedCallback, "log");
+}
+
+// commits, blocks and bytes written are counted since last report
+void monitorSaveCommitInfo(int64_t ts) {
+  if (monitorCommitFp == NULL) {
+    return;
+  }
+
+  SCommitInfo info = {0};
+  (*monitorCommitFp)(&info);
+
+  char sql[SQL_LENGTH] = {0};
+  snprintf(sql, SQL_LENGTH, "insert into %s.cm_%s values(%" PRId64 ", %" PRId64 ", %" PRId64 ", %f, %f)",
+           tsMonitorDbName, monitor->privateIpStr, ts, info.commits, info.blocks, info.bytes / 1048576.0,
+           (info.commits > 0) ? info.useconds / 1000.0 / info.commits : 0.0);
+
+  monitorTrace("monitor:%p, save commit info, sql:%s", monitor->conn, sql);
+  taos_query_a(monitor->conn, sql, dnodeMontiorInsertCommitCallback, "log");
+}
+
+// compaction rounds, blocks and bytes are counted since last report
+void monitorSaveCompactInfo(int64_t ts) {
+  if (monitorCompactFp == NULL) {
+    return;
+  }
+
+  SCompactInfo info = {0};
+  (*monitorCompactFp)(&info);
+
+  char sql[SQL_LENGTH] = {0};
+  snprintf(sql, SQL_LENGTH,
+           "insert into %s.cp_%s values(%" PRId64 ", %" PRId64 ", %" PRId64 ", %" PRId64 ", %" PRId64
+           ", %f, %f, %f, %f)",
+           tsMonitorDbName, monitor->privateIpStr, ts, info.rounds, info.meters, info.srcBlocks, info.dstBlocks,
+           info.srcBytes / 1048576.0, info.dstBytes / 1048576.0, info.reclaimedBytes / 1048576.0,
+           (info.rounds > 0) ? info.useconds / 1000.0 / info.rounds : 0.0);
+
+  monitorTrace("monitor:%p, save compact info, sql:%s", monitor->conn, sql);
+  taos_query_a(monitor->conn, sql, dnodeMontiorInsertCompactCallback, "log");
+}
+
+// admitted, rejected and spilled queries are counted since last report
+void monitorSaveQueryMemInfo(int64_t ts) {
+  if (monitorQueryMemFp == NULL) {
+    return;
+  }
+
+  SQueryMemInfo info = {0};
+  (*monitorQueryMemFp)(&info);
+
+  char sql[SQL_LENGTH] = {0};
+  snprintf(sql, SQL_LENGTH,
+           "insert into %s.qm_%s values(%" PRId64 ", %f, %f, %f, %d, %" PRId64 ", %" PRId64 ", %" PRId64 ", %f)",
+           tsMonitorDbName, monitor->privateIpStr, ts, info.budget / 1048576.0, info.used / 1048576.0,
+           info.peak / 1048576.0, info.queued, info.admitted, info.rejected, info.spills,
+           info.spilledBytes / 1048576.0);
+
+  monitorTrace("monitor:%p, save query memory info, sql:%s", monitor->conn, sql);
+  taos_query_a(monitor->conn, sql, dnodeMontiorInsertQueryMemCallback, "log");
+}
+
 void monitorSaveSystemInfo() {
   if (monitor->state != MONITOR_STATE_INITIALIZED) {
     return;
@@ -373,6 +574,12 @@ void monitorSaveSystemInfo() {
   monitorTrace("monitor:%p, save system info, sql:%s", monitor->conn, sql);
   taos_query_a(monitor->conn, sql, dnodeMontiorInsertSysCallback, "log");
 
+  monitorSaveBlockCacheInfo(ts);
+  monitorSaveCommitSchedInfo(ts);
+  monitorSaveCommitInfo(ts);
+  monitorSaveCompactInfo(ts);
+  monitorSaveQueryMemInfo(ts);
+
   if (monitor->timer != NULL && monitor->state != MONITOR_STATE_STOPPED) {
     monitorStartTimer();
   }
@@ -1245,7 +1245,7 @@ void *taosProcessDataFromPeer(char *data, int dataLen, uint32_t ip, uint16_t por
   return pConn;
 }
 
-int taosSendMsgToPeerH(void *thandle, char *pCont, int contLen, void *ahandle) {
+static int taosSendMsgToPeerImp(void *thandle, char *pCont, int contLen, void *ahandle, bool compress) {
   STaosHeader *pHeader;
   SMsgNode *   pMsgNode;
   char *       msg;
@@ -1266,7 +1266,7 @@ int taosSendMsgToPeerH(void *thandle, char *pCont, int contLen, void *ahandle) {
 
   if ((pHeader->msgType & 1U) == 0 && pConn->localPort) pHeader->port = pConn->localPort;
   
-  contLen = taosCompressRpcMsg(pCont, contLen);
+  if (compress) contLen = taosCompressRpcMsg(pCont, contLen);
 
   msgLen = contLen + (int32_t)sizeof(STaosHeader);
 
@@ -1341,6 +1341,14 @@ int taosSendMsgToPeerH(void *thandle, char *pCont, int contLen, void *ahandle) {
   return contLen;
 }
 
+int taosSendMsgToPeerH(void *thandle, char *pCont, int contLen, void *ahandle) {
+  return taosSendMsgToPeerImp(thandle, pCont, contLen, ahandle, true);
+}
+
+int taosSendUncompressedMsgToPeer(void *thandle, char *pCont, int contLen) {
+  return taosSendMsgToPeerImp(thandle, pCont, contLen, NULL, false);
+}
+
 int taosReSendRspToPeer(SRpcConn *pConn) {
   STaosHeader *pHeader;
   int          writtenLen;
@@ -103,13 +103,12 @@ char *taosMsg[] = {"null",
                    "alter-stream-rsp",
                    "alter-table",
                    "alter-table-rsp",
-
-                   "",
-                   "",
-                   "",
-                   "",
-                   "",
-                   "",
+                   "alter-db",
+                   "alter-db-rsp",
+                   "multi-meterinfo",
+                   "multi-meterinfo-rsp",
+                   "multi-create-meterinfo",
+                   "multi-create-meterinfo-rsp",
                    "",
                    "",
 
@@ -245,4 +244,5 @@ char *tsError[] = {"success",
                    "table id/uid mismatch",
                    "client query cache erased",     // 119
                    "too many authentication failed, try 10 minutes later",   //120                   
+                   "query memory budget exceeded",
 };
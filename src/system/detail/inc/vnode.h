@@ -74,9 +74,30 @@ typedef struct {
   char    data[];
 } SData;
 
+typedef struct {
+  int64_t commits;   // number of commits finished
+  int64_t blocks;    // number of blocks written by commits
+  int64_t bytes;     // bytes written by commits
+  int64_t useconds;  // time spent on commits
+} SVnodeCommitStat;
+
+typedef struct {
+  int64_t rounds;          // number of compaction rounds finished
+  int64_t meters;          // number of meters whose blocks are merged
+  int64_t srcBlocks;       // number of small blocks merged
+  int64_t dstBlocks;       // number of blocks written
+  int64_t srcBytes;        // size of the small blocks merged
+  int64_t dstBytes;        // size of the blocks written
+  int64_t reclaims;        // number of data files rewritten to reclaim dead space
+  int64_t reclaimedBytes;  // dead space reclaimed
+  int64_t useconds;        // time spent on compaction
+} SVnodeCompactStat;
+
 #pragma pack(push, 8)
 typedef struct {
   SVnodeStatisticInfo vnodeStatistic;
+  SVnodeCommitStat    commitStat;
+  SVnodeCompactStat   compactStat;
   int                 vnode;
   SVnodeCfg           cfg;
   // SDiskDesc   tierDisk[TSDB_MAX_TIER];
@@ -119,6 +140,7 @@ typedef struct {
   int             dfd;  // data file FD
   int64_t         dfSize;
   int64_t         lfSize;
+  int32_t         dataVersion;  // increased when compaction rewrites a data file, guarded by vmutex
   uint64_t *      fmagic;  // hold magic number for each file
   char            cfn[TSDB_FILENAME_LEN];
   char            nfn[TSDB_FILENAME_LEN];
@@ -135,7 +157,19 @@ typedef struct {
   int64_t         mappingSize;
   int64_t         mappingThreshold;
 
+  // group commit of the commit log, only used if cfg.commitLog is TSDB_COMMIT_LOG_SYNC
+  pthread_t       logSyncThread;
+  pthread_cond_t  logSyncCond;    // wake up the log sync thread
+  pthread_cond_t  logSyncedCond;  // wake up the writers waiting for their records to be synced
+  int64_t         logSyncedLen;   // length of the log content that is already synced to disk
+  int64_t         logFailedLen;   // end of the latest batch that failed to be synced
+  int32_t         logGen;         // increased every time the commit log is renewed
+  int32_t         logFailedGen;   // the latest generation whose records failed to be synced when it was renewed
+  char            logSyncing;
+  char            logSyncStop;
+
   void *         commitTimer;
+  void *         compactTimer;
   void **        meterList;
   void *         pCachePool;
   void *         pQueue;
@@ -147,6 +181,7 @@ typedef struct {
 
   TAOS *           dbConn;
   SMeterObjHeader *meterIndex;
+  int64_t          importBufBytes;  // bytes of out-of-order rows buffered by all meters
 } SVnodeObj;
 #pragma pack(pop)
 
@@ -183,6 +218,7 @@ typedef struct _meter_obj {
   char *   pSql;
   void *   pStream;
   void *   pCache;
+  void *   pImportBuf;  // out-of-order rows not merged yet
   SColumn *schema;
 } SMeterObj;
 
@@ -219,6 +255,13 @@ typedef struct SColumnFilterElem {
   int16_t           bytes;  // column length
   __filter_func_t   fp;
   SColumnFilterInfo filterInfo;
+
+  // the filter rewritten for vnodeBatchFilterData, see vnodeInitBatchFilter
+  int8_t  batchOptr;
+  int64_t batchLowerBndi;  // inclusive bounds, or the value of not equal
+  int64_t batchUpperBndi;
+  double  batchLowerBndd;
+  double  batchUpperBndd;
 } SColumnFilterElem;
 
 typedef struct SSingleColumnFilterInfo {
@@ -306,6 +349,7 @@ extern uint32_t   tsRebootTime;
 extern void **    rpcQhandle;
 extern void *     dmQhandle;
 extern void *     queryQhandle;
+extern void *     commitQhandle;
 extern int        tsVnodePeers;
 extern int        tsMaxVnode;
 extern int        tsMaxQueues;
@@ -332,7 +376,10 @@ bool vnodeIsValidVnodeCfg(SVnodeCfg *pCfg);
 
 int32_t vnodeGetResultSize(void *handle, int32_t *numOfRows);
 
-int32_t vnodeCopyQueryResultToMsg(void *handle, char *data, int32_t numOfRows);
+/* columns of results are compressed one by one if the size is larger than compressMsgSize */
+bool vnodeNeedToCompressResult(void *handle, int32_t size);
+
+int32_t vnodeCopyQueryResultToMsg(void *handle, char *data, int32_t numOfRows, bool compressed, int32_t *size);
 
 int64_t vnodeGetOffsetVal(void *thandle);
 
@@ -340,7 +387,7 @@ bool vnodeHasRemainResults(void *handle);
 
 int vnodeRetrieveQueryResult(void *handle, int *pNum, char *argv[]);
 
-int vnodeSaveQueryResult(void *handle, char *data, int32_t* size);
+int vnodeSaveQueryResult(void *handle, char *data, int32_t* size, bool compressed);
 
 int vnodeRetrieveQueryInfo(void *handle, int *numOfRows, int *rowSize, int16_t *timePrec);
 
@@ -422,6 +469,17 @@ int vnodeFreeCacheBlock(SCacheBlock *pCacheBlock);
 
 int vnodeIsCacheCommitted(SMeterObj *pObj);
 
+// import buffer API
+int32_t vnodeGetImportBufferRows(SMeterObj *pObj);
+
+int32_t vnodeFlushImportBuffer(SMeterObj *pObj);
+
+void vnodeMergeImportBuffers(SVnodeObj *pVnode, int ssid, int esid);
+
+void vnodeRelogImportBuffers(SVnodeObj *pVnode, int ssid, int esid);
+
+void vnodeFreeImportBuffer(SMeterObj *pObj);
+
 // file API
 int vnodeInitFile(int vnode);
 
@@ -431,6 +489,16 @@ void *vnodeCommitToFile(void *param);
 
 void *vnodeCommitMultiToFile(SVnodeObj *pVnode, int ssid, int esid);
 
+// sum of the commit statistics of all vnodes
+void vnodeGetCommitStat(SVnodeCommitStat *pStat);
+
+void vnodeProcessCompactTimer(void *param, void *tmrId);
+
+// sum of the compaction statistics of all vnodes
+void vnodeGetCompactStat(SVnodeCompactStat *pStat);
+
+void *vnodeCompactVnode(void *param);
+
 int vnodeSyncRetrieveFile(int vnode, int fd, uint32_t fileId, uint64_t *fmagic);
 
 int vnodeSyncRestoreFile(int vnode, int sfd);
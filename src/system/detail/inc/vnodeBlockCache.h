@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TDENGINE_VNODEBLOCKCACHE_H
+#define TDENGINE_VNODEBLOCKCACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+  int64_t hits;
+  int64_t misses;
+  int64_t evictions;
+  int64_t numOfChunks;
+  int64_t cachedBytes;
+  int64_t capacity;
+} SBlockCacheStat;
+
+/*
+ * Decompressed column data of file blocks shared by all queries, keyed by (vnode, fileId, version, offset, colId).
+ * version is the data file version the query opened, since offsets are reused once compaction rewrites the data file.
+ * capacity is in bytes, 0 disables the cache.
+ */
+int32_t vnodeInitBlockCache(int64_t capacity);
+
+void vnodeCleanUpBlockCache();
+
+/* copy the cached column into buf, returns -1 if it is not cached */
+int32_t vnodeGetBlockCache(int32_t vnode, int32_t fileId, int32_t version, int64_t offset, int16_t colId, char *buf,
+                           int32_t size);
+
+/* check if the column is cached, without touching its position in the lru list */
+bool vnodeIsBlockCached(int32_t vnode, int32_t fileId, int32_t version, int64_t offset, int16_t colId);
+
+void vnodePutBlockCache(int32_t vnode, int32_t fileId, int32_t version, int64_t offset, int16_t colId, const char *data,
+                        int32_t size);
+
+/* drop cached columns of a file, or of all files of the vnode if fileId is -1 */
+void vnodeInvalidateBlockCache(int32_t vnode, int32_t fileId);
+
+void vnodeGetBlockCacheStat(SBlockCacheStat *pStat);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TDENGINE_VNODEBLOCKCACHE_H
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TDENGINE_VNODEBLOCKREAD_H
+#define TDENGINE_VNODEBLOCKREAD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define TSDB_BLOCK_READ_SYNC  0  // blocks are read by the query thread when they are loaded
+#define TSDB_BLOCK_READ_URING 1  // io_uring, falls back to the read thread pool if the kernel does not support it
+#define TSDB_BLOCK_READ_POOL  2  // pread in the read thread pool
+
+// ranges of a request read after its head
+#define TSDB_BLOCK_READ_MAX_RANGES 4
+
+typedef struct {
+  int     fd;
+  int32_t len;  // length of the head, 0 if nothing of the request is needed
+  int64_t offset;
+} SBlockReadReq;
+
+typedef struct {
+  int64_t offset;
+  int32_t len;
+} SBlockReadRange;
+
+/*
+ * Called once the head of request seq is read. It fills at most TSDB_BLOCK_READ_MAX_RANGES ranges of the same file
+ * to be read next and returns their number. It is called in a read thread or in the thread reaping io_uring, so it
+ * can only use data that are not changed while the reader is open.
+ */
+typedef int32_t (*__block_read_next_fn_t)(void *param, int32_t seq, const char *head, SBlockReadRange *pRanges);
+
+int32_t vnodeInitBlockReadPool(int32_t numOfThreads);
+
+void vnodeCleanUpBlockReadPool();
+
+/*
+ * Requests are given in the order the caller consumes them. At most depth of them are in flight, each batch is
+ * issued in file offset order, and the caller gets them back one by one by vnodeAcquireBlockRead with increasing
+ * sequence. The head of a request is read first, then the ranges given by fp, if it is not NULL. A reader on io_uring
+ * sets up a ring of its own, so readers of one thread never take completions of each other, and a reader may be used
+ * by any thread, one at a time.
+ * Returns NULL if mode is TSDB_BLOCK_READ_SYNC or no asynchronous engine is available.
+ */
+void *vnodeOpenBlockReader(SBlockReadReq *pReqs, int32_t numOfReqs, int32_t depth, int32_t mode,
+                           __block_read_next_fn_t fp, void *param);
+
+int32_t vnodeAcquireBlockRead(void *handle, int32_t seq);
+
+/* copy data of the acquired request, returns -1 if the range is not in what is read or the read failed */
+int32_t vnodeCopyFromBlockRead(void *handle, int fd, int64_t offset, char *buf, int32_t size);
+
+int32_t vnodeGetBlockReadMode(void *handle);
+
+void vnodeCloseBlockReader(void *handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TDENGINE_VNODEBLOCKREAD_H
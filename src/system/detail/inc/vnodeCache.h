@@ -25,6 +25,7 @@ typedef struct {
   short              numOfPoints;
   int                slot;
   int                index;
+  int                shard;  // home shard of pMeterObj, whose mutex protects an allocated block
   int64_t            blockId;
   struct _meter_obj *pMeterObj;
   char *             offset[];
@@ -41,19 +42,46 @@ typedef struct {
   SCacheBlock **cacheBlocks;  // cache block list, circular list
 } SCacheInfo;
 
+#define TSDB_MAX_CACHE_SHARDS 64
+
+/*
+ * The cache blocks of a vnode are split into shards, and the sid of a meter selects its home shard.
+ * Writers of meters in different shards roll over cache blocks without contending for the same
+ * mutex. A meter takes blocks from its home shard first, and borrows free or committed blocks
+ * from the other shards once all blocks of the home shard are waiting to be committed, so that
+ * a hot shard does not stall while the others are idle.
+ */
+typedef struct {
+  pthread_mutex_t mutex;        // protect the free blocks of this shard and SCacheInfo of its meters
+  int32_t         startBlock;   // index of the first block of this shard in pMem
+  int32_t         numOfBlocks;
+  int32_t         freeSlot;     // relative to startBlock
+  int32_t         notFreeSlots; // blocks of this shard not committed yet, updated atomically
+  int32_t         threshold;
+} SCacheShard;
+
 typedef struct {
   int             vnode;
   char **         pMem;
-  int64_t         freeSlot;
-  pthread_mutex_t vmutex;
-  uint64_t        count;  // kind of transcation ID
-  int64_t         notFreeSlots;
+  pthread_mutex_t vmutex;       // protect the commit status
+  uint64_t        count;        // kind of transcation ID
+  int64_t         notFreeSlots; // sum of all shards, updated atomically
   int64_t         threshold;
   char            commitInProcess;
   int             cacheBlockSize;
   int             cacheNumOfBlocks;
+  int32_t         numOfShards;
+  int32_t         blocksPerShard;
+  SCacheShard *   shards;
 } SCachePool;
 
+#define vnodeGetCacheShard(pPool, sid) (&((SCachePool *)(pPool))->shards[(sid) % ((SCachePool *)(pPool))->numOfShards])
+
+// the shard a cache block belongs to, the last shard also holds the remainder of the blocks
+#define vnodeGetBlockShard(pPool, index)                                                      \
+  (&((SCachePool *)(pPool))->shards[MIN((index) / ((SCachePool *)(pPool))->blocksPerShard, \
+                                        ((SCachePool *)(pPool))->numOfShards - 1)])
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TDENGINE_VNODECOMMITSCHED_H
+#define TDENGINE_VNODECOMMITSCHED_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// commits finished in 100ms, 1s, 10s, 60s, and longer
+#define TSDB_COMMIT_LATENCY_BUCKETS 5
+
+typedef struct {
+  int32_t queued;   // vnodes waiting for a worker
+  int32_t running;  // commits in process
+  int64_t commits;  // commits finished
+  int64_t waitUs;   // time spent by finished commits in the queue
+  int64_t latency[TSDB_COMMIT_LATENCY_BUCKETS];
+} SCommitSchedStat;
+
+/*
+ * Commits of all vnodes are run by a bounded pool of workers. The vnode with the highest cache pressure goes
+ * first, and at most maxCommitsPerDir commits write to the same data directory at a time. Compaction of a vnode
+ * is run by the workers as a commit is, so it is limited in the same way.
+ * numOfWorkers 0 keeps the old way, a commit thread is created for each commit.
+ */
+int32_t vnodeInitCommitScheduler(int32_t numOfWorkers, int32_t maxCommitsPerDir);
+
+void vnodeCleanUpCommitScheduler();
+
+bool vnodeCommitSchedulerEnabled();
+
+/* queue the commit of a vnode, pPool->vmutex of the vnode shall be held */
+int32_t vnodeScheduleCommit(int32_t vnode);
+
+/* queue the compaction of a vnode, pPool->vmutex of the vnode shall be held. The vnode is committed instead if
+ * data arrives before a worker takes it. */
+int32_t vnodeScheduleCompact(int32_t vnode);
+
+/* remove the vnode from the queue if its commit is not started yet, returns true if removed */
+bool vnodeUnscheduleCommit(int32_t vnode);
+
+void vnodeGetCommitSchedStat(SCommitSchedStat *pStat);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TDENGINE_VNODECOMMITSCHED_H
@@ -21,6 +21,7 @@ extern "C" {
 #endif
 
 #include "vnode.h"
+#include "vnodeFile.h"
 
 __filter_func_t *vnodeGetRangeFilterFuncArray(int32_t type);
 
@@ -28,6 +29,37 @@ __filter_func_t *vnodeGetValueFilterFuncArray(int32_t type);
 
 bool vnodeSupportPrefilter(int32_t type);
 
+/*
+ * calculate the prefixes of the min/max value and the bloom filter of a binary/nchar column into pField,
+ * pField->type and pField->bytes must be set.
+ */
+void vnodeSetStrFieldStatis(SField *pField, const char *data, int32_t numOfRows);
+
+/*
+ * check the =/like filter on a binary/nchar column against the statistics of the block in pField,
+ * returns false only if no value in the block can be qualified.
+ */
+bool vnodeStrPrefilter(SColumnFilterElem *pFilter, int16_t type, SField *pField);
+
+#define TSDB_BATCH_FILTER_NONE      0  // no value is qualified
+#define TSDB_BATCH_FILTER_RANGE     1  // value in [batchLowerBnd, batchUpperBnd]
+#define TSDB_BATCH_FILTER_NOT_EQUAL 2  // value != batchLowerBnd
+#define TSDB_BATCH_FILTER_EQUAL_EPS 3  // float value equals to batchLowerBndd within FLT_EPSILON
+#define TSDB_BATCH_FILTER_ROW       4  // binary and nchar, call fp for each row
+
+/*
+ * rewrite the filter, whose fp is already set, into the bounds used by vnodeBatchFilterData
+ */
+void vnodeInitBatchFilter(SColumnFilterElem *pFilter, int16_t type);
+
+/*
+ * evaluate all filters of the query over the rows [start, start + numOfRows) of pFilterInfo->pData column by column.
+ * pSel[i] is set to 1 if the row start + i is not null in all filter columns and qualified, otherwise 0.
+ *
+ * @return the number of qualified rows
+ */
+int32_t vnodeBatchFilterData(SQuery *pQuery, int32_t start, int32_t numOfRows, uint8_t *pSel);
+
 #ifdef __cplusplus
 }
 #endif
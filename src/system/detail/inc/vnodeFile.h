@@ -24,8 +24,20 @@ extern "C" {
 
 #define TSDB_VNODE_DELIMITER 0xF00AFA0F
 
+// last file is rewritten during commit only when it is twice as large as it was after last rewritten
+#define TSDB_MIN_LAST_FILE_REWRITE_SIZE (1024 * 1024)
+
+// data file is rewritten by compaction only when its dead space is larger than both its live blocks and this size
+#define TSDB_MIN_DATA_FILE_RECLAIM_SIZE (16 * 1024 * 1024)
+
 typedef struct { int64_t compInfoOffset; } SCompHeader;
 
+// version of the binary/nchar statistics in SField, 0 for blocks written before they were introduced
+#define TSDB_FIELD_STR_STATIS_VERSION 1
+
+// bits of the bloom filter of binary/nchar values in SField
+#define TSDB_FIELD_BLOOM_BITS 128
+
 typedef struct {
   short   colId;
   short   bytes;
@@ -34,11 +46,13 @@ typedef struct {
   int32_t offset : 24;
   int32_t len;  // data length
   int64_t sum;
-  int64_t max;
-  int64_t min;
+  int64_t max;  // for binary/nchar, the prefix of the max value
+  int64_t min;  // for binary/nchar, the prefix of the min value
   int16_t maxIndex;
   int16_t minIndex;
-  char    reserved[20];
+  uint8_t strStatisVer;  // TSDB_FIELD_STR_STATIS_VERSION if the binary/nchar statistics are available
+  char    reserved[3];
+  uint64_t bloom[TSDB_FIELD_BLOOM_BITS / 64];
 } SField;
 
 typedef struct {
@@ -72,6 +86,8 @@ typedef struct {
   int64_t    tempHeadOffset;
   int64_t    compInfoOffset;
   int64_t    oldCompBlockOffset;
+  int64_t    oldCompInfoOffset;
+  int64_t    oldCompInfoLen;  // including SCompInfo, comp blocks and checksum
 
   int64_t    oldNumOfBlocks;
   int64_t    newNumOfBlocks;
@@ -85,12 +101,16 @@ typedef struct {
   int        commitSlot;
   int32_t    last : 1;
   int32_t    changed : 1;
-  int32_t    commitPos : 30;
+  int32_t    copied : 1;  // comp info is copied from old head file as it is
+  int32_t    commitPos : 29;
   int64_t    commitCount;
   SCompBlock lastBlock;
 } SMeterInfo;
 
-typedef struct { int64_t totalStorage; } SVnodeHeadInfo;
+typedef struct {
+  int64_t totalStorage;
+  int64_t lastFileSize;  // size of last file when it was rewritten
+} SVnodeHeadInfo;
 
 #ifdef __cplusplus
 }
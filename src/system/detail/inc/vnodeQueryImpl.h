@@ -24,6 +24,7 @@ extern "C" {
 
 #include "hash.h"
 #include "hashutil.h"
+#include "vnodeBlockRead.h"
 
 #define GET_QINFO_ADDR(x) ((char*)(x)-offsetof(SQInfo, query))
 #define Q_STATUS_EQUAL(p, s) (((p) & (s)) != 0)
@@ -195,6 +196,23 @@ int32_t LoadDatablockOnDemand(SCompBlock* pBlock, SField** pFields, uint8_t* blk
                               int32_t fileIdx, int32_t slotIdx, __block_search_fn_t searchFn, bool onDemand);
 int32_t vnodeGetHeaderFile(SQueryRuntimeEnv* pRuntimeEnv, int32_t fileIndex);
 
+/*
+ * Blocks of current file read ahead for a super table query, in the order they are visited. It is filled before the
+ * reads are issued and not changed until the reader is closed.
+ */
+typedef struct SQueryBlockReadPlan {
+  SQuery*      pQuery;
+  int32_t      vnode;
+  int32_t      fileId;
+  int32_t      version;      // data file version, see SQueryFilesInfo
+  SCompBlock** pBlocks;
+  int8_t*      inRange;      // the block is entirely in the query time range
+  int8_t*      loadColumns;  // columns of the block are needed, besides its fields
+} SQueryBlockReadPlan;
+
+uint32_t vnodeGetFileBlockDataReq(SQueryRuntimeEnv* pRuntimeEnv, SCompBlock* pBlock);
+int32_t  vnodeGetBlockReadRanges(void* param, int32_t seq, const char* head, SBlockReadRange* pRanges);
+
 /**
  * Create SMeterQueryInfo.
  * The MeterQueryInfo is created one for each table during super table query
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TDENGINE_VNODEQUERYMEM_H
+#define TDENGINE_VNODEQUERYMEM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "tsched.h"
+
+typedef struct {
+  int64_t budget;    // bytes, 0 means unlimited
+  int64_t used;      // bytes reserved by running queries
+  int64_t peak;
+  int32_t queued;    // queries waiting for the budget
+  int64_t admitted;
+  int64_t rejected;  // queries over quota or timed out in the queue
+  int64_t spills;    // result buffers written back to disk since the budget is tight
+  int64_t spilledBytes;
+} SQueryMemStat;
+
+/*
+ * Queries of all vnodes reserve their memory from one budget of the dnode. A query is scheduled when its
+ * estimated memory fits in the budget, otherwise it waits in the queue in arrival order for at most waitTime
+ * milliseconds. A query whose estimate or usage exceeds quota is rejected.
+ * budget 0 means unlimited, quota 0 means no limit for a single query.
+ */
+int32_t vnodeInitQueryMemGovernor(int64_t budget, int64_t quota, int32_t waitTime);
+
+void vnodeCleanUpQueryMemGovernor();
+
+/* reserve the estimated memory of the query and schedule it on the query queue, or queue it until memory is released */
+void vnodeScheduleQuery(void *handle, SSchedMsg *pMsg);
+
+/* charge the memory allocated by a query or its scan task, the query is killed if its quota is exceeded */
+void vnodeChargeQueryMem(void *handle, int64_t bytes);
+
+/* release all memory reserved by a query or a scan task, and admit the queued queries that fit in the budget */
+void vnodeReleaseQueryMem(void *handle);
+
+/*
+ * a retrieve request of a query waiting for memory would block a query thread until the query is admitted or
+ * rejected, and the request freeing the query that holds the memory may wait behind it. It is parked with the
+ * query and scheduled after it instead. false is returned if the query is not waiting.
+ */
+bool vnodeParkQueryRetrieve(void *handle, SSchedMsg *pMsg);
+
+/* more than 80% of the budget is reserved, result buffers shall be spilled to disk */
+bool vnodeQueryMemIsTight();
+
+/*
+ * pages of the result buffer of a query are written back to disk. The bytes stay charged to the budget, since the
+ * pages are read back into memory when the results are merged or retrieved, they are only counted in the stat
+ */
+void vnodeCountSpilledQueryMem(void *handle, int64_t bytes);
+
+void vnodeGetQueryMemStat(SQueryMemStat *pStat);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TDENGINE_VNODEQUERYMEM_H
@@ -120,7 +120,10 @@ typedef struct SQueryFilesInfo {
   int32_t          headerFd;         // header file fd
   int64_t          headerFileSize;
   int32_t          dataFd;
+  int32_t          dataVersion;      // version of the data file opened, columns are cached under it
   int32_t          lastFd;
+  void*            pBlockReader;     // blocks of current file read ahead, NULL if blocks are read on demand
+  void*            pBlockReadPlan;   // what is read ahead from the blocks, see SQueryBlockReadPlan
 
   char headerFilePath[PATH_MAX];  // current opened header file name
   char dataFilePath[PATH_MAX];    // current opened data file name
@@ -249,8 +252,30 @@ typedef struct STableQuerySupportObj {
   SMeterDataInfo* pMeterDataInfo;
 
   TSKEY* tsList;
+
+  /*
+   * meters in [meterStart, meterEnd) of pMeterSidExtInfo are scanned by this object. The range is the whole
+   * list except for the scan tasks of a parallel super table query, see SSTableScanTasks.
+   */
+  int32_t meterStart;
+  int32_t meterEnd;
+  struct SSTableScanTasks* pScanTasks;
 } STableQuerySupportObj;
 
+/*
+ * The meter list of a super table query is split into tasks. The query thread and the helper threads scheduled
+ * on the query queue claim tasks one by one, and the partial result of each task is merged into the result of
+ * the query thread.
+ */
+typedef struct SSTableScanTasks {
+  pthread_mutex_t mutex;
+  pthread_cond_t  cond;
+  int32_t         numOfTasks;
+  int32_t         numOfMetersPerTask;
+  int32_t         nextTask;
+  int32_t         numOfCompleted;
+} SSTableScanTasks;
+
 typedef struct _qinfo {
   uint64_t       signature;
   int32_t        refCount;  // QInfo reference count, when the value is 0, it can be released safely
@@ -263,11 +288,14 @@ typedef struct _qinfo {
   int64_t        useconds;
   int            killed;
   struct _qinfo *prev, *next;
+  struct _qinfo *pParent;  // the query that a scan task belongs to
   SQuery         query;
   int            totalPoints;
   int            pointsRead;
   int            pointsReturned;
   int            pointsInterpo;
+  int            retrieveWindow;  // file blocks in each half of the result buffer of projection queries
+  int64_t        memUsage;        // bytes reserved from the query memory budget, see vnodeQueryMem.h
   int            code;
   char           bufIndex;
   char           changed;
@@ -288,6 +316,17 @@ bool vnodeParametersSafetyCheck(SQuery* pQuery);
 
 int32_t vnodeSTableQueryPrepare(SQInfo* pQInfo, SQuery* pQuery, void* param);
 
+/*
+ * create the object to scan meters in [meterStart, meterEnd) as a task of a prepared super table query,
+ * and merge its group results into the query when the scan is completed
+ */
+SQInfo* vnodeCreateSTableScanTask(SQInfo* pQInfo, int32_t meterStart, int32_t meterEnd);
+int32_t vnodeMergeSTableScanTask(SQInfo* pQInfo, SQInfo* pTask);
+void    vnodeFreeSTableScanTask(SQInfo* pTask);
+
+/* estimate the memory a query needs to run, reserved from the query memory budget when it is scheduled */
+int64_t vnodeEstimateQueryMem(SQInfo* pQInfo);
+
 /**
  * decrease the numofQuery of each table that is queried, enable the
  * remove/close operation can be executed
@@ -22,6 +22,9 @@
 #include "dnodeSystem.h"
 #include "httpSystem.h"
 #include "monitorSystem.h"
+#include "vnodeBlockCache.h"
+#include "vnodeCommitSched.h"
+#include "vnodeQueryMem.h"
 #include "tcrc32c.h"
 #include "tglobalcfg.h"
 #include "vnode.h"
@@ -36,6 +39,11 @@ bool            tsDnodeStopping = false;
 
 int  dnodeCheckConfig();
 void dnodeCountRequest(SCountInfo *info);
+void dnodeGetBlockCacheInfo(SBlockCacheInfo *info);
+void dnodeGetCommitSchedInfo(SCommitSchedInfo *info);
+void dnodeGetCommitInfo(SCommitInfo *info);
+void dnodeGetCompactInfo(SCompactInfo *info);
+void dnodeGetQueryMemInfo(SQueryMemInfo *info);
 
 void dnodeInitModules() {
   tsModule[TSDB_MOD_MGMT].name = "mgmt";
@@ -167,6 +175,11 @@ int dnodeInitSystem() {
   }
 
   monitorCountReqFp = dnodeCountRequest;
+  monitorBlockCacheFp = dnodeGetBlockCacheInfo;
+  monitorCommitSchedFp = dnodeGetCommitSchedInfo;
+  monitorCommitFp = dnodeGetCommitInfo;
+  monitorCompactFp = dnodeGetCompactInfo;
+  monitorQueryMemFp = dnodeGetQueryMemInfo;
 
   dnodeStartModuleSpec();
 
@@ -216,3 +229,80 @@ void dnodeCountRequest(SCountInfo *info) {
   info->selectReqNum = atomic_exchange_32(&vnodeSelectReqNum, 0);
   info->insertReqNum = atomic_exchange_32(&vnodeInsertReqNum, 0);
 }
+
+void dnodeGetBlockCacheInfo(SBlockCacheInfo *info) {
+  static SBlockCacheStat lastStat = {0};
+
+  SBlockCacheStat stat;
+  vnodeGetBlockCacheStat(&stat);
+
+  info->hits = stat.hits - lastStat.hits;
+  info->misses = stat.misses - lastStat.misses;
+  info->evictions = stat.evictions - lastStat.evictions;
+  info->cachedBytes = stat.cachedBytes;
+  lastStat = stat;
+}
+
+void dnodeGetCommitSchedInfo(SCommitSchedInfo *info) {
+  static SCommitSchedStat lastStat = {0};
+
+  SCommitSchedStat stat;
+  vnodeGetCommitSchedStat(&stat);
+
+  info->queued = stat.queued;
+  info->running = stat.running;
+  info->commits = stat.commits - lastStat.commits;
+  info->waitUs = stat.waitUs - lastStat.waitUs;
+  for (int32_t i = 0; i < TSDB_COMMIT_LATENCY_BUCKETS; ++i) {
+    info->latency[i] = stat.latency[i] - lastStat.latency[i];
+  }
+
+  lastStat = stat;
+}
+
+void dnodeGetCommitInfo(SCommitInfo *info) {
+  static SVnodeCommitStat lastStat = {0};
+
+  SVnodeCommitStat stat;
+  vnodeGetCommitStat(&stat);
+
+  info->commits = stat.commits - lastStat.commits;
+  info->blocks = stat.blocks - lastStat.blocks;
+  info->bytes = stat.bytes - lastStat.bytes;
+  info->useconds = stat.useconds - lastStat.useconds;
+  lastStat = stat;
+}
+
+void dnodeGetCompactInfo(SCompactInfo *info) {
+  static SVnodeCompactStat lastStat = {0};
+
+  SVnodeCompactStat stat;
+  vnodeGetCompactStat(&stat);
+
+  info->rounds = stat.rounds - lastStat.rounds;
+  info->meters = stat.meters - lastStat.meters;
+  info->srcBlocks = stat.srcBlocks - lastStat.srcBlocks;
+  info->dstBlocks = stat.dstBlocks - lastStat.dstBlocks;
+  info->srcBytes = stat.srcBytes - lastStat.srcBytes;
+  info->dstBytes = stat.dstBytes - lastStat.dstBytes;
+  info->reclaimedBytes = stat.reclaimedBytes - lastStat.reclaimedBytes;
+  info->useconds = stat.useconds - lastStat.useconds;
+  lastStat = stat;
+}
+
+void dnodeGetQueryMemInfo(SQueryMemInfo *info) {
+  static SQueryMemStat lastStat = {0};
+
+  SQueryMemStat stat;
+  vnodeGetQueryMemStat(&stat);
+
+  info->budget = stat.budget;
+  info->used = stat.used;
+  info->peak = stat.peak;
+  info->queued = stat.queued;
+  info->admitted = stat.admitted - lastStat.admitted;
+  info->rejected = stat.rejected - lastStat.rejected;
+  info->spills = stat.spills - lastStat.spills;
+  info->spilledBytes = stat.spilledBytes - lastStat.spilledBytes;
+  lastStat = stat;
+}
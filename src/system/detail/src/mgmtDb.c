@@ -119,7 +119,11 @@ SDbObj *mgmtGetDbByMeterId(char *meterId) {
   char db[TSDB_METER_ID_LEN], *pos;
 
   pos = strstr(meterId, TS_PATH_DELIMITER);
+  if (pos == NULL) return NULL;
+
   pos = strstr(pos + 1, TS_PATH_DELIMITER);
+  if (pos == NULL || pos - meterId >= TSDB_METER_ID_LEN) return NULL;
+
   memset(db, 0, sizeof(db));
   strncpy(db, meterId, pos - meterId);
 
@@ -138,8 +138,8 @@ static char *mgmtAllocMsg(SConnObj *pConn, int32_t size, char **pMsg, STaosRsp *
   return pStart;
 }
 
-static char *mgmtForMultiAllocMsg(SConnObj *pConn, int32_t size, char **pMsg, STaosRsp **pRsp) {
-  char *pStart = taosBuildRspMsgWithSize(pConn->thandle, TSDB_MSG_TYPE_MULTI_METERINFO_RSP, size);
+static char *mgmtForMultiAllocMsg(SConnObj *pConn, char rspType, int32_t size, char **pMsg, STaosRsp **pRsp) {
+  char *pStart = taosBuildRspMsgWithSize(pConn->thandle, rspType, size);
   if (pStart == NULL) return 0;
   *pMsg = pStart;
   *pRsp = (STaosRsp *)(*pMsg);
@@ -168,6 +168,17 @@ bool mgmtCheckMeterMetaMsgType(char *pMsg) {
   return addIntoTranQueue;
 }
 
+// the name of a table shall be in the form of the db name, a delimiter and a table name without delimiter
+static bool mgmtIsMeterIdInDb(char *meterId, SDbObj *pDb) {
+  size_t len = strlen(pDb->name);
+  if (strncmp(meterId, pDb->name, len) != 0 || meterId[len] != TS_PATH_DELIMITER[0]) {
+    return false;
+  }
+
+  char *name = meterId + len + 1;
+  return name[0] != 0 && strstr(name, TS_PATH_DELIMITER) == NULL;
+}
+
 int mgmtProcessMeterMetaMsg(char *pMsg, int msgLen, SConnObj *pConn) {
   SMeterInfoMsg *pInfo = (SMeterInfoMsg *)pMsg;
   STabObj *      pMeterObj = NULL;
@@ -208,6 +219,13 @@ int mgmtProcessMeterMetaMsg(char *pMsg, int msgLen, SConnObj *pConn) {
       return 0;
     }
 
+    pInfo->meterId[TSDB_METER_ID_LEN - 1] = 0;
+    if (!mgmtIsMeterIdInDb(pInfo->meterId, pDb)) {
+      mError("meter:%s, not in the db:%s of the connection", pInfo->meterId, pDb->name);
+      taosSendSimpleRsp(pConn->thandle, TSDB_MSG_TYPE_METERINFO_RSP, TSDB_CODE_INVALID_TABLE);
+      return 0;
+    }
+
     SCreateTableMsg *pCreateMsg = calloc(1, sizeof(SCreateTableMsg) + sizeof(STagData));
     if (pCreateMsg == NULL) {
       taosSendSimpleRsp(pConn->thandle, TSDB_MSG_TYPE_METERINFO_RSP, TSDB_CODE_SERV_OUT_OF_MEMORY);
@@ -217,11 +235,6 @@ int mgmtProcessMeterMetaMsg(char *pMsg, int msgLen, SConnObj *pConn) {
     memcpy(pCreateMsg->schema, pInfo->tags, sizeof(STagData));
     strcpy(pCreateMsg->meterId, pInfo->meterId);
 
-    SDbObj* pMeterDb = mgmtGetDbByMeterId(pCreateMsg->meterId);
-    mTrace("meter:%s, pConnDb:%p, pConnDbName:%s, pMeterDb:%p, pMeterDbName:%s",
-           pCreateMsg->meterId, pDb, pDb->name, pMeterDb, pMeterDb->name);
-    assert(pDb == pMeterDb);
-
     int32_t code = mgmtCreateMeter(pDb, pCreateMsg);
 
     char stableName[TSDB_METER_ID_LEN] = {0};
@@ -339,7 +352,7 @@ _exit_code:
  *                |                                                                                          |                       |
  *              pStart                                                                                   pCurMeter                 pTail
  **/
-int mgmtProcessMultiMeterMetaMsg(char *pMsg, int msgLen, SConnObj *pConn) {
+static int mgmtProcessMultiMeterMetaMsgImp(char *pMsg, int msgLen, SConnObj *pConn, char rspType) {
   SDbObj *          pDbObj    = NULL;
   STabObj *         pMeterObj = NULL;
   SVgObj *          pVgroup   = NULL;
@@ -355,8 +368,8 @@ int mgmtProcessMultiMeterMetaMsg(char *pMsg, int msgLen, SConnObj *pConn) {
   int size = 4*1024*1024; // first malloc 4 MB, subsequent reallocation as twice
 
   char *pNewMsg;
-  if ((pStart = mgmtForMultiAllocMsg(pConn, size, &pNewMsg, &pRsp)) == NULL) {
-    taosSendSimpleRsp(pConn->thandle, TSDB_MSG_TYPE_MULTI_METERINFO_RSP, TSDB_CODE_SERV_OUT_OF_MEMORY);
+  if ((pStart = mgmtForMultiAllocMsg(pConn, rspType, size, &pNewMsg, &pRsp)) == NULL) {
+    taosSendSimpleRsp(pConn->thandle, rspType, TSDB_CODE_SERV_OUT_OF_MEMORY);
     return 0;
   }
 
@@ -385,7 +398,7 @@ int mgmtProcessMultiMeterMetaMsg(char *pMsg, int msgLen, SConnObj *pConn) {
       if (NULL == pMsgHdr) {
         char* pTmp = pStart - sizeof(STaosHeader);
         tfree(pTmp);
-        taosSendSimpleRsp(pConn->thandle, TSDB_MSG_TYPE_MULTI_METERINFO_RSP, TSDB_CODE_SERV_OUT_OF_MEMORY);
+        taosSendSimpleRsp(pConn->thandle, rspType, TSDB_CODE_SERV_OUT_OF_MEMORY);
         break;
       }
 
@@ -493,6 +506,103 @@ _exit_code:
   return msgLen;
 }
 
+int mgmtProcessMultiMeterMetaMsg(char *pMsg, int msgLen, SConnObj *pConn) {
+  return mgmtProcessMultiMeterMetaMsgImp(pMsg, msgLen, pConn, TSDB_MSG_TYPE_MULTI_METERINFO_RSP);
+}
+
+/*
+ * tables that do not exist are created from their super tables in one transaction request, then the metas of all
+ * tables are returned like those of the multi meter meta msg. A table failed to create is left out of the response,
+ * the client creates it alone and gets the error then.
+ */
+int mgmtProcessMultiCreateMeterMetaMsg(char *pMsg, int msgLen, SConnObj *pConn) {
+  // write operation needs to redirect to master mnode
+  if (mgmtCheckRedirectMsg(pConn, TSDB_MSG_TYPE_MULTI_CREATE_METERINFO_RSP) != 0) {
+    return 0;
+  }
+
+  SMultiMeterInfoMsg *pInfo = (SMultiMeterInfoMsg *)pMsg;
+  int32_t             numOfMeters = htonl(pInfo->numOfMeters);
+
+  // names of the tables separated by comma, in the format of the multi meter meta msg
+  char *           pNames = calloc(1, sizeof(SMultiMeterInfoMsg) + (size_t)numOfMeters * TSDB_METER_ID_LEN + 1);
+  SCreateTableMsg *pCreateMsg = calloc(1, sizeof(SCreateTableMsg) + sizeof(STagData));
+  if (numOfMeters < 0 || pNames == NULL || pCreateMsg == NULL) {
+    tfree(pNames);
+    tfree(pCreateMsg);
+    taosSendSimpleRsp(pConn->thandle, TSDB_MSG_TYPE_MULTI_CREATE_METERINFO_RSP, TSDB_CODE_SERV_OUT_OF_MEMORY);
+    return 0;
+  }
+
+  // like the meter meta msg, tables are only created in the db of the connection
+  SDbObj *pDb = NULL;
+  if (pConn->pDb != NULL) pDb = mgmtGetDb(pConn->pDb->name);
+  if (pDb != NULL && pDb->dropStatus != TSDB_DB_STATUS_READY) pDb = NULL;
+
+  char *  str = pNames + sizeof(SMultiMeterInfoMsg);
+  char *  pCur = pMsg + sizeof(SMultiMeterInfoMsg);
+  int32_t numOfNames = 0, numOfCreated = 0;
+
+  for (int32_t i = 0; i < numOfMeters && pCur + sizeof(SMultiCreateMeterInfo) <= pMsg + msgLen; ++i) {
+    SMultiCreateMeterInfo *pMeter = (SMultiCreateMeterInfo *)pCur;
+    int16_t                tagLen = htons(pMeter->tagLen);
+
+    pCur += sizeof(SMultiCreateMeterInfo) + tagLen;
+    if (tagLen < 0 || tagLen > TSDB_MAX_TAGS_LEN || pCur > pMsg + msgLen) {
+      break;
+    }
+
+    pMeter->meterId[TSDB_METER_ID_LEN - 1] = 0;
+    pMeter->stableId[TSDB_METER_ID_LEN - 1] = 0;
+
+    if (mgmtGetMeter(pMeter->meterId) == NULL) {
+      // a table of another db is left out, the client creates it alone and gets the error then
+      if (!pConn->writeAuth || pDb == NULL || !mgmtIsMeterIdInDb(pMeter->meterId, pDb)) {
+        mTrace("meter:%s is not created by %s, no write auth or not in the db of the connection", pMeter->meterId,
+               pConn->pUser->user);
+        continue;
+      }
+
+      STagData *pTag = (STagData *)pCreateMsg->schema;
+      memset(pCreateMsg, 0, sizeof(SCreateTableMsg) + sizeof(STagData));
+      strcpy(pCreateMsg->meterId, pMeter->meterId);
+      strcpy(pTag->name, pMeter->stableId);
+      memcpy(pTag->data, pMeter->tags, (size_t)tagLen);
+
+      int32_t code = mgmtCreateMeter(pDb, pCreateMsg);
+      mTrace("meter:%s is automatically created by %s from %s, code:%d", pMeter->meterId, pConn->pUser->user,
+             pMeter->stableId, code);
+
+      // a vgroup is being created for the table, the request is sent again by the client and goes on from here
+      if (code == TSDB_CODE_ACTION_IN_PROGRESS) {
+        tfree(pNames);
+        tfree(pCreateMsg);
+        taosSendSimpleRsp(pConn->thandle, TSDB_MSG_TYPE_MULTI_CREATE_METERINFO_RSP, code);
+        return 0;
+      }
+
+      if (code != TSDB_CODE_SUCCESS) {
+        continue;
+      }
+
+      numOfCreated++;
+    }
+
+    str += sprintf(str, "%s,", pMeter->meterId);
+    numOfNames++;
+  }
+
+  ((SMultiMeterInfoMsg *)pNames)->numOfMeters = htonl(numOfNames);
+  mTrace("%d of %d meters are created by %s", numOfCreated, numOfMeters, pConn->pUser->user);
+
+  int ret = mgmtProcessMultiMeterMetaMsgImp(pNames, (int)(str - pNames), pConn,
+                                            TSDB_MSG_TYPE_MULTI_CREATE_METERINFO_RSP);
+  tfree(pNames);
+  tfree(pCreateMsg);
+
+  return ret;
+}
+
 int mgmtProcessMetricMetaMsg(char *pMsg, int msgLen, SConnObj *pConn) {
   SMetricMetaMsg *pMetricMetaMsg = (SMetricMetaMsg *)pMsg;
   STabObj *       pMetric;
@@ -1019,6 +1129,7 @@ int mgmtProcessRetrieveMsg(char *pMsg, int msgLen, SConnObj *pConn) {
 
     pRsp->numOfRows = htonl(rowsRead);
     pRsp->precision = htonl(TSDB_TIME_PRECISION_MILLI);  // millisecond time precision
+    pRsp->compressed = 0;
     pMsg += size;
   }
 
@@ -1490,6 +1601,7 @@ void mgmtInitProcessShellMsg() {
   mgmtProcessShellMsg[TSDB_MSG_TYPE_METERINFO] = mgmtProcessMeterMetaMsg;
   mgmtProcessShellMsg[TSDB_MSG_TYPE_METRIC_META] = mgmtProcessMetricMetaMsg;
   mgmtProcessShellMsg[TSDB_MSG_TYPE_MULTI_METERINFO] = mgmtProcessMultiMeterMetaMsg;
+  mgmtProcessShellMsg[TSDB_MSG_TYPE_MULTI_CREATE_METERINFO] = mgmtProcessMultiCreateMeterMetaMsg;
   mgmtProcessShellMsg[TSDB_MSG_TYPE_CREATE_DB] = mgmtProcessCreateDbMsg;
   mgmtProcessShellMsg[TSDB_MSG_TYPE_ALTER_DB] = mgmtProcessAlterDbMsg;
   mgmtProcessShellMsg[TSDB_MSG_TYPE_CREATE_USER] = mgmtProcessCreateUserMsg;
@@ -94,8 +94,8 @@ bool mgmtCheckIsMonitorDB(char *db, char *monitordb) {
 }
 
 int32_t mgmtCheckDBParams(SCreateDbMsg *pCreate) {
-  if (pCreate->commitLog < 0 || pCreate->commitLog > 1) {
-    mError("invalid db option commitLog: %d, only 0 or 1 allowed", pCreate->commitLog);
+  if (pCreate->commitLog < 0 || pCreate->commitLog > TSDB_COMMIT_LOG_SYNC) {
+    mError("invalid db option commitLog: %d, only 0, 1 or 2 allowed", pCreate->commitLog);
     return TSDB_CODE_INVALID_OPTION;
   }
   
@@ -0,0 +1,268 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _DEFAULT_SOURCE
+#include "os.h"
+
+#include "tlog.h"
+#include "tutil.h"
+#include "vnodeBlockCache.h"
+
+#define BLOCK_CACHE_SHARDS     16
+#define BLOCK_CACHE_SLOTS_BITS 12
+
+typedef struct SBlockCacheNode {
+  struct SBlockCacheNode *hnext;  // next node in hash slot
+  struct SBlockCacheNode *prev;   // lru list, head is the most recently used
+  struct SBlockCacheNode *next;
+  int64_t                 offset;
+  int32_t                 fileId;
+  int32_t                 version;  // version of the data file the column is read from
+  int16_t                 vnode;
+  int16_t                 colId;
+  int32_t                 size;
+  char                    data[];
+} SBlockCacheNode;
+
+typedef struct {
+  pthread_mutex_t   mutex;
+  int64_t           capacity;
+  int64_t           size;
+  int64_t           numOfChunks;
+  int64_t           hits;
+  int64_t           misses;
+  int64_t           evictions;
+  SBlockCacheNode  *hashList[1 << BLOCK_CACHE_SLOTS_BITS];
+  SBlockCacheNode   lru;  // sentinel
+} SBlockCacheShard;
+
+static SBlockCacheShard *blockCacheShards = NULL;
+static int64_t           blockCacheCapacity = 0;
+
+static uint32_t vnodeHashBlockCacheKey(int32_t vnode, int32_t fileId, int64_t offset, int16_t colId) {
+  uint64_t key = (uint64_t)offset * 0x9E3779B97F4A7C15ULL;
+  key ^= ((uint64_t)(uint32_t)fileId << 32) ^ ((uint64_t)(uint16_t)vnode << 16) ^ (uint16_t)colId;
+  key ^= key >> 29;
+  key *= 0xBF58476D1CE4E5B9ULL;
+  key ^= key >> 32;
+  return (uint32_t)key;
+}
+
+static void vnodeUnlinkBlockCacheNode(SBlockCacheShard *pShard, SBlockCacheNode *pNode) {
+  pNode->prev->next = pNode->next;
+  pNode->next->prev = pNode->prev;
+}
+
+static void vnodeLinkBlockCacheNode(SBlockCacheShard *pShard, SBlockCacheNode *pNode) {
+  pNode->next = pShard->lru.next;
+  pNode->prev = &pShard->lru;
+  pShard->lru.next->prev = pNode;
+  pShard->lru.next = pNode;
+}
+
+static void vnodeRemoveBlockCacheNode(SBlockCacheShard *pShard, SBlockCacheNode *pNode, uint32_t hash) {
+  SBlockCacheNode **ppNode = &pShard->hashList[hash & ((1 << BLOCK_CACHE_SLOTS_BITS) - 1)];
+  while (*ppNode != pNode) ppNode = &(*ppNode)->hnext;
+  *ppNode = pNode->hnext;
+
+  vnodeUnlinkBlockCacheNode(pShard, pNode);
+  pShard->size -= pNode->size;
+  pShard->numOfChunks--;
+  free(pNode);
+}
+
+static SBlockCacheNode *vnodeFindBlockCacheNode(SBlockCacheShard *pShard, uint32_t hash, int32_t vnode, int32_t fileId,
+                                                int32_t version, int64_t offset, int16_t colId) {
+  SBlockCacheNode *pNode = pShard->hashList[hash & ((1 << BLOCK_CACHE_SLOTS_BITS) - 1)];
+  while (pNode != NULL) {
+    if (pNode->offset == offset && pNode->fileId == fileId && pNode->vnode == vnode && pNode->colId == colId &&
+        pNode->version == version) {
+      return pNode;
+    }
+    pNode = pNode->hnext;
+  }
+
+  return NULL;
+}
+
+int32_t vnodeInitBlockCache(int64_t capacity) {
+  if (capacity <= 0) {
+    dPrint("block cache is disabled");
+    return 0;
+  }
+
+  blockCacheShards = calloc(BLOCK_CACHE_SHARDS, sizeof(SBlockCacheShard));
+  if (blockCacheShards == NULL) {
+    dError("failed to allocate block cache, reason:%s", strerror(errno));
+    return -1;
+  }
+
+  for (int32_t i = 0; i < BLOCK_CACHE_SHARDS; ++i) {
+    SBlockCacheShard *pShard = blockCacheShards + i;
+    pthread_mutex_init(&pShard->mutex, NULL);
+    pShard->capacity = capacity / BLOCK_CACHE_SHARDS;
+    pShard->lru.next = &pShard->lru;
+    pShard->lru.prev = &pShard->lru;
+  }
+
+  blockCacheCapacity = capacity;
+  dPrint("block cache is initialized, capacity:%" PRId64 " bytes", capacity);
+  return 0;
+}
+
+void vnodeCleanUpBlockCache() {
+  if (blockCacheShards == NULL) return;
+
+  for (int32_t i = 0; i < BLOCK_CACHE_SHARDS; ++i) {
+    SBlockCacheShard *pShard = blockCacheShards + i;
+    SBlockCacheNode * pNode = pShard->lru.next;
+    while (pNode != &pShard->lru) {
+      SBlockCacheNode *pNext = pNode->next;
+      free(pNode);
+      pNode = pNext;
+    }
+    pthread_mutex_destroy(&pShard->mutex);
+  }
+
+  tfree(blockCacheShards);
+  blockCacheCapacity = 0;
+}
+
+int32_t vnodeGetBlockCache(int32_t vnode, int32_t fileId, int32_t version, int64_t offset, int16_t colId, char *buf,
+                           int32_t size) {
+  if (blockCacheShards == NULL) return -1;
+
+  uint32_t          hash = vnodeHashBlockCacheKey(vnode, fileId, offset, colId);
+  SBlockCacheShard *pShard = blockCacheShards + (hash >> 28) % BLOCK_CACHE_SHARDS;
+
+  pthread_mutex_lock(&pShard->mutex);
+
+  SBlockCacheNode *pNode = vnodeFindBlockCacheNode(pShard, hash, vnode, fileId, version, offset, colId);
+  if (pNode == NULL || pNode->size != size) {
+    pShard->misses++;
+    pthread_mutex_unlock(&pShard->mutex);
+    return -1;
+  }
+
+  vnodeUnlinkBlockCacheNode(pShard, pNode);
+  vnodeLinkBlockCacheNode(pShard, pNode);
+  memcpy(buf, pNode->data, (size_t)size);
+  pShard->hits++;
+
+  pthread_mutex_unlock(&pShard->mutex);
+  return 0;
+}
+
+bool vnodeIsBlockCached(int32_t vnode, int32_t fileId, int32_t version, int64_t offset, int16_t colId) {
+  if (blockCacheShards == NULL) return false;
+
+  uint32_t          hash = vnodeHashBlockCacheKey(vnode, fileId, offset, colId);
+  SBlockCacheShard *pShard = blockCacheShards + (hash >> 28) % BLOCK_CACHE_SHARDS;
+
+  pthread_mutex_lock(&pShard->mutex);
+  bool cached = vnodeFindBlockCacheNode(pShard, hash, vnode, fileId, version, offset, colId) != NULL;
+  pthread_mutex_unlock(&pShard->mutex);
+
+  return cached;
+}
+
+void vnodePutBlockCache(int32_t vnode, int32_t fileId, int32_t version, int64_t offset, int16_t colId, const char *data,
+                        int32_t size) {
+  if (blockCacheShards == NULL || size <= 0) return;
+
+  uint32_t          hash = vnodeHashBlockCacheKey(vnode, fileId, offset, colId);
+  SBlockCacheShard *pShard = blockCacheShards + (hash >> 28) % BLOCK_CACHE_SHARDS;
+
+  // a column larger than a quarter of the shard would flush everything else out
+  if (size > pShard->capacity / 4) return;
+
+  SBlockCacheNode *pNew = malloc(sizeof(SBlockCacheNode) + size);
+  if (pNew == NULL) return;
+
+  pNew->vnode = (int16_t)vnode;
+  pNew->fileId = fileId;
+  pNew->version = version;
+  pNew->offset = offset;
+  pNew->colId = colId;
+  pNew->size = size;
+  memcpy(pNew->data, data, (size_t)size);
+
+  pthread_mutex_lock(&pShard->mutex);
+
+  // another query may have loaded the same column meanwhile
+  SBlockCacheNode *pNode = vnodeFindBlockCacheNode(pShard, hash, vnode, fileId, version, offset, colId);
+  if (pNode != NULL) {
+    vnodeRemoveBlockCacheNode(pShard, pNode, hash);
+  }
+
+  while (pShard->size + size > pShard->capacity && pShard->lru.prev != &pShard->lru) {
+    SBlockCacheNode *pTail = pShard->lru.prev;
+    vnodeRemoveBlockCacheNode(pShard, pTail,
+                              vnodeHashBlockCacheKey(pTail->vnode, pTail->fileId, pTail->offset, pTail->colId));
+    pShard->evictions++;
+  }
+
+  SBlockCacheNode **ppSlot = &pShard->hashList[hash & ((1 << BLOCK_CACHE_SLOTS_BITS) - 1)];
+  pNew->hnext = *ppSlot;
+  *ppSlot = pNew;
+  vnodeLinkBlockCacheNode(pShard, pNew);
+  pShard->size += size;
+  pShard->numOfChunks++;
+
+  pthread_mutex_unlock(&pShard->mutex);
+}
+
+void vnodeInvalidateBlockCache(int32_t vnode, int32_t fileId) {
+  if (blockCacheShards == NULL) return;
+
+  int64_t removed = 0;
+  for (int32_t i = 0; i < BLOCK_CACHE_SHARDS; ++i) {
+    SBlockCacheShard *pShard = blockCacheShards + i;
+
+    pthread_mutex_lock(&pShard->mutex);
+    SBlockCacheNode *pNode = pShard->lru.next;
+    while (pNode != &pShard->lru) {
+      SBlockCacheNode *pNext = pNode->next;
+      if (pNode->vnode == vnode && (fileId < 0 || pNode->fileId == fileId)) {
+        vnodeRemoveBlockCacheNode(pShard, pNode,
+                                  vnodeHashBlockCacheKey(pNode->vnode, pNode->fileId, pNode->offset, pNode->colId));
+        removed++;
+      }
+      pNode = pNext;
+    }
+    pthread_mutex_unlock(&pShard->mutex);
+  }
+
+  dTrace("vid:%d fileId:%d, %" PRId64 " cached columns are invalidated", vnode, fileId, removed);
+}
+
+void vnodeGetBlockCacheStat(SBlockCacheStat *pStat) {
+  memset(pStat, 0, sizeof(SBlockCacheStat));
+  if (blockCacheShards == NULL) return;
+
+  for (int32_t i = 0; i < BLOCK_CACHE_SHARDS; ++i) {
+    SBlockCacheShard *pShard = blockCacheShards + i;
+
+    pthread_mutex_lock(&pShard->mutex);
+    pStat->hits += pShard->hits;
+    pStat->misses += pShard->misses;
+    pStat->evictions += pShard->evictions;
+    pStat->numOfChunks += pShard->numOfChunks;
+    pStat->cachedBytes += pShard->size;
+    pthread_mutex_unlock(&pShard->mutex);
+  }
+
+  pStat->capacity = blockCacheCapacity;
+}
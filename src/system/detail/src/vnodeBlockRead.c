@@ -0,0 +1,667 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _DEFAULT_SOURCE
+#include "os.h"
+
+#include "tlog.h"
+#include "tsched.h"
+#include "tutil.h"
+#include "vnodeBlockRead.h"
+
+#if defined(LINUX) && defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define TSDB_USE_IO_URING
+#include <linux/io_uring.h>
+#endif
+
+// a slot has either its head or its ranges in flight, so the depth of a reader on io_uring is limited by the ring
+#define BLOCK_READ_RING_ENTRIES 256
+#define BLOCK_READ_MAX_READS    (TSDB_BLOCK_READ_MAX_RANGES + 1)
+#define BLOCK_READ_CANCEL_DATA  UINT64_MAX  // user_data of the requests to cancel reads of a broken ring
+
+enum {
+  BLOCK_READ_FREE = 0,
+  BLOCK_READ_INFLIGHT = 1,
+  BLOCK_READ_DONE = 2,
+};
+
+typedef struct {
+  int32_t         seq;          // request held by this slot
+  int32_t         status;
+  int32_t         code;         // 0, or -1 if any read of the request failed
+  int32_t         pending;      // reads issued to io_uring and not completed
+  int32_t         numOfReads;   // the head and the ranges after it
+  SBlockReadRange reads[BLOCK_READ_MAX_READS];
+  int32_t         pos[BLOCK_READ_MAX_READS];  // position of each read in buf
+  int32_t         capacity;
+  char *          buf;
+  struct iovec    iov[BLOCK_READ_MAX_READS];
+} SBlockReadSlot;
+
+typedef struct {
+  int       ringFd;
+  void *    sqRing;
+  size_t    sqRingSize;
+  void *    cqRing;
+  size_t    cqRingSize;
+  void *    sqes;
+  size_t    sqesSize;
+  uint32_t *sqHead;
+  uint32_t *sqTail;
+  uint32_t *sqMask;
+  uint32_t *sqArray;
+  uint32_t *cqHead;
+  uint32_t *cqTail;
+  uint32_t *cqMask;
+  void *    cqes;
+} SBlockReadRing;
+
+typedef struct {
+  int32_t                mode;
+  int32_t                depth;
+  int32_t                numOfReqs;
+  SBlockReadReq *        pReqs;
+  __block_read_next_fn_t fp;
+  void *                 param;
+  int32_t                submitted;  // requests before it have been issued
+  int32_t                released;   // requests before it are no longer needed by the caller
+  int32_t                current;    // the acquired request, -1 if none
+  int32_t                inflight;
+  int32_t                broken;     // io_uring failed, issued reads may never complete
+  int32_t *              batch;
+  SBlockReadSlot *       slots;
+  pthread_mutex_t        mutex;
+  pthread_cond_t         cond;
+  SBlockReadRing         ring;       // each reader has its own ring, so completions are never taken by another one
+} SBlockReader;
+
+static void *  blockReadQhandle = NULL;
+static int32_t blockReadURingUnavailable = 0;  // io_uring is not supported by the kernel, do not try again
+
+int32_t vnodeInitBlockReadPool(int32_t numOfThreads) {
+  if (numOfThreads <= 0) {
+    dPrint("block read pool is not initialized, asynchronous reads use io_uring only");
+    return 0;
+  }
+
+  int32_t maxQueueSize = numOfThreads * 256;
+  blockReadQhandle = taosInitScheduler(maxQueueSize, numOfThreads, "blockRead");
+  if (blockReadQhandle == NULL) {
+    dError("failed to init block read pool, threads:%d", numOfThreads);
+    return -1;
+  }
+
+  dTrace("block read pool initialized, max slot:%d, threads:%d", maxQueueSize, numOfThreads);
+  return 0;
+}
+
+void vnodeCleanUpBlockReadPool() {
+  if (blockReadQhandle != NULL) {
+    taosCleanUpScheduler(blockReadQhandle);
+    blockReadQhandle = NULL;
+  }
+}
+
+static int32_t vnodePreadBlock(int fd, char *buf, int32_t len, int64_t offset) {
+  int32_t nread = 0;
+  while (nread < len) {
+    ssize_t ret = pread(fd, buf + nread, (size_t)(len - nread), (off_t)(offset + nread));
+    if (ret < 0) {
+      if (errno == EINTR) continue;
+      return -errno;
+    }
+
+    if (ret == 0) break;
+    nread += (int32_t)ret;
+  }
+
+  return nread;
+}
+
+/*
+ * Ask the caller what to read after the head of the slot, and make room for it in the buffer. Returns -1 if the
+ * ranges are invalid or the buffer can not be enlarged.
+ */
+static int32_t vnodeSetBlockReadRanges(SBlockReader *pReader, SBlockReadSlot *pSlot) {
+  if (pReader->fp == NULL) return 0;
+
+  int32_t num = (*pReader->fp)(pReader->param, pSlot->seq, pSlot->buf, &pSlot->reads[1]);
+  if (num < 0 || num > TSDB_BLOCK_READ_MAX_RANGES) return -1;
+
+  int32_t size = pSlot->reads[0].len;
+  for (int32_t i = 1; i <= num; ++i) {
+    if (pSlot->reads[i].len <= 0) return -1;
+
+    pSlot->pos[i] = size;
+    size += pSlot->reads[i].len;
+  }
+
+  if (pSlot->capacity < size) {
+    char *buf = realloc(pSlot->buf, (size_t)size);
+    if (buf == NULL) return -1;
+
+    pSlot->buf = buf;
+    pSlot->capacity = size;
+  }
+
+  pSlot->numOfReads = num + 1;
+  return 0;
+}
+
+#ifdef TSDB_USE_IO_URING
+
+static int vnodeURingEnter(int ringFd, uint32_t toSubmit, uint32_t minComplete, uint32_t flags) {
+  return (int)syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, NULL, 0);
+}
+
+static void vnodeCloseURing(SBlockReadRing *pRing) {
+  if (pRing->sqes != NULL && pRing->sqes != MAP_FAILED) munmap(pRing->sqes, pRing->sqesSize);
+  if (pRing->cqRing != NULL && pRing->cqRing != MAP_FAILED) munmap(pRing->cqRing, pRing->cqRingSize);
+  if (pRing->sqRing != NULL && pRing->sqRing != MAP_FAILED) munmap(pRing->sqRing, pRing->sqRingSize);
+  if (pRing->ringFd >= 0) close(pRing->ringFd);
+
+  memset(pRing, 0, sizeof(SBlockReadRing));
+  pRing->ringFd = -1;
+}
+
+static int32_t vnodeOpenURing(SBlockReadRing *pRing, uint32_t entries) {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+
+  pRing->ringFd = (int)syscall(__NR_io_uring_setup, entries, &params);
+  if (pRing->ringFd < 0) {
+    dTrace("io_uring is not available, reason:%s", strerror(errno));
+    if (errno == ENOSYS || errno == EPERM) blockReadURingUnavailable = 1;
+    return -1;
+  }
+
+  pRing->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  pRing->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  pRing->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+
+  pRing->sqRing = mmap(NULL, pRing->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, pRing->ringFd,
+                       IORING_OFF_SQ_RING);
+  pRing->cqRing = mmap(NULL, pRing->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, pRing->ringFd,
+                       IORING_OFF_CQ_RING);
+  pRing->sqes = mmap(NULL, pRing->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, pRing->ringFd,
+                     IORING_OFF_SQES);
+  if (pRing->sqRing == MAP_FAILED || pRing->cqRing == MAP_FAILED || pRing->sqes == MAP_FAILED) {
+    dError("failed to map io_uring, reason:%s", strerror(errno));
+    vnodeCloseURing(pRing);
+    return -1;
+  }
+
+  pRing->sqHead = (uint32_t *)((char *)pRing->sqRing + params.sq_off.head);
+  pRing->sqTail = (uint32_t *)((char *)pRing->sqRing + params.sq_off.tail);
+  pRing->sqMask = (uint32_t *)((char *)pRing->sqRing + params.sq_off.ring_mask);
+  pRing->sqArray = (uint32_t *)((char *)pRing->sqRing + params.sq_off.array);
+  pRing->cqHead = (uint32_t *)((char *)pRing->cqRing + params.cq_off.head);
+  pRing->cqTail = (uint32_t *)((char *)pRing->cqRing + params.cq_off.tail);
+  pRing->cqMask = (uint32_t *)((char *)pRing->cqRing + params.cq_off.ring_mask);
+  pRing->cqes = (char *)pRing->cqRing + params.cq_off.cqes;
+
+  return 0;
+}
+
+static void vnodePrepareURingRead(SBlockReader *pReader, SBlockReadSlot *pSlot, int32_t index) {
+  SBlockReadRing *     pRing = &pReader->ring;
+  uint32_t             tail = *pRing->sqTail;
+  uint32_t             sqIndex = tail & *pRing->sqMask;
+  struct io_uring_sqe *sqe = (struct io_uring_sqe *)pRing->sqes + sqIndex;
+
+  pSlot->iov[index].iov_base = pSlot->buf + pSlot->pos[index];
+  pSlot->iov[index].iov_len = (size_t)pSlot->reads[index].len;
+  pSlot->pending++;
+
+  memset(sqe, 0, sizeof(struct io_uring_sqe));
+  sqe->opcode = IORING_OP_READV;
+  sqe->fd = pReader->pReqs[pSlot->seq].fd;
+  sqe->off = (uint64_t)pSlot->reads[index].offset;
+  sqe->addr = (uint64_t)(uintptr_t)&pSlot->iov[index];
+  sqe->len = 1;
+  sqe->user_data = (uint64_t)(pSlot - pReader->slots) * BLOCK_READ_MAX_READS + index;
+
+  pRing->sqArray[sqIndex] = sqIndex;
+  __atomic_store_n(pRing->sqTail, tail + 1, __ATOMIC_RELEASE);
+}
+
+static int32_t vnodeSubmitURing(SBlockReader *pReader, uint32_t toSubmit) {
+  while (toSubmit > 0) {
+    int ret = vnodeURingEnter(pReader->ring.ringFd, toSubmit, 0, 0);
+    if (ret < 0) {
+      if (errno == EINTR || errno == EAGAIN) continue;
+      dError("failed to submit %u block reads to io_uring, reason:%s", toSubmit, strerror(errno));
+      pReader->broken = 1;
+      return -1;
+    }
+
+    toSubmit -= (uint32_t)ret;
+  }
+
+  return 0;
+}
+
+static void vnodeFinishURingRead(SBlockReader *pReader, SBlockReadSlot *pSlot) {
+  pSlot->pending--;
+  if (pSlot->pending == 0) {
+    pSlot->status = BLOCK_READ_DONE;
+    pReader->inflight--;
+  }
+}
+
+/*
+ * A completed head is followed by the reads of its ranges, so a slot is done when all reads issued for it are
+ * completed and no more are needed.
+ */
+static int32_t vnodeReapURing(SBlockReader *pReader, int wait) {
+  SBlockReadRing *pRing = &pReader->ring;
+
+  while (1) {
+    uint32_t head = *pRing->cqHead;
+    uint32_t tail = __atomic_load_n(pRing->cqTail, __ATOMIC_ACQUIRE);
+
+    if (head == tail) {
+      if (!wait) return 0;
+
+      if (vnodeURingEnter(pRing->ringFd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+        dError("failed to wait for io_uring completions, reason:%s", strerror(errno));
+        pReader->broken = 1;
+        return -1;
+      }
+      continue;
+    }
+
+    uint32_t toSubmit = 0;
+    for (; head != tail; ++head) {
+      struct io_uring_cqe *cqe = (struct io_uring_cqe *)pRing->cqes + (head & *pRing->cqMask);
+      if (cqe->user_data == BLOCK_READ_CANCEL_DATA) continue;
+
+      SBlockReadSlot *pSlot = pReader->slots + cqe->user_data / BLOCK_READ_MAX_READS;
+      int32_t         index = (int32_t)(cqe->user_data % BLOCK_READ_MAX_READS);
+
+      // ranges of a broken ring are not issued, the slot is done when the reads in flight are completed
+      if (cqe->res != pSlot->reads[index].len || (index == 0 && pReader->broken)) {
+        pSlot->code = -1;
+      } else if (index == 0) {
+        if (vnodeSetBlockReadRanges(pReader, pSlot) < 0) {
+          pSlot->code = -1;
+        } else {
+          for (int32_t i = 1; i < pSlot->numOfReads; ++i) {
+            vnodePrepareURingRead(pReader, pSlot, i);
+            toSubmit++;
+          }
+        }
+      }
+
+      vnodeFinishURingRead(pReader, pSlot);
+    }
+
+    __atomic_store_n(pRing->cqHead, head, __ATOMIC_RELEASE);
+    return (toSubmit > 0) ? vnodeSubmitURing(pReader, toSubmit) : 0;
+  }
+}
+
+/*
+ * Reads of a broken ring may still be in flight, and the kernel writes into their iovecs and buffers until they are
+ * completed. Reads not taken by the kernel yet are withdrawn, the others are cancelled and waited for. Returns -1 if
+ * they cannot be waited for, the memory they use must not be freed then.
+ */
+static int32_t vnodeDrainURing(SBlockReader *pReader) {
+  SBlockReadRing *pRing = &pReader->ring;
+  uint32_t        entries = *pRing->sqMask + 1;
+
+  // the submission queue is only consumed in io_uring_enter, which is called by the reader alone
+  uint32_t head = __atomic_load_n(pRing->sqHead, __ATOMIC_ACQUIRE);
+  uint32_t tail = *pRing->sqTail;
+  for (uint32_t i = head; i != tail; ++i) {
+    struct io_uring_sqe *sqe = (struct io_uring_sqe *)pRing->sqes + pRing->sqArray[i & *pRing->sqMask];
+    SBlockReadSlot *     pSlot = pReader->slots + sqe->user_data / BLOCK_READ_MAX_READS;
+
+    pSlot->code = -1;
+    vnodeFinishURingRead(pReader, pSlot);
+  }
+  __atomic_store_n(pRing->sqTail, head, __ATOMIC_RELEASE);
+
+  // a read not in flight any more is not found by the cancel request, which is harmless
+  for (int32_t s = 0; s < pReader->depth && pReader->inflight > 0; ++s) {
+    SBlockReadSlot *pSlot = &pReader->slots[s];
+    if (pSlot->status != BLOCK_READ_INFLIGHT) continue;
+
+    for (int32_t index = 0; index < pSlot->numOfReads; ++index) {
+      tail = *pRing->sqTail;
+      if (tail - __atomic_load_n(pRing->sqHead, __ATOMIC_ACQUIRE) >= entries) {
+        if (vnodeURingEnter(pRing->ringFd, entries, 0, 0) < 0) break;
+        tail = *pRing->sqTail;
+      }
+
+      uint32_t             sqIndex = tail & *pRing->sqMask;
+      struct io_uring_sqe *sqe = (struct io_uring_sqe *)pRing->sqes + sqIndex;
+
+      memset(sqe, 0, sizeof(struct io_uring_sqe));
+      sqe->opcode = IORING_OP_ASYNC_CANCEL;
+      sqe->fd = -1;
+      sqe->addr = (uint64_t)(pSlot - pReader->slots) * BLOCK_READ_MAX_READS + index;
+      sqe->user_data = BLOCK_READ_CANCEL_DATA;
+
+      pRing->sqArray[sqIndex] = sqIndex;
+      __atomic_store_n(pRing->sqTail, tail + 1, __ATOMIC_RELEASE);
+    }
+  }
+
+  // reads complete by themselves even if they cannot be cancelled, cancel requests not submitted are withdrawn
+  head = __atomic_load_n(pRing->sqHead, __ATOMIC_ACQUIRE);
+  if (head != *pRing->sqTail && vnodeURingEnter(pRing->ringFd, *pRing->sqTail - head, 0, 0) < 0) {
+    __atomic_store_n(pRing->sqTail, head, __ATOMIC_RELEASE);
+  }
+
+  while (pReader->inflight > 0) {
+    if (vnodeReapURing(pReader, 1) < 0) {
+      dError("failed to wait for %d block reads of a broken io_uring", pReader->inflight);
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+#else
+
+static void vnodeCloseURing(SBlockReadRing *pRing) { pRing->ringFd = -1; }
+
+static int32_t vnodeOpenURing(SBlockReadRing *pRing, uint32_t entries) { return -1; }
+
+static void vnodePrepareURingRead(SBlockReader *pReader, SBlockReadSlot *pSlot, int32_t index) {}
+
+static int32_t vnodeSubmitURing(SBlockReader *pReader, uint32_t toSubmit) { return -1; }
+
+static int32_t vnodeReapURing(SBlockReader *pReader, int wait) { return -1; }
+
+static int32_t vnodeDrainURing(SBlockReader *pReader) { return -1; }
+
+#endif
+
+static void vnodeProcessBlockRead(SSchedMsg *pMsg) {
+  SBlockReader *  pReader = (SBlockReader *)pMsg->ahandle;
+  SBlockReadSlot *pSlot = (SBlockReadSlot *)pMsg->thandle;
+  int             fd = pReader->pReqs[pSlot->seq].fd;
+
+  int32_t code = 0;
+  for (int32_t i = 0; i < pSlot->numOfReads && code == 0; ++i) {
+    SBlockReadRange *pRead = &pSlot->reads[i];
+    if (vnodePreadBlock(fd, pSlot->buf + pSlot->pos[i], pRead->len, pRead->offset) != pRead->len) {
+      code = -1;
+    } else if (i == 0 && vnodeSetBlockReadRanges(pReader, pSlot) < 0) {
+      code = -1;
+    }
+  }
+
+  pthread_mutex_lock(&pReader->mutex);
+  pSlot->code = code;
+  pSlot->status = BLOCK_READ_DONE;
+  pReader->inflight--;
+  pthread_cond_broadcast(&pReader->cond);
+  pthread_mutex_unlock(&pReader->mutex);
+}
+
+static int32_t vnodeWaitBlockReadSlot(SBlockReader *pReader, SBlockReadSlot *pSlot) {
+  if (pReader->mode == TSDB_BLOCK_READ_URING) {
+    while (pSlot->status == BLOCK_READ_INFLIGHT) {
+      if (pReader->broken) return -1;
+      if (vnodeReapURing(pReader, 1) < 0) return -1;
+    }
+    return 0;
+  }
+
+  pthread_mutex_lock(&pReader->mutex);
+  while (pSlot->status == BLOCK_READ_INFLIGHT) {
+    pthread_cond_wait(&pReader->cond, &pReader->mutex);
+  }
+  pthread_mutex_unlock(&pReader->mutex);
+
+  return 0;
+}
+
+static void vnodeSortBlockReadBatch(SBlockReader *pReader, int32_t num) {
+  for (int32_t i = 1; i < num; ++i) {
+    int32_t seq = pReader->batch[i];
+    int32_t j = i - 1;
+
+    while (j >= 0) {
+      SBlockReadReq *pPrev = &pReader->pReqs[pReader->batch[j]];
+      SBlockReadReq *pCur = &pReader->pReqs[seq];
+      if (pPrev->fd < pCur->fd || (pPrev->fd == pCur->fd && pPrev->offset <= pCur->offset)) break;
+
+      pReader->batch[j + 1] = pReader->batch[j];
+      --j;
+    }
+    pReader->batch[j + 1] = seq;
+  }
+}
+
+/*
+ * Issue requests that fit in the read window. Unless the caller is waiting for a request that has not been issued,
+ * wait until half of the window is free, so that each batch sorted by offset is long enough to be worth it.
+ */
+static int32_t vnodeFillBlockReadWindow(SBlockReader *pReader, int force) {
+  int32_t end = pReader->released + pReader->depth;
+  if (end > pReader->numOfReqs) end = pReader->numOfReqs;
+
+  int32_t num = end - pReader->submitted;
+  if (num <= 0) return 0;
+  if (!force && num < pReader->depth / 2 && end < pReader->numOfReqs) return 0;
+
+  for (int32_t i = 0; i < num; ++i) {
+    pReader->batch[i] = pReader->submitted + i;
+  }
+  vnodeSortBlockReadBatch(pReader, num);
+
+  uint32_t toSubmit = 0;
+  for (int32_t i = 0; i < num; ++i) {
+    int32_t         seq = pReader->batch[i];
+    SBlockReadReq * pReq = &pReader->pReqs[seq];
+    SBlockReadSlot *pSlot = &pReader->slots[seq % pReader->depth];
+
+    // slot is still held by a request the caller skipped
+    if (vnodeWaitBlockReadSlot(pReader, pSlot) < 0) return -1;
+
+    pSlot->seq = seq;
+    pSlot->code = 0;
+    pSlot->pending = 0;
+    pSlot->numOfReads = 0;
+
+    // nothing of the request is needed, the caller reads it by itself if it turns out to be
+    if (pReq->len <= 0 || pReq->fd < 0) {
+      pSlot->status = BLOCK_READ_DONE;
+      continue;
+    }
+
+    if (pSlot->capacity < pReq->len) {
+      char *buf = realloc(pSlot->buf, (size_t)pReq->len);
+      if (buf == NULL) {
+        pSlot->status = BLOCK_READ_DONE;
+        continue;
+      }
+      pSlot->buf = buf;
+      pSlot->capacity = pReq->len;
+    }
+
+    pSlot->reads[0].offset = pReq->offset;
+    pSlot->reads[0].len = pReq->len;
+    pSlot->pos[0] = 0;
+    pSlot->numOfReads = 1;
+
+    pthread_mutex_lock(&pReader->mutex);
+    pSlot->status = BLOCK_READ_INFLIGHT;
+    pReader->inflight++;
+    pthread_mutex_unlock(&pReader->mutex);
+
+    if (pReader->mode == TSDB_BLOCK_READ_URING) {
+      vnodePrepareURingRead(pReader, pSlot, 0);
+      toSubmit++;
+    } else {
+      SSchedMsg schedMsg = {0};
+      schedMsg.fp = vnodeProcessBlockRead;
+      schedMsg.ahandle = pReader;
+      schedMsg.thandle = pSlot;
+      taosScheduleTask(blockReadQhandle, &schedMsg);
+    }
+  }
+
+  pReader->submitted = end;
+
+  if (toSubmit > 0) {
+    return vnodeSubmitURing(pReader, toSubmit);
+  }
+
+  return 0;
+}
+
+void *vnodeOpenBlockReader(SBlockReadReq *pReqs, int32_t numOfReqs, int32_t depth, int32_t mode,
+                           __block_read_next_fn_t fp, void *param) {
+  if (mode == TSDB_BLOCK_READ_SYNC || numOfReqs <= 0 || depth <= 0) {
+    return NULL;
+  }
+
+  SBlockReader *pReader = calloc(1, sizeof(SBlockReader));
+  if (pReader == NULL) return NULL;
+
+  pReader->ring.ringFd = -1;
+  if (mode == TSDB_BLOCK_READ_URING) {
+    if (blockReadURingUnavailable || vnodeOpenURing(&pReader->ring, BLOCK_READ_RING_ENTRIES) < 0) {
+      mode = TSDB_BLOCK_READ_POOL;
+    } else if (depth > BLOCK_READ_RING_ENTRIES / TSDB_BLOCK_READ_MAX_RANGES) {
+      depth = BLOCK_READ_RING_ENTRIES / TSDB_BLOCK_READ_MAX_RANGES;
+    }
+  }
+
+  if (mode == TSDB_BLOCK_READ_POOL && blockReadQhandle == NULL) {
+    free(pReader);
+    return NULL;
+  }
+
+  if (depth > numOfReqs) depth = numOfReqs;
+
+  pReader->mode = mode;
+  pReader->depth = depth;
+  pReader->numOfReqs = numOfReqs;
+  pReader->fp = fp;
+  pReader->param = param;
+  pReader->current = -1;
+  pReader->pReqs = malloc(sizeof(SBlockReadReq) * numOfReqs);
+  pReader->batch = malloc(sizeof(int32_t) * depth);
+  pReader->slots = calloc((size_t)depth, sizeof(SBlockReadSlot));
+  pthread_mutex_init(&pReader->mutex, NULL);
+  pthread_cond_init(&pReader->cond, NULL);
+
+  if (pReader->pReqs == NULL || pReader->batch == NULL || pReader->slots == NULL) {
+    vnodeCloseBlockReader(pReader);
+    return NULL;
+  }
+
+  memcpy(pReader->pReqs, pReqs, sizeof(SBlockReadReq) * numOfReqs);
+  for (int32_t i = 0; i < depth; ++i) {
+    pReader->slots[i].seq = -1;
+  }
+
+  if (vnodeFillBlockReadWindow(pReader, 1) < 0) {
+    vnodeCloseBlockReader(pReader);
+    return NULL;
+  }
+
+  return pReader;
+}
+
+int32_t vnodeAcquireBlockRead(void *handle, int32_t seq) {
+  SBlockReader *pReader = (SBlockReader *)handle;
+  if (pReader == NULL || seq < pReader->released || seq >= pReader->numOfReqs) {
+    return -1;
+  }
+
+  pReader->released = seq;
+  pReader->current = -1;
+
+  if (pReader->mode == TSDB_BLOCK_READ_URING && vnodeReapURing(pReader, 0) < 0) return -1;
+  if (vnodeFillBlockReadWindow(pReader, seq >= pReader->submitted) < 0) return -1;
+
+  SBlockReadSlot *pSlot = &pReader->slots[seq % pReader->depth];
+  assert(pSlot->seq == seq);
+
+  if (vnodeWaitBlockReadSlot(pReader, pSlot) < 0) return -1;
+
+  pReader->current = seq;
+  return pSlot->code;
+}
+
+int32_t vnodeCopyFromBlockRead(void *handle, int fd, int64_t offset, char *buf, int32_t size) {
+  SBlockReader *pReader = (SBlockReader *)handle;
+  if (pReader == NULL || pReader->current < 0) return -1;
+
+  SBlockReadSlot *pSlot = &pReader->slots[pReader->current % pReader->depth];
+  if (pSlot->code != 0 || fd != pReader->pReqs[pReader->current].fd) {
+    return -1;
+  }
+
+  for (int32_t i = 0; i < pSlot->numOfReads; ++i) {
+    SBlockReadRange *pRead = &pSlot->reads[i];
+    if (offset >= pRead->offset && offset + size <= pRead->offset + pRead->len) {
+      memcpy(buf, pSlot->buf + pSlot->pos[i] + (offset - pRead->offset), (size_t)size);
+      return 0;
+    }
+  }
+
+  return -1;
+}
+
+int32_t vnodeGetBlockReadMode(void *handle) {
+  SBlockReader *pReader = (SBlockReader *)handle;
+  return (pReader == NULL) ? TSDB_BLOCK_READ_SYNC : pReader->mode;
+}
+
+void vnodeCloseBlockReader(void *handle) {
+  SBlockReader *pReader = (SBlockReader *)handle;
+  if (pReader == NULL) return;
+
+  // buffers and iovecs can only be freed after all issued reads are completed
+  int32_t drained = 1;
+  if (pReader->mode == TSDB_BLOCK_READ_URING) {
+    while (pReader->inflight > 0 && !pReader->broken) {
+      if (vnodeReapURing(pReader, 1) < 0) break;
+    }
+
+    if (pReader->inflight > 0 && vnodeDrainURing(pReader) < 0) drained = 0;
+    vnodeCloseURing(&pReader->ring);
+  } else {
+    pthread_mutex_lock(&pReader->mutex);
+    while (pReader->inflight > 0) {
+      pthread_cond_wait(&pReader->cond, &pReader->mutex);
+    }
+    pthread_mutex_unlock(&pReader->mutex);
+  }
+
+  // the kernel may still write into reads that cannot be waited for, leak them rather than reuse freed memory
+  if (pReader->slots != NULL && drained) {
+    for (int32_t i = 0; i < pReader->depth; ++i) {
+      tfree(pReader->slots[i].buf);
+    }
+    tfree(pReader->slots);
+  }
+
+  pthread_mutex_destroy(&pReader->mutex);
+  pthread_cond_destroy(&pReader->cond);
+
+  tfree(pReader->batch);
+  tfree(pReader->pReqs);
+  free(pReader);
+}
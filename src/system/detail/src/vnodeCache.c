@@ -19,11 +19,56 @@
 #include "taosmsg.h"
 #include "vnode.h"
 #include "vnodeCache.h"
+#include "vnodeCommitSched.h"
 #include "vnodeUtil.h"
 #include "vnodeStatus.h"
 
 void vnodeSearchPointInCache(SMeterObj *pObj, SQuery *pQuery);
 void vnodeProcessCommitTimer(void *param, void *tmrId);
+static int32_t vnodeWaitForCommitComplete(SVnodeObj *pVnode);
+
+static int32_t vnodeGetNumOfCacheShards(SVnodeCfg *pCfg) {
+  // each shard shall be able to hold all the cache blocks of at least two meters
+  int32_t numOfShards = pCfg->cacheNumOfBlocks.totalBlocks / (pCfg->blocksPerMeter * 2);
+
+  numOfShards = MIN(numOfShards, (tsCacheShards > 0) ? tsCacheShards : tsNumOfCores);
+  numOfShards = MIN(numOfShards, TSDB_MAX_CACHE_SHARDS);
+
+  return (numOfShards < 1) ? 1 : numOfShards;
+}
+
+static int vnodeInitCacheShards(SCachePool *pCachePool, SVnodeCfg *pCfg) {
+  int32_t numOfShards = vnodeGetNumOfCacheShards(pCfg);
+  int32_t blocksPerShard = pCfg->cacheNumOfBlocks.totalBlocks / numOfShards;
+
+  pCachePool->shards = (SCacheShard *)calloc(numOfShards, sizeof(SCacheShard));
+  if (pCachePool->shards == NULL) {
+    return -1;
+  }
+
+  for (int32_t i = 0; i < numOfShards; ++i) {
+    SCacheShard *pShard = &pCachePool->shards[i];
+
+    pShard->startBlock = i * blocksPerShard;
+    pShard->numOfBlocks = (i == numOfShards - 1) ? (pCfg->cacheNumOfBlocks.totalBlocks - pShard->startBlock)
+                                                 : blocksPerShard;
+    pShard->threshold = pShard->numOfBlocks * 0.6;
+    pthread_mutex_init(&pShard->mutex, NULL);
+  }
+
+  pCachePool->numOfShards = numOfShards;
+  pCachePool->blocksPerShard = blocksPerShard;
+  return 0;
+}
+
+static void vnodeCleanupCacheShards(SCachePool *pCachePool) {
+  for (int32_t i = 0; i < pCachePool->numOfShards; ++i) {
+    pthread_mutex_destroy(&pCachePool->shards[i].mutex);
+  }
+
+  pCachePool->numOfShards = 0;
+  tfree(pCachePool->shards);
+}
 
 void *vnodeOpenCachePool(int vnode) {
   SCachePool *pCachePool;
@@ -78,12 +123,18 @@ void *vnodeOpenCachePool(int vnode) {
     }
   }
 
-  dPrint("vid:%d, cache pool is allocated:0x%x", vnode, pCachePool);
+  if (vnodeInitCacheShards(pCachePool, pCfg) < 0) {
+    dError("vid:%d, no memory to allocate cache shards", vnode);
+    goto _err_exit;
+  }
+
+  dPrint("vid:%d, cache pool is allocated:0x%x, shards:%d", vnode, pCachePool, pCachePool->numOfShards);
 
   return pCachePool;
 
 _err_exit:
   pthread_mutex_destroy(&(pCachePool->vmutex));
+  vnodeCleanupCacheShards(pCachePool);
   // TODO : Free the cache blocks and return
   blockId = 0;
   while (blockId < pCfg->cacheNumOfBlocks.totalBlocks) {
@@ -101,7 +152,24 @@ void vnodeCloseCachePool(int vnode) {
   int         blockId = 0;
 
   taosTmrStopA(&pVnode->commitTimer);
-  if (pVnode->commitInProcess) pthread_cancel(pVnode->commitThread);
+  taosTmrStopA(&pVnode->compactTimer);
+  if (vnodeCommitSchedulerEnabled()) {
+    // a queued job is not started yet, it is dropped rather than run on a freed pool
+    pthread_mutex_lock(&pCachePool->vmutex);
+    if (vnodeUnscheduleCommit(vnode)) pCachePool->commitInProcess = 0;
+    pthread_mutex_unlock(&pCachePool->vmutex);
+
+    // workers are shared by all vnodes and cannot be cancelled, meters are dropped so the commit ends soon
+    if (vnodeWaitForCommitComplete(pVnode) < 0) {
+      dError("vid:%d, commit is not over in time, cache pool is not freed", vnode);
+      return;
+    }
+
+    // the timer is set again when the commit is over
+    taosTmrStopA(&pVnode->commitTimer);
+  } else if (pVnode->commitInProcess) {
+    pthread_cancel(pVnode->commitThread);
+  }
 
   dPrint("vid:%d, cache pool closed, count:%d", vnode, pCachePool->count);
 
@@ -112,6 +180,7 @@ void vnodeCloseCachePool(int vnode) {
   }
   tfree(pCachePool->pMem);
   pthread_mutex_destroy(&(pCachePool->vmutex));
+  vnodeCleanupCacheShards(pCachePool);
   tfree(pCachePool);
   pVnode->pCachePool = NULL;
 }
@@ -172,7 +241,8 @@ int vnodeFreeCacheBlock(SCacheBlock *pCacheBlock) {
 
     SCachePool *pPool = (SCachePool *)vnodeList[pObj->vnode].pCachePool;
     if (pCacheBlock->notFree) {
-      pPool->notFreeSlots--;
+      atomic_sub_fetch_32(&vnodeGetBlockShard(pPool, pCacheBlock->index)->notFreeSlots, 1);
+      atomic_sub_fetch_64(&pPool->notFreeSlots, 1);
       pInfo->unCommittedBlocks--;
       dTrace("vid:%d sid:%d id:%s, cache block is not free, slot:%d, index:%d notFreeSlots:%d",
              pObj->vnode, pObj->sid, pObj->meterId, pCacheBlock->slot, pCacheBlock->index, pPool->notFreeSlots);
@@ -182,7 +252,10 @@ int vnodeFreeCacheBlock(SCacheBlock *pCacheBlock) {
            pObj->vnode, pObj->sid, pObj->meterId, pInfo->numOfBlocks, pCacheBlock->slot, pCacheBlock->index,
            pPool->notFreeSlots);
 
-    memset(pCacheBlock, 0, sizeof(SCacheBlock));
+    // a block whose blockId is 0 may be taken at once by a writer holding the mutex of its shard only
+    memset(pCacheBlock, 0, offsetof(SCacheBlock, blockId));
+    pCacheBlock->pMeterObj = NULL;
+    atomic_store_64(&pCacheBlock->blockId, 0);
 
   } else {
     dError("BUG, pObj is null");
@@ -195,6 +268,7 @@ void vnodeFreeCacheInfo(SMeterObj *pObj) {
   SCacheInfo * pInfo;
   SCacheBlock *pCacheBlock;
   SCachePool * pPool;
+  SCacheShard *pShard;
   int          slot, numOfBlocks;
 
   if (pObj == NULL || pObj->pCache == NULL) return;
@@ -203,7 +277,8 @@ void vnodeFreeCacheInfo(SMeterObj *pObj) {
   pInfo = (SCacheInfo *)pObj->pCache;
   if (pPool == NULL || pInfo == NULL) return;
 
-  pthread_mutex_lock(&pPool->vmutex);
+  pShard = vnodeGetCacheShard(pPool, pObj->sid);
+  pthread_mutex_lock(&pShard->mutex);
   numOfBlocks = pInfo->numOfBlocks;
   slot = pInfo->currentSlot;
 
@@ -216,7 +291,7 @@ void vnodeFreeCacheInfo(SMeterObj *pObj) {
   pObj->pCache = NULL;
   tfree(pInfo->cacheBlocks);
   tfree(pInfo);
-  pthread_mutex_unlock(&pPool->vmutex);
+  pthread_mutex_unlock(&pShard->mutex);
 }
 
 uint64_t vnodeGetPoolCount(SVnodeObj *pVnode) {
@@ -231,9 +306,11 @@ void vnodeUpdateCommitInfo(SMeterObj *pObj, int slot, int pos, uint64_t count) {
   SCacheInfo * pInfo;
   SCacheBlock *pBlock;
   SCachePool * pPool;
+  SCacheShard *pShard;
 
   pInfo = (SCacheInfo *)pObj->pCache;
   pPool = (SCachePool *)vnodeList[pObj->vnode].pCachePool;
+  pShard = vnodeGetCacheShard(pPool, pObj->sid);
 
   int tslot =
       (pInfo->commitPoint == pObj->pointsPerBlock) ? (pInfo->commitSlot + 1) % pInfo->maxBlocks : pInfo->commitSlot;
@@ -241,13 +318,14 @@ void vnodeUpdateCommitInfo(SMeterObj *pObj, int slot, int pos, uint64_t count) {
 
   while (tslot != slot || ((tslot == slot) && (pos == pObj->pointsPerBlock))) {
     slots++;
-    pthread_mutex_lock(&pPool->vmutex);
+    pthread_mutex_lock(&pShard->mutex);
     pBlock = pInfo->cacheBlocks[tslot];
     assert(pBlock->notFree);
     pBlock->notFree = 0;
     pInfo->unCommittedBlocks--;
-    pPool->notFreeSlots--;
-    pthread_mutex_unlock(&pPool->vmutex);
+    atomic_sub_fetch_32(&vnodeGetBlockShard(pPool, pBlock->index)->notFreeSlots, 1);
+    atomic_sub_fetch_64(&pPool->notFreeSlots, 1);
+    pthread_mutex_unlock(&pShard->mutex);
 
     dTrace("vid:%d sid:%d id:%s, cache block is committed, slot:%d, index:%d notFreeSlots:%d, unCommittedBlocks:%d",
            pObj->vnode, pObj->sid, pObj->meterId, pBlock->slot, pBlock->index, pPool->notFreeSlots,
@@ -304,6 +382,11 @@ pthread_t vnodeCreateCommitThread(SVnodeObj *pVnode) {
     return pVnode->commitThread;
   }
 
+  if (vnodeCommitSchedulerEnabled()) {
+    if (vnodeScheduleCommit(pVnode->vnode) == 0) pPool->commitInProcess = 1;
+    return pVnode->commitThread;
+  }
+
   pthread_attr_init(&thattr);
   pthread_attr_setdetachstate(&thattr, PTHREAD_CREATE_DETACHED);
   if (pthread_create(&(pVnode->commitThread), &thattr, vnodeCommitToFile, pVnode) != 0) {
@@ -342,11 +425,12 @@ void vnodeCommitOver(SVnodeObj *pVnode) {
   pthread_mutex_unlock(&pPool->vmutex);
 }
 
-static void vnodeWaitForCommitComplete(SVnodeObj *pVnode) {
+// returns -1 if the commit is still in process after the wait
+static int32_t vnodeWaitForCommitComplete(SVnodeObj *pVnode) {
   SCachePool *pPool = (SCachePool *)(pVnode->pCachePool);
 
   // wait for 100s at most
-  const int32_t totalCount = 1000;
+  const int32_t totalCount = 10000;
   int32_t count = 0;
 
   // all meter is marked as dropped, so the commit will abort very quickly
@@ -357,64 +441,110 @@ static void vnodeWaitForCommitComplete(SVnodeObj *pVnode) {
     commitInProcess = pPool->commitInProcess;
     pthread_mutex_unlock(&pPool->vmutex);
 
-    if (commitInProcess) {
-      dWarn("vid:%d still in commit, wait for completed", pVnode->vnode);
-      taosMsleep(10);
-    }
+    if (!commitInProcess) return 0;
+
+    if (count % 100 == 1) dWarn("vid:%d still in commit, wait for completed", pVnode->vnode);
+    taosMsleep(10);
   }
+
+  return -1;
 }
 
 void vnodeCancelCommit(SVnodeObj *pVnode) {
   SCachePool *pPool = (SCachePool *)(pVnode->pCachePool);
   if (pPool == NULL) return;
 
+  // a queued commit is not started yet, just drop it
+  pthread_mutex_lock(&pPool->vmutex);
+  if (vnodeUnscheduleCommit(pVnode->vnode)) pPool->commitInProcess = 0;
+  pthread_mutex_unlock(&pPool->vmutex);
+
   vnodeWaitForCommitComplete(pVnode);
   taosTmrReset(vnodeProcessCommitTimer, pVnode->cfg.commitTime * 1000, pVnode, vnodeTmrCtrl, &pVnode->commitTimer);
 }
 
-/* The vnode cache lock should be hold before calling this interface
+/*
+ * Take a block from pShard for a meter of pHome, the mutex of both shards shall be hold. A committed block is
+ * reused by freeing the first block of its meter, which needs the mutex of the home shard of that meter. The
+ * mutex is only tried, and the block is skipped if it is busy. NULL is returned if too many blocks of the shard
+ * are not committed yet.
  */
-SCacheBlock *vnodeGetFreeCacheBlock(SVnodeObj *pVnode) {
-  SCachePool  *pPool = (SCachePool *)(pVnode->pCachePool);
-  SVnodeCfg   *pCfg = &(pVnode->cfg);
+static SCacheBlock *vnodeTakeCacheBlock(SCachePool *pPool, SCacheShard *pShard, SCacheShard *pHome) {
   SCacheBlock *pCacheBlock = NULL;
-  int skipped = 0;
+  int          skipped = 0;
 
   while (1) {
-    pCacheBlock = (SCacheBlock *)(pPool->pMem[((int64_t)pPool->freeSlot)]);
-    if (pCacheBlock->blockId == 0) break;
-
-    if (pCacheBlock->notFree) {
-      pPool->freeSlot++;
-      pPool->freeSlot = pPool->freeSlot % pCfg->cacheNumOfBlocks.totalBlocks;
-      skipped++;
-      if (skipped > pPool->threshold) {
-        vnodeCreateCommitThread(pVnode);
-        pthread_mutex_unlock(&pPool->vmutex);
-        dError("vid:%d committing process is too slow, notFreeSlots:%d....", pVnode->vnode, pPool->notFreeSlots);
-        return NULL;
-      }
-    } else {
-      SMeterObj * pRelObj = pCacheBlock->pMeterObj;
-      SCacheInfo *pRelInfo = (SCacheInfo *)pRelObj->pCache;
-      int firstSlot = (pRelInfo->currentSlot - pRelInfo->numOfBlocks + 1 + pRelInfo->maxBlocks) % pRelInfo->maxBlocks;
-      pCacheBlock = pRelInfo->cacheBlocks[firstSlot];
-      if (pCacheBlock) {
-        pPool->freeSlot = pCacheBlock->index;
-        vnodeFreeCacheBlock(pCacheBlock);
-        break;
-      } else {
-        pPool->freeSlot = (pPool->freeSlot + 1) % pCfg->cacheNumOfBlocks.totalBlocks;
-        skipped++;
+    pCacheBlock = (SCacheBlock *)(pPool->pMem[pShard->startBlock + pShard->freeSlot]);
+    if (atomic_load_64(&pCacheBlock->blockId) == 0) break;
+
+    if (skipped > pShard->threshold) return NULL;
+
+    SCacheShard *pOwner = pPool->shards + pCacheBlock->shard;
+    int          lock = (pOwner != pShard && pOwner != pHome);
+    SCacheBlock *pFirstBlock = NULL;
+
+    if (!pCacheBlock->notFree && (!lock || pthread_mutex_trylock(&pOwner->mutex) == 0)) {
+      // check again, the block may be freed or taken by another meter before the mutex is got
+      SMeterObj *pRelObj = pCacheBlock->pMeterObj;
+      if (pCacheBlock->blockId != 0 && !pCacheBlock->notFree && pPool->shards + pCacheBlock->shard == pOwner &&
+          pRelObj != NULL && pRelObj->pCache != NULL) {
+        SCacheInfo *pRelInfo = (SCacheInfo *)pRelObj->pCache;
+        int firstSlot = (pRelInfo->currentSlot - pRelInfo->numOfBlocks + 1 + pRelInfo->maxBlocks) % pRelInfo->maxBlocks;
+        pFirstBlock = pRelInfo->cacheBlocks[firstSlot];
+
+        // blocks of a meter are freed in order, the first block may be lent by another shard
+        if (pFirstBlock != NULL && vnodeGetBlockShard(pPool, pFirstBlock->index) == pShard) {
+          pShard->freeSlot = pFirstBlock->index - pShard->startBlock;
+          vnodeFreeCacheBlock(pFirstBlock);
+        } else {
+          pFirstBlock = NULL;
+        }
       }
+
+      if (lock) pthread_mutex_unlock(&pOwner->mutex);
     }
+
+    if (pFirstBlock != NULL) break;
+
+    pShard->freeSlot = (pShard->freeSlot + 1) % pShard->numOfBlocks;
+    skipped++;
   }
 
-  pCacheBlock = (SCacheBlock *)(pPool->pMem[pPool->freeSlot]);
-  pCacheBlock->index = pPool->freeSlot;
+  pCacheBlock = (SCacheBlock *)(pPool->pMem[pShard->startBlock + pShard->freeSlot]);
+  pCacheBlock->index = pShard->startBlock + pShard->freeSlot;
   pCacheBlock->notFree = 1;
-  pPool->freeSlot = (pPool->freeSlot + 1) % pCfg->cacheNumOfBlocks.totalBlocks;
-  pPool->notFreeSlots++;
+  pCacheBlock->shard = pHome - pPool->shards;
+  pCacheBlock->blockId = -1;  // the caller fills the block after the mutex of a lending shard is released
+  pShard->freeSlot = (pShard->freeSlot + 1) % pShard->numOfBlocks;
+  atomic_add_fetch_32(&pShard->notFreeSlots, 1);
+  atomic_add_fetch_64(&pPool->notFreeSlots, 1);
+
+  return pCacheBlock;
+}
+
+/* The lock of the home shard of the meter should be hold before calling this interface. If all
+ * blocks of the home shard are waiting to be committed, a block is borrowed from another shard.
+ */
+SCacheBlock *vnodeGetFreeCacheBlock(SVnodeObj *pVnode, SCacheShard *pShard) {
+  SCachePool * pPool = (SCachePool *)(pVnode->pCachePool);
+  SCacheBlock *pCacheBlock = vnodeTakeCacheBlock(pPool, pShard, pShard);
+
+  // shards under commit pressure or busy are skipped, so writers never wait for each other here
+  for (int32_t i = 1; pCacheBlock == NULL && i < pPool->numOfShards; ++i) {
+    SCacheShard *pLender = pPool->shards + (pShard - pPool->shards + i) % pPool->numOfShards;
+    if (atomic_load_32(&pLender->notFreeSlots) > pLender->threshold) continue;
+    if (pthread_mutex_trylock(&pLender->mutex) != 0) continue;
+
+    pCacheBlock = vnodeTakeCacheBlock(pPool, pLender, pShard);
+    pthread_mutex_unlock(&pLender->mutex);
+  }
+
+  if (pCacheBlock == NULL) {
+    pthread_mutex_lock(&pPool->vmutex);
+    vnodeCreateCommitThread(pVnode);
+    pthread_mutex_unlock(&pPool->vmutex);
+    dError("vid:%d committing process is too slow, notFreeSlots:%d....", pVnode->vnode, pPool->notFreeSlots);
+  }
 
   return pCacheBlock;
 }
@@ -422,6 +552,7 @@ SCacheBlock *vnodeGetFreeCacheBlock(SVnodeObj *pVnode) {
 int vnodeAllocateCacheBlock(SMeterObj *pObj) {
   int          index;
   SCachePool * pPool;
+  SCacheShard *pShard;
   SCacheBlock *pCacheBlock;
   SCacheInfo * pInfo;
   SVnodeObj *  pVnode;
@@ -433,27 +564,35 @@ int vnodeAllocateCacheBlock(SMeterObj *pObj) {
   SVnodeCfg *pCfg = &(vnodeList[pObj->vnode].cfg);
 
   if (pPool == NULL) return -1;
-  pthread_mutex_lock(&pPool->vmutex);
+  pShard = vnodeGetCacheShard(pPool, pObj->sid);
+  pthread_mutex_lock(&pShard->mutex);
 
   if (pInfo == NULL || pInfo->cacheBlocks == NULL) {
-    pthread_mutex_unlock(&pPool->vmutex);
+    pthread_mutex_unlock(&pShard->mutex);
     dError("vid:%d sid:%d id:%s, meter is not there", pObj->vnode, pObj->sid, pObj->meterId);
     return -1;
   }
 
   if (pPool->count <= 1) {
+    pthread_mutex_lock(&pPool->vmutex);
     if (pVnode->commitTimer == NULL)
       pVnode->commitTimer = taosTmrStart(vnodeProcessCommitTimer, pCfg->commitTime * 1000, pVnode, vnodeTmrCtrl);
+    pthread_mutex_unlock(&pPool->vmutex);
   }
 
   if (pInfo->unCommittedBlocks >= pInfo->maxBlocks-1) {
+    pthread_mutex_lock(&pPool->vmutex);
     vnodeCreateCommitThread(pVnode);
     pthread_mutex_unlock(&pPool->vmutex);
+    pthread_mutex_unlock(&pShard->mutex);
     dError("vid:%d sid:%d id:%s, all blocks are not committed yet....", pObj->vnode, pObj->sid, pObj->meterId);
     return -1;
   }
 
-  if ((pCacheBlock = vnodeGetFreeCacheBlock(pVnode)) == NULL) return -1;
+  if ((pCacheBlock = vnodeGetFreeCacheBlock(pVnode, pShard)) == NULL) {
+    pthread_mutex_unlock(&pShard->mutex);
+    return -1;
+  }
 
   index = pCacheBlock->index;
   pCacheBlock->pMeterObj = pObj;
@@ -478,14 +617,17 @@ int vnodeAllocateCacheBlock(SMeterObj *pObj) {
          pObj->vnode, pObj->sid, pObj->meterId, pInfo->numOfBlocks, pInfo->currentSlot, index, pPool->notFreeSlots,
          pInfo->blocks);
 
-  if (((pPool->notFreeSlots > pPool->threshold) || (pInfo->unCommittedBlocks >= pInfo->maxBlocks / 2))) {
+  SCacheShard *pBlockShard = vnodeGetBlockShard(pPool, index);
+  if (((pBlockShard->notFreeSlots > pBlockShard->threshold) || (pInfo->unCommittedBlocks >= pInfo->maxBlocks / 2))) {
     dTrace("vid:%d sid:%d id:%s, too many unCommitted slots, unCommitted:%d notFreeSlots:%d",
-           pObj->vnode, pObj->sid, pObj->meterId, pInfo->unCommittedBlocks, pPool->notFreeSlots);
+           pObj->vnode, pObj->sid, pObj->meterId, pInfo->unCommittedBlocks, pBlockShard->notFreeSlots);
+    pthread_mutex_lock(&pPool->vmutex);
     vnodeCreateCommitThread(pVnode);
+    pthread_mutex_unlock(&pPool->vmutex);
     commit = 1;
   }
 
-  pthread_mutex_unlock(&pPool->vmutex);
+  pthread_mutex_unlock(&pShard->mutex);
 
   return commit;
 }
@@ -519,7 +661,7 @@ int vnodeInsertPointToCache(SMeterObj *pObj, char *pData) {
 
   atomic_fetch_sub_32(&pObj->freePoints, 1);
   pCacheBlock->numOfPoints++;
-  pPool->count++;
+  atomic_add_fetch_64(&pPool->count, 1);
 
   return 0;
 }
@@ -757,15 +899,16 @@ void vnodeSearchPointInCache(SMeterObj *pObj, SQuery *pQuery) {
   SCacheBlock *pBlock;
   SCacheInfo * pInfo = (SCacheInfo *)pObj->pCache;
   SCachePool * pPool = (SCachePool *)vnodeList[pObj->vnode].pCachePool;
+  SCacheShard *pShard = vnodeGetCacheShard(pPool, pObj->sid);
 
   pQuery->slot = -1;
   pQuery->pos = -1;
 
   // save these variables first in case it may be changed by write operation
-  pthread_mutex_lock(&pPool->vmutex);
+  pthread_mutex_lock(&pShard->mutex);
   numOfBlocks = pInfo->numOfBlocks;
   lastSlot = pInfo->currentSlot;
-  pthread_mutex_unlock(&pPool->vmutex);
+  pthread_mutex_unlock(&pShard->mutex);
   if (numOfBlocks <= 0) return;
 
   firstSlot = (lastSlot - numOfBlocks + 1 + pInfo->maxBlocks) % pInfo->maxBlocks;
@@ -912,6 +1055,7 @@ void vnodeSetCommitQuery(SMeterObj *pObj, SQuery *pQuery) {
   SCacheInfo *pInfo = (SCacheInfo *)pObj->pCache;
   SCachePool *pPool = (SCachePool *)vnodeList[pObj->vnode].pCachePool;
   SVnodeObj * pVnode = vnodeList + pObj->vnode;
+  SCacheShard *pShard = vnodeGetCacheShard(pPool, pObj->sid);
 
   pQuery->order.order = TSQL_SO_ASC;
   pQuery->numOfCols = pObj->numOfColumns;
@@ -936,10 +1080,10 @@ void vnodeSetCommitQuery(SMeterObj *pObj, SQuery *pQuery) {
   pQuery->pos = pInfo->commitPoint;
   pQuery->over = 0;
 
-  pthread_mutex_lock(&pPool->vmutex);
+  pthread_mutex_lock(&pShard->mutex);
   pQuery->currentSlot = pInfo->currentSlot;
   pQuery->numOfBlocks = pInfo->numOfBlocks;
-  pthread_mutex_unlock(&pPool->vmutex);
+  pthread_mutex_unlock(&pShard->mutex);
 
   if (pQuery->numOfBlocks <= 0 || pQuery->firstSlot < 0) {
     pQuery->over = 1;
@@ -1090,13 +1234,14 @@ int vnodeSyncRestoreCache(int vnode, int fd) {
 
     pInfo = (SCacheInfo *)pObj->pCache;
     numOfBlocks = pInfo->numOfBlocks;
-    pthread_mutex_lock(&pPool->vmutex);
+    SCacheShard *pShard = vnodeGetCacheShard(pPool, sid);
+    pthread_mutex_lock(&pShard->mutex);
     for (i = 0; i < numOfBlocks; ++i) {
       slot = (pInfo->currentSlot - i + pInfo->maxBlocks) % pInfo->maxBlocks;
       pBlock = pInfo->cacheBlocks[slot];
       vnodeFreeCacheBlock(pBlock);
     }
-    pthread_mutex_unlock(&pPool->vmutex);
+    pthread_mutex_unlock(&pShard->mutex);
 
     pInfo->unCommittedBlocks = 0;
     if (taosReadMsg(fd, &(pObj->lastKey), sizeof(pObj->lastKey)) <= 0) return -1;
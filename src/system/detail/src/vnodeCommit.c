@@ -75,6 +75,97 @@ int vnodeOpenCommitLog(int vnode, uint64_t firstV) {
   return -1;
 }
 
+/*
+ * Records appended by concurrent writers are synced to disk by one msync, and all the writers
+ * in this batch are waked up. The batch is closed when tsCommitLogSyncDelay expires or it
+ * reaches tsCommitLogSyncBytes. The log mutex is released during msync, so that writers can
+ * append records into the next batch.
+ */
+static void *vnodeSyncCommitLog(void *param) {
+  SVnodeObj *pVnode = (SVnodeObj *)param;
+
+  pthread_mutex_lock(&(pVnode->logMutex));
+
+  while (!pVnode->logSyncStop) {
+    if (pVnode->pWrite == NULL || pVnode->pWrite - pVnode->pMem <= pVnode->logSyncedLen) {
+      pthread_cond_wait(&(pVnode->logSyncCond), &(pVnode->logMutex));
+      continue;
+    }
+
+    if (tsCommitLogSyncDelay > 0) {
+      struct timespec ts;
+      clock_gettime(CLOCK_REALTIME, &ts);
+      ts.tv_nsec += tsCommitLogSyncDelay * 1000000L;
+      ts.tv_sec += ts.tv_nsec / 1000000000L;
+      ts.tv_nsec = ts.tv_nsec % 1000000000L;
+
+      while (!pVnode->logSyncStop && pVnode->pWrite != NULL &&
+             pVnode->pWrite - pVnode->pMem - pVnode->logSyncedLen < tsCommitLogSyncBytes) {
+        if (pthread_cond_timedwait(&(pVnode->logSyncCond), &(pVnode->logMutex), &ts) == ETIMEDOUT) break;
+      }
+
+      // the commit log may be renewed during waiting
+      if (pVnode->logSyncStop || pVnode->pWrite == NULL) continue;
+    }
+
+    char *  pMem = pVnode->pMem;
+    int64_t start = pVnode->logSyncedLen & ~(tsPageSize - 1);
+    int64_t end = pVnode->pWrite - pVnode->pMem;
+    int32_t gen = pVnode->logGen;
+
+    pVnode->logSyncing = 1;
+    pthread_mutex_unlock(&(pVnode->logMutex));
+
+    int code = msync(pMem + start, end - start, MS_SYNC);
+    if (code != 0) {
+      dError("vid:%d, failed to sync commit log, offset:%" PRId64 " len:%" PRId64 ", reason:%s", pVnode->vnode, start,
+             end - start, strerror(errno));
+    }
+
+    pthread_mutex_lock(&(pVnode->logMutex));
+    pVnode->logSyncing = 0;
+    if (gen == pVnode->logGen) {
+      if (code != 0) pVnode->logFailedLen = end;
+      pVnode->logSyncedLen = end;
+    }
+
+    pthread_cond_broadcast(&(pVnode->logSyncedCond));
+  }
+
+  pthread_mutex_unlock(&(pVnode->logMutex));
+  return NULL;
+}
+
+static int vnodeStartCommitLogSync(SVnodeObj *pVnode) {
+  pthread_attr_t thattr;
+  pthread_attr_init(&thattr);
+  pthread_attr_setdetachstate(&thattr, PTHREAD_CREATE_JOINABLE);
+
+  pVnode->logSyncStop = 0;
+  pVnode->logFailedGen = -1;
+  if (pthread_create(&(pVnode->logSyncThread), &thattr, vnodeSyncCommitLog, pVnode) != 0) {
+    dError("vid:%d, failed to create commit log sync thread, reason:%s", pVnode->vnode, strerror(errno));
+    pthread_attr_destroy(&thattr);
+    return -1;
+  }
+
+  pthread_attr_destroy(&thattr);
+  dTrace("vid:%d, commit log sync thread is created", pVnode->vnode);
+  return 0;
+}
+
+static void vnodeStopCommitLogSync(SVnodeObj *pVnode) {
+  if (pVnode->logSyncStop) return;
+
+  pthread_mutex_lock(&(pVnode->logMutex));
+  pVnode->logSyncStop = 1;
+  pthread_cond_signal(&(pVnode->logSyncCond));
+  pthread_cond_broadcast(&(pVnode->logSyncedCond));
+  pthread_mutex_unlock(&(pVnode->logMutex));
+
+  pthread_join(pVnode->logSyncThread, NULL);
+}
+
 int vnodeRenewCommitLog(int vnode) {
   SVnodeObj *pVnode = vnodeList + vnode;
   char *     fileName = pVnode->logFn;
@@ -82,7 +173,20 @@ int vnodeRenewCommitLog(int vnode) {
 
   pthread_mutex_lock(&(pVnode->logMutex));
 
+  // the mapping shall not be released while it is being synced
+  while (pVnode->logSyncing) {
+    pthread_cond_wait(&(pVnode->logSyncedCond), &(pVnode->logMutex));
+  }
+
   if (FD_VALID(pVnode->logFd)) {
+    // data in the old log is not in data files yet, it shall be on disk before the log is released
+    if (pVnode->cfg.commitLog == TSDB_COMMIT_LOG_SYNC && pVnode->pWrite - pVnode->pMem > pVnode->logSyncedLen) {
+      if (msync(pVnode->pMem, pVnode->pWrite - pVnode->pMem, MS_SYNC) != 0) {
+        dError("vid:%d, failed to sync commit log, reason:%s", vnode, strerror(errno));
+        pVnode->logFailedGen = pVnode->logGen;
+      }
+    }
+
     munmap(pVnode->pMem, pVnode->mappingSize);
     close(pVnode->logFd);
     rename(fileName, oldName);
@@ -90,6 +194,11 @@ int vnodeRenewCommitLog(int vnode) {
 
   if (pVnode->cfg.commitLog) vnodeOpenCommitLog(vnode, vnodeList[vnode].version);
 
+  pVnode->logGen++;
+  pVnode->logSyncedLen = 0;
+  pVnode->logFailedLen = 0;
+  pthread_cond_broadcast(&(pVnode->logSyncedCond));
+
   pthread_mutex_unlock(&(pVnode->logMutex));
 
   return pVnode->logFd;
@@ -209,6 +318,9 @@ int vnodeInitCommit(int vnode) {
   SVnodeObj *pVnode = vnodeList + vnode;
 
   pthread_mutex_init(&(pVnode->logMutex), NULL);
+  pthread_cond_init(&(pVnode->logSyncCond), NULL);
+  pthread_cond_init(&(pVnode->logSyncedCond), NULL);
+  pVnode->logSyncStop = 1;
 
   sprintf(pVnode->logFn, "%s/vnode%d/db/submit%d.log", tsDirectory, vnode, vnode);
   sprintf(pVnode->logOFn, "%s/vnode%d/db/submit%d.olog", tsDirectory, vnode, vnode);
@@ -236,6 +348,12 @@ int vnodeInitCommit(int vnode) {
   }
 
   pVnode->pWrite += size;
+  pVnode->logSyncedLen = 0;
+
+  if (pVnode->cfg.commitLog == TSDB_COMMIT_LOG_SYNC && vnodeStartCommitLogSync(pVnode) < 0) {
+    return -1;
+  }
+
   dPrint("vid:%d, commit log is initialized", vnode);
 
   return 0;
@@ -244,6 +362,8 @@ int vnodeInitCommit(int vnode) {
 void vnodeCleanUpCommit(int vnode) {
   SVnodeObj *pVnode = vnodeList + vnode;
 
+  vnodeStopCommitLogSync(pVnode);
+
   if (FD_VALID(pVnode->logFd)) close(pVnode->logFd);
 
   if (pVnode->cfg.commitLog && (pVnode->logFd > 0 && remove(pVnode->logFn) < 0)) {
@@ -251,6 +371,8 @@ void vnodeCleanUpCommit(int vnode) {
     taosLogError("vid:%d, failed to remove:%s", vnode, pVnode->logFn);
   }
 
+  pthread_cond_destroy(&(pVnode->logSyncCond));
+  pthread_cond_destroy(&(pVnode->logSyncedCond));
   pthread_mutex_destroy(&(pVnode->logMutex));
 }
 
@@ -279,8 +401,30 @@ int vnodeWriteToCommitLog(SMeterObj *pObj, char action, char *cont, int contLen,
   memcpy(pWrite, (char *)&head, sizeof(head));
   memcpy(pWrite + sizeof(head), cont, contLen);
   memcpy(pWrite + sizeof(head) + contLen, &simpleCheck, sizeof(simpleCheck));
+
+  int code = TSDB_CODE_SUCCESS;
+  if (pVnode->cfg.commitLog == TSDB_COMMIT_LOG_SYNC) {
+    int64_t len = pVnode->pWrite - pVnode->pMem;
+    int32_t gen = pVnode->logGen;
+
+    pthread_cond_signal(&(pVnode->logSyncCond));
+    while (pVnode->logSyncedLen < len && pVnode->logGen == gen && !pVnode->logSyncStop) {
+      pthread_cond_wait(&(pVnode->logSyncedCond), &(pVnode->logMutex));
+    }
+
+    // the record is either in a batch failed to be synced, or left in the log renewed with a failed sync
+    if ((pVnode->logGen == gen && pVnode->logFailedLen >= len) ||
+        (pVnode->logGen != gen && pVnode->logFailedGen == gen)) {
+      code = TSDB_CODE_OTHERS;
+    }
+  }
   pthread_mutex_unlock(&(pVnode->logMutex));
 
+  if (code != TSDB_CODE_SUCCESS) {
+    dError("vid:%d sid:%d, failed to sync data to commit log", pObj->vnode, pObj->sid);
+    return code;
+  }
+
   if (pVnode->pWrite - pVnode->pMem > pVnode->mappingThreshold) {
     dTrace("vid:%d, mem mapping is close to limit, commit", pObj->vnode);
     vnodeProcessCommitTimer(pVnode, NULL);
@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _DEFAULT_SOURCE
+#include "os.h"
+
+#include "ttime.h"
+#include "vnode.h"
+#include "vnodeCache.h"
+#include "vnodeCommitSched.h"
+
+// a vnode waiting for one minute is treated as if its cache is full, so idle vnodes are not starved
+#define COMMIT_SCHED_AGING_US (60 * 1000000L)
+
+typedef struct {
+  char    path[TSDB_FILENAME_LEN];
+  int32_t running;
+} SCommitDir;
+
+typedef struct {
+  pthread_mutex_t mutex;
+  pthread_cond_t  cond;
+  int32_t         stop;
+  int32_t         numOfWorkers;
+  int32_t         maxCommitsPerDir;
+  pthread_t *     workers;
+
+  int32_t         numOfQueued;
+  int32_t         queue[TSDB_MAX_VNODES];       // queued vnodes, not in order
+  int64_t         queuedTime[TSDB_MAX_VNODES];  // indexed by vnode
+  int8_t          compact[TSDB_MAX_VNODES];     // indexed by vnode, the queued job is compaction
+  int32_t         dirIndex[TSDB_MAX_VNODES];    // indexed by vnode
+  int32_t         numOfDirs;
+  SCommitDir      dirs[TSDB_MAX_VNODES];
+
+  SCommitSchedStat stat;
+} SCommitScheduler;
+
+static SCommitScheduler *commitSched = NULL;
+
+char *vnodeGetDataDir(int vnode, int fileId);
+
+static int32_t vnodeGetCommitDirIndex(SVnodeObj *pVnode) {
+  char *path = vnodeGetDataDir(pVnode->vnode, pVnode->fileId);
+  if (path == NULL) path = tsDirectory;
+
+  for (int32_t i = 0; i < commitSched->numOfDirs; ++i) {
+    if (strcmp(commitSched->dirs[i].path, path) == 0) return i;
+  }
+
+  // at most one directory for each vnode
+  assert(commitSched->numOfDirs < TSDB_MAX_VNODES);
+  SCommitDir *pDir = &commitSched->dirs[commitSched->numOfDirs];
+  strncpy(pDir->path, path, TSDB_FILENAME_LEN - 1);
+  pDir->running = 0;
+
+  return commitSched->numOfDirs++;
+}
+
+/*
+ * pick the queued vnode whose cache is the fullest from those whose data directory has a free writer slot,
+ * returns the position in queue or -1 if none can be started
+ */
+static int32_t vnodePickCommitVnode(int64_t now) {
+  int32_t pos = -1;
+  double  maxPressure = -1;
+
+  for (int32_t i = 0; i < commitSched->numOfQueued; ++i) {
+    int32_t vnode = commitSched->queue[i];
+    if (commitSched->dirs[commitSched->dirIndex[vnode]].running >= commitSched->maxCommitsPerDir) continue;
+
+    double      pressure = 0;
+    SCachePool *pPool = (SCachePool *)vnodeList[vnode].pCachePool;
+    if (pPool != NULL && pPool->threshold > 0) {
+      pressure = (double)atomic_load_64(&pPool->notFreeSlots) / pPool->threshold;
+    }
+
+    pressure += (double)(now - commitSched->queuedTime[vnode]) / COMMIT_SCHED_AGING_US;
+    if (pressure > maxPressure) {
+      maxPressure = pressure;
+      pos = i;
+    }
+  }
+
+  return pos;
+}
+
+static void vnodeRecordCommitLatency(int64_t useconds) {
+  int32_t bucket = 0;
+  if (useconds < 100000L) {
+    bucket = 0;
+  } else if (useconds < 1000000L) {
+    bucket = 1;
+  } else if (useconds < 10000000L) {
+    bucket = 2;
+  } else if (useconds < 60000000L) {
+    bucket = 3;
+  } else {
+    bucket = 4;
+  }
+
+  commitSched->stat.latency[bucket]++;
+  commitSched->stat.commits++;
+}
+
+static void *vnodeCommitWorker(void *param) {
+  pthread_mutex_lock(&commitSched->mutex);
+
+  while (1) {
+    int32_t pos = -1;
+    while (!commitSched->stop && (pos = vnodePickCommitVnode(taosGetTimestampUs())) < 0) {
+      pthread_cond_wait(&commitSched->cond, &commitSched->mutex);
+    }
+
+    if (commitSched->stop) break;
+
+    int32_t     vnode = commitSched->queue[pos];
+    SCommitDir *pDir = &commitSched->dirs[commitSched->dirIndex[vnode]];
+    commitSched->queue[pos] = commitSched->queue[--commitSched->numOfQueued];
+    commitSched->stat.queued = commitSched->numOfQueued;
+    commitSched->stat.running++;
+    pDir->running++;
+
+    int64_t st = taosGetTimestampUs();
+    int8_t  compact = commitSched->compact[vnode] && vnodeList[vnode].firstKey > vnodeList[vnode].lastKey;
+    commitSched->stat.waitUs += st - commitSched->queuedTime[vnode];
+    vnodeList[vnode].commitThread = pthread_self();
+    pthread_mutex_unlock(&commitSched->mutex);
+
+    dTrace("vid:%d, %s is started by worker, dir:%s running:%d", vnode, compact ? "compaction" : "commit", pDir->path,
+           pDir->running);
+    if (compact) {
+      vnodeCompactVnode(vnodeList + vnode);
+    } else {
+      vnodeCommitToFile(vnodeList + vnode);
+    }
+    int64_t useconds = taosGetTimestampUs() - st;
+
+    pthread_mutex_lock(&commitSched->mutex);
+    pDir->running--;
+    commitSched->stat.running--;
+    vnodeRecordCommitLatency(useconds);
+
+    // a writer slot of the directory is released, queued vnodes on it may be started
+    pthread_cond_broadcast(&commitSched->cond);
+  }
+
+  pthread_mutex_unlock(&commitSched->mutex);
+  return NULL;
+}
+
+int32_t vnodeInitCommitScheduler(int32_t numOfWorkers, int32_t maxCommitsPerDir) {
+  if (numOfWorkers <= 0) {
+    dPrint("commit scheduler is disabled, a thread is created for each commit");
+    return 0;
+  }
+
+  commitSched = calloc(1, sizeof(SCommitScheduler));
+  if (commitSched == NULL) {
+    dError("failed to allocate commit scheduler, reason:%s", strerror(errno));
+    return -1;
+  }
+
+  commitSched->maxCommitsPerDir = (maxCommitsPerDir > 0) ? maxCommitsPerDir : numOfWorkers;
+  commitSched->workers = calloc((size_t)numOfWorkers, sizeof(pthread_t));
+  if (commitSched->workers == NULL) {
+    dError("failed to allocate commit workers, reason:%s", strerror(errno));
+    tfree(commitSched);
+    return -1;
+  }
+
+  pthread_mutex_init(&commitSched->mutex, NULL);
+  pthread_cond_init(&commitSched->cond, NULL);
+
+  for (int32_t i = 0; i < numOfWorkers; ++i) {
+    if (pthread_create(&commitSched->workers[i], NULL, vnodeCommitWorker, NULL) != 0) {
+      dError("failed to create commit worker, reason:%s", strerror(errno));
+      break;
+    }
+
+    commitSched->numOfWorkers++;
+  }
+
+  if (commitSched->numOfWorkers == 0) {
+    vnodeCleanUpCommitScheduler();
+    return -1;
+  }
+
+  dPrint("commit scheduler is initialized, workers:%d, max commits per dir:%d", commitSched->numOfWorkers,
+         commitSched->maxCommitsPerDir);
+  return 0;
+}
+
+void vnodeCleanUpCommitScheduler() {
+  if (commitSched == NULL) return;
+
+  pthread_mutex_lock(&commitSched->mutex);
+  commitSched->stop = 1;
+  pthread_cond_broadcast(&commitSched->cond);
+  pthread_mutex_unlock(&commitSched->mutex);
+
+  for (int32_t i = 0; i < commitSched->numOfWorkers; ++i) {
+    pthread_join(commitSched->workers[i], NULL);
+  }
+
+  pthread_cond_destroy(&commitSched->cond);
+  pthread_mutex_destroy(&commitSched->mutex);
+  tfree(commitSched->workers);
+  tfree(commitSched);
+}
+
+bool vnodeCommitSchedulerEnabled() { return commitSched != NULL; }
+
+static int32_t vnodeScheduleJob(int32_t vnode, int8_t compact) {
+  if (commitSched == NULL) return -1;
+
+  SVnodeObj *pVnode = vnodeList + vnode;
+
+  pthread_mutex_lock(&commitSched->mutex);
+
+  for (int32_t i = 0; i < commitSched->numOfQueued; ++i) {
+    if (commitSched->queue[i] == vnode) {
+      if (!compact) commitSched->compact[vnode] = 0;
+      pthread_mutex_unlock(&commitSched->mutex);
+      return 0;
+    }
+  }
+
+  commitSched->dirIndex[vnode] = vnodeGetCommitDirIndex(pVnode);
+  commitSched->queuedTime[vnode] = taosGetTimestampUs();
+  commitSched->compact[vnode] = compact;
+  commitSched->queue[commitSched->numOfQueued++] = vnode;
+  commitSched->stat.queued = commitSched->numOfQueued;
+
+  // those waiting for the commit check commitThread, mark it before a worker takes the vnode
+  pVnode->commitThread = commitSched->workers[0];
+
+  int32_t queued = commitSched->numOfQueued;
+  pthread_cond_signal(&commitSched->cond);
+  pthread_mutex_unlock(&commitSched->mutex);
+
+  dTrace("vid:%d, %s is queued, queued:%d", vnode, compact ? "compaction" : "commit", queued);
+  return 0;
+}
+
+int32_t vnodeScheduleCommit(int32_t vnode) { return vnodeScheduleJob(vnode, 0); }
+
+int32_t vnodeScheduleCompact(int32_t vnode) { return vnodeScheduleJob(vnode, 1); }
+
+bool vnodeUnscheduleCommit(int32_t vnode) {
+  if (commitSched == NULL) return false;
+
+  bool removed = false;
+  pthread_mutex_lock(&commitSched->mutex);
+
+  for (int32_t i = 0; i < commitSched->numOfQueued; ++i) {
+    if (commitSched->queue[i] == vnode) {
+      commitSched->queue[i] = commitSched->queue[--commitSched->numOfQueued];
+      commitSched->stat.queued = commitSched->numOfQueued;
+      memset(&vnodeList[vnode].commitThread, 0, sizeof(vnodeList[vnode].commitThread));
+      removed = true;
+      break;
+    }
+  }
+
+  pthread_mutex_unlock(&commitSched->mutex);
+  return removed;
+}
+
+void vnodeGetCommitSchedStat(SCommitSchedStat *pStat) {
+  memset(pStat, 0, sizeof(SCommitSchedStat));
+  if (commitSched == NULL) return;
+
+  pthread_mutex_lock(&commitSched->mutex);
+  *pStat = commitSched->stat;
+  pthread_mutex_unlock(&commitSched->mutex);
+}
@@ -0,0 +1,663 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _DEFAULT_SOURCE
+#include "os.h"
+
+#include "vnode.h"
+#include "vnodeBlockCache.h"
+#include "vnodeCache.h"
+#include "vnodeCommitSched.h"
+#include "vnodeFile.h"
+#include "vnodeUtil.h"
+#include "vnodeStatus.h"
+
+extern void vnodeGetHeadTname(char *nHeadName, char *nLastName, int vnode, int fileId);
+extern void vnodeGetHeadDataLname(char *headName, char *dataName, char *lastName, int vnode, int fileId);
+extern int  vnodeReadColumnToMem(int fd, SCompBlock *pBlock, SField **fields, int col, char *data, int dataSize,
+                                 char *temp, char *buffer, int bufferSize);
+extern int  vnodeUpdateFileMagic(int vnode, int fileId);
+
+/*
+ * Background compaction merges adjacent small blocks of a meter in the data file into full size blocks. It is
+ * scheduled as the commit of an idle vnode, so it never runs together with commit or import, and it is counted by
+ * the commit scheduler as a commit writing to the data directory. Merged blocks are appended to the data file and
+ * a new head file is renamed into place, as commit does, so queries are not blocked.
+ *
+ * The small blocks merged are left in the data file as dead space. Once the dead space of a data file is larger
+ * than its live blocks, the data file is rewritten with the live blocks only, and renamed into place together with
+ * the new head file. Offsets in the new data file are reused, so the data file version of the vnode is increased,
+ * which is part of the key of the block cache.
+ */
+typedef struct {
+  SVnodeObj *       pVnode;
+  int               rfd;      // data file to read small blocks from
+  int               reclaim;  // the data file is rewritten, blocks kept are copied into the new data file
+  int               aborted;
+  int64_t           blocksInSecond;
+  int64_t           secondStart;
+  SVnodeCompactStat stat;
+} SCompactHandle;
+
+// the vnode is idle enough to do compaction, and no more data is waiting to be committed
+static int vnodeIsCompactAllowed(SVnodeObj *pVnode) {
+  SCachePool *pPool = (SCachePool *)pVnode->pCachePool;
+
+  if (pPool == NULL || pVnode->vnodeStatus != TSDB_VN_STATUS_MASTER) return 0;
+
+  return pPool->notFreeSlots < pPool->threshold / 2;
+}
+
+static int vnodeIsSmallBlock(SMeterObj *pObj, SCompBlock *pBlock) {
+  return (pBlock->last == 0) && (pBlock->sversion == pObj->sversion) && (pBlock->numOfCols == pObj->numOfColumns) &&
+         (pBlock->numOfPoints <= pObj->pointsPerFileBlock / 2);
+}
+
+static void vnodeThrottleCompact(SCompactHandle *pHandle) {
+  if (tsCompactBlocksPerSec <= 0) return;
+
+  pHandle->blocksInSecond++;
+  if (pHandle->blocksInSecond < tsCompactBlocksPerSec) return;
+
+  int64_t elapsed = taosGetTimestampMs() - pHandle->secondStart;
+  if (elapsed < 1000) taosMsleep(1000 - elapsed);
+
+  pHandle->secondStart = taosGetTimestampMs();
+  pHandle->blocksInSecond = 0;
+}
+
+// the other one of the two files on disk that a link is switched between, e.g., v1f1.head and v1f1.head0
+static void vnodeGetOtherFileName(char *name) {
+  int len = strlen(name);
+  if (name[len - 1] == '0' || name[len - 1] == '1') {
+    name[len - 1] = '0' + (name[len - 1] + 1 - '0') % 2;
+  } else {
+    name[len] = '0';
+    name[len + 1] = '\0';
+  }
+}
+
+// size of the blocks in the data file referred to by the head file, or -1 if the head file can not be read
+static int64_t vnodeGetLiveDataSize(int hfd, SCompHeader *pHeader, int maxSessions) {
+  SCompInfo   compInfo;
+  SCompBlock *pBlocks = NULL;
+  int         maxBlocks = 0;
+  int64_t     size = 0;
+
+  for (int sid = 0; sid < maxSessions; ++sid) {
+    if (pHeader[sid].compInfoOffset == 0) continue;
+
+    lseek(hfd, pHeader[sid].compInfoOffset, SEEK_SET);
+    if (read(hfd, &compInfo, sizeof(SCompInfo)) != sizeof(SCompInfo)) {
+      size = -1;
+      break;
+    }
+
+    if (compInfo.numOfBlocks > maxBlocks) {
+      maxBlocks = compInfo.numOfBlocks;
+      tfree(pBlocks);
+      pBlocks = (SCompBlock *)malloc(sizeof(SCompBlock) * maxBlocks);
+      if (pBlocks == NULL) {
+        size = -1;
+        break;
+      }
+    }
+
+    int len = sizeof(SCompBlock) * compInfo.numOfBlocks;
+    if (read(hfd, pBlocks, len) != len) {
+      size = -1;
+      break;
+    }
+
+    for (int i = 0; i < compInfo.numOfBlocks; ++i) {
+      if (!pBlocks[i].last) size += pBlocks[i].len;
+    }
+  }
+
+  tfree(pBlocks);
+  return size;
+}
+
+// keep a block as it is, it is copied into the new data file if the data file is rewritten
+static int vnodeKeepBlock(SCompactHandle *pHandle, SCompBlock *pBlock, SCompBlock *pNewBlock) {
+  *pNewBlock = *pBlock;
+  if (!pHandle->reclaim || pBlock->last) return 0;
+
+  int   dfd = pHandle->pVnode->dfd;
+  off_t offset = pBlock->offset;
+
+  pNewBlock->offset = lseek(dfd, 0, SEEK_END);
+  if (tsendfile(dfd, pHandle->rfd, &offset, pBlock->len) != pBlock->len) {
+    dError("vid:%d, failed to copy block at offset:%" PRId64 " to new data file, reason:%s", pHandle->pVnode->vnode,
+           (int64_t)pBlock->offset, strerror(errno));
+    return -1;
+  }
+
+  vnodeThrottleCompact(pHandle);
+  return 0;
+}
+
+/*
+ * Merge runs of adjacent small blocks in pBlocks. The new block list is put in pNewBlocks, and the number of blocks
+ * in the new list is returned. Blocks that can not be merged are kept as they are.
+ *
+ * Adjacent small blocks that fit in one block are merged only if the new block is at least twice as large as the
+ * largest of them. So a merged block that is still small is not rewritten in every round, but only after it can
+ * double, and a row is rewritten a few times at most.
+ */
+static int vnodeMergeSmallBlocks(SCompactHandle *pHandle, SMeterObj *pObj, SCompBlock *pBlocks, int numOfBlocks,
+                                 SCompBlock *pNewBlocks) {
+  SVnodeObj *pVnode = pHandle->pVnode;
+  SData *    data[TSDB_MAX_COLUMNS], *cdata[TSDB_MAX_COLUMNS];
+  SField *   fields = NULL;
+  char *     buffer = NULL, *cbuffer = NULL, *temp = NULL, *tempBuffer = NULL;
+  int        numOfNewBlocks = 0;
+  int        i = 0, run = 0;
+
+  // nothing to merge if there are no adjacent small blocks, blocks are still copied if the data file is rewritten
+  for (i = 0; i < numOfBlocks && run < 2; ++i) run = vnodeIsSmallBlock(pObj, pBlocks + i) ? run + 1 : 0;
+  if (run < 2 && !pHandle->reclaim) return numOfBlocks;
+  i = 0;
+
+  int size = pObj->bytesPerPoint * pObj->pointsPerFileBlock +
+             (sizeof(SData) + EXTRA_BYTES + sizeof(TSCKSUM)) * pObj->numOfColumns;
+  int tempBufferSize = pObj->maxBytes * pObj->pointsPerFileBlock + EXTRA_BYTES + sizeof(TSCKSUM);
+
+  if (run >= 2) {
+    buffer = malloc(size);
+    cbuffer = malloc(size);
+    temp = malloc(size);
+    tempBuffer = malloc(tempBufferSize);
+    if (buffer == NULL || cbuffer == NULL || temp == NULL || tempBuffer == NULL) {
+      dError("vid:%d sid:%d id:%s, failed to allocate memory for compaction", pObj->vnode, pObj->sid, pObj->meterId);
+      numOfNewBlocks = -1;
+      goto _over;
+    }
+
+    data[0] = (SData *)buffer;
+    cdata[0] = (SData *)cbuffer;
+    for (int col = 1; col < pObj->numOfColumns; ++col) {
+      data[col] = (SData *)((char *)data[col - 1] + sizeof(SData) + EXTRA_BYTES + sizeof(TSCKSUM) +
+                            pObj->pointsPerFileBlock * pObj->schema[col - 1].bytes);
+      cdata[col] = (SData *)((char *)cdata[col - 1] + sizeof(SData) + EXTRA_BYTES + sizeof(TSCKSUM) +
+                             pObj->pointsPerFileBlock * pObj->schema[col - 1].bytes);
+    }
+  }
+
+  while (i < numOfBlocks) {
+    // the small blocks from i on that fit in one block
+    int j = i, points = 0, maxPoints = 0;
+    while (j < numOfBlocks && vnodeIsSmallBlock(pObj, pBlocks + j) &&
+           points + pBlocks[j].numOfPoints <= pObj->pointsPerFileBlock) {
+      points += pBlocks[j].numOfPoints;
+      if (pBlocks[j].numOfPoints > maxPoints) maxPoints = pBlocks[j].numOfPoints;
+      j++;
+    }
+
+    if (j - i < 2 || points < maxPoints * 2) {
+      if (vnodeKeepBlock(pHandle, pBlocks + i, pNewBlocks + numOfNewBlocks) < 0) {
+        numOfNewBlocks = -1;
+        goto _over;
+      }
+
+      numOfNewBlocks++;
+      i++;
+      continue;
+    }
+
+    // merge blocks [i, j) into one block
+    points = 0;
+    for (int k = i; k < j; ++k) {
+      for (int col = 0; col < pObj->numOfColumns; ++col) {
+        int bytes = pObj->schema[col].bytes;
+        if (vnodeReadColumnToMem(pHandle->rfd, pBlocks + k, &fields, col, data[col]->data + points * bytes,
+                                 pBlocks[k].numOfPoints * bytes, temp, tempBuffer, tempBufferSize) < 0) {
+          dError("vid:%d sid:%d id:%s, failed to read block at offset:%" PRId64 " for compaction", pObj->vnode,
+                 pObj->sid, pObj->meterId, (int64_t)pBlocks[k].offset);
+          numOfNewBlocks = -1;
+          goto _over;
+        }
+      }
+      tfree(fields);
+
+      points += pBlocks[k].numOfPoints;
+      pHandle->stat.srcBlocks++;
+      pHandle->stat.srcBytes += pBlocks[k].len;
+      vnodeThrottleCompact(pHandle);
+    }
+
+    SCompBlock *pCompBlock = pNewBlocks + numOfNewBlocks;
+    memset(pCompBlock, 0, sizeof(SCompBlock));
+    if (vnodeWriteBlockToFile(pObj, pCompBlock, data, cdata, points) < 0) {
+      numOfNewBlocks = -1;
+      goto _over;
+    }
+
+    // the merged blocks are no longer referred to, only the new block is counted as storage
+    for (int k = i; k < j; ++k) pVnode->vnodeStatistic.compStorage -= pBlocks[k].len;
+
+    numOfNewBlocks++;
+    pHandle->stat.dstBlocks++;
+    pHandle->stat.dstBytes += pCompBlock->len;
+    i = j;
+  }
+
+_over:
+  tfree(fields);
+  tfree(buffer);
+  tfree(cbuffer);
+  tfree(temp);
+  tfree(tempBuffer);
+
+  return numOfNewBlocks;
+}
+
+/*
+ * The new data file is linked to the other one of the two data files on disk, its header is copied from the current
+ * data file.
+ */
+static int vnodeOpenReclaimDataFile(SCompactHandle *pHandle, char *dataName, char *nDataName, char *dDataName) {
+  SVnodeObj *pVnode = pHandle->pVnode;
+  char       fileHeader[TSDB_FILE_HEADER_LEN];
+
+  if (readlink(dataName, dDataName, TSDB_FILENAME_LEN) < 0) return -1;
+  vnodeGetOtherFileName(dDataName);
+
+  remove(nDataName);
+  symlink(dDataName, nDataName);
+
+  int fd = open(nDataName, O_RDWR | O_CREAT | O_TRUNC, S_IRWXU | S_IRWXG | S_IRWXO);
+  if (fd < 0) {
+    dError("vid:%d, failed to open new data file:%s, reason:%s", pVnode->vnode, nDataName, strerror(errno));
+    return -1;
+  }
+
+  if (pread(pHandle->rfd, fileHeader, TSDB_FILE_HEADER_LEN, 0) != TSDB_FILE_HEADER_LEN ||
+      twrite(fd, fileHeader, TSDB_FILE_HEADER_LEN) != TSDB_FILE_HEADER_LEN) {
+    dError("vid:%d, failed to write header of new data file:%s", pVnode->vnode, nDataName);
+    close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+static int vnodeCompactFile(SCompactHandle *pHandle, int fileId) {
+  SVnodeObj * pVnode = pHandle->pVnode;
+  int         vnode = pVnode->vnode;
+  char        headName[TSDB_FILENAME_LEN] = "\0";
+  char        dataName[TSDB_FILENAME_LEN] = "\0";
+  char        nHeadName[TSDB_FILENAME_LEN] = "\0";
+  char        dHeadName[TSDB_FILENAME_LEN] = "\0";
+  char        nDataName[TSDB_FILENAME_LEN] = "\0";
+  char        dDataName[TSDB_FILENAME_LEN] = "\0";
+  char        dpath[TSDB_FILENAME_LEN] = "\0";
+  char        ddpath[TSDB_FILENAME_LEN] = "\0";
+  char        fileHeader[TSDB_FILE_HEADER_LEN];
+  int         hfd = -1, nfd = -1, dfd = -1, ndfd = -1;
+  int         code = -1, changed = 0;
+  int64_t     dfSize = pVnode->dfSize;
+  SCompHeader *pHeader = NULL;
+  SCompBlock * pBlocks = NULL, *pNewBlocks = NULL;
+  int          maxBlocks = 0;
+  SCompInfo    compInfo;
+  TSCKSUM      chksum;
+  struct stat  filestat, datastat;
+
+  vnodeGetHeadDataLname(headName, dataName, NULL, vnode, fileId);
+  vnodeGetHeadTname(nHeadName, NULL, vnode, fileId);
+  sprintf(nDataName, "%s/vnode%d/db/v%df%d.d", tsDirectory, vnode, vnode, fileId);
+  pHandle->reclaim = 0;
+
+  int tmsize = sizeof(SCompHeader) * pVnode->cfg.maxSessions + sizeof(TSCKSUM);
+  pHeader = (SCompHeader *)malloc(tmsize);
+  if (pHeader == NULL) goto _over;
+
+  hfd = open(headName, O_RDONLY);
+  pHandle->rfd = open(dataName, O_RDONLY);
+  dfd = open(dataName, O_WRONLY);
+  if (hfd < 0 || pHandle->rfd < 0 || dfd < 0) {
+    dError("vid:%d fileId:%d, failed to open files for compaction, reason:%s", vnode, fileId, strerror(errno));
+    goto _over;
+  }
+
+  fstat(hfd, &filestat);
+  fstat(pHandle->rfd, &datastat);
+  if (filestat.st_size <= TSDB_FILE_HEADER_LEN + tmsize) {
+    code = 0;  // no data in this file
+    goto _over;
+  }
+
+  if (read(hfd, fileHeader, TSDB_FILE_HEADER_LEN) != TSDB_FILE_HEADER_LEN || read(hfd, pHeader, tmsize) != tmsize ||
+      !taosCheckChecksumWhole((uint8_t *)pHeader, tmsize)) {
+    dError("vid:%d fileId:%d, head file:%s is broken, compaction is skipped", vnode, fileId, headName);
+    goto _over;
+  }
+
+  // the data file is rewritten if the space not referred to by the head file is too much
+  int64_t liveSize = vnodeGetLiveDataSize(hfd, pHeader, pVnode->cfg.maxSessions);
+  int64_t deadSize = datastat.st_size - TSDB_FILE_HEADER_LEN - liveSize;
+  if (liveSize >= 0 && deadSize > MAX(liveSize, TSDB_MIN_DATA_FILE_RECLAIM_SIZE)) {
+    dTrace("vid:%d fileId:%d, data file will be rewritten, live:%" PRId64 " dead:%" PRId64, vnode, fileId, liveSize,
+           deadSize);
+    pHandle->reclaim = 1;
+  }
+
+  // nothing to merge if no meter has more than one block, the size of the head file tells it
+  int64_t numOfMeters = 0;
+  for (int sid = 0; sid < pVnode->cfg.maxSessions; ++sid) {
+    if (pHeader[sid].compInfoOffset > 0) numOfMeters++;
+  }
+  int64_t minHeadSize =
+      TSDB_FILE_HEADER_LEN + tmsize + numOfMeters * (sizeof(SCompInfo) + sizeof(SCompBlock) + sizeof(TSCKSUM));
+  if (!pHandle->reclaim && filestat.st_size <= minHeadSize) {
+    code = 0;
+    goto _over;
+  }
+
+  // the new head file is linked to the other one of the two head files on disk, as commit does
+  if (readlink(headName, dHeadName, TSDB_FILENAME_LEN) < 0) goto _over;
+  vnodeGetOtherFileName(dHeadName);
+  symlink(dHeadName, nHeadName);
+
+  nfd = open(nHeadName, O_RDWR | O_CREAT | O_TRUNC, S_IRWXU | S_IRWXG | S_IRWXO);
+  if (nfd < 0) {
+    dError("vid:%d, failed to open new head file:%s, reason:%s", vnode, nHeadName, strerror(errno));
+    goto _over;
+  }
+
+  twrite(nfd, fileHeader, TSDB_FILE_HEADER_LEN);
+  lseek(nfd, tmsize, SEEK_CUR);
+
+  if (pHandle->reclaim) {
+    ndfd = vnodeOpenReclaimDataFile(pHandle, dataName, nDataName, dDataName);
+    if (ndfd < 0) goto _over;
+  }
+
+  // merged blocks are written to the new data file if the data file is rewritten
+  pVnode->dfd = pHandle->reclaim ? ndfd : dfd;
+  pVnode->commitFileId = fileId;
+  int64_t compInfoOffset = TSDB_FILE_HEADER_LEN + tmsize;
+
+  for (int sid = 0; sid < pVnode->cfg.maxSessions; ++sid) {
+    if (pHeader[sid].compInfoOffset == 0) continue;
+
+    lseek(hfd, pHeader[sid].compInfoOffset, SEEK_SET);
+    if (read(hfd, &compInfo, sizeof(SCompInfo)) != sizeof(SCompInfo) ||
+        !taosCheckChecksumWhole((uint8_t *)&compInfo, sizeof(SCompInfo))) {
+      dError("vid:%d sid:%d fileId:%d, compInfo is broken, compaction is skipped", vnode, sid, fileId);
+      goto _over;
+    }
+
+    int numOfBlocks = compInfo.numOfBlocks;
+    if (numOfBlocks > maxBlocks) {
+      maxBlocks = numOfBlocks;
+      tfree(pBlocks);
+      tfree(pNewBlocks);
+      pBlocks = (SCompBlock *)malloc(sizeof(SCompBlock) * maxBlocks);
+      pNewBlocks = (SCompBlock *)malloc(sizeof(SCompBlock) * maxBlocks);
+      if (pBlocks == NULL || pNewBlocks == NULL) goto _over;
+    }
+
+    read(hfd, pBlocks, sizeof(SCompBlock) * numOfBlocks);
+    read(hfd, &chksum, sizeof(TSCKSUM));
+    if (chksum != taosCalcChecksum(0, (uint8_t *)pBlocks, sizeof(SCompBlock) * numOfBlocks)) {
+      dError("vid:%d sid:%d fileId:%d, comp blocks are broken, compaction is skipped", vnode, sid, fileId);
+      goto _over;
+    }
+
+    SMeterObj * pObj = (SMeterObj *)pVnode->meterList[sid];
+    SCompBlock *pFinalBlocks = pBlocks;
+    int         numOfNewBlocks = -1;
+    if (!pHandle->aborted && !vnodeIsCompactAllowed(pVnode)) {
+      dTrace("vid:%d, vnode is busy, compaction is aborted", vnode);
+      pHandle->aborted = 1;
+    }
+
+    // a data file half rewritten is dropped
+    if (pHandle->aborted && pHandle->reclaim) {
+      code = 0;
+      goto _over;
+    }
+
+    if (!pHandle->aborted && pObj != NULL && pObj->uid == compInfo.uid &&
+        !vnodeIsMeterState(pObj, TSDB_METER_STATE_DROPPING)) {
+      numOfNewBlocks = vnodeMergeSmallBlocks(pHandle, pObj, pBlocks, numOfBlocks, pNewBlocks);
+      if (numOfNewBlocks > 0 && numOfNewBlocks < numOfBlocks) {
+        dTrace("vid:%d sid:%d id:%s, fileId:%d, %d blocks are merged into %d blocks", vnode, sid, pObj->meterId, fileId,
+               numOfBlocks, numOfNewBlocks);
+        pHandle->stat.meters++;
+        changed = 1;
+      } else if (numOfNewBlocks >= 0 && !pHandle->reclaim) {
+        numOfNewBlocks = -1;  // nothing is merged, the blocks are kept in place
+      }
+    } else if (pHandle->reclaim) {
+      // blocks of a meter not compacted are still copied into the new data file
+      for (numOfNewBlocks = 0; numOfNewBlocks < numOfBlocks; ++numOfNewBlocks) {
+        if (vnodeKeepBlock(pHandle, pBlocks + numOfNewBlocks, pNewBlocks + numOfNewBlocks) < 0) goto _over;
+      }
+    }
+
+    if (numOfNewBlocks < 0 && pHandle->reclaim) goto _over;
+
+    if (numOfNewBlocks >= 0) {
+      pFinalBlocks = pNewBlocks;
+      numOfBlocks = numOfNewBlocks;
+      compInfo.numOfBlocks = numOfNewBlocks;
+      taosCalcChecksumAppend(0, (uint8_t *)&compInfo, sizeof(SCompInfo));
+    }
+
+    chksum = taosCalcChecksum(0, (uint8_t *)pFinalBlocks, sizeof(SCompBlock) * numOfBlocks);
+    if (twrite(nfd, &compInfo, sizeof(SCompInfo)) <= 0 ||
+        twrite(nfd, pFinalBlocks, sizeof(SCompBlock) * numOfBlocks) <= 0 ||
+        twrite(nfd, &chksum, sizeof(TSCKSUM)) <= 0) {
+      dError("vid:%d, failed to write new head file:%s, reason:%s", vnode, nHeadName, strerror(errno));
+      goto _over;
+    }
+
+    pHeader[sid].compInfoOffset = compInfoOffset;
+    compInfoOffset += sizeof(SCompInfo) + sizeof(SCompBlock) * numOfBlocks + sizeof(TSCKSUM);
+  }
+
+  if (!changed && !pHandle->reclaim) {
+    code = 0;
+    goto _over;
+  }
+
+  taosCalcChecksumAppend(0, (uint8_t *)pHeader, tmsize);
+  lseek(nfd, TSDB_FILE_HEADER_LEN, SEEK_SET);
+  if (twrite(nfd, pHeader, tmsize) <= 0) {
+    dError("vid:%d, failed to write new head file:%s, reason:%s", vnode, nHeadName, strerror(errno));
+    goto _over;
+  }
+
+  close(nfd);
+  nfd = -1;
+
+  int64_t newDataSize = 0;
+  if (pHandle->reclaim) {
+    newDataSize = lseek(ndfd, 0, SEEK_END);
+    fsync(ndfd);
+    close(ndfd);
+    ndfd = -1;
+  }
+
+  pthread_mutex_lock(&(pVnode->vmutex));
+  readlink(headName, dpath, TSDB_FILENAME_LEN);
+  readlink(dataName, ddpath, TSDB_FILENAME_LEN);
+  if (rename(nHeadName, headName) < 0) {
+    dError("vid:%d, failed to rename:%s, reason:%s", vnode, nHeadName, strerror(errno));
+    remove(nHeadName);
+    remove(dHeadName);
+    if (pHandle->reclaim) {
+      remove(nDataName);
+      remove(dDataName);
+    }
+  } else if (pHandle->reclaim && rename(nDataName, dataName) < 0) {
+    // the old head file is linked back, it still matches the old data file
+    dError("vid:%d, failed to rename:%s, reason:%s", vnode, nDataName, strerror(errno));
+    symlink(dpath, nHeadName);
+    rename(nHeadName, headName);
+    remove(dHeadName);
+    remove(nDataName);
+    remove(dDataName);
+  } else {
+    remove(dpath);
+    if (pHandle->reclaim) {
+      remove(ddpath);
+      pVnode->dataVersion++;
+      pHandle->stat.reclaims++;
+      pHandle->stat.reclaimedBytes += datastat.st_size - newDataSize;
+    }
+    code = 0;
+  }
+  pthread_mutex_unlock(&(pVnode->vmutex));
+
+  // a new data file version makes all columns cached for the vnode unreachable
+  vnodeInvalidateBlockCache(vnode, pHandle->reclaim ? -1 : fileId);
+
+  vnodeUpdateFileMagic(vnode, fileId);
+
+_over:
+  if (nfd >= 0) {
+    close(nfd);
+    remove(nHeadName);
+    remove(dHeadName);
+  }
+  if (ndfd >= 0) {
+    close(ndfd);
+    remove(nDataName);
+    remove(dDataName);
+  }
+  if (hfd >= 0) close(hfd);
+  if (dfd >= 0) close(dfd);
+  if (pHandle->rfd >= 0) close(pHandle->rfd);
+  pHandle->rfd = -1;
+  pVnode->dfd = 0;
+  pVnode->dfSize = dfSize;
+
+  tfree(pHeader);
+  tfree(pBlocks);
+  tfree(pNewBlocks);
+
+  return code;
+}
+
+void *vnodeCompactVnode(void *param) {
+  SVnodeObj *    pVnode = (SVnodeObj *)param;
+  SCompactHandle handle = {0};
+  int64_t        startTime = taosGetTimestampUs();
+
+  handle.pVnode = pVnode;
+  handle.rfd = -1;
+  handle.secondStart = taosGetTimestampMs();
+  pVnode->commitInProcess = 1;
+
+  dTrace("vid:%d, start to compact small blocks, fileId:%d numOfFiles:%d", pVnode->vnode, pVnode->fileId,
+         pVnode->numOfFiles);
+
+  for (int fileId = pVnode->fileId - pVnode->numOfFiles + 1; fileId <= pVnode->fileId && !handle.aborted; ++fileId) {
+    if (vnodeCompactFile(&handle, fileId) < 0) {
+      dError("vid:%d fileId:%d, failed to compact small blocks", pVnode->vnode, fileId);
+    }
+  }
+
+  handle.stat.rounds = 1;
+  handle.stat.useconds = taosGetTimestampUs() - startTime;
+
+  SVnodeCompactStat *pStat = &pVnode->compactStat;
+  atomic_add_fetch_64(&pStat->rounds, handle.stat.rounds);
+  atomic_add_fetch_64(&pStat->meters, handle.stat.meters);
+  atomic_add_fetch_64(&pStat->srcBlocks, handle.stat.srcBlocks);
+  atomic_add_fetch_64(&pStat->dstBlocks, handle.stat.dstBlocks);
+  atomic_add_fetch_64(&pStat->srcBytes, handle.stat.srcBytes);
+  atomic_add_fetch_64(&pStat->dstBytes, handle.stat.dstBytes);
+  atomic_add_fetch_64(&pStat->reclaims, handle.stat.reclaims);
+  atomic_add_fetch_64(&pStat->reclaimedBytes, handle.stat.reclaimedBytes);
+  atomic_add_fetch_64(&pStat->useconds, handle.stat.useconds);
+
+  dPrint("vid:%d, compaction is over%s, meters:%" PRId64 " blocks:%" PRId64 "->%" PRId64 " bytes:%" PRId64 "->%" PRId64
+         " reclaimed files:%" PRId64 " bytes:%" PRId64 " elapsed:%.3fs",
+         pVnode->vnode, handle.aborted ? " (aborted)" : "", handle.stat.meters, handle.stat.srcBlocks,
+         handle.stat.dstBlocks, handle.stat.srcBytes, handle.stat.dstBytes, handle.stat.reclaims,
+         handle.stat.reclaimedBytes, handle.stat.useconds / 1000000.0);
+
+  pVnode->commitInProcess = 0;
+  vnodeCommitOver(pVnode);
+  memset(&(pVnode->commitThread), 0, sizeof(pVnode->commitThread));
+
+  // commit requests are ignored during compaction, so the data arrived in the meantime is committed in the usual way
+  if (pVnode->firstKey <= pVnode->lastKey) vnodeProcessCommitTimer(pVnode, NULL);
+
+  return NULL;
+}
+
+void vnodeProcessCompactTimer(void *param, void *tmrId) {
+  SVnodeObj *    pVnode = (SVnodeObj *)param;
+  SCachePool *   pPool = (SCachePool *)pVnode->pCachePool;
+  pthread_attr_t thattr;
+
+  if (pPool == NULL || tsCompactInterval <= 0) return;
+
+  taosTmrReset(vnodeProcessCompactTimer, tsCompactInterval * 1000, pVnode, vnodeTmrCtrl, &pVnode->compactTimer);
+
+  if (!vnodeIsCompactAllowed(pVnode)) {
+    dTrace("vid:%d, vnode is not idle, compaction is skipped", pVnode->vnode);
+    return;
+  }
+
+  pthread_mutex_lock(&pPool->vmutex);
+
+  if (pPool->commitInProcess) {
+    pthread_mutex_unlock(&pPool->vmutex);
+    dTrace("vid:%d, commit is in process, compaction is skipped", pVnode->vnode);
+    return;
+  }
+
+  if (vnodeCommitSchedulerEnabled()) {
+    if (vnodeScheduleCompact(pVnode->vnode) == 0) pPool->commitInProcess = 1;
+    pthread_mutex_unlock(&pPool->vmutex);
+    return;
+  }
+
+  pthread_attr_init(&thattr);
+  pthread_attr_setdetachstate(&thattr, PTHREAD_CREATE_DETACHED);
+  if (pthread_create(&(pVnode->commitThread), &thattr, vnodeCompactVnode, pVnode) != 0) {
+    dError("vid:%d, failed to create thread to compact files, reason:%s", pVnode->vnode, strerror(errno));
+  } else {
+    pPool->commitInProcess = 1;
+    dTrace("vid:%d, compact thread: 0x%lx is created", pVnode->vnode, pVnode->commitThread);
+  }
+
+  pthread_attr_destroy(&thattr);
+  pthread_mutex_unlock(&pPool->vmutex);
+}
+
+void vnodeGetCompactStat(SVnodeCompactStat *pStat) {
+  memset(pStat, 0, sizeof(SVnodeCompactStat));
+
+  for (int vnode = 0; vnode < TSDB_MAX_VNODES; ++vnode) {
+    SVnodeCompactStat *pVnodeStat = &vnodeList[vnode].compactStat;
+    pStat->rounds += atomic_load_64(&pVnodeStat->rounds);
+    pStat->meters += atomic_load_64(&pVnodeStat->meters);
+    pStat->srcBlocks += atomic_load_64(&pVnodeStat->srcBlocks);
+    pStat->dstBlocks += atomic_load_64(&pVnodeStat->dstBlocks);
+    pStat->srcBytes += atomic_load_64(&pVnodeStat->srcBytes);
+    pStat->dstBytes += atomic_load_64(&pVnodeStat->dstBytes);
+    pStat->reclaims += atomic_load_64(&pVnodeStat->reclaims);
+    pStat->reclaimedBytes += atomic_load_64(&pVnodeStat->reclaimedBytes);
+    pStat->useconds += atomic_load_64(&pVnodeStat->useconds);
+  }
+}
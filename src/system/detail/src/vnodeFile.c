@@ -17,8 +17,11 @@
 #include "os.h"
 
 #include "tscompression.h"
+#include "tsched.h"
 #include "tutil.h"
 #include "vnode.h"
+#include "vnodeBlockCache.h"
+#include "vnodeDataFilterFunc.h"
 #include "vnodeFile.h"
 #include "vnodeUtil.h"
 #include "vnodeStatus.h"
@@ -275,7 +278,6 @@ int vnodeOpenCommitFiles(SVnodeObj *pVnode, int noTempLast) {
   }
   vnodeGetHeadTname(pVnode->nfn, pVnode->tfn, vnode, fileId);
   symlink(dHeadName, pVnode->nfn);
-  if (!noTempLast) symlink(dLastName, pVnode->tfn);
 
   // open head file
   pVnode->hfd = open(pVnode->cfn, O_RDONLY);
@@ -342,10 +344,22 @@ int vnodeOpenCommitFiles(SVnodeObj *pVnode, int noTempLast) {
     goto _error;
   }
 
+  // last file is not rewritten until it grows large enough, new last blocks are appended to it instead
+  if (!noTempLast) {
+    SVnodeHeadInfo headInfo;
+    vnodeGetHeadFileHeaderInfo(pVnode->hfd, &headInfo);
+    if (filestat.st_size < 2 * MAX(headInfo.lastFileSize, TSDB_MIN_LAST_FILE_REWRITE_SIZE)) {
+      dTrace("vid:%d, last file size:%" PRId64 " rewritten size:%" PRId64 ", append to it", vnode,
+             (int64_t)filestat.st_size, headInfo.lastFileSize);
+      noTempLast = 1;
+    }
+  }
+
   // open a new last file
   if (noTempLast) {
     pVnode->tfd = -1;  // do not open temporary last file
   } else {
+    symlink(dLastName, pVnode->tfn);
     pVnode->tfd = open(pVnode->tfn, O_RDWR | O_CREAT | O_TRUNC, S_IRWXU | S_IRWXG | S_IRWXO);
     if (pVnode->tfd < 0) {
       dError("vid:%d, failed to open new last file:%s, reason:%s", vnode, pVnode->tfn, strerror(errno));
@@ -426,6 +440,8 @@ void vnodeRemoveFile(int vnode, int fileId) {
   remove(dDataName);
   remove(dLastName);
 
+  vnodeInvalidateBlockCache(vnode, fileId);
+
   dPrint("vid:%d fileId:%d on disk: %s is removed, numOfFiles:%d maxFiles:%d", vnode, fileId, path,
          pVnode->numOfFiles, pVnode->maxFiles);
 }
@@ -485,10 +501,200 @@ void vnodeCloseCommitFiles(SVnodeObj *pVnode) {
 
 void vnodeBroadcastStatusToUnsyncedPeer(SVnodeObj *pVnode);
 
+static void vnodePrepareCompBlock(SMeterObj *pObj, SCompBlock *pCompBlock, SData *data[], int points);
+static int  vnodeCompressBlock(SMeterObj *pObj, SData *data[], SData *cdata[], SField *fields, int points);
+static int  vnodeWriteCompressedBlock(SMeterObj *pObj, SCompBlock *pCompBlock, SData *data[], SData *cdata[],
+                                      SField *fields);
+
+/*
+ * Blocks to be committed go through a pipeline: the commit thread reads a block from cache, hands
+ * it over to the commit threads for compression, and goes on with the next block. Compressed
+ * blocks are written into file by the commit thread in the same order as they are read.
+ */
+typedef struct {
+  SMeterObj * pObj;
+  SCompBlock *pCompBlock;
+  SField *    fields;
+  SData *     data[TSDB_MAX_COLUMNS];
+  SData *     cdata[TSDB_MAX_COLUMNS];
+  char *      dmem;
+  char *      cmem;
+  int         points;
+  int         code;
+  tsem_t      sem;
+} SCommitBlock;
+
+typedef struct {
+  SCommitBlock *pBlocks;
+  int           depth;
+  int           first;        // the oldest block in pipeline, it will be written first
+  int           numOfBlocks;  // number of blocks in pipeline
+  int64_t       blocks;       // number of blocks written
+  int64_t       bytes;        // bytes written
+} SCommitPipe;
+
+static void vnodeCleanUpCommitPipe(SCommitPipe *pPipe) {
+  // blocks may be still in compressing, wait for them
+  for (int i = 0; i < pPipe->numOfBlocks; ++i) {
+    tsem_wait(&pPipe->pBlocks[(pPipe->first + i) % pPipe->depth].sem);
+  }
+  pPipe->numOfBlocks = 0;
+
+  for (int i = 0; pPipe->pBlocks != NULL && i < pPipe->depth; ++i) {
+    SCommitBlock *pBlock = pPipe->pBlocks + i;
+    tsem_destroy(&pBlock->sem);
+    tfree(pBlock->dmem);
+    tfree(pBlock->cmem);
+    tfree(pBlock->fields);
+  }
+
+  tfree(pPipe->pBlocks);
+}
+
+static int vnodeInitCommitPipe(SCommitPipe *pPipe, int dmsize, int cmsize) {
+  memset(pPipe, 0, sizeof(SCommitPipe));
+
+  pPipe->depth = (commitQhandle == NULL) ? 1 : tsNumOfCommitThreads * 2;
+  pPipe->pBlocks = (SCommitBlock *)calloc(pPipe->depth, sizeof(SCommitBlock));
+  if (pPipe->pBlocks == NULL) return -1;
+
+  for (int i = 0; i < pPipe->depth; ++i) {
+    SCommitBlock *pBlock = pPipe->pBlocks + i;
+    tsem_init(&pBlock->sem, 0, 0);
+    pBlock->dmem = malloc(dmsize);
+    pBlock->cmem = malloc(cmsize);
+    pBlock->fields = (SField *)malloc(sizeof(SField) * TSDB_MAX_COLUMNS + sizeof(TSCKSUM));
+    if (pBlock->dmem == NULL || pBlock->cmem == NULL || pBlock->fields == NULL) {
+      pPipe->depth = i + 1;
+      vnodeCleanUpCommitPipe(pPipe);
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+// get the next free block in pipeline, and set up its buffer for the meter
+static SCommitBlock *vnodeGetCommitBlock(SCommitPipe *pPipe, SMeterObj *pObj) {
+  assert(pPipe->numOfBlocks < pPipe->depth);
+  SCommitBlock *pBlock = pPipe->pBlocks + (pPipe->first + pPipe->numOfBlocks) % pPipe->depth;
+
+  pBlock->data[0] = (SData *)pBlock->dmem;
+  pBlock->cdata[0] = (SData *)pBlock->cmem;
+  for (int col = 1; col < pObj->numOfColumns; ++col) {
+    pBlock->data[col] = (SData *)(((char *)pBlock->data[col - 1]) + sizeof(SData) +
+                                  pObj->pointsPerFileBlock * pObj->schema[col - 1].bytes + EXTRA_BYTES + sizeof(TSCKSUM));
+    pBlock->cdata[col] = (SData *)(((char *)pBlock->cdata[col - 1]) + sizeof(SData) +
+                                   pObj->pointsPerFileBlock * pObj->schema[col - 1].bytes + EXTRA_BYTES + sizeof(TSCKSUM));
+  }
+
+  return pBlock;
+}
+
+static void vnodeProcessCompressBlock(SSchedMsg *pMsg) {
+  SCommitBlock *pBlock = (SCommitBlock *)pMsg->ahandle;
+
+  pBlock->code = vnodeCompressBlock(pBlock->pObj, pBlock->data, pBlock->cdata, pBlock->fields, pBlock->points);
+  tsem_post(&pBlock->sem);
+}
+
+static void vnodeSubmitCommitBlock(SCommitPipe *pPipe, SCommitBlock *pBlock, SMeterObj *pObj, SCompBlock *pCompBlock,
+                                   int points) {
+  pBlock->pObj = pObj;
+  pBlock->pCompBlock = pCompBlock;
+  pBlock->points = points;
+  pBlock->code = 0;
+  pPipe->numOfBlocks++;
+
+  vnodePrepareCompBlock(pObj, pCompBlock, pBlock->data, points);
+
+  SSchedMsg schedMsg = {0};
+  schedMsg.fp = vnodeProcessCompressBlock;
+  schedMsg.ahandle = pBlock;
+
+  if (commitQhandle == NULL) {
+    vnodeProcessCompressBlock(&schedMsg);
+  } else {
+    taosScheduleTask(commitQhandle, &schedMsg);
+  }
+}
+
+// write the compressed blocks into file in order, until only maxBlocks are left in pipeline
+static int vnodeFlushCommitPipe(SCommitPipe *pPipe, int maxBlocks) {
+  while (pPipe->numOfBlocks > maxBlocks) {
+    SCommitBlock *pBlock = pPipe->pBlocks + pPipe->first;
+    tsem_wait(&pBlock->sem);
+
+    pPipe->first = (pPipe->first + 1) % pPipe->depth;
+    pPipe->numOfBlocks--;
+
+    if (pBlock->code < 0) {
+      dError("vid:%d sid:%d id:%s, failed to compress block", pBlock->pObj->vnode, pBlock->pObj->sid,
+             pBlock->pObj->meterId);
+      return -1;
+    }
+
+    if (vnodeWriteCompressedBlock(pBlock->pObj, pBlock->pCompBlock, pBlock->data, pBlock->cdata, pBlock->fields) < 0) {
+      return -1;
+    }
+
+    pPipe->blocks++;
+    pPipe->bytes += pBlock->pCompBlock->len;
+  }
+
+  return 0;
+}
+
+/*
+ * If the last file is not rewritten, comp info of the meters which have no data to commit does not change. It is
+ * copied from the old head file span by span, so the comp info has to be laid out in the order of sid. The new head
+ * file still holds the comp info of all meters, and the SCompInfo of each copied meter is still read to check that
+ * its sid is not reused, only the comp blocks of unchanged meters are no longer read and rebuilt.
+ */
+static int vnodeSetOldCompInfoLen(SVnodeObj *pVnode, SCompHeader *pHeader, SMeterInfo *meterInfo, int tmsize) {
+  struct stat filestat;
+  int64_t     offset = 0;
+  int         prev = -1;
+
+  if (fstat(pVnode->hfd, &filestat) < 0) return -1;
+
+  for (int sid = 0; sid < pVnode->cfg.maxSessions; ++sid) {
+    if (pHeader[sid].compInfoOffset == 0) continue;
+    if (pHeader[sid].compInfoOffset < MAX(offset + 1, TSDB_FILE_HEADER_LEN + tmsize) ||
+        pHeader[sid].compInfoOffset >= filestat.st_size) {
+      dWarn("vid:%d sid:%d, compInfoOffset:%" PRId64 " out of order, head file will be rewritten", pVnode->vnode, sid,
+            pHeader[sid].compInfoOffset);
+      return -1;
+    }
+
+    if (prev >= 0) meterInfo[prev].oldCompInfoLen = pHeader[sid].compInfoOffset - offset;
+    offset = pHeader[sid].compInfoOffset;
+    prev = sid;
+  }
+
+  if (prev >= 0) meterInfo[prev].oldCompInfoLen = filestat.st_size - offset;
+
+  return 0;
+}
+
+static int vnodeCopyCompInfo(SVnodeObj *pVnode, int64_t offset, int64_t oldOffset, int64_t len) {
+  if (len <= 0) return 0;
+
+  lseek(pVnode->nfd, offset, SEEK_SET);
+  lseek(pVnode->hfd, oldOffset, SEEK_SET);
+  if (tsendfile(pVnode->nfd, pVnode->hfd, NULL, len) < 0) {
+    dError("vid:%d, failed to copy comp info, offset:%" PRId64 " len:%" PRId64 ", reason:%s", pVnode->vnode, oldOffset,
+           len, strerror(errno));
+    return -1;
+  }
+
+  return 0;
+}
+
 void *vnodeCommitMultiToFile(SVnodeObj *pVnode, int ssid, int esid) {
   int              vnode = pVnode->vnode;
-  SData *          data[TSDB_MAX_COLUMNS], *cdata[TSDB_MAX_COLUMNS];  // first 4 bytes are length
-  char *           buffer = NULL, *dmem = NULL, *cmem = NULL, *hmem = NULL, *tmem = NULL;
+  SData **         data = NULL;  // first 4 bytes are length
+  char *           buffer = NULL, *hmem = NULL, *tmem = NULL;
   SMeterObj *      pObj = NULL;
   SCompInfo        compInfo = {0};
   SCompHeader *    pHeader;
@@ -497,21 +703,30 @@ void *vnodeCommitMultiToFile(SVnodeObj *pVnode, int ssid, int esid) {
   SColumnInfoEx    colList[TSDB_MAX_COLUMNS] = {0};
   SSqlFunctionExpr pExprs[TSDB_MAX_COLUMNS] = {0};
   int              commitAgain;
-  int              headLen, sid, col;
+  int              headLen, sid;
   int64_t          pointsRead;
   int64_t          pointsReadLast;
   SCompBlock *     pCompBlock = NULL;
   SVnodeCfg *      pCfg = &pVnode->cfg;
   TSCKSUM          chksum;
   SVnodeHeadInfo   headInfo;
-  uint8_t *        pOldCompBlocks;
+  uint8_t *        pOldCompBlocks = NULL;
+  SCommitPipe      pipe = {0};
+  SCommitBlock *   pCommitBlock = NULL;
+  int64_t          startTime = taosGetTimestampUs();
+  int              incremental;
+  int64_t          copyOffset, copyOldOffset, copyLen;
 
   dPrint("vid:%d, committing to file, firstKey:%" PRId64 " lastKey:%" PRId64 " ssid:%d esid:%d", vnode, pVnode->firstKey,
          pVnode->lastKey, ssid, esid);
+
+  // out-of-order rows go into cache and files first, so they are committed with the cache
+  vnodeMergeImportBuffers(pVnode, ssid, esid);
   if (pVnode->lastKey == 0) goto _over;
 
   vnodeCloseAllSyncFds(vnode);
   vnodeRenewCommitLog(vnode);
+  vnodeRelogImportBuffers(pVnode, 0, pVnode->cfg.maxSessions - 1);  // the log is renewed for all meters
 
   // get the MAX consumption buffer for this vnode
   int32_t maxBytesPerPoint = 0;
@@ -548,17 +763,21 @@ void *vnodeCommitMultiToFile(SVnodeObj *pVnode, int ssid, int esid) {
   // buffer to hold meterInfo
   int misize = pVnode->cfg.maxSessions * sizeof(SMeterInfo);
 
-  int totalSize = hmsize + dmsize + cmsize + misize + tmsize;
+  int totalSize = hmsize + misize + tmsize;
   buffer = malloc(totalSize);
   if (buffer == NULL) {
     dError("no enough memory for committing buffer");
     return NULL;
   }
 
+  if (vnodeInitCommitPipe(&pipe, dmsize, cmsize) < 0) {
+    dError("vid:%d, no enough memory for committing pipeline", vnode);
+    tfree(buffer);
+    return NULL;
+  }
+
   hmem = buffer;
-  dmem = hmem + hmsize;
-  cmem = dmem + dmsize;
-  tmem = cmem + cmsize;
+  tmem = hmem + hmsize;
   meterInfo = (SMeterInfo *)(tmem + tmsize);
 
   pthread_mutex_lock(&(pVnode->vmutex));
@@ -579,6 +798,7 @@ _again:
   headLen = 0;
   vnodeGetHeadFileHeaderInfo(pVnode->hfd, &headInfo);
   int maxOldBlocks = 1;
+  int copiedMeters = 0;
 
   // read head info
   if (pVnode->hfd) {
@@ -600,6 +820,9 @@ _again:
     }
   }
 
+  // the last file is appended, so meters without data to commit keep their comp info
+  incremental = (pVnode->tfd <= 0) && (vnodeSetOldCompInfoLen(pVnode, (SCompHeader *)tmem, meterInfo, tmsize) == 0);
+
   // read compInfo
   for (sid = 0; sid < pCfg->maxSessions; ++sid) {
     if (pVnode->meterList == NULL) {  // vnode is being freed, abort
@@ -620,6 +843,7 @@ _again:
     pMeter = meterInfo + sid;
     pHeader = ((SCompHeader *)tmem) + sid;
 
+    // comp info of a dropped meter, or of the old meter of a reused sid, is neither copied nor rewritten
     if (pVnode->hfd > 0) {
       if (pHeader->compInfoOffset > 0) {
         lseek(pVnode->hfd, pHeader->compInfoOffset, SEEK_SET);
@@ -631,6 +855,11 @@ _again:
                 vnode, sid, pObj->meterId, pVnode->cfn);
             vnodeRecoverFromPeer(pVnode, pVnode->commitFileId);
             goto _over;
+          } else if (pObj->uid == compInfo.uid && incremental &&
+                     (sid < ssid || sid > esid || pObj->pCache == NULL || pObj->lastKey < pVnode->commitFirstKey)) {
+            pMeter->copied = 1;
+            pMeter->oldCompInfoOffset = pHeader->compInfoOffset;
+            copiedMeters++;
           } else {
             if (pObj->uid == compInfo.uid) {
               pMeter->oldNumOfBlocks = compInfo.numOfBlocks;
@@ -660,14 +889,12 @@ _again:
     pObj = (SMeterObj *)(pVnode->meterList[sid]);
     if ((pObj == NULL) || (pObj->pCache == NULL)) continue;
 
-    data[0] = (SData *)dmem;
-    cdata[0] = (SData *)cmem;
-    for (col = 1; col < pObj->numOfColumns; ++col) {
-      data[col] = (SData *)(((char *)data[col - 1]) + sizeof(SData) +
-                            pObj->pointsPerFileBlock * pObj->schema[col - 1].bytes + EXTRA_BYTES + sizeof(TSCKSUM));
-      cdata[col] = (SData *)(((char *)cdata[col - 1]) + sizeof(SData) +
-                             pObj->pointsPerFileBlock * pObj->schema[col - 1].bytes + EXTRA_BYTES + sizeof(TSCKSUM));
-    }
+    // no data to commit
+    if (incremental && (meterInfo[sid].copied || pObj->lastKey < pVnode->commitFirstKey)) continue;
+
+    if (vnodeFlushCommitPipe(&pipe, pipe.depth - 1) < 0) goto _over;
+    pCommitBlock = vnodeGetCommitBlock(&pipe, pObj);
+    data = pCommitBlock->data;
 
     pMeter = meterInfo + sid;
     pMeter->tempHeadOffset = headLen;
@@ -689,13 +916,17 @@ _again:
     pointsRead = 0;
     pointsReadLast = 0;
 
-    // last block is at last file
+    /*
+     * last block is at last file. It is copied right away, while compressed blocks of the previous meters may still
+     * be in the pipeline. So a copied last block can precede them in the file, the offsets of all blocks are taken
+     * when they are written.
+     */
     if (pMeter->last) {
       if ((pMeter->lastBlock.sversion != pObj->sversion) || (query.over)) {
         // TODO : Check the correctness of this code. write the last block to
         // .data file
         pCompBlock = (SCompBlock *)(hmem + headLen);
-        assert(dmem - (char *)pCompBlock >= sizeof(SCompBlock));
+        assert(headLen + sizeof(SCompBlock) <= hmsize);
         *pCompBlock = pMeter->lastBlock;
         if (pMeter->lastBlock.sversion != pObj->sversion) {
           pCompBlock->last = 0;
@@ -705,8 +936,8 @@ _again:
           tsendfile(pVnode->dfd, pVnode->lfd, NULL, pMeter->lastBlock.len);
           pVnode->dfSize = pCompBlock->offset + pMeter->lastBlock.len;
         } else {
-          if (ssid == 0) {
-            assert(pCompBlock->last && pVnode->tfd != -1);
+          if (pVnode->tfd > 0) {
+            assert(pCompBlock->last);
             pCompBlock->offset = lseek(pVnode->tfd, 0, SEEK_END); 
             lseek(pVnode->lfd, pMeter->lastBlock.offset, SEEK_SET);
             tsendfile(pVnode->tfd, pVnode->lfd, NULL, pMeter->lastBlock.len);
@@ -737,7 +968,7 @@ _again:
 
     while (query.over == 0) {
       pCompBlock = (SCompBlock *)(hmem + headLen);
-      assert(dmem - (char *)pCompBlock >= sizeof(SCompBlock));
+      assert(headLen + sizeof(SCompBlock) <= hmsize);
       pointsRead += pointsReadLast;
 
       while (pointsRead < pObj->pointsPerFileBlock) {
@@ -751,7 +982,7 @@ _again:
 
       headInfo.totalStorage += ((pointsRead - pointsReadLast) * pObj->bytesPerPoint);
       pCompBlock->last = 1;
-      if (vnodeWriteBlockToFile(pObj, pCompBlock, data, cdata, pointsRead) < 0) goto _over;
+      vnodeSubmitCommitBlock(&pipe, pCommitBlock, pObj, pCompBlock, pointsRead);
       if (pCompBlock->keyLast > pObj->lastKeyOnFile) pObj->lastKeyOnFile = pCompBlock->keyLast;
       pMeter->last = pCompBlock->last;
 
@@ -769,6 +1000,10 @@ _again:
 
       pointsRead = 0;
       pointsReadLast = 0;
+
+      if (vnodeFlushCommitPipe(&pipe, pipe.depth - 1) < 0) goto _over;
+      pCommitBlock = vnodeGetCommitBlock(&pipe, pObj);
+      query.sdata = pCommitBlock->data;
     }
 
     dTrace("vid:%d sid:%d id:%s, %d points are committed, lastKey:%" PRId64 " slot:%d pos:%d newNumOfBlocks:%d",
@@ -791,6 +1026,9 @@ _again:
     pthread_mutex_unlock(&(pVnode->vmutex));
   }
 
+  // all blocks shall be in file before the comp blocks are written into head file
+  if (vnodeFlushCommitPipe(&pipe, 0) < 0) goto _over;
+
   if (pVnode->lastKey > pVnode->commitLastKey) commitAgain = 1;
 
   dTrace("vid:%d, finish appending the data file", vnode);
@@ -807,6 +1045,12 @@ _again:
 
     pMeter = meterInfo + sid;
     pMeter->compInfoOffset = compInfoOffset;
+    if (pMeter->copied) {
+      pHeader->compInfoOffset = pMeter->compInfoOffset;
+      compInfoOffset += pMeter->oldCompInfoLen;
+      continue;
+    }
+
     pMeter->finalNumOfBlocks = pMeter->oldNumOfBlocks + pMeter->newNumOfBlocks;
 
     if (pMeter->finalNumOfBlocks > 0) {
@@ -821,6 +1065,7 @@ _again:
   }
 
   // write the comp header into new file
+  if (pVnode->tfd > 0) headInfo.lastFileSize = lseek(pVnode->tfd, 0, SEEK_END);
   vnodeUpdateHeadFileHeader(pVnode->nfd, &headInfo);
   lseek(pVnode->nfd, TSDB_FILE_HEADER_LEN, SEEK_SET);
   taosCalcChecksumAppend(0, (uint8_t *)tmem, tmsize);
@@ -833,14 +1078,32 @@ _again:
 
   pOldCompBlocks = (uint8_t *)malloc(sizeof(SCompBlock) * maxOldBlocks);
 
-  // write the comp block list in new file
+  // write the comp block list in new file, adjacent copied comp info is sent in one span
+  copyOffset = copyOldOffset = copyLen = 0;
   for (sid = 0; sid < pCfg->maxSessions; ++sid) {
     pObj = (SMeterObj *)(pVnode->meterList[sid]);
     if (pObj == NULL) continue;
 
     pMeter = meterInfo + sid;
+    if (pMeter->copied) {
+      if (copyLen > 0 && copyOffset + copyLen == pMeter->compInfoOffset &&
+          copyOldOffset + copyLen == pMeter->oldCompInfoOffset) {
+        copyLen += pMeter->oldCompInfoLen;
+        continue;
+      }
+
+      if (vnodeCopyCompInfo(pVnode, copyOffset, copyOldOffset, copyLen) < 0) goto _over;
+      copyOffset = pMeter->compInfoOffset;
+      copyOldOffset = pMeter->oldCompInfoOffset;
+      copyLen = pMeter->oldCompInfoLen;
+      continue;
+    }
+
     if (pMeter->finalNumOfBlocks <= 0) continue;
 
+    if (vnodeCopyCompInfo(pVnode, copyOffset, copyOldOffset, copyLen) < 0) goto _over;
+    copyLen = 0;
+
     compInfo.last = pMeter->last;
     compInfo.uid = pObj->uid;
     compInfo.numOfBlocks = pMeter->finalNumOfBlocks;
@@ -883,8 +1146,11 @@ _again:
     twrite(pVnode->nfd, &chksum, sizeof(TSCKSUM));
   }
 
+  if (vnodeCopyCompInfo(pVnode, copyOffset, copyOldOffset, copyLen) < 0) goto _over;
+
   tfree(pOldCompBlocks);
-  dTrace("vid:%d, finish writing the new header file:%s", vnode, pVnode->nfn);
+  dTrace("vid:%d, finish writing the new header file:%s, %d meters' comp info copied", vnode, pVnode->nfn,
+         copiedMeters);
   vnodeCloseCommitFiles(pVnode);
 
   for (sid = ssid; sid <= esid; ++sid) {
@@ -904,9 +1170,12 @@ _again:
     goto _again;
   }
 
+  // rows of meters queried at the beginning are older than lastKeyOnFile now, they go into files
+  vnodeMergeImportBuffers(pVnode, ssid, esid);
   vnodeRemoveCommitLog(vnode);
 
 _over:
+  vnodeCleanUpCommitPipe(&pipe);
   pVnode->commitInProcess = 0;
   vnodeCommitOver(pVnode);
   memset(&(vnodeList[vnode].commitThread), 0, sizeof(vnodeList[vnode].commitThread));
@@ -914,7 +1183,17 @@ _over:
   tfree(pOldCompBlocks);
 
   vnodeBroadcastStatusToUnsyncedPeer(pVnode);
-  dPrint("vid:%d, committing is over", vnode);
+
+  int64_t useconds = taosGetTimestampUs() - startTime;
+  SVnodeCommitStat *pStat = &pVnode->commitStat;
+  atomic_add_fetch_64(&pStat->commits, 1);
+  atomic_add_fetch_64(&pStat->blocks, pipe.blocks);
+  atomic_add_fetch_64(&pStat->bytes, pipe.bytes);
+  atomic_add_fetch_64(&pStat->useconds, useconds);
+
+  double seconds = (useconds > 0) ? useconds / 1000000.0 : 1e-6;
+  dPrint("vid:%d, committing is over, blocks:%" PRId64 " bytes:%" PRId64 " elapsed:%.3fs, %.2f MB/s, %.2f blocks/s",
+         vnode, pipe.blocks, pipe.bytes, seconds, pipe.bytes / seconds / 1048576.0, pipe.blocks / seconds);
 
   return pVnode;
 }
@@ -925,6 +1204,18 @@ void *vnodeCommitToFile(void *param) {
   return vnodeCommitMultiToFile(pVnode, 0, pVnode->cfg.maxSessions - 1);
 }
 
+void vnodeGetCommitStat(SVnodeCommitStat *pStat) {
+  memset(pStat, 0, sizeof(SVnodeCommitStat));
+
+  for (int vnode = 0; vnode < TSDB_MAX_VNODES; ++vnode) {
+    SVnodeCommitStat *pVnodeStat = &vnodeList[vnode].commitStat;
+    pStat->commits += atomic_load_64(&pVnodeStat->commits);
+    pStat->blocks += atomic_load_64(&pVnodeStat->blocks);
+    pStat->bytes += atomic_load_64(&pVnodeStat->bytes);
+    pStat->useconds += atomic_load_64(&pVnodeStat->useconds);
+  }
+}
+
 int vnodeGetCompBlockInfo(SMeterObj *pObj, SQuery *pQuery) {
   char        prefix[TSDB_FILENAME_LEN];
   char        fileName[TSDB_FILENAME_LEN];
@@ -1205,37 +1496,45 @@ int vnodeReadLastBlockToMem(SMeterObj *pObj, SCompBlock *pBlock, SData *sdata[])
   return code;
 }
 
-int vnodeWriteBlockToFile(SMeterObj *pObj, SCompBlock *pCompBlock, SData *data[], SData *cdata[], int points) {
+static void vnodePrepareCompBlock(SMeterObj *pObj, SCompBlock *pCompBlock, SData *data[], int points) {
   SVnodeObj *pVnode = &vnodeList[pObj->vnode];
-  SVnodeCfg *pCfg = &pVnode->cfg;
-  int        wlen = 0;
-  SField *   fields = NULL;
-  int        size = sizeof(SField) * pObj->numOfColumns + sizeof(TSCKSUM);
-  int32_t    offset = size;
-  char *     buffer = NULL;
-  int        bufferSize = 0;
-
-  int dfd = pVnode->dfd;
 
   if (pCompBlock->last && (points < pObj->pointsPerFileBlock * tsFileBlockMinPercent)) {
     dTrace("vid:%d sid:%d id:%s, points:%d are written to last block, block stime: %" PRId64 ", block etime: %" PRId64,
            pObj->vnode, pObj->sid, pObj->meterId, points, *((TSKEY *)(data[0]->data)),
            *((TSKEY * )(data[0]->data + (points - 1) * pObj->schema[0].bytes)));
     pCompBlock->last = 1;
-    dfd = pVnode->tfd > 0 ? pVnode->tfd : pVnode->lfd;
   } else {
     pCompBlock->last = 0;
   }
 
-  pCompBlock->offset = lseek(dfd, 0, SEEK_END);
-  pCompBlock->len = 0;
+  pCompBlock->algorithm = pVnode->cfg.compression;
+  pCompBlock->numOfPoints = points;
+  pCompBlock->numOfCols = pObj->numOfColumns;
+  pCompBlock->keyFirst = *((TSKEY *)(data[0]->data));  // hack way to get the key
+  pCompBlock->keyLast = *((TSKEY *)(data[0]->data + (points - 1) * pObj->schema[0].bytes));
+  pCompBlock->sversion = pObj->sversion;
+  assert(pCompBlock->keyFirst <= pCompBlock->keyLast);
+}
 
-  fields = (SField *)calloc(1, size);
-  if (fields == NULL) return -1;
+/*
+ * Compress the columns and calculate the statistics of a block, no file is touched here, so it
+ * can be done in parallel by commit threads.
+ */
+static int vnodeCompressBlock(SMeterObj *pObj, SData *data[], SData *cdata[], SField *fields, int points) {
+  SVnodeCfg *pCfg = &vnodeList[pObj->vnode].cfg;
+  int        size = sizeof(SField) * pObj->numOfColumns + sizeof(TSCKSUM);
+  int32_t    offset = size;
+  char *     buffer = NULL;
+  int        bufferSize = 0;
+
+  memset(fields, 0, size);
 
-  if (pCfg->compression == TWO_STAGE_COMP){
+  // scratch of the second stage, and of the codec not kept when float columns are compressed adaptively
+  if (pCfg->compression == TWO_STAGE_COMP || tsFloatCompression == TSDB_FLOAT_COMP_ADAPTIVE) {
     bufferSize = pObj->maxBytes * points + EXTRA_BYTES;
     buffer = (char *)malloc(bufferSize);
+    if (buffer == NULL) return -1;
   } 
 
   for (int i = 0; i < pObj->numOfColumns; ++i) {
@@ -1262,15 +1561,34 @@ int vnodeWriteBlockToFile(SMeterObj *pObj, SCompBlock *pCompBlock, SData *data[]
 
     getStatistics(data[0]->data, data[i]->data, pObj->schema[i].bytes, points, pObj->schema[i].type, &fields[i].min,
                   &fields[i].max, &fields[i].sum, &fields[i].minIndex, &fields[i].maxIndex, &fields[i].numOfNullPoints);
+
+    if (pObj->schema[i].type == TSDB_DATA_TYPE_BINARY || pObj->schema[i].type == TSDB_DATA_TYPE_NCHAR) {
+      vnodeSetStrFieldStatis(&fields[i], data[i]->data, points);
+    }
   }
 
   tfree(buffer);
 
-  // Write SField part
   taosCalcChecksumAppend(0, (uint8_t *)fields, size);
+  return 0;
+}
+
+static int vnodeWriteCompressedBlock(SMeterObj *pObj, SCompBlock *pCompBlock, SData *data[], SData *cdata[],
+                                     SField *fields) {
+  SVnodeObj *pVnode = &vnodeList[pObj->vnode];
+  SVnodeCfg *pCfg = &pVnode->cfg;
+  int        wlen = 0;
+  int        size = sizeof(SField) * pObj->numOfColumns + sizeof(TSCKSUM);
+
+  int dfd = pVnode->dfd;
+  if (pCompBlock->last) dfd = pVnode->tfd > 0 ? pVnode->tfd : pVnode->lfd;
+
+  pCompBlock->offset = lseek(dfd, 0, SEEK_END);
+  pCompBlock->len = 0;
+
+  // Write SField part
   wlen = twrite(dfd, fields, size);
   if (wlen <= 0) {
-    tfree(fields);
     dError("vid:%d sid:%d id:%s, failed to write block, wlen:%d reason:%s", pObj->vnode, pObj->sid, pObj->meterId, wlen,
            strerror(errno));
 #ifdef CLUSTER		   
@@ -1282,7 +1600,6 @@ int vnodeWriteBlockToFile(SMeterObj *pObj, SCompBlock *pCompBlock, SData *data[]
   pVnode->vnodeStatistic.compStorage += wlen;
   pVnode->dfSize += wlen;
   pCompBlock->len += wlen;
-  tfree(fields);
 
   // Write data part
   for (int i = 0; i < pObj->numOfColumns; ++i) {
@@ -1294,7 +1611,7 @@ int vnodeWriteBlockToFile(SMeterObj *pObj, SCompBlock *pCompBlock, SData *data[]
 
     if (wlen <= 0) {
       dError("vid:%d sid:%d id:%s, failed to write block, wlen:%d points:%d reason:%s",
-             pObj->vnode, pObj->sid, pObj->meterId, wlen, points, strerror(errno));
+             pObj->vnode, pObj->sid, pObj->meterId, wlen, pCompBlock->numOfPoints, strerror(errno));
       return vnodeRecoverFromPeer(pVnode, pVnode->commitFileId);
     }
 
@@ -1305,17 +1622,25 @@ int vnodeWriteBlockToFile(SMeterObj *pObj, SCompBlock *pCompBlock, SData *data[]
 
   dTrace("vid:%d, vnode compStorage size is: %" PRId64, pObj->vnode, pVnode->vnodeStatistic.compStorage);
 
-  pCompBlock->algorithm = pCfg->compression;
-  pCompBlock->numOfPoints = points;
-  pCompBlock->numOfCols = pObj->numOfColumns;
-  pCompBlock->keyFirst = *((TSKEY *)(data[0]->data));  // hack way to get the key
-  pCompBlock->keyLast = *((TSKEY *)(data[0]->data + (points - 1) * pObj->schema[0].bytes));
-  pCompBlock->sversion = pObj->sversion;
-  assert(pCompBlock->keyFirst <= pCompBlock->keyLast);
-
   return 0;
 }
 
+int vnodeWriteBlockToFile(SMeterObj *pObj, SCompBlock *pCompBlock, SData *data[], SData *cdata[], int points) {
+  int     size = sizeof(SField) * pObj->numOfColumns + sizeof(TSCKSUM);
+  SField *fields = (SField *)calloc(1, size);
+  if (fields == NULL) return -1;
+
+  vnodePrepareCompBlock(pObj, pCompBlock, data, points);
+
+  int code = vnodeCompressBlock(pObj, data, cdata, fields, points);
+  if (code == 0) {
+    code = vnodeWriteCompressedBlock(pObj, pCompBlock, data, cdata, fields);
+  }
+
+  tfree(fields);
+  return code;
+}
+
 static int forwardInFile(SQuery *pQuery, int32_t midSlot, int32_t step, SVnodeObj *pVnode, SMeterObj *pObj);
 
 int vnodeSearchPointInFile(SMeterObj *pObj, SQuery *pQuery) {
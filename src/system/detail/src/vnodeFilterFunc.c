@@ -16,11 +16,18 @@
 #define _DEFAULT_SOURCE
 #include "os.h"
 
+#include "hashutil.h"
 #include "taosmsg.h"
 #include "tsqlfunction.h"
 #include "vnode.h"
+#include "tutil.h"
 #include "vnodeDataFilterFunc.h"
 
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define BATCH_FILTER_X86
+#include <immintrin.h>
+#endif
+
 bool less_i8(SColumnFilterElem *pFilter, char *minval, char *maxval) {
   return (*(int8_t *)minval < pFilter->filterInfo.upperBndi);
 }
@@ -556,3 +563,681 @@ __filter_func_t* vnodeGetValueFilterFuncArray(int32_t type) {
 }
 
 bool vnodeSupportPrefilter(int32_t type) { return type != TSDB_DATA_TYPE_BINARY && type != TSDB_DATA_TYPE_NCHAR; }
+
+////////////////////////////////////////////////////////////////////////////
+// statistics of binary/nchar columns in SField: prefixes of the min/max value in min/max, and a bloom filter
+#define STR_PREFIX_BYTES  ((int32_t)sizeof(int64_t))
+#define STR_BLOOM_HASHES  3
+
+// the length in bytes of a binary/nchar value without the trailing zeros
+static int32_t vnodeGetStrLen(const char *val, int16_t type, int32_t bytes) {
+  if (type == TSDB_DATA_TYPE_BINARY) {
+    return (int32_t)strnlen(val, (size_t)bytes);
+  }
+
+  int32_t len = 0;
+  while (len + TSDB_NCHAR_SIZE <= bytes) {
+    uint32_t c = 0;
+    memcpy(&c, val + len, TSDB_NCHAR_SIZE);
+    if (c == 0) break;
+
+    len += TSDB_NCHAR_SIZE;
+  }
+
+  return len;
+}
+
+// compare the first n bytes of two prefixes, nchar is compared by character
+static int32_t vnodeCompareStrPrefix(const char *p1, const char *p2, int32_t n, int16_t type) {
+  if (type == TSDB_DATA_TYPE_BINARY) {
+    return memcmp(p1, p2, (size_t)n);
+  }
+
+  for (int32_t i = 0; i + TSDB_NCHAR_SIZE <= n; i += TSDB_NCHAR_SIZE) {
+    int32_t c1 = 0, c2 = 0;
+    memcpy(&c1, p1 + i, TSDB_NCHAR_SIZE);
+    memcpy(&c2, p2 + i, TSDB_NCHAR_SIZE);
+    if (c1 != c2) {
+      return (c1 < c2) ? -1 : 1;
+    }
+  }
+
+  return 0;
+}
+
+static void vnodeGetStrBloomBits(const char *val, int32_t len, uint32_t bits[]) {
+  uint32_t h1 = MurmurHash3_32(val, (uint32_t)len);
+  uint32_t h2 = ((h1 >> 17) | (h1 << 15)) | 1;
+
+  for (int32_t i = 0; i < STR_BLOOM_HASHES; ++i) {
+    bits[i] = (h1 + i * h2) % TSDB_FIELD_BLOOM_BITS;
+  }
+}
+
+void vnodeSetStrFieldStatis(SField *pField, const char *data, int32_t numOfRows) {
+  int16_t     type = pField->type;
+  int32_t     bytes = pField->bytes;
+  char        minPrefix[STR_PREFIX_BYTES] = {0};
+  char        maxPrefix[STR_PREFIX_BYTES] = {0};
+  const char *prev = NULL;
+  int32_t     prevLen = 0;
+
+  memset(pField->bloom, 0, sizeof(pField->bloom));
+
+  for (int32_t i = 0; i < numOfRows; ++i) {
+    const char *val = data + (int64_t)bytes * i;
+    if (isNull(val, type)) {
+      continue;
+    }
+
+    int32_t len = vnodeGetStrLen(val, type, bytes);
+
+    // values of a column, such as a device state, are often repeated in consecutive rows
+    if (prev != NULL && prevLen == len && memcmp(prev, val, (size_t)len) == 0) {
+      continue;
+    }
+
+    char prefix[STR_PREFIX_BYTES] = {0};
+    memcpy(prefix, val, (size_t)MIN(len, STR_PREFIX_BYTES));
+
+    if (prev == NULL || vnodeCompareStrPrefix(prefix, minPrefix, STR_PREFIX_BYTES, type) < 0) {
+      memcpy(minPrefix, prefix, STR_PREFIX_BYTES);
+    }
+
+    if (prev == NULL || vnodeCompareStrPrefix(prefix, maxPrefix, STR_PREFIX_BYTES, type) > 0) {
+      memcpy(maxPrefix, prefix, STR_PREFIX_BYTES);
+    }
+
+    uint32_t bits[STR_BLOOM_HASHES];
+    vnodeGetStrBloomBits(val, len, bits);
+    for (int32_t j = 0; j < STR_BLOOM_HASHES; ++j) {
+      pField->bloom[bits[j] >> 6] |= (1ULL << (bits[j] & 63));
+    }
+
+    prev = val;
+    prevLen = len;
+  }
+
+  memcpy(&pField->min, minPrefix, STR_PREFIX_BYTES);
+  memcpy(&pField->max, maxPrefix, STR_PREFIX_BYTES);
+  pField->strStatisVer = TSDB_FIELD_STR_STATIS_VERSION;
+}
+
+// the length in bytes of the pattern before the first wildcard or case insensitive character
+static int32_t vnodeGetLikePrefixLen(const char *pattern, int32_t len, int16_t type) {
+  SPatternCompareInfo info = PATTERN_COMPARE_INFO_INITIALIZER;
+
+  int32_t n = 0;
+  if (type == TSDB_DATA_TYPE_BINARY) {
+    for (; n < len; ++n) {
+      int c = (uint8_t)pattern[n];
+      if (c == info.matchAll || c == info.matchOne || tolower(c) != toupper(c)) break;
+    }
+  } else {
+    for (; n + TSDB_NCHAR_SIZE <= len; n += TSDB_NCHAR_SIZE) {
+      wchar_t c = 0;
+      memcpy(&c, pattern + n, TSDB_NCHAR_SIZE);
+      if (c == info.matchAll || c == info.matchOne || towlower(c) != towupper(c)) break;
+    }
+  }
+
+  return n;
+}
+
+bool vnodeStrPrefilter(SColumnFilterElem *pFilter, int16_t type, SField *pField) {
+  if (pField->strStatisVer != TSDB_FIELD_STR_STATIS_VERSION) {
+    return true;  // block written without the statistics
+  }
+
+  const char *pz = (const char *)pFilter->filterInfo.pz;
+  int32_t     len = (int32_t)pFilter->filterInfo.len;
+  const char *minPrefix = (const char *)&pField->min;
+  const char *maxPrefix = (const char *)&pField->max;
+
+  if (pFilter->filterInfo.lowerRelOptr == TSDB_RELATION_EQUAL) {
+    // query condition string is greater than the max length of string, not qualified data
+    if (len > pFilter->bytes) {
+      return false;
+    }
+
+    len = vnodeGetStrLen(pz, type, len);
+
+    char prefix[STR_PREFIX_BYTES] = {0};
+    memcpy(prefix, pz, (size_t)MIN(len, STR_PREFIX_BYTES));
+    if (vnodeCompareStrPrefix(prefix, minPrefix, STR_PREFIX_BYTES, type) < 0 ||
+        vnodeCompareStrPrefix(prefix, maxPrefix, STR_PREFIX_BYTES, type) > 0) {
+      return false;
+    }
+
+    uint32_t bits[STR_BLOOM_HASHES];
+    vnodeGetStrBloomBits(pz, len, bits);
+    for (int32_t j = 0; j < STR_BLOOM_HASHES; ++j) {
+      if ((pField->bloom[bits[j] >> 6] & (1ULL << (bits[j] & 63))) == 0) {
+        return false;
+      }
+    }
+
+    return true;
+  } else if (pFilter->filterInfo.lowerRelOptr == TSDB_RELATION_LIKE) {
+    int32_t n = MIN(vnodeGetLikePrefixLen(pz, len, type), STR_PREFIX_BYTES);
+    if (n == 0) {
+      return true;
+    }
+
+    // all qualified values start with the n bytes, which must be in the range of the prefixes
+    return vnodeCompareStrPrefix(pz, minPrefix, n, type) >= 0 && vnodeCompareStrPrefix(pz, maxPrefix, n, type) <= 0;
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// batch filter, evaluate a filter over a column of the data block at a time
+#define BATCH_FILTER_CHUNK 1024
+
+static pthread_once_t batchFilterOnce = PTHREAD_ONCE_INIT;
+static bool           batchFilterAVX2 = false;
+
+#ifdef BATCH_FILTER_X86
+static uint64_t batchFilterMaskBytes[256];  // bit i of the compare mask to byte i, 0 or 1
+
+static void vnodeInitBatchFilterEnv() {
+  for (int32_t m = 0; m < 256; ++m) {
+    uint64_t bytes = 0;
+    for (int32_t i = 0; i < 8; ++i) {
+      if (m & (1 << i)) bytes |= (uint64_t)1 << (i * 8);
+    }
+    batchFilterMaskBytes[m] = bytes;
+  }
+
+  __builtin_cpu_init();
+  batchFilterAVX2 = __builtin_cpu_supports("avx2");
+}
+#else
+static void vnodeInitBatchFilterEnv() {}
+#endif
+
+static void vnodeGetIntegerTypeRange(int16_t type, int64_t *minVal, int64_t *maxVal) {
+  switch (type) {
+    case TSDB_DATA_TYPE_BOOL:
+    case TSDB_DATA_TYPE_TINYINT:  *minVal = INT8_MIN;  *maxVal = INT8_MAX;  break;
+    case TSDB_DATA_TYPE_SMALLINT: *minVal = INT16_MIN; *maxVal = INT16_MAX; break;
+    case TSDB_DATA_TYPE_INT:      *minVal = INT32_MIN; *maxVal = INT32_MAX; break;
+    default:                      *minVal = INT64_MIN; *maxVal = INT64_MAX; break;
+  }
+}
+
+// the bounds are clipped to the value range of the column type, so the kernels never overflow
+static void vnodeSetIntegerBatchBound(SColumnFilterElem *pFilter, int32_t optr, int64_t bnd, int64_t minVal,
+                                      int64_t maxVal) {
+  switch (optr) {
+    case TSDB_RELATION_LARGE:
+      if (bnd >= maxVal) {
+        pFilter->batchOptr = TSDB_BATCH_FILTER_NONE;
+      } else if (bnd + 1 > pFilter->batchLowerBndi) {
+        pFilter->batchLowerBndi = bnd + 1;
+      }
+      break;
+    case TSDB_RELATION_LARGE_EQUAL:
+      if (bnd > maxVal) {
+        pFilter->batchOptr = TSDB_BATCH_FILTER_NONE;
+      } else if (bnd > pFilter->batchLowerBndi) {
+        pFilter->batchLowerBndi = bnd;
+      }
+      break;
+    case TSDB_RELATION_LESS:
+      if (bnd <= minVal) {
+        pFilter->batchOptr = TSDB_BATCH_FILTER_NONE;
+      } else if (bnd - 1 < pFilter->batchUpperBndi) {
+        pFilter->batchUpperBndi = bnd - 1;
+      }
+      break;
+    case TSDB_RELATION_LESS_EQUAL:
+      if (bnd < minVal) {
+        pFilter->batchOptr = TSDB_BATCH_FILTER_NONE;
+      } else if (bnd < pFilter->batchUpperBndi) {
+        pFilter->batchUpperBndi = bnd;
+      }
+      break;
+    case TSDB_RELATION_EQUAL:
+      if (bnd < minVal || bnd > maxVal) {
+        pFilter->batchOptr = TSDB_BATCH_FILTER_NONE;
+      } else {
+        pFilter->batchLowerBndi = bnd;
+        pFilter->batchUpperBndi = bnd;
+      }
+      break;
+    case TSDB_RELATION_NOT_EQUAL:
+      // a value out of the type range is not equal to any value
+      if (bnd >= minVal && bnd <= maxVal) {
+        pFilter->batchOptr = TSDB_BATCH_FILTER_NOT_EQUAL;
+        pFilter->batchLowerBndi = bnd;
+      }
+      break;
+    default:
+      pFilter->batchOptr = TSDB_BATCH_FILTER_ROW;
+  }
+}
+
+// the exclusive bounds are turned into the inclusive adjacent doubles
+static void vnodeSetFloatBatchBound(SColumnFilterElem *pFilter, int32_t optr, double bnd) {
+  if (isnan(bnd) && optr != TSDB_RELATION_NOT_EQUAL) {
+    pFilter->batchOptr = TSDB_BATCH_FILTER_NONE;
+    return;
+  }
+
+  switch (optr) {
+    case TSDB_RELATION_LARGE:
+      if (bnd == INFINITY) {
+        pFilter->batchOptr = TSDB_BATCH_FILTER_NONE;
+      } else if (nextafter(bnd, INFINITY) > pFilter->batchLowerBndd) {
+        pFilter->batchLowerBndd = nextafter(bnd, INFINITY);
+      }
+      break;
+    case TSDB_RELATION_LARGE_EQUAL:
+      if (bnd > pFilter->batchLowerBndd) pFilter->batchLowerBndd = bnd;
+      break;
+    case TSDB_RELATION_LESS:
+      if (bnd == -INFINITY) {
+        pFilter->batchOptr = TSDB_BATCH_FILTER_NONE;
+      } else if (nextafter(bnd, -INFINITY) < pFilter->batchUpperBndd) {
+        pFilter->batchUpperBndd = nextafter(bnd, -INFINITY);
+      }
+      break;
+    case TSDB_RELATION_LESS_EQUAL:
+      if (bnd < pFilter->batchUpperBndd) pFilter->batchUpperBndd = bnd;
+      break;
+    case TSDB_RELATION_EQUAL:
+      pFilter->batchLowerBndd = bnd;
+      pFilter->batchUpperBndd = bnd;
+      break;
+    case TSDB_RELATION_NOT_EQUAL:
+      pFilter->batchOptr = TSDB_BATCH_FILTER_NOT_EQUAL;
+      pFilter->batchLowerBndd = bnd;
+      break;
+    default:
+      pFilter->batchOptr = TSDB_BATCH_FILTER_ROW;
+  }
+}
+
+void vnodeInitBatchFilter(SColumnFilterElem *pFilter, int16_t type) {
+  pthread_once(&batchFilterOnce, vnodeInitBatchFilterEnv);
+
+  SColumnFilterInfo *pInfo = &pFilter->filterInfo;
+  int32_t            lower = pInfo->lowerRelOptr;
+  int32_t            upper = pInfo->upperRelOptr;
+
+  // the single relation filter functions compare less/less equal with upperBnd, and others with lowerBnd
+  bool    isRange = (lower != TSDB_RELATION_INVALID && upper != TSDB_RELATION_INVALID);
+  int32_t optr = (lower != TSDB_RELATION_INVALID) ? lower : upper;
+  bool    useUpper = (optr == TSDB_RELATION_LESS || optr == TSDB_RELATION_LESS_EQUAL);
+
+  pFilter->batchOptr = TSDB_BATCH_FILTER_RANGE;
+
+  switch (type) {
+    case TSDB_DATA_TYPE_BOOL:
+    case TSDB_DATA_TYPE_TINYINT:
+    case TSDB_DATA_TYPE_SMALLINT:
+    case TSDB_DATA_TYPE_INT:
+    case TSDB_DATA_TYPE_BIGINT:
+    case TSDB_DATA_TYPE_TIMESTAMP: {
+      int64_t minVal = 0, maxVal = 0;
+      vnodeGetIntegerTypeRange(type, &minVal, &maxVal);
+      pFilter->batchLowerBndi = minVal;
+      pFilter->batchUpperBndi = maxVal;
+
+      if (isRange) {
+        vnodeSetIntegerBatchBound(pFilter, lower, pInfo->lowerBndi, minVal, maxVal);
+        vnodeSetIntegerBatchBound(pFilter, upper, pInfo->upperBndi, minVal, maxVal);
+      } else {
+        vnodeSetIntegerBatchBound(pFilter, optr, useUpper ? pInfo->upperBndi : pInfo->lowerBndi, minVal, maxVal);
+      }
+
+      if (pFilter->batchOptr == TSDB_BATCH_FILTER_RANGE && pFilter->batchLowerBndi > pFilter->batchUpperBndi) {
+        pFilter->batchOptr = TSDB_BATCH_FILTER_NONE;
+      }
+      break;
+    }
+    case TSDB_DATA_TYPE_FLOAT:
+    case TSDB_DATA_TYPE_DOUBLE: {
+      pFilter->batchLowerBndd = -INFINITY;
+      pFilter->batchUpperBndd = INFINITY;
+
+      if (isRange) {
+        vnodeSetFloatBatchBound(pFilter, lower, pInfo->lowerBndd);
+        vnodeSetFloatBatchBound(pFilter, upper, pInfo->upperBndd);
+      } else if (optr == TSDB_RELATION_EQUAL && type == TSDB_DATA_TYPE_FLOAT) {
+        pFilter->batchOptr = TSDB_BATCH_FILTER_EQUAL_EPS;  // keep the tolerance of equal_ds
+        pFilter->batchLowerBndd = pInfo->lowerBndd;
+      } else {
+        vnodeSetFloatBatchBound(pFilter, optr, useUpper ? pInfo->upperBndd : pInfo->lowerBndd);
+      }
+
+      // float values are compared in double by the filter functions, use the float bounds that are equivalent
+      if (pFilter->batchOptr == TSDB_BATCH_FILTER_RANGE && type == TSDB_DATA_TYPE_FLOAT) {
+        float lowerBnd = (float)pFilter->batchLowerBndd;
+        if ((double)lowerBnd < pFilter->batchLowerBndd) lowerBnd = nextafterf(lowerBnd, INFINITY);
+
+        float upperBnd = (float)pFilter->batchUpperBndd;
+        if ((double)upperBnd > pFilter->batchUpperBndd) upperBnd = nextafterf(upperBnd, -INFINITY);
+
+        pFilter->batchLowerBndd = lowerBnd;
+        pFilter->batchUpperBndd = upperBnd;
+      }
+
+      if (pFilter->batchOptr == TSDB_BATCH_FILTER_RANGE && !(pFilter->batchLowerBndd <= pFilter->batchUpperBndd)) {
+        pFilter->batchOptr = TSDB_BATCH_FILTER_NONE;
+      }
+      break;
+    }
+    default:
+      pFilter->batchOptr = TSDB_BATCH_FILTER_ROW;
+  }
+}
+
+#define BATCH_FILTER_RANGE(_type, _data, _num, _lower, _upper, _sel)  \
+  do {                                                                \
+    const _type *p = (const _type *)(_data);                          \
+    _type        lowerBnd = (_type)(_lower);                          \
+    _type        upperBnd = (_type)(_upper);                          \
+    for (int32_t i = 0; i < (_num); ++i) {                            \
+      (_sel)[i] |= (uint8_t)((p[i] >= lowerBnd) & (p[i] <= upperBnd)); \
+    }                                                                 \
+  } while (0)
+
+#define BATCH_FILTER_NOT_EQUAL(_type, _data, _num, _val, _sel) \
+  do {                                                         \
+    const _type *p = (const _type *)(_data);                   \
+    for (int32_t i = 0; i < (_num); ++i) {                     \
+      (_sel)[i] |= (uint8_t)(p[i] != (_val));                  \
+    }                                                          \
+  } while (0)
+
+#define BATCH_FILTER_NOT_NULL(_type, _null, _data, _num, _colSel, _sel)         \
+  do {                                                                         \
+    const _type *p = (const _type *)(_data);                                   \
+    for (int32_t i = 0; i < (_num); ++i) {                                     \
+      (_sel)[i] &= (uint8_t)((_colSel)[i] & (uint8_t)(p[i] != (_type)(_null))); \
+    }                                                                          \
+  } while (0)
+
+#ifdef BATCH_FILTER_X86
+static FORCE_INLINE void vnodeSetBatchFilterMask(uint8_t *sel, int32_t mask) {
+  uint64_t bytes = 0;
+  memcpy(&bytes, sel, sizeof(bytes));
+  bytes |= batchFilterMaskBytes[mask];
+  memcpy(sel, &bytes, sizeof(bytes));
+}
+
+/*
+ * the AVX2 kernels handle eight values at a time and return the number of values done,
+ * the remaining ones are left to the scalar loops
+ */
+__attribute__((target("avx2"))) static int32_t vnodeRangeFilterI32AVX2(const int32_t *p, int32_t num,
+                                                                        int32_t lowerBnd, int32_t upperBnd,
+                                                                        uint8_t *sel) {
+  __m256i lower = _mm256_set1_epi32(lowerBnd);
+  __m256i upper = _mm256_set1_epi32(upperBnd);
+
+  int32_t i = 0;
+  for (; i + 8 <= num; i += 8) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+    __m256i out = _mm256_or_si256(_mm256_cmpgt_epi32(lower, v), _mm256_cmpgt_epi32(v, upper));
+    vnodeSetBatchFilterMask(sel + i, ~_mm256_movemask_ps(_mm256_castsi256_ps(out)) & 0xFF);
+  }
+
+  return i;
+}
+
+__attribute__((target("avx2"))) static int32_t vnodeRangeFilterI64AVX2(const int64_t *p, int32_t num,
+                                                                        int64_t lowerBnd, int64_t upperBnd,
+                                                                        uint8_t *sel) {
+  __m256i lower = _mm256_set1_epi64x(lowerBnd);
+  __m256i upper = _mm256_set1_epi64x(upperBnd);
+
+  int32_t i = 0;
+  for (; i + 8 <= num; i += 8) {
+    __m256i v1 = _mm256_loadu_si256((const __m256i *)(p + i));
+    __m256i v2 = _mm256_loadu_si256((const __m256i *)(p + i + 4));
+    __m256i out1 = _mm256_or_si256(_mm256_cmpgt_epi64(lower, v1), _mm256_cmpgt_epi64(v1, upper));
+    __m256i out2 = _mm256_or_si256(_mm256_cmpgt_epi64(lower, v2), _mm256_cmpgt_epi64(v2, upper));
+
+    int32_t mask = _mm256_movemask_pd(_mm256_castsi256_pd(out1)) | (_mm256_movemask_pd(_mm256_castsi256_pd(out2)) << 4);
+    vnodeSetBatchFilterMask(sel + i, ~mask & 0xFF);
+  }
+
+  return i;
+}
+
+__attribute__((target("avx2"))) static int32_t vnodeRangeFilterFloatAVX2(const float *p, int32_t num,
+                                                                          float lowerBnd, float upperBnd,
+                                                                          uint8_t *sel) {
+  __m256 lower = _mm256_set1_ps(lowerBnd);
+  __m256 upper = _mm256_set1_ps(upperBnd);
+
+  int32_t i = 0;
+  for (; i + 8 <= num; i += 8) {
+    __m256 v = _mm256_loadu_ps(p + i);
+    __m256 in = _mm256_and_ps(_mm256_cmp_ps(v, lower, _CMP_GE_OQ), _mm256_cmp_ps(v, upper, _CMP_LE_OQ));
+    vnodeSetBatchFilterMask(sel + i, _mm256_movemask_ps(in));
+  }
+
+  return i;
+}
+
+__attribute__((target("avx2"))) static int32_t vnodeRangeFilterDoubleAVX2(const double *p, int32_t num,
+                                                                           double lowerBnd, double upperBnd,
+                                                                           uint8_t *sel) {
+  __m256d lower = _mm256_set1_pd(lowerBnd);
+  __m256d upper = _mm256_set1_pd(upperBnd);
+
+  int32_t i = 0;
+  for (; i + 8 <= num; i += 8) {
+    __m256d v1 = _mm256_loadu_pd(p + i);
+    __m256d v2 = _mm256_loadu_pd(p + i + 4);
+    __m256d in1 = _mm256_and_pd(_mm256_cmp_pd(v1, lower, _CMP_GE_OQ), _mm256_cmp_pd(v1, upper, _CMP_LE_OQ));
+    __m256d in2 = _mm256_and_pd(_mm256_cmp_pd(v2, lower, _CMP_GE_OQ), _mm256_cmp_pd(v2, upper, _CMP_LE_OQ));
+    vnodeSetBatchFilterMask(sel + i, _mm256_movemask_pd(in1) | (_mm256_movemask_pd(in2) << 4));
+  }
+
+  return i;
+}
+#endif
+
+static void vnodeRangeFilterColumn(SColumnFilterElem *pFilter, int16_t type, char *pData, int32_t num,
+                                   uint8_t *sel) {
+  int32_t done = 0;
+
+  switch (type) {
+    case TSDB_DATA_TYPE_BOOL:
+    case TSDB_DATA_TYPE_TINYINT:
+      BATCH_FILTER_RANGE(int8_t, pData, num, pFilter->batchLowerBndi, pFilter->batchUpperBndi, sel);
+      break;
+    case TSDB_DATA_TYPE_SMALLINT:
+      BATCH_FILTER_RANGE(int16_t, pData, num, pFilter->batchLowerBndi, pFilter->batchUpperBndi, sel);
+      break;
+    case TSDB_DATA_TYPE_INT:
+#ifdef BATCH_FILTER_X86
+      if (batchFilterAVX2) {
+        done = vnodeRangeFilterI32AVX2((int32_t *)pData, num, (int32_t)pFilter->batchLowerBndi,
+                                       (int32_t)pFilter->batchUpperBndi, sel);
+      }
+#endif
+      BATCH_FILTER_RANGE(int32_t, (int32_t *)pData + done, num - done, pFilter->batchLowerBndi,
+                         pFilter->batchUpperBndi, sel + done);
+      break;
+    case TSDB_DATA_TYPE_BIGINT:
+    case TSDB_DATA_TYPE_TIMESTAMP:
+#ifdef BATCH_FILTER_X86
+      if (batchFilterAVX2) {
+        done = vnodeRangeFilterI64AVX2((int64_t *)pData, num, pFilter->batchLowerBndi, pFilter->batchUpperBndi, sel);
+      }
+#endif
+      BATCH_FILTER_RANGE(int64_t, (int64_t *)pData + done, num - done, pFilter->batchLowerBndi,
+                         pFilter->batchUpperBndi, sel + done);
+      break;
+    case TSDB_DATA_TYPE_FLOAT:
+#ifdef BATCH_FILTER_X86
+      if (batchFilterAVX2) {
+        done = vnodeRangeFilterFloatAVX2((float *)pData, num, (float)pFilter->batchLowerBndd,
+                                         (float)pFilter->batchUpperBndd, sel);
+      }
+#endif
+      BATCH_FILTER_RANGE(float, (float *)pData + done, num - done, pFilter->batchLowerBndd, pFilter->batchUpperBndd,
+                         sel + done);
+      break;
+    case TSDB_DATA_TYPE_DOUBLE:
+#ifdef BATCH_FILTER_X86
+      if (batchFilterAVX2) {
+        done = vnodeRangeFilterDoubleAVX2((double *)pData, num, pFilter->batchLowerBndd, pFilter->batchUpperBndd, sel);
+      }
+#endif
+      BATCH_FILTER_RANGE(double, (double *)pData + done, num - done, pFilter->batchLowerBndd,
+                         pFilter->batchUpperBndd, sel + done);
+      break;
+    default:
+      assert(false);
+  }
+}
+
+static void vnodeNotEqualFilterColumn(SColumnFilterElem *pFilter, int16_t type, char *pData, int32_t num,
+                                      uint8_t *sel) {
+  switch (type) {
+    case TSDB_DATA_TYPE_BOOL:
+    case TSDB_DATA_TYPE_TINYINT:
+      BATCH_FILTER_NOT_EQUAL(int8_t, pData, num, (int8_t)pFilter->batchLowerBndi, sel);
+      break;
+    case TSDB_DATA_TYPE_SMALLINT:
+      BATCH_FILTER_NOT_EQUAL(int16_t, pData, num, (int16_t)pFilter->batchLowerBndi, sel);
+      break;
+    case TSDB_DATA_TYPE_INT:
+      BATCH_FILTER_NOT_EQUAL(int32_t, pData, num, (int32_t)pFilter->batchLowerBndi, sel);
+      break;
+    case TSDB_DATA_TYPE_BIGINT:
+    case TSDB_DATA_TYPE_TIMESTAMP:
+      BATCH_FILTER_NOT_EQUAL(int64_t, pData, num, pFilter->batchLowerBndi, sel);
+      break;
+    case TSDB_DATA_TYPE_FLOAT:  // compared in double as nequal_ds does
+      BATCH_FILTER_NOT_EQUAL(float, pData, num, pFilter->batchLowerBndd, sel);
+      break;
+    case TSDB_DATA_TYPE_DOUBLE:
+      BATCH_FILTER_NOT_EQUAL(double, pData, num, pFilter->batchLowerBndd, sel);
+      break;
+    default:
+      assert(false);
+  }
+}
+
+static void vnodeBatchFilterColumn(SColumnFilterElem *pFilter, int16_t type, int16_t bytes, char *pData,
+                                   int32_t num, uint8_t *sel) {
+  switch (pFilter->batchOptr) {
+    case TSDB_BATCH_FILTER_RANGE:
+      vnodeRangeFilterColumn(pFilter, type, pData, num, sel);
+      break;
+    case TSDB_BATCH_FILTER_NOT_EQUAL:
+      vnodeNotEqualFilterColumn(pFilter, type, pData, num, sel);
+      break;
+    case TSDB_BATCH_FILTER_EQUAL_EPS: {
+      const float *p = (const float *)pData;
+      for (int32_t i = 0; i < num; ++i) {
+        sel[i] |= (uint8_t)(fabs(p[i] - pFilter->batchLowerBndd) <= FLT_EPSILON);
+      }
+      break;
+    }
+    case TSDB_BATCH_FILTER_ROW:
+      for (int32_t i = 0; i < num; ++i) {
+        if (sel[i] == 0 && pFilter->fp(pFilter, pData + bytes * i, pData + bytes * i)) {
+          sel[i] = 1;
+        }
+      }
+      break;
+    default:  // TSDB_BATCH_FILTER_NONE
+      break;
+  }
+}
+
+// sel &= colSel && the value is not null
+static void vnodeMergeBatchFilterColumn(int16_t type, int16_t bytes, char *pData, int32_t num, uint8_t *colSel,
+                                        uint8_t *sel) {
+  switch (type) {
+    case TSDB_DATA_TYPE_BOOL:
+      BATCH_FILTER_NOT_NULL(uint8_t, TSDB_DATA_BOOL_NULL, pData, num, colSel, sel);
+      break;
+    case TSDB_DATA_TYPE_TINYINT:
+      BATCH_FILTER_NOT_NULL(uint8_t, TSDB_DATA_TINYINT_NULL, pData, num, colSel, sel);
+      break;
+    case TSDB_DATA_TYPE_SMALLINT:
+      BATCH_FILTER_NOT_NULL(uint16_t, TSDB_DATA_SMALLINT_NULL, pData, num, colSel, sel);
+      break;
+    case TSDB_DATA_TYPE_INT:
+      BATCH_FILTER_NOT_NULL(uint32_t, TSDB_DATA_INT_NULL, pData, num, colSel, sel);
+      break;
+    case TSDB_DATA_TYPE_BIGINT:
+    case TSDB_DATA_TYPE_TIMESTAMP:
+      BATCH_FILTER_NOT_NULL(uint64_t, TSDB_DATA_BIGINT_NULL, pData, num, colSel, sel);
+      break;
+    case TSDB_DATA_TYPE_FLOAT:
+      BATCH_FILTER_NOT_NULL(uint32_t, TSDB_DATA_FLOAT_NULL, pData, num, colSel, sel);
+      break;
+    case TSDB_DATA_TYPE_DOUBLE:
+      BATCH_FILTER_NOT_NULL(uint64_t, TSDB_DATA_DOUBLE_NULL, pData, num, colSel, sel);
+      break;
+    default:
+      for (int32_t i = 0; i < num; ++i) {
+        sel[i] &= (uint8_t)(colSel[i] && !isNull(pData + bytes * i, type));
+      }
+  }
+}
+
+static bool vnodeHasQualifiedRow(uint8_t *sel, int32_t num) {
+  int32_t i = 0;
+  for (; i + 8 <= num; i += 8) {
+    uint64_t bytes = 0;
+    memcpy(&bytes, sel + i, sizeof(bytes));
+    if (bytes != 0) return true;
+  }
+
+  for (; i < num; ++i) {
+    if (sel[i] != 0) return true;
+  }
+
+  return false;
+}
+
+int32_t vnodeBatchFilterData(SQuery *pQuery, int32_t start, int32_t numOfRows, uint8_t *pSel) {
+  uint8_t colSel[BATCH_FILTER_CHUNK];
+  int32_t numOfQualified = 0;
+
+  memset(pSel, 1, (size_t)numOfRows);
+
+  // a chunk of the column stays in the cache while all filters of the column are evaluated on it
+  for (int32_t s = 0; s < numOfRows; s += BATCH_FILTER_CHUNK) {
+    int32_t  num = MIN(BATCH_FILTER_CHUNK, numOfRows - s);
+    uint8_t *sel = pSel + s;
+
+    for (int32_t k = 0; k < pQuery->numOfFilterCols; ++k) {
+      SSingleColumnFilterInfo *pFilterInfo = &pQuery->pFilterInfo[k];
+
+      int16_t type = pFilterInfo->info.data.type;
+      int16_t bytes = pFilterInfo->info.data.bytes;
+      char *  pData = pFilterInfo->pData + (int64_t)bytes * (start + s);
+
+      // filters on the same column are OR-ed
+      memset(colSel, 0, (size_t)num);
+      for (int32_t f = 0; f < pFilterInfo->numOfFilters; ++f) {
+        vnodeBatchFilterColumn(&pFilterInfo->pFilters[f], type, bytes, pData, num, colSel);
+      }
+
+      vnodeMergeBatchFilterColumn(type, bytes, pData, num, colSel, sel);
+      if (!vnodeHasQualifiedRow(sel, num)) {
+        break;
+      }
+    }
+
+    for (int32_t i = 0; i < num; ++i) {
+      numOfQualified += sel[i];
+    }
+  }
+
+  return numOfQualified;
+}
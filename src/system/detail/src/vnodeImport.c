@@ -16,7 +16,9 @@
 #define _DEFAULT_SOURCE
 #include "os.h"
 
+#include "tskiplist.h"
 #include "vnode.h"
+#include "vnodeBlockCache.h"
 #include "vnodeUtil.h"
 #include "vnodeStatus.h"
 
@@ -27,7 +29,7 @@ extern int          vnodeSendShellSubmitRspMsg(SShellObj *pObj, int code, int nu
 extern void         vnodeGetHeadDataLname(char *headName, char *dataName, char *lastName, int vnode, int fileId);
 extern int          vnodeCreateEmptyCompFile(int vnode, int fileId);
 extern int          vnodeUpdateFreeSlot(SVnodeObj *pVnode);
-extern SCacheBlock *vnodeGetFreeCacheBlock(SVnodeObj *pVnode);
+extern SCacheBlock *vnodeGetFreeCacheBlock(SVnodeObj *pVnode, SCacheShard *pShard);
 extern int          vnodeCreateNeccessaryFiles(SVnodeObj *pVnode);
 
 #define KEY_AT_INDEX(payload, step, idx) (*(TSKEY *)((char *)(payload) + (step) * (idx)))
@@ -99,7 +101,20 @@ typedef struct {
   char *  offset[];
 } SMergeBuffer;
 
+/*
+ * out-of-order rows of a meter older than its last key on file, waiting to be merged into files, keyed by timestamp.
+ * Rows are logged before they are put here. They are merged by commits, and by the first query on the meter before it
+ * scans, see vnodeFlushImportBuffer
+ */
+typedef struct {
+  pthread_mutex_t mutex;
+  tSkipList *     pList;
+  int32_t         rows;
+} SImportBuffer;
+
 int vnodeImportData(SMeterObj *pObj, SImportInfo *pImport);
+static int vnodeImportPointsToBuffer(SMeterObj *pObj, char *cont, int contLen, char source, int sversion,
+                                     int *pNumOfPoints);
 
 int vnodeFindKeyInCache(SImportInfo *pImport, int order) {
   SMeterObj * pObj = pImport->pObj;
@@ -195,6 +210,11 @@ int vnodeImportPoints(SMeterObj *pObj, char *cont, int contLen, char source, voi
     if (code != 0) return code;
   }
 
+  // lastKeyOnFile never goes back, the rows are always merged into files, which queries on the meter tolerate
+  if (lastKey <= pObj->lastKeyOnFile && tsImportBufferRows > 0) {
+    return vnodeImportPointsToBuffer(pObj, cont, contLen, source, sversion, pNumOfPoints);
+  }
+
   if (pVnode->cfg.commitLog && source != TSDB_DATA_SOURCE_LOG) {
     if (pVnode->logFd < 0) return TSDB_CODE_INVALID_COMMIT_LOG;
     code = vnodeWriteToCommitLog(pObj, TSDB_ACTION_IMPORT, cont, contLen, sversion);
@@ -684,7 +704,7 @@ static int vnodeMergeDataIntoFile(SImportInfo *pImport, const char *payload, int
   TSCKSUM       checksum = 0;
   int           pointsImported = 0;
   int           code = TSDB_CODE_SUCCESS;
-  SCachePool *  pPool = (SCachePool *)pVnode->pCachePool;
+  SCacheShard * pShard = vnodeGetCacheShard(pVnode->pCachePool, pObj->sid);
   SCacheInfo *  pInfo = (SCacheInfo *)(pObj->pCache);
   TSKEY         lastKeyImported = 0;
 
@@ -1162,9 +1182,11 @@ static int vnodeMergeDataIntoFile(SImportInfo *pImport, const char *payload, int
     goto _error_merge;
   }
 
+  vnodeInvalidateBlockCache(pObj->vnode, fid);
+
   pImport->importedRows += pointsImported;
 
-  pthread_mutex_lock(&(pPool->vmutex));
+  pthread_mutex_lock(&(pShard->mutex));
   if (pInfo->numOfBlocks > 0) {
     int   slot = (pInfo->currentSlot - pInfo->numOfBlocks + 1 + pInfo->maxBlocks) % pInfo->maxBlocks;
     TSKEY firstKeyInCache = *((TSKEY *)(pInfo->cacheBlocks[slot]->offset[0]));
@@ -1184,7 +1206,7 @@ static int vnodeMergeDataIntoFile(SImportInfo *pImport, const char *payload, int
       }
     }
   }
-  pthread_mutex_unlock(&(pPool->vmutex));
+  pthread_mutex_unlock(&(pShard->mutex));
 
   // TODO: free the allocated memory
   tfree(buffer);
@@ -1288,7 +1310,7 @@ int vnodeImportDataToCache(SImportInfo *pImport, const char *payload, const int
   int           code = -1;
   SCacheInfo *  pInfo = (SCacheInfo *)(pObj->pCache);
   int           payloadIter;
-  SCachePool *  pPool = (SCachePool *)(pVnode->pCachePool);
+  SCacheShard * pShard = vnodeGetCacheShard(pVnode->pCachePool, pObj->sid);
   int           isCacheIterEnd = 0;
   int           spayloadIter = 0;
   int           isAppendData = 0;
@@ -1398,11 +1420,11 @@ int vnodeImportDataToCache(SImportInfo *pImport, const char *payload, const int
         isCacheIterEnd = isCacheEnd(cacheIter, pObj);
       } else if (cacheKey > payloadKey) {  // cacheIter end || (payloadIter not end && payloadKey < blockKey), consume payload
         if (availPoints == 0) {                      // Need to allocate a new cache block
-          pthread_mutex_lock(&(pPool->vmutex));
+          pthread_mutex_lock(&(pShard->mutex));
           // TODO: Need to check if there are enough slots to hold a new one
-          SCacheBlock *pNewBlock = vnodeGetFreeCacheBlock(pVnode);
+          SCacheBlock *pNewBlock = vnodeGetFreeCacheBlock(pVnode, pShard);
           if (pNewBlock == NULL) {  // Failed to allocate a new cache block, need to commit and loop over the remaining cache records
-            pthread_mutex_unlock(&(pPool->vmutex));
+            pthread_mutex_unlock(&(pShard->mutex));
             payloadIter = rows;
             code = TSDB_CODE_ACTION_IN_PROGRESS;
             pImport->commit = 1;
@@ -1455,7 +1477,7 @@ int vnodeImportDataToCache(SImportInfo *pImport, const char *payload, const int
           pInfo->numOfBlocks++;
           pInfo->unCommittedBlocks++;
           pInfo->currentSlot = (pInfo->currentSlot + 1) % pInfo->maxBlocks;
-          pthread_mutex_unlock(&(pPool->vmutex));
+          pthread_mutex_unlock(&(pShard->mutex));
           cacheIter.slot = (cacheIter.slot + 1) % pInfo->maxBlocks;
           // move a cache of data forward
           availPoints = pObj->pointsPerBlock;
@@ -1542,25 +1564,20 @@ int vnodeImportDataToFiles(SImportInfo *pImport, char *payload, const int rows)
   return code;
 }
 
-// TODO : add offset in pShell to make it avoid repeatedly deal with messages
-int vnodeImportData(SMeterObj *pObj, SImportInfo *pImport) {
-  int         code = 0;
-  int         srow = 0, nrows = 0;
-  SVnodeObj * pVnode = vnodeList + pObj->vnode;
-  SCachePool *pPool = (SCachePool *)(pVnode->pCachePool);
+/*
+ * import data into cache and files, pPool->commitInProcess shall be set by the caller. pImport->commit is set if the
+ * cache is full and a commit is needed before the rest can be imported
+ */
+static int vnodeImportDataToCacheAndFiles(SMeterObj *pObj, SImportInfo *pImport) {
+  int code = 0;
+  int srow = 0, nrows = 0;
 
   // 1. import data in range (pObj->lastKeyOnFile, INT64_MAX) into cache
   if (vnodeSearchKeyInRange(pImport->payload, pObj->bytesPerPoint, pImport->rows, pObj->lastKeyOnFile + 1, INT64_MAX,
                             &srow, &nrows) >= 0) {
     assert(nrows > 0);
     code = vnodeImportDataToCache(pImport, pImport->payload + pObj->bytesPerPoint * srow, nrows);
-    if (pImport->commit) {  // Need to commit now
-      pPool->commitInProcess = 0;
-      vnodeProcessCommitTimer(pVnode, NULL);
-      return code;
-    }
-
-    if (code != TSDB_CODE_SUCCESS) return code;
+    if (pImport->commit || code != TSDB_CODE_SUCCESS) return code;
   }
 
   // 2. import data (0, pObj->lastKeyOnFile) into files
@@ -1570,7 +1587,430 @@ int vnodeImportData(SMeterObj *pObj, SImportInfo *pImport) {
     code = vnodeImportDataToFiles(pImport, pImport->payload + pObj->bytesPerPoint * srow, nrows);
   }
 
+  return code;
+}
+
+// TODO : add offset in pShell to make it avoid repeatedly deal with messages
+int vnodeImportData(SMeterObj *pObj, SImportInfo *pImport) {
+  SVnodeObj * pVnode = vnodeList + pObj->vnode;
+  SCachePool *pPool = (SCachePool *)(pVnode->pCachePool);
+
+  int code = vnodeImportDataToCacheAndFiles(pObj, pImport);
   pPool->commitInProcess = 0;
 
+  if (pImport->commit) {  // Need to commit now
+    vnodeProcessCommitTimer(pVnode, NULL);
+  }
+
   return code;
 }
+
+static SImportBuffer *vnodeGetImportBuffer(SMeterObj *pObj, bool create) {
+  SImportBuffer *pBuf = atomic_load_ptr(&pObj->pImportBuf);
+  if (pBuf != NULL || !create) return pBuf;
+
+  pBuf = calloc(1, sizeof(SImportBuffer));
+  if (pBuf == NULL) return NULL;
+
+  pBuf->pList = tSkipListCreate(MAX_SKIP_LIST_LEVEL, TSDB_DATA_TYPE_BIGINT, sizeof(TSKEY));
+  if (pBuf->pList == NULL) {
+    free(pBuf);
+    return NULL;
+  }
+  pthread_mutex_init(&pBuf->mutex, NULL);
+
+  // another thread may have created it meanwhile
+  SImportBuffer *pOld = atomic_val_compare_exchange_ptr(&pObj->pImportBuf, NULL, pBuf);
+  if (pOld != NULL) {
+    tSkipListDestroy(pBuf->pList);
+    pthread_mutex_destroy(&pBuf->mutex);
+    free(pBuf);
+    pBuf = pOld;
+  }
+
+  return pBuf;
+}
+
+/*
+ * put rows into the buffer, the mutex of the buffer shall be held. For identical keys, the first row wins, the number
+ * of rows put is returned by pAdded if it is not NULL
+ */
+static int vnodePutRowsToImportBuffer(SMeterObj *pObj, SImportBuffer *pBuf, const char *payload, int rows,
+                                      int *pAdded) {
+  SVnodeObj *pVnode = vnodeList + pObj->vnode;
+  int        added = 0, i = 0;
+
+  for (i = 0; i < rows; ++i) {
+    const char *pSrc = payload + pObj->bytesPerPoint * i;
+    char *      pRow = malloc(pObj->bytesPerPoint);
+    if (pRow == NULL) {
+      dError("vid:%d sid:%d id:%s, no enough memory to buffer imported rows", pObj->vnode, pObj->sid, pObj->meterId);
+      break;
+    }
+
+    memcpy(pRow, pSrc, pObj->bytesPerPoint);
+    tSkipListKey   key = tSkipListCreateKey(TSDB_DATA_TYPE_BIGINT, (char *)pSrc, sizeof(TSKEY));
+    tSkipListNode *pNode = tSkipListPut(pBuf->pList, pRow, &key, 0);
+    if (pNode == NULL || pNode->pData != pRow) {
+      free(pRow);
+      continue;
+    }
+
+    added++;
+  }
+
+  pBuf->rows += added;
+  atomic_add_fetch_64(&pVnode->importBufBytes, (int64_t)added * pObj->bytesPerPoint);
+
+  if (pAdded != NULL) *pAdded = added;
+  return (i == rows) ? TSDB_CODE_SUCCESS : TSDB_CODE_SERV_OUT_OF_MEMORY;
+}
+
+/* move all rows out of the buffer in ascending order of key, the mutex of the buffer shall be held */
+static char *vnodeTakeRowsFromImportBuffer(SMeterObj *pObj, SImportBuffer *pBuf, int *rows) {
+  SVnodeObj *pVnode = vnodeList + pObj->vnode;
+
+  *rows = 0;
+  char *payload = malloc((size_t)pBuf->rows * pObj->bytesPerPoint);
+  if (payload == NULL) return NULL;
+
+  tSkipList *pList = tSkipListCreate(MAX_SKIP_LIST_LEVEL, TSDB_DATA_TYPE_BIGINT, sizeof(TSKEY));
+  if (pList == NULL) {
+    free(payload);
+    return NULL;
+  }
+
+  SSkipListIterator iter = {0};
+  tSkipListIteratorReset(pBuf->pList, &iter);
+  while (tSkipListIteratorNext(&iter)) {
+    tSkipListNode *pNode = tSkipListIteratorGet(&iter);
+    memcpy(payload + pObj->bytesPerPoint * (*rows), pNode->pData, pObj->bytesPerPoint);
+    free(pNode->pData);
+    (*rows)++;
+  }
+
+  assert(*rows == pBuf->rows);
+  tSkipListDestroy(pBuf->pList);
+  pBuf->pList = pList;
+  pBuf->rows = 0;
+  atomic_sub_fetch_64(&pVnode->importBufBytes, (int64_t)(*rows) * pObj->bytesPerPoint);
+
+  return payload;
+}
+
+static int vnodeImportPointsToBuffer(SMeterObj *pObj, char *cont, int contLen, char source, int sversion,
+                                     int *pNumOfPoints) {
+  SSubmitMsg *pSubmit = (SSubmitMsg *)cont;
+  SVnodeObj * pVnode = vnodeList + pObj->vnode;
+  SCachePool *pPool = (SCachePool *)(pVnode->pCachePool);
+  int         rows = htons(pSubmit->numOfRows);
+  int         added = 0;
+  int         code = TSDB_CODE_SUCCESS;
+
+  if (sversion != pObj->sversion) {
+    dError("vid:%d sid:%d id:%s, invalid sversion, expected:%d received:%d", pObj->vnode, pObj->sid, pObj->meterId,
+           pObj->sversion, sversion);
+    return TSDB_CODE_OTHERS;
+  }
+
+  // buffering rows takes no more than an insert, queries and inserts on other meters go on
+  if ((code = vnodeSetMeterInsertImportStateEx(pObj, TSDB_METER_STATE_INSERTING)) != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  SImportBuffer *pBuf = vnodeGetImportBuffer(pObj, true);
+  if (pBuf == NULL) {
+    vnodeClearMeterState(pObj, TSDB_METER_STATE_INSERTING);
+    return TSDB_CODE_SERV_OUT_OF_MEMORY;
+  }
+
+  /*
+   * the buffered rows are written into the new commit log by the commit, so logging and buffering are done under
+   * the mutex, rows logged into the old log are always in the buffer by then
+   */
+  pthread_mutex_lock(&pBuf->mutex);
+
+  // buffered rows shall fit into a quarter of the commit log, since they are logged again by each commit
+  if (pBuf->rows > 0 && (pBuf->rows + rows > tsImportBufferRows ||
+                         atomic_load_64(&pVnode->importBufBytes) + rows * pObj->bytesPerPoint > pVnode->mappingSize / 4)) {
+    pthread_mutex_unlock(&pBuf->mutex);
+    vnodeClearMeterState(pObj, TSDB_METER_STATE_INSERTING);
+
+    dTrace("vid:%d sid:%d id:%s, import buffer is full, rows:%d, commit first", pObj->vnode, pObj->sid, pObj->meterId,
+           pBuf->rows);
+    vnodeProcessCommitTimer(pVnode, NULL);
+    return TSDB_CODE_ACTION_IN_PROGRESS;
+  }
+
+  if (pVnode->cfg.commitLog && source != TSDB_DATA_SOURCE_LOG) {
+    if (pVnode->logFd < 0) {
+      code = TSDB_CODE_INVALID_COMMIT_LOG;
+    } else {
+      code = vnodeWriteToCommitLog(pObj, TSDB_ACTION_IMPORT, cont, contLen, sversion);
+    }
+  }
+
+  if (code == TSDB_CODE_SUCCESS) {
+    code = vnodePutRowsToImportBuffer(pObj, pBuf, pSubmit->payLoad, rows, &added);
+  }
+
+  pthread_mutex_unlock(&pBuf->mutex);
+
+  if (code == TSDB_CODE_SUCCESS) {
+    dTrace("vid:%d sid:%d id:%s, %d of %d rows are buffered for import, firstKey:%" PRId64 " object lastKey:%" PRId64,
+           pObj->vnode, pObj->sid, pObj->meterId, added, rows, KEY_AT_INDEX(pSubmit->payLoad, pObj->bytesPerPoint, 0),
+           pObj->lastKey);
+
+    // buffered rows are merged by commits, make sure there is one coming
+    pthread_mutex_lock(&pPool->vmutex);
+    if (pVnode->commitTimer == NULL) {
+      pVnode->commitTimer = taosTmrStart(vnodeProcessCommitTimer, pVnode->cfg.commitTime * 1000, pVnode, vnodeTmrCtrl);
+    }
+    pthread_mutex_unlock(&pPool->vmutex);
+
+    pVnode->version++;
+
+    // rows of keys already in the buffer are dropped, rows of keys in files are dropped by the merge later
+    *pNumOfPoints = added;
+  }
+
+  vnodeClearMeterState(pObj, TSDB_METER_STATE_INSERTING);
+  return code;
+}
+
+/*
+ * merge the buffered rows into cache and files. pPool->commitInProcess and the importing state shall be set by the
+ * caller. Rows are merged into cache blocks in place, which concurrent scans can not tolerate, so for a meter being
+ * queried only the rows older than lastKeyOnFile are merged: the file part writes a new head file and appends blocks,
+ * the files opened by the queries stay intact. Rows not merged are put back to the buffer
+ */
+static int vnodeMergeImportBuffer(SMeterObj *pObj, SImportBuffer *pBuf, bool queried, int *commit) {
+  int rows = 0;
+
+  pthread_mutex_lock(&pBuf->mutex);
+  if (pBuf->rows == 0) {
+    pthread_mutex_unlock(&pBuf->mutex);
+    return TSDB_CODE_SUCCESS;
+  }
+
+  char *payload = vnodeTakeRowsFromImportBuffer(pObj, pBuf, &rows);
+  pthread_mutex_unlock(&pBuf->mutex);
+
+  if (payload == NULL) {
+    dError("vid:%d sid:%d id:%s, no enough memory to merge imported rows", pObj->vnode, pObj->sid, pObj->meterId);
+    return TSDB_CODE_SERV_OUT_OF_MEMORY;
+  }
+
+  SImportInfo import = {0};
+  import.pObj = pObj;
+  import.firstKey = KEY_AT_INDEX(payload, pObj->bytesPerPoint, 0);
+  import.lastKey = KEY_AT_INDEX(payload, pObj->bytesPerPoint, rows - 1);
+  import.payload = payload;
+  import.rows = rows;
+
+  dTrace("vid:%d sid:%d id:%s, merge %d buffered rows, firstKey:%" PRId64 ", lastKey:%" PRId64 ", object lastKey:%" PRId64
+         " queried:%d", pObj->vnode, pObj->sid, pObj->meterId, rows, import.firstKey, import.lastKey, pObj->lastKey,
+         queried);
+
+  int code = TSDB_CODE_SUCCESS;
+  int srow = 0, nrows = 0, merged = 0;
+
+  if (!queried) {
+    code = vnodeImportDataToCacheAndFiles(pObj, &import);
+    *commit = import.commit;
+  } else if (vnodeSearchKeyInRange(payload, pObj->bytesPerPoint, rows, 0, pObj->lastKeyOnFile - 1, &srow, &nrows) >= 0) {
+    code = vnodeImportDataToFiles(&import, payload + pObj->bytesPerPoint * srow, nrows);
+    merged = srow + nrows;
+  }
+
+  if (code != TSDB_CODE_SUCCESS) {
+    // rows already imported are skipped as identical keys when they are merged again
+    dTrace("vid:%d sid:%d id:%s, failed to merge buffered rows, code:%d, put them back", pObj->vnode, pObj->sid,
+           pObj->meterId, code);
+    pthread_mutex_lock(&pBuf->mutex);
+    vnodePutRowsToImportBuffer(pObj, pBuf, payload, rows, NULL);
+    pthread_mutex_unlock(&pBuf->mutex);
+  } else if (queried && merged < rows) {
+    // rows newer than the file are left for a commit that finds the meter idle, or has written them to the file
+    int skip = merged;
+    while (skip < rows && KEY_AT_INDEX(payload, pObj->bytesPerPoint, skip) <= pObj->lastKeyOnFile) skip++;
+
+    pthread_mutex_lock(&pBuf->mutex);
+    vnodePutRowsToImportBuffer(pObj, pBuf, payload + pObj->bytesPerPoint * skip, rows - skip, NULL);
+    pthread_mutex_unlock(&pBuf->mutex);
+  }
+
+  free(payload);
+  return code;
+}
+
+int32_t vnodeGetImportBufferRows(SMeterObj *pObj) {
+  SImportBuffer *pBuf = vnodeGetImportBuffer(pObj, false);
+  return (pBuf == NULL) ? 0 : pBuf->rows;
+}
+
+/*
+ * called before a meter is queried, so that the query sees the buffered rows. The rows are older than lastKeyOnFile,
+ * they are merged into files even if other queries are scanning the meter. A commit or an insert in process is waited
+ * for, it takes a while at most
+ */
+int32_t vnodeFlushImportBuffer(SMeterObj *pObj) {
+  SVnodeObj *    pVnode = vnodeList + pObj->vnode;
+  SCachePool *   pPool = (SCachePool *)(pVnode->pCachePool);
+  SImportBuffer *pBuf = vnodeGetImportBuffer(pObj, false);
+  int32_t        code = TSDB_CODE_SUCCESS;
+
+  for (int32_t count = 0;; ++count) {
+    // the commit in process may have merged the rows
+    if (pBuf == NULL || pBuf->rows == 0) return TSDB_CODE_SUCCESS;
+
+    int32_t commitInProcess = 0;
+    pthread_mutex_lock(&pPool->vmutex);
+    if ((commitInProcess = pPool->commitInProcess) == 0) pPool->commitInProcess = 1;
+    pthread_mutex_unlock(&pPool->vmutex);
+
+    if (commitInProcess == 0) {
+      code = vnodeSetMeterInsertImportStateEx(pObj, TSDB_METER_STATE_IMPORTING);
+      if (code != TSDB_CODE_ACTION_IN_PROGRESS) break;
+
+      pPool->commitInProcess = 0;
+    }
+
+    if (count % 100 == 1) {
+      dWarn("vid:%d sid:%d id:%s, still in commit or insert, wait to flush buffered rows", pObj->vnode, pObj->sid,
+            pObj->meterId);
+    }
+    taosMsleep(10);
+  }
+
+  // a meter being dropped is skipped by the query
+  if (code != TSDB_CODE_SUCCESS) {
+    pPool->commitInProcess = 0;
+    return TSDB_CODE_SUCCESS;
+  }
+
+  int32_t num = 0;
+  pthread_mutex_lock(&pVnode->vmutex);
+  num = pObj->numOfQueries;
+  pthread_mutex_unlock(&pVnode->vmutex);
+
+  int commit = 0;
+  code = vnodeMergeImportBuffer(pObj, pBuf, num > 0, &commit);
+
+  vnodeClearMeterState(pObj, TSDB_METER_STATE_IMPORTING);
+  pPool->commitInProcess = 0;
+
+  if (commit) vnodeProcessCommitTimer(pVnode, NULL);
+
+  return code;
+}
+
+/*
+ * merge buffered rows of meters, called by the commit before it snapshots the cache and again after the cache is
+ * written into files. Meters being queried are merged into files only, see vnodeMergeImportBuffer. Meters being
+ * updated or dropped are left for later
+ */
+void vnodeMergeImportBuffers(SVnodeObj *pVnode, int ssid, int esid) {
+  if (pVnode->meterList == NULL) return;
+
+  for (int sid = ssid; sid <= esid; ++sid) {
+    SMeterObj *pObj = pVnode->meterList[sid];
+    if (pObj == NULL) continue;
+
+    SImportBuffer *pBuf = vnodeGetImportBuffer(pObj, false);
+    if (pBuf == NULL || pBuf->rows == 0) continue;
+
+    if (vnodeSetMeterState(pObj, TSDB_METER_STATE_IMPORTING) != TSDB_METER_STATE_READY) continue;
+
+    int32_t num = 0;
+    pthread_mutex_lock(&pVnode->vmutex);
+    num = pObj->numOfQueries;
+    pthread_mutex_unlock(&pVnode->vmutex);
+
+    int commit = 0;
+    vnodeMergeImportBuffer(pObj, pBuf, num > 0, &commit);
+    vnodeClearMeterState(pObj, TSDB_METER_STATE_IMPORTING);
+
+    // cache is full, the rest are merged by the next commit
+    if (commit) break;
+  }
+}
+
+/*
+ * write the rows left in buffers into the new commit log, called by the commit after the log is renewed, since the
+ * old log is removed once the commit is over
+ */
+void vnodeRelogImportBuffers(SVnodeObj *pVnode, int ssid, int esid) {
+  if (pVnode->meterList == NULL || !pVnode->cfg.commitLog) return;
+
+  // numOfRows in submit message is a short
+  const int maxRows = INT16_MAX;
+
+  for (int sid = ssid; sid <= esid; ++sid) {
+    SMeterObj *pObj = pVnode->meterList[sid];
+    if (pObj == NULL) continue;
+
+    SImportBuffer *pBuf = vnodeGetImportBuffer(pObj, false);
+    if (pBuf == NULL || pBuf->rows == 0) continue;
+
+    pthread_mutex_lock(&pBuf->mutex);
+
+    SSubmitMsg *pSubmit = malloc(sizeof(SSubmitMsg) + (size_t)MIN(pBuf->rows, maxRows) * pObj->bytesPerPoint);
+    if (pSubmit == NULL) {
+      pthread_mutex_unlock(&pBuf->mutex);
+      dError("vid:%d sid:%d id:%s, no enough memory to log buffered rows", pObj->vnode, pObj->sid, pObj->meterId);
+      continue;
+    }
+
+    int               rows = 0;
+    int               logged = 0;
+    SSkipListIterator iter = {0};
+    tSkipListIteratorReset(pBuf->pList, &iter);
+
+    while (1) {
+      bool hasNext = tSkipListIteratorNext(&iter);
+      if (hasNext) {
+        tSkipListNode *pNode = tSkipListIteratorGet(&iter);
+        memcpy(pSubmit->payLoad + pObj->bytesPerPoint * rows, pNode->pData, pObj->bytesPerPoint);
+        rows++;
+      }
+
+      if ((rows == maxRows || !hasNext) && rows > 0) {
+        pSubmit->numOfRows = htons(rows);
+        int contLen = rows * pObj->bytesPerPoint + sizeof(pSubmit->numOfRows);
+        if (vnodeWriteToCommitLog(pObj, TSDB_ACTION_IMPORT, (char *)pSubmit, contLen, pObj->sversion) != 0) {
+          dError("vid:%d sid:%d id:%s, failed to log %d buffered rows", pObj->vnode, pObj->sid, pObj->meterId, rows);
+        }
+        logged += rows;
+        rows = 0;
+      }
+
+      if (!hasNext) break;
+    }
+
+    pthread_mutex_unlock(&pBuf->mutex);
+    free(pSubmit);
+
+    dTrace("vid:%d sid:%d id:%s, %d buffered rows are written into new commit log", pObj->vnode, pObj->sid,
+           pObj->meterId, logged);
+  }
+}
+
+void vnodeFreeImportBuffer(SMeterObj *pObj) {
+  SImportBuffer *pBuf = pObj->pImportBuf;
+  if (pBuf == NULL) return;
+
+  SVnodeObj *pVnode = vnodeList + pObj->vnode;
+
+  SSkipListIterator iter = {0};
+  tSkipListIteratorReset(pBuf->pList, &iter);
+  while (tSkipListIteratorNext(&iter)) {
+    free(tSkipListIteratorGet(&iter)->pData);
+  }
+
+  atomic_sub_fetch_64(&pVnode->importBufBytes, (int64_t)pBuf->rows * pObj->bytesPerPoint);
+  tSkipListDestroy(pBuf->pList);
+  pthread_mutex_destroy(&pBuf->mutex);
+  free(pBuf);
+  pObj->pImportBuf = NULL;
+}
@@ -41,6 +41,7 @@ void vnodeFreeMeterObj(SMeterObj *pObj) {
   dTrace("vid:%d sid:%d id:%s, meter is cleaned up", pObj->vnode, pObj->sid, pObj->meterId);
 
   vnodeFreeCacheInfo(pObj);
+  vnodeFreeImportBuffer(pObj);
   if (vnodeList[pObj->vnode].meterList != NULL) {
     vnodeList[pObj->vnode].meterList[pObj->sid] = NULL;
   }
@@ -339,6 +340,7 @@ int vnodeRestoreMeterObj(char *buffer, int64_t length) {
   
   vnodeList[pSavedObj->vnode].meterList[pSavedObj->sid] = pObj;
   pObj->pStream = NULL;
+  pObj->pImportBuf = NULL;
   
   memcpy(pObj->schema, buffer + offsetof(SMeterObj, reserved), pSavedObj->numOfColumns * sizeof(SColumn));
   pObj->state = TSDB_METER_STATE_READY;
@@ -450,6 +452,7 @@ void vnodeCloseMetersVnode(int vnode) {
       pObj = pVnode->meterList[sid];
       if (pObj == NULL) continue;
       vnodeFreeCacheInfo(pObj);
+      vnodeFreeImportBuffer(pObj);
       tfree(pObj->schema);
       tfree(pObj);
     }
@@ -776,8 +779,8 @@ void vnodeUpdateMeter(void *param, void *tmrId) {
     return;
   }
 
-  // commit first
-  if (!vnodeIsCacheCommitted(pObj)) {
+  // commit first, buffered out-of-order rows are in the old schema too
+  if (!vnodeIsCacheCommitted(pObj) || vnodeGetImportBufferRows(pObj) > 0) {
     // commit data first
     if (taosTmrStart(vnodeProcessUpdateSchemaTimer, 0, pObj, vnodeTmrCtrl) == NULL) {
       dError("vid:%d sid:%d id:%s, failed to start commit timer", pObj->vnode, pObj->sid, pObj->meterId);
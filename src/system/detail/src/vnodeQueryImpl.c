@@ -30,9 +30,12 @@
 #include "vnodeUtil.h"
 
 #include "vnodeCache.h"
+#include "vnodeBlockCache.h"
+#include "vnodeBlockRead.h"
 #include "vnodeDataFilterFunc.h"
 #include "vnodeFile.h"
 #include "vnodeQueryImpl.h"
+#include "vnodeQueryMem.h"
 #include "vnodeStatus.h"
 
 #include <dirent.h>
@@ -71,8 +74,8 @@ static void setWindowResOutputBuf(SQueryRuntimeEnv *pRuntimeEnv, SWindowResult *
 
 static void    resetMergeResultBuf(SQuery *pQuery, SQLFunctionCtx *pCtx, SResultInfo *pResultInfo);
 static int32_t flushFromResultBuf(STableQuerySupportObj *pSupporter, const SQuery *pQuery,
-                                  const SQueryRuntimeEnv *pRuntimeEnv);
-static void    getBasicCacheInfoSnapshot(SQuery *pQuery, SCacheInfo *pCacheInfo, int32_t vid);
+                                  SQueryRuntimeEnv *pRuntimeEnv);
+static void    getBasicCacheInfoSnapshot(SQuery *pQuery, SCacheInfo *pCacheInfo, SMeterObj *pMeterObj);
 static TSKEY   getQueryPositionForCacheInvalid(SQueryRuntimeEnv *pRuntimeEnv, __block_search_fn_t searchFn);
 static bool    functionNeedToExecute(SQueryRuntimeEnv *pRuntimeEnv, SQLFunctionCtx *pCtx, int32_t functionId);
 static void    getNextTimeWindow(SQuery *pQuery, STimeWindow *pTimeWindow);
@@ -350,6 +353,10 @@ static bool checkIsHeaderFileEmpty(SQueryFilesInfo *pVnodeFilesInfo) {
 }
 
 static void doCloseQueryFileInfoFD(SQueryFilesInfo *pVnodeFilesInfo) {
+  // reads in flight refer to the data and last file fd
+  vnodeCloseBlockReader(pVnodeFilesInfo->pBlockReader);
+  pVnodeFilesInfo->pBlockReader = NULL;
+
   tclose(pVnodeFilesInfo->headerFd);
   tclose(pVnodeFilesInfo->dataFd);
   tclose(pVnodeFilesInfo->lastFd);
@@ -365,6 +372,7 @@ static void doInitQueryFileInfoFD(SQueryFilesInfo *pVnodeFilesInfo) {
   pVnodeFilesInfo->headerFd = FD_INITIALIZER;  // set the initial value
   pVnodeFilesInfo->dataFd = FD_INITIALIZER;
   pVnodeFilesInfo->lastFd = FD_INITIALIZER;
+  pVnodeFilesInfo->pBlockReader = NULL;
 }
 
 /*
@@ -386,25 +394,38 @@ static int32_t doOpenQueryFile(SQInfo *pQInfo, SQueryFilesInfo *pVnodeFileInfo)
     return -1;
   }
 
+  /*
+   * commit and compaction rename new files into place under vmutex, the files are opened under it as well, so the
+   * head file always matches the data and last files opened with it
+   */
+  SVnodeObj *pVnode = &vnodeList[pVnodeFileInfo->vnodeId];
+  int32_t    code = TSDB_CODE_SUCCESS;
+  pthread_mutex_lock(&pVnode->vmutex);
+
+  pVnodeFileInfo->dataVersion = pVnode->dataVersion;
   pVnodeFileInfo->headerFd = open(pVnodeFileInfo->headerFilePath, O_RDONLY);
   if (!FD_VALID(pVnodeFileInfo->headerFd)) {
     dError("QInfo:%p failed open head file:%s reason:%s", pQInfo, pVnodeFileInfo->headerFilePath, strerror(errno));
-    return -1;
+    code = -1;
+    goto _over;
   }
 
   pVnodeFileInfo->dataFd = open(pVnodeFileInfo->dataFilePath, O_RDONLY);
   if (!FD_VALID(pVnodeFileInfo->dataFd)) {
     dError("QInfo:%p failed open data file:%s reason:%s", pQInfo, pVnodeFileInfo->dataFilePath, strerror(errno));
-    return -1;
+    code = -1;
+    goto _over;
   }
 
   pVnodeFileInfo->lastFd = open(pVnodeFileInfo->lastFilePath, O_RDONLY);
   if (!FD_VALID(pVnodeFileInfo->lastFd)) {
     dError("QInfo:%p failed open last file:%s reason:%s", pQInfo, pVnodeFileInfo->lastFilePath, strerror(errno));
-    return -1;
+    code = -1;
   }
 
-  return TSDB_CODE_SUCCESS;
+_over:
+  pthread_mutex_unlock(&pVnode->vmutex);
+  return code;
 }
 
 static void doCloseQueryFiles(SQueryFilesInfo *pVnodeFileInfo) {
@@ -751,6 +772,12 @@ static int32_t readDataFromDiskFile(int fd, SQInfo *pQInfo, SQueryFilesInfo *pQu
                                     int32_t size) {
   assert(size >= 0);
 
+  // the block may have been read ahead, otherwise read it synchronously
+  if (pQueryFile->pBlockReader != NULL &&
+      vnodeCopyFromBlockRead(pQueryFile->pBlockReader, fd, offset, buf, size) == TSDB_CODE_SUCCESS) {
+    return 0;
+  }
+
   int32_t ret = (int32_t)lseek(fd, offset, SEEK_SET);
   if (ret == -1) {
     //        qTrace("QInfo:%p seek failed, reason:%s", pQInfo, strerror(errno));
@@ -769,6 +796,19 @@ static int32_t loadColumnIntoMem(SQuery *pQuery, SQueryFilesInfo *pQueryFileInfo
   int64_t offset = pBlock->offset + pFields[col].offset;
   SQInfo *pQInfo = (SQInfo *)GET_QINFO_ADDR(pQuery);
 
+  /*
+   * commit and compaction append blocks to the data file, and only a compaction reclaiming dead space writes a new
+   * one, which bumps the data file version in the cache key, so a cached offset never refers to other data. The last
+   * file is appended to until it doubles, then rewritten by commit without any version, so its offsets are reused
+   * and only columns in the data file are shared with other queries.
+   */
+  int32_t fileId = pQueryFileInfo->pFileInfo[pQueryFileInfo->current].fileID;
+  int32_t size = pFields[col].bytes * pBlock->numOfPoints;
+  if (!pBlock->last && vnodeGetBlockCache(pQueryFileInfo->vnodeId, fileId, pQueryFileInfo->dataVersion, offset,
+                                          pFields[col].colId, sdata->data, size) == TSDB_CODE_SUCCESS) {
+    return 0;
+  }
+
   int     fd = pBlock->last ? pQueryFileInfo->lastFd : pQueryFileInfo->dataFd;
   int32_t ret = readDataFromDiskFile(fd, pQInfo, pQueryFileInfo, dst, offset, pFields[col].len);
   if (ret != 0) {
@@ -795,6 +835,11 @@ static int32_t loadColumnIntoMem(SQuery *pQuery, SQueryFilesInfo *pQueryFileInfo
                                       pFields[col].bytes * pBlock->numOfPoints, pBlock->algorithm, buffer, buffersize);
   }
 
+  if (!pBlock->last) {
+    vnodePutBlockCache(pQueryFileInfo->vnodeId, fileId, pQueryFileInfo->dataVersion, offset, pFields[col].colId,
+                       sdata->data, size);
+  }
+
   return 0;
 }
 
@@ -1121,7 +1166,7 @@ SCacheBlock *getCacheDataBlock(SMeterObj *pMeterObj, SQueryRuntimeEnv *pRuntimeE
   }
 
   vnodeFreeFields(pQuery);
-  getBasicCacheInfoSnapshot(pQuery, pCacheInfo, pMeterObj->vnode);
+  getBasicCacheInfoSnapshot(pQuery, pCacheInfo, pMeterObj);
 
   SCacheBlock *pBlock = pCacheInfo->cacheBlocks[slot];
   if (pBlock == NULL) {  // the cache info snapshot must be existed.
@@ -1536,26 +1581,54 @@ static STimeWindow getActiveTimeWindow(SWindowResInfo *pWindowResInfo, int64_t t
   return w;
 }
 
-static int32_t addNewWindowResultBuf(SWindowResult *pWindowRes, SQueryDiskbasedResultBuf *pResultBuf, int32_t sid,
+/*
+ * the result buffer grows by a few pages each time, the grown size is charged to the query memory budget. When the
+ * budget is tight, the pages are written back to the disk file so that the pages not touched again do not occupy
+ * memory. The bytes written back stay charged, the pages are faulted in again once they are read.
+ */
+static tFilePage *getNewResultPage(SQueryRuntimeEnv *pRuntimeEnv, int32_t groupId, int32_t *pageId) {
+  SQueryDiskbasedResultBuf *pResultBuf = pRuntimeEnv->pResultBuf;
+  int64_t                   size = getResBufSize(pResultBuf);
+
+  tFilePage *pData = getNewDataBuf(pResultBuf, groupId, pageId);
+  if (pData == NULL || getResBufSize(pResultBuf) == size) {
+    return pData;
+  }
+
+  SQInfo *pQInfo = (SQInfo *)GET_QINFO_ADDR(pRuntimeEnv->pQuery);
+  vnodeChargeQueryMem(pQInfo, getResBufSize(pResultBuf) - size);
+
+  int64_t spilled = 0;
+  if (vnodeQueryMemIsTight() && (spilled = spillResultBufPages(pResultBuf)) > 0) {
+    vnodeCountSpilledQueryMem(pQInfo, spilled);
+    dTrace("QInfo:%p query memory is tight, %" PRId64 " bytes of result buffer are spilled, size:%" PRId64, pQInfo,
+           spilled, (int64_t)getResBufSize(pResultBuf));
+  }
+
+  return pData;
+}
+
+static int32_t addNewWindowResultBuf(SWindowResult *pWindowRes, SQueryRuntimeEnv *pRuntimeEnv, int32_t sid,
                                      int32_t numOfRowsPerPage) {
   if (pWindowRes->pos.pageId != -1) {
     return 0;
   }
 
   tFilePage *pData = NULL;
+  SQueryDiskbasedResultBuf *pResultBuf = pRuntimeEnv->pResultBuf;
 
   // in the first scan, new space needed for results
   int32_t pageId = -1;
   SIDList list = getDataBufPagesIdList(pResultBuf, sid);
 
   if (list.size == 0) {
-    pData = getNewDataBuf(pResultBuf, sid, &pageId);
+    pData = getNewResultPage(pRuntimeEnv, sid, &pageId);
   } else {
     pageId = getLastPageId(&list);
     pData = getResultBufferPageById(pResultBuf, pageId);
 
     if (pData->numOfElems >= numOfRowsPerPage) {
-      pData = getNewDataBuf(pResultBuf, sid, &pageId);
+      pData = getNewResultPage(pRuntimeEnv, sid, &pageId);
       if (pData != NULL) {
         assert(pData->numOfElems == 0);  // number of elements must be 0 for new allocated buffer
       }
@@ -1575,19 +1648,50 @@ static int32_t addNewWindowResultBuf(SWindowResult *pWindowRes, SQueryDiskbasedR
   return 0;
 }
 
+/*
+ * Windows are appended to pResult in the order they are visited, so in an ordered scan the slot of a window is
+ * mostly its distance to the current window counted in sliding steps. The guessed slot is verified by its start key,
+ * and -1 is returned to fall back to the hash table if it does not match.
+ */
+static int32_t getTimeWindowSlotByKey(SQuery *pQuery, SWindowResInfo *pWindowResInfo, TSKEY skey) {
+  int32_t cur = pWindowResInfo->curIndex;
+  if (cur < 0 || cur >= pWindowResInfo->size || pQuery->slidingTime <= 0) {
+    return -1;
+  }
+
+  int64_t delta = skey - pWindowResInfo->pResult[cur].window.skey;
+  if (delta % pQuery->slidingTime != 0) {
+    return -1;
+  }
+
+  int64_t slot = cur + (delta / pQuery->slidingTime) * GET_FORWARD_DIRECTION_FACTOR(pQuery->order.order);
+  if (slot < 0 || slot >= pWindowResInfo->size || pWindowResInfo->pResult[slot].window.skey != skey) {
+    return -1;
+  }
+
+  return (int32_t)slot;
+}
+
 static int32_t setWindowOutputBufByKey(SQueryRuntimeEnv *pRuntimeEnv, SWindowResInfo *pWindowResInfo, int32_t sid,
                                        STimeWindow *win) {
   assert(win->skey <= win->ekey);
-  SQueryDiskbasedResultBuf *pResultBuf = pRuntimeEnv->pResultBuf;
+  SWindowResult *pWindowRes = NULL;
+
+  int32_t slot = getTimeWindowSlotByKey(pRuntimeEnv->pQuery, pWindowResInfo, win->skey);
+  if (slot >= 0) {
+    pWindowResInfo->curIndex = slot;
+    pWindowRes = getWindowResult(pWindowResInfo, slot);
+  } else {
+    pWindowRes = doSetTimeWindowFromKey(pRuntimeEnv, pWindowResInfo, (char *)&win->skey, TSDB_KEYSIZE);
+  }
 
-  SWindowResult *pWindowRes = doSetTimeWindowFromKey(pRuntimeEnv, pWindowResInfo, (char *)&win->skey, TSDB_KEYSIZE);
   if (pWindowRes == NULL) {
     return -1;
   }
 
   // not assign result buffer yet, add new result buffer
   if (pWindowRes->pos.pageId == -1) {
-    int32_t ret = addNewWindowResultBuf(pWindowRes, pResultBuf, sid, pRuntimeEnv->numOfRowsPerPage);
+    int32_t ret = addNewWindowResultBuf(pWindowRes, pRuntimeEnv, sid, pRuntimeEnv->numOfRowsPerPage);
     if (ret != 0) {
       return -1;
     }
@@ -1780,6 +1884,25 @@ static void doRowwiseApplyFunctions(SQueryRuntimeEnv *pRuntimeEnv, SWindowStatus
   }
 }
 
+/*
+ * Apply the functions to num consecutive rows from startPos in one call, as to a block without filters. The ts list
+ * of every function that uses one follows the start offset.
+ */
+static void doRangewiseApplyFunctions(SQueryRuntimeEnv *pRuntimeEnv, SWindowStatus *pStatus, STimeWindow *pWin,
+                                      int32_t startPos, int32_t num) {
+  SQuery *        pQuery = pRuntimeEnv->pQuery;
+  SQLFunctionCtx *pCtx = pRuntimeEnv->pCtx;
+  int32_t         startOffset = (QUERY_IS_ASC_QUERY(pQuery)) ? startPos : startPos - (num - 1);
+
+  for (int32_t k = 0; k < pQuery->numOfOutputCols; ++k) {
+    if (pCtx[k].ptsList != NULL) {
+      pCtx[k].ptsList = (TSKEY *)pRuntimeEnv->primaryColBuffer->data + startOffset;
+    }
+  }
+
+  doBlockwiseApplyFunctions(pRuntimeEnv, pStatus, pWin, startPos, num);
+}
+
 static int32_t getNextQualifiedWindow(SQueryRuntimeEnv *pRuntimeEnv, STimeWindow *pNextWin,
                                       SWindowResInfo *pWindowResInfo, SBlockInfo *pBlockInfo, TSKEY *primaryKeys,
                                       __block_search_fn_t searchFn) {
@@ -2180,7 +2303,23 @@ static int32_t blockwiseApplyAllFunctions(SQueryRuntimeEnv *pRuntimeEnv, int32_t
   }
 
   int32_t step = GET_FORWARD_DIRECTION_FACTOR(pQuery->order.order);
-  if (isIntervalQuery(pQuery)) {
+  if (isIntervalQuery(pQuery) && !IS_DATA_BLOCK_LOADED(pRuntimeEnv->blockStatus)) {
+    // the whole block is in one time window, see isBlockInSingleTimeWindow
+    TSKEY       ts = QUERY_IS_ASC_QUERY(pQuery) ? pBlockInfo->keyFirst : pBlockInfo->keyLast;
+    STimeWindow win = getActiveTimeWindow(pWindowResInfo, ts, pQuery);
+    assert(pBlockInfo->keyFirst >= win.skey && pBlockInfo->keyLast <= win.ekey);
+
+    if (setWindowOutputBufByKey(pRuntimeEnv, pWindowResInfo, pRuntimeEnv->pMeterObj->sid, &win) != TSDB_CODE_SUCCESS) {
+      tfree(sasArray);
+      return 0;
+    }
+
+    TSKEY ekey = reviseWindowEkey(pQuery, &win);
+    forwardStep = getNumOfRowsInTimeWindow(pQuery, pBlockInfo, primaryKeyCol, pQuery->pos, ekey, searchFn, true);
+
+    SWindowStatus *pStatus = getTimeWindowResStatus(pWindowResInfo, curTimeWindow(pWindowResInfo));
+    doBlockwiseApplyFunctions(pRuntimeEnv, pStatus, &win, pQuery->pos, forwardStep);
+  } else if (isIntervalQuery(pQuery)) {
     int32_t offset = GET_COL_DATA_POS(pQuery, 0, step);
     TSKEY   ts = primaryKeyCol[offset];
   
@@ -2270,65 +2409,135 @@ static int32_t blockwiseApplyAllFunctions(SQueryRuntimeEnv *pRuntimeEnv, int32_t
  *
  * first filter the data block according to the value filter condition, then, if the top/bottom query applied,
  * invoke the filter function to decide if the data block need to be accessed or not.
- * TODO handle the whole data block is NULL situation
  * @param pQuery
  * @param pField
  * @return
  */
-static bool needToLoadDataBlock(SQuery *pQuery, SField *pField, SQLFunctionCtx *pCtx, int32_t numOfTotalPoints) {
-  if (pField == NULL) {
-    return false;  // no need to load data
-  }
+// filters on the same column are OR-ed, and filters of different columns are AND-ed
+static bool isBlockQualifiedByFilters(SQuery *pQuery, SCompBlock *pBlock, SField *pField) {
+  int32_t numOfTotalPoints = pBlock->numOfPoints;
 
   for (int32_t k = 0; k < pQuery->numOfFilterCols; ++k) {
     SSingleColumnFilterInfo *pFilterInfo = &pQuery->pFilterInfo[k];
     int32_t                  colIndex = pFilterInfo->info.colIdx;
 
     // this column not valid in current data block
-    if (colIndex < 0 || pField[colIndex].colId != pFilterInfo->info.data.colId) {
+    if (colIndex < 0 || colIndex >= pBlock->numOfCols || pField[colIndex].colId != pFilterInfo->info.data.colId) {
       continue;
     }
 
-    // not support pre-filter operation on binary/nchar data type
-    if (!vnodeSupportPrefilter(pFilterInfo->info.data.type)) {
-      continue;
-    }
-
-    // all points in current column are NULL, no need to check its boundary value
+    // all points in current column are NULL, no value is qualified
     if (pField[colIndex].numOfNullPoints == numOfTotalPoints) {
-      continue;
+      return false;
     }
 
-    if (pFilterInfo->info.data.type == TSDB_DATA_TYPE_FLOAT) {
+    bool qualified = false;
+
+    if (!vnodeSupportPrefilter(pFilterInfo->info.data.type)) {
+      // binary/nchar columns, by the prefixes of min/max value and the bloom filter
+      for (int32_t i = 0; i < pFilterInfo->numOfFilters && !qualified; ++i) {
+        qualified = vnodeStrPrefilter(&pFilterInfo->pFilters[i], pFilterInfo->info.data.type, &pField[colIndex]);
+      }
+    } else if (pFilterInfo->info.data.type == TSDB_DATA_TYPE_FLOAT) {
       float minval = *(double *)(&pField[colIndex].min);
       float maxval = *(double *)(&pField[colIndex].max);
 
-      for (int32_t i = 0; i < pFilterInfo->numOfFilters; ++i) {
-        if (pFilterInfo->pFilters[i].fp(&pFilterInfo->pFilters[i], (char *)&minval, (char *)&maxval)) {
-          return true;
-        }
+      for (int32_t i = 0; i < pFilterInfo->numOfFilters && !qualified; ++i) {
+        qualified = pFilterInfo->pFilters[i].fp(&pFilterInfo->pFilters[i], (char *)&minval, (char *)&maxval);
       }
     } else {
-      for (int32_t i = 0; i < pFilterInfo->numOfFilters; ++i) {
-        if (pFilterInfo->pFilters[i].fp(&pFilterInfo->pFilters[i], (char *)&pField[colIndex].min,
-                                        (char *)&pField[colIndex].max)) {
-          return true;
-        }
+      for (int32_t i = 0; i < pFilterInfo->numOfFilters && !qualified; ++i) {
+        qualified = pFilterInfo->pFilters[i].fp(&pFilterInfo->pFilters[i], (char *)&pField[colIndex].min,
+                                                (char *)&pField[colIndex].max);
       }
     }
-  }
 
-  // todo disable this opt code block temporarily
-  //  for (int32_t i = 0; i < pQuery->numOfOutputCols; ++i) {
-  //    int32_t functId = pQuery->pSelectExpr[i].pBase.functionId;
-  //    if (functId == TSDB_FUNC_TOP || functId == TSDB_FUNC_BOTTOM) {
-  //      return top_bot_datablock_filter(&pCtx[i], functId, (char *)&pField[i].min, (char *)&pField[i].max);
-  //    }
-  //  }
+    if (!qualified) {
+      return false;
+    }
+  }
 
   return true;
 }
 
+static bool needToLoadDataBlock(SQueryRuntimeEnv *pRuntimeEnv, SCompBlock *pBlock, SField *pField) {
+  SQuery *pQuery = pRuntimeEnv->pQuery;
+  int32_t numOfTotalPoints = pBlock->numOfPoints;
+
+  if (pField == NULL) {
+    return false;  // no need to load data
+  }
+
+  if (!isBlockQualifiedByFilters(pQuery, pBlock, pField)) {
+    return false;
+  }
+
+  /*
+   * For a top/bottom query on a table, the block is discarded if its max/min value can not beat the smallest/largest
+   * value kept in the result buffer. In super table query, the output buffer of the meter is not set yet when the
+   * block is checked, and in interval query the buffer belongs to the previous window, so both are excluded.
+   */
+  if (pRuntimeEnv->stableQuery || isIntervalQuery(pQuery)) {
+    return true;
+  }
+
+  int32_t topBotIndex = -1;
+  for (int32_t i = 0; i < pQuery->numOfOutputCols; ++i) {
+    int32_t functId = pQuery->pSelectExpr[i].pBase.functionId;
+    if (functId == TSDB_FUNC_TOP || functId == TSDB_FUNC_BOTTOM) {
+      topBotIndex = i;
+    } else if (functId != TSDB_FUNC_TS && functId != TSDB_FUNC_TS_DUMMY && functId != TSDB_FUNC_TAG_DUMMY) {
+      return true;
+    }
+  }
+
+  if (topBotIndex < 0) {
+    return true;
+  }
+
+  SQLFunctionCtx *pCtx = &pRuntimeEnv->pCtx[topBotIndex];
+  int16_t         colId = pQuery->pSelectExpr[topBotIndex].pBase.colInfo.colId;
+
+  for (int32_t i = 0; i < pBlock->numOfCols; ++i) {
+    if (pField[i].colId != colId) {
+      continue;
+    }
+
+    if (pField[i].numOfNullPoints == numOfTotalPoints) {
+      return false;
+    }
+
+    return top_bot_datablock_filter(pCtx, pQuery->pSelectExpr[topBotIndex].pBase.functionId, (char *)&pField[i].min,
+                                    (char *)&pField[i].max);
+  }
+
+  // the column does not exist in this block, all values are NULL
+  return false;
+}
+
+/*
+ * An interval query is answered from the pre-aggregated values in SField for a file block that falls entirely into one
+ * time window, if every output function is able to use them. The time windows of an interval query are aligned to the
+ * same grid as taosGetIntervalStartTimestamp, so the window of keyFirst is the only candidate.
+ */
+static bool isBlockInSingleTimeWindow(SQuery *pQuery, TSKEY keyFirst, TSKEY keyLast) {
+  if (pQuery->slidingTime != pQuery->intervalTime || isSelectivityWithTagsQuery(pQuery)) {
+    return false;
+  }
+
+  for (int32_t i = 0; i < pQuery->numOfOutputCols; ++i) {
+    int32_t functId = pQuery->pSelectExpr[i].pBase.functionId;
+    if (functId != TSDB_FUNC_TS && functId != TSDB_FUNC_COUNT && functId != TSDB_FUNC_SUM &&
+        functId != TSDB_FUNC_AVG && functId != TSDB_FUNC_MIN && functId != TSDB_FUNC_MAX &&
+        functId != TSDB_FUNC_SPREAD && functId != TSDB_FUNC_TAG) {
+      return false;
+    }
+  }
+
+  TSKEY skey = taosGetIntervalStartTimestamp(keyFirst, pQuery->slidingTime, pQuery->slidingTimeUnit, pQuery->precision);
+  return (skey <= keyFirst) && (keyLast - skey < pQuery->intervalTime);
+}
+
 int32_t initWindowResInfo(SWindowResInfo *pWindowResInfo, SQueryRuntimeEnv *pRuntimeEnv, int32_t size,
                           int32_t threshold, int16_t type) {
   pWindowResInfo->capacity = size;
@@ -2500,8 +2709,6 @@ static int32_t setGroupResultOutputBuf(SQueryRuntimeEnv *pRuntimeEnv, char *pDat
 
   int32_t GROUPRESULTID = 1;
 
-  SQueryDiskbasedResultBuf *pResultBuf = pRuntimeEnv->pResultBuf;
-
   SWindowResult *pWindowRes = doSetTimeWindowFromKey(pRuntimeEnv, &pRuntimeEnv->windowResInfo, pData, bytes);
   if (pWindowRes == NULL) {
     return -1;
@@ -2509,7 +2716,7 @@ static int32_t setGroupResultOutputBuf(SQueryRuntimeEnv *pRuntimeEnv, char *pDat
 
   // not assign result buffer yet, add new result buffer
   if (pWindowRes->pos.pageId == -1) {
-    int32_t ret = addNewWindowResultBuf(pWindowRes, pResultBuf, GROUPRESULTID, pRuntimeEnv->numOfRowsPerPage);
+    int32_t ret = addNewWindowResultBuf(pWindowRes, pRuntimeEnv, GROUPRESULTID, pRuntimeEnv->numOfRowsPerPage);
     if (ret != 0) {
       return -1;
     }
@@ -2606,6 +2813,15 @@ static bool functionNeedToExecute(SQueryRuntimeEnv *pRuntimeEnv, SQLFunctionCtx
   return true;
 }
 
+// pSel holds the result of the batch filter from selStart on, without it the row is checked by itself
+static FORCE_INLINE bool isRowSelected(SQuery *pQuery, uint8_t *pSel, int32_t selStart, int32_t offset) {
+  if (pSel != NULL) {
+    return pSel[offset - selStart] != 0;
+  }
+
+  return pQuery->numOfFilterCols == 0 || vnodeDoFilterData(pQuery, offset);
+}
+
 static int32_t rowwiseApplyAllFunctions(SQueryRuntimeEnv *pRuntimeEnv, int32_t *forwardStep, SField *pFields,
                                         SBlockInfo *pBlockInfo, SWindowResInfo *pWindowResInfo) {
   SQLFunctionCtx *pCtx = pRuntimeEnv->pCtx;
@@ -2656,6 +2872,20 @@ static int32_t rowwiseApplyAllFunctions(SQueryRuntimeEnv *pRuntimeEnv, int32_t *
   int32_t numOfRes = 0;
   int32_t step = GET_FORWARD_DIRECTION_FACTOR(pQuery->order.order);
 
+  // evaluate the filters over the whole accessed range of the block at once, instead of row by row
+  uint8_t *pSel = NULL;
+  int32_t  selStart = 0;
+  int32_t  numOfSel = 0;
+  if (pQuery->numOfFilterCols > 0 && (*forwardStep) > 0) {
+    selStart = MIN(GET_COL_DATA_POS(pQuery, 0, step), GET_COL_DATA_POS(pQuery, (*forwardStep) - 1, step));
+    pSel = malloc((size_t)(*forwardStep));
+
+    // out of memory, the filters are evaluated row by row instead
+    if (pSel != NULL) {
+      numOfSel = vnodeBatchFilterData(pQuery, selStart, *forwardStep, pSel);
+    }
+  }
+
   // from top to bottom in desc
   // from bottom to top in asc order
   if (pRuntimeEnv->pTSBuf != NULL) {
@@ -2668,7 +2898,74 @@ static int32_t rowwiseApplyAllFunctions(SQueryRuntimeEnv *pRuntimeEnv, int32_t *
   TSKEY   lastKey = -1;
   int32_t lastIndex = -1;
   
-  for (j = 0; j < (*forwardStep); ++j) {
+  // no qualified rows, nothing to feed the functions
+  int32_t numOfRows = (pSel != NULL && numOfSel == 0 && pRuntimeEnv->pTSBuf == NULL) ? 0 : (*forwardStep);
+
+  /*
+   * Split the rows into runs of consecutive rows of the same time window, so the window and its output buffer are
+   * located once per run rather than once per row, and feed each range of consecutive selected rows of a run to the
+   * functions in one call. Overlapped sliding windows, ts join and the result buffer check still go row by row below.
+   */
+  if (isIntervalQuery(pQuery) && pRuntimeEnv->pTSBuf == NULL && pQuery->checkBufferInLoop == 0 &&
+      pQuery->slidingTime == pQuery->intervalTime && IS_DATA_BLOCK_LOADED(pRuntimeEnv->blockStatus)) {
+    int32_t sid = pRuntimeEnv->pMeterObj->sid;
+
+    j = 0;
+    while (j < numOfRows) {
+      STimeWindow win = getActiveTimeWindow(pWindowResInfo, primaryKeyCol[GET_COL_DATA_POS(pQuery, j, step)], pQuery);
+
+      // keys are ordered in the accessed range, so the run ends at the first row out of the window
+      int32_t end = j + 1;
+      int32_t hi = numOfRows;
+      while (end < hi) {
+        int32_t mid = end + ((hi - end) >> 1);
+        TSKEY   ts = primaryKeyCol[GET_COL_DATA_POS(pQuery, mid, step)];
+        if (ts >= win.skey && ts <= win.ekey) {
+          end = mid + 1;
+        } else {
+          hi = mid;
+        }
+      }
+
+      SWindowStatus *pStatus = NULL;
+      while (j < end) {
+        if (!isRowSelected(pQuery, pSel, selStart, GET_COL_DATA_POS(pQuery, j, step))) {
+          j += 1;
+          continue;
+        }
+
+        int32_t first = j;
+        while (++j < end && isRowSelected(pQuery, pSel, selStart, GET_COL_DATA_POS(pQuery, j, step))) {
+        }
+
+        if (pStatus == NULL) {
+          if (setWindowOutputBufByKey(pRuntimeEnv, pWindowResInfo, sid, &win) != TSDB_CODE_SUCCESS) {
+            j = end;  // null data, failed to allocate more memory buffer
+            break;
+          }
+
+          pStatus = getTimeWindowResStatus(pWindowResInfo, curTimeWindow(pWindowResInfo));
+        }
+
+        doRangewiseApplyFunctions(pRuntimeEnv, pStatus, &win, GET_COL_DATA_POS(pQuery, first, step), j - first);
+        lastIndex = j - 1;
+      }
+    }
+
+    // leave the functions with the accessed range of the block, as set up for them above
+    int32_t startOffset = (QUERY_IS_ASC_QUERY(pQuery)) ? pQuery->pos : pQuery->pos - ((*forwardStep) - 1);
+    for (int32_t k = 0; k < pQuery->numOfOutputCols; ++k) {
+      pCtx[k].startOffset = startOffset;
+      pCtx[k].size = *forwardStep;
+      if (pCtx[k].ptsList != NULL) {
+        pCtx[k].ptsList = primaryKeyCol + startOffset;
+      }
+    }
+
+    numOfRows = 0;
+  }
+
+  for (j = 0; j < numOfRows; ++j) {
     int32_t offset = GET_COL_DATA_POS(pQuery, j, step);
 
     if (pRuntimeEnv->pTSBuf != NULL) {
@@ -2682,7 +2979,7 @@ static int32_t rowwiseApplyAllFunctions(SQueryRuntimeEnv *pRuntimeEnv, int32_t *
       }
     }
 
-    if (pQuery->numOfFilterCols > 0 && (!vnodeDoFilterData(pQuery, offset))) {
+    if (!isRowSelected(pQuery, pSel, selStart, offset)) {
       continue;
     }
 
@@ -2813,6 +3110,7 @@ static int32_t rowwiseApplyAllFunctions(SQueryRuntimeEnv *pRuntimeEnv, int32_t *
   }
 
   free(sasArray);
+  tfree(pSel);
 
   /*
    * No need to calculate the number of output results for group-by normal columns, interval query
@@ -3321,6 +3619,12 @@ bool isQueryKilled(SQuery *pQuery) {
     return true;
   }
 
+  // the query that the scan task belongs to is killed
+  if (pQInfo->pParent != NULL && pQInfo->pParent->killed == 1) {
+    pQInfo->killed = 1;
+    return true;
+  }
+
   return (pQInfo->killed == 1);
 }
 
@@ -3550,20 +3854,20 @@ static bool cacheBoundaryCheck(SQueryRuntimeEnv *pRuntimeEnv, SMeterObj *pMeterO
   return true;
 }
 
-void getBasicCacheInfoSnapshot(SQuery *pQuery, SCacheInfo *pCacheInfo, int32_t vid) {
+void getBasicCacheInfoSnapshot(SQuery *pQuery, SCacheInfo *pCacheInfo, SMeterObj *pMeterObj) {
   // commitSlot here denotes the first uncommitted block in cache
   int32_t numOfBlocks = 0;
   int32_t lastSlot = 0;
   int32_t commitSlot = 0;
   int32_t commitPoint = 0;
 
-  SCachePool *pPool = (SCachePool *)vnodeList[vid].pCachePool;
-  pthread_mutex_lock(&pPool->vmutex);
+  SCacheShard *pShard = vnodeGetCacheShard(vnodeList[pMeterObj->vnode].pCachePool, pMeterObj->sid);
+  pthread_mutex_lock(&pShard->mutex);
   numOfBlocks = pCacheInfo->numOfBlocks;
   lastSlot = pCacheInfo->currentSlot;
   commitSlot = pCacheInfo->commitSlot;
   commitPoint = pCacheInfo->commitPoint;
-  pthread_mutex_unlock(&pPool->vmutex);
+  pthread_mutex_unlock(&pShard->mutex);
 
   // make sure it is there, otherwise, return right away
   pQuery->currentSlot = lastSlot;
@@ -3593,7 +3897,7 @@ int64_t getQueryStartPositionInCache(SQueryRuntimeEnv *pRuntimeEnv, int32_t *slo
   vnodeFreeFieldsEx(pRuntimeEnv);
 
   // keep in-memory cache status in local variables in case that it may be changed by write operation
-  getBasicCacheInfoSnapshot(pQuery, pMeterObj->pCache, pMeterObj->vnode);
+  getBasicCacheInfoSnapshot(pQuery, pMeterObj->pCache, pMeterObj);
 
   SCacheInfo *pCacheInfo = (SCacheInfo *)pMeterObj->pCache;
   if (pCacheInfo == NULL || pCacheInfo->cacheBlocks == NULL || pQuery->numOfBlocks == 0) {
@@ -3685,7 +3989,7 @@ bool hasDataInCache(SQueryRuntimeEnv *pRuntimeEnv, SMeterObj *pMeterObj) {
 
   /* numOfBlocks value has been overwrite, release pFields data if exists */
   vnodeFreeFieldsEx(pRuntimeEnv);
-  getBasicCacheInfoSnapshot(pQuery, pCacheInfo, pMeterObj->vnode);
+  getBasicCacheInfoSnapshot(pQuery, pCacheInfo, pMeterObj);
   if (pQuery->numOfBlocks <= 0) {
     return false;
   }
@@ -3916,7 +4220,7 @@ bool normalizeUnBoundLastRowQuery(STableQuerySupportObj *pSupporter, SPointInter
   vnodeFreeFieldsEx(pRuntimeEnv);
 
   // keep in-memory cache status in local variables in case that it may be changed by write operation
-  getBasicCacheInfoSnapshot(pQuery, pMeterObj->pCache, pMeterObj->vnode);
+  getBasicCacheInfoSnapshot(pQuery, pMeterObj->pCache, pMeterObj);
 
   SCacheInfo *pCacheInfo = (SCacheInfo *)pMeterObj->pCache;
   if (pCacheInfo != NULL && pCacheInfo->cacheBlocks != NULL && pQuery->numOfBlocks > 0) {
@@ -5195,6 +5499,12 @@ void vnodeQueryFreeQInfoEx(SQInfo *pQInfo) {
 
   tfree(pSupporter->pMeterDataInfo);
 
+  if (pSupporter->pScanTasks != NULL) {
+    pthread_mutex_destroy(&pSupporter->pScanTasks->mutex);
+    pthread_cond_destroy(&pSupporter->pScanTasks->cond);
+    tfree(pSupporter->pScanTasks);
+  }
+
   tfree(pQInfo->pTableQuerySupporter);
 }
 
@@ -5232,6 +5542,8 @@ int32_t vnodeSTableQueryPrepare(SQInfo *pQInfo, SQuery *pQuery, void *param) {
   // save raw query range for applying to each subgroup
   pSupporter->rawEKey = pQuery->ekey;
   pSupporter->rawSKey = pQuery->skey;
+  pSupporter->meterStart = 0;
+  pSupporter->meterEnd = pSupporter->numOfMeters;
   pQuery->lastKey = pQuery->skey;
   pRuntimeEnv->interpoSearch = needsBoundaryTS(pQuery);
 
@@ -5296,6 +5608,278 @@ int32_t vnodeSTableQueryPrepare(SQInfo *pQInfo, SQuery *pQuery, void *param) {
   return TSDB_CODE_SUCCESS;
 }
 
+/*
+ * The meter list, sid set and output buffer are shared with the query. The column list, filters and expressions are
+ * copied since the column index in them is updated for each scanned meter, while the items they refer to are shared.
+ */
+static int64_t getRuntimeEnvBufSize(SQueryRuntimeEnv *pRuntimeEnv, SMeterObj *pMeterObj) {
+  SQuery *pQuery = pRuntimeEnv->pQuery;
+  int64_t size = 2 * (int64_t)pRuntimeEnv->unzipBufSize;
+
+  for (int32_t i = 0; i < pQuery->numOfCols; ++i) {
+    size += (int64_t)pQuery->colList[i].data.bytes * pMeterObj->pointsPerFileBlock;
+  }
+
+  if (!PRIMARY_TSCOL_LOADED(pQuery)) {
+    size += (int64_t)pMeterObj->pointsPerFileBlock * TSDB_KEYSIZE;
+  }
+
+  if (pRuntimeEnv->pResultBuf != NULL) {
+    size += getResBufSize(pRuntimeEnv->pResultBuf);
+  }
+
+  return size;
+}
+
+int64_t vnodeEstimateQueryMem(SQInfo *pQInfo) {
+  SQuery *   pQuery = &pQInfo->query;
+  SMeterObj *pMeterObj = pQInfo->pObj;
+
+  // projection query, both halves of the output buffer and the loaded columns of a file block
+  if (pQInfo->pTableQuerySupporter == NULL) {
+    int64_t size = 2 * (int64_t)pQuery->rowSize * vnodeList[pMeterObj->vnode].cfg.rowsInFileBlock *
+                   pQInfo->retrieveWindow;
+    for (int32_t i = 0; i < pQuery->numOfCols; ++i) {
+      size += (int64_t)pQuery->colList[i].data.bytes * pMeterObj->pointsPerFileBlock;
+    }
+
+    return size;
+  }
+
+  SQueryRuntimeEnv *pRuntimeEnv = &pQInfo->pTableQuerySupporter->runtimeEnv;
+  return (int64_t)pQuery->rowSize * pQuery->pointsToRead + getRuntimeEnvBufSize(pRuntimeEnv, pMeterObj);
+}
+
+SQInfo *vnodeCreateSTableScanTask(SQInfo *pQInfo, int32_t meterStart, int32_t meterEnd) {
+  SQuery *               pQuery = &pQInfo->query;
+  STableQuerySupportObj *pSupporter = pQInfo->pTableQuerySupporter;
+
+  SQInfo *pTask = calloc(1, sizeof(SQInfo));
+  if (pTask == NULL) {
+    return NULL;
+  }
+
+  pTask->signature = (uint64_t)pTask;
+  pTask->pObj = pQInfo->pObj;
+  pTask->pParent = pQInfo;
+
+  SQuery *pTaskQuery = &pTask->query;
+  memcpy(pTaskQuery, pQuery, sizeof(SQuery));
+
+  pTaskQuery->pBlock = NULL;
+  pTaskQuery->pFields = NULL;
+  pTaskQuery->numOfBlocks = 0;
+  pTaskQuery->blockBufferSize = 0;
+  pTaskQuery->pFilterInfo = NULL;
+
+  pTaskQuery->colList = malloc(sizeof(SColumnInfoEx) * pQuery->numOfCols);
+  pTaskQuery->pSelectExpr = malloc(sizeof(SSqlFunctionExpr) * pQuery->numOfOutputCols);
+  if (pTaskQuery->colList == NULL || pTaskQuery->pSelectExpr == NULL) {
+    goto _error;
+  }
+
+  memcpy(pTaskQuery->colList, pQuery->colList, sizeof(SColumnInfoEx) * pQuery->numOfCols);
+  memcpy(pTaskQuery->pSelectExpr, pQuery->pSelectExpr, sizeof(SSqlFunctionExpr) * pQuery->numOfOutputCols);
+
+  if (pQuery->numOfFilterCols > 0) {
+    pTaskQuery->pFilterInfo = malloc(sizeof(SSingleColumnFilterInfo) * pQuery->numOfFilterCols);
+    if (pTaskQuery->pFilterInfo == NULL) {
+      goto _error;
+    }
+
+    memcpy(pTaskQuery->pFilterInfo, pQuery->pFilterInfo, sizeof(SSingleColumnFilterInfo) * pQuery->numOfFilterCols);
+  }
+
+  STableQuerySupportObj *pTaskSupporter = calloc(1, sizeof(STableQuerySupportObj));
+  if (pTaskSupporter == NULL) {
+    goto _error;
+  }
+
+  pTask->pTableQuerySupporter = pTaskSupporter;
+
+  pTaskSupporter->pMetersHashTable = pSupporter->pMetersHashTable;
+  pTaskSupporter->pMeterSidExtInfo = pSupporter->pMeterSidExtInfo;
+  pTaskSupporter->numOfMeters = pSupporter->numOfMeters;
+  pTaskSupporter->pSidSet = pSupporter->pSidSet;
+  pTaskSupporter->rawSKey = pSupporter->rawSKey;
+  pTaskSupporter->rawEKey = pSupporter->rawEKey;
+  pTaskSupporter->meterStart = meterStart;
+  pTaskSupporter->meterEnd = meterEnd;
+
+  // meter data info is indexed by the position of meter in the whole list
+  pTaskSupporter->pMeterDataInfo = calloc(pSupporter->numOfMeters, sizeof(SMeterDataInfo));
+  if (pTaskSupporter->pMeterDataInfo == NULL) {
+    goto _error;
+  }
+
+  SQueryRuntimeEnv *pRuntimeEnv = &pTaskSupporter->runtimeEnv;
+  doInitQueryFileInfoFD(&pRuntimeEnv->vnodeFileInfo);
+  vnodeInitDataBlockInfo(&pRuntimeEnv->loadBlockInfo);
+  vnodeInitLoadCompBlockInfo(&pRuntimeEnv->loadCompBlockInfo);
+
+  pRuntimeEnv->interpoSearch = pSupporter->runtimeEnv.interpoSearch;
+  pRuntimeEnv->cur.vnodeIndex = -1;
+
+  SMeterObj *pMeter = getMeterObj(pSupporter->pMetersHashTable, pSupporter->pMeterSidExtInfo[meterStart]->sid);
+
+  int32_t ret = setupQueryRuntimeEnv(pMeter, pTaskQuery, pRuntimeEnv, pSupporter->pSidSet->pColumnModel, TSQL_SO_ASC,
+                                     true);
+  if (ret != TSDB_CODE_SUCCESS) {
+    goto _error;
+  }
+
+  ret = allocateRuntimeEnvBuf(pRuntimeEnv, pMeter);
+  if (ret != TSDB_CODE_SUCCESS) {
+    goto _error;
+  }
+
+  vnodeRecordAllFiles(pTask, pMeter->vnode);
+
+  ret = createDiskbasedResultBuffer(&pRuntimeEnv->pResultBuf, getInitialPageNum(pTaskSupporter), pQuery->rowSize);
+  if (ret != TSDB_CODE_SUCCESS) {
+    goto _error;
+  }
+
+  initWindowResInfo(&pRuntimeEnv->windowResInfo, pRuntimeEnv, 512, 4096, TSDB_DATA_TYPE_INT);
+  pRuntimeEnv->numOfRowsPerPage = pSupporter->runtimeEnv.numOfRowsPerPage;
+
+  TSKEY revisedStime = taosGetIntervalStartTimestamp(pSupporter->rawSKey, pQuery->intervalTime,
+                                                     pQuery->slidingTimeUnit, pQuery->precision);
+  taosInitInterpoInfo(&pRuntimeEnv->interpoInfo, pQuery->order.order, revisedStime, 0, 0);
+  pRuntimeEnv->stableQuery = true;
+
+  // the scan buffers of the task are allocated in addition to the reserved memory of the query
+  vnodeChargeQueryMem(pTask, getRuntimeEnvBufSize(pRuntimeEnv, pMeter));
+
+  dTrace("QInfo:%p scan task:%p created, meters:%d-%d", pQInfo, pTask, meterStart, meterEnd);
+  return pTask;
+
+_error:
+  dError("QInfo:%p failed to create scan task for meters:%d-%d", pQInfo, meterStart, meterEnd);
+  vnodeFreeSTableScanTask(pTask);
+  return NULL;
+}
+
+static void addQueryCostSummary(SQueryCostSummary *pSummary, SQueryCostSummary *pTaskSummary) {
+  pSummary->cacheTimeUs += pTaskSummary->cacheTimeUs;
+  pSummary->fileTimeUs += pTaskSummary->fileTimeUs;
+  pSummary->numOfFiles = MAX(pSummary->numOfFiles, pTaskSummary->numOfFiles);
+  pSummary->numOfTables = MAX(pSummary->numOfTables, pTaskSummary->numOfTables);
+  pSummary->numOfSeek += pTaskSummary->numOfSeek;
+  pSummary->readDiskBlocks += pTaskSummary->readDiskBlocks;
+  pSummary->skippedFileBlocks += pTaskSummary->skippedFileBlocks;
+  pSummary->blocksInCache += pTaskSummary->blocksInCache;
+  pSummary->readField += pTaskSummary->readField;
+  pSummary->totalFieldSize += pTaskSummary->totalFieldSize;
+  pSummary->loadFieldUs += pTaskSummary->loadFieldUs;
+  pSummary->totalBlockSize += pTaskSummary->totalBlockSize;
+  pSummary->loadBlocksUs += pTaskSummary->loadBlocksUs;
+  pSummary->totalGenData += pTaskSummary->totalGenData;
+  pSummary->readCompInfo += pTaskSummary->readCompInfo;
+  pSummary->totalCompInfoSize += pTaskSummary->totalCompInfoSize;
+  pSummary->loadCompInfoUs += pTaskSummary->loadCompInfoUs;
+}
+
+/*
+ * The group results of the task are intermediate results, they are merged into the group results of the query with
+ * the first stage merge functions, the same as the results of different vnodes are merged by the client.
+ */
+int32_t vnodeMergeSTableScanTask(SQInfo *pQInfo, SQInfo *pTask) {
+  STableQuerySupportObj *pSupporter = pQInfo->pTableQuerySupporter;
+  SQueryRuntimeEnv *     pRuntimeEnv = &pSupporter->runtimeEnv;
+  SQueryRuntimeEnv *     pTaskRuntimeEnv = &pTask->pTableQuerySupporter->runtimeEnv;
+  SWindowResInfo *       pTaskWindowResInfo = &pTaskRuntimeEnv->windowResInfo;
+
+  SQuery *        pQuery = pRuntimeEnv->pQuery;
+  SQLFunctionCtx *pCtx = pRuntimeEnv->pCtx;
+  int32_t         GROUPRESULTID = 1;
+
+  for (int32_t groupIdx = 0; groupIdx < pSupporter->pSidSet->numOfSubSet; ++groupIdx) {
+    int32_t *p = (int32_t *)taosGetDataFromHashTable(pTaskWindowResInfo->hashList, (char *)&groupIdx, sizeof(groupIdx));
+    if (p == NULL) {
+      continue;
+    }
+
+    SWindowResult *pTaskWindowRes = getWindowResult(pTaskWindowResInfo, *p);
+    if (pTaskWindowRes->numOfRows == 0) {
+      continue;
+    }
+
+    SWindowResult *pWindowRes =
+        doSetTimeWindowFromKey(pRuntimeEnv, &pRuntimeEnv->windowResInfo, (char *)&groupIdx, sizeof(groupIdx));
+    if (pWindowRes == NULL || addNewWindowResultBuf(pWindowRes, pRuntimeEnv, GROUPRESULTID,
+                                                    pRuntimeEnv->numOfRowsPerPage) != TSDB_CODE_SUCCESS) {
+      return TSDB_CODE_SERV_OUT_OF_MEMORY;
+    }
+
+    setWindowResOutputBuf(pRuntimeEnv, pWindowRes);
+    initCtxOutputBuf(pRuntimeEnv);
+
+    for (int32_t i = 0; i < pQuery->numOfOutputCols; ++i) {
+      int32_t functionId = pQuery->pSelectExpr[i].pBase.functionId;
+
+      pCtx[i].currentStage = FIRST_STAGE_MERGE;
+      pCtx[i].hasNull = true;
+      pCtx[i].size = 1;
+      pCtx[i].aInputElemBuf = getPosInResultPage(pTaskRuntimeEnv, i, pTaskWindowRes);
+
+      if (functionId == TSDB_FUNC_TAG_DUMMY || functionId == TSDB_FUNC_TAG) {
+        tVariantDestroy(&pCtx[i].tag);
+        tVariantCreateFromBinary(&pCtx[i].tag, pCtx[i].aInputElemBuf, pCtx[i].inputBytes, pCtx[i].inputType);
+      }
+    }
+
+    for (int32_t i = 0; i < pQuery->numOfOutputCols; ++i) {
+      int32_t functionId = pQuery->pSelectExpr[i].pBase.functionId;
+      if (functionId == TSDB_FUNC_TAG_DUMMY) {
+        continue;
+      }
+
+      aAggs[functionId].distMergeFunc(&pCtx[i]);
+    }
+
+    pWindowRes->numOfRows = MAX(pWindowRes->numOfRows, pTaskWindowRes->numOfRows);
+  }
+
+  addQueryCostSummary(&pRuntimeEnv->summary, &pTaskRuntimeEnv->summary);
+  return TSDB_CODE_SUCCESS;
+}
+
+void vnodeFreeSTableScanTask(SQInfo *pTask) {
+  if (pTask == NULL) {
+    return;
+  }
+
+  SQuery *               pQuery = &pTask->query;
+  STableQuerySupportObj *pSupporter = pTask->pTableQuerySupporter;
+
+  vnodeReleaseQueryMem(pTask);
+
+  if (pSupporter != NULL) {
+    teardownQueryRuntimeEnv(&pSupporter->runtimeEnv);
+
+    if (pSupporter->pMeterDataInfo != NULL) {
+      for (int32_t j = 0; j < pSupporter->numOfMeters; ++j) {
+        destroyMeterQueryInfo(pSupporter->pMeterDataInfo[j].pMeterQInfo, pQuery->numOfOutputCols);
+        free(pSupporter->pMeterDataInfo[j].pBlock);
+      }
+    }
+
+    tfree(pSupporter->pMeterDataInfo);
+    tfree(pTask->pTableQuerySupporter);
+  }
+
+  vnodeFreeFields(pQuery);
+  tfree(pQuery->pBlock);
+
+  tfree(pQuery->pFilterInfo);
+  tfree(pQuery->colList);
+  tfree(pQuery->pSelectExpr);
+
+  memset(pTask, 0, sizeof(SQInfo));
+  free(pTask);
+}
+
 /**
  * decrease the refcount for each table involved in this query
  * @param pQInfo
@@ -6242,9 +6826,8 @@ int32_t doMergeMetersResultsToGroupRes(STableQuerySupportObj *pSupporter, SQuery
 }
 
 int32_t flushFromResultBuf(STableQuerySupportObj *pSupporter, const SQuery *pQuery,
-                           const SQueryRuntimeEnv *pRuntimeEnv) {
-  SQueryDiskbasedResultBuf *pResultBuf = pRuntimeEnv->pResultBuf;
-  int32_t                   capacity = (DEFAULT_INTERN_BUF_SIZE - sizeof(tFilePage)) / pQuery->rowSize;
+                           SQueryRuntimeEnv *pRuntimeEnv) {
+  int32_t capacity = (DEFAULT_INTERN_BUF_SIZE - sizeof(tFilePage)) / pQuery->rowSize;
 
   // the base value for group result, since the maximum number of table for each vnode will not exceed 100,000.
   int32_t pageId = -1;
@@ -6259,7 +6842,7 @@ int32_t flushFromResultBuf(STableQuerySupportObj *pSupporter, const SQuery *pQue
     }
 
     int32_t    id = getGroupResultId(pSupporter->subgroupIdx) + pSupporter->numOfGroupResultPages;
-    tFilePage *buf = getNewDataBuf(pResultBuf, id, &pageId);
+    tFilePage *buf = getNewResultPage(pRuntimeEnv, id, &pageId);
 
     // pagewise copy to dest buffer
     for (int32_t i = 0; i < pQuery->numOfOutputCols; ++i) {
@@ -6905,6 +7488,10 @@ int32_t vnodeFilterQualifiedMeters(SQInfo *pQInfo, int32_t vid, tSidSet *pSidSet
       groupId += 1;
     }
 
+    if (i < pSupporter->meterStart || i >= pSupporter->meterEnd) {
+      continue;
+    }
+
     SMeterDataInfo *pOneMeterDataInfo = &pMeterDataInfo[i];
     if (pOneMeterDataInfo->pMeterObj == NULL) {
       setMeterDataInfo(pOneMeterDataInfo, pMeterObj, i, groupId);
@@ -7407,7 +7994,7 @@ void setExecutionContext(STableQuerySupportObj *pSupporter, SMeterQueryInfo *pMe
    * all group belong to one result set, and each group result has different group id so set the id to be one
    */
   if (pWindowRes->pos.pageId == -1) {
-    if (addNewWindowResultBuf(pWindowRes, pRuntimeEnv->pResultBuf, GROUPRESULTID, pRuntimeEnv->numOfRowsPerPage) !=
+    if (addNewWindowResultBuf(pWindowRes, pRuntimeEnv, GROUPRESULTID, pRuntimeEnv->numOfRowsPerPage) !=
         TSDB_CODE_SUCCESS) {
       return;
     }
@@ -7573,6 +8160,113 @@ bool needPrimaryTimestampCol(SQuery *pQuery, SBlockInfo *pBlockInfo) {
   return loadPrimaryTS;
 }
 
+/*
+ * What a file block entirely in the query range needs to be loaded, BLK_DATA_NO_NEEDED if the output functions are
+ * answered by its time range, BLK_DATA_FILEDS_NEEDED if by the pre-aggregated values in SField. If noResult is true,
+ * the functions are asked as if no result has been collected, which is how the block is seen before it is visited.
+ */
+static uint32_t getFileBlockDataReq(SQueryRuntimeEnv *pRuntimeEnv, SCompBlock *pBlock, uint8_t blkStatus,
+                                    bool noResult) {
+  SQuery *pQuery = pRuntimeEnv->pQuery;
+  if (pQuery->numOfFilterCols > 0) {
+    return BLK_DATA_ALL_NEEDED;
+  }
+
+  uint32_t req = 0;
+  for (int32_t i = 0; i < pQuery->numOfOutputCols; ++i) {
+    int32_t         functID = pQuery->pSelectExpr[i].pBase.functionId;
+    SQLFunctionCtx *pCtx = &pRuntimeEnv->pCtx[i];
+    SQLFunctionCtx  ctx;
+    SResultInfo     resInfo = {0};
+
+    if (noResult) {
+      ctx = *pCtx;
+      ctx.resultInfo = &resInfo;
+      pCtx = &ctx;
+    }
+
+    req |= aAggs[functID].dataReqFunc(pCtx, pBlock->keyFirst, pBlock->keyLast,
+                                      pQuery->pSelectExpr[i].pBase.colInfo.colId, blkStatus);
+  }
+
+  if (pRuntimeEnv->pTSBuf > 0 ||
+      (isIntervalQuery(pQuery) && !isBlockInSingleTimeWindow(pQuery, pBlock->keyFirst, pBlock->keyLast))) {
+    req |= BLK_DATA_ALL_NEEDED;
+  }
+
+  return req;
+}
+
+uint32_t vnodeGetFileBlockDataReq(SQueryRuntimeEnv *pRuntimeEnv, SCompBlock *pBlock) {
+  uint8_t blkStatus = 0;
+  SET_FILE_BLOCK_FLAG(blkStatus);
+  SET_DATA_BLOCK_NOT_LOADED(blkStatus);
+
+  return getFileBlockDataReq(pRuntimeEnv, pBlock, blkStatus, true);
+}
+
+/*
+ * Columns of a block read ahead after its fields: the columns loaded in the master scan that are neither all NULL
+ * nor in the block cache. Nothing is read if the fields are enough, or if the block is discarded by the filters,
+ * see needToLoadDataBlock. Columns are adjacent in the block, so most of them are merged into a few ranges.
+ */
+int32_t vnodeGetBlockReadRanges(void *param, int32_t seq, const char *head, SBlockReadRange *pRanges) {
+  SQueryBlockReadPlan *pPlan = (SQueryBlockReadPlan *)param;
+  SQuery *             pQuery = pPlan->pQuery;
+  SCompBlock *         pBlock = pPlan->pBlocks[seq];
+  SField *             pFields = (SField *)head;
+
+  if (!pPlan->loadColumns[seq] ||
+      !taosCheckChecksumWhole((uint8_t *)head, sizeof(SField) * pBlock->numOfCols + sizeof(TSCKSUM))) {
+    return 0;
+  }
+
+  if (pPlan->inRange[seq] && !isBlockQualifiedByFilters(pQuery, pBlock, pFields)) {
+    return 0;
+  }
+
+  int32_t num = 0;
+  int32_t i = 0, j = 0;
+
+  while (i < pQuery->numOfCols && j < pBlock->numOfCols) {
+    SColumnInfoEx *pCol = &pQuery->colList[i];
+    if (pFields[j].colId < pCol->data.colId) {
+      ++j;
+      continue;
+    } else if (pFields[j].colId > pCol->data.colId) {
+      ++i;
+      continue;
+    }
+
+    int64_t offset = pBlock->offset + pFields[j].offset;
+    int32_t len = pFields[j].len + sizeof(TSCKSUM);
+    bool    required = (pCol->req[0] == 1 || pCol->data.colId == PRIMARYKEY_TIMESTAMP_COL_INDEX) &&
+                    pFields[j].type == pCol->data.type && pFields[j].numOfNullPoints < pBlock->numOfPoints;
+
+    if (required && (pBlock->last || !vnodeIsBlockCached(pPlan->vnode, pPlan->fileId, pPlan->version, offset,
+                                                         pCol->data.colId))) {
+      SBlockReadRange *pLast = (num > 0) ? &pRanges[num - 1] : NULL;
+
+      if (pLast != NULL && pLast->offset + pLast->len == offset) {
+        pLast->len += len;
+      } else if (num < TSDB_BLOCK_READ_MAX_RANGES) {
+        pRanges[num].offset = offset;
+        pRanges[num].len = len;
+        num++;
+      } else {  // the last range is extended to the column, bytes in between are read in vain
+        int64_t end = MAX(pLast->offset + pLast->len, offset + len);
+        pLast->offset = MIN(pLast->offset, offset);
+        pLast->len = (int32_t)(end - pLast->offset);
+      }
+    }
+
+    ++i;
+    ++j;
+  }
+
+  return num;
+}
+
 int32_t LoadDatablockOnDemand(SCompBlock *pBlock, SField **pFields, uint8_t *blkStatus, SQueryRuntimeEnv *pRuntimeEnv,
                               int32_t fileIdx, int32_t slotIdx, __block_search_fn_t searchFn, bool onDemand) {
   SQuery *   pQuery = pRuntimeEnv->pQuery;
@@ -7589,21 +8283,7 @@ int32_t LoadDatablockOnDemand(SCompBlock *pBlock, SField **pFields, uint8_t *blk
   if (((pQuery->lastKey <= pBlock->keyFirst && pQuery->ekey >= pBlock->keyLast && QUERY_IS_ASC_QUERY(pQuery)) ||
        (pQuery->ekey <= pBlock->keyFirst && pQuery->lastKey >= pBlock->keyLast && !QUERY_IS_ASC_QUERY(pQuery))) &&
       onDemand) {
-    uint32_t req = 0;
-    if (pQuery->numOfFilterCols > 0) {
-      req = BLK_DATA_ALL_NEEDED;
-    } else {
-      for (int32_t i = 0; i < pQuery->numOfOutputCols; ++i) {
-        int32_t functID = pQuery->pSelectExpr[i].pBase.functionId;
-        req |= aAggs[functID].dataReqFunc(&pRuntimeEnv->pCtx[i], pBlock->keyFirst, pBlock->keyLast,
-                                          pQuery->pSelectExpr[i].pBase.colInfo.colId, *blkStatus);
-      }
-
-      if (pRuntimeEnv->pTSBuf > 0 || isIntervalQuery(pQuery)) {
-        req |= BLK_DATA_ALL_NEEDED;
-      }
-    }
-
+    uint32_t req = getFileBlockDataReq(pRuntimeEnv, pBlock, *blkStatus, false);
     if (req == BLK_DATA_NO_NEEDED) {
       qTrace("QInfo:%p vid:%d sid:%d id:%s, slot:%d, data block ignored, brange:%" PRId64 "-%" PRId64 ", rows:%d",
              GET_QINFO_ADDR(pQuery), pMeterObj->vnode, pMeterObj->sid, pMeterObj->meterId, pQuery->slot,
@@ -7631,7 +8311,7 @@ int32_t LoadDatablockOnDemand(SCompBlock *pBlock, SField **pFields, uint8_t *blk
        * filter the data block according to the value filter condition.
        * no need to load the data block, continue for next block
        */
-      if (!needToLoadDataBlock(pQuery, *pFields, pRuntimeEnv->pCtx, pBlock->numOfPoints)) {
+      if (!needToLoadDataBlock(pRuntimeEnv, pBlock, *pFields)) {
 #if defined(_DEBUG_VIEW)
         dTrace("QInfo:%p fileId:%d, slot:%d, block discarded by per-filter, ", GET_QINFO_ADDR(pQuery), pQuery->fileId,
                pQuery->slot);
@@ -7682,7 +8362,12 @@ int32_t LoadDatablockOnDemand(SCompBlock *pBlock, SField **pFields, uint8_t *blk
 }
 
 bool onDemandLoadDatablock(SQuery *pQuery, int16_t queryRangeSet) {
-  return (pQuery->intervalTime == 0) || ((queryRangeSet == 1) && (isIntervalQuery(pQuery)));
+  /*
+   * before the query range of a meter is set, the first block needs to be loaded in descending order query, since the
+   * query range is decided by the timestamp of the loaded data, see setIntervalQueryRange
+   */
+  return (pQuery->intervalTime == 0) ||
+         (((queryRangeSet == 1) || QUERY_IS_ASC_QUERY(pQuery)) && (isIntervalQuery(pQuery)));
 }
 
 static int32_t getNumOfSubset(STableQuerySupportObj *pSupporter) {
@@ -7926,33 +8611,86 @@ static int32_t resultInterpolate(SQInfo *pQInfo, tFilePage **data, tFilePage **p
   return numOfRes;
 }
 
-static void doCopyQueryResultToMsg(SQInfo *pQInfo, int32_t numOfRows, char *data) {
+static bool isResultColumnCompressible(int16_t type) {
+  // bool columns are mostly NULL flags of aggregates, nothing is saved by compressing them
+  return type > TSDB_DATA_TYPE_BOOL && type <= TSDB_DATA_TYPE_NCHAR;
+}
+
+static int32_t doCopyQueryResultToMsg(SQInfo *pQInfo, int32_t numOfRows, char *data, bool compressed) {
   SMeterObj *pObj = pQInfo->pObj;
   SQuery *   pQuery = &pQInfo->query;
+  char *     start = data;
 
-  int tnumOfRows = vnodeList[pObj->vnode].cfg.rowsInFileBlock;
+  int tnumOfRows = vnodeList[pObj->vnode].cfg.rowsInFileBlock * pQInfo->retrieveWindow;
+
+  // scratch of the codec not kept when float columns are compressed adaptively, shared by all columns
+  char *  buffer = NULL;
+  int32_t bufferSize = 0;
+  if (compressed && tsFloatCompression == TSDB_FLOAT_COMP_ADAPTIVE) {
+    bufferSize = (int32_t)sizeof(double) * numOfRows + EXTRA_BYTES;
+    buffer = malloc((size_t)bufferSize);
+    if (buffer == NULL) bufferSize = 0;
+  }
 
   // for metric query, bufIndex always be 0.
   for (int32_t col = 0; col < pQuery->numOfOutputCols; ++col) {  // pQInfo->bufIndex == 0
     int32_t bytes = pQuery->pSelectExpr[col].resBytes;
+    char *  src = pQuery->sdata[col]->data + bytes * tnumOfRows * pQInfo->bufIndex;
+
+    if (!compressed) {
+      memmove(data, src, bytes * numOfRows);
+      data += bytes * numOfRows;
+      continue;
+    }
+
+    int16_t             type = pQuery->pSelectExpr[col].resType;
+    int32_t             rawLen = bytes * numOfRows;
+    int32_t             len = 0;
+    SRetrieveColumnRsp *pCol = (SRetrieveColumnRsp *)data;
+
+    // the output is bounded by rawLen + EXTRA_BYTES, the same as compressing a file block
+    if (isResultColumnCompressible(type)) {
+      len = (*pCompFunc[type])(src, rawLen, numOfRows, pCol->data, rawLen + EXTRA_BYTES, ONE_STAGE_COMP, buffer,
+                               bufferSize);
+    }
+
+    if (len > 0 && len < rawLen) {
+      pCol->compressed = 1;
+    } else {
+      memcpy(pCol->data, src, rawLen);
+      len = rawLen;
+      pCol->compressed = 0;
+    }
 
-    memmove(data, pQuery->sdata[col]->data + bytes * tnumOfRows * pQInfo->bufIndex, bytes * numOfRows);
-    data += bytes * numOfRows;
+    pCol->type = (int8_t)type;
+    pCol->len = htonl(len);
+    pCol->rawLen = htonl(rawLen);
+    data += sizeof(SRetrieveColumnRsp) + len;
   }
+
+  tfree(buffer);
+  return data - start;
+}
+
+bool vnodeNeedToCompressResult(void *handle, int32_t size) {
+  SQInfo *pQInfo = (SQInfo *)handle;
+  return !isTSCompQuery(&pQInfo->query) && NEEDTO_COMPRESSS_MSG(size);
 }
 
 /**
  * Copy the result data/file to output message buffer.
  * If the result is in file format, read file from disk and copy to output buffer, compression is not involved since
  * data in file is already compressed.
- * In case of other result in buffer, compress the result before copy once the tsComressMsg is set.
+ * In case of other result in buffer, each column is compressed by the codec of its type if compressed is set.
  *
  * @param handle
  * @param data
  * @param numOfRows the number of rows that are not returned in current retrieve
+ * @param compressed compress columns or not
+ * @param size bytes written into data
  * @return
  */
-int32_t vnodeCopyQueryResultToMsg(void *handle, char *data, int32_t numOfRows) {
+int32_t vnodeCopyQueryResultToMsg(void *handle, char *data, int32_t numOfRows, bool compressed, int32_t *size) {
   SQInfo *pQInfo = (SQInfo *)handle;
   SQuery *pQuery = &pQInfo->query;
 
@@ -7977,7 +8715,7 @@ int32_t vnodeCopyQueryResultToMsg(void *handle, char *data, int32_t numOfRows) {
              pQuery->sdata[0]->data, strerror(errno));
     }
   } else {
-    doCopyQueryResultToMsg(pQInfo, numOfRows, data);
+    *size = doCopyQueryResultToMsg(pQInfo, numOfRows, data, compressed);
   }
 
   return numOfRows;
@@ -0,0 +1,345 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _DEFAULT_SOURCE
+#include "os.h"
+
+#include "taoserror.h"
+#include "tscJoinProcess.h"
+#include "ttime.h"
+#include "ttimer.h"
+#include "vnode.h"
+#include "vnodeQueryMem.h"
+#include "vnodeRead.h"
+
+typedef struct SQueryMemWaiter {
+  struct SQueryMemWaiter *next;
+  uint64_t                id;
+  int64_t                 size;
+  int64_t                 queuedTime;
+  tmr_h                   timer;
+  SSchedMsg               schedMsg;
+  SSchedMsg               retrieveMsg;  // retrieve request of the client parked until the query is admitted or rejected
+} SQueryMemWaiter;
+
+typedef struct {
+  pthread_mutex_t  mutex;
+  int64_t          quota;
+  int32_t          waitTime;
+  uint64_t         nextId;
+  SQueryMemWaiter *head;  // queries are admitted in arrival order
+  SQueryMemWaiter *tail;
+  SQueryMemStat    stat;
+} SQueryMemGovernor;
+
+static SQueryMemGovernor *queryMem = NULL;
+
+extern void *queryQhandle;
+
+static bool vnodeQueryMemFits(int64_t size) {
+  // a query larger than the whole budget runs alone rather than never
+  return queryMem->stat.budget <= 0 || queryMem->stat.used == 0 || queryMem->stat.used + size <= queryMem->stat.budget;
+}
+
+static void vnodeReserveQueryMem(SQInfo *pQInfo, int64_t size) {
+  pQInfo->memUsage += size;
+  queryMem->stat.used += size;
+  if (queryMem->stat.used > queryMem->stat.peak) {
+    queryMem->stat.peak = queryMem->stat.used;
+  }
+}
+
+static void vnodeRejectQuery(SQInfo *pQInfo) {
+  pQInfo->code = -TSDB_CODE_QUERY_MEM_EXCEEDED;
+  pQInfo->killed = 1;
+
+  // wake up the retrieve request, the reference count held for the query thread is released here
+  sem_post(&pQInfo->dataReady);
+  vnodeDecRefCount(pQInfo);
+}
+
+static void vnodeProcessQueryMemTimer(void *param, void *tmrId) {
+  uint64_t id = (uint64_t)(uintptr_t)param;
+  if (queryMem == NULL) return;
+
+  pthread_mutex_lock(&queryMem->mutex);
+
+  SQueryMemWaiter *pPrev = NULL;
+  SQueryMemWaiter *pWaiter = queryMem->head;
+  while (pWaiter != NULL && pWaiter->id != id) {
+    pPrev = pWaiter;
+    pWaiter = pWaiter->next;
+  }
+
+  // the query is admitted meanwhile
+  if (pWaiter == NULL) {
+    pthread_mutex_unlock(&queryMem->mutex);
+    return;
+  }
+
+  if (pPrev == NULL) {
+    queryMem->head = pWaiter->next;
+  } else {
+    pPrev->next = pWaiter->next;
+  }
+
+  if (queryMem->tail == pWaiter) {
+    queryMem->tail = pPrev;
+  }
+
+  queryMem->stat.queued--;
+  queryMem->stat.rejected++;
+  pthread_mutex_unlock(&queryMem->mutex);
+
+  SQInfo *pQInfo = (SQInfo *)pWaiter->schedMsg.ahandle;
+  dWarn("QInfo:%p waits for query memory more than %d ms, size:%" PRId64 " bytes, rejected", pQInfo,
+        queryMem->waitTime, pWaiter->size);
+
+  vnodeRejectQuery(pQInfo);
+  if (pWaiter->retrieveMsg.fp != NULL) {
+    taosScheduleTask(queryQhandle, &pWaiter->retrieveMsg);
+  }
+
+  free(pWaiter);
+}
+
+int32_t vnodeInitQueryMemGovernor(int64_t budget, int64_t quota, int32_t waitTime) {
+  queryMem = calloc(1, sizeof(SQueryMemGovernor));
+  if (queryMem == NULL) {
+    dError("failed to allocate query memory governor, reason:%s", strerror(errno));
+    return -1;
+  }
+
+  pthread_mutex_init(&queryMem->mutex, NULL);
+  queryMem->stat.budget = budget;
+  queryMem->quota = quota;
+  queryMem->waitTime = waitTime;
+
+  dPrint("query memory governor is initialized, budget:%" PRId64 " quota:%" PRId64 " bytes, wait:%d ms", budget,
+         quota, waitTime);
+  return 0;
+}
+
+void vnodeCleanUpQueryMemGovernor() {
+  if (queryMem == NULL) return;
+
+  SQueryMemWaiter *pWaiter = queryMem->head;
+  while (pWaiter != NULL) {
+    SQueryMemWaiter *pNext = pWaiter->next;
+    taosTmrStopA(&pWaiter->timer);
+    tfree(pWaiter->retrieveMsg.msg);
+    free(pWaiter);
+    pWaiter = pNext;
+  }
+
+  pthread_mutex_destroy(&queryMem->mutex);
+  tfree(queryMem);
+}
+
+void vnodeScheduleQuery(void *handle, SSchedMsg *pMsg) {
+  SQInfo *pQInfo = (SQInfo *)handle;
+  if (queryMem == NULL) {
+    taosScheduleTask(queryQhandle, pMsg);
+    return;
+  }
+
+  int64_t size = vnodeEstimateQueryMem(pQInfo);
+
+  if (queryMem->quota > 0 && size > queryMem->quota) {
+    dError("QInfo:%p estimated memory %" PRId64 " bytes exceeds quota:%" PRId64 ", rejected", pQInfo, size,
+           queryMem->quota);
+    pthread_mutex_lock(&queryMem->mutex);
+    queryMem->stat.rejected++;
+    pthread_mutex_unlock(&queryMem->mutex);
+
+    vnodeRejectQuery(pQInfo);
+    return;
+  }
+
+  pthread_mutex_lock(&queryMem->mutex);
+
+  if (queryMem->head == NULL && vnodeQueryMemFits(size)) {
+    vnodeReserveQueryMem(pQInfo, size);
+    queryMem->stat.admitted++;
+    pthread_mutex_unlock(&queryMem->mutex);
+
+    taosScheduleTask(queryQhandle, pMsg);
+    return;
+  }
+
+  SQueryMemWaiter *pWaiter = calloc(1, sizeof(SQueryMemWaiter));
+  if (pWaiter == NULL) {
+    pthread_mutex_unlock(&queryMem->mutex);
+    vnodeRejectQuery(pQInfo);
+    return;
+  }
+
+  pWaiter->id = ++queryMem->nextId;
+  pWaiter->size = size;
+  pWaiter->queuedTime = taosGetTimestampMs();
+  pWaiter->schedMsg = *pMsg;
+
+  if (queryMem->tail == NULL) {
+    queryMem->head = pWaiter;
+  } else {
+    queryMem->tail->next = pWaiter;
+  }
+
+  queryMem->tail = pWaiter;
+  queryMem->stat.queued++;
+  pWaiter->timer = taosTmrStart(vnodeProcessQueryMemTimer, queryMem->waitTime, (void *)(uintptr_t)pWaiter->id,
+                                vnodeTmrCtrl);
+
+  dTrace("QInfo:%p wait for query memory, size:%" PRId64 " used:%" PRId64 " budget:%" PRId64 " queued:%d", pQInfo,
+         size, queryMem->stat.used, queryMem->stat.budget, queryMem->stat.queued);
+  pthread_mutex_unlock(&queryMem->mutex);
+}
+
+void vnodeChargeQueryMem(void *handle, int64_t bytes) {
+  SQInfo *pQInfo = (SQInfo *)handle;
+  SQInfo *pRoot = (pQInfo->pParent != NULL) ? pQInfo->pParent : pQInfo;
+  if (queryMem == NULL || bytes <= 0) return;
+
+  pthread_mutex_lock(&queryMem->mutex);
+
+  if (pQInfo != pRoot) {
+    pQInfo->memUsage += bytes;
+  }
+
+  vnodeReserveQueryMem(pRoot, bytes);
+  int64_t usage = pRoot->memUsage;
+
+  pthread_mutex_unlock(&queryMem->mutex);
+
+  if (queryMem->quota > 0 && usage > queryMem->quota && pRoot->killed == 0) {
+    dError("QInfo:%p memory usage %" PRId64 " bytes exceeds quota:%" PRId64 ", killed", pRoot, usage,
+           queryMem->quota);
+    pRoot->code = -TSDB_CODE_QUERY_MEM_EXCEEDED;
+    pRoot->killed = 1;
+  }
+}
+
+// admit the queued queries that fit in the budget in arrival order, the mutex shall be held
+static SQueryMemWaiter *vnodeAdmitQueuedQueries() {
+  SQueryMemWaiter *pAdmitted = NULL;
+  SQueryMemWaiter *pLast = NULL;
+
+  while (queryMem->head != NULL && vnodeQueryMemFits(queryMem->head->size)) {
+    SQueryMemWaiter *pWaiter = queryMem->head;
+    queryMem->head = pWaiter->next;
+    if (queryMem->head == NULL) {
+      queryMem->tail = NULL;
+    }
+
+    vnodeReserveQueryMem((SQInfo *)pWaiter->schedMsg.ahandle, pWaiter->size);
+    queryMem->stat.queued--;
+    queryMem->stat.admitted++;
+
+    pWaiter->next = NULL;
+    if (pLast == NULL) {
+      pAdmitted = pWaiter;
+    } else {
+      pLast->next = pWaiter;
+    }
+    pLast = pWaiter;
+  }
+
+  return pAdmitted;
+}
+
+static void vnodeScheduleAdmittedQueries(SQueryMemWaiter *pAdmitted) {
+  while (pAdmitted != NULL) {
+    SQueryMemWaiter *pNext = pAdmitted->next;
+    taosTmrStopA(&pAdmitted->timer);
+
+    dTrace("QInfo:%p query memory is reserved after waiting %" PRId64 " ms, size:%" PRId64, pAdmitted->schedMsg.ahandle,
+           taosGetTimestampMs() - pAdmitted->queuedTime, pAdmitted->size);
+    taosScheduleTask(queryQhandle, &pAdmitted->schedMsg);
+    if (pAdmitted->retrieveMsg.fp != NULL) {
+      taosScheduleTask(queryQhandle, &pAdmitted->retrieveMsg);
+    }
+
+    free(pAdmitted);
+    pAdmitted = pNext;
+  }
+}
+
+void vnodeReleaseQueryMem(void *handle) {
+  SQInfo *pQInfo = (SQInfo *)handle;
+
+  if (queryMem == NULL) return;
+
+  pthread_mutex_lock(&queryMem->mutex);
+
+  queryMem->stat.used -= pQInfo->memUsage;
+  if (pQInfo->pParent != NULL) {
+    pQInfo->pParent->memUsage -= pQInfo->memUsage;
+  }
+
+  pQInfo->memUsage = 0;
+
+  SQueryMemWaiter *pAdmitted = vnodeAdmitQueuedQueries();
+  pthread_mutex_unlock(&queryMem->mutex);
+
+  vnodeScheduleAdmittedQueries(pAdmitted);
+}
+
+bool vnodeParkQueryRetrieve(void *handle, SSchedMsg *pMsg) {
+  if (queryMem == NULL || handle == NULL) return false;
+
+  bool parked = false;
+  pthread_mutex_lock(&queryMem->mutex);
+
+  // the handle is compared only, it may be stale
+  for (SQueryMemWaiter *pWaiter = queryMem->head; pWaiter != NULL; pWaiter = pWaiter->next) {
+    if (pWaiter->schedMsg.ahandle == handle) {
+      if (pWaiter->retrieveMsg.fp == NULL) {
+        pWaiter->retrieveMsg = *pMsg;
+        parked = true;
+      }
+      break;
+    }
+  }
+
+  pthread_mutex_unlock(&queryMem->mutex);
+
+  if (parked) {
+    dTrace("QInfo:%p waits for query memory, retrieve request is parked", handle);
+  }
+  return parked;
+}
+
+bool vnodeQueryMemIsTight() {
+  if (queryMem == NULL || queryMem->stat.budget <= 0) return false;
+  return queryMem->stat.used * 5 > queryMem->stat.budget * 4;
+}
+
+void vnodeCountSpilledQueryMem(void *handle, int64_t bytes) {
+  if (queryMem == NULL || bytes <= 0) return;
+
+  pthread_mutex_lock(&queryMem->mutex);
+  queryMem->stat.spills++;
+  queryMem->stat.spilledBytes += bytes;
+  pthread_mutex_unlock(&queryMem->mutex);
+}
+
+void vnodeGetQueryMemStat(SQueryMemStat *pStat) {
+  memset(pStat, 0, sizeof(SQueryMemStat));
+  if (queryMem == NULL) return;
+
+  pthread_mutex_lock(&queryMem->mutex);
+  *pStat = queryMem->stat;
+  pthread_mutex_unlock(&queryMem->mutex);
+}
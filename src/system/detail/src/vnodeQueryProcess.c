@@ -21,6 +21,7 @@
 #include "tscJoinProcess.h"
 #include "ttime.h"
 #include "vnode.h"
+#include "vnodeBlockRead.h"
 #include "vnodeRead.h"
 #include "vnodeUtil.h"
 
@@ -32,6 +33,10 @@
 
 #define FORWARD_CACHE_BLOCK_CHECK_SLOT(slot, step, maxblocks) (slot) = ((slot) + (step) + (maxblocks)) % (maxblocks);
 
+// a super table query is split into tasks of at least this number of meters
+#define STABLE_SCAN_TASK_MIN_METERS 8
+#define STABLE_SCAN_TASKS_PER_THREAD 4
+
 static bool isGroupbyEachTable(SSqlGroupbyExpr *pGroupbyExpr, tSidSet *pSidset) {
   if (pGroupbyExpr == NULL || pGroupbyExpr->numOfGroupCols == 0) {
     return false;
@@ -102,8 +107,8 @@ static void queryOnMultiDataCache(SQInfo *pQInfo, SMeterDataInfo *pMeterDataInfo
   int32_t totalBlocks = 0;
 
   for (int32_t groupIdx = 0; groupIdx < pSupporter->pSidSet->numOfSubSet; ++groupIdx) {
-    int32_t start = pSupporter->pSidSet->starterPos[groupIdx];
-    int32_t end = pSupporter->pSidSet->starterPos[groupIdx + 1] - 1;
+    int32_t start = MAX(pSupporter->pSidSet->starterPos[groupIdx], pSupporter->meterStart);
+    int32_t end = MIN(pSupporter->pSidSet->starterPos[groupIdx + 1], pSupporter->meterEnd) - 1;
 
     if (isQueryKilled(pQuery)) {
       return;
@@ -253,6 +258,91 @@ static void queryOnMultiDataCache(SQInfo *pQInfo, SMeterDataInfo *pMeterDataInfo
   setQueryStatus(pQuery, QUERY_NOT_COMPLETED);
 }
 
+/*
+ * Issue reads of the blocks to be checked in current file ahead of the scan. Requests are listed in the order of
+ * the scan, and the reader issues each batch in file offset order. Nothing is read for a block answered by its time
+ * range, only the fields for a block answered by its pre-aggregated values, and otherwise the fields and then the
+ * columns that are loaded, see vnodeGetBlockReadRanges.
+ */
+static void openQueryBlockReader(SQInfo *pQInfo, SMeterDataBlockInfoEx *pDataBlockInfoEx, int32_t numOfBlocks) {
+  SQuery *               pQuery = &pQInfo->query;
+  STableQuerySupportObj *pSupporter = pQInfo->pTableQuerySupporter;
+  SQueryRuntimeEnv *     pRuntimeEnv = &pSupporter->runtimeEnv;
+  SQueryFilesInfo *      pVnodeFileInfo = &pRuntimeEnv->vnodeFileInfo;
+
+  if (tsAsyncRead == TSDB_BLOCK_READ_SYNC || tsReadAheadBlocks <= 0) {
+    return;
+  }
+
+  SBlockReadReq *      pReqs = malloc(sizeof(SBlockReadReq) * numOfBlocks);
+  SQueryBlockReadPlan *pPlan = calloc(1, sizeof(SQueryBlockReadPlan));
+  if (pReqs == NULL || pPlan == NULL) {
+    tfree(pReqs);
+    tfree(pPlan);
+    return;
+  }
+
+  pPlan->pQuery = pQuery;
+  pPlan->vnode = pVnodeFileInfo->vnodeId;
+  pPlan->fileId = pVnodeFileInfo->pFileInfo[pVnodeFileInfo->current].fileID;
+  pPlan->version = pVnodeFileInfo->dataVersion;
+  pPlan->pBlocks = malloc(sizeof(SCompBlock *) * numOfBlocks);
+  pPlan->inRange = malloc(sizeof(int8_t) * numOfBlocks);
+  pPlan->loadColumns = malloc(sizeof(int8_t) * numOfBlocks);
+  pVnodeFileInfo->pBlockReadPlan = pPlan;
+
+  if (pPlan->pBlocks == NULL || pPlan->inRange == NULL || pPlan->loadColumns == NULL) {
+    free(pReqs);
+    return;
+  }
+
+  int32_t numOfReads = 0;
+  for (int32_t i = 0; i < numOfBlocks; ++i) {
+    int32_t                j = QUERY_IS_ASC_QUERY(pQuery) ? i : numOfBlocks - 1 - i;
+    SMeterDataBlockInfoEx *pInfoEx = &pDataBlockInfoEx[j];
+    SCompBlock *           pBlock = pInfoEx->pBlock.compBlock;
+
+    bool inRange = QUERY_IS_ASC_QUERY(pQuery)
+                       ? (pBlock->keyFirst >= pSupporter->rawSKey && pBlock->keyLast <= pSupporter->rawEKey)
+                       : (pBlock->keyFirst >= pSupporter->rawEKey && pBlock->keyLast <= pSupporter->rawSKey);
+    uint32_t req = BLK_DATA_ALL_NEEDED;
+    if (inRange && onDemandLoadDatablock(pQuery, pInfoEx->pMeterDataInfo->pMeterQInfo->queryRangeSet)) {
+      req = vnodeGetFileBlockDataReq(pRuntimeEnv, pBlock);
+    }
+
+    pPlan->pBlocks[i] = pBlock;
+    pPlan->inRange[i] = inRange;
+    pPlan->loadColumns[i] = (req == BLK_DATA_ALL_NEEDED);
+
+    pReqs[i].fd = pBlock->last ? pVnodeFileInfo->lastFd : pVnodeFileInfo->dataFd;
+    pReqs[i].offset = pBlock->offset;
+    pReqs[i].len = (req == BLK_DATA_NO_NEEDED) ? 0 : sizeof(SField) * pBlock->numOfCols + sizeof(TSCKSUM);
+    numOfReads += (req == BLK_DATA_NO_NEEDED) ? 0 : 1;
+  }
+
+  if (numOfReads > 0) {
+    pVnodeFileInfo->pBlockReader = vnodeOpenBlockReader(pReqs, numOfBlocks, tsReadAheadBlocks, tsAsyncRead,
+                                                        vnodeGetBlockReadRanges, pPlan);
+  }
+  free(pReqs);
+
+  dTrace("QInfo:%p %d of %d blocks are read ahead, mode:%d", pQInfo, numOfReads, numOfBlocks,
+         vnodeGetBlockReadMode(pVnodeFileInfo->pBlockReader));
+}
+
+static void closeQueryBlockReader(SQueryFilesInfo *pVnodeFileInfo) {
+  vnodeCloseBlockReader(pVnodeFileInfo->pBlockReader);
+  pVnodeFileInfo->pBlockReader = NULL;
+
+  SQueryBlockReadPlan *pPlan = (SQueryBlockReadPlan *)pVnodeFileInfo->pBlockReadPlan;
+  if (pPlan != NULL) {
+    tfree(pPlan->pBlocks);
+    tfree(pPlan->inRange);
+    tfree(pPlan->loadColumns);
+    tfree(pVnodeFileInfo->pBlockReadPlan);
+  }
+}
+
 static void queryOnMultiDataFiles(SQInfo *pQInfo, SMeterDataInfo *pMeterDataInfo) {
   SQuery *               pQuery = &pQInfo->query;
   STableQuerySupportObj *pSupporter = pQInfo->pTableQuerySupporter;
@@ -353,6 +443,8 @@ static void queryOnMultiDataFiles(SQInfo *pQInfo, SMeterDataInfo *pMeterDataInfo
     }
 
     dTrace("QInfo:%p start to load %d blocks and check", pQInfo, numOfBlocks);
+    openQueryBlockReader(pQInfo, pDataBlockInfoEx, numOfBlocks);
+
     int64_t TRACE_OUTPUT_BLOCK_CNT = 10000;
     int64_t stimeUnit = 0;
     int64_t etimeUnit = 0;
@@ -397,6 +489,11 @@ static void queryOnMultiDataFiles(SQInfo *pQInfo, SMeterDataInfo *pMeterDataInfo
         continue;
       }
 
+      // if the read ahead failed, the block is read again synchronously
+      if (pVnodeFileInfo->pBlockReader != NULL) {
+        vnodeAcquireBlockRead(pVnodeFileInfo->pBlockReader, QUERY_IS_ASC_QUERY(pQuery) ? j : numOfBlocks - 1 - j);
+      }
+
       SCompBlock *pBlock = pInfoEx->pBlock.compBlock;
       bool        ondemandLoad = onDemandLoadDatablock(pQuery, pMeterQueryInfo->queryRangeSet);
       ret = LoadDatablockOnDemand(pBlock, &pInfoEx->pBlock.fields, &pRuntimeEnv->blockStatus, pRuntimeEnv, fileIdx,
@@ -434,6 +531,7 @@ static void queryOnMultiDataFiles(SQInfo *pQInfo, SMeterDataInfo *pMeterDataInfo
         setIntervalQueryRange(pMeterQueryInfo, pSupporter, nextKey);
         ret = setAdditionalInfo(pSupporter, pOneMeterDataInfo->meterOrderIdx, pMeterQueryInfo);
         if (ret != TSDB_CODE_SUCCESS) {
+          closeQueryBlockReader(pVnodeFileInfo);
           tfree(pReqMeterDataInfo);  // error code has been set
           pQInfo->killed = 1;
           return;
@@ -443,6 +541,7 @@ static void queryOnMultiDataFiles(SQInfo *pQInfo, SMeterDataInfo *pMeterDataInfo
       stableApplyFunctionsOnBlock(pSupporter, pOneMeterDataInfo, &binfo, pInfoEx->pBlock.fields, searchFn);
     }
 
+    closeQueryBlockReader(pVnodeFileInfo);
     tfree(pReqMeterDataInfo);
 
     // try next file
@@ -900,6 +999,148 @@ static void doMultiMeterSupplementaryScan(SQInfo *pQInfo) {
   SET_MASTER_SCAN_FLAG(pRuntimeEnv);
 }
 
+static int32_t getNumOfSTableScanTasks(SQInfo *pQInfo) {
+  SQuery *               pQuery = &pQInfo->query;
+  STableQuerySupportObj *pSupporter = pQInfo->pTableQuerySupporter;
+
+  /*
+   * only the query with one fixed output row in each group, of which the intermediate results of different tables
+   * can be merged in any order, is split into tasks
+   */
+  if (tsQueryParallelism <= 1 || pQuery->intervalTime > 0 || isSumAvgRateQuery(pQuery) ||
+      isGroupbyNormalCol(pQuery->pGroupbyExpr) || isPointInterpoQuery(pQuery) ||
+      pSupporter->runtimeEnv.pTSBuf != NULL) {
+    return 1;
+  }
+
+  for (int32_t i = 0; i < pQuery->numOfOutputCols; ++i) {
+    int32_t functionId = pQuery->pSelectExpr[i].pBase.functionId;
+    if (functionId != TSDB_FUNC_COUNT && functionId != TSDB_FUNC_SUM && functionId != TSDB_FUNC_AVG &&
+        functionId != TSDB_FUNC_MIN && functionId != TSDB_FUNC_MAX && functionId != TSDB_FUNC_SPREAD &&
+        functionId != TSDB_FUNC_FIRST_DST && functionId != TSDB_FUNC_LAST_DST && functionId != TSDB_FUNC_TAG &&
+        functionId != TSDB_FUNC_TAG_DUMMY) {
+      return 1;
+    }
+  }
+
+  // more tasks than threads, so that a thread with less data to scan claims more tasks
+  int32_t numOfTasks = pSupporter->numOfMeters / STABLE_SCAN_TASK_MIN_METERS;
+  return MIN(numOfTasks, tsQueryParallelism * STABLE_SCAN_TASKS_PER_THREAD);
+}
+
+static void doSTableScanTasks(SQInfo *pQInfo) {
+  STableQuerySupportObj *pSupporter = pQInfo->pTableQuerySupporter;
+  SSTableScanTasks *     pTasks = pSupporter->pScanTasks;
+
+  while (1) {
+    int32_t index = atomic_fetch_add_32(&pTasks->nextTask, 1);
+    if (index >= pTasks->numOfTasks) {
+      break;
+    }
+
+    int32_t meterStart = (int32_t)((int64_t)pSupporter->numOfMeters * index / pTasks->numOfTasks);
+    int32_t meterEnd = (int32_t)((int64_t)pSupporter->numOfMeters * (index + 1) / pTasks->numOfTasks);
+    int32_t code = TSDB_CODE_SUCCESS;
+    SQInfo *pTask = NULL;
+
+    if (!isQueryKilled(&pQInfo->query)) {
+      pTask = vnodeCreateSTableScanTask(pQInfo, meterStart, meterEnd);
+      if (pTask == NULL) {
+        code = -TSDB_CODE_SERV_OUT_OF_MEMORY;
+      }
+    }
+
+    if (pTask != NULL) {
+      int64_t st = taosGetTimestampMs();
+
+      doOrderedScan(pTask);
+      closeAllTimeWindow(&pTask->pTableQuerySupporter->runtimeEnv.windowResInfo);
+
+      if (pTask->code == TSDB_CODE_SUCCESS && !isQueryKilled(&pTask->query)) {
+        doMultiMeterSupplementaryScan(pTask);
+      }
+
+      dTrace("QInfo:%p scan task:%d, meters:%d-%d completed, elapsed time:%" PRId64 "ms", pQInfo, index, meterStart,
+             meterEnd, taosGetTimestampMs() - st);
+    }
+
+    pthread_mutex_lock(&pTasks->mutex);
+
+    if (pTask != NULL) {
+      if (pTask->code != TSDB_CODE_SUCCESS) {
+        code = pTask->code;
+      } else if (!isQueryKilled(&pTask->query)) {
+        int32_t ret = vnodeMergeSTableScanTask(pQInfo, pTask);
+        if (ret != TSDB_CODE_SUCCESS) {
+          code = -ret;
+        }
+      }
+    }
+
+    if (code != TSDB_CODE_SUCCESS) {
+      pQInfo->code = code;
+      pQInfo->killed = 1;
+    }
+
+    pTasks->numOfCompleted += 1;
+    pthread_cond_signal(&pTasks->cond);
+    pthread_mutex_unlock(&pTasks->mutex);
+
+    vnodeFreeSTableScanTask(pTask);
+  }
+}
+
+static void vnodeSTableScanTaskProcessor(SSchedMsg *pMsg) {
+  SQInfo *pQInfo = (SQInfo *)pMsg->ahandle;
+
+  doSTableScanTasks(pQInfo);
+  vnodeDecRefCount(pQInfo);
+}
+
+/*
+ * The query thread scans tasks together with the helper threads and waits for the tasks claimed by helpers. A helper
+ * that is scheduled after all tasks are claimed returns immediately, so the query never waits for the query queue.
+ */
+static void doParallelSTableScan(SQInfo *pQInfo, int32_t numOfTasks) {
+  STableQuerySupportObj *pSupporter = pQInfo->pTableQuerySupporter;
+
+  SSTableScanTasks *pTasks = calloc(1, sizeof(SSTableScanTasks));
+  if (pTasks == NULL) {
+    dError("QInfo:%p failed to allocate memory, %s", pQInfo, strerror(errno));
+    pQInfo->code = -TSDB_CODE_SERV_OUT_OF_MEMORY;
+    pQInfo->killed = 1;
+    return;
+  }
+
+  pthread_mutex_init(&pTasks->mutex, NULL);
+  pthread_cond_init(&pTasks->cond, NULL);
+  pTasks->numOfTasks = numOfTasks;
+  pSupporter->pScanTasks = pTasks;
+
+  int32_t numOfHelpers = MIN(tsQueryParallelism, numOfTasks) - 1;
+  dTrace("QInfo:%p %d meters are scanned in %d tasks by %d threads", pQInfo, pSupporter->numOfMeters, numOfTasks,
+         numOfHelpers + 1);
+
+  for (int32_t i = 0; i < numOfHelpers; ++i) {
+    vnodeAddRefCount(pQInfo);
+
+    SSchedMsg schedMsg = {0};
+    schedMsg.msg = NULL;
+    schedMsg.thandle = (void *)1;
+    schedMsg.ahandle = pQInfo;
+    schedMsg.fp = vnodeSTableScanTaskProcessor;
+    taosScheduleTask(queryQhandle, &schedMsg);
+  }
+
+  doSTableScanTasks(pQInfo);
+
+  pthread_mutex_lock(&pTasks->mutex);
+  while (pTasks->numOfCompleted < pTasks->numOfTasks) {
+    pthread_cond_wait(&pTasks->cond, &pTasks->mutex);
+  }
+  pthread_mutex_unlock(&pTasks->mutex);
+}
+
 static void vnodeMultiMeterQueryProcessor(SQInfo *pQInfo) {
   STableQuerySupportObj *pSupporter = pQInfo->pTableQuerySupporter;
   SQueryRuntimeEnv *     pRuntimeEnv = &pSupporter->runtimeEnv;
@@ -941,23 +1182,35 @@ static void vnodeMultiMeterQueryProcessor(SQInfo *pQInfo) {
   dTrace("QInfo:%p query start, qrange:%" PRId64 "-%" PRId64 ", order:%d, group:%d", pQInfo, pSupporter->rawSKey,
          pSupporter->rawEKey, pQuery->order.order, pSupporter->pSidSet->numOfSubSet);
 
-  dTrace("QInfo:%p main query scan start", pQInfo);
-  int64_t st = taosGetTimestampMs();
-  doOrderedScan(pQInfo);
-  int64_t et = taosGetTimestampMs();
-  dTrace("QInfo:%p main scan completed, elapsed time: %lldms, supplementary scan start, order:%d", pQInfo, et - st,
-         pQuery->order.order ^ 1u);
+  int32_t numOfTasks = getNumOfSTableScanTasks(pQInfo);
+
+  if (numOfTasks > 1) {
+    dTrace("QInfo:%p parallel scan start", pQInfo);
+    int64_t st = taosGetTimestampMs();
+    doParallelSTableScan(pQInfo, numOfTasks);
+    int64_t et = taosGetTimestampMs();
+    dTrace("QInfo:%p parallel scan completed, elapsed time: %lldms", pQInfo, et - st);
 
-  if (pQuery->intervalTime > 0) {
-    for (int32_t i = 0; i < pSupporter->numOfMeters; ++i) {
-      SMeterQueryInfo *pMeterQueryInfo = pSupporter->pMeterDataInfo[i].pMeterQInfo;
-      closeAllTimeWindow(&pMeterQueryInfo->windowResInfo);
-    }
-  } else {  // close results for group result
     closeAllTimeWindow(&pRuntimeEnv->windowResInfo);
-  }
+  } else {
+    dTrace("QInfo:%p main query scan start", pQInfo);
+    int64_t st = taosGetTimestampMs();
+    doOrderedScan(pQInfo);
+    int64_t et = taosGetTimestampMs();
+    dTrace("QInfo:%p main scan completed, elapsed time: %lldms, supplementary scan start, order:%d", pQInfo, et - st,
+           pQuery->order.order ^ 1u);
+
+    if (pQuery->intervalTime > 0) {
+      for (int32_t i = 0; i < pSupporter->numOfMeters; ++i) {
+        SMeterQueryInfo *pMeterQueryInfo = pSupporter->pMeterDataInfo[i].pMeterQInfo;
+        closeAllTimeWindow(&pMeterQueryInfo->windowResInfo);
+      }
+    } else {  // close results for group result
+      closeAllTimeWindow(&pRuntimeEnv->windowResInfo);
+    }
 
-  doMultiMeterSupplementaryScan(pQInfo);
+    doMultiMeterSupplementaryScan(pQInfo);
+  }
 
   if (isQueryKilled(pQuery)) {
     dTrace("QInfo:%p query killed, abort", pQInfo);
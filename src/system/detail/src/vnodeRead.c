@@ -23,11 +23,15 @@
 #include "tscJoinProcess.h"
 #include "tscompression.h"
 #include "vnode.h"
+#include "vnodeQueryMem.h"
 #include "vnodeRead.h"
 #include "vnodeUtil.h"
 #include "hash.h"
 #include "hashutil.h"
 
+// bytes of each half of the result buffer of projection queries, which limits the granted retrieve window
+#define RETRIEVE_BUF_MAX_SIZE (4 * 1024 * 1024L)
+
 int (*pQueryFunc[])(SMeterObj *, SQuery *) = {vnodeQueryFromCache, vnodeQueryFromFile};
 
 int vnodeInterpolationSearchKey(char *pValue, int num, TSKEY key, int order) {
@@ -172,6 +176,8 @@ static SQInfo *vnodeAllocateQInfoCommon(SQueryMeterMsg *pQueryMsg, SMeterObj *pM
   pQuery->order.order = pQueryMsg->order;
   pQuery->order.orderColId = pQueryMsg->orderColId;
 
+  pQInfo->retrieveWindow = 1;
+
   pQuery->colList = calloc(1, sizeof(SSingleColumnFilterInfo) * numOfCols);
   if (pQuery->colList == NULL) {
     goto _clean_memory;
@@ -329,6 +335,19 @@ sign_clean_memory:
   return NULL;
 }
 
+/*
+ * the window is the number of file blocks of results returned in one retrieve. The client asks for a window, the
+ * server grants at most its own retrieveWindow and keeps each half of the result buffer within RETRIEVE_BUF_MAX_SIZE
+ */
+static int32_t vnodeGetRetrieveWindow(int32_t window, SMeterObj *pObj, int32_t rowSize) {
+  if (window > tsRetrieveWindow) window = tsRetrieveWindow;
+
+  int64_t blockSize = (int64_t)vnodeList[pObj->vnode].cfg.rowsInFileBlock * rowSize;
+  if (blockSize > 0 && blockSize * window > RETRIEVE_BUF_MAX_SIZE) window = (int32_t)(RETRIEVE_BUF_MAX_SIZE / blockSize);
+
+  return (window < 1) ? 1 : window;
+}
+
 SQInfo *vnodeAllocateQInfo(SQueryMeterMsg *pQueryMsg, SMeterObj *pObj, SSqlFunctionExpr *pExprs) {
   SQInfo *pQInfo = vnodeAllocateQInfoCommon(pQueryMsg, pObj, pExprs);
   if (pQInfo == NULL) {
@@ -343,8 +362,11 @@ SQInfo *vnodeAllocateQInfo(SQueryMeterMsg *pQueryMsg, SMeterObj *pObj, SSqlFunct
     goto __clean_memory;
   }
 
+  pQInfo->retrieveWindow = vnodeGetRetrieveWindow(pQueryMsg->retrieveWindow, pObj, pQuery->rowSize);
+
   size_t  size = 0;
-  int32_t numOfRows = vnodeList[pObj->vnode].cfg.rowsInFileBlock;
+  int32_t pointsPerBlock = vnodeList[pObj->vnode].cfg.rowsInFileBlock;
+  int32_t numOfRows = pointsPerBlock * pQInfo->retrieveWindow;
   for (int col = 0; col < pQuery->numOfOutputCols; ++col) {
     size = 2 * (numOfRows * pQuery->pSelectExpr[col].resBytes + sizeof(SData));
     pQuery->sdata[col] = (SData *)malloc(size);
@@ -354,7 +376,8 @@ SQInfo *vnodeAllocateQInfo(SQueryMeterMsg *pQueryMsg, SMeterObj *pObj, SSqlFunct
   }
 
   if (pQuery->colList[0].data.colId != PRIMARYKEY_TIMESTAMP_COL_INDEX) {
-    size = 2 * (numOfRows * TSDB_KEYSIZE + sizeof(SData));
+    // timestamps of a whole block are loaded after the rows filled in buffer, which may be at the end of buffer
+    size = 2 * (numOfRows * TSDB_KEYSIZE + sizeof(SData)) + pointsPerBlock * TSDB_KEYSIZE;
     pQuery->tsData = (SData *)malloc(size);
     if (pQuery->tsData == NULL) {
       goto __clean_memory;
@@ -439,6 +462,7 @@ void vnodeFreeQInfo(void *param, bool decQueryRef) {
 
   sem_destroy(&(pQInfo->dataReady));
   vnodeQueryFreeQInfoEx(pQInfo);
+  vnodeReleaseQueryMem(pQInfo);
 
   for (int32_t i = 0; i < pQuery->numOfFilterCols; ++i) {
     SSingleColumnFilterInfo *pColFilter = &pQuery->pFilterInfo[i];
@@ -535,34 +559,40 @@ void vnodeQueryData(SSchedMsg *pMsg) {
   dTrace("QInfo:%p vid:%d sid:%d id:%s, query thread is created, numOfQueries:%d, func:%s", pQInfo, pObj->vnode,
          pObj->sid, pObj->meterId, pObj->numOfQueries, __FUNCTION__);
 
-  pQuery->pointsToRead = vnodeList[pObj->vnode].cfg.rowsInFileBlock;
-  pQuery->pointsOffset = pQInfo->bufIndex * pQuery->pointsToRead;
+  // the rows of a window of blocks are produced while the client is receiving the previous window
+  int32_t bufRows = vnodeList[pObj->vnode].cfg.rowsInFileBlock * pQInfo->retrieveWindow;
+  int32_t numOfRows = 0;
 
   int64_t st = taosGetTimestampUs();
 
   while (1) {
-    int64_t potentNumOfRes = pQInfo->pointsRead + pQuery->pointsToRead;
+    pQuery->pointsToRead = bufRows - numOfRows;
+    pQuery->pointsOffset = pQInfo->bufIndex * bufRows + numOfRows;
+
+    int64_t potentNumOfRes = pQInfo->pointsRead + numOfRows + pQuery->pointsToRead;
     /* limit the potential overflow data */
     if (pQuery->limit.limit > 0 && potentNumOfRes > pQuery->limit.limit) {
-      pQuery->pointsToRead = pQuery->limit.limit - pQInfo->pointsRead;
+      pQuery->pointsToRead = pQuery->limit.limit - pQInfo->pointsRead - numOfRows;
 
       if (pQuery->pointsToRead == 0) {
-        /* reach the limitation, abort */
-        pQuery->pointsRead = 0;
-        pQInfo->over = 1;
+        /* reach the limitation, abort after the rows in buffer are returned */
+        if (numOfRows == 0) pQInfo->over = 1;
         break;
       }
     }
 
     pQInfo->code = (*pQInfo->fp)(pObj, pQuery);  // <0:error
+    if (pQInfo->code < 0) break;
 
-    // has read at least one point
-    if (pQuery->pointsRead > 0 || pQInfo->code < 0) break;
+    // the buffer is full
+    numOfRows += pQuery->pointsRead;
+    if (numOfRows >= bufRows) break;
 
-    if (pQuery->pointsRead == 0 && pQuery->over == 0) continue;
+    if (pQuery->over == 0) continue;
 
+    // no round is scheduled after the query is over, so rows read in this round are returned before it is over
     if (pQInfo->changed) {
-      pQInfo->over = 1;
+      if (numOfRows == 0) pQInfo->over = 1;
       break;
     }
 
@@ -577,6 +607,7 @@ void vnodeQueryData(SSchedMsg *pMsg) {
            pObj->meterId, pQuery->order.order, pQuery->skey, pQuery);
   }
 
+  pQuery->pointsRead = numOfRows;
   pQInfo->pointsRead += pQuery->pointsRead;
 
   dTrace("vid:%d sid:%d id:%s, %d points returned, totalRead:%d totalReturn:%d last key:%" PRId64 ", query:%p", pObj->vnode,
@@ -709,7 +740,7 @@ void *vnodeQueryOnSingleTable(SMeterObj **pMetersObj, SSqlGroupbyExpr *pGroupbyE
   dTrace("QInfo:%p set query flag and prepare runtime environment completed, ref:%d, wait for schedule", pQInfo,
       pQInfo->refCount);
   
-  taosScheduleTask(queryQhandle, &schedMsg);
+  vnodeScheduleQuery(pQInfo, &schedMsg);
   return pQInfo;
 
 _error:
@@ -825,7 +856,7 @@ void *vnodeQueryOnMultiMeters(SMeterObj **pMetersObj, SSqlGroupbyExpr *pGroupbyE
 
   dTrace("QInfo:%p set query flag and prepare runtime environment completed, wait for schedule", pQInfo);
 
-  taosScheduleTask(queryQhandle, &schedMsg);
+  vnodeScheduleQuery(pQInfo, &schedMsg);
   return pQInfo;
 
 _error:
@@ -884,13 +915,13 @@ int vnodeRetrieveQueryInfo(void *handle, int *numOfRows, int *rowSize, int16_t *
 }
 
 // vnodeRetrieveQueryInfo must be called first
-int vnodeSaveQueryResult(void *handle, char *data, int32_t *size) {
+int vnodeSaveQueryResult(void *handle, char *data, int32_t *size, bool compressed) {
   SQInfo *pQInfo = (SQInfo *)handle;
 
   // the remained number of retrieved rows, not the interpolated result
   int numOfRows = pQInfo->pointsRead - pQInfo->pointsReturned;
 
-  int32_t numOfFinal = vnodeCopyQueryResultToMsg(pQInfo, data, numOfRows);
+  int32_t numOfFinal = vnodeCopyQueryResultToMsg(pQInfo, data, numOfRows, compressed, size);
   pQInfo->pointsReturned += numOfFinal;
 
   dTrace("QInfo:%p %d are returned, totalReturned:%d totalRead:%d", pQInfo, numOfFinal, pQInfo->pointsReturned,
@@ -994,6 +1025,7 @@ int32_t vnodeConvertQueryMeterMsg(SQueryMeterMsg *pQueryMsg) {
   pQueryMsg->numOfTagsCols = htons(pQueryMsg->numOfTagsCols);
   pQueryMsg->numOfCols = htons(pQueryMsg->numOfCols);
   pQueryMsg->numOfOutputCols = htons(pQueryMsg->numOfOutputCols);
+  pQueryMsg->retrieveWindow = htons(pQueryMsg->retrieveWindow);
   pQueryMsg->numOfGroupCols = htons(pQueryMsg->numOfGroupCols);
   pQueryMsg->tagLength = htons(pQueryMsg->tagLength);
 
@@ -26,6 +26,7 @@
 #include "tscJoinProcess.h"
 #include "vnode.h"
 #include "vnodeRead.h"
+#include "vnodeQueryMem.h"
 #include "vnodeUtil.h"
 #include "vnodeStore.h"
 #include "vnodeStatus.h"
@@ -342,6 +343,14 @@ int vnodeProcessQueryRequest(char *pMsg, int msgLen, SShellObj *pObj) {
     }
   }
 
+  // out-of-order rows buffered for the meters are merged first, so that they are visible to the query
+  for (int32_t i = 0; i < pQueryMsg->numOfSids; ++i) {
+    SMeterObj *pMeter = pVnode->meterList[pSids[i]->sid];
+    if (pMeter == NULL || vnodeGetImportBufferRows(pMeter) == 0) continue;
+
+    if ((code = vnodeFlushImportBuffer(pMeter)) != TSDB_CODE_SUCCESS) goto _query_over;
+  }
+
   // todo optimize for single table query process
   pMeterObjList = (SMeterObj **)calloc(pQueryMsg->numOfSids, sizeof(SMeterObj *));
   if (pMeterObjList == NULL) {
@@ -412,6 +421,7 @@ void vnodeExecuteRetrieveReq(SSchedMsg *pSched) {
   SRetrieveMeterRsp *pRsp;
   int                numOfRows = 0, rowSize = 0, size = 0;
   int16_t            timePrec = TSDB_TIME_PRECISION_MILLI;
+  bool               compressed = false;
 
   char *pStart;
 
@@ -442,6 +452,7 @@ void vnodeExecuteRetrieveReq(SSchedMsg *pSched) {
 
   if (code == TSDB_CODE_SUCCESS) {
     size = vnodeGetResultSize((void *)(pRetrieve->qhandle), &numOfRows);
+    compressed = (numOfRows > 0) && vnodeNeedToCompressResult((void *)(pRetrieve->qhandle), size);
   
     // buffer size for progress information, including meter count,
     // and for each meter, including 'uid' and 'TSKEY'.
@@ -451,7 +462,11 @@ void vnodeExecuteRetrieveReq(SSchedMsg *pSched) {
     else if (pQInfo->pObj != NULL)
       progressSize = sizeof(int64_t) + sizeof(TSKEY) + sizeof(int32_t);
   
-    pStart = taosBuildRspMsgWithSize(pObj->thandle, TSDB_MSG_TYPE_RETRIEVE_RSP, progressSize + size + 100);
+    // a column may grow a little if it can not be compressed
+    int compressSize = compressed ? pQInfo->query.numOfOutputCols * (sizeof(SRetrieveColumnRsp) + EXTRA_BYTES) : 0;
+
+    pStart = taosBuildRspMsgWithSize(pObj->thandle, TSDB_MSG_TYPE_RETRIEVE_RSP,
+                                     progressSize + size + compressSize + 100);
     if (pStart == NULL) {
       taosSendSimpleRsp(pObj->thandle, TSDB_MSG_TYPE_RETRIEVE_RSP, TSDB_CODE_SERV_OUT_OF_MEMORY);
       goto _exit;
@@ -469,19 +484,23 @@ void vnodeExecuteRetrieveReq(SSchedMsg *pSched) {
   pRsp = (SRetrieveMeterRsp *)pMsg;
   pRsp->numOfRows = htonl(numOfRows);
   pRsp->precision = htons(timePrec);
+  pRsp->compressed = compressed;
+  pRsp->numOfCols = compressed ? htons(pQInfo->query.numOfOutputCols) : 0;
 
   if (code == TSDB_CODE_SUCCESS) {
     pRsp->offset = htobe64(vnodeGetOffsetVal((void*)pRetrieve->qhandle));
     pRsp->useconds = htobe64(((SQInfo *)(pRetrieve->qhandle))->useconds);
+    pRsp->memUsage = htobe64(((SQInfo *)(pRetrieve->qhandle))->memUsage);
   } else {
     pRsp->offset = 0;
     pRsp->useconds = 0;
+    pRsp->memUsage = 0;
   }
 
   pMsg = pRsp->data;
 
   if (numOfRows > 0 && code == TSDB_CODE_SUCCESS) {
-    vnodeSaveQueryResult((void *)(pRetrieve->qhandle), pRsp->data, &size);
+    vnodeSaveQueryResult((void *)(pRetrieve->qhandle), pRsp->data, &size, compressed);
   }
 
   pMsg += size;
@@ -522,7 +541,12 @@ void vnodeExecuteRetrieveReq(SSchedMsg *pSched) {
     pObj->qhandle = NULL;
   }
 
-  taosSendMsgToPeer(pObj->thandle, pStart, msgLen);
+  // columns compressed by their codecs are not compressed again by rpc
+  if (compressed) {
+    taosSendUncompressedMsgToPeer(pObj->thandle, pStart, msgLen);
+  } else {
+    taosSendMsgToPeer(pObj->thandle, pStart, msgLen);
+  }
 
 _exit:
   free(pSched->msg);
@@ -536,7 +560,10 @@ int vnodeProcessRetrieveRequest(char *pMsg, int msgLen, SShellObj *pObj) {
   schedMsg.msg = msg;
   schedMsg.ahandle = pObj;
   schedMsg.fp = vnodeExecuteRetrieveReq;
-  taosScheduleTask(queryQhandle, &schedMsg);
+
+  if (!vnodeParkQueryRetrieve((void *)(uintptr_t)((SRetrieveMeterMsg *)msg)->qhandle, &schedMsg)) {
+    taosScheduleTask(queryQhandle, &schedMsg);
+  }
 
   return msgLen;
 }
@@ -20,6 +20,7 @@
 #include "trpc.h"
 #include "ttime.h"
 #include "vnode.h"
+#include "vnodeBlockCache.h"
 #include "vnodeStore.h"
 #include "vnodeUtil.h"
 #include "vnodeStatus.h"
@@ -58,6 +59,11 @@ static int vnodeInitStoreVnode(int vnode) {
   }
 
   pthread_mutex_init(&(pVnode->vmutex), NULL);
+
+  if (tsCompactInterval > 0) {
+    pVnode->compactTimer = taosTmrStart(vnodeProcessCompactTimer, tsCompactInterval * 1000, pVnode, vnodeTmrCtrl);
+  }
+
   dPrint("vid:%d, storage initialized, version:%" PRIu64 " fileId:%d numOfFiles:%d", vnode, pVnode->version, pVnode->fileId,
          pVnode->numOfFiles);
 
@@ -293,6 +299,7 @@ int vnodeRemoveVnode(int vnode) {
 
       dTrace("vid:%d, status:%s, do delete operation", vnode, taosGetVnodeStatusStr(pVnode->vnodeStatus));
       vnodeRemoveDataFiles(vnode);
+      vnodeInvalidateBlockCache(vnode, -1);
     }
 
   } else {
@@ -336,6 +343,19 @@ int vnodeInitVnodes() {
   return 0;
 }
 
+/*
+ * The commit log is removed once the vnode is cleaned up. A commit that is running then does not take the rows
+ * written after it started, so the cache is committed once more after it is over.
+ */
+static void vnodeCommitBeforeCleanUp(int vnode) {
+  for (int i = 0; i < 2; ++i) {
+    vnodeProcessCommitTimer(vnodeList + vnode, NULL);
+    while (vnodeList[vnode].commitThread != 0) {
+      taosMsleep(10);
+    }
+  }
+}
+
 void vnodeCleanUpOneVnode(int vnode) {
   static int again = 0;
   if (vnodeList == NULL) return;
@@ -356,10 +376,7 @@ void vnodeCleanUpOneVnode(int vnode) {
   pthread_mutex_unlock(&dmutex);
 
   if (vnodeList[vnode].pCachePool) {
-    vnodeProcessCommitTimer(vnodeList + vnode, NULL);
-    while (vnodeList[vnode].commitThread != 0) {
-      taosMsleep(10);
-    }
+    vnodeCommitBeforeCleanUp(vnode);
     vnodeCleanUpCommit(vnode);
   }
 }
@@ -387,10 +404,7 @@ void vnodeCleanUpVnodes() {
 
   for (int vnode = 0; vnode < TSDB_MAX_VNODES; ++vnode) {
     if (vnodeList[vnode].pCachePool) {
-      vnodeProcessCommitTimer(vnodeList + vnode, NULL);
-      while (vnodeList[vnode].commitThread != 0) {
-        taosMsleep(10);
-      }
+      vnodeCommitBeforeCleanUp(vnode);
       vnodeCleanUpCommit(vnode);
     }
   }
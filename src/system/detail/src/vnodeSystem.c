@@ -17,8 +17,13 @@
 #include "os.h"
 
 #include "tsdb.h"
+#include "tsched.h"
 #include "tsocket.h"
 #include "vnode.h"
+#include "vnodeBlockCache.h"
+#include "vnodeBlockRead.h"
+#include "vnodeCommitSched.h"
+#include "vnodeQueryMem.h"
 #include "vnodeSystem.h"
 
 // internal global, not configurable
@@ -26,12 +31,25 @@ void *   vnodeTmrCtrl;
 void **  rpcQhandle;
 void *   dmQhandle;
 void *   queryQhandle;
+void *   commitQhandle;
 int      tsVnodePeers = TSDB_VNODES_SUPPORT - 1;
 int      tsMaxQueues;
 uint32_t tsRebootTime;
 
+void vnodeCleanUpCommitHandle() {
+  // commits of all vnodes are over, no compression task is left in the queue
+  if (commitQhandle != NULL) {
+    taosCleanUpScheduler(commitQhandle);
+    commitQhandle = NULL;
+  }
+}
+
 void vnodeCleanUpSystem() {
   vnodeCleanUpVnodes();
+  vnodeCleanUpCommitScheduler();
+  vnodeCleanUpCommitHandle();
+  vnodeCleanUpBlockReadPool();
+  vnodeCleanUpQueryMemGovernor();
 }
 
 bool vnodeInitQueryHandle() {
@@ -47,6 +65,28 @@ bool vnodeInitQueryHandle() {
   return true;
 }
 
+bool vnodeInitCommitHandle() {
+  if (tsNumOfCommitThreads <= 0) {
+    dPrint("commit task queue is not initialized, blocks are compressed in commit thread");
+    return true;
+  }
+
+  int32_t maxQueueSize = TSDB_MAX_VNODES * tsNumOfCommitThreads * 2;
+  dTrace("commit task queue initialized, max slot:%d, task threads:%d", maxQueueSize, tsNumOfCommitThreads);
+
+  commitQhandle = taosInitScheduler(maxQueueSize, tsNumOfCommitThreads, "commit");
+  return commitQhandle != NULL;
+}
+
+bool vnodeInitReadHandle() {
+  if (tsAsyncRead == TSDB_BLOCK_READ_SYNC || tsReadAheadBlocks <= 0) {
+    dPrint("file blocks are not read ahead, they are read in query threads");
+    return true;
+  }
+
+  return vnodeInitBlockReadPool(tsNumOfReadThreads) == 0;
+}
+
 bool vnodeInitTmrCtl() {
   vnodeTmrCtrl = taosTmrInit(TSDB_MAX_VNODES * (tsVnodePeers + 10) + tsSessionsPerVnode + 1000, 200, 60000, "DND-vnode");
   if (vnodeTmrCtrl == NULL) {
@@ -68,6 +108,32 @@ int vnodeInitSystem() {
     return -1;
   }
 
+  if (!vnodeInitCommitHandle()) {
+    dError("failed to init commit qhandle, exit");
+    return -1;
+  }
+
+  if (vnodeInitCommitScheduler(tsNumOfCommitWorkers, tsMaxCommitsPerDir) < 0) {
+    dError("failed to init commit scheduler, exit");
+    return -1;
+  }
+
+  if (!vnodeInitReadHandle()) {
+    dError("failed to init block read qhandle, exit");
+    return -1;
+  }
+
+  if (vnodeInitBlockCache((int64_t)tsBlockCacheSize * 1024 * 1024) < 0) {
+    dError("failed to init block cache, exit");
+    return -1;
+  }
+
+  if (vnodeInitQueryMemGovernor((int64_t)tsQueryMemBudget * 1024 * 1024, (int64_t)tsQueryMemQuota * 1024 * 1024,
+                                tsQueryMemWaitTime) < 0) {
+    dError("failed to init query memory governor, exit");
+    return -1;
+  }
+
   if (vnodeInitStore() < 0) {
     dError("failed to init vnode storage");
     return -1;
@@ -470,6 +470,7 @@ int32_t vnodeCreateFilterInfo(void* pQInfo, SQuery* pQuery) {
         }
         assert (pSingleColFilter->fp != NULL);
         pSingleColFilter->bytes = bytes;
+        vnodeInitBatchFilter(pSingleColFilter, type);
       }
 
       j++;
@@ -49,9 +49,16 @@
 
 #include "os.h"
 #include "lz4.h"
+#include "tglobalcfg.h"
 #include "tscompression.h"
 #include "tsdb.h"
 #include "ttypes.h"
+#include "tutil.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define COMPRESS_CODEC_X86
+#include <immintrin.h>
+#endif
 
 const int TEST_NUMBER = 1;
 #define is_bigendian() ((*(char *)&TEST_NUMBER) == 0)
@@ -65,11 +72,13 @@ int tsDecompressBoolImp(const char *const input, const int nelements, char *cons
 int tsCompressStringImp(const char *const input, int inputSize, char *const output, int outputSize);
 int tsDecompressStringImp(const char *const input, int compressedSize, char *const output, int outputSize);
 int tsCompressTimestampImp(const char *const input, const int nelements, char *const output);
-int tsDecompressTimestampImp(const char *const input, const int nelements, char *const output);
-int tsCompressDoubleImp(const char *const input, const int nelements, char *const output);
-int tsDecompressDoubleImp(const char *const input, const int nelements, char *const output);
-int tsCompressFloatImp(const char *const input, const int nelements, char *const output);
-int tsDecompressFloatImp(const char *const input, const int nelements, char *const output);
+int tsDecompressTimestampImp(const char *const input, int compressedSize, const int nelements, char *const output);
+int tsCompressDoubleImp(const char *const input, const int nelements, char *const output, char *const buffer,
+                        int bufferSize);
+int tsDecompressDoubleImp(const char *const input, int compressedSize, const int nelements, char *const output);
+int tsCompressFloatImp(const char *const input, const int nelements, char *const output, char *const buffer,
+                       int bufferSize);
+int tsDecompressFloatImp(const char *const input, int compressedSize, const int nelements, char *const output);
 
 /* ----------------------------------------------Compression function used by
  * others ---------------------------------------------- */
@@ -206,9 +215,10 @@ int tsDecompressString(const char *const input, int compressedSize, const int ne
 int tsCompressFloat(const char *const input, int inputSize, const int nelements, char *const output, int outputSize,
                     char algorithm, char *const buffer, int bufferSize) {
   if (algorithm == ONE_STAGE_COMP) {
-    return tsCompressFloatImp(input, nelements, output);
+    return tsCompressFloatImp(input, nelements, output, buffer, bufferSize);
   } else if (algorithm == TWO_STAGE_COMP) {
-    int len = tsCompressFloatImp(input, nelements, buffer);
+    // output is overwritten by the second stage, so it is the scratch of the first one
+    int len = tsCompressFloatImp(input, nelements, buffer, output, outputSize);
     return tsCompressStringImp(buffer, len, output, outputSize);
   } else {
     assert(0);
@@ -218,10 +228,10 @@ int tsCompressFloat(const char *const input, int inputSize, const int nelements,
 int tsDecompressFloat(const char *const input, int compressedSize, const int nelements, char *const output,
                       int outputSize, char algorithm, char *const buffer, int bufferSize) {
   if (algorithm == ONE_STAGE_COMP) {
-    return tsDecompressFloatImp(input, nelements, output);
+    return tsDecompressFloatImp(input, compressedSize, nelements, output);
   } else if (algorithm == TWO_STAGE_COMP) {
-    tsDecompressStringImp(input, compressedSize, buffer, bufferSize);
-    return tsDecompressFloatImp(buffer, nelements, output);
+    int len = tsDecompressStringImp(input, compressedSize, buffer, bufferSize);
+    return tsDecompressFloatImp(buffer, len, nelements, output);
   } else {
     assert(0);
   }
@@ -229,9 +239,10 @@ int tsDecompressFloat(const char *const input, int compressedSize, const int nel
 int tsCompressDouble(const char *const input, int inputSize, const int nelements, char *const output, int outputSize,
                      char algorithm, char *const buffer, int bufferSize) {
   if (algorithm == ONE_STAGE_COMP) {
-    return tsCompressDoubleImp(input, nelements, output);
+    return tsCompressDoubleImp(input, nelements, output, buffer, bufferSize);
   } else if (algorithm == TWO_STAGE_COMP) {
-    int len = tsCompressDoubleImp(input, nelements, buffer);
+    // output is overwritten by the second stage, so it is the scratch of the first one
+    int len = tsCompressDoubleImp(input, nelements, buffer, output, outputSize);
     return tsCompressStringImp(buffer, len, output, outputSize);
   } else {
     assert(0);
@@ -241,10 +252,10 @@ int tsCompressDouble(const char *const input, int inputSize, const int nelements
 int tsDecompressDouble(const char *const input, int compressedSize, const int nelements, char *const output,
                        int outputSize, char algorithm, char *const buffer, int bufferSize) {
   if (algorithm == ONE_STAGE_COMP) {
-    return tsDecompressDoubleImp(input, nelements, output);
+    return tsDecompressDoubleImp(input, compressedSize, nelements, output);
   } else if (algorithm == TWO_STAGE_COMP) {
-    tsDecompressStringImp(input, compressedSize, buffer, bufferSize);
-    return tsDecompressDoubleImp(buffer, nelements, output);
+    int len = tsDecompressStringImp(input, compressedSize, buffer, bufferSize);
+    return tsDecompressDoubleImp(buffer, len, nelements, output);
   } else {
     assert(0);
   }
@@ -265,10 +276,10 @@ int tsCompressTimestamp(const char *const input, int inputSize, const int neleme
 int tsDecompressTimestamp(const char *const input, int compressedSize, const int nelements, char *const output,
                           int outputSize, char algorithm, char *const buffer, int bufferSize) {
   if (algorithm == ONE_STAGE_COMP) {
-    return tsDecompressTimestampImp(input, nelements, output);
+    return tsDecompressTimestampImp(input, compressedSize, nelements, output);
   } else if (algorithm == TWO_STAGE_COMP) {
-    tsDecompressStringImp(input, compressedSize, buffer, bufferSize);
-    return tsDecompressTimestampImp(buffer, nelements, output);
+    int len = tsDecompressStringImp(input, compressedSize, buffer, bufferSize);
+    return tsDecompressTimestampImp(buffer, len, nelements, output);
   } else {
     assert(0);
   }
@@ -279,10 +290,38 @@ bool safeInt64Add(int64_t a, int64_t b) {
   return true;
 }
 
+// the codec engine in use, see tsSetCompressCodec
+static int tsCompressCodec = -1;
+
+static int tsDetectCompressCodec() {
+  if (is_bigendian()) return TSDB_CODEC_REFERENCE;
+
+#ifdef COMPRESS_CODEC_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return TSDB_CODEC_AVX2;
+  if (__builtin_cpu_supports("sse4.2")) return TSDB_CODEC_SSE42;
+#endif
+
+  return TSDB_CODEC_SCALAR;
+}
+
+int tsSetCompressCodec(int codec) {
+  int best = tsDetectCompressCodec();
+  if (codec < 0 || codec > best || best == TSDB_CODEC_REFERENCE) codec = best;
+
+  tsCompressCodec = codec;
+  return codec;
+}
+
+int tsGetCompressCodec() {
+  if (tsCompressCodec < 0) tsSetCompressCodec(-1);
+  return tsCompressCodec;
+}
+
 /*
  * Compress Integer (Simple8B).
  */
-int tsCompressINTImp(const char *const input, const int nelements, char *const output, const char type) {
+static int tsCompressINTReference(const char *const input, const int nelements, char *const output, const char type) {
   // Selector value:              0    1   2   3   4   5   6   7   8  9  10  11
   // 12  13  14  15
   char bit_per_integer[] = {0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 10, 12, 15, 20, 30, 60};
@@ -412,7 +451,7 @@ int tsCompressINTImp(const char *const input, const int nelements, char *const o
   return opos;
 }
 
-int tsDecompressINTImp(const char *const input, const int nelements, char *const output, const char type) {
+static int tsDecompressINTReference(const char *const input, const int nelements, char *const output, const char type) {
   int word_length = 0;
   switch (type) {
     case TSDB_DATA_TYPE_BIGINT:
@@ -500,6 +539,245 @@ int tsDecompressINTImp(const char *const input, const int nelements, char *const
   return nelements * word_length;
 }
 
+/*
+ * Type specialized simple8b codec. Selectors are chosen by the same state machine as the reference one, so the words
+ * are identical, but the integer type is resolved once per call instead of once per element, and the zigzag values
+ * found by the scan are packed without being computed again. Decoding fills runs of selector 0 and 1 directly, and
+ * unpacks other words with constant shifts per selector or with AVX2 variable shifts before the prefix sum.
+ */
+static const char tsSimple8bBits[] = {0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 10, 12, 15, 20, 30, 60};
+static const int  tsSimple8bElems[] = {240, 120, 60, 30, 20, 15, 12, 10, 8, 7, 6, 5, 4, 3, 2, 1};
+static const char tsSimple8bBitToSelector[] = {
+    0,  2,  3,  4,  5,  6,  7,  8,  9,  10, 10, 11, 11, 12, 12, 12, 13, 13, 13, 13, 13,
+    14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15};
+
+static FORCE_INLINE int64_t tsGetINTValue(const char *const input, int i, const char type) {
+  switch (type) {
+    case TSDB_DATA_TYPE_TINYINT:
+      return *((int8_t *)input + i);
+    case TSDB_DATA_TYPE_SMALLINT:
+      return *((int16_t *)input + i);
+    case TSDB_DATA_TYPE_INT:
+      return *((int32_t *)input + i);
+    default:
+      return *((int64_t *)input + i);
+  }
+}
+
+static FORCE_INLINE void tsSetINTValue(char *const output, int i, int64_t value, const char type) {
+  switch (type) {
+    case TSDB_DATA_TYPE_TINYINT:
+      *((int8_t *)output + i) = (int8_t)value;
+      break;
+    case TSDB_DATA_TYPE_SMALLINT:
+      *((int16_t *)output + i) = (int16_t)value;
+      break;
+    case TSDB_DATA_TYPE_INT:
+      *((int32_t *)output + i) = (int32_t)value;
+      break;
+    default:
+      *((int64_t *)output + i) = value;
+      break;
+  }
+}
+
+static FORCE_INLINE int tsCompressINTTyped(const char *const input, const int nelements, char *const output,
+                                           const char type, const int word_length) {
+  int      byte_limit = nelements * word_length + 1;
+  int      opos = 1;
+  int64_t  prev_value = 0;
+  uint64_t zigzag[240];
+
+  for (int i = 0; i < nelements;) {
+    int     selector = 0;
+    int     elems = 0;
+    int64_t prev_value_tmp = prev_value;
+
+    for (int j = i; j < nelements; j++) {
+      int64_t  curr_value = tsGetINTValue(input, j, type);
+      uint64_t diff = (uint64_t)curr_value - (uint64_t)prev_value_tmp;
+      uint64_t zigzag_value = ((uint64_t)((int64_t)diff >> (LONG_BYTES * BITS_PER_BYTE - 1))) ^ (diff << 1);
+
+      // Only a bigint can overflow or go beyond 60 bits. Like the reference codec, the overflow is checked against
+      // the last value of the previous word.
+      if (type == TSDB_DATA_TYPE_BIGINT) {
+        if (!safeInt64Add(curr_value, (int64_t)(0 - (uint64_t)prev_value))) goto _copy_and_exit;
+        if (zigzag_value >= SIMPLE8B_MAX_INT64 || BUILDIN_CLZL(zigzag_value | 1) < 4) goto _copy_and_exit;
+      }
+
+      int bit = (zigzag_value == 0) ? 0 : (LONG_BYTES * BITS_PER_BYTE) - BUILDIN_CLZL(zigzag_value);
+      int tmp_selector = tsSimple8bBitToSelector[bit];
+      if (tmp_selector < selector) tmp_selector = selector;
+
+      if (elems < tsSimple8bElems[tmp_selector]) {
+        selector = tmp_selector;
+        zigzag[elems++] = zigzag_value;
+      } else {
+        while (elems < tsSimple8bElems[selector]) selector++;
+        elems = tsSimple8bElems[selector];
+        break;
+      }
+      prev_value_tmp = curr_value;
+    }
+
+    int      bit = tsSimple8bBits[selector];
+    uint64_t buffer = (uint64_t)selector;
+    for (int k = 0; k < elems; k++) {
+      buffer |= (zigzag[k] & INT64MASK(bit)) << (bit * k + 4);
+    }
+    i += elems;
+    prev_value = tsGetINTValue(input, i - 1, type);
+
+    if (opos + LONG_BYTES > byte_limit) goto _copy_and_exit;
+    memcpy(output + opos, &buffer, LONG_BYTES);
+    opos += LONG_BYTES;
+  }
+
+  // set the indicator.
+  output[0] = 0;
+  return opos;
+
+_copy_and_exit:
+  output[0] = 1;
+  memcpy(output + 1, input, byte_limit - 1);
+  return byte_limit;
+}
+
+#define SIMPLE8B_UNPACK(_selector, _bit, _elems)                                    \
+  case _selector:                                                                    \
+    for (int k = 0; k < (_elems); ++k) out[k] = (w >> (4 + (_bit) * k)) & INT64MASK(_bit); \
+    return (_elems);
+
+// unpack the zigzag values of a word with selector 2 to 15 into out, which has room for 3 values more than it holds
+static FORCE_INLINE int tsSimple8bUnpackScalar(uint64_t w, uint64_t *out) {
+  switch (w & INT64MASK(4)) {
+    SIMPLE8B_UNPACK(2, 1, 60)
+    SIMPLE8B_UNPACK(3, 2, 30)
+    SIMPLE8B_UNPACK(4, 3, 20)
+    SIMPLE8B_UNPACK(5, 4, 15)
+    SIMPLE8B_UNPACK(6, 5, 12)
+    SIMPLE8B_UNPACK(7, 6, 10)
+    SIMPLE8B_UNPACK(8, 7, 8)
+    SIMPLE8B_UNPACK(9, 8, 7)
+    SIMPLE8B_UNPACK(10, 10, 6)
+    SIMPLE8B_UNPACK(11, 12, 5)
+    SIMPLE8B_UNPACK(12, 15, 4)
+    SIMPLE8B_UNPACK(13, 20, 3)
+    SIMPLE8B_UNPACK(14, 30, 2)
+    default:
+      out[0] = (w >> 4) & INT64MASK(60);
+      return 1;
+  }
+}
+
+#undef SIMPLE8B_UNPACK
+
+#ifdef COMPRESS_CODEC_X86
+__attribute__((target("avx2"))) static int tsSimple8bUnpackAVX2(uint64_t w, uint64_t *out) {
+  int     selector = (int)(w & INT64MASK(4));
+  int     bit = tsSimple8bBits[selector];
+  int     elems = tsSimple8bElems[selector];
+  __m256i value = _mm256_set1_epi64x((int64_t)w);
+  __m256i mask = _mm256_set1_epi64x((int64_t)INT64MASK(bit));
+  __m256i shift = _mm256_setr_epi64x(4, 4 + bit, 4 + 2 * bit, 4 + 3 * bit);
+  __m256i step = _mm256_set1_epi64x(4 * bit);
+
+  // lanes beyond the last value get shifts of 64 or more, which give 0
+  for (int k = 0; k < elems; k += 4) {
+    _mm256_storeu_si256((__m256i *)(out + k), _mm256_and_si256(_mm256_srlv_epi64(value, shift), mask));
+    shift = _mm256_add_epi64(shift, step);
+  }
+
+  return elems;
+}
+#endif
+
+static FORCE_INLINE int tsDecompressINTTyped(const char *const input, const int nelements, char *const output,
+                                             const char type, const int word_length, int codec) {
+  // If not compressed.
+  if (input[0] == 1) {
+    memcpy(output, input + 1, nelements * word_length);
+    return nelements * word_length;
+  }
+
+  uint64_t    zigzag[60 + 3];
+  const char *ip = input + 1;
+  uint64_t    prev_value = 0;
+  int         count = 0;
+
+  while (count < nelements) {
+    uint64_t w = 0;
+    memcpy(&w, ip, LONG_BYTES);
+    ip += LONG_BYTES;
+
+    int selector = (int)(w & INT64MASK(4));
+    int elems = tsSimple8bElems[selector];
+    if (elems > nelements - count) elems = nelements - count;
+
+    if (selector < 2) {
+      // a run of the same value
+      for (int k = 0; k < elems; ++k) tsSetINTValue(output, count + k, (int64_t)prev_value, type);
+    } else {
+#ifdef COMPRESS_CODEC_X86
+      // with fewer than 8 values in a word the scalar shifts are faster
+      if (codec == TSDB_CODEC_AVX2 && selector <= 8) {
+        tsSimple8bUnpackAVX2(w, zigzag);
+      } else {
+        tsSimple8bUnpackScalar(w, zigzag);
+      }
+#else
+      tsSimple8bUnpackScalar(w, zigzag);
+#endif
+      for (int k = 0; k < elems; ++k) {
+        prev_value += (zigzag[k] >> 1) ^ (0 - (zigzag[k] & 1));
+        tsSetINTValue(output, count + k, (int64_t)prev_value, type);
+      }
+    }
+
+    count += elems;
+  }
+
+  return nelements * word_length;
+}
+
+int tsCompressINTImp(const char *const input, const int nelements, char *const output, const char type) {
+  if (tsGetCompressCodec() == TSDB_CODEC_REFERENCE) return tsCompressINTReference(input, nelements, output, type);
+
+  switch (type) {
+    case TSDB_DATA_TYPE_TINYINT:
+      return tsCompressINTTyped(input, nelements, output, TSDB_DATA_TYPE_TINYINT, CHAR_BYTES);
+    case TSDB_DATA_TYPE_SMALLINT:
+      return tsCompressINTTyped(input, nelements, output, TSDB_DATA_TYPE_SMALLINT, SHORT_BYTES);
+    case TSDB_DATA_TYPE_INT:
+      return tsCompressINTTyped(input, nelements, output, TSDB_DATA_TYPE_INT, INT_BYTES);
+    case TSDB_DATA_TYPE_BIGINT:
+      return tsCompressINTTyped(input, nelements, output, TSDB_DATA_TYPE_BIGINT, LONG_BYTES);
+    default:
+      perror("Wrong integer types.\n");
+      exit(1);
+  }
+}
+
+int tsDecompressINTImp(const char *const input, const int nelements, char *const output, const char type) {
+  int codec = tsGetCompressCodec();
+  if (codec == TSDB_CODEC_REFERENCE) return tsDecompressINTReference(input, nelements, output, type);
+
+  switch (type) {
+    case TSDB_DATA_TYPE_TINYINT:
+      return tsDecompressINTTyped(input, nelements, output, TSDB_DATA_TYPE_TINYINT, CHAR_BYTES, codec);
+    case TSDB_DATA_TYPE_SMALLINT:
+      return tsDecompressINTTyped(input, nelements, output, TSDB_DATA_TYPE_SMALLINT, SHORT_BYTES, codec);
+    case TSDB_DATA_TYPE_INT:
+      return tsDecompressINTTyped(input, nelements, output, TSDB_DATA_TYPE_INT, INT_BYTES, codec);
+    case TSDB_DATA_TYPE_BIGINT:
+      return tsDecompressINTTyped(input, nelements, output, TSDB_DATA_TYPE_BIGINT, LONG_BYTES, codec);
+    default:
+      perror("Wrong integer types.\n");
+      exit(1);
+  }
+}
+
 /* ----------------------------------------------Bool Compression
  * ---------------------------------------------- */
 // TODO: You can also implement it using RLE method.
@@ -651,8 +929,8 @@ int tsDecompressStringImp(const char *const input, int compressedSize, char *con
 
 /* --------------------------------------------Timestamp Compression
  * ---------------------------------------------- */
-// TODO: Take care here, we assumes little endian encoding.
-int tsCompressTimestampImp(const char *const input, const int nelements, char *const output) {
+// The byte-wise codec is the reference of the on-disk format, and it is the only one working on big endian hosts.
+static int tsCompressTimestampReference(const char *const input, const int nelements, char *const output) {
   int _pos = 1;
   assert(nelements >= 0);
 
@@ -744,7 +1022,7 @@ _exit_over:
   return nelements * LONG_BYTES + 1;
 }
 
-int tsDecompressTimestampImp(const char *const input, const int nelements, char *const output) {
+static int tsDecompressTimestampReference(const char *const input, const int nelements, char *const output) {
   assert(nelements >= 0);
   if (nelements == 0) return 0;
 
@@ -812,6 +1090,342 @@ int tsDecompressTimestampImp(const char *const input, const int nelements, char
     assert(0);
   }
 }
+
+/*
+ * The word-wise codecs below produce exactly the bytes of the byte-wise one. Each chunk of timestamps is turned into
+ * zigzag encoded delta of deltas first, which is vectorized, and then packed pair by pair with unaligned 8-byte
+ * stores. Decoding unpacks a chunk of zigzag values into the output and runs the prefix sums over it in place.
+ * The overflow check of safeInt64Add is done branch free: a + b overflows iff both operands have the sign bit
+ * different from the sum.
+ */
+#define TS_CODEC_CHUNK 256  // must be even so that a pair never spans two chunks
+
+static const uint64_t tsTimestampByteMask[16] = {
+    0x0ul,
+    0xFFul,
+    0xFFFFul,
+    0xFFFFFFul,
+    0xFFFFFFFFul,
+    0xFFFFFFFFFFul,
+    0xFFFFFFFFFFFFul,
+    0xFFFFFFFFFFFFFFul,
+    0xFFFFFFFFFFFFFFFFul, 0xFFFFFFFFFFFFFFFFul, 0xFFFFFFFFFFFFFFFFul, 0xFFFFFFFFFFFFFFFFul,
+    0xFFFFFFFFFFFFFFFFul, 0xFFFFFFFFFFFFFFFFul, 0xFFFFFFFFFFFFFFFFul, 0xFFFFFFFFFFFFFFFFul};
+
+static FORCE_INLINE uint8_t tsTimestampBytes(uint64_t zigzag) {
+  return (zigzag == 0) ? 0 : (uint8_t)(LONG_BYTES - BUILDIN_CLZL(zigzag) / BITS_PER_BYTE);
+}
+
+// returns -1 if any delta or delta of delta overflows
+static int tsTimestampZigzagScalar(const int64_t *in, int n, int64_t *prevValue, int64_t *prevDelta, uint64_t *out) {
+  uint64_t pv = (uint64_t)*prevValue, pd = (uint64_t)*prevDelta, ovf = 0;
+
+  for (int i = 0; i < n; ++i) {
+    uint64_t v = (uint64_t)in[i];
+    uint64_t nv = 0 - pv;
+    uint64_t d = v + nv;
+    ovf |= (v ^ d) & (nv ^ d);
+    uint64_t nd = 0 - pd;
+    uint64_t dd = d + nd;
+    ovf |= (d ^ dd) & (nd ^ dd);
+    out[i] = (dd << 1) ^ (uint64_t)((int64_t)dd >> 63);
+    pv = v;
+    pd = d;
+  }
+
+  *prevValue = (int64_t)pv;
+  *prevDelta = (int64_t)pd;
+  return ((int64_t)ovf < 0) ? -1 : 0;
+}
+
+static void tsTimestampPrefixScalar(uint64_t *data, int n, int64_t *value, int64_t *delta) {
+  uint64_t v = (uint64_t)*value, d = (uint64_t)*delta;
+
+  for (int i = 0; i < n; ++i) {
+    uint64_t zz = data[i];
+    d += (zz >> 1) ^ (0 - (zz & 1));
+    v += d;
+    data[i] = v;
+  }
+
+  *value = (int64_t)v;
+  *delta = (int64_t)d;
+}
+
+#ifdef COMPRESS_CODEC_X86
+/*
+ * In the vector loops element i needs in[i-1] and in[i-2] of the same chunk, so the first two elements of a chunk
+ * are always handled by the scalar code, which also carries the state in from the previous chunk.
+ */
+__attribute__((target("sse4.2"))) static int tsTimestampZigzagSSE42(const int64_t *in, int n, int64_t *prevValue,
+                                                                    int64_t *prevDelta, uint64_t *out) {
+  int i = (n < 2) ? n : 2;
+  int ret = tsTimestampZigzagScalar(in, i, prevValue, prevDelta, out);
+
+  __m128i zero = _mm_setzero_si128(), ovf = zero;
+  int     start = i;
+  for (; i + 2 <= n; i += 2) {
+    __m128i a = _mm_loadu_si128((const __m128i *)(in + i));
+    __m128i b = _mm_loadu_si128((const __m128i *)(in + i - 1));
+    __m128i c = _mm_loadu_si128((const __m128i *)(in + i - 2));
+    __m128i nb = _mm_sub_epi64(zero, b);
+    __m128i d = _mm_add_epi64(a, nb);
+    ovf = _mm_or_si128(ovf, _mm_and_si128(_mm_xor_si128(a, d), _mm_xor_si128(nb, d)));
+    __m128i nd = _mm_sub_epi64(zero, _mm_sub_epi64(b, c));
+    __m128i dd = _mm_add_epi64(d, nd);
+    ovf = _mm_or_si128(ovf, _mm_and_si128(_mm_xor_si128(d, dd), _mm_xor_si128(nd, dd)));
+    __m128i sign = _mm_cmpgt_epi64(zero, dd);
+    _mm_storeu_si128((__m128i *)(out + i), _mm_xor_si128(_mm_slli_epi64(dd, 1), sign));
+  }
+
+  if (i > start) {
+    *prevValue = in[i - 1];
+    *prevDelta = (int64_t)((uint64_t)in[i - 1] - (uint64_t)in[i - 2]);
+  }
+
+  ret |= tsTimestampZigzagScalar(in + i, n - i, prevValue, prevDelta, out + i);
+  return (ret != 0 || _mm_movemask_pd(_mm_castsi128_pd(ovf)) != 0) ? -1 : 0;
+}
+
+__attribute__((target("avx2"))) static int tsTimestampZigzagAVX2(const int64_t *in, int n, int64_t *prevValue,
+                                                                  int64_t *prevDelta, uint64_t *out) {
+  int i = (n < 2) ? n : 2;
+  int ret = tsTimestampZigzagScalar(in, i, prevValue, prevDelta, out);
+
+  __m256i zero = _mm256_setzero_si256(), ovf = zero;
+  int     start = i;
+  for (; i + 4 <= n; i += 4) {
+    __m256i a = _mm256_loadu_si256((const __m256i *)(in + i));
+    __m256i b = _mm256_loadu_si256((const __m256i *)(in + i - 1));
+    __m256i c = _mm256_loadu_si256((const __m256i *)(in + i - 2));
+    __m256i nb = _mm256_sub_epi64(zero, b);
+    __m256i d = _mm256_add_epi64(a, nb);
+    ovf = _mm256_or_si256(ovf, _mm256_and_si256(_mm256_xor_si256(a, d), _mm256_xor_si256(nb, d)));
+    __m256i nd = _mm256_sub_epi64(zero, _mm256_sub_epi64(b, c));
+    __m256i dd = _mm256_add_epi64(d, nd);
+    ovf = _mm256_or_si256(ovf, _mm256_and_si256(_mm256_xor_si256(d, dd), _mm256_xor_si256(nd, dd)));
+    __m256i sign = _mm256_cmpgt_epi64(zero, dd);
+    _mm256_storeu_si256((__m256i *)(out + i), _mm256_xor_si256(_mm256_slli_epi64(dd, 1), sign));
+  }
+
+  if (i > start) {
+    *prevValue = in[i - 1];
+    *prevDelta = (int64_t)((uint64_t)in[i - 1] - (uint64_t)in[i - 2]);
+  }
+
+  ret |= tsTimestampZigzagScalar(in + i, n - i, prevValue, prevDelta, out + i);
+  return (ret != 0 || _mm256_movemask_pd(_mm256_castsi256_pd(ovf)) != 0) ? -1 : 0;
+}
+
+__attribute__((target("sse4.2"))) static void tsTimestampPrefixSSE42(uint64_t *data, int n, int64_t *value,
+                                                                     int64_t *delta) {
+  __m128i zero = _mm_setzero_si128(), one = _mm_set1_epi64x(1);
+  __m128i vValue = _mm_set1_epi64x(*value), vDelta = _mm_set1_epi64x(*delta);
+  int     i = 0;
+
+  for (; i + 2 <= n; i += 2) {
+    __m128i zz = _mm_loadu_si128((const __m128i *)(data + i));
+    __m128i dod = _mm_xor_si128(_mm_srli_epi64(zz, 1), _mm_sub_epi64(zero, _mm_and_si128(zz, one)));
+    __m128i d = _mm_add_epi64(_mm_add_epi64(dod, _mm_slli_si128(dod, 8)), vDelta);
+    vDelta = _mm_unpackhi_epi64(d, d);
+    __m128i v = _mm_add_epi64(_mm_add_epi64(d, _mm_slli_si128(d, 8)), vValue);
+    vValue = _mm_unpackhi_epi64(v, v);
+    _mm_storeu_si128((__m128i *)(data + i), v);
+  }
+
+  *value = _mm_cvtsi128_si64(vValue);
+  *delta = _mm_cvtsi128_si64(vDelta);
+  tsTimestampPrefixScalar(data + i, n - i, value, delta);
+}
+
+__attribute__((target("avx2"))) static void tsTimestampPrefixAVX2(uint64_t *data, int n, int64_t *value,
+                                                                   int64_t *delta) {
+  __m256i zero = _mm256_setzero_si256(), one = _mm256_set1_epi64x(1);
+  __m256i vValue = _mm256_set1_epi64x(*value), vDelta = _mm256_set1_epi64x(*delta);
+  int     i = 0;
+
+  for (; i + 4 <= n; i += 4) {
+    __m256i zz = _mm256_loadu_si256((const __m256i *)(data + i));
+    __m256i d = _mm256_xor_si256(_mm256_srli_epi64(zz, 1), _mm256_sub_epi64(zero, _mm256_and_si256(zz, one)));
+    // inclusive prefix sum of 4 lanes: shift up by one lane and add, then by two lanes and add
+    d = _mm256_add_epi64(d, _mm256_blend_epi32(_mm256_permute4x64_epi64(d, 0x90), zero, 0x03));
+    d = _mm256_add_epi64(d, _mm256_blend_epi32(_mm256_permute4x64_epi64(d, 0x40), zero, 0x0F));
+    d = _mm256_add_epi64(d, vDelta);
+    vDelta = _mm256_permute4x64_epi64(d, 0xFF);
+
+    __m256i v = _mm256_add_epi64(d, _mm256_blend_epi32(_mm256_permute4x64_epi64(d, 0x90), zero, 0x03));
+    v = _mm256_add_epi64(v, _mm256_blend_epi32(_mm256_permute4x64_epi64(v, 0x40), zero, 0x0F));
+    v = _mm256_add_epi64(v, vValue);
+    vValue = _mm256_permute4x64_epi64(v, 0xFF);
+    _mm256_storeu_si256((__m256i *)(data + i), v);
+  }
+
+  *value = _mm_cvtsi128_si64(_mm256_castsi256_si128(vValue));
+  *delta = _mm_cvtsi128_si64(_mm256_castsi256_si128(vDelta));
+  tsTimestampPrefixScalar(data + i, n - i, value, delta);
+}
+#endif
+
+static FORCE_INLINE int tsTimestampZigzag(int codec, const int64_t *in, int n, int64_t *prevValue, int64_t *prevDelta,
+                                          uint64_t *out) {
+#ifdef COMPRESS_CODEC_X86
+  if (codec == TSDB_CODEC_AVX2) return tsTimestampZigzagAVX2(in, n, prevValue, prevDelta, out);
+  if (codec == TSDB_CODEC_SSE42) return tsTimestampZigzagSSE42(in, n, prevValue, prevDelta, out);
+#endif
+  return tsTimestampZigzagScalar(in, n, prevValue, prevDelta, out);
+}
+
+static FORCE_INLINE void tsTimestampPrefix(int codec, uint64_t *data, int n, int64_t *value, int64_t *delta) {
+#ifdef COMPRESS_CODEC_X86
+  if (codec == TSDB_CODEC_AVX2) {
+    tsTimestampPrefixAVX2(data, n, value, delta);
+    return;
+  }
+  if (codec == TSDB_CODEC_SSE42) {
+    tsTimestampPrefixSSE42(data, n, value, delta);
+    return;
+  }
+#endif
+  tsTimestampPrefixScalar(data, n, value, delta);
+}
+
+static int tsCompressTimestampWordwise(const char *const input, const int nelements, char *const output, int codec) {
+  const int64_t *istream = (const int64_t *)input;
+  uint64_t       zigzag[TS_CODEC_CHUNK];
+
+  // same initial state as the byte-wise codec, so that the first delta of delta is the first value
+  int64_t prevValue = istream[0];
+  int64_t prevDelta = (int64_t)(0 - (uint64_t)prevValue);
+  int     limit = nelements * LONG_BYTES;
+  int     pos = 1;
+
+  for (int start = 0; start < nelements; start += TS_CODEC_CHUNK) {
+    int n = nelements - start;
+    if (n > TS_CODEC_CHUNK) n = TS_CODEC_CHUNK;
+
+    if (tsTimestampZigzag(codec, istream + start, n, &prevValue, &prevDelta, zigzag) != 0) goto _exit_over;
+
+    for (int i = 0; i < n; i += 2) {
+      uint64_t dd1 = zigzag[i];
+      uint64_t dd2 = (i + 1 < n) ? zigzag[i + 1] : 0;
+      uint8_t  flag1 = tsTimestampBytes(dd1);
+      uint8_t  flag2 = tsTimestampBytes(dd2);
+
+      // the output buffer holds limit + 1 bytes, full words are stored as long as there is room for both of them
+      if (pos + CHAR_BYTES + 2 * LONG_BYTES <= limit + 1) {
+        output[pos] = (char)(flag1 | (flag2 << 4));
+        memcpy(output + pos + CHAR_BYTES, &dd1, LONG_BYTES);
+        memcpy(output + pos + CHAR_BYTES + flag1, &dd2, LONG_BYTES);
+      } else {
+        if (pos + CHAR_BYTES + flag1 + flag2 > limit) goto _exit_over;
+        output[pos] = (char)(flag1 | (flag2 << 4));
+        memcpy(output + pos + CHAR_BYTES, &dd1, flag1);
+        memcpy(output + pos + CHAR_BYTES + flag1, &dd2, flag2);
+      }
+      pos += CHAR_BYTES + flag1 + flag2;
+    }
+  }
+
+  // the byte-wise codec gives up as soon as the encoded bytes go beyond the raw size
+  if (pos > limit) goto _exit_over;
+
+  output[0] = 1;  // Means the string is compressed
+  return pos;
+
+_exit_over:
+  output[0] = 0;  // Means the string is not compressed
+  memcpy(output + 1, input, nelements * LONG_BYTES);
+  return nelements * LONG_BYTES + 1;
+}
+
+static int tsDecompressTimestampWordwise(const char *const input, int compressedSize, const int nelements,
+                                         char *const output, int codec) {
+  uint64_t *ostream = (uint64_t *)output;
+  int64_t   value = 0, delta = 0;
+  int       ipos = 1;
+
+  for (int start = 0; start < nelements; start += TS_CODEC_CHUNK) {
+    int n = nelements - start;
+    if (n > TS_CODEC_CHUNK) n = TS_CODEC_CHUNK;
+
+    uint64_t *zigzag = ostream + start;
+    int       i = 0;
+    while (i + 1 < n) {
+      // a regular series is a run of zero flags, take 8 pairs at a time
+      if (i + 16 <= n && ipos + LONG_BYTES <= compressedSize) {
+        uint64_t run;
+        memcpy(&run, input + ipos, LONG_BYTES);
+        if (run == 0) {
+          memset(zigzag + i, 0, 16 * LONG_BYTES);
+          ipos += LONG_BYTES;
+          i += 16;
+          continue;
+        }
+      }
+
+      uint8_t  flags = (uint8_t)input[ipos++];
+      int      nbytes1 = flags & INT8MASK(4);
+      int      nbytes2 = (flags >> 4) & INT8MASK(4);
+      uint64_t dd1 = 0, dd2 = 0;
+
+      if (ipos + 2 * LONG_BYTES <= compressedSize) {
+        memcpy(&dd1, input + ipos, LONG_BYTES);
+        memcpy(&dd2, input + ipos + nbytes1, LONG_BYTES);
+        dd1 &= tsTimestampByteMask[nbytes1];
+        dd2 &= tsTimestampByteMask[nbytes2];
+      } else {
+        memcpy(&dd1, input + ipos, nbytes1);
+        memcpy(&dd2, input + ipos + nbytes1, nbytes2);
+      }
+
+      zigzag[i] = dd1;
+      zigzag[i + 1] = dd2;
+      ipos += nbytes1 + nbytes2;
+      i += 2;
+    }
+
+    if (i < n) {  // the last value of an odd number of values
+      uint8_t  flags = (uint8_t)input[ipos++];
+      int      nbytes1 = flags & INT8MASK(4);
+      uint64_t dd1 = 0;
+      memcpy(&dd1, input + ipos, nbytes1);
+      zigzag[i] = dd1;
+      ipos += nbytes1;
+    }
+
+    if (start == 0) {
+      // the first value is stored as it is: start from a state whose next delta is 0
+      int64_t first = (int64_t)((zigzag[0] >> 1) ^ (0 - (zigzag[0] & 1)));
+      value = first;
+      delta = (int64_t)(0 - (uint64_t)first);
+    }
+
+    tsTimestampPrefix(codec, zigzag, n, &value, &delta);
+  }
+
+  return nelements * LONG_BYTES;
+}
+
+int tsCompressTimestampImp(const char *const input, const int nelements, char *const output) {
+  assert(nelements >= 0);
+  if (nelements == 0) return 0;
+
+  int codec = tsGetCompressCodec();
+  if (codec == TSDB_CODEC_REFERENCE) return tsCompressTimestampReference(input, nelements, output);
+
+  return tsCompressTimestampWordwise(input, nelements, output, codec);
+}
+
+int tsDecompressTimestampImp(const char *const input, int compressedSize, const int nelements, char *const output) {
+  assert(nelements >= 0);
+  if (nelements == 0) return 0;
+
+  int codec = tsGetCompressCodec();
+  if (codec == TSDB_CODEC_REFERENCE || input[0] != 1) return tsDecompressTimestampReference(input, nelements, output);
+
+  return tsDecompressTimestampWordwise(input, compressedSize, nelements, output, codec);
+}
+
 /* --------------------------------------------Double Compression
  * ---------------------------------------------- */
 void encodeDoubleValue(uint64_t diff, uint8_t flag, char *const output, int *const pos) {
@@ -826,7 +1440,7 @@ void encodeDoubleValue(uint64_t diff, uint8_t flag, char *const output, int *con
   }
 }
 
-int tsCompressDoubleImp(const char *const input, const int nelements, char *const output) {
+static int tsCompressDoubleBytes(const char *const input, const int nelements, char *const output) {
   int byte_limit = nelements * DOUBLE_BYTES + 1;
   int opos = 1;
 
@@ -922,7 +1536,7 @@ uint64_t decodeDoubleValue(const char *const input, int *const ipos, uint8_t fla
   return diff;
 }
 
-int tsDecompressDoubleImp(const char *const input, const int nelements, char *const output) {
+static int tsDecompressDoubleBytes(const char *const input, const int nelements, char *const output) {
   // output stream
   double *ostream = (double *)output;
 
@@ -974,7 +1588,7 @@ void encodeFloatValue(uint32_t diff, uint8_t flag, char *const output, int *cons
   }
 }
 
-int tsCompressFloatImp(const char *const input, const int nelements, char *const output) {
+static int tsCompressFloatBytes(const char *const input, const int nelements, char *const output) {
   float *istream = (float *)input;
   int    byte_limit = nelements * FLOAT_BYTES + 1;
   int    opos = 1;
@@ -1069,7 +1683,7 @@ uint32_t decodeFloatValue(const char *const input, int *const ipos, uint8_t flag
   return diff;
 }
 
-int tsDecompressFloatImp(const char *const input, const int nelements, char *const output) {
+static int tsDecompressFloatBytes(const char *const input, const int nelements, char *const output) {
   float *ostream = (float *)output;
 
   if (input[0] == 1) {
@@ -1105,3 +1719,278 @@ int tsDecompressFloatImp(const char *const input, const int nelements, char *con
 
   return nelements * FLOAT_BYTES;
 }
+
+/* --------------------------------------------Float and Double Group Compression
+ * ---------------------------------------------- */
+/*
+ * Values are XORed with the previous one like the byte-wise codec, but the XORs of a group of 8 values share one bit
+ * window: a byte of window width, a byte of trailing zeros if the width is not 0, and then the 8 windows packed into
+ * width bytes. A group of repeated values costs 1 byte, and slowly changing values keep only the bits that change.
+ * Decoding unpacks a whole group with fixed shifts and has no branch per value. The first byte of the column is
+ * FLOAT_STREAM_GROUP, so columns of both codecs can be mixed in a file.
+ */
+#define FLOAT_STREAM_BYTES 0  // the byte-wise codec
+#define FLOAT_STREAM_RAW   1  // not compressed
+#define FLOAT_STREAM_GROUP 2
+#define FLOAT_GROUP_SIZE   8
+
+// pack 8 values of width bits into width bytes, little endian bit order
+static FORCE_INLINE void tsPackGroup(const uint64_t *values, int width, char *const output) {
+  uint64_t acc = 0;
+  int      bits = 0;
+  char *   op = output;
+
+  for (int k = 0; k < FLOAT_GROUP_SIZE; ++k) {
+    acc |= values[k] << bits;
+    if (bits + width >= 64) {
+      memcpy(op, &acc, LONG_BYTES);
+      op += LONG_BYTES;
+      acc = (bits == 0) ? 0 : values[k] >> (64 - bits);
+      bits = bits + width - 64;
+    } else {
+      bits += width;
+    }
+  }
+
+  memcpy(op, &acc, bits / BITS_PER_BYTE);
+}
+
+// unpack 8 values of width bits, 8 bytes beyond the packed bytes are readable
+static FORCE_INLINE void tsUnpackGroup(const char *const input, int width, uint64_t *values) {
+  uint64_t mask = ~((uint64_t)0) >> (64 - width);
+
+  if (width <= 57) {
+    for (int k = 0; k < FLOAT_GROUP_SIZE; ++k) {
+      int      bit = k * width;
+      uint64_t v;
+      memcpy(&v, input + (bit >> 3), LONG_BYTES);
+      values[k] = (v >> (bit & 7)) & mask;
+    }
+  } else {
+    for (int k = 0; k < FLOAT_GROUP_SIZE; ++k) {
+      int      bit = k * width;
+      int      shift = bit & 7;
+      uint64_t v;
+      memcpy(&v, input + (bit >> 3), LONG_BYTES);
+      v >>= shift;
+      if (shift + width > 64) v |= (uint64_t)(uint8_t)input[(bit >> 3) + LONG_BYTES] << (64 - shift);
+      values[k] = v & mask;
+    }
+  }
+}
+
+static int tsCompressDoubleGroup(const char *const input, const int nelements, char *const output) {
+  const uint64_t *istream = (const uint64_t *)input;
+  int             byte_limit = nelements * DOUBLE_BYTES + 1;
+  int             opos = 1;
+  uint64_t        prev_value = 0;
+
+  for (int i = 0; i < nelements; i += FLOAT_GROUP_SIZE) {
+    uint64_t xors[FLOAT_GROUP_SIZE] = {0};
+    uint64_t all = 0;
+    int      n = MIN(FLOAT_GROUP_SIZE, nelements - i);
+
+    for (int k = 0; k < n; ++k) {
+      xors[k] = istream[i + k] ^ prev_value;
+      prev_value = istream[i + k];
+      all |= xors[k];
+    }
+
+    if (all == 0) {
+      if (opos + 1 > byte_limit) goto _copy_and_exit;
+      output[opos++] = 0;
+      continue;
+    }
+
+    int trailing_zeros = BUILDIN_CTZL(all);
+    int width = LONG_BYTES * BITS_PER_BYTE - BUILDIN_CLZL(all) - trailing_zeros;
+    if (opos + 2 + width > byte_limit) goto _copy_and_exit;
+
+    for (int k = 0; k < FLOAT_GROUP_SIZE; ++k) xors[k] >>= trailing_zeros;
+    output[opos++] = (char)width;
+    output[opos++] = (char)trailing_zeros;
+    tsPackGroup(xors, width, output + opos);
+    opos += width;
+  }
+
+  output[0] = FLOAT_STREAM_GROUP;
+  return opos;
+
+_copy_and_exit:
+  output[0] = FLOAT_STREAM_RAW;
+  memcpy(output + 1, input, byte_limit - 1);
+  return byte_limit;
+}
+
+static int tsDecompressDoubleGroup(const char *const input, int compressedSize, const int nelements,
+                                   char *const output) {
+  uint64_t *ostream = (uint64_t *)output;
+  uint64_t  prev_value = 0;
+  int       ipos = 1;
+
+  for (int i = 0; i < nelements; i += FLOAT_GROUP_SIZE) {
+    uint64_t xors[FLOAT_GROUP_SIZE];
+    int      n = MIN(FLOAT_GROUP_SIZE, nelements - i);
+    int      width = (uint8_t)input[ipos++];
+
+    if (width == 0) {
+      for (int k = 0; k < n; ++k) ostream[i + k] = prev_value;
+      continue;
+    }
+
+    int         trailing_zeros = (uint8_t)input[ipos++];
+    const char *packed = input + ipos;
+    char        temp[LONG_BYTES * BITS_PER_BYTE + LONG_BYTES];
+    if (ipos + width + LONG_BYTES > compressedSize) {
+      memset(temp, 0, sizeof(temp));
+      memcpy(temp, packed, width);
+      packed = temp;
+    }
+
+    tsUnpackGroup(packed, width, xors);
+    ipos += width;
+
+    for (int k = 0; k < n; ++k) {
+      prev_value ^= xors[k] << trailing_zeros;
+      ostream[i + k] = prev_value;
+    }
+  }
+
+  return nelements * DOUBLE_BYTES;
+}
+
+static int tsCompressFloatGroup(const char *const input, const int nelements, char *const output) {
+  const uint32_t *istream = (const uint32_t *)input;
+  int             byte_limit = nelements * FLOAT_BYTES + 1;
+  int             opos = 1;
+  uint32_t        prev_value = 0;
+
+  for (int i = 0; i < nelements; i += FLOAT_GROUP_SIZE) {
+    uint64_t xors[FLOAT_GROUP_SIZE] = {0};
+    uint32_t all = 0;
+    int      n = MIN(FLOAT_GROUP_SIZE, nelements - i);
+
+    for (int k = 0; k < n; ++k) {
+      uint32_t x = istream[i + k] ^ prev_value;
+      prev_value = istream[i + k];
+      xors[k] = x;
+      all |= x;
+    }
+
+    if (all == 0) {
+      if (opos + 1 > byte_limit) goto _copy_and_exit;
+      output[opos++] = 0;
+      continue;
+    }
+
+    int trailing_zeros = BUILDIN_CTZ(all);
+    int width = FLOAT_BYTES * BITS_PER_BYTE - BUILDIN_CLZ(all) - trailing_zeros;
+    if (opos + 2 + width > byte_limit) goto _copy_and_exit;
+
+    for (int k = 0; k < FLOAT_GROUP_SIZE; ++k) xors[k] >>= trailing_zeros;
+    output[opos++] = (char)width;
+    output[opos++] = (char)trailing_zeros;
+    tsPackGroup(xors, width, output + opos);
+    opos += width;
+  }
+
+  output[0] = FLOAT_STREAM_GROUP;
+  return opos;
+
+_copy_and_exit:
+  output[0] = FLOAT_STREAM_RAW;
+  memcpy(output + 1, input, byte_limit - 1);
+  return byte_limit;
+}
+
+static int tsDecompressFloatGroup(const char *const input, int compressedSize, const int nelements,
+                                  char *const output) {
+  uint32_t *ostream = (uint32_t *)output;
+  uint32_t  prev_value = 0;
+  int       ipos = 1;
+
+  for (int i = 0; i < nelements; i += FLOAT_GROUP_SIZE) {
+    uint64_t xors[FLOAT_GROUP_SIZE];
+    int      n = MIN(FLOAT_GROUP_SIZE, nelements - i);
+    int      width = (uint8_t)input[ipos++];
+
+    if (width == 0) {
+      for (int k = 0; k < n; ++k) ostream[i + k] = prev_value;
+      continue;
+    }
+
+    int         trailing_zeros = (uint8_t)input[ipos++];
+    const char *packed = input + ipos;
+    char        temp[FLOAT_BYTES * BITS_PER_BYTE + LONG_BYTES];
+    if (ipos + width + LONG_BYTES > compressedSize) {
+      memset(temp, 0, sizeof(temp));
+      memcpy(temp, packed, width);
+      packed = temp;
+    }
+
+    tsUnpackGroup(packed, width, xors);
+    ipos += width;
+
+    for (int k = 0; k < n; ++k) {
+      prev_value ^= (uint32_t)xors[k] << trailing_zeros;
+      ostream[i + k] = prev_value;
+    }
+  }
+
+  return nelements * FLOAT_BYTES;
+}
+
+/*
+ * The codec is chosen by the floatComp option. In the adaptive mode both codecs are tried and the smaller output
+ * is kept, so the choice is made for each column of each block. The group codec is tried in buffer, the scratch of
+ * the caller, and only the byte codec is used if it is not large enough.
+ */
+int tsCompressDoubleImp(const char *const input, const int nelements, char *const output, char *const buffer,
+                        int bufferSize) {
+  if (tsFloatCompression == TSDB_FLOAT_COMP_GROUP) return tsCompressDoubleGroup(input, nelements, output);
+
+  int len = tsCompressDoubleBytes(input, nelements, output);
+  if (tsFloatCompression != TSDB_FLOAT_COMP_ADAPTIVE) return len;
+  if (buffer == NULL || bufferSize < nelements * DOUBLE_BYTES + 1) return len;
+
+  int glen = tsCompressDoubleGroup(input, nelements, buffer);
+  if (glen < len) {
+    memcpy(output, buffer, glen);
+    len = glen;
+  }
+
+  return len;
+}
+
+int tsDecompressDoubleImp(const char *const input, int compressedSize, const int nelements, char *const output) {
+  if (nelements > 0 && input[0] == FLOAT_STREAM_GROUP) {
+    return tsDecompressDoubleGroup(input, compressedSize, nelements, output);
+  }
+
+  return tsDecompressDoubleBytes(input, nelements, output);
+}
+
+int tsCompressFloatImp(const char *const input, const int nelements, char *const output, char *const buffer,
+                       int bufferSize) {
+  if (tsFloatCompression == TSDB_FLOAT_COMP_GROUP) return tsCompressFloatGroup(input, nelements, output);
+
+  int len = tsCompressFloatBytes(input, nelements, output);
+  if (tsFloatCompression != TSDB_FLOAT_COMP_ADAPTIVE) return len;
+  if (buffer == NULL || bufferSize < nelements * FLOAT_BYTES + 1) return len;
+
+  int glen = tsCompressFloatGroup(input, nelements, buffer);
+  if (glen < len) {
+    memcpy(output, buffer, glen);
+    len = glen;
+  }
+
+  return len;
+}
+
+int tsDecompressFloatImp(const char *const input, int compressedSize, const int nelements, char *const output) {
+  if (nelements > 0 && input[0] == FLOAT_STREAM_GROUP) {
+    return tsDecompressFloatGroup(input, compressedSize, nelements, output);
+  }
+
+  return tsDecompressFloatBytes(input, nelements, output);
+}
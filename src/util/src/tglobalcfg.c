@@ -74,6 +74,14 @@ int tsMetricMetaKeepTimer = 600;  // second
 
 float tsNumOfThreadsPerCore = 1.0;
 float tsRatioOfQueryThreads = 0.5;
+int   tsAsyncRead = 0;          // 0: read blocks in query thread, 1: io_uring with read thread fallback, 2: read threads
+int   tsReadAheadBlocks = 16;   // max number of file blocks read ahead for a super table query
+int   tsNumOfReadThreads = 4;   // threads to read file blocks ahead, 0 means io_uring only
+int   tsBlockCacheSize = 64;    // MB, decompressed file block columns shared by queries, 0 means disabled
+int   tsQueryParallelism = 1;   // max number of query threads to scan one super table query, 1 means disabled
+int   tsQueryMemBudget = 0;     // MB, memory reserved by all queries of the dnode, 0 means unlimited
+int   tsQueryMemQuota = 0;      // MB, memory of a single query, 0 means unlimited
+int   tsQueryMemWaitTime = 5000;  // ms, a query waiting for the budget longer than it is rejected
 char  tsPublicIp[TSDB_IPv4ADDR_LEN] = {0};
 char  tsPrivateIp[TSDB_IPv4ADDR_LEN] = {0};
 short tsNumOfVnodesPerCore = 8;
@@ -88,6 +96,7 @@ int tsSessionsPerVnode = 1000;
 
 int tsCacheBlockSize = 16384;  // 256 columns
 int tsAverageCacheBlocks = TSDB_DEFAULT_AVG_BLOCKS;
+int tsCacheShards = 0;  // shards of the cache blocks of a vnode, 0 means one for each core
 /**
  * Change the meaning of affected rows:
  * 0: affected rows not include those duplicate records
@@ -97,11 +106,20 @@ short tsAffectedRowsMod = 0;
 
 int   tsRowsInFileBlock = 4096;
 float tsFileBlockMinPercent = 0.05;
+int   tsCompactInterval = 0;  // seconds, interval to merge small file blocks of idle vnodes, 0 means disabled
+int   tsCompactBlocksPerSec = 1000;  // max number of small file blocks merged per second, 0 means no limit
 
 short tsNumOfBlocksPerMeter = 100;
 short tsCommitTime = 3600;  // seconds
+int   tsNumOfCommitThreads = 4;  // threads to compress file blocks during commit, 0 means compressing in commit thread
+int   tsNumOfCommitWorkers = 4;  // threads to commit vnodes, 0 means creating a thread for each commit
+int   tsMaxCommitsPerDir = 2;    // max number of vnodes committing to one data directory at the same time
+int   tsImportBufferRows = 100000;  // max rows of out-of-order imports buffered per table, 0 means importing right away
 short tsCommitLog = 1;
+int   tsCommitLogSyncDelay = 10;         // ms, max time a record waits for other records to join its sync batch
+int   tsCommitLogSyncBytes = 1048576;    // a batch is synced right away once it reaches this size
 short tsCompression = TSDB_MAX_COMPRESSION_LEVEL;
+int   tsFloatCompression = 0;  // codec of float and double columns, 0: byte-wise XOR, 1: grouped XOR, 2: smaller one
 short tsDaysPerFile = 10;
 int   tsDaysToKeep = 3650;
 int   tsReplications = TSDB_REPLICA_MIN_NUM;
@@ -150,6 +168,25 @@ int tsMaxNumOfOrderedResults = 100000;
  */
 int tsCompressMsgSize = -1;
 
+/*
+ * file blocks of results returned in one retrieve of projection queries on a table. The client asks for this window
+ * and the server grants at most its own value, so the next window is produced while the previous one is in flight.
+ */
+int tsRetrieveWindow = 4;
+
+/*
+ * threads to parse a data file of "insert into ... file", rows of different files are sent to vnodes concurrently.
+ * 1 parses and sends the files one by one in the calling thread.
+ */
+int tsImportThreads = 4;
+
+/*
+ * streams to merge the results of vnodes in the client, each merges the results of a part of the vnodes and the
+ * application thread merges their outputs. Streams of all queries run on a pool with a thread per core. 1 merges all
+ * results in the application thread. A connection may change its own value by "alter local localMergeThreads".
+ */
+int tsLocalMergeThreads = 1;
+
 // use UDP by default[option: udp, tcp]
 char tsSocketType[4] = "udp";
 
@@ -529,6 +566,30 @@ static void doInitGlobalConfig() {
   tsInitConfigOption(cfg++, "ratioOfQueryThreads", &tsRatioOfQueryThreads, TSDB_CFG_VTYPE_FLOAT,
                      TSDB_CFG_CTYPE_B_CONFIG,
                      0.1, 0.9, 0, TSDB_CFG_UTYPE_NONE);
+  tsInitConfigOption(cfg++, "asyncRead", &tsAsyncRead, TSDB_CFG_VTYPE_INT,
+                     TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW,
+                     0, 2, 0, TSDB_CFG_UTYPE_NONE);
+  tsInitConfigOption(cfg++, "readAheadBlocks", &tsReadAheadBlocks, TSDB_CFG_VTYPE_INT,
+                     TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW,
+                     0, 1024, 0, TSDB_CFG_UTYPE_NONE);
+  tsInitConfigOption(cfg++, "numOfReadThreads", &tsNumOfReadThreads, TSDB_CFG_VTYPE_INT,
+                     TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW,
+                     0, 64, 0, TSDB_CFG_UTYPE_NONE);
+  tsInitConfigOption(cfg++, "blockCacheSize", &tsBlockCacheSize, TSDB_CFG_VTYPE_INT,
+                     TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW,
+                     0, 1048576, 0, TSDB_CFG_UTYPE_MB);
+  tsInitConfigOption(cfg++, "queryParallelism", &tsQueryParallelism, TSDB_CFG_VTYPE_INT,
+                     TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW,
+                     1, 64, 0, TSDB_CFG_UTYPE_NONE);
+  tsInitConfigOption(cfg++, "queryMemBudget", &tsQueryMemBudget, TSDB_CFG_VTYPE_INT,
+                     TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW,
+                     0, 1048576, 0, TSDB_CFG_UTYPE_MB);
+  tsInitConfigOption(cfg++, "queryMemQuota", &tsQueryMemQuota, TSDB_CFG_VTYPE_INT,
+                     TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW,
+                     0, 1048576, 0, TSDB_CFG_UTYPE_MB);
+  tsInitConfigOption(cfg++, "queryMemWaitTime", &tsQueryMemWaitTime, TSDB_CFG_VTYPE_INT,
+                     TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW,
+                     1, 60000, 0, TSDB_CFG_UTYPE_MS);
   tsInitConfigOption(cfg++, "numOfVnodesPerCore", &tsNumOfVnodesPerCore, TSDB_CFG_VTYPE_SHORT,
                      TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW,
                      1, 64, 0, TSDB_CFG_UTYPE_NONE);
@@ -541,12 +602,33 @@ static void doInitGlobalConfig() {
   tsInitConfigOption(cfg++, "cache", &tsCacheBlockSize, TSDB_CFG_VTYPE_INT,
                      TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW,
                      100, 1048576, 0, TSDB_CFG_UTYPE_BYTE);
+  tsInitConfigOption(cfg++, "cacheShards", &tsCacheShards, TSDB_CFG_VTYPE_INT,
+                     TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW,
+                     0, 64, 0, TSDB_CFG_UTYPE_NONE);
   tsInitConfigOption(cfg++, "rows", &tsRowsInFileBlock, TSDB_CFG_VTYPE_INT,
                      TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW,
                      200, 1048576, 0, TSDB_CFG_UTYPE_NONE);
   tsInitConfigOption(cfg++, "fileBlockMinPercent", &tsFileBlockMinPercent, TSDB_CFG_VTYPE_FLOAT,
                      TSDB_CFG_CTYPE_B_CONFIG,
                      0, 1.0, 0, TSDB_CFG_UTYPE_NONE);
+  tsInitConfigOption(cfg++, "numOfCommitThreads", &tsNumOfCommitThreads, TSDB_CFG_VTYPE_INT,
+                     TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW,
+                     0, 64, 0, TSDB_CFG_UTYPE_NONE);
+  tsInitConfigOption(cfg++, "numOfCommitWorkers", &tsNumOfCommitWorkers, TSDB_CFG_VTYPE_INT,
+                     TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW,
+                     0, 64, 0, TSDB_CFG_UTYPE_NONE);
+  tsInitConfigOption(cfg++, "maxCommitsPerDir", &tsMaxCommitsPerDir, TSDB_CFG_VTYPE_INT,
+                     TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW,
+                     1, 64, 0, TSDB_CFG_UTYPE_NONE);
+  tsInitConfigOption(cfg++, "importBufferRows", &tsImportBufferRows, TSDB_CFG_VTYPE_INT,
+                     TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW,
+                     0, 10000000, 0, TSDB_CFG_UTYPE_NONE);
+  tsInitConfigOption(cfg++, "compactInterval", &tsCompactInterval, TSDB_CFG_VTYPE_INT,
+                     TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW,
+                     0, 864000, 0, TSDB_CFG_UTYPE_SECOND);
+  tsInitConfigOption(cfg++, "compactBlocksPerSec", &tsCompactBlocksPerSec, TSDB_CFG_VTYPE_INT,
+                     TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW,
+                     0, 1000000, 0, TSDB_CFG_UTYPE_NONE);
   tsInitConfigOption(cfg++, "ablocks", &tsAverageCacheBlocks, TSDB_CFG_VTYPE_INT,
                      TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW,
                      TSDB_MIN_AVG_BLOCKS, TSDB_MAX_AVG_BLOCKS, 0, TSDB_CFG_UTYPE_NONE);
@@ -651,10 +733,19 @@ static void doInitGlobalConfig() {
   
   tsInitConfigOption(cfg++, "clog", &tsCommitLog, TSDB_CFG_VTYPE_SHORT,
                      TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW,
-                     0, 1, 0, TSDB_CFG_UTYPE_NONE);
+                     0, TSDB_COMMIT_LOG_SYNC, 0, TSDB_CFG_UTYPE_NONE);
+  tsInitConfigOption(cfg++, "clogSyncDelay", &tsCommitLogSyncDelay, TSDB_CFG_VTYPE_INT,
+                     TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW,
+                     0, 1000, 0, TSDB_CFG_UTYPE_MS);
+  tsInitConfigOption(cfg++, "clogSyncBytes", &tsCommitLogSyncBytes, TSDB_CFG_VTYPE_INT,
+                     TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW,
+                     4096, 104857600, 0, TSDB_CFG_UTYPE_BYTE);
   tsInitConfigOption(cfg++, "comp", &tsCompression, TSDB_CFG_VTYPE_SHORT,
                      TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW,
                      0, 2, 0, TSDB_CFG_UTYPE_NONE);
+  tsInitConfigOption(cfg++, "floatComp", &tsFloatCompression, TSDB_CFG_VTYPE_INT,
+                     TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW,
+                     0, 2, 0, TSDB_CFG_UTYPE_NONE);
 
   // database configs
   tsInitConfigOption(cfg++, "days", &tsDaysPerFile, TSDB_CFG_VTYPE_SHORT,
@@ -686,6 +777,18 @@ static void doInitGlobalConfig() {
   tsInitConfigOption(cfg++, "compressMsgSize", &tsCompressMsgSize, TSDB_CFG_VTYPE_INT,
                      TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_CLIENT | TSDB_CFG_CTYPE_B_SHOW,
                      -1, 10000000, 0, TSDB_CFG_UTYPE_NONE);
+
+  tsInitConfigOption(cfg++, "retrieveWindow", &tsRetrieveWindow, TSDB_CFG_VTYPE_INT,
+                     TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_CLIENT | TSDB_CFG_CTYPE_B_SHOW,
+                     1, 64, 0, TSDB_CFG_UTYPE_NONE);
+
+  tsInitConfigOption(cfg++, "importThreads", &tsImportThreads, TSDB_CFG_VTYPE_INT,
+                     TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_CLIENT | TSDB_CFG_CTYPE_B_SHOW,
+                     1, 64, 0, TSDB_CFG_UTYPE_NONE);
+
+  tsInitConfigOption(cfg++, "localMergeThreads", &tsLocalMergeThreads, TSDB_CFG_VTYPE_INT,
+                     TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_CLIENT | TSDB_CFG_CTYPE_B_SHOW,
+                     1, 64, 0, TSDB_CFG_UTYPE_NONE);
   
   tsInitConfigOption(cfg++, "maxSQLLength", &tsMaxSQLStringLen, TSDB_CFG_VTYPE_INT,
                      TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_CLIENT | TSDB_CFG_CTYPE_B_SHOW,
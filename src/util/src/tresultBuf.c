@@ -60,6 +60,26 @@ int32_t getNumOfResultBufGroupId(SQueryDiskbasedResultBuf* pResultBuf) { return
 
 int32_t getResBufSize(SQueryDiskbasedResultBuf* pResultBuf) { return pResultBuf->totalBufSize; }
 
+int64_t spillResultBufPages(SQueryDiskbasedResultBuf* pResultBuf) {
+  if (pResultBuf->totalBufSize < pResultBuf->spilledBufSize + pResultBuf->spilledBufSize / 4) {
+    return 0;
+  }
+
+  if (msync(pResultBuf->pBuf, pResultBuf->totalBufSize, MS_SYNC) != 0) {
+    pError("failed to sync tmp file: %s. %s", pResultBuf->path, strerror(errno));
+    return 0;
+  }
+
+  // the mapping is shared with the file, dropped pages are read from the file again on the next access
+  madvise(pResultBuf->pBuf, pResultBuf->totalBufSize, MADV_DONTNEED);
+  posix_fadvise(pResultBuf->fd, 0, pResultBuf->totalBufSize, POSIX_FADV_DONTNEED);
+
+  int64_t spilled = pResultBuf->totalBufSize - pResultBuf->spilledBufSize;
+  pResultBuf->spilledBufSize = pResultBuf->totalBufSize;
+  pTrace("tmp file: %s is spilled, %" PRId64 " bytes", pResultBuf->path, spilled);
+  return spilled;
+}
+
 static int32_t extendDiskFileSize(SQueryDiskbasedResultBuf* pResultBuf, int32_t numOfPages) {
   assert(pResultBuf->numOfPages * DEFAULT_INTERN_BUF_SIZE == pResultBuf->totalBufSize);
 
@@ -361,10 +361,11 @@ tSkipListNode *tSkipListPut(tSkipList *pSkipList, void *pData, tSkipListKey *pKe
   }
 
   // if the skiplist does not allowed identical key inserted, the new data will be discarded.
-  if ((insertIdenticalKey == 0) && forward[0] != &pSkipList->pHead &&
-      (pSkipList->comparator(&forward[0]->key, pKey) == 0)) {
+  // forward[0] is the last node with a smaller key, so the identical one, if any, is next to it
+  tSkipListNode *pNext = forward[0]->pForward[0];
+  if ((insertIdenticalKey == 0) && pNext != NULL && (pSkipList->comparator(&pNext->key, pKey) == 0)) {
     pthread_rwlock_unlock(&pSkipList->lock);
-    return forward[0];
+    return pNext;
   }
 
   int32_t nLevel = getSkipListNodeLevel(pSkipList);
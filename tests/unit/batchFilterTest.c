@@ -0,0 +1,297 @@
+/*
+ * Compare the row by row filter of a query, the loop of vnodeDoFilterData, with vnodeBatchFilterData:
+ *   check : random filters on every numeric type, with null and extreme values in the data and bounds out of the
+ *           type range, must select the same rows
+ *   bench : "where val > x and status = y" on int and tinyint columns, the time to filter all blocks
+ */
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "testHarness.h"
+#include "vnode.h"
+#include "vnodeDataFilterFunc.h"
+
+typedef struct {
+  int32_t rows;
+  int32_t blocks;
+  int32_t rounds;
+  int32_t checks;
+} ProArgs;
+
+static ProArgs arguments;
+
+static const int16_t checkType[] = {TSDB_DATA_TYPE_BOOL,   TSDB_DATA_TYPE_TINYINT, TSDB_DATA_TYPE_SMALLINT,
+                                    TSDB_DATA_TYPE_INT,    TSDB_DATA_TYPE_BIGINT,  TSDB_DATA_TYPE_FLOAT,
+                                    TSDB_DATA_TYPE_DOUBLE, TSDB_DATA_TYPE_TIMESTAMP};
+static const int16_t checkBytes[] = {1, 1, 2, 4, 8, 4, 8, 8};
+
+void parseArg(int argc, char *argv[]) {
+  arguments.rows = 4096;
+  arguments.blocks = 2048;
+  arguments.rounds = 5;
+  arguments.checks = 20000;
+
+  SThOption options[] = {TH_INT_OPTION("-rows", &arguments.rows), TH_INT_OPTION("-blocks", &arguments.blocks),
+                         TH_INT_OPTION("-rounds", &arguments.rounds), TH_INT_OPTION("-checks", &arguments.checks)};
+  thParseArgs(argc, argv, options, tListLen(options));
+}
+
+// the same as vnodeDoFilterData
+static bool rowFilterData(SQuery *pQuery, int32_t elemPos) {
+  for (int32_t k = 0; k < pQuery->numOfFilterCols; ++k) {
+    SSingleColumnFilterInfo *pFilterInfo = &pQuery->pFilterInfo[k];
+    char *                   pElem = pFilterInfo->pData + pFilterInfo->info.data.bytes * elemPos;
+
+    if (isNull(pElem, pFilterInfo->info.data.type)) {
+      return false;
+    }
+
+    bool qualified = false;
+    for (int32_t j = 0; j < pFilterInfo->numOfFilters; ++j) {
+      SColumnFilterElem *pFilterElem = &pFilterInfo->pFilters[j];
+      if (pFilterElem->fp(pFilterElem, pElem, pElem)) {
+        qualified = true;
+        break;
+      }
+    }
+
+    if (!qualified) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// the same choice of the filter function as vnodeCreateFilterInfo
+static void setFilter(SColumnFilterElem *pElem, int16_t type, int16_t bytes) {
+  int32_t          lower = pElem->filterInfo.lowerRelOptr;
+  int32_t          upper = pElem->filterInfo.upperRelOptr;
+  __filter_func_t *rangeFilterArray = vnodeGetRangeFilterFuncArray(type);
+  __filter_func_t *filterArray = vnodeGetValueFilterFuncArray(type);
+
+  if (lower != TSDB_RELATION_INVALID && upper != TSDB_RELATION_INVALID) {
+    if (lower == TSDB_RELATION_LARGE_EQUAL) {
+      pElem->fp = rangeFilterArray[(upper == TSDB_RELATION_LESS_EQUAL) ? 4 : 2];
+    } else {
+      pElem->fp = rangeFilterArray[(upper == TSDB_RELATION_LESS_EQUAL) ? 3 : 1];
+    }
+  } else {
+    pElem->fp = filterArray[(lower != TSDB_RELATION_INVALID) ? lower : upper];
+  }
+
+  pElem->bytes = bytes;
+  vnodeInitBatchFilter(pElem, type);
+}
+
+static int64_t randomInteger(int16_t type) {
+  static const int64_t extremes[] = {INT8_MIN, INT8_MAX, INT16_MIN, INT16_MAX, INT32_MIN, INT32_MAX,
+                                     INT64_MIN, INT64_MAX, 0, 1, -1, 2};
+  switch (rand() % 4) {
+    case 0:  return extremes[rand() % 12];
+    case 1:  return extremes[rand() % 12] + (rand() % 3) - 1;
+    default: return (int64_t)(rand() % 300) - 150;
+  }
+}
+
+static double randomDouble() {
+  static const double extremes[] = {0.0, -0.0, 1.5, FLT_MAX, -FLT_MAX, DBL_MAX, -DBL_MAX, INFINITY, -INFINITY,
+                                    FLT_EPSILON, 1e-40, 16777217.0};
+  switch (rand() % 4) {
+    case 0:  return extremes[rand() % 12];
+    case 1:  return (double)(rand() % 300 - 150) / 8.0 + 1e-9;
+    default: return (double)(rand() % 300 - 150) / 8.0;
+  }
+}
+
+static void fillColumn(char *pData, int16_t type, int32_t rows) {
+  for (int32_t i = 0; i < rows; ++i) {
+    if (rand() % 16 == 0) {
+      setNull(pData + i * tDataTypeDesc[type].nSize, type, tDataTypeDesc[type].nSize);
+      continue;
+    }
+
+    switch (type) {
+      case TSDB_DATA_TYPE_BOOL:      ((int8_t *)pData)[i] = (int8_t)(rand() % 2); break;
+      case TSDB_DATA_TYPE_TINYINT:   ((int8_t *)pData)[i] = (int8_t)randomInteger(type); break;
+      case TSDB_DATA_TYPE_SMALLINT:  ((int16_t *)pData)[i] = (int16_t)randomInteger(type); break;
+      case TSDB_DATA_TYPE_INT:       ((int32_t *)pData)[i] = (int32_t)randomInteger(type); break;
+      case TSDB_DATA_TYPE_BIGINT:
+      case TSDB_DATA_TYPE_TIMESTAMP: ((int64_t *)pData)[i] = randomInteger(type); break;
+      case TSDB_DATA_TYPE_FLOAT:     ((float *)pData)[i] = (float)randomDouble(); break;
+      case TSDB_DATA_TYPE_DOUBLE:    ((double *)pData)[i] = randomDouble(); break;
+    }
+  }
+}
+
+static void randomFilter(SColumnFilterElem *pElem, int16_t type) {
+  static const int16_t lowerOptr[] = {TSDB_RELATION_LARGE, TSDB_RELATION_LARGE_EQUAL};
+  static const int16_t upperOptr[] = {TSDB_RELATION_LESS, TSDB_RELATION_LESS_EQUAL};
+  bool                 isFloat = (type == TSDB_DATA_TYPE_FLOAT || type == TSDB_DATA_TYPE_DOUBLE);
+
+  memset(pElem, 0, sizeof(SColumnFilterElem));
+  SColumnFilterInfo *pInfo = &pElem->filterInfo;
+
+  if (rand() % 3 == 0) {
+    pInfo->lowerRelOptr = lowerOptr[rand() % 2];
+    pInfo->upperRelOptr = upperOptr[rand() % 2];
+  } else {
+    int16_t optr = (int16_t)(TSDB_RELATION_LESS + rand() % 6);
+    if (rand() % 2) {
+      pInfo->lowerRelOptr = optr;
+    } else {
+      pInfo->upperRelOptr = optr;
+    }
+  }
+
+  if (isFloat) {
+    pInfo->lowerBndd = randomDouble();
+    pInfo->upperBndd = randomDouble();
+  } else {
+    pInfo->lowerBndi = randomInteger(type);
+    pInfo->upperBndi = randomInteger(type);
+  }
+}
+
+static void check() {
+  int32_t rows = arguments.rows;
+  char *  pData[2] = {malloc((size_t)rows * 8), malloc((size_t)rows * 8)};
+  uint8_t *pSel = malloc((size_t)rows);
+
+  SColumnFilterElem       filters[2][3];
+  SSingleColumnFilterInfo filterInfo[2];
+  SQuery                  query;
+  memset(&query, 0, sizeof(query));
+  query.pFilterInfo = filterInfo;
+
+  int64_t selected = 0;
+  for (int32_t c = 0; c < arguments.checks; ++c) {
+    memset(filterInfo, 0, sizeof(filterInfo));
+    query.numOfFilterCols = 1 + rand() % 2;
+
+    for (int32_t k = 0; k < query.numOfFilterCols; ++k) {
+      int32_t t = rand() % (int32_t)(sizeof(checkType) / sizeof(checkType[0]));
+      filterInfo[k].info.data.type = checkType[t];
+      filterInfo[k].info.data.bytes = checkBytes[t];
+      filterInfo[k].numOfFilters = 1 + rand() % 3;
+      filterInfo[k].pFilters = filters[k];
+      filterInfo[k].pData = pData[k];
+
+      fillColumn(pData[k], checkType[t], rows);
+      for (int32_t f = 0; f < filterInfo[k].numOfFilters; ++f) {
+        randomFilter(&filters[k][f], checkType[t]);
+        setFilter(&filters[k][f], checkType[t], checkBytes[t]);
+      }
+    }
+
+    int32_t start = rand() % 64;
+    int32_t num = rows - start - rand() % 64;
+    int32_t numOfSel = vnodeBatchFilterData(&query, start, num, pSel);
+
+    int32_t expected = 0;
+    for (int32_t i = 0; i < num; ++i) {
+      bool qualified = rowFilterData(&query, start + i);
+      expected += qualified;
+
+      if (qualified != (pSel[i] != 0)) {
+        SColumnFilterInfo *pInfo = &filterInfo[0].pFilters[0].filterInfo;
+        TH_CHECK(false, "check %d: row %d mismatch, type:%d optr:%d/%d", c, start + i, filterInfo[0].info.data.type,
+                 pInfo->lowerRelOptr, pInfo->upperRelOptr);
+        break;
+      }
+    }
+
+    TH_CHECK(numOfSel == expected, "check %d: %d rows qualified, expect:%d", c, numOfSel, expected);
+
+    selected += expected;
+  }
+
+  printf("check: %d filters, %.2f%% rows qualified\n", arguments.checks,
+         selected * 100.0 / ((double)arguments.checks * rows));
+
+  free(pData[0]);
+  free(pData[1]);
+  free(pSel);
+}
+
+static void bench() {
+  int32_t  rows = arguments.rows;
+  int32_t *val = malloc(sizeof(int32_t) * rows * arguments.blocks);
+  int8_t * status = malloc((size_t)rows * arguments.blocks);
+  uint8_t *pSel = malloc((size_t)rows);
+
+  for (int64_t i = 0; i < (int64_t)rows * arguments.blocks; ++i) {
+    val[i] = rand() % 10000;
+    status[i] = (int8_t)(rand() % 4);
+  }
+
+  SColumnFilterElem       filters[2];
+  SSingleColumnFilterInfo filterInfo[2];
+  SQuery                  query;
+  memset(&query, 0, sizeof(query));
+  memset(filters, 0, sizeof(filters));
+  memset(filterInfo, 0, sizeof(filterInfo));
+
+  filters[0].filterInfo.lowerRelOptr = TSDB_RELATION_LARGE;
+  filters[0].filterInfo.lowerBndi = 5000;
+  setFilter(&filters[0], TSDB_DATA_TYPE_INT, 4);
+  filters[1].filterInfo.lowerRelOptr = TSDB_RELATION_EQUAL;
+  filters[1].filterInfo.lowerBndi = 1;
+  setFilter(&filters[1], TSDB_DATA_TYPE_TINYINT, 1);
+
+  filterInfo[0].info.data.type = TSDB_DATA_TYPE_INT;
+  filterInfo[0].info.data.bytes = 4;
+  filterInfo[1].info.data.type = TSDB_DATA_TYPE_TINYINT;
+  filterInfo[1].info.data.bytes = 1;
+  for (int32_t k = 0; k < 2; ++k) {
+    filterInfo[k].numOfFilters = 1;
+    filterInfo[k].pFilters = &filters[k];
+  }
+
+  query.numOfFilterCols = 2;
+  query.pFilterInfo = filterInfo;
+
+  int64_t rowUs = 0, batchUs = 0, rowSum = 0, batchSum = 0;
+  for (int32_t r = 0; r < arguments.rounds; ++r) {
+    int64_t st = thGetTimeUs();
+    for (int32_t b = 0; b < arguments.blocks; ++b) {
+      filterInfo[0].pData = (char *)(val + (int64_t)b * rows);
+      filterInfo[1].pData = (char *)(status + (int64_t)b * rows);
+      for (int32_t i = 0; i < rows; ++i) {
+        rowSum += rowFilterData(&query, i);
+      }
+    }
+    rowUs += thGetTimeUs() - st;
+
+    st = thGetTimeUs();
+    for (int32_t b = 0; b < arguments.blocks; ++b) {
+      filterInfo[0].pData = (char *)(val + (int64_t)b * rows);
+      filterInfo[1].pData = (char *)(status + (int64_t)b * rows);
+      batchSum += vnodeBatchFilterData(&query, 0, rows, pSel);
+    }
+    batchUs += thGetTimeUs() - st;
+  }
+
+  double total = (double)rows * arguments.blocks * arguments.rounds;
+  printf("bench: val > 5000 and status = 1, %d blocks of %d rows\n", arguments.blocks, rows);
+  printf("  row   : %8.2f Mrows/s\n", total / rowUs);
+  printf("  batch : %8.2f Mrows/s\n", total / batchUs);
+  TH_CHECK(rowSum == batchSum, "bench: qualified rows mismatch");
+
+  free(val);
+  free(status);
+  free(pSel);
+}
+
+int main(int argc, char *argv[]) {
+  parseArg(argc, argv);
+  srand(1);
+
+  check();
+  bench();
+  return thReport("batchFilterTest");
+}
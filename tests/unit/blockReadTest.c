@@ -0,0 +1,323 @@
+/*
+ * Compare the engines to read file blocks of a query:
+ *   mmap  : the mmap window with MAP_POPULATE used by the query before, remapped when a block is out of the window
+ *   sync  : lseek and read in the query thread, one block after another
+ *   pool  : blocks read ahead by the read thread pool
+ *   uring : blocks read ahead by io_uring
+ *
+ * The engines marked with * read only the head of each block, then the parts of it given after the head is read.
+ *
+ * A data file with blocks of random size is created, and blocks are visited in a shuffled order, as a super table
+ * query visits blocks of different tables sorted by time rather than by file offset.
+ *
+ * At last two readers are used in turn by one thread, as queries scheduled on the same query thread, and each of them
+ * must get its own blocks.
+ */
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "testHarness.h"
+#include "tutil.h"
+#include "vnodeBlockRead.h"
+
+typedef struct {
+  char    file[256];
+  int32_t numOfBlocks;
+  int32_t blockSize;
+  int32_t depth;
+  int32_t threads;
+  int32_t windowSize;
+  int32_t create;
+} ProArgs;
+
+static ProArgs arguments;
+
+void parseArg(int argc, char *argv[]) {
+  strcpy(arguments.file, "./blockRead.data");
+  arguments.numOfBlocks = 20000;
+  arguments.blockSize = 64 * 1024;
+  arguments.depth = 16;
+  arguments.threads = 4;
+  arguments.windowSize = 4 * 1024 * 1024;
+  arguments.create = 1;
+
+  SThOption options[] = {
+      TH_STR_OPTION("-file", arguments.file),          TH_INT_OPTION("-blocks", &arguments.numOfBlocks),
+      TH_INT_OPTION("-blockSize", &arguments.blockSize), TH_INT_OPTION("-depth", &arguments.depth),
+      TH_INT_OPTION("-threads", &arguments.threads),     TH_INT_OPTION("-window", &arguments.windowSize),
+      TH_INT_OPTION("-create", &arguments.create)};
+  thParseArgs(argc, argv, options, tListLen(options));
+}
+
+static SBlockReadReq *createBlocks(int fd) {
+  SBlockReadReq *pReqs = malloc(sizeof(SBlockReadReq) * arguments.numOfBlocks);
+  char *         buf = malloc((size_t)arguments.blockSize * 2);
+  int64_t        offset = 0;
+
+  for (int32_t i = 0; i < arguments.numOfBlocks; ++i) {
+    pReqs[i].fd = fd;
+    pReqs[i].offset = offset;
+    pReqs[i].len = arguments.blockSize / 2 + rand() % arguments.blockSize;
+    offset += pReqs[i].len;
+  }
+
+  if (arguments.create) {
+    for (int32_t i = 0; i < arguments.numOfBlocks; ++i) {
+      memset(buf, i & 0xFF, (size_t)pReqs[i].len);
+      if (pwrite(fd, buf, (size_t)pReqs[i].len, pReqs[i].offset) != pReqs[i].len) {
+        fprintf(stderr, "failed to write test file:%s\n", arguments.file);
+        exit(EXIT_FAILURE);
+      }
+    }
+    fsync(fd);
+  }
+
+  free(buf);
+
+  // shuffle the visit order
+  for (int32_t i = arguments.numOfBlocks - 1; i > 0; --i) {
+    int32_t       j = rand() % (i + 1);
+    SBlockReadReq tmp = pReqs[i];
+    pReqs[i] = pReqs[j];
+    pReqs[j] = tmp;
+  }
+
+  return pReqs;
+}
+
+static void dropCache(int fd) { posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED); }
+
+static int64_t checkBlock(SBlockReadReq *pReq, char *buf) {
+  // the block is filled with its index, only make sure the read is not optimized out
+  return (uint8_t)buf[0] + (uint8_t)buf[pReq->len - 1];
+}
+
+static int64_t readByMMapWindow(SBlockReadReq *pReqs, char *buf) {
+  int      fd = pReqs[0].fd;
+  int64_t  windowSize = arguments.windowSize;
+  int64_t  windowOffset = 0;
+  char *   pWindow = MAP_FAILED;
+  int64_t  sum = 0;
+
+  for (int32_t i = 0; i < arguments.numOfBlocks; ++i) {
+    SBlockReadReq *pReq = &pReqs[i];
+    int64_t        offset = pReq->offset;
+    int32_t        copied = 0;
+
+    while (copied < pReq->len) {
+      if (pWindow == MAP_FAILED || offset < windowOffset || offset >= windowOffset + windowSize) {
+        if (pWindow != MAP_FAILED) munmap(pWindow, (size_t)windowSize);
+
+        windowOffset = (offset / windowSize) * windowSize;
+        pWindow = mmap(NULL, (size_t)windowSize, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, windowOffset);
+        if (pWindow == MAP_FAILED) {
+          fprintf(stderr, "failed to mmap test file\n");
+          exit(EXIT_FAILURE);
+        }
+      }
+
+      int32_t len = pReq->len - copied;
+      if (offset + len > windowOffset + windowSize) len = (int32_t)(windowOffset + windowSize - offset);
+
+      memcpy(buf + copied, pWindow + (offset - windowOffset), (size_t)len);
+      copied += len;
+      offset += len;
+    }
+
+    sum += checkBlock(pReq, buf);
+  }
+
+  if (pWindow != MAP_FAILED) munmap(pWindow, (size_t)windowSize);
+  return sum;
+}
+
+static int64_t readBySync(SBlockReadReq *pReqs, char *buf) {
+  int64_t sum = 0;
+
+  for (int32_t i = 0; i < arguments.numOfBlocks; ++i) {
+    SBlockReadReq *pReq = &pReqs[i];
+    lseek(pReq->fd, pReq->offset, SEEK_SET);
+    if (read(pReq->fd, buf, (size_t)pReq->len) != pReq->len) {
+      fprintf(stderr, "failed to read block:%d\n", i);
+      exit(EXIT_FAILURE);
+    }
+
+    sum += checkBlock(pReq, buf);
+  }
+
+  return sum;
+}
+
+// only the head and the tail of a block are read, and a part in the middle that is not copied
+#define BLOCK_HEAD_SIZE 64
+#define BLOCK_TAIL_SIZE 64
+
+static int32_t getTailRanges(void *param, int32_t seq, const char *head, SBlockReadRange *pRanges) {
+  SBlockReadReq *pReq = (SBlockReadReq *)param + seq;
+
+  pRanges[0].offset = pReq->offset + pReq->len / 2;
+  pRanges[0].len = 16;
+  pRanges[1].offset = pReq->offset + pReq->len - BLOCK_TAIL_SIZE;
+  pRanges[1].len = BLOCK_TAIL_SIZE;
+  return 2;
+}
+
+static int64_t readByReader(SBlockReadReq *pReqs, char *buf, int32_t mode, int32_t ranges, int32_t *realMode) {
+  SBlockReadReq *pHeads = pReqs;
+  if (ranges) {
+    pHeads = malloc(sizeof(SBlockReadReq) * arguments.numOfBlocks);
+    for (int32_t i = 0; i < arguments.numOfBlocks; ++i) {
+      pHeads[i] = pReqs[i];
+      pHeads[i].len = BLOCK_HEAD_SIZE;
+    }
+  }
+
+  void *pReader = vnodeOpenBlockReader(pHeads, arguments.numOfBlocks, arguments.depth, mode,
+                                       ranges ? getTailRanges : NULL, pReqs);
+  if (pHeads != pReqs) free(pHeads);
+
+  if (pReader == NULL) {
+    *realMode = TSDB_BLOCK_READ_SYNC;
+    return -1;
+  }
+
+  *realMode = vnodeGetBlockReadMode(pReader);
+  int64_t sum = 0;
+
+  for (int32_t i = 0; i < arguments.numOfBlocks; ++i) {
+    SBlockReadReq *pReq = &pReqs[i];
+    int32_t        code = vnodeAcquireBlockRead(pReader, i);
+
+    if (ranges) {
+      // the tail is copied to the end of the block in buf, a range across head and tail is not read
+      int64_t tail = pReq->offset + pReq->len - BLOCK_TAIL_SIZE;
+      if (code != 0 || vnodeCopyFromBlockRead(pReader, pReq->fd, pReq->offset, buf, BLOCK_HEAD_SIZE) != 0 ||
+          vnodeCopyFromBlockRead(pReader, pReq->fd, tail, buf + pReq->len - BLOCK_TAIL_SIZE, BLOCK_TAIL_SIZE) != 0) {
+        fprintf(stderr, "failed to read ranges of block:%d\n", i);
+        exit(EXIT_FAILURE);
+      }
+
+      TH_CHECK(vnodeCopyFromBlockRead(pReader, pReq->fd, pReq->offset, buf, BLOCK_HEAD_SIZE + 1) != 0,
+               "block:%d, bytes not read are copied", i);
+    } else if (code != 0 || vnodeCopyFromBlockRead(pReader, pReq->fd, pReq->offset, buf, pReq->len) != 0) {
+      fprintf(stderr, "failed to read block:%d\n", i);
+      exit(EXIT_FAILURE);
+    }
+
+    sum += checkBlock(pReq, buf);
+  }
+
+  vnodeCloseBlockReader(pReader);
+  return sum;
+}
+
+static int32_t isWholeBlock(SBlockReadReq *pReq, char *buf) {
+  for (int32_t i = 1; i < pReq->len; ++i) {
+    if (buf[i] != buf[0]) return 0;
+  }
+  return 1;
+}
+
+static void readByInterleavedReaders(SBlockReadReq *pReqs, char *buf, int64_t expect) {
+  void *  pReaders[2];
+  int64_t sums[2] = {0};
+  char *  bufs[2] = {buf, buf + arguments.blockSize * 2};
+
+  for (int32_t r = 0; r < 2; ++r) {
+    pReaders[r] = vnodeOpenBlockReader(pReqs, arguments.numOfBlocks, arguments.depth, TSDB_BLOCK_READ_URING, NULL, NULL);
+  }
+
+  if (vnodeGetBlockReadMode(pReaders[0]) != TSDB_BLOCK_READ_URING ||
+      vnodeGetBlockReadMode(pReaders[1]) != TSDB_BLOCK_READ_URING) {
+    printf("interleaved readers on io_uring not available\n");
+  } else {
+    for (int32_t i = 0; i < arguments.numOfBlocks; ++i) {
+      SBlockReadReq *pReq = &pReqs[i];
+
+      for (int32_t r = 0; r < 2; ++r) {
+        int32_t code = vnodeAcquireBlockRead(pReaders[r], i);
+        if (code == 0) code = vnodeCopyFromBlockRead(pReaders[r], pReq->fd, pReq->offset, bufs[r], pReq->len);
+
+        TH_CHECK(code == 0 && isWholeBlock(pReq, bufs[r]), "reader:%d, block:%d is not read", r, i);
+        sums[r] += checkBlock(pReq, bufs[r]);
+      }
+    }
+
+    TH_CHECK(sums[0] == expect && sums[1] == expect, "interleaved readers: data mismatch");
+  }
+
+  for (int32_t r = 0; r < 2; ++r) vnodeCloseBlockReader(pReaders[r]);
+}
+
+static void report(const char *name, int64_t us, int64_t bytes) {
+  printf("%-6s elapsed:%10.3f ms, throughput:%10.2f MB/s\n", name, us / 1000.0,
+         (us > 0) ? bytes / (us / 1000000.0) / 1048576.0 : 0.0);
+}
+
+int main(int argc, char *argv[]) {
+  parseArg(argc, argv);
+  srand(1);
+
+  int fd = open(arguments.file, O_RDWR | O_CREAT, 0644);
+  if (fd < 0) {
+    fprintf(stderr, "failed to open test file:%s\n", arguments.file);
+    exit(EXIT_FAILURE);
+  }
+
+  SBlockReadReq *pReqs = createBlocks(fd);
+  char *         buf = malloc((size_t)arguments.blockSize * 4);
+  int64_t        bytes = 0;
+  for (int32_t i = 0; i < arguments.numOfBlocks; ++i) bytes += pReqs[i].len;
+
+  printf("blocks:%d, total size:%.2f MB, depth:%d, threads:%d, mmap window:%d\n", arguments.numOfBlocks,
+         bytes / 1048576.0, arguments.depth, arguments.threads, arguments.windowSize);
+
+  vnodeInitBlockReadPool(arguments.threads);
+
+  dropCache(fd);
+  int64_t st = thGetTimeUs();
+  int64_t expect = readByMMapWindow(pReqs, buf);
+  report("mmap", thGetTimeUs() - st, bytes);
+
+  dropCache(fd);
+  st = thGetTimeUs();
+  TH_CHECK(readBySync(pReqs, buf) == expect, "sync: data mismatch");
+  report("sync", thGetTimeUs() - st, bytes);
+
+  int32_t modes[] = {TSDB_BLOCK_READ_POOL, TSDB_BLOCK_READ_URING};
+  for (int32_t m = 0; m < 2; ++m) {
+    for (int32_t ranges = 0; ranges <= 1; ++ranges) {
+      const char *name = (modes[m] == TSDB_BLOCK_READ_URING) ? (ranges ? "uring*" : "uring")
+                                                             : (ranges ? "pool*" : "pool");
+      int32_t realMode = 0;
+
+      dropCache(fd);
+      st = thGetTimeUs();
+      int64_t sum = readByReader(pReqs, buf, modes[m], ranges, &realMode);
+      int64_t us = thGetTimeUs() - st;
+
+      if (realMode != modes[m]) {
+        printf("%-6s not available\n", name);
+        continue;
+      }
+
+      TH_CHECK(sum == expect, "mode %d, ranges:%d: data mismatch", modes[m], ranges);
+      report(name, us, ranges ? (int64_t)arguments.numOfBlocks * (BLOCK_HEAD_SIZE + 16 + BLOCK_TAIL_SIZE) : bytes);
+    }
+  }
+
+  readByInterleavedReaders(pReqs, buf, expect);
+
+  vnodeCleanUpBlockReadPool();
+  free(buf);
+  free(pReqs);
+  close(fd);
+  return thReport("blockReadTest");
+}
@@ -0,0 +1,166 @@
+/*
+ * Queries answered by the pre-aggregated values of file blocks or by skipping them shall return the rows of the
+ * queries that load every block. File blocks of 200 rows span exactly 1h, so an interval of 1h or 2h has whole blocks
+ * in its windows, which are answered from their SField, while shorter intervals split the blocks. A filter on k, which
+ * is never NULL, selects all rows and makes every block loaded. Top/bottom of a table skip the blocks that can not
+ * beat the kept values, the same query on the super table filtered by the tag of the table skips none. Some blocks
+ * are NULL in every row of a column, and the other blocks have NULLs scattered.
+ */
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "testHarness.h"
+#include "tutil.h"
+
+typedef struct {
+  int numOfRows;
+} ProArgs;
+
+static ProArgs arguments;
+
+#define TEST_NAME "blockStatisTest"
+#define START_TS ((int64_t)1599998400000LL)  // aligned to an hour
+#define ROW_INTERVAL 18000LL                 // 200 rows of a block in 1h
+#define MAX_SQL_LEN 65000
+#define MAX_RESULT_LEN (1024 * 1024)
+
+static const char *aggrs[] = {
+    "count(*), count(v), sum(v), min(v), max(v), avg(v), spread(v)",
+    "count(d), sum(d), min(d), max(d), avg(d), spread(d)",
+    "count(*), max(v), min(d)",
+};
+
+// a retrieve of a table returns at most 200 windows, i.e., the rows of a file block, no query has more of them
+static const char *intervals[] = {"1h", "2h", "5h", "40m", "17m"};
+
+static const char *topBottoms[] = {"top(v, 5)", "bottom(v, 5)", "top(v, 50)", "top(d, 3)", "bottom(d, 20)"};
+
+void parseArg(int argc, char *argv[]) {
+  arguments.numOfRows = 10000;
+
+  SThOption options[] = {TH_INT_OPTION("-rows", &arguments.numOfRows)};
+  thParseArgs(argc, argv, options, tListLen(options));
+}
+
+static int64_t getTs(int row) { return START_TS + row * ROW_INTERVAL; }
+
+// v is NULL in every row of the 11th block, d in every row of the 21st, besides the scattered ones
+static bool isNullV(int row) { return row % 13 == 6 || (row >= 2000 && row < 2200); }
+static bool isNullD(int row) { return row % 17 == 3 || (row >= 4000 && row < 4200); }
+
+// values are unique, which rows of top/bottom are kept does not depend on the order the blocks are visited
+static int getValue(int row, int table) { return (int)(((int64_t)row * 7919 + table * 31) % 100003); }
+
+void writeRows(TAOS *taos) {
+  char *sql = malloc(MAX_SQL_LEN);
+
+  thExecute(taos, "create database bs rows 200 tblocks 400");
+  thExecute(taos, "use bs");
+  thExecute(taos, "create table st (ts timestamp, v int, d double, k int) tags (t int)");
+
+  for (int t = 0; t < 2; ++t) {
+    thExecute(taos, "create table t%d using st tags (%d)", t, t);
+
+    for (int row = 0; row < arguments.numOfRows;) {
+      int len = sprintf(sql, "insert into t%d values", t);
+      for (int n = 0; n < 500 && row < arguments.numOfRows; ++n, ++row) {
+        len += sprintf(sql + len, "(%" PRId64 ",", getTs(row));
+        len += isNullV(row) ? sprintf(sql + len, "NULL,") : sprintf(sql + len, "%d,", getValue(row, t));
+        len += isNullD(row) ? sprintf(sql + len, "NULL,") : sprintf(sql + len, "%.2f,", getValue(row, t) * -0.25);
+        len += sprintf(sql + len, "%d)", row);
+      }
+
+      thExecute(taos, "%s", sql);
+    }
+  }
+
+  free(sql);
+}
+
+static void checkSame(TAOS *taos, char *expected, char *result, const char *sql, const char *baseSql) {
+  int32_t rows = thQueryRows(taos, result, MAX_RESULT_LEN, "%s", sql);
+  int32_t baseRows = thQueryRows(taos, expected, MAX_RESULT_LEN, "%s", baseSql);
+
+  TH_CHECK(baseRows > 0, "no rows of \"%s\"", baseSql);
+  TH_CHECK(rows == baseRows, "\"%s\", rows:%d, expected:%d", sql, rows, baseRows);
+  TH_CHECK(strcmp(expected, result) == 0, "\"%s\" differs from \"%s\", expected:\n%.2000s\nresult:\n%.2000s", sql,
+           baseSql, expected, result);
+}
+
+// the time range of a query, with a block of its own at both ends, or with split blocks at both ends
+void checkIntervals(TAOS *taos, char *expected, char *result) {
+  char sql[512], baseSql[512], ranges[3][128];
+
+  ranges[0][0] = 0;
+  snprintf(ranges[1], sizeof(ranges[1]), "ts >= %" PRId64 " and ts < %" PRId64, getTs(1000), getTs(6000));
+  snprintf(ranges[2], sizeof(ranges[2]), "ts >= %" PRId64 " and ts <= %" PRId64, getTs(1234) + 5000,
+           getTs(arguments.numOfRows - 1357) - 5000);
+
+  for (int a = 0; a < tListLen(aggrs); ++a) {
+    for (int i = 0; i < tListLen(intervals); ++i) {
+      for (int r = 0; r < tListLen(ranges); ++r) {
+        bool hasRange = ranges[r][0] != 0;
+        snprintf(sql, sizeof(sql), "select %s from t0 %s%s interval(%s)", aggrs[a], hasRange ? "where " : "",
+                 ranges[r], intervals[i]);
+        snprintf(baseSql, sizeof(baseSql), "select %s from t0 where %s%sk >= 0 interval(%s)", aggrs[a], ranges[r],
+                 hasRange ? " and " : "", intervals[i]);
+        checkSame(taos, expected, result, sql, baseSql);
+      }
+    }
+  }
+
+  // every window of a whole block
+  int32_t rows = thQueryRows(taos, result, MAX_RESULT_LEN, "select count(*) from t0 interval(1h)");
+  int32_t windows = (int32_t)((getTs(arguments.numOfRows - 1) - START_TS) / 3600000LL) + 1;
+  TH_CHECK(rows == windows, "windows of 1h:%d, expected:%d", rows, windows);
+}
+
+// the super table query checks each block of the table, the rows are the same as of the table query
+void checkTopBottoms(TAOS *taos, char *expected, char *result) {
+  char sql[512], baseSql[512];
+
+  for (int i = 0; i < tListLen(topBottoms); ++i) {
+    for (int t = 0; t < 2; ++t) {
+      snprintf(sql, sizeof(sql), "select %s from t%d", topBottoms[i], t);
+      snprintf(baseSql, sizeof(baseSql), "select %s from st where t = %d", topBottoms[i], t);
+      checkSame(taos, expected, result, sql, baseSql);
+
+      snprintf(sql, sizeof(sql), "select %s from t%d where ts >= %" PRId64 " and ts < %" PRId64, topBottoms[i], t,
+               getTs(1500), getTs(4500));
+      snprintf(baseSql, sizeof(baseSql), "select %s from st where t = %d and ts >= %" PRId64 " and ts < %" PRId64,
+               topBottoms[i], t, getTs(1500), getTs(4500));
+      checkSame(taos, expected, result, sql, baseSql);
+    }
+  }
+
+  // only the all NULL block of v is in the range
+  int32_t rows = thQueryRows(taos, result, MAX_RESULT_LEN, "select top(v, 5) from t0 where ts >= %" PRId64
+                             " and ts < %" PRId64, getTs(2000), getTs(2200));
+  TH_CHECK(rows == 0, "top of a block of NULL values, rows:%d, expected:0\n%.2000s", rows, result);
+}
+
+int main(int argc, char *argv[]) {
+  parseArg(argc, argv);
+
+  TAOS *taos = thStartServer(TEST_NAME, NULL);
+  writeRows(taos);
+
+  // the pre-aggregated values are of the blocks in files
+  taos = thRestartServer(taos, TEST_NAME, NULL);
+  thExecute(taos, "use bs");
+
+  char *expected = malloc(MAX_RESULT_LEN);
+  char *result = malloc(MAX_RESULT_LEN);
+
+  checkIntervals(taos, expected, result);
+  checkTopBottoms(taos, expected, result);
+
+  free(expected);
+  free(result);
+
+  thStopServer(taos);
+  return thReport(TEST_NAME);
+}
@@ -0,0 +1,153 @@
+/*
+ * Measure inserts per second against the number of writer threads. The cache blocks of the vnode are split into
+ * shards, writers either spread over all tables or only write the tables whose sid falls into one shard, so the
+ * hot shard has to borrow blocks from the others. Rows in the tables are checked after each round.
+ */
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "testHarness.h"
+#include "tutil.h"
+
+typedef struct {
+  int numOfThreads;
+  int numOfShards;
+  int numOfTables;
+  int rowsPerTable;
+  int rowsPerRequest;
+} ProArgs;
+
+typedef struct {
+  int     first;  // tables written by a thread: first, first + step, ...
+  int     step;
+  int     numOfTables;
+  int64_t rows;
+} SWriter;
+
+static ProArgs arguments;
+
+#define START_TS ((int64_t)1600000000000LL)
+#define MAX_SQL_LEN 65000
+
+void parseArg(int argc, char *argv[]) {
+  arguments.numOfThreads = 8;
+  arguments.numOfShards = 4;
+  arguments.numOfTables = 100;
+  arguments.rowsPerTable = 20000;
+  arguments.rowsPerRequest = 500;
+
+  SThOption options[] = {TH_INT_OPTION("-threads", &arguments.numOfThreads),
+                         TH_INT_OPTION("-shards", &arguments.numOfShards),
+                         TH_INT_OPTION("-tables", &arguments.numOfTables),
+                         TH_INT_OPTION("-rows", &arguments.rowsPerTable),
+                         TH_INT_OPTION("-batch", &arguments.rowsPerRequest)};
+  thParseArgs(argc, argv, options, tListLen(options));
+}
+
+// tables are created in order, so the sids of t0, tN, t2N ... fall into the same shard of N shards
+void prepareDb(TAOS *taos) {
+  thExecute(taos, "drop database if exists cw");
+  thExecute(taos, "create database cw tables %d cache 4096 ablocks 4 tblocks 16", arguments.numOfTables);
+  thExecute(taos, "use cw");
+  thExecute(taos, "create table st (ts timestamp, v int, f double) tags (t int)");
+
+  for (int i = 0; i < arguments.numOfTables; ++i) {
+    thExecute(taos, "create table t%d using st tags (%d)", i, i);
+  }
+}
+
+void *writeTables(void *param) {
+  SWriter *pWriter = (SWriter *)param;
+  TAOS *   taos = taos_connect("127.0.0.1", "root", "taosdata", "cw", 0);
+  char *   sql = malloc(MAX_SQL_LEN);
+
+  TH_CHECK(taos != NULL, "failed to connect");
+  if (taos == NULL) return NULL;
+
+  // a request writes rows of one table, tables of the thread are written in turn
+  for (int row = 0; row < arguments.rowsPerTable; row += arguments.rowsPerRequest) {
+    for (int i = 0; i < pWriter->numOfTables; ++i) {
+      int table = pWriter->first + i * pWriter->step;
+      int len = sprintf(sql, "insert into t%d values", table);
+      int n = 0;
+      for (; n < arguments.rowsPerRequest && row + n < arguments.rowsPerTable; ++n) {
+        len += sprintf(sql + len, "(%" PRId64 ",%d,%d.5)", START_TS + row + n, row + n, table);
+      }
+
+      if (thExecute(taos, "%s", sql) == 0) pWriter->rows += n;
+    }
+  }
+
+  free(sql);
+  taos_close(taos);
+  return NULL;
+}
+
+void writeByThreads(TAOS *taos, int numOfThreads, int hot) {
+  prepareDb(taos);
+
+  // a hot round writes only the tables of one shard, each thread writes the same number of tables in both rounds
+  int step = hot ? arguments.numOfShards : 1;
+  int numOfTables = arguments.numOfTables / arguments.numOfShards / numOfThreads;
+  if (numOfTables < 1) numOfTables = 1;
+
+  pthread_t *threads = calloc(numOfThreads, sizeof(pthread_t));
+  SWriter *  writers = calloc(numOfThreads, sizeof(SWriter));
+
+  int64_t st = thGetTimeUs();
+  for (int i = 0; i < numOfThreads; ++i) {
+    writers[i].first = hot ? i * numOfTables * step : i * numOfTables;
+    writers[i].step = step;
+    writers[i].numOfTables = numOfTables;
+    pthread_create(&threads[i], NULL, writeTables, &writers[i]);
+  }
+
+  int64_t rows = 0;
+  for (int i = 0; i < numOfThreads; ++i) {
+    pthread_join(threads[i], NULL);
+    rows += writers[i].rows;
+  }
+  double seconds = (double)(thGetTimeUs() - st) / 1000000;
+
+  int64_t expected = (int64_t)numOfThreads * numOfTables * arguments.rowsPerTable;
+  TH_CHECK(rows == expected, "%s shard, threads:%d, rows written:%" PRId64 ", expected:%" PRId64,
+           hot ? "hot" : "all", numOfThreads, rows, expected);
+
+  // a query racing with a commit may miss the rows being moved from cache to file, so count again later
+  double count = thQueryValue(taos, "select count(*) from st");
+  for (int i = 0; i < 10 && count != expected; ++i) {
+    usleep(500000);
+    count = thQueryValue(taos, "select count(*) from st");
+  }
+
+  TH_CHECK(count == expected, "%s shard, threads:%d, rows in tables:%.0f, expected:%" PRId64, hot ? "hot" : "all",
+           numOfThreads, count, expected);
+
+  printf("%s shard, threads:%d, tables:%d, rows:%" PRId64 ", time:%.2f seconds, rows/second:%.0f\n",
+         hot ? "hot" : "all", numOfThreads, numOfThreads * numOfTables, rows, seconds, rows / seconds);
+
+  free(writers);
+  free(threads);
+}
+
+int main(int argc, char *argv[]) {
+  parseArg(argc, argv);
+
+  char cfg[64];
+  snprintf(cfg, sizeof(cfg), "cacheShards %d\n", arguments.numOfShards);
+  TAOS *taos = thStartServer("cacheWriteTest", cfg);
+
+  for (int hot = 0; hot <= 1; ++hot) {
+    for (int numOfThreads = 1; numOfThreads <= arguments.numOfThreads; numOfThreads *= 2) {
+      writeByThreads(taos, numOfThreads, hot);
+    }
+  }
+
+  thStopServer(taos);
+  return thReport("cacheWriteTest");
+}
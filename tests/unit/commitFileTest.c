@@ -0,0 +1,278 @@
+/*
+ * Rows are committed into files again and again, by the cache running out of blocks while tables are written and by
+ * the restarts of taosd, with the blocks compressed in the commit thread and in the pool of commit threads in turn.
+ * Each round writes rows of every column type into some of the tables, and all rows of all tables are checked after
+ * the round and after the restart.
+ *
+ * The head file is only appended the comp info of the changed tables, and the comp info of the others is copied, as
+ * long as the last file is appended rather than rewritten. Tables are dropped and created again in the full vnode, so
+ * the new table takes the sid of the old one, and the comp info of the old table shall be thrown away even if the new
+ * one has no rows to commit. The last file is appended until it doubles and then it is rewritten.
+ */
+#include <fcntl.h>
+#include <glob.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "testHarness.h"
+#include "tutil.h"
+#include "vnode.h"
+#include "vnodeFile.h"
+
+typedef struct {
+  int numOfTables;
+  int numOfRounds;
+  int rowsPerRound;
+} ProArgs;
+
+static ProArgs arguments;
+
+#define TEST_NAME "commitFileTest"
+#define START_TS ((int64_t)1600000000000LL)
+#define MAX_SQL_LEN 65000
+#define MAX_RESULT_LEN (8 * 1024 * 1024)
+#define MAX_TABLES 100
+
+// partial blocks of up to 90% of the rows of a file block go into the last file
+static const char *serverCfg[] = {"numOfCommitThreads 0\nfileBlockMinPercent 0.9\n",
+                                  "numOfCommitThreads 4\nfileBlockMinPercent 0.9\n"};
+
+static int numOfRows[MAX_TABLES];
+static int tableIds[MAX_TABLES];  // values of the rows of a table, changed when the table is created again
+
+void parseArg(int argc, char *argv[]) {
+  arguments.numOfTables = 20;
+  arguments.numOfRounds = 10;
+  arguments.rowsPerRound = 2000;
+
+  SThOption options[] = {TH_INT_OPTION("-tables", &arguments.numOfTables),
+                         TH_INT_OPTION("-rounds", &arguments.numOfRounds),
+                         TH_INT_OPTION("-rows", &arguments.rowsPerRound)};
+  thParseArgs(argc, argv, options, tListLen(options));
+  arguments.numOfTables = MIN(arguments.numOfTables, MAX_TABLES);
+}
+
+// columns of a row, as they are printed by the query
+static int printRow(char *buf, int table, int row) {
+  int len = sprintf(buf, "%" PRId64 " ", START_TS + (int64_t)row * 1000);
+  len += (row % 29 == 5) ? sprintf(buf + len, "NULL ") : sprintf(buf + len, "%d ", (row * 7 + table) % 1000);
+  len += sprintf(buf + len, "%" PRId64 " %f ", (int64_t)row * 100003 + table, (row % 1000) * 0.5f);
+  len += (row % 31 == 7) ? sprintf(buf + len, "NULL ") : sprintf(buf + len, "%lf ", row * 0.25 + table);
+  len += sprintf(buf + len, "%d %d %d ", (row * 13 + table) % 30000 - 15000, row % 200 - 100, row % 3 == 0);
+  len += (row % 37 == 11) ? sprintf(buf + len, "NULL") : sprintf(buf + len, "%c%05d-t%d", 'a' + row % 26, row, table);
+  return len;
+}
+
+static int printValues(char *buf, int table, int row) {
+  char line[256];
+  printRow(line, table, row);
+
+  int len = sprintf(buf, "(");
+  int col = 0;
+  for (char *p = strtok(line, " "); p != NULL; p = strtok(NULL, " "), ++col) {
+    // the binary column
+    if (col == 8 && strcmp(p, "NULL") != 0) {
+      len += sprintf(buf + len, ",'%s'", p);
+    } else {
+      len += sprintf(buf + len, "%s%s", (col > 0) ? "," : "", p);
+    }
+  }
+
+  return len + sprintf(buf + len, ")");
+}
+
+void prepareDb(TAOS *taos) {
+  thExecute(taos, "create database cf tables %d rows 1000 cache 4096 ablocks 4 tblocks 16", arguments.numOfTables);
+  thExecute(taos, "use cf");
+  thExecute(taos,
+            "create table st (ts timestamp, i int, b bigint, f float, d double, s smallint, c tinyint, l bool, "
+            "n binary(16)) tags (t int)");
+
+  for (int t = 0; t < arguments.numOfTables; ++t) {
+    thExecute(taos, "create table t%d using st tags (%d)", t, t);
+    tableIds[t] = t;
+  }
+}
+
+// the new tables are left empty in the round they are created in
+static bool recreateTables(TAOS *taos, int round) {
+  if (round % 3 != 1) return false;
+
+  for (int t = round % 5; t < arguments.numOfTables; t += 5) {
+    thExecute(taos, "drop table t%d", t);
+    thExecute(taos, "create table t%d using st tags (%d)", t, t);
+    tableIds[t] += MAX_TABLES;
+    numOfRows[t] = 0;
+  }
+
+  return true;
+}
+
+// files of the vnode, all rows are in the same file id
+static int64_t listFiles(const char *suffix, glob_t *pFiles) {
+  char pattern[600];
+  snprintf(pattern, sizeof(pattern), "%s/data/tsdb/vnode*/db/*.%s", thGetServerDir(), suffix);
+  if (glob(pattern, 0, NULL, pFiles) != 0) return 0;
+  return (int64_t)pFiles->gl_pathc;
+}
+
+static int64_t getLastFileSize() {
+  glob_t  files;
+  int64_t size = 0;
+
+  if (listFiles("last", &files) == 0) return 0;
+  for (size_t i = 0; i < files.gl_pathc; ++i) {
+    struct stat st;
+    if (stat(files.gl_pathv[i], &st) == 0) size += st.st_size;
+  }
+
+  globfree(&files);
+  return size;
+}
+
+// tables with comp info in the head files, a vnode has a table more than its db
+static int32_t countCompInfo() {
+  glob_t  files;
+  int32_t count = 0;
+
+  if (listFiles("head", &files) == 0) return 0;
+
+  int32_t      size = (arguments.numOfTables + 1) * (int32_t)sizeof(SCompHeader) + (int32_t)sizeof(TSCKSUM);
+  SCompHeader *headers = malloc((size_t)size);
+
+  for (size_t i = 0; i < files.gl_pathc; ++i) {
+    int fd = open(files.gl_pathv[i], O_RDONLY);
+    if (fd < 0 || pread(fd, headers, (size_t)size, TSDB_FILE_HEADER_LEN) != size ||
+        !taosCheckChecksumWhole((uint8_t *)headers, (uint32_t)size)) {
+      TH_CHECK(false, "failed to read the comp headers of %s", files.gl_pathv[i]);
+      if (fd >= 0) close(fd);
+      continue;
+    }
+
+    for (int32_t sid = 0; sid <= arguments.numOfTables; ++sid) {
+      if (headers[sid].compInfoOffset == 0) continue;
+
+      SCompInfo info;
+      bool      valid = pread(fd, &info, sizeof(info), headers[sid].compInfoOffset) == sizeof(info) &&
+                   taosCheckChecksumWhole((uint8_t *)&info, sizeof(info));
+      TH_CHECK(valid, "comp info of sid:%d in %s is broken", sid, files.gl_pathv[i]);
+      count++;
+    }
+
+    close(fd);
+  }
+
+  free(headers);
+  globfree(&files);
+  return count;
+}
+
+/*
+ * a round leaves some of the tables untouched, and writes the others a different number of rows, tables are written
+ * in turn, so that a commit by the cache appends the last blocks of many tables
+ */
+void writeRound(TAOS *taos, int round, bool recreated) {
+  char *sql = malloc(MAX_SQL_LEN);
+  int   rows[MAX_TABLES];
+
+  for (int t = 0; t < arguments.numOfTables; ++t) {
+    bool skipped = (t + round) % 4 == 0 || (recreated && t % 5 == round % 5);
+    rows[t] = skipped ? 0 : arguments.rowsPerRound / 6 * (1 + (t * 3 + round) % 6);
+  }
+
+  for (bool written = true; written;) {
+    written = false;
+    for (int t = 0; t < arguments.numOfTables; ++t) {
+      if (rows[t] <= 0) continue;
+
+      int len = sprintf(sql, "insert into t%d values", t);
+      for (int i = 0; i < 50 && rows[t] > 0; ++i, --rows[t]) {
+        len += printValues(sql + len, tableIds[t], numOfRows[t]++);
+      }
+      thExecute(taos, "%s", sql);
+      written = true;
+    }
+  }
+
+  free(sql);
+}
+
+void checkRows(TAOS *taos, char *expected, char *result, const char *step) {
+  for (int t = 0; t < arguments.numOfTables; ++t) {
+    int len = 0;
+    expected[0] = 0;
+    for (int row = 0; row < numOfRows[t]; ++row) {
+      len += printRow(expected + len, tableIds[t], row);
+      len += sprintf(expected + len, "\n");
+    }
+
+    int32_t rows = thQueryRows(taos, result, MAX_RESULT_LEN, "select * from t%d", t);
+    TH_CHECK(rows == numOfRows[t], "%s, t%d, rows:%d, expected:%d", step, t, rows, numOfRows[t]);
+    if (strcmp(expected, result) == 0) continue;
+
+    // the first row that differs
+    int offset = 0, row = 0;
+    for (int i = 0; expected[i] == result[i]; ++i) {
+      if (expected[i] == '\n') offset = i + 1, row++;
+    }
+    TH_CHECK(false, "%s, t%d, row:%d differs, expected:\n%.200s\nresult:\n%.200s", step, t, row, expected + offset,
+             result + offset);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  parseArg(argc, argv);
+
+  char *expected = malloc(MAX_RESULT_LEN);
+  char *result = malloc(MAX_RESULT_LEN);
+  char  step[64];
+
+  TAOS *taos = thStartServer(TEST_NAME, serverCfg[0]);
+  prepareDb(taos);
+
+  int64_t lastFileSize = 0;
+  int     appended = 0, rewritten = 0;
+
+  for (int round = 0; round < arguments.numOfRounds; ++round) {
+    bool recreated = recreateTables(taos, round);
+    writeRound(taos, round, recreated);
+
+    snprintf(step, sizeof(step), "round %d", round);
+    checkRows(taos, expected, result, step);
+
+    // the commit at the stop is incremental while the last file is appended, its head file is read after the start
+    taos = thRestartServer(taos, TEST_NAME, serverCfg[(round + 1) % 2]);
+    thExecute(taos, "use cf");
+
+    snprintf(step, sizeof(step), "restart after round %d", round);
+    checkRows(taos, expected, result, step);
+
+    // comp info of the old tables of reused sids is not copied to the new head file
+    int32_t tables = 0;
+    for (int t = 0; t < arguments.numOfTables; ++t) tables += (numOfRows[t] > 0);
+    int32_t compInfos = countCompInfo();
+    TH_CHECK(compInfos == tables, "%s, comp info of %d tables, expected:%d", step, compInfos, tables);
+
+    int64_t size = getLastFileSize();
+    if (size > lastFileSize) appended++;
+    if (size < lastFileSize) rewritten++;
+    lastFileSize = size;
+  }
+
+  // the new tables are in the vnode of the old ones
+  int32_t vgroups = thQueryRows(taos, NULL, 0, "show vgroups");
+  TH_CHECK(vgroups == 1, "tables are in %d vnodes, expected 1", vgroups);
+  TH_CHECK(appended > 0 && rewritten > 0, "last file is appended %d times and rewritten %d times", appended,
+           rewritten);
+
+  free(expected);
+  free(result);
+
+  thStopServer(taos);
+  return thReport(TEST_NAME);
+}
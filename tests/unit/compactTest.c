@@ -0,0 +1,197 @@
+/*
+ * Check the blocks merged by background compaction and the rows of the tables. Every commit writes a block of 20
+ * rows per table, blocks up to 100 rows are small. Adjacent small blocks are merged only if the merged block is at
+ * least twice as large as the largest of them, so a merged block of 80 rows followed by a block of 20 rows is left
+ * as it is, until four blocks of 20 rows follow it. Compaction is only enabled while the blocks merged are counted,
+ * from the log of the server, and the rows are checked after each stage.
+ */
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "testHarness.h"
+#include "tutil.h"
+
+typedef struct {
+  int numOfTables;
+} ProArgs;
+
+static ProArgs arguments;
+
+#define TEST_NAME "compactTest"
+#define START_TS ((int64_t)1600000000000LL)
+#define MAX_SQL_LEN 65000
+#define MAX_RESULT_LEN (1024 * 1024)
+#define COMPACT_TIMEOUT_SEC 60
+#define ROWS_PER_ROUND 20
+
+// compaction runs every second when it is enabled
+static const char *compactCfg = "compactInterval 1\n";
+
+void parseArg(int argc, char *argv[]) {
+  arguments.numOfTables = 10;
+
+  SThOption options[] = {TH_INT_OPTION("-tables", &arguments.numOfTables)};
+  thParseArgs(argc, argv, options, tListLen(options));
+}
+
+static int64_t getTs(int row) { return START_TS + row * 1000LL; }
+
+static int getValue(int table, int row) { return table * 100000 + row * 7; }
+
+void prepareDb(TAOS *taos) {
+  // blocks of 200 rows, a block below 10 rows is kept in the last file
+  thExecute(taos, "create database cp rows 200");
+  thExecute(taos, "use cp");
+  thExecute(taos, "create table st (ts timestamp, v int, b binary(16)) tags (t int)");
+
+  for (int i = 0; i < arguments.numOfTables; ++i) {
+    thExecute(taos, "create table t%d using st tags (%d)", i, i);
+  }
+}
+
+void writeRound(TAOS *taos, int round) {
+  char *sql = malloc(MAX_SQL_LEN);
+
+  for (int i = 0; i < arguments.numOfTables; ++i) {
+    int len = sprintf(sql, "insert into t%d values", i);
+    for (int row = round * ROWS_PER_ROUND; row < (round + 1) * ROWS_PER_ROUND; ++row) {
+      len += sprintf(sql + len, "(%" PRId64 ",%d,'b%d')", getTs(row), getValue(i, row), row);
+    }
+
+    thExecute(taos, "%s", sql);
+  }
+
+  free(sql);
+}
+
+void checkRows(TAOS *taos, const char *stage, int numOfRows) {
+  char *expected = malloc(MAX_RESULT_LEN);
+  char *result = malloc(MAX_RESULT_LEN);
+
+  thExecute(taos, "use cp");
+
+  for (int i = 0; i < arguments.numOfTables; ++i) {
+    int len = 0;
+    expected[0] = 0;
+    for (int row = 0; row < numOfRows; ++row) {
+      len += sprintf(expected + len, "%" PRId64 " %d b%d\n", getTs(row), getValue(i, row), row);
+    }
+
+    thQueryRows(taos, result, MAX_RESULT_LEN, "select ts, v, b from t%d", i);
+    TH_CHECK(strcmp(expected, result) == 0, "%s, rows of t%d, expected:\n%.1000s\nresult:\n%.1000s", stage, i,
+             expected, result);
+  }
+
+  double count = thQueryValue(taos, "select count(*) from st");
+  TH_CHECK(count == (double)numOfRows * arguments.numOfTables, "%s, count of st:%.0f, expected:%d", stage, count,
+           numOfRows * arguments.numOfTables);
+
+  free(expected);
+  free(result);
+}
+
+/*
+ * Compaction rounds and small blocks merged by the running server, from the lines of its pid in the log files. The
+ * harness writes the pid of the server into taosd.pid.
+ */
+void getCompactStat(int64_t *rounds, int64_t *blocks) {
+  char path[600], line[1024];
+  int  pid = -1;
+
+  *rounds = 0;
+  *blocks = 0;
+
+  snprintf(path, sizeof(path), "%s/taosd.pid", thGetServerDir());
+  FILE *fp = fopen(path, "r");
+  if (fp == NULL) return;
+  if (fscanf(fp, "%d", &pid) != 1) pid = -1;
+  fclose(fp);
+
+  for (int i = 0; i < 2; ++i) {
+    snprintf(path, sizeof(path), "%s/log/taosdlog.%d", thGetServerDir(), i);
+    fp = fopen(path, "r");
+    if (fp == NULL) continue;
+
+    while (fgets(line, sizeof(line), fp) != NULL) {
+      char *  p = strstr(line, "compaction is over");
+      int     linePid = 0;
+      int64_t src = 0, dst = 0;
+      if (p == NULL || sscanf(line, "%*s %*s %d", &linePid) != 1 || linePid != pid) continue;
+
+      (*rounds)++;
+      if ((p = strstr(p, " blocks:")) != NULL && sscanf(p, " blocks:%" SCNd64 "->%" SCNd64, &src, &dst) == 2) {
+        *blocks += src;
+      }
+    }
+
+    fclose(fp);
+  }
+}
+
+// restart the server with compaction enabled, the small blocks merged are returned once it has run twice
+int64_t compact(TAOS **taos) {
+  int64_t rounds = 0, blocks = 0;
+
+  *taos = thRestartServer(*taos, TEST_NAME, compactCfg);
+  for (int sec = 0; sec < COMPACT_TIMEOUT_SEC; ++sec) {
+    getCompactStat(&rounds, &blocks);
+    if (rounds >= 2) break;
+    sleep(1);
+  }
+
+  TH_CHECK(rounds >= 2, "compaction does not run in %d seconds", COMPACT_TIMEOUT_SEC);
+  return blocks;
+}
+
+// write rounds of rows [from, to), each of them is committed as one block per table by a restart
+void writeRounds(TAOS **taos, int from, int to) {
+  char stage[64];
+
+  for (int round = from; round < to; ++round) {
+    writeRound(*taos, round);
+    *taos = thRestartServer(*taos, TEST_NAME, NULL);
+
+    snprintf(stage, sizeof(stage), "round %d", round);
+    checkRows(*taos, stage, (round + 1) * ROWS_PER_ROUND);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  parseArg(argc, argv);
+
+  TAOS *  taos = thStartServer(TEST_NAME, NULL);
+  int     numOfTables = arguments.numOfTables;
+  int64_t blocks;
+  prepareDb(taos);
+
+  // four blocks of 20 rows are merged into one
+  writeRounds(&taos, 0, 4);
+  blocks = compact(&taos);
+  TH_CHECK(blocks == 4 * numOfTables, "blocks of 20 rows merged:%" PRId64 ", expected:%d", blocks, 4 * numOfTables);
+  checkRows(taos, "blocks of 80 rows", 4 * ROWS_PER_ROUND);
+
+  // a block of 20 rows can not double the block of 80 rows, neither is rewritten
+  writeRounds(&taos, 4, 5);
+  blocks = compact(&taos);
+  TH_CHECK(blocks == 0, "blocks merged with a block of 20 rows:%" PRId64 ", expected:0", blocks);
+  checkRows(taos, "blocks of 80 and 20 rows", 5 * ROWS_PER_ROUND);
+
+  // the block of 80 rows and four blocks of 20 rows are merged into a block of 160 rows
+  writeRounds(&taos, 5, 8);
+  blocks = compact(&taos);
+  TH_CHECK(blocks == 5 * numOfTables, "blocks merged with four blocks of 20 rows:%" PRId64 ", expected:%d", blocks,
+           5 * numOfTables);
+  checkRows(taos, "blocks of 160 rows", 8 * ROWS_PER_ROUND);
+
+  taos = thRestartServer(taos, TEST_NAME, NULL);
+  checkRows(taos, "after restart", 8 * ROWS_PER_ROUND);
+
+  printf("tables:%d, blocks of %d rows merged into blocks of 80 and 160 rows\n", numOfTables, ROWS_PER_ROUND);
+
+  thStopServer(taos);
+  return thReport(TEST_NAME);
+}
@@ -0,0 +1,334 @@
+/*
+ * Report the compression ratio and throughput of the float codecs (floatComp option):
+ *   bytes    : XOR with the previous value, leading or trailing bytes kept for each value
+ *   group    : XOR with the previous value, one bit window kept for each group of 8 values
+ *   adaptive : the smaller of the two for each column of each block
+ *
+ * With -dir, the float and double columns of all data files of a vnode (e.g. /var/lib/taos/vnode/vnode2/db) are
+ * decoded and encoded again by each codec. The number of comp headers in a head file is found from the offset of the
+ * first comp info, -tables gives it when that fails. Without -dir, synthetic gauges are used. The throughput is the
+ * size of the raw values per second.
+ */
+#include <dirent.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "testHarness.h"
+#include "tglobalcfg.h"
+#include "tscompression.h"
+#include "tsdb.h"
+#include "tutil.h"
+#include "vnodeFile.h"
+
+#define NUM_OF_CODECS 3
+#define TSDB_FILE_HEADER_LEN 512  // as in vnode.h
+
+typedef struct {
+  char    dir[256];
+  int32_t tables;
+  int32_t rounds;
+} ProArgs;
+
+typedef struct {
+  int64_t columns;
+  int64_t values;
+  int64_t rawBytes;
+  int64_t storedBytes;
+  int64_t compBytes[NUM_OF_CODECS];
+  int64_t encodeNs[NUM_OF_CODECS];
+  int64_t decodeNs[NUM_OF_CODECS];
+  int64_t errors;
+} SCodecReport;
+
+static ProArgs      arguments;
+static SCodecReport reports[2];  // float, double
+static const char * codecName[] = {"bytes", "group", "adaptive"};
+
+void parseArg(int argc, char *argv[]) {
+  arguments.dir[0] = 0;
+  arguments.tables = 0;
+  arguments.rounds = 3;
+
+  SThOption options[] = {TH_STR_OPTION("-dir", arguments.dir), TH_INT_OPTION("-tables", &arguments.tables),
+                         TH_INT_OPTION("-rounds", &arguments.rounds)};
+  thParseArgs(argc, argv, options, tListLen(options));
+}
+
+static int64_t getTimeStampNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static int32_t compress(int32_t type, const char *input, int32_t points, char *output, int32_t algorithm,
+                        char *buffer, int32_t bufferSize) {
+  int32_t size = points * ((type == TSDB_DATA_TYPE_FLOAT) ? 4 : 8);
+  if (type == TSDB_DATA_TYPE_FLOAT) {
+    return tsCompressFloat(input, size, points, output, size + 1024, algorithm, buffer, bufferSize);
+  }
+  return tsCompressDouble(input, size, points, output, size + 1024, algorithm, buffer, bufferSize);
+}
+
+static int32_t decompress(int32_t type, const char *input, int32_t len, int32_t points, char *output,
+                          int32_t algorithm, char *buffer, int32_t bufferSize) {
+  int32_t size = points * ((type == TSDB_DATA_TYPE_FLOAT) ? 4 : 8);
+  if (type == TSDB_DATA_TYPE_FLOAT) {
+    return tsDecompressFloat(input, len, points, output, size, algorithm, buffer, bufferSize);
+  }
+  return tsDecompressDouble(input, len, points, output, size, algorithm, buffer, bufferSize);
+}
+
+// encode the column again by each codec, values are the decoded column
+static void measureColumn(int32_t type, const char *values, int32_t points, int32_t algorithm, int32_t storedLen) {
+  SCodecReport *pReport = &reports[(type == TSDB_DATA_TYPE_FLOAT) ? 0 : 1];
+  int32_t       size = points * ((type == TSDB_DATA_TYPE_FLOAT) ? 4 : 8);
+  int32_t       bufferSize = size + 1024;
+  char *        output = malloc((size_t)bufferSize);
+  char *        decoded = malloc((size_t)size);
+  char *        buffer = malloc((size_t)bufferSize);
+
+  pReport->columns++;
+  pReport->values += points;
+  pReport->rawBytes += size;
+  pReport->storedBytes += storedLen;
+
+  for (int32_t codec = 0; codec < NUM_OF_CODECS; ++codec) {
+    int32_t len = 0;
+    tsFloatCompression = codec;
+
+    int64_t st = getTimeStampNs();
+    for (int32_t r = 0; r < arguments.rounds; ++r) len = compress(type, values, points, output, algorithm, buffer, bufferSize);
+    pReport->encodeNs[codec] += getTimeStampNs() - st;
+
+    st = getTimeStampNs();
+    for (int32_t r = 0; r < arguments.rounds; ++r) decompress(type, output, len, points, decoded, algorithm, buffer, bufferSize);
+    pReport->decodeNs[codec] += getTimeStampNs() - st;
+
+    pReport->compBytes[codec] += len;
+    if (memcmp(decoded, values, (size_t)size) != 0) pReport->errors++;
+  }
+
+  free(output);
+  free(decoded);
+  free(buffer);
+}
+
+static int32_t readBlockColumns(int dfd, SCompBlock *pBlock) {
+  int32_t fieldsSize = sizeof(SField) * pBlock->numOfCols + sizeof(TSCKSUM);
+  SField *pFields = malloc((size_t)fieldsSize);
+
+  if (pread(dfd, pFields, (size_t)fieldsSize, pBlock->offset) != fieldsSize ||
+      !taosCheckChecksumWhole((uint8_t *)pFields, fieldsSize)) {
+    fprintf(stderr, "failed to read fields of block at offset:%ld\n", (long)pBlock->offset);
+    free(pFields);
+    return -1;
+  }
+
+  for (int32_t col = 0; col < pBlock->numOfCols; ++col) {
+    SField *pField = pFields + col;
+    if (pField->type != TSDB_DATA_TYPE_FLOAT && pField->type != TSDB_DATA_TYPE_DOUBLE) continue;
+
+    int32_t size = pBlock->numOfPoints * pField->bytes;
+    int32_t bufferSize = size + 1024;
+    char *  data = malloc((size_t)pField->len);
+    char *  values = malloc((size_t)bufferSize);
+    char *  buffer = malloc((size_t)bufferSize);
+
+    if (pread(dfd, data, (size_t)pField->len, pBlock->offset + pField->offset) == pField->len) {
+      if (pBlock->algorithm) {
+        decompress(pField->type, data, pField->len, pBlock->numOfPoints, values, pBlock->algorithm, buffer,
+                   bufferSize);
+      } else {
+        memcpy(values, data, (size_t)size);
+      }
+
+      measureColumn(pField->type, values, pBlock->numOfPoints, pBlock->algorithm ? pBlock->algorithm : ONE_STAGE_COMP,
+                    pBlock->algorithm ? pField->len : size + 1);
+    }
+
+    free(data);
+    free(values);
+    free(buffer);
+  }
+
+  free(pFields);
+  return 0;
+}
+
+/*
+ * The comp info of the first table written follows the comp headers right away, so its offset tells the number of
+ * comp headers, which is the maxSessions of the vnode.
+ */
+static int32_t detectTables(int hfd) {
+  for (int32_t sid = 0;; ++sid) {
+    int64_t offset = 0;
+    if (pread(hfd, &offset, sizeof(offset), TSDB_FILE_HEADER_LEN + sid * sizeof(SCompHeader)) != sizeof(offset)) {
+      return 0;  // no table is written yet
+    }
+    if (offset == 0) continue;
+
+    int32_t tables = (int32_t)((offset - TSDB_FILE_HEADER_LEN - (int64_t)sizeof(TSCKSUM)) / sizeof(SCompHeader));
+    return (tables > sid) ? tables : -1;
+  }
+}
+
+static void reportFile(const char *headName) {
+  char dataName[300], lastName[300];
+  int  len = (int)strlen(headName) - 5;
+
+  sprintf(dataName, "%.*s.data", len, headName);
+  sprintf(lastName, "%.*s.last", len, headName);
+
+  int hfd = open(headName, O_RDONLY);
+  int dfd = open(dataName, O_RDONLY);
+  int lfd = open(lastName, O_RDONLY);
+  if (hfd < 0 || dfd < 0 || lfd < 0) {
+    fprintf(stderr, "failed to open files of %s\n", headName);
+    goto _over;
+  }
+
+  int32_t tables = (arguments.tables > 0) ? arguments.tables : detectTables(hfd);
+  if (tables == 0) {
+    printf("%s: 0 blocks\n", headName);
+    goto _over;
+  } else if (tables < 0) {
+    fprintf(stderr, "%s: failed to find the number of tables, please give -tables\n", headName);
+    goto _over;
+  }
+
+  int32_t      headerSize = sizeof(SCompHeader) * tables + sizeof(TSCKSUM);
+  SCompHeader *pHeader = malloc((size_t)headerSize);
+  if (pread(hfd, pHeader, (size_t)headerSize, TSDB_FILE_HEADER_LEN) != headerSize ||
+      !taosCheckChecksumWhole((uint8_t *)pHeader, headerSize)) {
+    fprintf(stderr, "%s: invalid comp header with %d tables\n", headName, tables);
+    free(pHeader);
+    goto _over;
+  }
+
+  int64_t numOfBlocks = 0;
+  for (int32_t sid = 0; sid < tables; ++sid) {
+    if (pHeader[sid].compInfoOffset == 0) continue;
+
+    SCompInfo compInfo;
+    if (pread(hfd, &compInfo, sizeof(SCompInfo), pHeader[sid].compInfoOffset) != sizeof(SCompInfo)) continue;
+    if (compInfo.delimiter != TSDB_VNODE_DELIMITER || compInfo.numOfBlocks <= 0) continue;
+
+    int32_t     blocksSize = (int32_t)(sizeof(SCompBlock) * compInfo.numOfBlocks);
+    SCompBlock *pBlocks = malloc((size_t)blocksSize);
+    if (pread(hfd, pBlocks, (size_t)blocksSize, pHeader[sid].compInfoOffset + sizeof(SCompInfo)) == blocksSize) {
+      for (int64_t i = 0; i < compInfo.numOfBlocks; ++i) {
+        readBlockColumns(pBlocks[i].last ? lfd : dfd, pBlocks + i);
+      }
+      numOfBlocks += compInfo.numOfBlocks;
+    }
+    free(pBlocks);
+  }
+
+  printf("%s: %" PRId64 " blocks\n", headName, numOfBlocks);
+  free(pHeader);
+
+_over:
+  if (hfd >= 0) close(hfd);
+  if (dfd >= 0) close(dfd);
+  if (lfd >= 0) close(lfd);
+}
+
+static void reportDir(const char *dir) {
+  DIR *pDir = opendir(dir);
+  if (pDir == NULL) {
+    fprintf(stderr, "failed to open dir:%s\n", dir);
+    exit(EXIT_FAILURE);
+  }
+
+  struct dirent *de;
+  while ((de = readdir(pDir)) != NULL) {
+    int len = (int)strlen(de->d_name);
+    if (len <= 5 || strcmp(de->d_name + len - 5, ".head") != 0) continue;
+
+    char headName[300];
+    snprintf(headName, sizeof(headName), "%s/%s", dir, de->d_name);
+    reportFile(headName);
+  }
+
+  closedir(pDir);
+}
+
+/*
+ * Synthetic gauges: a temperature with 0.01 resolution and a slow drift, a voltage holding its value for a while,
+ * a smooth sine and random values, each in a float and a double column.
+ */
+static void reportSynthetic() {
+  int32_t points = 4096;
+  double *dvalues = malloc(sizeof(double) * points);
+  float * fvalues = malloc(sizeof(float) * points);
+
+  srand(1);
+  for (int32_t block = 0; block < 400; ++block) {
+    int32_t shape = block % 4;
+    double  v = 20 + rand() % 10;
+
+    for (int32_t i = 0; i < points; ++i) {
+      switch (shape) {
+        case 0:
+          v += (rand() % 5 - 2) * 0.01;
+          dvalues[i] = (int64_t)(v * 100 + 0.5) / 100.0;
+          break;
+        case 1:
+          if (rand() % 50 == 0) v = 220 + (rand() % 100) * 0.1;
+          dvalues[i] = v;
+          break;
+        case 2:
+          dvalues[i] = 100 * sin((block * points + i) * 0.001);
+          break;
+        default:
+          dvalues[i] = (double)rand() / RAND_MAX * 1e6;
+          break;
+      }
+      fvalues[i] = (float)dvalues[i];
+    }
+
+    measureColumn(TSDB_DATA_TYPE_DOUBLE, (char *)dvalues, points, ONE_STAGE_COMP, points * 8 + 1);
+    measureColumn(TSDB_DATA_TYPE_FLOAT, (char *)fvalues, points, ONE_STAGE_COMP, points * 4 + 1);
+  }
+
+  free(dvalues);
+  free(fvalues);
+}
+
+int main(int argc, char *argv[]) {
+  parseArg(argc, argv);
+
+  if (arguments.dir[0] != 0) {
+    reportDir(arguments.dir);
+  } else {
+    printf("no -dir given, synthetic gauges are used\n");
+    reportSynthetic();
+  }
+
+  for (int32_t t = 0; t < 2; ++t) {
+    SCodecReport *pReport = &reports[t];
+    if (pReport->columns == 0) continue;
+
+    printf("%s: %" PRId64 " columns, %" PRId64 " values, raw:%.2f MB, stored:%.2f%%\n", (t == 0) ? "float" : "double",
+           pReport->columns, pReport->values, pReport->rawBytes / 1048576.0,
+           pReport->storedBytes * 100.0 / pReport->rawBytes);
+
+    for (int32_t codec = 0; codec < NUM_OF_CODECS; ++codec) {
+      double mb = (double)pReport->rawBytes * arguments.rounds / 1048576.0;
+      printf("  %-9s ratio:%6.2f%%  encode:%9.2f MB/s  decode:%9.2f MB/s\n", codecName[codec],
+             pReport->compBytes[codec] * 100.0 / pReport->rawBytes, mb / (pReport->encodeNs[codec] / 1e9),
+             mb / (pReport->decodeNs[codec] / 1e9));
+    }
+
+    TH_CHECK(pReport->errors == 0, "%" PRId64 " %s columns are not decoded to the same values", pReport->errors,
+             (t == 0) ? "float" : "double");
+  }
+
+  return thReport("floatCodecTest");
+}
@@ -0,0 +1,282 @@
+/*
+ * With clog 2, an insert returns after its records in the commit log are synced to disk together with the records
+ * of the concurrent writers. Writers insert rows of their own tables in order, and taosd is killed with SIGKILL while
+ * they are writing, every row acknowledged before the kill shall be queried after taosd is started again.
+ *
+ * A failed sync can not be caused in taosd, so the commit log of vnodeCommit.c is also run in this program on a vnode
+ * of its own, with msync replaced by one that fails on demand. The writers of a batch failed to be synced, and the
+ * writers left in a log that failed to be synced when it is renewed, shall get an error, the others shall not.
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <inttypes.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "testHarness.h"
+#include "tglobalcfg.h"
+#include "tsdb.h"
+#include "tutil.h"
+#include "vnode.h"
+
+typedef struct {
+  int numOfThreads;
+  int numOfTables;
+  int rowsPerRequest;
+  int killAfterRows;
+} ProArgs;
+
+typedef struct {
+  int           first;  // tables written by a thread: first, first + numOfThreads, ...
+  volatile int *acked;  // rows of each table acknowledged by the server
+} SWriter;
+
+typedef struct {
+  int32_t sid;
+  int32_t numOfRecords;
+  int32_t failed;
+} SLogWriter;
+
+static ProArgs arguments;
+
+#define TEST_NAME "groupCommitTest"
+#define START_TS ((int64_t)1600000000000LL)
+#define MAX_SQL_LEN 65000
+#define MAX_TABLES 64
+
+static volatile int64_t totalAcked = 0;
+static volatile int     stopWriting = 0;
+
+void parseArg(int argc, char *argv[]) {
+  arguments.numOfThreads = 8;
+  arguments.numOfTables = 16;
+  arguments.rowsPerRequest = 20;
+  arguments.killAfterRows = 20000;
+
+  SThOption options[] = {TH_INT_OPTION("-threads", &arguments.numOfThreads),
+                         TH_INT_OPTION("-tables", &arguments.numOfTables),
+                         TH_INT_OPTION("-batch", &arguments.rowsPerRequest),
+                         TH_INT_OPTION("-killAfter", &arguments.killAfterRows)};
+  thParseArgs(argc, argv, options, tListLen(options));
+  arguments.numOfTables = MIN(arguments.numOfTables, MAX_TABLES);
+}
+
+/*
+ * stubs of the vnode, which the commit log calls when it is restored or full, the vnode of this program never has
+ * its log restored or committed
+ */
+SVnodeObj *vnodeList = NULL;
+int (*vnodeProcessAction[TSDB_ACTION_MAX])(SMeterObj *, char *, int, char, void *, int, int *, TSKEY);
+
+void  vnodeProcessCommitTimer(void *param, void *tmrId) {}
+void *vnodeCommitToFile(void *param) { return NULL; }
+bool  vnodeIsMeterState(SMeterObj *pMeterObj, int32_t state) { return false; }
+
+static volatile int failSync = 0;
+
+// msync of vnodeCommit.c in this program
+int msync(void *addr, size_t length, int flags) {
+  if (failSync) {
+    errno = EIO;
+    return -1;
+  }
+
+  return (int)syscall(SYS_msync, addr, length, flags);
+}
+
+/*
+ * a row is acknowledged only when the insert of it returns success, an insert in flight when taosd is killed may be
+ * retried on the taosd started again, the writers stop after it
+ */
+void *writeTables(void *param) {
+  SWriter *pWriter = (SWriter *)param;
+  TAOS *   taos = taos_connect("127.0.0.1", "root", "taosdata", "gc", 0);
+  char *   sql = malloc(MAX_SQL_LEN);
+
+  if (taos == NULL) {
+    free(sql);
+    return NULL;
+  }
+
+  for (bool failed = false; !failed && !stopWriting;) {
+    for (int t = pWriter->first; t < arguments.numOfTables; t += arguments.numOfThreads) {
+      int row = pWriter->acked[t];
+      int len = sprintf(sql, "insert into t%d values", t);
+      for (int n = 0; n < arguments.rowsPerRequest; ++n) {
+        len += sprintf(sql + len, "(%" PRId64 ",%d)", START_TS + row + n, row + n);
+      }
+
+      if (taos_query(taos, sql) != 0) {
+        failed = true;
+        break;
+      }
+
+      pWriter->acked[t] = row + arguments.rowsPerRequest;
+      __sync_fetch_and_add(&totalAcked, arguments.rowsPerRequest);
+    }
+  }
+
+  taos_close(taos);
+  free(sql);
+  return NULL;
+}
+
+void checkKilledWrites(TAOS *taos) {
+  volatile int acked[MAX_TABLES] = {0};
+
+  thExecute(taos, "create database gc clog 2");
+  thExecute(taos, "use gc");
+  thExecute(taos, "create table st (ts timestamp, v int) tags (t int)");
+  for (int t = 0; t < arguments.numOfTables; ++t) {
+    thExecute(taos, "create table t%d using st tags (%d)", t, t);
+  }
+
+  pthread_t threads[arguments.numOfThreads];
+  SWriter   writers[arguments.numOfThreads];
+  for (int i = 0; i < arguments.numOfThreads; ++i) {
+    writers[i].first = i;
+    writers[i].acked = acked;
+    pthread_create(threads + i, NULL, writeTables, writers + i);
+  }
+
+  int64_t start = thGetTimeUs();
+  while (totalAcked < arguments.killAfterRows && thGetTimeUs() - start < 60000000LL) usleep(1000);
+
+  taos_close(taos);
+  stopWriting = 1;
+  thCrashServer();
+
+  taos = thRestartServer(NULL, TEST_NAME, "clog 2\n");
+  thExecute(taos, "use gc");
+
+  for (int i = 0; i < arguments.numOfThreads; ++i) {
+    pthread_join(threads[i], NULL);
+  }
+
+  // rows of an insert that failed may be there or not, the acknowledged ones in front of them shall all be there
+  for (int t = 0; t < arguments.numOfTables; ++t) {
+    double count = thQueryValue(taos, "select count(*) from t%d where ts < %" PRId64, t, START_TS + acked[t]);
+    double sum = thQueryValue(taos, "select sum(v) from t%d where ts < %" PRId64, t, START_TS + acked[t]);
+    if (isnan(count)) count = 0;
+    if (isnan(sum)) sum = 0;
+
+    TH_CHECK(acked[t] > 0, "no row of t%d is acknowledged", t);
+    TH_CHECK(count == acked[t], "t%d, rows:%.0f, acknowledged:%d", t, count, acked[t]);
+    TH_CHECK(sum == (double)acked[t] * (acked[t] - 1) / 2, "t%d, sum:%.0f of %d acknowledged rows", t, sum, acked[t]);
+  }
+
+  thStopServer(taos);
+}
+
+// records of a writer are written one after another, each returns after it is synced or failed
+void *writeLog(void *param) {
+  SLogWriter *pWriter = (SLogWriter *)param;
+  SMeterObj   obj;
+  char        cont[100];
+
+  memset(&obj, 0, sizeof(obj));
+  obj.vnode = 0;
+  obj.sid = pWriter->sid;
+  memset(cont, pWriter->sid, sizeof(cont));
+
+  for (int i = 0; i < pWriter->numOfRecords; ++i) {
+    if (vnodeWriteToCommitLog(&obj, TSDB_ACTION_INSERT, cont, sizeof(cont), 0) != 0) pWriter->failed++;
+  }
+
+  return NULL;
+}
+
+static int32_t writeLogConcurrently(int numOfWriters, int numOfRecords) {
+  pthread_t  threads[numOfWriters];
+  SLogWriter writers[numOfWriters];
+  int32_t    failed = 0;
+
+  for (int i = 0; i < numOfWriters; ++i) {
+    writers[i] = (SLogWriter){.sid = i, .numOfRecords = numOfRecords, .failed = 0};
+    pthread_create(threads + i, NULL, writeLog, writers + i);
+  }
+
+  for (int i = 0; i < numOfWriters; ++i) {
+    pthread_join(threads[i], NULL);
+    failed += writers[i].failed;
+  }
+
+  return failed;
+}
+
+void *renewLog(void *param) {
+  usleep(100000);
+  vnodeRenewCommitLog(0);
+  return NULL;
+}
+
+void checkFailedSync() {
+  char cmd[1200];
+  snprintf(tsDirectory, TSDB_FILENAME_LEN, "%s/clog", thGetServerDir());
+  snprintf(cmd, sizeof(cmd), "rm -rf %s && mkdir -p %s/vnode0/db", tsDirectory, tsDirectory);
+  TH_CHECK(system(cmd) == 0, "failed to create %s", tsDirectory);
+
+  tsPageSize = sysconf(_SC_PAGESIZE);
+  tsCommitLogSyncDelay = 10;
+
+  vnodeList = calloc(1, sizeof(SVnodeObj));
+  SVnodeObj *pVnode = vnodeList;
+  pVnode->vnode = 0;
+  pVnode->cfg.maxSessions = 16;
+  pVnode->cfg.commitLog = TSDB_COMMIT_LOG_SYNC;
+  pVnode->cfg.cacheBlockSize = 16384;
+  pVnode->cfg.cacheNumOfBlocks.totalBlocks = 256;
+
+  TH_CHECK(vnodeInitCommit(0) == 0, "failed to init the commit log");
+
+  int32_t failed = writeLogConcurrently(8, 100);
+  TH_CHECK(failed == 0, "%d records failed while msync succeeds", failed);
+  TH_CHECK(pVnode->logSyncedLen == pVnode->pWrite - pVnode->pMem, "synced:%" PRId64 ", written:%" PRId64,
+           pVnode->logSyncedLen, (int64_t)(pVnode->pWrite - pVnode->pMem));
+
+  failSync = 1;
+  failed = writeLogConcurrently(8, 20);
+  TH_CHECK(failed == 8 * 20, "%d of %d records failed while msync fails", failed, 8 * 20);
+
+  failSync = 0;
+  failed = writeLogConcurrently(8, 20);
+  TH_CHECK(failed == 0, "%d records failed after msync succeeds again", failed);
+
+  // the writer waits for a batch held for 1s, the log is renewed before with a failed sync of it
+  tsCommitLogSyncDelay = 1000;
+  failSync = 1;
+
+  pthread_t thread;
+  pthread_create(&thread, NULL, renewLog, NULL);
+  failed = writeLogConcurrently(1, 1);
+  pthread_join(thread, NULL);
+  TH_CHECK(failed == 1, "a record in the log renewed with a failed sync is acknowledged");
+  TH_CHECK(pVnode->logGen == 1, "commit log is renewed %d times, expected once", pVnode->logGen);
+
+  failSync = 0;
+  tsCommitLogSyncDelay = 10;
+  failed = writeLogConcurrently(8, 20);
+  TH_CHECK(failed == 0, "%d records failed in the renewed log", failed);
+
+  vnodeCleanUpCommit(0);
+  free(vnodeList);
+  vnodeList = NULL;
+}
+
+int main(int argc, char *argv[]) {
+  parseArg(argc, argv);
+
+  TAOS *taos = thStartServer(TEST_NAME, "clog 2\n");
+  checkKilledWrites(taos);
+
+  checkFailedSync();
+
+  return thReport(TEST_NAME);
+}
@@ -0,0 +1,228 @@
+/*
+ * Out-of-order imports older than the files of a table are buffered and merged by commits or by the first query on the
+ * table. Rows with even timestamps are inserted and committed, then the odd ones are imported. Each import is queried
+ * right after it, before any commit, and the number of rows reported by an import of rows already buffered shall be 0.
+ * Then writers import the rest backwards while readers query the same tables all the time. No query may fail on the
+ * import buffers, and each row is in its table exactly once before and after the server is restarted.
+ */
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "testHarness.h"
+#include "tutil.h"
+
+typedef struct {
+  int numOfTables;
+  int rowsPerTable;
+  int rowsPerRequest;
+  int bufferRows;
+} ProArgs;
+
+typedef struct {
+  volatile int stop;
+  int64_t      queries;
+  int64_t      failures;
+  int64_t      maxUs;
+} SReader;
+
+static ProArgs arguments;
+
+#define START_TS ((int64_t)1600000000000LL)
+#define MAX_SQL_LEN 65000
+
+void parseArg(int argc, char *argv[]) {
+  arguments.numOfTables = 8;
+  arguments.rowsPerTable = 20000;
+  arguments.rowsPerRequest = 200;
+  arguments.bufferRows = 1000;
+
+  SThOption options[] = {TH_INT_OPTION("-tables", &arguments.numOfTables),
+                         TH_INT_OPTION("-rows", &arguments.rowsPerTable),
+                         TH_INT_OPTION("-batch", &arguments.rowsPerRequest),
+                         TH_INT_OPTION("-buffer", &arguments.bufferRows)};
+  thParseArgs(argc, argv, options, tListLen(options));
+}
+
+void prepareDb(TAOS *taos) {
+  thExecute(taos, "drop database if exists ib");
+  // the commit log holds all imports of importAndQuery, no commit merges the buffers between an import and its query
+  thExecute(taos, "create database ib tables %d cache 16384 ablocks 4 tblocks 16", arguments.numOfTables);
+  thExecute(taos, "use ib");
+  thExecute(taos, "create table st (ts timestamp, v int) tags (t int)");
+
+  for (int i = 0; i < arguments.numOfTables; ++i) {
+    thExecute(taos, "create table t%d using st tags (%d)", i, i);
+  }
+}
+
+// row i of a table has timestamp START_TS + i and value i, even rows are inserted in order, odd rows are imported
+int writeRows(TAOS *taos, char *sql, const char *action, int table, int first, int last, int step) {
+  int len = sprintf(sql, "%s into t%d values", action, table);
+  for (int row = first; step > 0 ? row <= last : row >= last; row += step) {
+    len += sprintf(sql + len, "(%" PRId64 ",%d)", START_TS + row, row);
+  }
+  return thExecute(taos, "%s", sql);
+}
+
+void insertEvenRows(TAOS *taos) {
+  char *sql = malloc(MAX_SQL_LEN);
+  int   batch = arguments.rowsPerRequest * 2;
+
+  for (int table = 0; table < arguments.numOfTables; ++table) {
+    for (int row = 0; row < arguments.rowsPerTable; row += batch) {
+      writeRows(taos, sql, "insert", table, row, MIN(row + batch, arguments.rowsPerTable) - 1, 2);
+    }
+  }
+
+  free(sql);
+}
+
+// the odd rows of the oldest quarter are imported batch by batch, each batch is checked by a query right after it
+void importAndQuery(TAOS *taos) {
+  char *sql = malloc(MAX_SQL_LEN);
+  int   batch = arguments.rowsPerRequest * 2;
+  int   evenRows = (arguments.rowsPerTable + 1) / 2;
+
+  for (int table = 0; table < arguments.numOfTables; ++table) {
+    int imported = 0;
+
+    for (int row = 1; row < arguments.rowsPerTable / 4; row += batch) {
+      int last = MIN(row + batch, arguments.rowsPerTable / 4) - 1;
+      int rows = (last - row) / 2 + 1;
+
+      writeRows(taos, sql, "import", table, row, last, 2);
+      TH_CHECK(taos_affected_rows(taos) == rows, "table:t%d, rows:%d reported by import, expected:%d", table,
+               taos_affected_rows(taos), rows);
+
+      // the rows are in the buffer, they are all dropped
+      writeRows(taos, sql, "import", table, row, last, 2);
+      TH_CHECK(taos_affected_rows(taos) == 0, "table:t%d, row:%d, rows:%d reported by import of the same rows, "
+               "expected:0", table, row, taos_affected_rows(taos));
+
+      imported += rows;
+      double count = thQueryValue(taos, "select count(*) from t%d", table);
+      TH_CHECK(count == evenRows + imported, "table:t%d, rows:%.0f right after import, expected:%d", table, count,
+               evenRows + imported);
+
+      int    lastOdd = row + (rows - 1) * 2;
+      double value = thQueryValue(taos, "select v from t%d where ts = %" PRId64, table, START_TS + lastOdd);
+      TH_CHECK(value == lastOdd, "table:t%d, value:%.0f of the last row imported, expected:%d", table, value, lastOdd);
+    }
+  }
+
+  free(sql);
+}
+
+// the rest of the odd rows are imported from the newest backwards
+void *writeTables(void *param) {
+  TAOS *taos = taos_connect("127.0.0.1", "root", "taosdata", "ib", 0);
+  char *sql = malloc(MAX_SQL_LEN);
+
+  TH_CHECK(taos != NULL, "failed to connect");
+  if (taos == NULL) return NULL;
+
+  int rows = arguments.rowsPerTable;
+  int batch = arguments.rowsPerRequest * 2;
+  int first = (rows / 4) | 1;
+
+  for (int row = (rows - 1) | 1; row >= first; row -= batch) {
+    int last = MAX(row - batch + 2, first);
+    for (int table = 0; table < arguments.numOfTables; ++table) {
+      writeRows(taos, sql, "import", table, row >= rows ? row - 2 : row, last, -2);
+    }
+  }
+
+  free(sql);
+  taos_close(taos);
+  return NULL;
+}
+
+void *queryTables(void *param) {
+  SReader *pReader = (SReader *)param;
+  TAOS *   taos = taos_connect("127.0.0.1", "root", "taosdata", "ib", 0);
+
+  TH_CHECK(taos != NULL, "failed to connect");
+  if (taos == NULL) return NULL;
+
+  while (!pReader->stop) {
+    int     table = (int)(pReader->queries % arguments.numOfTables);
+    char    buf[64];
+    int64_t st = thGetTimeUs();
+    int32_t rows = thQueryRows(taos, buf, sizeof(buf), "select count(*) from t%d", table);
+    int64_t us = thGetTimeUs() - st;
+
+    pReader->queries++;
+    if (rows < 0) pReader->failures++;
+    if (us > pReader->maxUs) pReader->maxUs = us;
+  }
+
+  taos_close(taos);
+  return NULL;
+}
+
+void checkTables(TAOS *taos, const char *when) {
+  int64_t rows = arguments.rowsPerTable;
+  double  sum = (double)rows * (rows - 1) / 2;
+
+  for (int i = 0; i < arguments.numOfTables; ++i) {
+    double count = thQueryValue(taos, "select count(*) from t%d", i);
+    TH_CHECK(count == rows, "%s, table:t%d, rows:%.0f, expected:%" PRId64, when, i, count, rows);
+
+    double value = thQueryValue(taos, "select sum(v) from t%d", i);
+    TH_CHECK(value == sum, "%s, table:t%d, sum:%.0f, expected:%.0f", when, i, value, sum);
+
+    // rows are returned in the order of timestamp, so the last value is the one of the last row
+    double last = thQueryValue(taos, "select last(v) from t%d", i);
+    TH_CHECK(last == rows - 1, "%s, table:t%d, last:%.0f, expected:%" PRId64, when, i, last, rows - 1);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  parseArg(argc, argv);
+
+  char cfg[64];
+  snprintf(cfg, sizeof(cfg), "importBufferRows %d\n", arguments.bufferRows);
+  TAOS *taos = thStartServer("importBufferTest", cfg);
+
+  prepareDb(taos);
+  insertEvenRows(taos);
+
+  // rows are committed into files, older rows imported then are buffered
+  taos = thRestartServer(taos, "importBufferTest", cfg);
+  thExecute(taos, "use ib");
+
+  importAndQuery(taos);
+
+  SReader   reader = {0};
+  pthread_t writer, querier;
+
+  int64_t st = thGetTimeUs();
+  pthread_create(&querier, NULL, queryTables, &reader);
+  pthread_create(&writer, NULL, writeTables, NULL);
+  pthread_join(writer, NULL);
+  double seconds = (double)(thGetTimeUs() - st) / 1000000;
+
+  reader.stop = 1;
+  pthread_join(querier, NULL);
+
+  TH_CHECK(reader.failures == 0, "%" PRId64 " of %" PRId64 " queries failed while rows were imported", reader.failures,
+           reader.queries);
+
+  printf("tables:%d, rows:%d, time:%.2f seconds, queries:%" PRId64 ", max query time:%.1f ms\n",
+         arguments.numOfTables, arguments.rowsPerTable, seconds, reader.queries, reader.maxUs / 1000.0);
+
+  checkTables(taos, "before restart");
+
+  // the buffers left are merged by the commit of the stopping server, or replayed from the commit log
+  taos = thRestartServer(taos, "importBufferTest", cfg);
+  thExecute(taos, "use ib");
+  checkTables(taos, "after restart");
+
+  thStopServer(taos);
+  return thReport("importBufferTest");
+}
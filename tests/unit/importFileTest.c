@@ -0,0 +1,168 @@
+/*
+ * Data files of "insert into ... file" are parsed by a pool of threads and sent to their vnodes concurrently. Files of
+ * several sizes, whose lines repeat timestamps now and then, are loaded in one statement by one thread and by the
+ * pool, and then with a failing file at the end. Affected rows, the error message and the rows of each table shall be
+ * as the serial loader leaves them.
+ */
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "testHarness.h"
+#include "tglobalcfg.h"
+#include "tutil.h"
+
+typedef struct {
+  int numOfFiles;
+  int rows;  // rows of the largest file
+  int numOfThreads;
+  int badRow;
+} ProArgs;
+
+// the outcome of a load, results are the rows of all tables
+typedef struct {
+  int32_t code;
+  int32_t affectedRows;
+  char    reason[256];
+  int32_t numOfRows;
+  char *  results;
+} SLoadResult;
+
+static ProArgs arguments;
+
+#define START_TS ((int64_t)1600000000000LL)
+#define MAX_SQL_LEN 65000
+#define RESULT_LEN (64 * 1024 * 1024)
+
+void parseArg(int argc, char *argv[]) {
+  arguments.numOfFiles = 4;
+  arguments.rows = 200000;
+  arguments.numOfThreads = 4;
+  arguments.badRow = 100;
+
+  SThOption options[] = {TH_INT_OPTION("-files", &arguments.numOfFiles),
+                         TH_INT_OPTION("-rows", &arguments.rows),
+                         TH_INT_OPTION("-threads", &arguments.numOfThreads),
+                         TH_INT_OPTION("-badRow", &arguments.badRow)};
+  thParseArgs(argc, argv, options, tListLen(options));
+}
+
+void getFilePath(char *path, int size, int f) { snprintf(path, size, "%s/data%d.csv", thGetServerDir(), f); }
+
+// every 1000th line repeats the timestamp of the line before it, which insert drops, so the order of rows matters.
+// File f has fewer rows than the one before it, and the bad file has an unparsable line at badRow, before its first
+// submit is full
+void writeFile(int f, int rows, bool bad) {
+  char path[600];
+  getFilePath(path, sizeof(path), f);
+
+  FILE *fp = fopen(path, "w");
+  TH_CHECK(fp != NULL, "failed to create %s", path);
+  if (fp == NULL) return;
+
+  for (int r = 0; r < rows; ++r) {
+    int64_t ts = START_TS + (int64_t)(r - (r % 1000 == 999)) * 10;
+    if (bad && r == arguments.badRow) {
+      fprintf(fp, "%" PRId64 ",bad,0.5,'line%d'\n", ts, r);
+    } else {
+      fprintf(fp, "%" PRId64 ",%d,%f,'f%d_line%d'\n", ts, f * 1000000 + r, r * 0.5, f, r);
+    }
+  }
+
+  fclose(fp);
+}
+
+int getFileRows(int f) { return arguments.rows / (f + 1); }
+
+void loadFiles(TAOS *taos, const char *db, int numOfThreads, bool withBadFile, SLoadResult *pResult) {
+  char *sql = malloc(MAX_SQL_LEN);
+  int   numOfFiles = arguments.numOfFiles + (withBadFile ? 1 : 0);
+
+  thExecute(taos, "drop database if exists %s", db);
+  // rows of a table fit in the cache, vnode does not count the rows written before it asks to resend a submit
+  thExecute(taos, "create database %s tables 4 cache 1048576 ablocks 8", db);
+  thExecute(taos, "use %s", db);
+  thExecute(taos, "create table st (ts timestamp, i int, d double, b binary(24)) tags (t int)");
+
+  int len = sprintf(sql, "insert into");
+  for (int f = 0; f < numOfFiles; ++f) {
+    char path[600];
+    getFilePath(path, sizeof(path), f);
+    thExecute(taos, "create table t%d using st tags (%d)", f, f);
+    len += sprintf(sql + len, " t%d file '%s'", f, path);
+  }
+
+  // the client reads importThreads once, a load in the calling thread is the serial one
+  tsImportThreads = numOfThreads;
+
+  int64_t st = thGetTimeUs();
+  pResult->code = taos_query(taos, sql);
+  pResult->affectedRows = taos_affected_rows(taos);
+  snprintf(pResult->reason, sizeof(pResult->reason), "%s", (pResult->code == 0) ? "success" : taos_errstr(taos));
+  int64_t us = thGetTimeUs() - st;
+
+  printf("%s, threads:%d, files:%d, code:%d, affected rows:%d, time:%.1f ms, %s\n", db, numOfThreads, numOfFiles,
+         pResult->code, pResult->affectedRows, us / 1000.0, pResult->reason);
+
+  // a projection may miss rows of the cache while they are being committed, the load is followed by commits
+  int32_t count = (int32_t)thQueryValue(taos, "select count(*) from st");
+  pResult->results = malloc(RESULT_LEN);
+  for (int i = 0; i < 10; ++i) {
+    pResult->numOfRows = thQueryRows(taos, pResult->results, RESULT_LEN, "select t, ts, i, d, b from st order by t");
+    if (pResult->numOfRows == count) break;
+    usleep(100000);
+  }
+
+  free(sql);
+}
+
+void compareLoads(SLoadResult *pSerial, SLoadResult *pParallel, const char *name) {
+  TH_CHECK(pParallel->code == pSerial->code, "%s, code:%d, expected:%d", name, pParallel->code, pSerial->code);
+  TH_CHECK(strcmp(pParallel->reason, pSerial->reason) == 0, "%s, reason:%s, expected:%s", name, pParallel->reason,
+           pSerial->reason);
+  TH_CHECK(pParallel->affectedRows == pSerial->affectedRows, "%s, affected rows:%d, expected:%d", name,
+           pParallel->affectedRows, pSerial->affectedRows);
+  TH_CHECK(pParallel->numOfRows == pSerial->numOfRows, "%s, rows:%d, expected:%d", name, pParallel->numOfRows,
+           pSerial->numOfRows);
+  TH_CHECK(strcmp(pParallel->results, pSerial->results) == 0, "%s, rows differ from the serial load", name);
+
+  free(pSerial->results);
+  free(pParallel->results);
+}
+
+int main(int argc, char *argv[]) {
+  parseArg(argc, argv);
+
+  TAOS *taos = thStartServer("importFileTest", NULL);
+
+  // the pool is used on machines with fewer cores as well
+  tsNumOfCores = MAX(tsNumOfCores, arguments.numOfThreads);
+
+  int expected = 0;
+  for (int f = 0; f < arguments.numOfFiles; ++f) {
+    writeFile(f, getFileRows(f), false);
+    expected += getFileRows(f) - getFileRows(f) / 1000;
+  }
+  writeFile(arguments.numOfFiles, arguments.badRow * 2, true);
+
+  SLoadResult serial = {0}, parallel = {0};
+  loadFiles(taos, "ifserial", 1, false, &serial);
+  loadFiles(taos, "ifparallel", arguments.numOfThreads, false, &parallel);
+
+  TH_CHECK(serial.code == 0, "serial load failed, reason:%s", serial.reason);
+  TH_CHECK(serial.numOfRows == expected, "serial load, rows:%d, expected:%d", serial.numOfRows, expected);
+  compareLoads(&serial, &parallel, "files");
+
+  // the failing file is the last one, the serial loader reports the error of the last file only
+  loadFiles(taos, "ifserial", 1, true, &serial);
+  loadFiles(taos, "ifparallel", arguments.numOfThreads, true, &parallel);
+
+  TH_CHECK(serial.code != 0, "serial load of a bad file succeeded");
+  compareLoads(&serial, &parallel, "files with a bad one");
+
+  thStopServer(taos);
+  return thReport("importFileTest");
+}
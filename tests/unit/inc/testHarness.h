@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TDENGINE_TEST_HARNESS_H
+#define TDENGINE_TEST_HARNESS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "taos.h"
+
+/*
+ * Shared by the unit tests under tests/unit. A test is a program that returns 0 when all checks pass, options
+ * given on the command line make the checks or the benchmarks larger, ctest runs them with the defaults.
+ */
+
+// the exit code of a test that can not run here, e.g., taosd is not built, ctest reports it as skipped
+#define TH_SKIP_CODE 77
+
+#define TH_OPTION_INT 0
+#define TH_OPTION_STR 1
+
+typedef struct {
+  const char *name;
+  int32_t     type;
+  void *      value;
+  int32_t     size;  // buffer size of a string option
+} SThOption;
+
+#define TH_INT_OPTION(name, pValue) \
+  { (name), TH_OPTION_INT, (pValue), sizeof(int32_t) }
+#define TH_STR_OPTION(name, buf) \
+  { (name), TH_OPTION_STR, (buf), sizeof(buf) }
+
+void thParseArgs(int argc, char *argv[], SThOption *pOptions, int32_t numOfOptions);
+
+int64_t thGetTimeUs();
+
+// a failed check is reported with its position and counted, the test goes on
+void thCheck(bool passed, const char *file, int32_t line, const char *format, ...);
+#define TH_CHECK(passed, ...) thCheck((passed), __FILE__, __LINE__, __VA_ARGS__)
+
+int32_t thGetFailures();
+
+// print the result of the test and return its exit code
+int32_t thReport(const char *name);
+
+/*
+ * Start a taosd of the test in the build directory, on ports that do not conflict with a server running with the
+ * default configuration. Extra configuration lines, e.g., "queryParallelism 4\n", are appended to taos.cfg. The
+ * client of the test is initialized with the same configuration and connected. The test exits with TH_SKIP_CODE if
+ * the server is not built or does not start.
+ */
+TAOS *thStartServer(const char *name, const char *cfg);
+void  thStopServer(TAOS *taos);
+
+// stop the server and start it again on the same data with the new extra configuration, cache data are committed
+TAOS *thRestartServer(TAOS *taos, const char *name, const char *cfg);
+
+// kill the server with SIGKILL as if it crashed, nothing is committed, thRestartServer with a NULL taos starts it again
+void thCrashServer();
+
+// directory of the server of the test, its data are in data/ and its logs in log/
+const char *thGetServerDir();
+
+// execute a statement, a failure is counted as a failed check and the code is returned
+int32_t thExecute(TAOS *taos, const char *format, ...);
+
+/*
+ * Execute a query and print the rows into buf, one row per line and columns separated by a space. The number of
+ * rows is returned, or -1 if the query fails. Results of different queries can be compared as strings.
+ */
+int32_t thQueryRows(TAOS *taos, char *buf, int32_t size, const char *format, ...);
+
+// the first column of the first row as a double, NAN if the query fails or returns nothing
+double thQueryValue(TAOS *taos, const char *format, ...);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TDENGINE_TEST_HARNESS_H
@@ -0,0 +1,170 @@
+/*
+ * Time to sort the rows of a table and remove the duplicated timestamps before they are sent, compared with the
+ * qsort and compaction formerly used by sortRemoveDuplicates:
+ *   ordered : ascending, with a few duplicated timestamps
+ *   jitter  : fixed interval with a random jitter of a few intervals, as reported by devices through a gateway
+ *   late    : ascending, with 1% of the rows arriving up to 100 intervals late
+ *   reversed: descending
+ *   random  : random timestamps in a day
+ *
+ * Rows are checked against the qsort result. Of the rows with the same timestamp the first one is kept.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "testHarness.h"
+#include "tscUtil.h"
+#include "tsclient.h"
+
+typedef struct {
+  int32_t rows;
+  int32_t blocks;
+  int32_t rowSize;
+  int32_t rounds;
+} ProArgs;
+
+static ProArgs arguments;
+
+static const char *typeName[] = {"ordered", "jitter", "late", "reversed", "random"};
+
+void parseArg(int argc, char *argv[]) {
+  arguments.rows = 4096;
+  arguments.blocks = 256;
+  arguments.rowSize = 32;
+  arguments.rounds = 5;
+
+  SThOption options[] = {TH_INT_OPTION("-rows", &arguments.rows), TH_INT_OPTION("-blocks", &arguments.blocks),
+                         TH_INT_OPTION("-rowSize", &arguments.rowSize), TH_INT_OPTION("-rounds", &arguments.rounds)};
+  thParseArgs(argc, argv, options, tListLen(options));
+
+  if (arguments.rowSize < 16) arguments.rowSize = 16;
+  if (arguments.rows > INT16_MAX) arguments.rows = INT16_MAX;
+}
+
+// the second column of a row is its position in the block, to check which of the duplicated rows is kept
+static void generate(char *payload, int32_t rows, int32_t rowSize, int32_t type) {
+  int64_t ts = 1600000000000L + rand() % 100000;
+
+  for (int32_t i = 0; i < rows; ++i) {
+    int64_t k = 0;
+    if (type == 0) {
+      k = ts + i * 1000L - ((rand() % 100 == 0) ? 1000 : 0);
+    } else if (type == 1) {
+      k = ts + i * 1000L + (rand() % 6001) - 3000;
+    } else if (type == 2) {
+      k = ts + i * 1000L - ((rand() % 100 == 0) ? (rand() % 100) * 1000L : 0);
+    } else if (type == 3) {
+      k = ts + (rows - i) * 1000L;
+    } else {
+      k = ts + rand() % 86400000L;
+    }
+
+    char *row = payload + (int64_t)rowSize * i;
+    memset(row, 0, (size_t)rowSize);
+    *(int64_t *)row = k;
+    *(int32_t *)(row + 8) = i;
+  }
+}
+
+static int32_t rowCompar(const void *lhs, const void *rhs) {
+  int64_t left = *(int64_t *)lhs;
+  int64_t right = *(int64_t *)rhs;
+
+  if (left == right) {
+    // the position makes the result deterministic, the first row is kept
+    return *(int32_t *)((char *)lhs + 8) - *(int32_t *)((char *)rhs + 8);
+  }
+  return left > right ? 1 : -1;
+}
+
+static int32_t qsortRemoveDuplicates(char *payload, int32_t rows, int32_t rowSize) {
+  qsort(payload, rows, rowSize, rowCompar);
+
+  int32_t i = 0;
+  for (int32_t j = 1; j < rows; ++j) {
+    if (*(int64_t *)(payload + rowSize * i) == *(int64_t *)(payload + rowSize * j)) continue;
+    if (++i != j) memmove(payload + rowSize * i, payload + rowSize * j, rowSize);
+  }
+
+  return i + 1;
+}
+
+static void setBlock(STableDataBlocks *pBlock, char *pData, int32_t rows, int32_t rowSize) {
+  memset(pBlock, 0, sizeof(STableDataBlocks));
+  pBlock->tsSource = 1;  // timestamps come from the client
+  pBlock->ordered = false;
+  pBlock->rowSize = rowSize;
+  pBlock->headerSize = sizeof(SShellSubmitBlock);
+  pBlock->size = sizeof(SShellSubmitBlock) + rows * rowSize;
+  pBlock->nAllocSize = pBlock->size;
+  pBlock->pData = pData;
+
+  ((SShellSubmitBlock *)pData)->numOfRows = rows;
+}
+
+static void benchmark(int32_t type) {
+  int32_t rows = arguments.rows;
+  int32_t rowSize = arguments.rowSize;
+  int64_t blockSize = sizeof(SShellSubmitBlock) + (int64_t)rows * rowSize;
+  char *  input = malloc((size_t)blockSize * arguments.blocks);
+  char *  expect = malloc((size_t)blockSize * arguments.blocks);
+  char *  output = malloc((size_t)blockSize * arguments.blocks);
+  int32_t *expectRows = malloc(sizeof(int32_t) * arguments.blocks);
+
+  STableDataBlocks block;
+
+  for (int32_t b = 0; b < arguments.blocks; ++b) {
+    memset(input + blockSize * b, 0, sizeof(SShellSubmitBlock));
+    generate(input + blockSize * b + sizeof(SShellSubmitBlock), rows, rowSize, type);
+  }
+
+  int64_t qsortUs = 0, sortUs = 0;
+  for (int32_t r = 0; r < arguments.rounds; ++r) {
+    memcpy(expect, input, (size_t)blockSize * arguments.blocks);
+    memcpy(output, input, (size_t)blockSize * arguments.blocks);
+
+    int64_t st = thGetTimeUs();
+    for (int32_t b = 0; b < arguments.blocks; ++b) {
+      expectRows[b] = qsortRemoveDuplicates(expect + blockSize * b + sizeof(SShellSubmitBlock), rows, rowSize);
+    }
+    qsortUs += thGetTimeUs() - st;
+
+    st = thGetTimeUs();
+    for (int32_t b = 0; b < arguments.blocks; ++b) {
+      setBlock(&block, output + blockSize * b, rows, rowSize);
+      sortRemoveDuplicates(&block);
+    }
+    sortUs += thGetTimeUs() - st;
+  }
+
+  for (int32_t b = 0; b < arguments.blocks; ++b) {
+    SShellSubmitBlock *pBlocks = (SShellSubmitBlock *)(output + blockSize * b);
+    TH_CHECK(pBlocks->numOfRows == expectRows[b] &&
+                 memcmp(pBlocks->payLoad, expect + blockSize * b + sizeof(SShellSubmitBlock),
+                        (size_t)rowSize * expectRows[b]) == 0,
+             "%s: rows of block %d differ", typeName[type], b);
+  }
+
+  double mrows = (double)rows * arguments.blocks * arguments.rounds / 1e6;
+  printf("%-8s qsort:%8.2f Mrows/s  sortRemoveDuplicates:%8.2f Mrows/s  speedup:%5.2fx\n", typeName[type],
+         mrows / (qsortUs / 1e6), mrows / (sortUs / 1e6), (double)qsortUs / sortUs);
+
+  free(input);
+  free(expect);
+  free(output);
+  free(expectRows);
+}
+
+int main(int argc, char *argv[]) {
+  parseArg(argc, argv);
+  srand(1);
+
+  printf("rows per block:%d, blocks:%d, row size:%d, rounds:%d\n", arguments.rows, arguments.blocks, arguments.rowSize,
+         arguments.rounds);
+
+  for (int32_t type = 0; type < 5; ++type) benchmark(type);
+
+  return thReport("insertSortTest");
+}
@@ -0,0 +1,224 @@
+/*
+ * Throughput of the simple8b integer codecs on data shaped like sensor readings, and a check that every codec
+ * produces the bytes of the reference one:
+ *   temperature : int, 0.01 degree, random walk with some spikes
+ *   humidity    : smallint, changes by 1 now and then
+ *   status      : tinyint, a code that seldom changes
+ *   adc         : smallint, noisy 12-bit readings
+ *   energy      : bigint, accumulated meter reading
+ *   random      : bigint, random values, the output is not compressed
+ *
+ * The throughput is the size of the raw values processed per second.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "testHarness.h"
+#include "tscompression.h"
+#include "tutil.h"
+
+#define NUM_OF_SHAPES 6
+
+typedef struct {
+  int32_t rows;
+  int32_t blocks;
+  int32_t rounds;
+} ProArgs;
+
+static ProArgs arguments;
+
+static const char *codecName[] = {"reference", "scalar", "sse4.2", "avx2"};
+static const char *shapeName[] = {"temperature", "humidity", "status", "adc", "energy", "random"};
+static const char  shapeType[] = {TSDB_DATA_TYPE_INT,      TSDB_DATA_TYPE_SMALLINT, TSDB_DATA_TYPE_TINYINT,
+                                 TSDB_DATA_TYPE_SMALLINT, TSDB_DATA_TYPE_BIGINT,   TSDB_DATA_TYPE_BIGINT};
+static const int   shapeBytes[] = {4, 2, 1, 2, 8, 8};
+
+void parseArg(int argc, char *argv[]) {
+  arguments.rows = 4096;
+  arguments.blocks = 1024;
+  arguments.rounds = 5;
+
+  SThOption options[] = {TH_INT_OPTION("-rows", &arguments.rows), TH_INT_OPTION("-blocks", &arguments.blocks),
+                         TH_INT_OPTION("-rounds", &arguments.rounds)};
+  thParseArgs(argc, argv, options, tListLen(options));
+}
+
+static int64_t random64() { return ((int64_t)rand() << 33) ^ ((int64_t)rand() << 11) ^ rand(); }
+
+static void generate(char *data, int32_t rows, int32_t shape) {
+  int64_t v = 0;
+
+  switch (shape) {
+    case 0: v = 2000 + rand() % 1000; break;
+    case 1: v = 40 + rand() % 50; break;
+    case 2: v = rand() % 4; break;
+    case 4: v = random64() % 100000000; break;
+    default: break;
+  }
+
+  for (int32_t i = 0; i < rows; ++i) {
+    switch (shape) {
+      case 0:
+        v += rand() % 11 - 5;
+        if (rand() % 200 == 0) v += rand() % 2000 - 1000;
+        ((int32_t *)data)[i] = (int32_t)v;
+        break;
+      case 1:
+        if (rand() % 20 == 0) v += (rand() % 2) ? 1 : -1;
+        ((int16_t *)data)[i] = (int16_t)v;
+        break;
+      case 2:
+        if (rand() % 1000 == 0) v = rand() % 4;
+        ((int8_t *)data)[i] = (int8_t)v;
+        break;
+      case 3:
+        ((int16_t *)data)[i] = (int16_t)(2048 + rand() % 64 - 32 + ((rand() % 100 == 0) ? rand() % 2048 : 0));
+        break;
+      case 4:
+        v += rand() % 200;
+        ((int64_t *)data)[i] = v;
+        break;
+      default:
+        ((int64_t *)data)[i] = random64();
+        break;
+    }
+  }
+}
+
+static int32_t compress(const char *input, int32_t rows, int32_t shape, char *output, char *buffer, int32_t algorithm) {
+  int32_t size = rows * shapeBytes[shape];
+  switch (shapeType[shape]) {
+    case TSDB_DATA_TYPE_TINYINT:
+      return tsCompressTinyint(input, size, rows, output, size + 1024, algorithm, buffer, size + 1024);
+    case TSDB_DATA_TYPE_SMALLINT:
+      return tsCompressSmallint(input, size, rows, output, size + 1024, algorithm, buffer, size + 1024);
+    case TSDB_DATA_TYPE_INT:
+      return tsCompressInt(input, size, rows, output, size + 1024, algorithm, buffer, size + 1024);
+    default:
+      return tsCompressBigint(input, size, rows, output, size + 1024, algorithm, buffer, size + 1024);
+  }
+}
+
+static int32_t decompress(const char *input, int32_t len, int32_t rows, int32_t shape, char *output, char *buffer,
+                          int32_t algorithm) {
+  int32_t size = rows * shapeBytes[shape];
+  switch (shapeType[shape]) {
+    case TSDB_DATA_TYPE_TINYINT:
+      return tsDecompressTinyint(input, len, rows, output, size, algorithm, buffer, size + 1024);
+    case TSDB_DATA_TYPE_SMALLINT:
+      return tsDecompressSmallint(input, len, rows, output, size, algorithm, buffer, size + 1024);
+    case TSDB_DATA_TYPE_INT:
+      return tsDecompressInt(input, len, rows, output, size, algorithm, buffer, size + 1024);
+    default:
+      return tsDecompressBigint(input, len, rows, output, size, algorithm, buffer, size + 1024);
+  }
+}
+
+/*
+ * Encode the same data by every codec and compare with the reference one, including short blocks, both algorithms
+ * and bigint values near the overflow bounds.
+ */
+static void checkCodecs(int32_t bestCodec) {
+  int32_t maxRows = 1100;
+  char *  input = malloc(maxRows * 8);
+  char *  expect = malloc(maxRows * 8 + 1024);
+  char *  output = malloc(maxRows * 8 + 1024);
+  char *  decoded = malloc(maxRows * 8);
+  char *  buffer = malloc(maxRows * 8 + 1024);
+
+  for (int32_t k = 0; k < 6000; ++k) {
+    int32_t rows = 1 + rand() % maxRows;
+    int32_t shape = k % NUM_OF_SHAPES;
+    int32_t algorithm = (k / NUM_OF_SHAPES % 2 == 0) ? ONE_STAGE_COMP : TWO_STAGE_COMP;
+
+    generate(input, rows, shape);
+    if (shape == 4 && k % 5 == 0) ((int64_t *)input)[rand() % rows] = (rand() % 2) ? INT64_MAX : INT64_MIN;
+    if (shape == 4 && k % 7 == 0) ((int64_t *)input)[rand() % rows] += (int64_t)1 << 58;
+
+    tsSetCompressCodec(TSDB_CODEC_REFERENCE);
+    int32_t expectLen = compress(input, rows, shape, expect, buffer, algorithm);
+
+    for (int32_t codec = TSDB_CODEC_SCALAR; codec <= bestCodec; ++codec) {
+      tsSetCompressCodec(codec);
+      int32_t len = compress(input, rows, shape, output, buffer, algorithm);
+      if (len != expectLen || memcmp(output, expect, (size_t)len) != 0) {
+        TH_CHECK(false, "%s: encoded bytes differ, rows:%d shape:%s", codecName[codec], rows, shapeName[shape]);
+        continue;
+      }
+
+      memset(decoded, 0, (size_t)rows * shapeBytes[shape]);
+      TH_CHECK(decompress(output, len, rows, shape, decoded, buffer, algorithm) == rows * shapeBytes[shape] &&
+                   memcmp(decoded, input, (size_t)rows * shapeBytes[shape]) == 0,
+               "%s: decoded values differ, rows:%d shape:%s", codecName[codec], rows, shapeName[shape]);
+    }
+  }
+
+  free(input);
+  free(expect);
+  free(output);
+  free(decoded);
+  free(buffer);
+}
+
+static void benchmark(int32_t shape, int32_t bestCodec) {
+  int32_t  rows = arguments.rows;
+  int32_t  blockSize = rows * shapeBytes[shape];
+  int64_t  rawSize = (int64_t)blockSize * arguments.blocks;
+  char *   input = malloc((size_t)rawSize);
+  char *   output = malloc((size_t)(blockSize + 1024) * arguments.blocks);
+  char *   decoded = malloc((size_t)rawSize);
+  int32_t *lens = malloc(sizeof(int32_t) * arguments.blocks);
+
+  for (int32_t b = 0; b < arguments.blocks; ++b) generate(input + (int64_t)b * blockSize, rows, shape);
+
+  for (int32_t codec = TSDB_CODEC_REFERENCE; codec <= bestCodec; ++codec) {
+    tsSetCompressCodec(codec);
+    int64_t encodeUs = 0, decodeUs = 0, compSize = 0;
+
+    for (int32_t r = 0; r < arguments.rounds; ++r) {
+      int64_t st = thGetTimeUs();
+      compSize = 0;
+      for (int32_t b = 0; b < arguments.blocks; ++b) {
+        lens[b] = compress(input + (int64_t)b * blockSize, rows, shape, output + (int64_t)b * (blockSize + 1024), NULL,
+                           ONE_STAGE_COMP);
+        compSize += lens[b];
+      }
+      encodeUs += thGetTimeUs() - st;
+
+      st = thGetTimeUs();
+      for (int32_t b = 0; b < arguments.blocks; ++b) {
+        decompress(output + (int64_t)b * (blockSize + 1024), lens[b], rows, shape, decoded + (int64_t)b * blockSize,
+                   NULL, ONE_STAGE_COMP);
+      }
+      decodeUs += thGetTimeUs() - st;
+    }
+
+    TH_CHECK(memcmp(decoded, input, (size_t)rawSize) == 0, "%s: decoded values differ", codecName[codec]);
+
+    double gb = (double)rawSize * arguments.rounds / 1e9;
+    printf("%-12s %-9s ratio:%6.2f%%  encode:%7.3f GB/s  decode:%7.3f GB/s\n", shapeName[shape], codecName[codec],
+           compSize * 100.0 / rawSize, gb / (encodeUs / 1e6), gb / (decodeUs / 1e6));
+  }
+
+  free(input);
+  free(output);
+  free(decoded);
+  free(lens);
+}
+
+int main(int argc, char *argv[]) {
+  parseArg(argc, argv);
+  srand(1);
+
+  int32_t bestCodec = tsSetCompressCodec(-1);
+  printf("rows per block:%d, blocks:%d, rounds:%d, best codec:%s\n", arguments.rows, arguments.blocks, arguments.rounds,
+         codecName[bestCodec]);
+
+  checkCodecs(bestCodec);
+
+  for (int32_t shape = 0; shape < NUM_OF_SHAPES; ++shape) benchmark(shape, bestCodec);
+
+  return thReport("intCodecTest");
+}
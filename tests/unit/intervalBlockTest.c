@@ -0,0 +1,249 @@
+/*
+ * Check interval and top/bottom queries of a table against results computed from the written rows. File blocks of
+ * 200 rows span about half of a 1h window, so some of them fall entirely into one window and are answered by their
+ * pre-aggregated values, while the others are split by window boundaries or by the time range of the query. Each
+ * query is checked with the rows in cache, and again after they are committed into files. With a filter on v, the
+ * selected rows of a window are fed to the functions in ranges of consecutive rows.
+ */
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "testHarness.h"
+#include "tutil.h"
+
+typedef struct {
+  int numOfRows;
+} ProArgs;
+
+static ProArgs arguments;
+
+#define TEST_NAME "intervalBlockTest"
+#define START_TS ((int64_t)1599998400000LL)  // aligned to an hour
+#define ROW_INTERVAL 10000LL
+#define MAX_SQL_LEN 65000
+#define MAX_RESULT_LEN (1024 * 1024)
+
+#define HOUR_MS 3600000LL
+#define MINUTE_MS 60000LL
+
+void parseArg(int argc, char *argv[]) {
+  arguments.numOfRows = 20000;
+
+  SThOption options[] = {TH_INT_OPTION("-rows", &arguments.numOfRows)};
+  thParseArgs(argc, argv, options, tListLen(options));
+}
+
+static int64_t getTs(int row) { return START_TS + row * ROW_INTERVAL; }
+
+// v is NULL in every 13th row, a few rows have unique large or small values, to be found by top/bottom
+static bool isNullRow(int row) { return row % 13 == 6; }
+
+static int getValue(int row) {
+  if (row % 1777 == 5) return 2000 + row;
+  if (row % 1999 == 7) return -1000 - row;
+  return (row * 7919) % 1000;
+}
+
+void writeRows(TAOS *taos) {
+  char *sql = malloc(MAX_SQL_LEN);
+
+  // a table keeps all its cache blocks of 200 rows, so no commit runs while the rows in cache are checked
+  thExecute(taos, "create database ib rows 200 tblocks 400");
+  thExecute(taos, "use ib");
+  thExecute(taos, "create table t (ts timestamp, v int, d double)");
+
+  for (int row = 0; row < arguments.numOfRows;) {
+    int len = sprintf(sql, "insert into t values");
+    for (int n = 0; n < 500 && row < arguments.numOfRows; ++n, ++row) {
+      if (isNullRow(row)) {
+        len += sprintf(sql + len, "(%" PRId64 ",NULL,NULL)", getTs(row));
+      } else {
+        len += sprintf(sql + len, "(%" PRId64 ",%d,%.1f)", getTs(row), getValue(row), getValue(row) * 0.5);
+      }
+    }
+
+    thExecute(taos, "%s", sql);
+  }
+
+  free(sql);
+}
+
+// v passes the filter "v >= vmin", vmin is INT32_MIN if there is no filter
+static bool isRowSelected(int row, int vmin) { return vmin == INT32_MIN || (!isNullRow(row) && getValue(row) >= vmin); }
+
+// rows of "select count(*), count(v), sum(v), min(v), max(v), avg(v), spread(v) ... interval(interval)"
+static void getAggrWindows(int64_t interval, int64_t skey, int64_t ekey, int vmin, char *buf) {
+  int len = 0;
+  buf[0] = 0;
+
+  for (int row = 0; row < arguments.numOfRows;) {
+    int64_t wstart = (getTs(row) / interval) * interval;
+    int64_t count = 0, countv = 0, sum = 0;
+    int     minv = INT32_MAX, maxv = INT32_MIN;
+
+    for (; row < arguments.numOfRows && getTs(row) < wstart + interval; ++row) {
+      if (getTs(row) < skey || getTs(row) > ekey || !isRowSelected(row, vmin)) continue;
+
+      count++;
+      if (isNullRow(row)) continue;
+
+      int v = getValue(row);
+      countv++;
+      sum += v;
+      if (v < minv) minv = v;
+      if (v > maxv) maxv = v;
+    }
+
+    if (count == 0) continue;
+
+    len += sprintf(buf + len, "%" PRId64 " %" PRId64 " %" PRId64 " %" PRId64 " %d %d %lf %lf\n", wstart, count, countv,
+                   sum, minv, maxv, (double)sum / countv, (double)maxv - minv);
+  }
+}
+
+// rows of "select count(*), first(v), last(v) ... interval(interval)"
+static void getFirstLastWindows(int64_t interval, int vmin, char *buf) {
+  int len = 0;
+  buf[0] = 0;
+
+  for (int row = 0; row < arguments.numOfRows;) {
+    int64_t wstart = (getTs(row) / interval) * interval;
+    int64_t count = 0;
+    int     first = -1, last = -1;
+
+    for (; row < arguments.numOfRows && getTs(row) < wstart + interval; ++row) {
+      if (!isRowSelected(row, vmin)) continue;
+
+      count++;
+      if (isNullRow(row)) continue;
+
+      if (first < 0) first = row;
+      last = row;
+    }
+
+    if (count == 0) continue;
+
+    len += sprintf(buf + len, "%" PRId64 " %" PRId64 " %d %d\n", wstart, count, getValue(first), getValue(last));
+  }
+}
+
+// rows of "select top(v, n)" or "select bottom(v, n)", in the order of timestamp
+static void getTopBottom(int n, bool top, char *buf) {
+  int *rows = malloc(sizeof(int) * n);
+  int  num = 0, len = 0;
+
+  for (int row = 0; row < arguments.numOfRows; ++row) {
+    if (isNullRow(row)) continue;
+
+    // insert by value, the worst one is dropped when there are n of them
+    int v = getValue(row);
+    int pos = num;
+    while (pos > 0 && (top ? getValue(rows[pos - 1]) < v : getValue(rows[pos - 1]) > v)) --pos;
+    if (pos >= n) continue;
+
+    if (num < n) num++;
+    memmove(rows + pos + 1, rows + pos, sizeof(int) * (num - 1 - pos));
+    rows[pos] = row;
+  }
+
+  // rows are in the order of timestamp
+  for (int i = 0; i < num; ++i) {
+    for (int j = i + 1; j < num; ++j) {
+      if (rows[j] < rows[i]) {
+        int tmp = rows[i];
+        rows[i] = rows[j];
+        rows[j] = tmp;
+      }
+    }
+  }
+
+  buf[0] = 0;
+  for (int i = 0; i < num; ++i) {
+    len += sprintf(buf + len, "%" PRId64 " %d\n", getTs(rows[i]), getValue(rows[i]));
+  }
+
+  free(rows);
+}
+
+static void checkQuery(TAOS *taos, const char *stage, const char *expected, char *result, const char *sql) {
+  thQueryRows(taos, result, MAX_RESULT_LEN, "%s", sql);
+  TH_CHECK(strcmp(expected, result) == 0, "%s, \"%s\", expected:\n%.2000s\nresult:\n%.2000s", stage, sql, expected,
+           result);
+}
+
+void checkQueries(TAOS *taos, const char *stage) {
+  char *expected = malloc(MAX_RESULT_LEN);
+  char *result = malloc(MAX_RESULT_LEN);
+  char  sql[512];
+
+  thExecute(taos, "use ib");
+
+  // blocks entirely in a window and blocks across windows
+  getAggrWindows(HOUR_MS, INT64_MIN, INT64_MAX, INT32_MIN, expected);
+  checkQuery(taos, stage, expected, result,
+             "select count(*), count(v), sum(v), min(v), max(v), avg(v), spread(v) from t interval(1h)");
+
+  // every block is across windows, a retrieve returns at most the rows of a file block, i.e., 200 windows
+  getAggrWindows(30 * MINUTE_MS, INT64_MIN, INT64_MAX, INT32_MIN, expected);
+  checkQuery(taos, stage, expected, result,
+             "select count(*), count(v), sum(v), min(v), max(v), avg(v), spread(v) from t interval(30m)");
+
+  // the first and the last block of the query are partly out of the time range
+  int64_t skey = getTs(1234) + 5000, ekey = getTs(arguments.numOfRows - 1357) - 5000;
+  getAggrWindows(HOUR_MS, skey, ekey, INT32_MIN, expected);
+  snprintf(sql, sizeof(sql),
+           "select count(*), count(v), sum(v), min(v), max(v), avg(v), spread(v) from t where ts >= %" PRId64
+           " and ts <= %" PRId64 " interval(1h)",
+           skey, ekey);
+  checkQuery(taos, stage, expected, result, sql);
+
+  // first/last can not use the pre-aggregated values, blocks are loaded on demand in the ascending scan
+  getFirstLastWindows(HOUR_MS, INT32_MIN, expected);
+  checkQuery(taos, stage, expected, result, "select count(*), first(v), last(v) from t interval(1h)");
+
+  // rows are filtered, the selected ones of a window are split into ranges by the rows filtered out
+  getAggrWindows(30 * MINUTE_MS, INT64_MIN, INT64_MAX, 300, expected);
+  checkQuery(taos, stage, expected, result,
+             "select count(*), count(v), sum(v), min(v), max(v), avg(v), spread(v) from t where v >= 300 "
+             "interval(30m)");
+
+  getAggrWindows(HOUR_MS, skey, ekey, 300, expected);
+  snprintf(sql, sizeof(sql),
+           "select count(*), count(v), sum(v), min(v), max(v), avg(v), spread(v) from t where ts >= %" PRId64
+           " and ts <= %" PRId64 " and v >= 300 interval(1h)",
+           skey, ekey);
+  checkQuery(taos, stage, expected, result, sql);
+
+  getFirstLastWindows(HOUR_MS, 300, expected);
+  checkQuery(taos, stage, expected, result, "select count(*), first(v), last(v) from t where v >= 300 interval(1h)");
+
+  // blocks without a value to beat the kept ones are skipped
+  getTopBottom(5, true, expected);
+  checkQuery(taos, stage, expected, result, "select top(v, 5) from t");
+
+  getTopBottom(5, false, expected);
+  checkQuery(taos, stage, expected, result, "select bottom(v, 5) from t");
+
+  free(expected);
+  free(result);
+}
+
+int main(int argc, char *argv[]) {
+  parseArg(argc, argv);
+
+  TAOS *taos = thStartServer(TEST_NAME, NULL);
+  writeRows(taos);
+  checkQueries(taos, "rows in cache");
+
+  taos = thRestartServer(taos, TEST_NAME, NULL);
+  checkQueries(taos, "rows in files");
+
+  printf("rows:%d, blocks of 200 rows in 1h windows of %" PRId64 " rows\n", arguments.numOfRows,
+         (int64_t)(HOUR_MS / ROW_INTERVAL));
+
+  thStopServer(taos);
+  return thReport(TEST_NAME);
+}
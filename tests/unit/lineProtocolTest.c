@@ -0,0 +1,173 @@
+/*
+ * Compare the ingestion speed of taos_insert_lines with SQL inserts of the same points.
+ * Both paths format the points as text, so the time to build the requests is included.
+ * The child tables of lines are created by mgmt in one request, and new vgroups are created in the middle of it
+ * when a vnode holds a few tables. Both databases shall have the same tables and values, and lines of the same tags
+ * in other orders shall go to the same child table.
+ */
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "testHarness.h"
+#include "tutil.h"
+
+typedef struct {
+  int numOfTables;
+  int rowsPerTable;
+  int pointsPerRequest;
+  int tablesPerVnode;
+} ProArgs;
+
+static ProArgs arguments;
+
+#define START_TS_NS 1600000000000000000LL
+
+// a SQL statement is limited to 64KB, so the batch of the SQL path is cut by the length as well
+#define MAX_SQL_LEN 65000
+
+void parseArg(int argc, char *argv[]) {
+  arguments.numOfTables = 100;
+  arguments.rowsPerTable = 10000;
+  arguments.pointsPerRequest = 5000;
+  arguments.tablesPerVnode = 1000;
+
+  SThOption options[] = {TH_INT_OPTION("-tables", &arguments.numOfTables),
+                         TH_INT_OPTION("-rows", &arguments.rowsPerTable),
+                         TH_INT_OPTION("-batch", &arguments.pointsPerRequest),
+                         TH_INT_OPTION("-vnodeTables", &arguments.tablesPerVnode)};
+  thParseArgs(argc, argv, options, tListLen(options));
+}
+
+void prepareDb(TAOS *taos, const char *db) {
+  thExecute(taos, "drop database if exists %s", db);
+  thExecute(taos, "create database %s tables %d", db, arguments.tablesPerVnode);
+  thExecute(taos, "use %s", db);
+}
+
+// points are written round robin among tables, as they arrive from many devices
+void getPoint(int64_t index, int *table, int64_t *ts) {
+  *table = (int)(index % arguments.numOfTables);
+  *ts = START_TS_NS + (index / arguments.numOfTables) * 1000000LL;
+}
+
+double writeBySql(TAOS *taos) {
+  prepareDb(taos, "lpsql");
+  thExecute(taos, "create table cpu (ts timestamp, usage_user double, usage_system double, usage_idle double, "
+                "load bigint, online bool) tags (host binary(16), region binary(16))");
+
+  int64_t total = (int64_t)arguments.numOfTables * arguments.rowsPerTable;
+  char *  sql = malloc(MAX_SQL_LEN);
+
+  int64_t st = thGetTimeUs();
+  for (int64_t i = 0; i < total;) {
+    int len = sprintf(sql, "insert into");
+    for (int n = 0; n < arguments.pointsPerRequest && i < total && len < MAX_SQL_LEN - 256; ++n, ++i) {
+      int     table;
+      int64_t ts;
+      getPoint(i, &table, &ts);
+      len += sprintf(sql + len, " h%d using cpu tags('host_%d','region_%d') values(%" PRId64 ",%d.5,%d.25,%d.75,%d,%s)",
+                     table, table, table % 8, ts / 1000000, (int)(i % 100), (int)(i % 10), (int)(i % 90),
+                     (int)(i % 1000), (i % 2) ? "true" : "false");
+    }
+
+    thExecute(taos, "%s", sql);
+  }
+
+  double seconds = (double)(thGetTimeUs() - st) / 1000000;
+  free(sql);
+  return seconds;
+}
+
+double writeByLines(TAOS *taos) {
+  prepareDb(taos, "lpline");
+
+  int64_t total = (int64_t)arguments.numOfTables * arguments.rowsPerTable;
+  char ** lines = malloc(sizeof(char *) * arguments.pointsPerRequest);
+  for (int n = 0; n < arguments.pointsPerRequest; ++n) {
+    lines[n] = malloc(256);
+  }
+
+  int64_t st = thGetTimeUs();
+  for (int64_t i = 0; i < total;) {
+    int n = 0;
+    for (; n < arguments.pointsPerRequest && i < total; ++n, ++i) {
+      int     table;
+      int64_t ts;
+      getPoint(i, &table, &ts);
+      sprintf(lines[n], "cpu,host=host_%d,region=region_%d usage_user=%d.5,usage_system=%d.25,usage_idle=%d.75,"
+              "load=%di,online=%s %" PRId64, table, table % 8, (int)(i % 100), (int)(i % 10), (int)(i % 90),
+              (int)(i % 1000), (i % 2) ? "true" : "false", ts);
+    }
+
+    int code = taos_insert_lines(taos, lines, n);
+    TH_CHECK(code == 0, "failed to insert lines, code:%d", code);
+  }
+
+  double seconds = (double)(thGetTimeUs() - st) / 1000000;
+  for (int n = 0; n < arguments.pointsPerRequest; ++n) {
+    free(lines[n]);
+  }
+  free(lines);
+  return seconds;
+}
+
+// the tags of a series are parsed once per request, the child table is the same whatever the order of tags
+void writeSeries(TAOS *taos) {
+  char *lines[] = {"mem,host=h1,region=r1 used=1i 1600000000000000000",
+                   "mem,region=r1,host=h1 used=2i 1600000000001000000",
+                   "mem,host=h\\ 2,region=r1 used=3i 1600000000000000000",
+                   "mem,host=h1,region=r1 used=4i 1600000000002000000"};
+
+  int code = taos_insert_lines(taos, lines, 3);
+  TH_CHECK(code == 0, "failed to insert lines of series, code:%d", code);
+  code = taos_insert_lines(taos, lines + 2, 2);
+  TH_CHECK(code == 0, "failed to insert lines of series, code:%d", code);
+
+  double value = thQueryValue(taos, "select sum(used) from lpline.mem where host = 'h1'");
+  TH_CHECK(value == 7, "sum of series h1:%f, expected:7", value);
+  value = thQueryValue(taos, "select count(*) from lpline.mem where host = 'h 2'");
+  TH_CHECK(value == 1, "rows of series 'h 2':%f, expected:1", value);
+}
+
+int main(int argc, char *argv[]) {
+  parseArg(argc, argv);
+
+  TAOS *taos = thStartServer("lineProtocolTest", NULL);
+
+  int64_t total = (int64_t)arguments.numOfTables * arguments.rowsPerTable;
+  printf("---- tables: %d, rows per table: %d, points per request: %d\n", arguments.numOfTables,
+         arguments.rowsPerTable, arguments.pointsPerRequest);
+
+  double  sqlSeconds = writeBySql(taos);
+  int64_t sqlRows = (int64_t)thQueryValue(taos, "select count(*) from lpsql.cpu");
+
+  double  lineSeconds = writeByLines(taos);
+  int64_t lineRows = (int64_t)thQueryValue(taos, "select count(*) from lpline.cpu");
+  writeSeries(taos);
+
+  printf("---- sql:  %" PRId64 " of %" PRId64 " points in %.3f seconds, %.0f points/second\n", sqlRows, total,
+         sqlSeconds, total / sqlSeconds);
+  printf("---- line: %" PRId64 " of %" PRId64 " points in %.3f seconds, %.0f points/second\n", lineRows, total,
+         lineSeconds, total / lineSeconds);
+
+  TH_CHECK(sqlRows == total, "%" PRId64 " of %" PRId64 " points are written by sql", sqlRows, total);
+  TH_CHECK(lineRows == total, "%" PRId64 " of %" PRId64 " points are written by lines", lineRows, total);
+
+  // two tables of the measurement mem
+  int32_t lineTables = thQueryRows(taos, NULL, 0, "show lpline.tables");
+  TH_CHECK(lineTables == arguments.numOfTables + 2, "%d child tables are created by lines, expected:%d", lineTables,
+           arguments.numOfTables + 2);
+
+  const char *aggregates[] = {"sum(load)", "sum(usage_user)", "count(online)"};
+  for (int i = 0; i < tListLen(aggregates); ++i) {
+    double sqlValue = thQueryValue(taos, "select %s from lpsql.cpu", aggregates[i]);
+    double lineValue = thQueryValue(taos, "select %s from lpline.cpu", aggregates[i]);
+    TH_CHECK(sqlValue == lineValue, "%s, sql:%f, line:%f", aggregates[i], sqlValue, lineValue);
+  }
+
+  thStopServer(taos);
+  return thReport("lineProtocolTest");
+}
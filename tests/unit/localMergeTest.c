@@ -0,0 +1,125 @@
+/*
+ * Results of the vnodes of a super table query are merged in the client, by the application thread alone or by
+ * streams on the pool of merge threads whose outputs the application thread merges. Queries with groups, orders,
+ * intervals, limits and slimits over many vnodes are run with localMergeThreads 1 and N, and the rows of each shall
+ * be the same.
+ */
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "testHarness.h"
+#include "tglobalcfg.h"
+#include "tutil.h"
+
+typedef struct {
+  int numOfTables;
+  int rowsPerTable;
+  int numOfThreads;
+} ProArgs;
+
+static ProArgs arguments;
+
+#define START_TS ((int64_t)1600000000000LL)
+#define MAX_SQL_LEN 65000
+#define RESULT_LEN (64 * 1024 * 1024)
+
+static const char *queries[] = {
+    "select count(*), sum(v), min(v), max(v) from st interval(10s) group by t",
+    "select count(*), last(v), first(d) from st interval(1s) group by t order by ts desc",
+    "select count(*), avg(d) from st interval(1s) group by g",
+    "select count(*), max(v) from st interval(1s) group by t limit 50 offset 7",
+    "select count(*), max(v) from st interval(1s) group by t slimit 5 soffset 3",
+    "select top(v, 5) from st group by t",
+    "select count(*), spread(d) from st where v > 100 interval(2s) group by g order by ts desc limit 100",
+    "select last_row(*) from st group by t",
+};
+
+void parseArg(int argc, char *argv[]) {
+  arguments.numOfTables = 64;
+  arguments.rowsPerTable = 2000;
+  arguments.numOfThreads = 4;
+
+  SThOption options[] = {TH_INT_OPTION("-tables", &arguments.numOfTables),
+                         TH_INT_OPTION("-rows", &arguments.rowsPerTable),
+                         TH_INT_OPTION("-threads", &arguments.numOfThreads)};
+  thParseArgs(argc, argv, options, tListLen(options));
+}
+
+// a vnode holds at most 4 tables, so a query merges the results of many vnodes
+void prepareDb(TAOS *taos) {
+  char *sql = malloc(MAX_SQL_LEN);
+
+  thExecute(taos, "drop database if exists lm");
+  thExecute(taos, "create database lm tables 4");
+  thExecute(taos, "use lm");
+  thExecute(taos, "create table st (ts timestamp, v int, d double) tags (t int, g int)");
+
+  for (int t = 0; t < arguments.numOfTables; ++t) {
+    thExecute(taos, "create table t%d using st tags (%d, %d)", t, t, t % 3);
+
+    for (int row = 0; row < arguments.rowsPerTable;) {
+      int len = sprintf(sql, "insert into t%d values", t);
+      for (int n = 0; n < 500 && row < arguments.rowsPerTable; ++n, ++row) {
+        int64_t ts = START_TS + (int64_t)row * 100 + t;
+        len += sprintf(sql + len, "(%" PRId64 ",%d,%.2f)", ts, (row * 37 + t * 11) % 1000, row * 0.25 + t);
+      }
+      thExecute(taos, "%s", sql);
+    }
+  }
+
+  free(sql);
+}
+
+// the rows of all queries with the merge threads of the connection
+void runQueries(TAOS *taos, int numOfThreads, char **results, int32_t *numOfRows) {
+  thExecute(taos, "alter local localMergeThreads %d", numOfThreads);
+
+  for (int i = 0; i < tListLen(queries); ++i) {
+    numOfRows[i] = thQueryRows(taos, results[i], RESULT_LEN, "%s", queries[i]);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  parseArg(argc, argv);
+
+  TAOS *taos = thStartServer("localMergeTest", NULL);
+
+  // the pool has a thread per core, it is started by the first merge on several threads
+  tsNumOfCores = MAX(tsNumOfCores, arguments.numOfThreads);
+
+  prepareDb(taos);
+
+  // rows are committed into files, the vnode asserts on interval queries in desc order over rows in cache
+  taos = thRestartServer(taos, "localMergeTest", NULL);
+  thExecute(taos, "use lm");
+
+  int32_t vgroups = thQueryRows(taos, NULL, 0, "show vgroups");
+  TH_CHECK(vgroups >= 8, "tables are in %d vnodes, expected many", vgroups);
+
+  char *  serial[tListLen(queries)], *parallel[tListLen(queries)];
+  int32_t serialRows[tListLen(queries)], parallelRows[tListLen(queries)];
+  for (int i = 0; i < tListLen(queries); ++i) {
+    serial[i] = malloc(RESULT_LEN);
+    parallel[i] = malloc(RESULT_LEN);
+  }
+
+  runQueries(taos, 1, serial, serialRows);
+  runQueries(taos, arguments.numOfThreads, parallel, parallelRows);
+
+  for (int i = 0; i < tListLen(queries); ++i) {
+    TH_CHECK(serialRows[i] > 0, "no rows of \"%s\"", queries[i]);
+    TH_CHECK(parallelRows[i] == serialRows[i], "\"%s\", rows:%d, expected:%d", queries[i], parallelRows[i],
+             serialRows[i]);
+    TH_CHECK(strcmp(parallel[i], serial[i]) == 0, "\"%s\", rows differ from the merge in the application thread",
+             queries[i]);
+
+    free(serial[i]);
+    free(parallel[i]);
+  }
+
+  thStopServer(taos);
+  return thReport("localMergeTest");
+}
@@ -0,0 +1,204 @@
+/*
+ * Queries reserve their estimated memory from the budget of the dnode before they are scheduled. A projection over a
+ * wide table holds about 12 MB while its result is not retrieved, one over the widest table is estimated at about
+ * 49 MB. With a budget of 20 MB and a quota of 32 MB, the widest query is rejected at once, a second wide query
+ * waits until the first one is freed, or is rejected once it waits longer than queryMemWaitTime. The budget is
+ * fully returned afterwards.
+ */
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "taoserror.h"
+#include "testHarness.h"
+#include "tutil.h"
+
+typedef struct {
+  int rows;
+  int waitTime;
+} ProArgs;
+
+typedef struct {
+  const char *sql;
+  int32_t     code;
+  int32_t     rows;
+  int64_t     us;
+  char        reason[128];
+} SQueryJob;
+
+static ProArgs arguments;
+
+#define START_TS ((int64_t)1600000000000LL)
+#define MAX_SQL_LEN 65000
+
+void parseArg(int argc, char *argv[]) {
+  arguments.rows = 10000;
+  arguments.waitTime = 1000;
+
+  SThOption options[] = {TH_INT_OPTION("-rows", &arguments.rows),
+                         TH_INT_OPTION("-wait", &arguments.waitTime)};
+  thParseArgs(argc, argv, options, tListLen(options));
+}
+
+// the estimate of a projection depends on the row size in the schema only, values of the binaries are short. A
+// batch of rows of the widest table shall fit in a few cache blocks
+void prepareDb(TAOS *taos) {
+  char *sql = malloc(MAX_SQL_LEN);
+
+  thExecute(taos, "drop database if exists qm");
+  thExecute(taos, "create database qm rows 4096");
+  thExecute(taos, "use qm");
+  thExecute(taos, "create table small (ts timestamp, v int)");
+  thExecute(taos, "create table wide (ts timestamp, v int, b binary(1000))");
+  thExecute(taos, "create table widest (ts timestamp, v int, b binary(4000))");
+
+  const char *tables[] = {"small", "wide", "widest"};
+  for (int i = 0; i < tListLen(tables); ++i) {
+    for (int row = 0; row < arguments.rows;) {
+      int len = sprintf(sql, "insert into %s values", tables[i]);
+      for (int n = 0; n < 50 && row < arguments.rows; ++n, ++row) {
+        if (i == 0) {
+          len += sprintf(sql + len, "(%" PRId64 ",%d)", START_TS + row, row);
+        } else {
+          len += sprintf(sql + len, "(%" PRId64 ",%d,'b%d')", START_TS + row, row, row);
+        }
+      }
+      thExecute(taos, "%s", sql);
+    }
+  }
+
+  free(sql);
+}
+
+// a rejected query is accepted by vnode and fails when its result is retrieved, so the code is the one of the fetch
+void runQuery(TAOS *taos, SQueryJob *pJob) {
+  int64_t st = thGetTimeUs();
+
+  pJob->rows = 0;
+  pJob->code = taos_query(taos, pJob->sql);
+  if (pJob->code == 0) {
+    TAOS_RES *result = taos_use_result(taos);
+    while (taos_fetch_row(result) != NULL) {
+      pJob->rows++;
+    }
+
+    pJob->code = taos_errno(taos);
+    taos_free_result(result);
+  }
+
+  pJob->us = thGetTimeUs() - st;
+  snprintf(pJob->reason, sizeof(pJob->reason), "%s", (pJob->code == 0) ? "success" : taos_errstr(taos));
+}
+
+void *runQueryJob(void *param) {
+  SQueryJob *pJob = (SQueryJob *)param;
+  TAOS *     taos = taos_connect("127.0.0.1", "root", "taosdata", "qm", 0);
+
+  TH_CHECK(taos != NULL, "failed to connect");
+  if (taos == NULL) return NULL;
+
+  runQuery(taos, pJob);
+  taos_close(taos);
+  return NULL;
+}
+
+// the first retrieved rows are fetched only, the query keeps its memory until the result is freed
+TAOS_RES *holdQuery(TAOS *taos, const char *sql) {
+  if (taos_query(taos, sql) != 0) {
+    TH_CHECK(false, "failed to query \"%s\", reason:%s", sql, taos_errstr(taos));
+    return NULL;
+  }
+
+  TAOS_RES *result = taos_use_result(taos);
+  TH_CHECK(taos_fetch_row(result) != NULL, "no rows of \"%s\", reason:%s", sql, taos_errstr(taos));
+  return result;
+}
+
+void checkAdmission(TAOS *taos) {
+  const char *queries[] = {"select * from small", "select * from wide", "select count(*), max(v) from widest"};
+
+  for (int i = 0; i < tListLen(queries); ++i) {
+    SQueryJob job = {.sql = queries[i]};
+    runQuery(taos, &job);
+    TH_CHECK(job.code == 0, "\"%s\" failed, reason:%s", queries[i], job.reason);
+    TH_CHECK(job.rows > 0, "no rows of \"%s\"", queries[i]);
+  }
+}
+
+void checkRejection(TAOS *taos) {
+  SQueryJob job = {.sql = "select * from widest"};
+  runQuery(taos, &job);
+
+  TH_CHECK(job.code == TSDB_CODE_QUERY_MEM_EXCEEDED, "query over quota, code:%d, reason:%s", job.code, job.reason);
+  TH_CHECK(strcmp(job.reason, "query memory budget exceeded") == 0, "query over quota, reason:%s", job.reason);
+  TH_CHECK(job.us < arguments.waitTime * 1000LL, "query over quota is rejected after %.1f ms, not at once",
+           job.us / 1000.0);
+  printf("query over quota, code:%d, reason:%s, time:%.1f ms\n", job.code, job.reason, job.us / 1000.0);
+}
+
+// the second wide query is queued behind the held one, and it runs once the held one is freed or it times out
+void checkQueue(TAOS *taos, TAOS *holder, int holdMs, const char *name) {
+  SQueryJob job = {.sql = "select * from wide"};
+  pthread_t thread;
+
+  TAOS_RES *result = holdQuery(holder, "select * from wide");
+  if (result == NULL) return;
+
+  pthread_create(&thread, NULL, runQueryJob, &job);
+  if (holdMs > 0) {
+    usleep(holdMs * 1000);
+    taos_free_result(result);
+    pthread_join(thread, NULL);
+  } else {
+    pthread_join(thread, NULL);
+    taos_free_result(result);
+  }
+
+  int64_t waitUs = arguments.waitTime * 1000LL;
+  if (holdMs > 0) {
+    TH_CHECK(job.code == 0, "%s, failed, reason:%s", name, job.reason);
+    TH_CHECK(job.rows == arguments.rows, "%s, rows:%d, expected:%d", name, job.rows, arguments.rows);
+    TH_CHECK(job.us >= holdMs * 800LL, "%s, query is not queued, time:%.1f ms", name, job.us / 1000.0);
+  } else {
+    TH_CHECK(job.code == TSDB_CODE_QUERY_MEM_EXCEEDED, "%s, code:%d, reason:%s", name, job.code, job.reason);
+    TH_CHECK(job.us >= waitUs * 8 / 10, "%s, rejected after %.1f ms, before waiting %d ms", name, job.us / 1000.0,
+             arguments.waitTime);
+  }
+
+  printf("%s, code:%d, rows:%d, time:%.1f ms\n", name, job.code, job.rows, job.us / 1000.0);
+}
+
+int main(int argc, char *argv[]) {
+  parseArg(argc, argv);
+
+  char cfg[128];
+  snprintf(cfg, sizeof(cfg), "queryMemBudget 20\nqueryMemQuota 32\nqueryMemWaitTime %d\n", arguments.waitTime);
+  TAOS *taos = thStartServer("queryMemTest", cfg);
+
+  prepareDb(taos);
+
+  // both queries read files, so that the results of the held ones are not complete in one retrieve
+  taos = thRestartServer(taos, "queryMemTest", cfg);
+  thExecute(taos, "use qm");
+
+  TAOS *holder = taos_connect("127.0.0.1", "root", "taosdata", "qm", 0);
+  TH_CHECK(holder != NULL, "failed to connect");
+  if (holder == NULL) return thReport("queryMemTest");
+
+  checkAdmission(taos);
+  checkRejection(taos);
+  checkQueue(taos, holder, arguments.waitTime / 2, "queued query admitted");
+  checkQueue(taos, holder, 0, "queued query timed out");
+
+  // all reservations are released, so the wide queries run one after another again
+  checkAdmission(taos);
+  checkQueue(taos, holder, arguments.waitTime / 4, "queued query admitted again");
+
+  taos_close(holder);
+  thStopServer(taos);
+  return thReport("queryMemTest");
+}
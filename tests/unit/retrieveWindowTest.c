@@ -0,0 +1,144 @@
+/*
+ * A projection query on a table returns a window of file blocks per retrieve, and keeps reading across data files
+ * and from files into cache within a window. Rows of a table are put into two data files and the cache, then read
+ * back in both orders with limits and offsets around the switches, with a window of several blocks and of one block.
+ * Each row shall be returned exactly once and in order.
+ */
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "testHarness.h"
+#include "tutil.h"
+
+typedef struct {
+  int fileRows;
+  int cacheRows;
+  int window;
+} ProArgs;
+
+static ProArgs arguments;
+
+#define START_TS ((int64_t)1600000000000LL)
+#define ROW_INTERVAL 30000  // rows of a day fill 14.4 blocks of 200 rows, file rows span two files of a day
+#define MAX_SQL_LEN 65000
+#define RESULT_LEN (16 * 1024 * 1024)
+
+void parseArg(int argc, char *argv[]) {
+  arguments.fileRows = 5000;
+  arguments.cacheRows = 3000;
+  arguments.window = 8;
+
+  SThOption options[] = {TH_INT_OPTION("-fileRows", &arguments.fileRows),
+                         TH_INT_OPTION("-cacheRows", &arguments.cacheRows),
+                         TH_INT_OPTION("-window", &arguments.window)};
+  thParseArgs(argc, argv, options, tListLen(options));
+}
+
+void insertRows(TAOS *taos, int first, int last) {
+  char *sql = malloc(MAX_SQL_LEN);
+
+  for (int row = first; row < last;) {
+    int len = sprintf(sql, "insert into t0 values");
+    for (int n = 0; n < 500 && row < last; ++n, ++row) {
+      len += sprintf(sql + len, "(%" PRId64 ",%d)", START_TS + (int64_t)row * ROW_INTERVAL, row);
+    }
+    thExecute(taos, "%s", sql);
+  }
+
+  free(sql);
+}
+
+// rows are "ts v" lines and v is the index of the row, so the lines shall be the rows from offset on, one by one
+void checkRows(TAOS *taos, char *buf, int desc, int limit, int offset) {
+  int total = arguments.fileRows + arguments.cacheRows;
+  int expected = MIN(limit, MAX(total - offset, 0));
+
+  int32_t numOfRows = thQueryRows(taos, buf, RESULT_LEN, "select ts, v from t0 %s limit %d offset %d",
+                                  desc ? "order by ts desc" : "", limit, offset);
+  TH_CHECK(numOfRows == expected, "%s, limit:%d offset:%d, rows:%d, expected:%d", desc ? "desc" : "asc", limit,
+           offset, numOfRows, expected);
+
+  char *line = buf;
+  for (int i = 0; i < expected && line != NULL && *line != 0; ++i) {
+    int     row = desc ? total - 1 - offset - i : offset + i;
+    int64_t ts = 0;
+    int     v = -1;
+
+    sscanf(line, "%" PRId64 " %d", &ts, &v);
+    if (v != row || ts != START_TS + (int64_t)row * ROW_INTERVAL) {
+      TH_CHECK(false, "%s, limit:%d offset:%d, row %d is \"%" PRId64 " %d\", expected row:%d", desc ? "desc" : "asc",
+               limit, offset, i, ts, v, row);
+      break;
+    }
+
+    line = strchr(line, '\n');
+    if (line != NULL) line++;
+  }
+}
+
+void checkTable(TAOS *taos, char *buf, const char *name) {
+  int fileRows = arguments.fileRows;
+  int total = fileRows + arguments.cacheRows;
+  int block = 200;
+  int window = block * arguments.window;
+
+  // whole table, within one window, across a window, across the file switch and the switch to cache, and past the end
+  int cases[][2] = {{total, 0},
+                    {10, 0},
+                    {window + 1, block - 1},
+                    {window * 2, 7 * block + 3},
+                    {window, fileRows - window / 2},
+                    {3 * block, fileRows - 1},
+                    {total, fileRows},
+                    {block, total - 50},
+                    {block, total}};
+
+  int64_t st = thGetTimeUs();
+  for (int desc = 0; desc <= 1; ++desc) {
+    for (int i = 0; i < tListLen(cases); ++i) {
+      checkRows(taos, buf, desc, cases[i][0], cases[i][1]);
+    }
+  }
+
+  printf("%s, rows in files:%d, rows in cache:%d, time:%.1f ms\n", name, fileRows, arguments.cacheRows,
+         (thGetTimeUs() - st) / 1000.0);
+}
+
+// the rows written before the restart are committed into files, the others stay in cache
+TAOS *prepareTable(TAOS *taos, const char *cfg) {
+  thExecute(taos, "drop database if exists rw");
+  thExecute(taos, "create database rw days 1 rows 200");
+  thExecute(taos, "use rw");
+  thExecute(taos, "create table t0 (ts timestamp, v int)");
+
+  insertRows(taos, 0, arguments.fileRows);
+  taos = thRestartServer(taos, "retrieveWindowTest", cfg);
+  thExecute(taos, "use rw");
+  insertRows(taos, arguments.fileRows, arguments.fileRows + arguments.cacheRows);
+
+  return taos;
+}
+
+int main(int argc, char *argv[]) {
+  parseArg(argc, argv);
+
+  char *buf = malloc(RESULT_LEN);
+  char  cfg[64];
+
+  // the client asks for the window it is started with, the server grants the smaller one of the two
+  snprintf(cfg, sizeof(cfg), "retrieveWindow %d\n", arguments.window);
+  TAOS *taos = thStartServer("retrieveWindowTest", cfg);
+  taos = prepareTable(taos, cfg);
+  checkTable(taos, buf, "window of several blocks");
+
+  taos = thRestartServer(taos, "retrieveWindowTest", "retrieveWindow 1\n");
+  taos = prepareTable(taos, "retrieveWindow 1\n");
+  checkTable(taos, buf, "window of one block");
+
+  free(buf);
+  thStopServer(taos);
+  return thReport("retrieveWindowTest");
+}
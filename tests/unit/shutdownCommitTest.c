@@ -0,0 +1,288 @@
+/*
+ * Commits of the vnodes are queued to the commit scheduler, which runs one of them at a time here. Writers fill the
+ * small caches of many vnodes, so commits are running and queued when taosd is stopped, and the cache of a vnode is
+ * committed at the stop even if its commit was running then. Every row is checked after taosd is started again,
+ * once for a stop right after the writers are done, and then for stops while they are writing, each sent once the
+ * log of the server shows rows written behind a running commit, and the rows acknowledged before it are checked.
+ */
+#include <inttypes.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "testHarness.h"
+#include "tutil.h"
+
+typedef struct {
+  int numOfThreads;
+  int numOfTables;
+  int rowsPerTable;
+  int numOfStops;
+} ProArgs;
+
+typedef struct {
+  int first;  // tables written by a thread: first, first + numOfThreads, ...
+  int rows;   // rows to write into each table, 0 to write until stopWriting is set
+} SWriter;
+
+static ProArgs arguments;
+
+#define TEST_NAME "shutdownCommitTest"
+#define START_TS ((int64_t)1600000000000LL)
+#define MAX_SQL_LEN 65000
+#define MAX_TABLES 200
+#define ROWS_PER_REQUEST 100
+#define AHEAD_TS (START_TS + 30 * 3600 * 1000LL)  // in the same file as the other rows
+#define STOP_TIMEOUT_US 60000000LL
+#define MAX_STOPS 20
+
+// the tables committed are logged with the debug flag of the dnode
+static const char *serverCfg = "numOfCommitWorkers 1\nmaxCommitsPerDir 1\ndDebugFlag 135\n";
+
+static volatile int     acked[MAX_TABLES];  // rows of each table acknowledged by the server
+static volatile int64_t totalAcked = 0;
+static volatile int     stopWriting = 0;
+
+void parseArg(int argc, char *argv[]) {
+  arguments.numOfThreads = 8;
+  arguments.numOfTables = 40;
+  arguments.rowsPerTable = 5000;
+  arguments.numOfStops = 5;
+
+  SThOption options[] = {TH_INT_OPTION("-threads", &arguments.numOfThreads),
+                         TH_INT_OPTION("-tables", &arguments.numOfTables),
+                         TH_INT_OPTION("-rows", &arguments.rowsPerTable),
+                         TH_INT_OPTION("-stops", &arguments.numOfStops)};
+  thParseArgs(argc, argv, options, tListLen(options));
+  arguments.numOfTables = MIN(arguments.numOfTables, MAX_TABLES);
+}
+
+/*
+ * the last table of each vnode has a row ahead of all rows to write, so the commit of a vnode covers the rows up to
+ * it and does not commit again for the rows written after it has passed their tables, they are left to the next one
+ */
+static bool isAheadTable(int t) { return t % 4 == 3; }
+
+// a vnode holds at most 4 tables, its cache of 16 blocks is committed many times while they are written
+void prepareDb(TAOS *taos) {
+  thExecute(taos, "create database sc tables 4 cache 65536 ablocks 4 tblocks 16");
+  thExecute(taos, "use sc");
+  thExecute(taos, "create table st (ts timestamp, v int, d double) tags (t int)");
+
+  for (int t = 0; t < arguments.numOfTables; ++t) {
+    thExecute(taos, "create table t%d using st tags (%d)", t, t);
+    if (isAheadTable(t)) thExecute(taos, "insert into t%d values (%" PRId64 ", 0, 0)", t, AHEAD_TS);
+  }
+}
+
+// tables of a thread are written in turn, a row is acknowledged only when the insert of it returns success
+void *writeTables(void *param) {
+  SWriter *pWriter = (SWriter *)param;
+  TAOS *   taos = taos_connect("127.0.0.1", "root", "taosdata", "sc", 0);
+  char *   sql = malloc(MAX_SQL_LEN);
+
+  TH_CHECK(taos != NULL, "failed to connect");
+  if (taos == NULL) {
+    free(sql);
+    return NULL;
+  }
+
+  for (bool written = true, failed = false; written && !failed && !stopWriting;) {
+    written = false;
+    for (int t = pWriter->first; t < arguments.numOfTables; t += arguments.numOfThreads) {
+      int row = acked[t];
+      if (isAheadTable(t) || (pWriter->rows > 0 && row >= pWriter->rows)) continue;
+
+      int len = sprintf(sql, "insert into t%d values", t);
+      for (int n = 0; n < ROWS_PER_REQUEST; ++n) {
+        len += sprintf(sql + len, "(%" PRId64 ",%d,%.6f)", START_TS + row + n, row + n,
+                       ((row + n) * 2654435761u % 1000003) / 7.0);
+      }
+
+      if (taos_query(taos, sql) != 0) {
+        TH_CHECK(pWriter->rows == 0, "failed to write t%d, reason:%s", t, taos_errstr(taos));
+        failed = true;
+        break;
+      }
+
+      acked[t] = row + ROWS_PER_REQUEST;
+      __sync_fetch_and_add(&totalAcked, ROWS_PER_REQUEST);
+      written = true;
+    }
+  }
+
+  taos_close(taos);
+  free(sql);
+  return NULL;
+}
+
+void startWriters(pthread_t *threads, SWriter *writers, int rows) {
+  stopWriting = 0;
+  for (int i = 0; i < arguments.numOfThreads; ++i) {
+    writers[i].first = i;
+    writers[i].rows = rows;
+    pthread_create(threads + i, NULL, writeTables, writers + i);
+  }
+}
+
+void joinWriters(pthread_t *threads) {
+  for (int i = 0; i < arguments.numOfThreads; ++i) {
+    pthread_join(threads[i], NULL);
+  }
+}
+
+typedef struct {
+  int     pid;
+  int64_t offsets[2];  // of the log files read so far
+  bool    committing;  // a commit of the first vnode runs
+  bool    passed;      // the running commit has passed the first table
+  bool    stopped;     // the shut down signal is logged
+} SLogScan;
+
+// the harness writes the pid of the server into taosd.pid
+static void startLogScan(SLogScan *pScan) {
+  char path[600];
+
+  memset(pScan, 0, sizeof(SLogScan));
+  pScan->pid = -1;
+
+  snprintf(path, sizeof(path), "%s/taosd.pid", thGetServerDir());
+  FILE *fp = fopen(path, "r");
+  if (fp == NULL) return;
+  if (fscanf(fp, "%d", &pScan->pid) != 1) pScan->pid = -1;
+  fclose(fp);
+}
+
+/*
+ * Commits of the first vnode, which holds t0, from the new lines of the server in the log files since the last scan,
+ * up to the shut down signal. The commit of a vnode goes through its tables in the order of their sids.
+ */
+static void scanLog(SLogScan *pScan) {
+  char path[600], line[1024];
+
+  for (int i = 0; i < 2 && !pScan->stopped; ++i) {
+    snprintf(path, sizeof(path), "%s/log/taosdlog.%d", thGetServerDir(), i);
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL) continue;
+
+    fseek(fp, pScan->offsets[i], SEEK_SET);
+    while (!pScan->stopped && fgets(line, sizeof(line), fp) != NULL) {
+      int linePid = 0, vnode = -1;
+      if (line[strlen(line) - 1] != '\n' && feof(fp)) break;  // the rest of it is not written yet
+      pScan->offsets[i] = ftell(fp);
+
+      if (sscanf(line, "%*s %*s %d %*s %*s vid:%d", &linePid, &vnode) < 1 || linePid != pScan->pid) continue;
+      if (strstr(line, "shut down signal") != NULL) pScan->stopped = true;
+      if (vnode != 0) continue;
+
+      if (strstr(line, "committing to file") != NULL) pScan->committing = true, pScan->passed = false;
+      if (strstr(line, "committing is over") != NULL) pScan->committing = false;
+      if (strstr(line, ".sc.t0, ") != NULL && strstr(line, "points are committed") != NULL) pScan->passed = true;
+    }
+
+    fclose(fp);
+  }
+}
+
+/*
+ * Waits until rows of t0 are acknowledged after a running commit of the first vnode has passed t0, an insert sent
+ * before the commit passed it may be acknowledged after, so the rows of a second insert are waited for.
+ */
+static bool waitForRowsPassed(SLogScan *pScan, int64_t start) {
+  while (thGetTimeUs() - start < STOP_TIMEOUT_US) {
+    scanLog(pScan);
+    if (!pScan->committing || !pScan->passed) {
+      usleep(100);
+      continue;
+    }
+
+    int acked0 = acked[0];
+    while (acked[0] < acked0 + 2 * ROWS_PER_REQUEST && pScan->committing && thGetTimeUs() - start < STOP_TIMEOUT_US) {
+      usleep(100);
+      scanLog(pScan);
+    }
+    if (pScan->committing && acked[0] >= acked0 + 2 * ROWS_PER_REQUEST) return true;
+  }
+
+  return false;
+}
+
+// rows of an insert that failed may be there or not, the acknowledged ones in front of them shall all be there
+void checkRows(TAOS *taos, const char *step) {
+  for (int t = 0; t < arguments.numOfTables; ++t) {
+    if (isAheadTable(t)) {
+      double count = thQueryValue(taos, "select count(*) from t%d", t);
+      TH_CHECK(count == 1, "%s, t%d, rows:%.0f, expected:1", step, t, count);
+      continue;
+    }
+
+    double count = thQueryValue(taos, "select count(*) from t%d where ts < %" PRId64, t, START_TS + acked[t]);
+    double sum = thQueryValue(taos, "select sum(v) from t%d where ts < %" PRId64, t, START_TS + acked[t]);
+    if (isnan(count)) count = 0;
+    if (isnan(sum)) sum = 0;
+
+    TH_CHECK(acked[t] > 0, "%s, no row of t%d is acknowledged", step, t);
+    TH_CHECK(count == acked[t], "%s, t%d, rows:%.0f, acknowledged:%d", step, t, count, acked[t]);
+    TH_CHECK(sum == (double)acked[t] * (acked[t] - 1) / 2, "%s, t%d, sum:%.0f of %d acknowledged rows", step, t, sum,
+             acked[t]);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  parseArg(argc, argv);
+
+  pthread_t threads[arguments.numOfThreads];
+  SWriter   writers[arguments.numOfThreads];
+
+  TAOS *taos = thStartServer(TEST_NAME, serverCfg);
+  prepareDb(taos);
+
+  int32_t vgroups = thQueryRows(taos, NULL, 0, "show vgroups");
+  TH_CHECK(vgroups >= 4, "tables are in %d vnodes, expected many", vgroups);
+
+  // stopped right after the last rows are written
+  startWriters(threads, writers, arguments.rowsPerTable);
+  joinWriters(threads);
+
+  taos = thRestartServer(taos, TEST_NAME, serverCfg);
+  thExecute(taos, "use sc");
+  checkRows(taos, "stop after writing");
+
+  /*
+   * stopped while the writers go on, right after rows of t0 are written into the cache behind a running commit of the
+   * first vnode. The vnodes are cleaned up in the order of their ids, each after its commits are over, so it is the
+   * commit of the first vnode which may still run when the commit at the stop is requested, and the rows of t0 are
+   * only committed by the commit at the stop. An insert in flight may be retried on the taosd started again. The
+   * commit may be over before the stop arrives, so taosd is stopped again until one stop is sent while it runs.
+   */
+  int32_t stopsInCommit = 0, stops = 0;
+  for (; stops < arguments.numOfStops || (stopsInCommit == 0 && stops < MAX_STOPS); ++stops) {
+    int64_t  start = thGetTimeUs();
+    SLogScan scan;
+
+    startLogScan(&scan);
+    startWriters(threads, writers, 0);
+    bool passed = waitForRowsPassed(&scan, start);
+
+    stopWriting = 1;
+    taos = thRestartServer(taos, TEST_NAME, serverCfg);
+    thExecute(taos, "use sc");
+    joinWriters(threads);
+
+    scanLog(&scan);
+    if (passed && scan.committing && scan.stopped) stopsInCommit++;
+
+    char step[64];
+    snprintf(step, sizeof(step), "stop %d during writing", stops);
+    checkRows(taos, step);
+  }
+
+  TH_CHECK(stopsInCommit > 0, "none of %d stops is sent while the first vnode is committing", stops);
+
+  thStopServer(taos);
+  return thReport(TEST_NAME);
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "testHarness.h"
+
+static int32_t thFailures = 0;
+
+void thParseArgs(int argc, char *argv[], SThOption *pOptions, int32_t numOfOptions) {
+  for (int i = 1; i < argc; ++i) {
+    SThOption *pOption = NULL;
+    for (int32_t j = 0; j < numOfOptions; ++j) {
+      if (strcmp(argv[i], pOptions[j].name) == 0) {
+        pOption = &pOptions[j];
+        break;
+      }
+    }
+
+    if (pOption == NULL) {
+      fprintf(stderr, "unknown option:%s, options:", argv[i]);
+      for (int32_t j = 0; j < numOfOptions; ++j) fprintf(stderr, " %s", pOptions[j].name);
+      fprintf(stderr, "\n");
+      exit(EXIT_FAILURE);
+    }
+
+    if (i == argc - 1) {
+      fprintf(stderr, "'%s' requires a parameter\n", argv[i]);
+      exit(EXIT_FAILURE);
+    }
+
+    ++i;
+    if (pOption->type == TH_OPTION_INT) {
+      *(int32_t *)pOption->value = atoi(argv[i]);
+    } else {
+      snprintf((char *)pOption->value, (size_t)pOption->size, "%s", argv[i]);
+    }
+  }
+}
+
+int64_t thGetTimeUs() {
+  struct timeval systemTime;
+  gettimeofday(&systemTime, NULL);
+  return (int64_t)systemTime.tv_sec * 1000000L + (int64_t)systemTime.tv_usec;
+}
+
+void thCheck(bool passed, const char *file, int32_t line, const char *format, ...) {
+  if (passed) return;
+
+  const char *name = strrchr(file, '/');
+  fprintf(stderr, "%s:%d: check failed: ", (name != NULL) ? name + 1 : file, line);
+
+  va_list ap;
+  va_start(ap, format);
+  vfprintf(stderr, format, ap);
+  va_end(ap);
+
+  fprintf(stderr, "\n");
+  thFailures++;
+}
+
+int32_t thGetFailures() { return thFailures; }
+
+int32_t thReport(const char *name) {
+  if (thFailures == 0) {
+    printf("%s: passed\n", name);
+    return 0;
+  }
+
+  printf("%s: %d checks failed\n", name, thFailures);
+  return 1;
+}
@@ -0,0 +1,282 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <fcntl.h>
+#include <math.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "testHarness.h"
+
+#ifndef TH_TAOSD_PATH
+#define TH_TAOSD_PATH "taosd"
+#endif
+
+#ifndef TH_WORK_DIR
+#define TH_WORK_DIR "/tmp/tdengine-unit"
+#endif
+
+#define TH_MAX_SQL_LEN 65480
+#define TH_START_TIMEOUT_MS 30000
+
+// ports of the test server, the defaults of a dnode start from 6030
+static const char *thServerCfg =
+    "charset UTF-8\n"
+    "locale C.UTF-8\n"
+    "mgmtShellPort 7030\n"
+    "vnodeShellPort 7035\n"
+    "mgmtVnodePort 7040\n"
+    "vnodeVnodePort 7045\n"
+    "mgmtMgmtPort 7050\n"
+    "mgmtSyncPort 7050\n"
+    "httpPort 7020\n"
+    "http 0\n"
+    "monitor 0\n";
+
+static pid_t thServerPid = 0;
+static char  thServerDir[512];
+
+static void thKillServer(int32_t signo) {
+  if (thServerPid <= 0) return;
+
+  kill(thServerPid, signo);
+  for (int32_t i = 0; i < 1000; ++i) {
+    if (waitpid(thServerPid, NULL, WNOHANG) != 0) {
+      thServerPid = 0;
+      return;
+    }
+    usleep(10000);
+  }
+
+  kill(thServerPid, SIGKILL);
+  waitpid(thServerPid, NULL, 0);
+  thServerPid = 0;
+}
+
+static void thCleanUpServer() { thKillServer(SIGTERM); }
+
+// a server left by a test that was killed still holds the ports
+static void thKillStaleServer(const char *pidFile) {
+  FILE *fp = fopen(pidFile, "r");
+  if (fp == NULL) return;
+
+  int pid = 0;
+  if (fscanf(fp, "%d", &pid) == 1 && pid > 0 && kill(pid, 0) == 0) {
+    char exe[512] = {0}, link[64];
+    snprintf(link, sizeof(link), "/proc/%d/exe", pid);
+    if (readlink(link, exe, sizeof(exe) - 1) > 0 && strstr(exe, "taosd") != NULL) {
+      kill(pid, SIGKILL);
+      usleep(200000);
+    }
+  }
+
+  fclose(fp);
+}
+
+static void thWriteServerCfg(const char *name, const char *cfg) {
+  char path[600];
+  snprintf(path, sizeof(path), "%s/cfg/taos.cfg", thServerDir);
+
+  FILE *fp = fopen(path, "w");
+  if (fp == NULL) {
+    printf("%s: skipped, failed to create %s\n", name, path);
+    exit(TH_SKIP_CODE);
+  }
+  fprintf(fp, "dataDir %s/data\nlogDir %s/log\n%s%s", thServerDir, thServerDir, thServerCfg, (cfg != NULL) ? cfg : "");
+  fclose(fp);
+}
+
+// fork the taosd and wait until it accepts connections
+static TAOS *thLaunchServer(const char *name) {
+  char path[600], cfgDir[600];
+  snprintf(cfgDir, sizeof(cfgDir), "%s/cfg", thServerDir);
+
+  thServerPid = fork();
+  if (thServerPid == 0) {
+    snprintf(path, sizeof(path), "%s/taosd.out", thServerDir);
+    int fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd >= 0) {
+      dup2(fd, STDOUT_FILENO);
+      dup2(fd, STDERR_FILENO);
+      close(fd);
+    }
+
+    execl(TH_TAOSD_PATH, "taosd", "-c", cfgDir, (char *)NULL);
+    _exit(127);
+  } else if (thServerPid < 0) {
+    printf("%s: skipped, failed to fork taosd\n", name);
+    exit(TH_SKIP_CODE);
+  }
+
+  snprintf(path, sizeof(path), "%s/taosd.pid", thServerDir);
+  FILE *fp = fopen(path, "w");
+  if (fp != NULL) {
+    fprintf(fp, "%d\n", (int)thServerPid);
+    fclose(fp);
+  }
+
+  for (int32_t ms = 0; ms < TH_START_TIMEOUT_MS; ms += 100) {
+    if (waitpid(thServerPid, NULL, WNOHANG) != 0) {
+      thServerPid = 0;
+      printf("%s: skipped, taosd exited, see %s/taosd.out\n", name, thServerDir);
+      exit(TH_SKIP_CODE);
+    }
+
+    TAOS *taos = taos_connect("127.0.0.1", "root", "taosdata", NULL, 0);
+    if (taos != NULL) return taos;
+
+    usleep(100000);
+  }
+
+  printf("%s: skipped, taosd does not accept connections, see %s/log\n", name, thServerDir);
+  exit(TH_SKIP_CODE);
+}
+
+TAOS *thStartServer(const char *name, const char *cfg) {
+  char path[2400];
+
+  if (access(TH_TAOSD_PATH, X_OK) != 0) {
+    printf("%s: skipped, %s is not built\n", name, TH_TAOSD_PATH);
+    exit(TH_SKIP_CODE);
+  }
+
+  snprintf(thServerDir, sizeof(thServerDir), "%s/%s", TH_WORK_DIR, name);
+  snprintf(path, sizeof(path), "%s/taosd.pid", thServerDir);
+  thKillStaleServer(path);
+
+  snprintf(path, sizeof(path), "rm -rf %s && mkdir -p %s/cfg %s/data %s/log", thServerDir, thServerDir, thServerDir,
+           thServerDir);
+  if (system(path) != 0) {
+    printf("%s: skipped, failed to create %s\n", name, thServerDir);
+    exit(TH_SKIP_CODE);
+  }
+
+  thWriteServerCfg(name, cfg);
+  atexit(thCleanUpServer);
+
+  char cfgDir[600];
+  snprintf(cfgDir, sizeof(cfgDir), "%s/cfg", thServerDir);
+  taos_options(TSDB_OPTION_CONFIGDIR, cfgDir);
+  taos_init();
+
+  return thLaunchServer(name);
+}
+
+TAOS *thRestartServer(TAOS *taos, const char *name, const char *cfg) {
+  if (taos != NULL) taos_close(taos);
+  thKillServer(SIGTERM);
+
+  thWriteServerCfg(name, cfg);
+  return thLaunchServer(name);
+}
+
+void thCrashServer() { thKillServer(SIGKILL); }
+
+void thStopServer(TAOS *taos) {
+  if (taos != NULL) taos_close(taos);
+  thKillServer(SIGTERM);
+}
+
+const char *thGetServerDir() { return thServerDir; }
+
+int32_t thExecute(TAOS *taos, const char *format, ...) {
+  char *  sql = malloc(TH_MAX_SQL_LEN);
+  va_list ap;
+
+  va_start(ap, format);
+  vsnprintf(sql, TH_MAX_SQL_LEN, format, ap);
+  va_end(ap);
+
+  int32_t code = taos_query(taos, sql);
+  if (code != 0) {
+    thCheck(false, __FILE__, __LINE__, "failed to execute \"%.200s\", reason:%s", sql, taos_errstr(taos));
+  } else if (taos_field_count(taos) > 0) {
+    taos_free_result(taos_use_result(taos));
+  }
+
+  free(sql);
+  return code;
+}
+
+static int32_t thQueryRowsImp(TAOS *taos, char *buf, int32_t size, double *pFirst, const char *format, va_list ap) {
+  char *sql = malloc(TH_MAX_SQL_LEN);
+  vsnprintf(sql, TH_MAX_SQL_LEN, format, ap);
+
+  if (taos_query(taos, sql) != 0) {
+    thCheck(false, __FILE__, __LINE__, "failed to query \"%.200s\", reason:%s", sql, taos_errstr(taos));
+    free(sql);
+    return -1;
+  }
+
+  TAOS_RES *  result = taos_use_result(taos);
+  TAOS_FIELD *fields = taos_fetch_fields(result);
+  int32_t     numOfFields = taos_num_fields(result);
+  int32_t     numOfRows = 0, len = 0;
+  char        line[4096];
+  TAOS_ROW    row;
+
+  if (buf != NULL && size > 0) buf[0] = 0;
+
+  while ((row = taos_fetch_row(result)) != NULL) {
+    if (numOfRows == 0 && pFirst != NULL && row[0] != NULL) {
+      switch (fields[0].type) {
+        case TSDB_DATA_TYPE_BOOL:
+        case TSDB_DATA_TYPE_TINYINT:   *pFirst = *(int8_t *)row[0]; break;
+        case TSDB_DATA_TYPE_SMALLINT:  *pFirst = *(int16_t *)row[0]; break;
+        case TSDB_DATA_TYPE_INT:       *pFirst = *(int32_t *)row[0]; break;
+        case TSDB_DATA_TYPE_BIGINT:
+        case TSDB_DATA_TYPE_TIMESTAMP: *pFirst = (double)*(int64_t *)row[0]; break;
+        case TSDB_DATA_TYPE_FLOAT:     *pFirst = *(float *)row[0]; break;
+        case TSDB_DATA_TYPE_DOUBLE:    *pFirst = *(double *)row[0]; break;
+        default:                       *pFirst = atof((char *)row[0]); break;
+      }
+    }
+
+    if (buf != NULL && len < size) {
+      taos_print_row(line, row, fields, numOfFields);
+      len += snprintf(buf + len, (size_t)(size - len), "%s\n", line);
+    }
+
+    numOfRows++;
+  }
+
+  TH_CHECK(buf == NULL || len < size, "results of \"%.200s\" are truncated", sql);
+  taos_free_result(result);
+  free(sql);
+  return numOfRows;
+}
+
+int32_t thQueryRows(TAOS *taos, char *buf, int32_t size, const char *format, ...) {
+  va_list ap;
+  va_start(ap, format);
+  int32_t numOfRows = thQueryRowsImp(taos, buf, size, NULL, format, ap);
+  va_end(ap);
+  return numOfRows;
+}
+
+double thQueryValue(TAOS *taos, const char *format, ...) {
+  double  value = NAN;
+  va_list ap;
+  va_start(ap, format);
+  thQueryRowsImp(taos, NULL, 0, &value, format, ap);
+  va_end(ap);
+  return value;
+}
@@ -0,0 +1,154 @@
+/*
+ * Check super table aggregates scanned by parallel tasks against the sequential scan of the same data. The server
+ * is restarted between the two modes, which commits the rows in cache, so each mode is checked both with rows only
+ * in files and with rows in files and in cache. Timestamps of tables differ, so first/last have one answer.
+ */
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "testHarness.h"
+#include "tutil.h"
+
+typedef struct {
+  int numOfTables;
+  int rowsPerTable;
+  int parallelism;
+} ProArgs;
+
+static ProArgs arguments;
+
+#define TEST_NAME "stableParallelTest"
+#define START_TS ((int64_t)1600000000000LL)
+#define MAX_SQL_LEN 65000
+#define MAX_RESULT_LEN 65536
+
+static const char *queries[] = {
+    "select count(*), count(v), sum(v), min(v), max(v), first(v), last(v) from st",
+    "select sum(b), min(b), max(b), first(b), last(b), spread(v) from st",
+    "select min(f), max(f), first(f), last(f), sum(d), min(d), max(d), avg(v) from st",
+    "select count(s), first(s), last(s) from st",
+    "select count(*), sum(v), min(v), max(v), first(v), last(v) from st where v > 100",
+    "select count(*), sum(v), min(d), max(d), first(v), last(v) from st "
+    "where ts >= 1600000500000 and ts < 1600001500000",
+    "select count(*), sum(v), min(v), max(v), first(v), last(v) from st group by g",
+    "select count(*), sum(b), first(d), last(d) from st where g = 2",
+};
+
+#define NUM_OF_QUERIES (sizeof(queries) / sizeof(queries[0]))
+
+void parseArg(int argc, char *argv[]) {
+  arguments.numOfTables = 64;
+  arguments.rowsPerTable = 3000;
+  arguments.parallelism = 4;
+
+  SThOption options[] = {TH_INT_OPTION("-tables", &arguments.numOfTables),
+                         TH_INT_OPTION("-rows", &arguments.rowsPerTable),
+                         TH_INT_OPTION("-parallelism", &arguments.parallelism)};
+  thParseArgs(argc, argv, options, tListLen(options));
+}
+
+static const char *getCfg(int parallelism) {
+  static char cfg[128];
+  snprintf(cfg, sizeof(cfg), "queryParallelism %d\nnumOfThreadsPerCore 4\n", parallelism);
+  return cfg;
+}
+
+void prepareDb(TAOS *taos) {
+  thExecute(taos, "create database sp tables %d", arguments.numOfTables + 10);
+  thExecute(taos, "use sp");
+  thExecute(taos, "create table st (ts timestamp, v int, b bigint, f float, d double, s binary(8)) tags (t int, g int)");
+
+  for (int i = 0; i < arguments.numOfTables; ++i) {
+    thExecute(taos, "create table t%d using st tags (%d, %d)", i, i, i % 5);
+  }
+}
+
+// rows [start, end) of each table, v is NULL in every 7th row, and f/d are exact in binary
+void writeRows(TAOS *taos, int start, int end) {
+  char *sql = malloc(MAX_SQL_LEN);
+
+  for (int t = 0; t < arguments.numOfTables; ++t) {
+    for (int row = start; row < end;) {
+      int len = sprintf(sql, "insert into t%d values", t);
+      for (int n = 0; n < 500 && row < end; ++n, ++row) {
+        int64_t ts = START_TS + (int64_t)row * 1000 + t;
+        int     v = (row * 37 + t * 11) % 1000 - 300;
+        if (row % 7 == 3) {
+          len += sprintf(sql + len, "(%" PRId64 ",NULL,%" PRId64 ",%.2f,%.1f,'s%d')", ts, (int64_t)v * 100000,
+                         v * 0.25, v * 0.5, v % 97);
+        } else {
+          len += sprintf(sql + len, "(%" PRId64 ",%d,%" PRId64 ",%.2f,%.1f,'s%d')", ts, v, (int64_t)v * 100000,
+                         v * 0.25, v * 0.5, v % 97);
+        }
+      }
+
+      thExecute(taos, "%s", sql);
+    }
+  }
+
+  free(sql);
+}
+
+void queryAll(TAOS *taos, char **results) {
+  thExecute(taos, "use sp");
+  for (int i = 0; i < NUM_OF_QUERIES; ++i) {
+    int rows = thQueryRows(taos, results[i], MAX_RESULT_LEN, "%s", queries[i]);
+    TH_CHECK(rows > 0, "no result of \"%s\"", queries[i]);
+  }
+}
+
+void compareResults(const char *phase, char **sequential, char **parallel) {
+  for (int i = 0; i < NUM_OF_QUERIES; ++i) {
+    TH_CHECK(strcmp(sequential[i], parallel[i]) == 0, "%s, \"%s\", sequential:\n%s\nparallel:\n%s", phase, queries[i],
+             sequential[i], parallel[i]);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  parseArg(argc, argv);
+
+  char *sequential[NUM_OF_QUERIES], *parallel[NUM_OF_QUERIES];
+  for (int i = 0; i < NUM_OF_QUERIES; ++i) {
+    sequential[i] = calloc(1, MAX_RESULT_LEN);
+    parallel[i] = calloc(1, MAX_RESULT_LEN);
+  }
+
+  int half = arguments.rowsPerTable / 2;
+  int third = arguments.rowsPerTable * 3 / 4;
+
+  TAOS *taos = thStartServer(TEST_NAME, getCfg(1));
+  prepareDb(taos);
+  writeRows(taos, 0, half);
+
+  // first half in files and the second in cache for the sequential scan, all in files for the parallel one
+  taos = thRestartServer(taos, TEST_NAME, getCfg(1));
+  thExecute(taos, "use sp");
+  writeRows(taos, half, third);
+  queryAll(taos, sequential);
+
+  taos = thRestartServer(taos, TEST_NAME, getCfg(arguments.parallelism));
+  queryAll(taos, parallel);
+  compareResults("rows in cache for sequential scan", sequential, parallel);
+
+  // the other way round
+  writeRows(taos, third, arguments.rowsPerTable);
+  queryAll(taos, parallel);
+
+  taos = thRestartServer(taos, TEST_NAME, getCfg(1));
+  queryAll(taos, sequential);
+  compareResults("rows in cache for parallel scan", sequential, parallel);
+
+  printf("tables:%d, rows:%d, parallelism:%d, result of the first query:\n%s", arguments.numOfTables,
+         arguments.rowsPerTable, arguments.parallelism, parallel[0]);
+
+  for (int i = 0; i < NUM_OF_QUERIES; ++i) {
+    free(sequential[i]);
+    free(parallel[i]);
+  }
+
+  thStopServer(taos);
+  return thReport(TEST_NAME);
+}
@@ -0,0 +1,215 @@
+/*
+ * One insert statement "insert into ? values(?, ?, ?, ?, ?)" is bound to tables of several vnodes, column by column
+ * with taos_stmt_bind_param_batch. The table is switched after each chunk of rows, so rows of a table arrive in
+ * several binds, and the statement is executed twice. Int, binary and nchar columns have NULLs and nchar values are
+ * not ASCII. Rows are read back and each one shall be as it was bound.
+ */
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "testHarness.h"
+#include "tutil.h"
+
+typedef struct {
+  int numOfTables;
+  int rowsPerTable;  // rows of a table in one execution
+  int rowsPerBind;
+  int numOfExecutions;
+} ProArgs;
+
+// column arrays of one bind, the columns are ts, i int, d double, b binary(16), n nchar(8)
+typedef struct {
+  int64_t *ts;
+  int32_t *i;
+  double * d;
+  char *   b;
+  char *   n;
+  int32_t *bLength;
+  int32_t *nLength;
+  char *   iNull;
+  char *   bNull;
+  char *   nNull;
+} SColumns;
+
+static ProArgs arguments;
+
+#define START_TS ((int64_t)1600000000000LL)
+#define BINARY_LEN 16
+#define NCHAR_BUF_LEN 32  // 8 characters of up to 4 bytes in utf-8
+#define RESULT_LEN (16 * 1024 * 1024)
+
+void parseArg(int argc, char *argv[]) {
+  arguments.numOfTables = 10;
+  arguments.rowsPerTable = 1000;
+  arguments.rowsPerBind = 300;
+  arguments.numOfExecutions = 2;
+
+  SThOption options[] = {TH_INT_OPTION("-tables", &arguments.numOfTables),
+                         TH_INT_OPTION("-rows", &arguments.rowsPerTable),
+                         TH_INT_OPTION("-bind", &arguments.rowsPerBind),
+                         TH_INT_OPTION("-executions", &arguments.numOfExecutions)};
+  thParseArgs(argc, argv, options, tListLen(options));
+}
+
+// a vnode holds at most 4 tables, so the tables are spread over several vnodes
+void prepareDb(TAOS *taos) {
+  thExecute(taos, "drop database if exists sb");
+  thExecute(taos, "create database sb tables 4");
+  thExecute(taos, "use sb");
+  thExecute(taos, "create table st (ts timestamp, i int, d double, b binary(%d), n nchar(8)) tags (t int)", BINARY_LEN);
+
+  for (int t = 0; t < arguments.numOfTables; ++t) {
+    thExecute(taos, "create table t%d using st tags (%d)", t, t);
+  }
+}
+
+// row r of table t, r counts over all executions. The values are printed as taos_print_row does
+bool isNullInt(int r) { return r % 7 == 3; }
+bool isNullBinary(int r) { return r % 5 == 1; }
+bool isNullNchar(int r) { return r % 3 == 2; }
+
+int printRow(char *line, int t, int r) {
+  int len = sprintf(line, "%" PRId64 " ", START_TS + (int64_t)r * 10);
+  len += isNullInt(r) ? sprintf(line + len, "NULL ") : sprintf(line + len, "%d ", t * 1000000 + r);
+  len += sprintf(line + len, "%lf ", r * 0.25 + t);
+  len += isNullBinary(r) ? sprintf(line + len, "NULL ") : sprintf(line + len, "bin%d_%d ", t, r);
+  len += isNullNchar(r) ? sprintf(line + len, "NULL") : sprintf(line + len, "数据%d", r % 1000);
+  return len;
+}
+
+void fillColumns(SColumns *pCols, int t, int first, int num) {
+  for (int k = 0; k < num; ++k) {
+    int r = first + k;
+
+    pCols->ts[k] = START_TS + (int64_t)r * 10;
+    pCols->i[k] = t * 1000000 + r;
+    pCols->d[k] = r * 0.25 + t;
+    pCols->iNull[k] = isNullInt(r);
+    pCols->bNull[k] = isNullBinary(r);
+    pCols->nNull[k] = isNullNchar(r);
+    pCols->bLength[k] = snprintf(pCols->b + k * BINARY_LEN, BINARY_LEN, "bin%d_%d", t, r);
+    pCols->nLength[k] = snprintf(pCols->n + k * NCHAR_BUF_LEN, NCHAR_BUF_LEN, "数据%d", r % 1000);
+  }
+}
+
+int bindRows(TAOS_STMT *stmt, SColumns *pCols, int t, int first, int num) {
+  fillColumns(pCols, t, first, num);
+
+  TAOS_MULTI_BIND params[] = {
+      {TSDB_DATA_TYPE_TIMESTAMP, pCols->ts, sizeof(int64_t), NULL, NULL, num},
+      {TSDB_DATA_TYPE_INT, pCols->i, sizeof(int32_t), NULL, pCols->iNull, num},
+      {TSDB_DATA_TYPE_DOUBLE, pCols->d, sizeof(double), NULL, NULL, num},
+      {TSDB_DATA_TYPE_BINARY, pCols->b, BINARY_LEN, pCols->bLength, pCols->bNull, num},
+      {TSDB_DATA_TYPE_NCHAR, pCols->n, NCHAR_BUF_LEN, pCols->nLength, pCols->nNull, num},
+  };
+
+  return taos_stmt_bind_param_batch(stmt, params);
+}
+
+// each table takes rowsPerTable rows in an execution, chunk by chunk and one table after another
+void executeStmt(TAOS_STMT *stmt, SColumns *pCols, int execution) {
+  int     first = execution * arguments.rowsPerTable;
+  int64_t st = thGetTimeUs();
+
+  for (int r = 0; r < arguments.rowsPerTable; r += arguments.rowsPerBind) {
+    int num = MIN(arguments.rowsPerBind, arguments.rowsPerTable - r);
+
+    for (int t = 0; t < arguments.numOfTables; ++t) {
+      char name[32];
+      snprintf(name, sizeof(name), "t%d", t);
+
+      int code = taos_stmt_set_tbname(stmt, name);
+      TH_CHECK(code == 0, "execution:%d, failed to set table %s, code:%d", execution, name, code);
+
+      code = bindRows(stmt, pCols, t, first + r, num);
+      TH_CHECK(code == 0, "execution:%d, failed to bind %d rows to %s, code:%d", execution, num, name, code);
+    }
+  }
+
+  int code = taos_stmt_execute(stmt);
+  TH_CHECK(code == 0, "execution:%d, failed to execute, code:%d", execution, code);
+
+  double seconds = (double)(thGetTimeUs() - st) / 1000000;
+  int64_t rows = (int64_t)arguments.numOfTables * arguments.rowsPerTable;
+  printf("execution:%d, tables:%d, rows:%" PRId64 ", time:%.3f seconds, %.0f rows/second\n", execution,
+         arguments.numOfTables, rows, seconds, rows / seconds);
+}
+
+void checkTables(TAOS *taos) {
+  int   rows = arguments.rowsPerTable * arguments.numOfExecutions;
+  char *buf = malloc(RESULT_LEN);
+  char  line[256];
+
+  for (int t = 0; t < arguments.numOfTables; ++t) {
+    int numOfRows = thQueryRows(taos, buf, RESULT_LEN, "select * from t%d", t);
+    TH_CHECK(numOfRows == rows, "table:t%d, rows:%d, expected:%d", t, numOfRows, rows);
+
+    char *p = buf;
+    for (int r = 0; r < rows && p != NULL && *p != 0; ++r) {
+      int   len = printRow(line, t, r);
+      char *end = strchr(p, '\n');
+
+      if (end == NULL || end - p != len || strncmp(p, line, (size_t)len) != 0) {
+        TH_CHECK(false, "table:t%d, row %d is \"%.*s\", expected \"%s\"", t, r, (end != NULL) ? (int)(end - p) : 64,
+                 p, line);
+        break;
+      }
+
+      p = end + 1;
+    }
+  }
+
+  free(buf);
+}
+
+int main(int argc, char *argv[]) {
+  parseArg(argc, argv);
+
+  int      num = arguments.rowsPerBind;
+  SColumns cols = {.ts = calloc(num, sizeof(int64_t)),
+                   .i = calloc(num, sizeof(int32_t)),
+                   .d = calloc(num, sizeof(double)),
+                   .b = calloc(num, BINARY_LEN),
+                   .n = calloc(num, NCHAR_BUF_LEN),
+                   .bLength = calloc(num, sizeof(int32_t)),
+                   .nLength = calloc(num, sizeof(int32_t)),
+                   .iNull = calloc(num, 1),
+                   .bNull = calloc(num, 1),
+                   .nNull = calloc(num, 1)};
+
+  TAOS *taos = thStartServer("stmtBatchTest", NULL);
+  prepareDb(taos);
+
+  TAOS_STMT *stmt = taos_stmt_init(taos);
+  const char *sql = "insert into ? values(?, ?, ?, ?, ?)";
+  int         code = taos_stmt_prepare(stmt, sql, 0);
+  TH_CHECK(code == 0, "failed to prepare \"%s\", code:%d", sql, code);
+
+  // the statement is bound and executed again after an execution
+  for (int i = 0; i < arguments.numOfExecutions; ++i) {
+    executeStmt(stmt, &cols, i);
+  }
+  taos_stmt_close(stmt);
+
+  int32_t vgroups = thQueryRows(taos, NULL, 0, "show vgroups");
+  TH_CHECK(vgroups > 1, "tables are in %d vnodes, expected several", vgroups);
+
+  checkTables(taos);
+
+  free(cols.ts);
+  free(cols.i);
+  free(cols.d);
+  free(cols.b);
+  free(cols.n);
+  free(cols.bLength);
+  free(cols.nLength);
+  free(cols.iNull);
+  free(cols.bNull);
+  free(cols.nNull);
+
+  thStopServer(taos);
+  return thReport("stmtBatchTest");
+}
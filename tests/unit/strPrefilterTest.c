@@ -0,0 +1,325 @@
+/*
+ * File blocks are skipped by the prefixes of the min/max value and the bloom filter of a binary/nchar column, and by
+ * the min/max of the other columns, filters of a column are OR-ed and filters of different columns are AND-ed. Each
+ * query shall return the same rows as over the rows in cache, where no block is skipped. The rows of db so are then
+ * committed, and the statistics of their blocks are cleared in the files as if the blocks were written before them,
+ * which must be loaded as before. The same rows are written into db sp, whose blocks keep the statistics.
+ */
+#include <dirent.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "testHarness.h"
+#include "tutil.h"
+#include "vnode.h"
+#include "vnodeFile.h"
+
+typedef struct {
+  int numOfRows;
+} ProArgs;
+
+static ProArgs arguments;
+
+#define TEST_NAME "strPrefilterTest"
+#define START_TS ((int64_t)1600000000000LL)
+#define MAX_SQL_LEN 65000
+#define MAX_RESULT_LEN 4096
+#define ROWS_IN_BLOCK 200
+#define MAX_TABLES 20
+
+// binary values share their first 8 bytes in a block, values longer than the prefix differ by the bloom filter
+static const char *stations[] = {"alpha-station", "bravo-station", "charlie-station", "delta-station"};
+static const char *zones[] = {"北京站", "上海站", "west-zone"};
+
+// the parser does not take 'in' on binary/nchar columns, the OR-ed '=' of a column are what it would be
+static const char *conditions[] = {
+    "b = 'bravo-station-05-3'",
+    "b = 'bravo-station-04-3'",  // in the prefix range of some blocks, but in no bloom filter
+    "b = 'echo-station-01-1'",
+    "b = 'alpha-station-00-0' or b = 'delta-station-03-4' or b = 'zulu'",
+    "b like 'charlie-st%'",
+    "b like 'charlie-station-1_-%'",
+    "b like 'Bravo-st%'",
+    "b like '%station-01%'",
+    "n = '北京站-3-05'",
+    "n = '上海站-2-05'",
+    "n like '上海站-1%'",
+    "n = 'west-zone-2-01' or n = '北京站-0-00'",
+    "b like 'alpha-st%' and n = '北京站-0-00'",
+    "b = 'delta-station-07-2' and v > 500",
+    "(b = 'alpha-station-02-1' or b = 'bravo-station-01-1') and n like 'west%'",
+    "n like 'west-zone-1%' and b like 'bravo%'",
+    "b = 'bravo-station-05-3' and n = 'west-zone-5-03'",
+    "b like 'delta-st%' and ts >= 1600000028000 and ts < 1600000032000",  // the block of NULL b
+    "v >= 0 and ts >= 1600000036000 and ts < 1600000040000",              // the block of NULL v
+    "n like '北京站%' and v < 100",
+};
+
+void parseArg(int argc, char *argv[]) {
+  arguments.numOfRows = 10000;
+
+  SThOption options[] = {TH_INT_OPTION("-rows", &arguments.numOfRows)};
+  thParseArgs(argc, argv, options, tListLen(options));
+}
+
+static int64_t getTs(int row) { return START_TS + row * 20; }
+
+// b is NULL in every row of the 8th block, v of the 10th, n of the 13th, besides the scattered ones
+static bool isNullB(int row) { return row % 11 == 4 || row / ROWS_IN_BLOCK == 7; }
+static bool isNullN(int row) { return row % 17 == 9 || row / ROWS_IN_BLOCK == 12; }
+static bool isNullV(int row) { return row / ROWS_IN_BLOCK == 9; }
+
+static void getB(int row, char *buf) {
+  int block = row / ROWS_IN_BLOCK;
+  sprintf(buf, "%s-%02d-%d", stations[block % 4], block % 10, row % 5);
+}
+
+static void getN(int row, char *buf) {
+  int block = row / ROWS_IN_BLOCK;
+  sprintf(buf, "%s-%d-%02d", zones[block % 3], block % 10, row % 13);
+}
+
+void writeRows(TAOS *taos, const char *db) {
+  char *sql = malloc(MAX_SQL_LEN);
+  char  b[32], n[64];
+
+  // all rows are kept in cache until the server restarts
+  thExecute(taos, "create database %s rows %d tables %d ablocks 20 tblocks 300", db, ROWS_IN_BLOCK, MAX_TABLES);
+  thExecute(taos, "use %s", db);
+  thExecute(taos, "create table t (ts timestamp, b binary(24), n nchar(20), v int)");
+
+  for (int row = 0; row < arguments.numOfRows;) {
+    int len = sprintf(sql, "insert into t values");
+    for (int i = 0; i < 500 && row < arguments.numOfRows; ++i, ++row) {
+      getB(row, b);
+      getN(row, n);
+      len += sprintf(sql + len, "(%" PRId64 ",", getTs(row));
+      len += isNullB(row) ? sprintf(sql + len, "NULL,") : sprintf(sql + len, "'%s',", b);
+      len += isNullN(row) ? sprintf(sql + len, "NULL,") : sprintf(sql + len, "'%s',", n);
+      len += isNullV(row) ? sprintf(sql + len, "NULL)") : sprintf(sql + len, "%d)", (row * 37) % 1000);
+    }
+
+    thExecute(taos, "%s", sql);
+  }
+
+  free(sql);
+}
+
+// rows whose b or n is one of the values
+static int64_t countEqual(bool isB, const char *values[], int numOfValues) {
+  char    buf[64];
+  int64_t count = 0;
+
+  for (int row = 0; row < arguments.numOfRows; ++row) {
+    if (isB ? isNullB(row) : isNullN(row)) continue;
+
+    isB ? getB(row, buf) : getN(row, buf);
+    for (int i = 0; i < numOfValues; ++i) {
+      if (strcmp(buf, values[i]) == 0) {
+        count++;
+        break;
+      }
+    }
+  }
+
+  return count;
+}
+
+// the conditions of equal values against the rows written, no row is counted as NAN
+void checkEqualCounts(TAOS *taos, const char *db) {
+  const char *b1[] = {"bravo-station-05-3"};
+  const char *b2[] = {"bravo-station-04-3"};
+  const char *b4[] = {"alpha-station-00-0", "delta-station-03-4", "zulu"};
+  const char *n1[] = {"北京站-3-05"};
+  const char *n4[] = {"west-zone-2-01", "北京站-0-00"};
+
+  struct {
+    const char * cond;
+    bool         isB;
+    const char **values;
+    int          numOfValues;
+  } cases[] = {
+      {conditions[0], true, b1, 1},  {conditions[1], true, b2, 1},  {conditions[3], true, b4, 3},
+      {conditions[8], false, n1, 1}, {conditions[11], false, n4, 2},
+  };
+
+  thExecute(taos, "use %s", db);
+  for (int i = 0; i < tListLen(cases); ++i) {
+    int64_t expected = countEqual(cases[i].isB, cases[i].values, cases[i].numOfValues);
+    double  count = thQueryValue(taos, "select count(*) from t where %s", cases[i].cond);
+    if (isnan(count)) count = 0;
+    TH_CHECK(count == expected, "%s, \"%s\", count:%.0f, expected:%" PRId64, db, cases[i].cond, count, expected);
+  }
+}
+
+void runQueries(TAOS *taos, const char *db, char *results[]) {
+  thExecute(taos, "use %s", db);
+  for (int i = 0; i < tListLen(conditions); ++i) {
+    thQueryRows(taos, results[i], MAX_RESULT_LEN, "select count(*), count(b), count(n), sum(v) from t where %s",
+                conditions[i]);
+  }
+}
+
+void checkQueries(TAOS *taos, const char *db, const char *stage, char *expected[], char *results[]) {
+  runQueries(taos, db, results);
+  for (int i = 0; i < tListLen(conditions); ++i) {
+    TH_CHECK(strcmp(expected[i], results[i]) == 0, "%s, %s, \"%s\", expected:%s, result:%s", db, stage, conditions[i],
+             expected[i], results[i]);
+  }
+}
+
+// clear the binary/nchar statistics of the fields of the blocks in a file, as they were before strStatisVer
+static int32_t clearStrStatisOfBlocks(int fd, int64_t offset, int32_t numOfCols) {
+  int32_t size = (int32_t)sizeof(SField) * numOfCols + (int32_t)sizeof(TSCKSUM);
+  SField *fields = malloc((size_t)size);
+  int32_t cleared = 0;
+
+  if (pread(fd, fields, (size_t)size, offset) != size || !taosCheckChecksumWhole((uint8_t *)fields, (uint32_t)size)) {
+    TH_CHECK(false, "fields of the block at %" PRId64 " are broken", offset);
+    free(fields);
+    return 0;
+  }
+
+  for (int32_t i = 0; i < numOfCols; ++i) {
+    if (fields[i].type != TSDB_DATA_TYPE_BINARY && fields[i].type != TSDB_DATA_TYPE_NCHAR) continue;
+
+    fields[i].min = 0;
+    fields[i].max = 0;
+    fields[i].strStatisVer = 0;
+    memset(fields[i].reserved, 0, sizeof(fields[i].reserved));
+    memset(fields[i].bloom, 0, sizeof(fields[i].bloom));
+    cleared++;
+  }
+
+  taosCalcChecksumAppend(0, (uint8_t *)fields, (uint32_t)size);
+  if (pwrite(fd, fields, (size_t)size, offset) != size) {
+    TH_CHECK(false, "failed to write the fields of the block at %" PRId64, offset);
+  }
+
+  free(fields);
+  return cleared;
+}
+
+// the blocks of a table are in the data or last file of the head file, a vnode has a table more than its db
+static int32_t clearStrStatisOfFile(const char *headPath) {
+  char dataPath[1024], lastPath[1024];
+  int  len = (int)strlen(headPath) - (int)strlen(".head");
+  snprintf(dataPath, sizeof(dataPath), "%.*s.data", len, headPath);
+  snprintf(lastPath, sizeof(lastPath), "%.*s.last", len, headPath);
+
+  int     hfd = open(headPath, O_RDONLY);
+  int     dfd = open(dataPath, O_RDWR);
+  int     lfd = open(lastPath, O_RDWR);
+  int32_t cleared = 0;
+
+  int32_t      size = (MAX_TABLES + 1) * (int32_t)sizeof(SCompHeader) + (int32_t)sizeof(TSCKSUM);
+  SCompHeader *headers = malloc((size_t)size);
+  if (hfd < 0 || dfd < 0 || lfd < 0 || pread(hfd, headers, (size_t)size, TSDB_FILE_HEADER_LEN) != size ||
+      !taosCheckChecksumWhole((uint8_t *)headers, (uint32_t)size)) {
+    TH_CHECK(false, "failed to read the comp headers of %s", headPath);
+    goto _over;
+  }
+
+  for (int32_t sid = 0; sid <= MAX_TABLES; ++sid) {
+    if (headers[sid].compInfoOffset == 0) continue;
+
+    SCompInfo info;
+    if (pread(hfd, &info, sizeof(info), headers[sid].compInfoOffset) != sizeof(info)) continue;
+
+    int32_t     blocksLen = (int32_t)(sizeof(SCompBlock) * info.numOfBlocks);
+    SCompBlock *blocks = malloc((size_t)blocksLen);
+    if (pread(hfd, blocks, (size_t)blocksLen, headers[sid].compInfoOffset + (int64_t)sizeof(info)) == blocksLen) {
+      for (int64_t i = 0; i < info.numOfBlocks; ++i) {
+        cleared += clearStrStatisOfBlocks(blocks[i].last ? lfd : dfd, blocks[i].offset, blocks[i].numOfCols);
+      }
+    }
+
+    free(blocks);
+  }
+
+_over:
+  free(headers);
+  if (hfd >= 0) close(hfd);
+  if (dfd >= 0) close(dfd);
+  if (lfd >= 0) close(lfd);
+  return cleared;
+}
+
+// the server is stopped, its files are linked in data/tsdb/vnode<id>/db
+int32_t clearStrStatis() {
+  char    path[1024];
+  int32_t cleared = 0;
+
+  snprintf(path, sizeof(path), "%s/data/tsdb", thGetServerDir());
+  DIR *vnodes = opendir(path);
+  if (vnodes == NULL) return 0;
+
+  struct dirent *vnode;
+  while ((vnode = readdir(vnodes)) != NULL) {
+    if (strncmp(vnode->d_name, "vnode", 5) != 0) continue;
+
+    snprintf(path, sizeof(path), "%s/data/tsdb/%s/db", thGetServerDir(), vnode->d_name);
+    DIR *files = opendir(path);
+    if (files == NULL) continue;
+
+    struct dirent *file;
+    while ((file = readdir(files)) != NULL) {
+      char *ext = strrchr(file->d_name, '.');
+      if (ext == NULL || strcmp(ext, ".head") != 0) continue;
+
+      char headPath[1400];
+      snprintf(headPath, sizeof(headPath), "%s/%s", path, file->d_name);
+      cleared += clearStrStatisOfFile(headPath);
+    }
+
+    closedir(files);
+  }
+
+  closedir(vnodes);
+  return cleared;
+}
+
+int main(int argc, char *argv[]) {
+  parseArg(argc, argv);
+
+  char *expected[tListLen(conditions)], *results[tListLen(conditions)];
+  for (int i = 0; i < tListLen(conditions); ++i) {
+    expected[i] = malloc(MAX_RESULT_LEN);
+    results[i] = malloc(MAX_RESULT_LEN);
+  }
+
+  TAOS *taos = thStartServer(TEST_NAME, NULL);
+  writeRows(taos, "so");
+  checkEqualCounts(taos, "so");
+  runQueries(taos, "so", expected);
+
+  // the blocks of so are committed, and all blocks in the files are of so
+  thStopServer(taos);
+  int32_t cleared = clearStrStatis();
+  TH_CHECK(cleared >= 2 * (arguments.numOfRows / ROWS_IN_BLOCK), "statistics of %d fields are cleared", cleared);
+
+  taos = thRestartServer(NULL, TEST_NAME, NULL);
+  checkQueries(taos, "so", "blocks without the statistics", expected, results);
+
+  writeRows(taos, "sp");
+  checkQueries(taos, "sp", "rows in cache", expected, results);
+
+  taos = thRestartServer(taos, TEST_NAME, NULL);
+  checkEqualCounts(taos, "sp");
+  checkQueries(taos, "sp", "blocks with the statistics", expected, results);
+  checkQueries(taos, "so", "blocks without the statistics", expected, results);
+
+  for (int i = 0; i < tListLen(conditions); ++i) {
+    free(expected[i]);
+    free(results[i]);
+  }
+
+  thStopServer(taos);
+  return thReport(TEST_NAME);
+}
@@ -0,0 +1,168 @@
+/*
+ * Throughput of the timestamp codecs, and a check that every codec produces the bytes of the byte-wise one:
+ *   regular : fixed interval, the delta of deltas are all 0
+ *   jitter  : interval with a small random jitter and some gaps, as sampled by real devices
+ *   random  : random values, the output is not compressed
+ *
+ * The throughput is the size of the raw timestamps processed per second.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "testHarness.h"
+#include "tscompression.h"
+#include "tutil.h"
+
+typedef struct {
+  int32_t rows;
+  int32_t blocks;
+  int32_t rounds;
+} ProArgs;
+
+static ProArgs arguments;
+
+static const char *codecName[] = {"reference", "scalar", "sse4.2", "avx2"};
+
+void parseArg(int argc, char *argv[]) {
+  arguments.rows = 4096;
+  arguments.blocks = 1024;
+  arguments.rounds = 5;
+
+  SThOption options[] = {TH_INT_OPTION("-rows", &arguments.rows), TH_INT_OPTION("-blocks", &arguments.blocks),
+                         TH_INT_OPTION("-rounds", &arguments.rounds)};
+  thParseArgs(argc, argv, options, tListLen(options));
+}
+
+static int64_t random64() { return ((int64_t)rand() << 33) ^ ((int64_t)rand() << 11) ^ rand(); }
+
+static void generate(int64_t *data, int32_t rows, int32_t type) {
+  int64_t ts = 1600000000000L + rand() % 100000;
+
+  for (int32_t i = 0; i < rows; ++i) {
+    if (type == 0) {
+      ts += 1000;
+    } else if (type == 1) {
+      ts += 1000 + rand() % 21 - 10;
+      if (rand() % 500 == 0) ts += rand() % 3600000;
+    } else {
+      ts = random64();
+    }
+    data[i] = ts;
+  }
+}
+
+static int32_t compress(const char *input, int32_t rows, char *output, char *buffer, int32_t algorithm) {
+  return tsCompressTimestamp(input, rows * 8, rows, output, rows * 8 + 1024, algorithm, buffer, rows * 8 + 1024);
+}
+
+static int32_t decompress(const char *input, int32_t len, int32_t rows, char *output, char *buffer, int32_t algorithm) {
+  return tsDecompressTimestamp(input, len, rows, output, rows * 8, algorithm, buffer, rows * 8 + 1024);
+}
+
+/*
+ * Encode the same data by every codec and compare with the byte-wise one, including short blocks, both algorithms
+ * and values near the overflow bounds.
+ */
+static void checkCodecs(int32_t bestCodec) {
+  int32_t maxRows = 1100;
+  char *  input = malloc(maxRows * 8);
+  char *  expect = malloc(maxRows * 8 + 1024);
+  char *  output = malloc(maxRows * 8 + 1024);
+  char *  decoded = malloc(maxRows * 8);
+  char *  buffer = malloc(maxRows * 8 + 1024);
+
+  for (int32_t k = 0; k < 3000; ++k) {
+    int32_t rows = 1 + rand() % maxRows;
+    int32_t algorithm = (k % 2 == 0) ? ONE_STAGE_COMP : TWO_STAGE_COMP;
+    int64_t *data = (int64_t *)input;
+
+    generate(data, rows, k % 3);
+    if (k % 7 == 0) data[rand() % rows] = (rand() % 2) ? INT64_MAX : INT64_MIN;
+    if (k % 11 == 0) data[rand() % rows] = data[0] + ((int64_t)1 << 62);
+
+    tsSetCompressCodec(TSDB_CODEC_REFERENCE);
+    int32_t expectLen = compress(input, rows, expect, buffer, algorithm);
+
+    for (int32_t codec = TSDB_CODEC_SCALAR; codec <= bestCodec; ++codec) {
+      tsSetCompressCodec(codec);
+      int32_t len = compress(input, rows, output, buffer, algorithm);
+      if (len != expectLen || memcmp(output, expect, (size_t)len) != 0) {
+        TH_CHECK(false, "%s: encoded bytes differ, rows:%d type:%d", codecName[codec], rows, k % 3);
+        continue;
+      }
+
+      memset(decoded, 0, (size_t)rows * 8);
+      TH_CHECK(decompress(output, len, rows, decoded, buffer, algorithm) == rows * 8 &&
+                   memcmp(decoded, input, (size_t)rows * 8) == 0,
+               "%s: decoded values differ, rows:%d type:%d", codecName[codec], rows, k % 3);
+    }
+  }
+
+  free(input);
+  free(expect);
+  free(output);
+  free(decoded);
+  free(buffer);
+}
+
+static void benchmark(int32_t type, int32_t bestCodec) {
+  int32_t rows = arguments.rows;
+  int64_t rawSize = (int64_t)rows * 8 * arguments.blocks;
+  char *  input = malloc((size_t)rawSize);
+  char *  output = malloc((size_t)(rows * 8 + 1024) * arguments.blocks);
+  char *  decoded = malloc((size_t)rawSize);
+  int32_t *lens = malloc(sizeof(int32_t) * arguments.blocks);
+
+  for (int32_t b = 0; b < arguments.blocks; ++b) generate((int64_t *)(input + (int64_t)b * rows * 8), rows, type);
+
+  for (int32_t codec = TSDB_CODEC_REFERENCE; codec <= bestCodec; ++codec) {
+    tsSetCompressCodec(codec);
+    int64_t encodeUs = 0, decodeUs = 0, compSize = 0;
+
+    for (int32_t r = 0; r < arguments.rounds; ++r) {
+      int64_t st = thGetTimeUs();
+      compSize = 0;
+      for (int32_t b = 0; b < arguments.blocks; ++b) {
+        lens[b] = tsCompressTimestamp(input + (int64_t)b * rows * 8, rows * 8, rows,
+                                      output + (int64_t)b * (rows * 8 + 1024), rows * 8 + 1024, ONE_STAGE_COMP, NULL, 0);
+        compSize += lens[b];
+      }
+      encodeUs += thGetTimeUs() - st;
+
+      st = thGetTimeUs();
+      for (int32_t b = 0; b < arguments.blocks; ++b) {
+        tsDecompressTimestamp(output + (int64_t)b * (rows * 8 + 1024), lens[b], rows, decoded + (int64_t)b * rows * 8,
+                              rows * 8, ONE_STAGE_COMP, NULL, 0);
+      }
+      decodeUs += thGetTimeUs() - st;
+    }
+
+    TH_CHECK(memcmp(decoded, input, (size_t)rawSize) == 0, "%s: decoded values differ", codecName[codec]);
+
+    double gb = (double)rawSize * arguments.rounds / 1e9;
+    printf("%-8s %-8s ratio:%6.2f%%  encode:%7.3f GB/s  decode:%7.3f GB/s\n", (type == 0) ? "regular" : (type == 1) ? "jitter" : "random",
+           codecName[codec], compSize * 100.0 / rawSize, gb / (encodeUs / 1e6), gb / (decodeUs / 1e6));
+  }
+
+  free(input);
+  free(output);
+  free(decoded);
+  free(lens);
+}
+
+int main(int argc, char *argv[]) {
+  parseArg(argc, argv);
+  srand(1);
+
+  int32_t bestCodec = tsSetCompressCodec(-1);
+  printf("rows per block:%d, blocks:%d, rounds:%d, best codec:%s\n", arguments.rows, arguments.blocks, arguments.rounds,
+         codecName[bestCodec]);
+
+  checkCodecs(bestCodec);
+
+  for (int32_t type = 0; type < 3; ++type) benchmark(type, bestCodec);
+
+  return thReport("tsCodecTest");
+}